@@ -0,0 +1,397 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+
+#include "kwl_benchmark.h"
+#include "kwl_decoder_imaadpcm.h"
+#include "kwl_decoder_oggvorbis.h"
+#include "kwl_decoder_pcm.h"
+#include "kwl_memory.h"
+#include "kwl_wavebankbinary.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif /*_WIN32*/
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif /*_WIN32*/
+
+double kwlBenchmark_getTimeSec(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#elif defined(__APPLE__)
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    return 1e-9 * (double)mach_absolute_time() * timebase.numer / timebase.denom;
+#else
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + 1e-9 * (double)time.tv_nsec;
+#endif /*_WIN32*/
+}
+
+double kwlBenchmark_getThreadTimeSec(void)
+{
+#ifdef _WIN32
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    GetThreadTimes(GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime);
+    ULARGE_INTEGER kernel, user;
+    kernel.LowPart = kernelTime.dwLowDateTime;
+    kernel.HighPart = kernelTime.dwHighDateTime;
+    user.LowPart = userTime.dwLowDateTime;
+    user.HighPart = userTime.dwHighDateTime;
+    return 1e-7 * (double)(kernel.QuadPart + user.QuadPart);
+#elif defined(__APPLE__)
+    mach_port_t thread = mach_thread_self();
+    thread_basic_info_data_t info;
+    mach_msg_type_number_t count = THREAD_BASIC_INFO_COUNT;
+    thread_info(thread, THREAD_BASIC_INFO, (thread_info_t)&info, &count);
+    mach_port_deallocate(mach_task_self(), thread);
+    return (double)(info.user_time.seconds + info.system_time.seconds) + 
+           1e-6 * (double)(info.user_time.microseconds + info.system_time.microseconds);
+#else
+    struct timespec time;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return (double)time.tv_sec + 1e-9 * (double)time.tv_nsec;
+#endif /*_WIN32*/
+}
+
+void kwlBenchmark_sleep(double seconds)
+{
+#ifdef _WIN32
+    Sleep((DWORD)(1e3 * seconds));
+#else
+    usleep((useconds_t)(1e6 * seconds));
+#endif /*_WIN32*/
+}
+
+void* kwlBenchmark_readFile(const char* path, int* numBytes)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        printf("Could not open '%s'.\n", path);
+        return NULL;
+    }
+    
+    fseek(file, 0, SEEK_END);
+    *numBytes = (int)ftell(file);
+    fseek(file, 0, SEEK_SET);
+    
+    void* bytes = KWL_MALLOC(*numBytes, KWL_MEMORY_CATEGORY_GENERAL, "benchmark file");
+    const int bytesRead = (int)fread(bytes, 1, *numBytes, file);
+    fclose(file);
+    
+    if (bytesRead != *numBytes)
+    {
+        printf("Could not read '%s'.\n", path);
+        KWL_FREE(bytes);
+        return NULL;
+    }
+    
+    return bytes;
+}
+
+unsigned long long kwlBenchmark_hash(unsigned long long hash, const void* bytes, int numBytes)
+{
+    const unsigned char* b = (const unsigned char*)bytes;
+    for (int i = 0; i < numBytes; i++)
+    {
+        hash ^= b[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/** Returns a copy of a given formatted string, allocated with KWL_MALLOC.*/
+static char* kwlBenchmark_createString(const char* format, int index)
+{
+    char buffer[128];
+    sprintf(buffer, format, index);
+    const int length = (int)strlen(buffer);
+    char* string = (char*)KWL_MALLOC(length + 1, KWL_MEMORY_CATEGORY_GENERAL, "benchmark string");
+    kwlMemcpy(string, buffer, length + 1);
+    return string;
+}
+
+/** Returns an array of a given number of integers, allocated with KWL_MALLOC.*/
+static int* kwlBenchmark_createIntArray(int numInts)
+{
+    return (int*)KWL_MALLOCANDZERO(numInts * sizeof(int), KWL_MEMORY_CATEGORY_GENERAL, "benchmark int array");
+}
+
+void kwlBenchmark_createEngineData(kwlEngineDataBinary* bin, const kwlBenchmarkProjectSize* size)
+{
+    kwlMemset(bin, 0, sizeof(kwlEngineDataBinary));
+    kwlMemcpy(bin->fileIdentifier, KWL_ENGINE_DATA_BINARY_FILE_IDENTIFIER, KWL_ENGINE_DATA_BINARY_FILE_IDENTIFIER_LENGTH);
+    
+    /*a master bus with all other buses as sub buses.*/
+    const int numMixBuses = size->numMixBuses;
+    bin->mixBusesChunk.numMixBuses = numMixBuses;
+    bin->mixBusesChunk.mixBuses = 
+        (kwlMixBusChunk*)KWL_MALLOCANDZERO(numMixBuses * sizeof(kwlMixBusChunk), KWL_MEMORY_CATEGORY_GENERAL, "benchmark mix buses");
+    for (int i = 0; i < numMixBuses; i++)
+    {
+        kwlMixBusChunk* mixBus = &bin->mixBusesChunk.mixBuses[i];
+        mixBus->id = i == 0 ? kwlBenchmark_createString("master", 0) : kwlBenchmark_createString("buses/bus_%d", i);
+    }
+    if (numMixBuses > 1)
+    {
+        kwlMixBusChunk* master = &bin->mixBusesChunk.mixBuses[0];
+        master->numSubBuses = numMixBuses - 1;
+        master->subBusIndices = kwlBenchmark_createIntArray(numMixBuses - 1);
+        for (int i = 1; i < numMixBuses; i++)
+        {
+            master->subBusIndices[i - 1] = i;
+        }
+    }
+    
+    const int numMixPresets = size->numMixPresets;
+    bin->mixPresetsChunk.numMixPresets = numMixPresets;
+    bin->mixPresetsChunk.mixPresets = 
+        (kwlMixPresetChunk*)KWL_MALLOCANDZERO(numMixPresets * sizeof(kwlMixPresetChunk), KWL_MEMORY_CATEGORY_GENERAL, "benchmark mix presets");
+    for (int i = 0; i < numMixPresets; i++)
+    {
+        kwlMixPresetChunk* mixPreset = &bin->mixPresetsChunk.mixPresets[i];
+        mixPreset->id = kwlBenchmark_createString("presets/preset_%d", i);
+        mixPreset->isDefault = i == 0;
+        mixPreset->mixBusIndices = kwlBenchmark_createIntArray(numMixBuses);
+        mixPreset->gainLeft = (float*)KWL_MALLOC(numMixBuses * sizeof(float), KWL_MEMORY_CATEGORY_GENERAL, "benchmark preset gain");
+        mixPreset->gainRight = (float*)KWL_MALLOC(numMixBuses * sizeof(float), KWL_MEMORY_CATEGORY_GENERAL, "benchmark preset gain");
+        mixPreset->pitch = (float*)KWL_MALLOC(numMixBuses * sizeof(float), KWL_MEMORY_CATEGORY_GENERAL, "benchmark preset pitch");
+        for (int j = 0; j < numMixBuses; j++)
+        {
+            mixPreset->mixBusIndices[j] = j;
+            mixPreset->gainLeft[j] = 1.0f;
+            mixPreset->gainRight[j] = 1.0f;
+            mixPreset->pitch[j] = 1.0f;
+        }
+    }
+    
+    const int numWaveBanks = size->numWaveBanks;
+    const int numEntries = size->numWaveBankEntries;
+    bin->waveBanksChunk.numWaveBanks = numWaveBanks;
+    bin->waveBanksChunk.numAudioDataItemsTotal = numWaveBanks * numEntries;
+    bin->waveBanksChunk.waveBanks = 
+        (kwlWaveBankChunk*)KWL_MALLOCANDZERO(numWaveBanks * sizeof(kwlWaveBankChunk), KWL_MEMORY_CATEGORY_GENERAL, "benchmark wave banks");
+    for (int i = 0; i < numWaveBanks; i++)
+    {
+        kwlWaveBankChunk* waveBank = &bin->waveBanksChunk.waveBanks[i];
+        waveBank->id = kwlBenchmark_createString("banks/bank_%d", i);
+        waveBank->numAudioDataEntries = numEntries;
+        waveBank->audioDataEntries = 
+            (char**)KWL_MALLOCANDZERO(numEntries * sizeof(char*), KWL_MEMORY_CATEGORY_GENERAL, "benchmark wave bank entries");
+        for (int j = 0; j < numEntries; j++)
+        {
+            char format[64];
+            sprintf(format, "audio/bank_%d/sound_file_%%d.wav", i);
+            waveBank->audioDataEntries[j] = kwlBenchmark_createString(format, j);
+        }
+    }
+    
+    /*each sound picks between three entries from consecutive wave banks.*/
+    const int numSounds = numWaveBanks > 0 && numEntries > 0 ? size->numSounds : 0;
+    bin->soundsChunk.numSoundDefinitions = numSounds;
+    bin->soundsChunk.soundDefinitions = 
+        (kwlSoundChunk*)KWL_MALLOCANDZERO(numSounds * sizeof(kwlSoundChunk), KWL_MEMORY_CATEGORY_GENERAL, "benchmark sounds");
+    for (int i = 0; i < numSounds; i++)
+    {
+        kwlSoundChunk* sound = &bin->soundsChunk.soundDefinitions[i];
+        sound->gain = 1.0f;
+        sound->pitch = 1.0f;
+        sound->numWaveReferences = 3;
+        sound->waveBankIndices = kwlBenchmark_createIntArray(3);
+        sound->audioDataIndices = kwlBenchmark_createIntArray(3);
+        for (int j = 0; j < 3; j++)
+        {
+            sound->waveBankIndices[j] = (i + j) % numWaveBanks;
+            sound->audioDataIndices[j] = (7 * i + j) % numEntries;
+        }
+    }
+    
+    const int numEvents = numSounds > 0 ? size->numEvents : 0;
+    bin->eventsChunk.numEventDefinitions = numEvents;
+    bin->eventsChunk.eventDefinitions = 
+        (kwlEventChunk*)KWL_MALLOCANDZERO(numEvents * sizeof(kwlEventChunk), KWL_MEMORY_CATEGORY_GENERAL, "benchmark events");
+    for (int i = 0; i < numEvents; i++)
+    {
+        kwlEventChunk* event = &bin->eventsChunk.eventDefinitions[i];
+        event->id = kwlBenchmark_createString("events/event_%d", i);
+        event->instanceCount = 1 + i % 4;
+        event->gain = 1.0f;
+        event->pitch = 1.0f;
+        event->innerConeAngleDeg = 360.0f;
+        event->outerConeAngleDeg = 360.0f;
+        event->outerConeGain = 1.0f;
+        event->mixBusIndex = i % numMixBuses;
+        event->soundIndex = i % numSounds;
+        event->waveBankIndex = -1;
+        event->audioDataIndex = -1;
+        event->numReferencedWaveBanks = numWaveBanks > 1 ? 2 : 1;
+        event->waveBankIndices = kwlBenchmark_createIntArray(event->numReferencedWaveBanks);
+        for (int j = 0; j < event->numReferencedWaveBanks; j++)
+        {
+            event->waveBankIndices[j] = (i % numSounds + j) % numWaveBanks;
+        }
+    }
+}
+
+void kwlBenchmark_writeWaveBank(const kwlEngineDataBinary* bin, 
+                                int waveBankIndex, 
+                                int numFrames, 
+                                int shuffle, 
+                                const char* path)
+{
+    const kwlWaveBankChunk* waveBank = &bin->waveBanksChunk.waveBanks[waveBankIndex];
+    const int numEntries = waveBank->numAudioDataEntries;
+    
+    kwlWaveBankBinary waveBankBin;
+    kwlMemset(&waveBankBin, 0, sizeof(kwlWaveBankBinary));
+    kwlMemcpy(waveBankBin.fileIdentifier, KWL_WAVE_BANK_BINARY_FILE_IDENTIFIER, KWL_WAVE_BANK_BINARY_FILE_IDENTIFIER_LENGTH);
+    waveBankBin.version = KWL_WAVE_BANK_BINARY_VERSION;
+    waveBankBin.id = kwlBenchmark_createString(waveBank->id, 0);
+    waveBankBin.numEntries = numEntries;
+    waveBankBin.entries = 
+        (kwlWaveBankEntryChunk*)KWL_MALLOCANDZERO(numEntries * sizeof(kwlWaveBankEntryChunk), KWL_MEMORY_CATEGORY_GENERAL, "benchmark wave bank entries");
+    
+    /*a fixed seed, so that every run shuffles the same way.*/
+    int* order = kwlBenchmark_createIntArray(numEntries);
+    srand(1);
+    for (int i = 0; i < numEntries; i++)
+    {
+        const int j = shuffle ? rand() % (i + 1) : i;
+        order[i] = order[j];
+        order[j] = i;
+    }
+    
+    for (int i = 0; i < numEntries; i++)
+    {
+        kwlWaveBankEntryChunk* entry = &waveBankBin.entries[i];
+        const int entryIndex = order[i];
+        entry->fileName = kwlBenchmark_createString(waveBank->audioDataEntries[entryIndex], 0);
+        entry->encoding = KWL_ENCODING_SIGNED_16BIT_PCM;
+        entry->numChannels = 1;
+        entry->sampleRate = 44100;
+        entry->numBytes = numFrames * sizeof(short);
+        short* samples = (short*)KWL_MALLOC(entry->numBytes, KWL_MEMORY_CATEGORY_GENERAL, "benchmark wave bank entry data");
+        for (int j = 0; j < numFrames; j++)
+        {
+            samples[j] = (short)(entryIndex + j);
+        }
+        entry->data = samples;
+        entry->contentHash = kwlBenchmark_hash(KWL_BENCHMARK_HASH_SEED, samples, entry->numBytes);
+    }
+    
+    kwlWaveBankBinary_writeToFile(&waveBankBin, path);
+    kwlWaveBankBinary_free(&waveBankBin);
+    KWL_FREE(order);
+}
+
+void kwlBenchmark_initAudioData(kwlAudioData* audioData, void* bytes, int numBytes, kwlAudioEncoding encoding)
+{
+    kwlMemset(audioData, 0, sizeof(kwlAudioData));
+    audioData->encoding = encoding;
+    audioData->bytes = bytes;
+    audioData->numBytes = numBytes;
+}
+
+void kwlBenchmark_freeAudioData(kwlAudioData* audioData)
+{
+    /*not kwlAudioData_free, since the audio data does not own the file contents.*/
+    if (audioData->sharedDecoderData != NULL)
+    {
+        kwlSharedDecoderData_release(audioData->sharedDecoderData);
+        audioData->sharedDecoderData = NULL;
+    }
+}
+
+kwlError kwlBenchmarkDecoder_init(kwlBenchmarkDecoder* decoder, kwlAudioData* audioData)
+{
+    kwlMemset(decoder, 0, sizeof(kwlBenchmarkDecoder));
+    kwlGetDefaultEngineConfig(&decoder->config);
+    
+    kwlDecoder* d = &decoder->decoder;
+    d->config = &decoder->config;
+    d->audioData = audioData;
+    d->loop = 1;
+    kwlInputStream_initWithBuffer(&d->audioDataStream, audioData->bytes, 0, audioData->numBytes);
+    
+    kwlError result = KWL_UNSUPPORTED_ENCODING;
+    if (audioData->encoding == KWL_ENCODING_IMA_ADPCM)
+    {
+        result = kwlInitDecoderIMAADPCM(d);
+    }
+    else if (audioData->encoding == KWL_ENCODING_VORBIS)
+    {
+        result = kwlInitDecoderOggVorbis(d);
+    }
+    else if (kwlAudioData_isLinearPCM(audioData))
+    {
+        result = kwlInitDecoderPCM(d);
+    }
+    
+    if (result != KWL_NO_ERROR)
+    {
+        return result;
+    }
+    
+    d->currentDecodedBuffer = (short*)KWL_MALLOC(d->maxDecodedBufferSize, KWL_MEMORY_CATEGORY_GENERAL, "benchmark decoded buffer");
+    return KWL_NO_ERROR;
+}
+
+int kwlBenchmarkDecoder_decodeBuffer(kwlBenchmarkDecoder* decoder)
+{
+    kwlDecoder* d = &decoder->decoder;
+    const int endOfData = d->decodeBuffer(d);
+    if (endOfData)
+    {
+        d->rewind(d);
+    }
+    return endOfData;
+}
+
+void kwlBenchmarkDecoder_free(kwlBenchmarkDecoder* decoder)
+{
+    kwlDecoder* d = &decoder->decoder;
+    if (d->deinit != NULL)
+    {
+        d->deinit(d);
+    }
+    KWL_FREE(d->currentDecodedBuffer);
+    d->currentDecodedBuffer = NULL;
+}
@@ -0,0 +1,245 @@
+/*
+ Copyright (c) 2010-2012 Per Gantelius
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any damages
+ arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it
+ freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must not
+ claim that you wrote the original software. If you use this software
+ in a product, an acknowledgment in the product documentation would be
+ appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and must not be
+ misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#ifndef KWL_BENCHMARK_H
+#define KWL_BENCHMARK_H
+
+/*! \file */
+
+#include "kowalski.h"
+#include "kwl_audiodata.h"
+#include "kwl_decoder.h"
+#include "kwl_enginedatabinary.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+    
+/** 
+ * A benchmark entry point. 
+ * @param argc The number of benchmark arguments.
+ * @param argv The benchmark arguments, not including the benchmark name.
+ * @return Zero on success, non-zero if the benchmark could not run or a check failed.
+ */
+typedef int (*kwlBenchmarkFunction)(int argc, const char* argv[]);
+
+/** A benchmark that can be run from the command line. */
+typedef struct kwlBenchmark
+{
+    /** The name used to select the benchmark.*/
+    const char* name;
+    /** A description of the arguments of the benchmark.*/
+    const char* arguments;
+    /** A description of what is measured.*/
+    const char* description;
+    /** The benchmark entry point.*/
+    kwlBenchmarkFunction run;
+} kwlBenchmark;
+
+/** The number of items of each kind in a synthetic project.*/
+typedef struct kwlBenchmarkProjectSize
+{
+    int numMixBuses;
+    int numMixPresets;
+    int numWaveBanks;
+    /** The number of audio data entries in each wave bank.*/
+    int numWaveBankEntries;
+    int numSounds;
+    int numEvents;
+} kwlBenchmarkProjectSize;
+
+/** 
+ * A decoder reading audio data held in memory, decoding on the calling thread. 
+ * @see kwlBenchmarkDecoder_init
+ */
+typedef struct kwlBenchmarkDecoder
+{
+    kwlEngineConfig config;
+    kwlDecoder decoder;
+} kwlBenchmarkDecoder;
+
+/**
+ * Returns the current value of a monotonic clock, in seconds.
+ */
+double kwlBenchmark_getTimeSec(void);
+
+/**
+ * Returns the CPU time used by the calling thread, in seconds.
+ */
+double kwlBenchmark_getThreadTimeSec(void);
+
+/**
+ * Suspends the calling thread for a given number of seconds.
+ */
+void kwlBenchmark_sleep(double seconds);
+
+/**
+ * Reads an entire file into memory allocated with KWL_MALLOC.
+ * @param path The path of the file to read.
+ * @param numBytes Receives the size of the file.
+ * @return The file contents, or NULL if the file could not be read.
+ */
+void* kwlBenchmark_readFile(const char* path, int* numBytes);
+
+/**
+ * Returns the FNV-1a hash of a number of bytes, continuing from a previous hash.
+ * Pass \c KWL_BENCHMARK_HASH_SEED as the previous hash to start a new hash.
+ */
+unsigned long long kwlBenchmark_hash(unsigned long long hash, const void* bytes, int numBytes);
+
+/** The initial value of a hash computed by kwlBenchmark_hash.*/
+#define KWL_BENCHMARK_HASH_SEED 14695981039346656037ULL
+
+/**
+ * Fills in an engine data binary describing a synthetic project of a given size. The 
+ * binary is freed with kwlEngineDataBinary_free.
+ * @param bin The engine data binary to fill in.
+ * @param size The size of the project.
+ */
+void kwlBenchmark_createEngineData(kwlEngineDataBinary* bin, const kwlBenchmarkProjectSize* size);
+
+/**
+ * Writes a wave bank binary for a wave bank of an engine data binary created by 
+ * kwlBenchmark_createEngineData. Every entry holds a short mono 16 bit sound whose
+ * samples differ between entries.
+ * @param bin The engine data binary.
+ * @param waveBankIndex The index of the wave bank to write.
+ * @param numFrames The number of sample frames of each entry.
+ * @param shuffle If non-zero, the entries are written in a shuffled order instead of 
+ * the order of the engine data.
+ * @param path The path of the wave bank binary file to write.
+ */
+void kwlBenchmark_writeWaveBank(const kwlEngineDataBinary* bin, 
+                                int waveBankIndex, 
+                                int numFrames, 
+                                int shuffle, 
+                                const char* path);
+
+/**
+ * Describes an audio file held in memory as audio data that decoders can be created for.
+ * The audio data does not take ownership of the file contents.
+ * @param audioData The audio data to initialize.
+ * @param bytes The encoded audio file. Must stay valid until the audio data is freed.
+ * @param numBytes The size of the audio file.
+ * @param encoding The encoding of the audio file.
+ */
+void kwlBenchmark_initAudioData(kwlAudioData* audioData, void* bytes, int numBytes, kwlAudioEncoding encoding);
+
+/**
+ * Releases any decoder data shared through audio data initialized by kwlBenchmark_initAudioData.
+ */
+void kwlBenchmark_freeAudioData(kwlAudioData* audioData);
+
+/**
+ * Initializes a looping decoder for audio data held in memory. 
+ * @param decoder The decoder to initialize.
+ * @param audioData The audio data to decode. Must stay valid until the decoder is freed.
+ * @return An error code.
+ */
+kwlError kwlBenchmarkDecoder_init(kwlBenchmarkDecoder* decoder, kwlAudioData* audioData);
+
+/**
+ * Decodes the next buffer of a decoder, rewinding it at the end of the audio data.
+ * @return Non-zero if the end of the audio data was reached, zero otherwise.
+ */
+int kwlBenchmarkDecoder_decodeBuffer(kwlBenchmarkDecoder* decoder);
+
+/**
+ * Frees the state of a decoder initialized by kwlBenchmarkDecoder_init.
+ */
+void kwlBenchmarkDecoder_free(kwlBenchmarkDecoder* decoder);
+
+/** Decodes IMA ADPCM data with the decoder and with a per nibble reference decoder.*/
+int kwlBenchmark_imaadpcm(int argc, const char* argv[]);
+
+/** Times starting Ogg Vorbis decoders with and without shared headers and codebooks.*/
+int kwlBenchmark_oggvorbisStart(int argc, const char* argv[]);
+
+/** 
+ * Times decoding a whole Ogg Vorbis stream and prints a hash of the output. Comparing
+ * the hash with a build defining _V_NO_SIMD checks that the SIMD paths in Tremor are 
+ * bit exact.
+ */
+int kwlBenchmark_oggvorbisDecode(int argc, const char* argv[]);
+
+/** Times kwlEventStart for events in a project and how long it takes until each event is audible.*/
+int kwlBenchmark_eventStart(int argc, const char* argv[]);
+
+/** 
+ * Times loading a synthetic wave bank with many short entries, with the entries in
+ * engine data order and shuffled.
+ */
+int kwlBenchmark_waveBankLoad(int argc, const char* argv[]);
+
+/** Times loading and unloading engine data for a large synthetic project and counts the allocations made while loading.*/
+int kwlBenchmark_engineDataLoad(int argc, const char* argv[]);
+
+/** Times releasing a live freeform buffer event and creating a new one, and counts the event allocations this makes.*/
+int kwlBenchmark_freeformEventChurn(int argc, const char* argv[]);
+
+/** 
+ * Times recording event calls on several threads into command buffers and applying them 
+ * in updates, compared to a baseline that records the calls in a mutex protected queue.
+ */
+int kwlBenchmark_commandBuffers(int argc, const char* argv[]);
+
+/** Times setting the parameters of many positional events with per call setters and with kwlEventBatchSetParameters.*/
+int kwlBenchmark_eventParameters(int argc, const char* argv[]);
+
+/** 
+ * Times freeing and allocating blocks among many live blocks, which measures the 
+ * allocation tracking in builds defining KWL_DEBUG_MEMORY.
+ */
+int kwlBenchmark_allocationChurn(int argc, const char* argv[]);
+
+/** 
+ * Times blocking wave bank unloads and unloads with a completion callback while an 
+ * event plays on an instance driven by the audio host.
+ */
+int kwlBenchmark_waveBankUnload(int argc, const char* argv[]);
+
+/** 
+ * Times engine data reloads, from the request until the completion callback, while an 
+ * event plays on an instance driven by the audio host, and counts silent output buffers.
+ */
+int kwlBenchmark_engineDataReload(int argc, const char* argv[]);
+
+/** 
+ * Times rendering offline instances that share audio data, one after the other and on 
+ * parallel threads, and checks that all instances render identical output.
+ */
+int kwlBenchmark_offlineInstances(int argc, const char* argv[]);
+
+/** 
+ * Counts the file reads made while streamed events play in real time on an instance 
+ * driven by the audio host, and reports the streaming I/O statistics.
+ */
+int kwlBenchmark_streamReads(int argc, const char* argv[]);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /*KWL_BENCHMARK_H*/
@@ -0,0 +1,278 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+
+
+#include "kwl_benchmark.h"
+#include "kowalski.h"
+#include "kwl_synchronization.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/** The number of threads recording event calls.*/
+#define KWL_BENCHMARK_NUM_PRODUCERS 8
+
+/** The number of freeform events the recorded calls target.*/
+#define KWL_BENCHMARK_NUM_EVENTS 16
+
+/** An event call recorded in the mutex protected baseline queue.*/
+typedef struct kwlBenchmarkEventCall
+{
+    /** Non-zero for a pitch call, zero for a gain call.*/
+    int isPitch;
+    kwlEventHandle handle;
+    float value;
+} kwlBenchmarkEventCall;
+
+/** State shared by the update thread and the producer threads.*/
+typedef struct kwlBenchmarkCommandContext
+{
+    kwlEngineInstance* engine;
+    kwlEventHandle handles[KWL_BENCHMARK_NUM_EVENTS];
+    int numFrames;
+    int numCommandsPerFrame;
+    /** Non-zero if calls are recorded in command buffers, zero if they go through the baseline queue.*/
+    int useCommandBuffers;
+    /** The baseline queue, drained by the update thread.*/
+    kwlBenchmarkEventCall* queue;
+    int queueSize;
+    kwlMutexLock queueLock;
+    /** Posted by each producer when it has recorded a frame.*/
+    kwlSemaphore* frameDoneSemaphore;
+    char frameDoneSemaphoreName[64];
+} kwlBenchmarkCommandContext;
+
+/** A thread recording event calls.*/
+typedef struct kwlBenchmarkProducer
+{
+    kwlBenchmarkCommandContext* context;
+    int index;
+    kwlThread thread;
+    kwlCommandBufferHandle commandBuffer;
+    /** Posted by the update thread when the producer may record the next frame.*/
+    kwlSemaphore* frameStartSemaphore;
+    char frameStartSemaphoreName[64];
+    /** The total time spent recording, in seconds.*/
+    double recordTime;
+} kwlBenchmarkProducer;
+
+static void* kwlBenchmark_producerThreadEntryPoint(void* data)
+{
+    kwlBenchmarkProducer* producer = (kwlBenchmarkProducer*)data;
+    kwlBenchmarkCommandContext* context = producer->context;
+    unsigned int random = producer->index * 7919 + 1;
+    
+    for (int frame = 0; frame < context->numFrames; frame++)
+    {
+        kwlSemaphoreWait(producer->frameStartSemaphore);
+        
+        const double start = kwlBenchmark_getTimeSec();
+        for (int i = 0; i < context->numCommandsPerFrame; i++)
+        {
+            const kwlEventHandle handle = context->handles[(producer->index + i) % KWL_BENCHMARK_NUM_EVENTS];
+            random = random * 1103515245 + 12345;
+            const float value = ((random >> 16) & 1023) / 1024.0f;
+            const int isPitch = i & 1;
+            if (context->useCommandBuffers)
+            {
+                if (isPitch)
+                {
+                    kwlCommandEventSetPitch(producer->commandBuffer, handle, value + 0.5f);
+                }
+                else
+                {
+                    kwlCommandEventSetGain(producer->commandBuffer, handle, value);
+                }
+            }
+            else
+            {
+                kwlMutexLockAcquire(&context->queueLock);
+                kwlBenchmarkEventCall* call = &context->queue[context->queueSize];
+                context->queueSize++;
+                call->isPitch = isPitch;
+                call->handle = handle;
+                call->value = value;
+                kwlMutexLockRelease(&context->queueLock);
+            }
+        }
+        if (context->useCommandBuffers)
+        {
+            kwlCommandBufferSubmit(producer->commandBuffer);
+        }
+        producer->recordTime += kwlBenchmark_getTimeSec() - start;
+        
+        kwlSemaphorePost(context->frameDoneSemaphore);
+    }
+    
+    return NULL;
+}
+
+/**
+ * Runs the producer threads for a number of frames, updating the engine after each frame.
+ * Returns the total time and, through @p updateTime and @p recordTime, the time spent 
+ * updating and the longest time any producer spent recording.
+ */
+static double kwlBenchmark_runProducers(kwlBenchmarkCommandContext* context, 
+                                        kwlBenchmarkProducer* producers,
+                                        int useCommandBuffers,
+                                        double* updateTime,
+                                        double* recordTime)
+{
+    context->useCommandBuffers = useCommandBuffers;
+    context->queueSize = 0;
+    *updateTime = 0.0;
+    *recordTime = 0.0;
+    for (int i = 0; i < KWL_BENCHMARK_NUM_PRODUCERS; i++)
+    {
+        producers[i].recordTime = 0.0;
+        kwlThreadCreate(&producers[i].thread, kwlBenchmark_producerThreadEntryPoint, &producers[i]);
+    }
+    
+    const double start = kwlBenchmark_getTimeSec();
+    for (int frame = 0; frame < context->numFrames; frame++)
+    {
+        for (int i = 0; i < KWL_BENCHMARK_NUM_PRODUCERS; i++)
+        {
+            kwlSemaphorePost(producers[i].frameStartSemaphore);
+        }
+        for (int i = 0; i < KWL_BENCHMARK_NUM_PRODUCERS; i++)
+        {
+            kwlSemaphoreWait(context->frameDoneSemaphore);
+        }
+        
+        /*the producers are waiting for the next frame, so the queue can be drained without the lock.*/
+        const double updateStart = kwlBenchmark_getTimeSec();
+        for (int i = 0; i < context->queueSize; i++)
+        {
+            const kwlBenchmarkEventCall* call = &context->queue[i];
+            if (call->isPitch)
+            {
+                kwlInstanceEventSetPitch(context->engine, call->handle, call->value + 0.5f);
+            }
+            else
+            {
+                kwlInstanceEventSetGain(context->engine, call->handle, call->value);
+            }
+        }
+        context->queueSize = 0;
+        kwlInstanceUpdate(context->engine, 0.016f);
+        *updateTime += kwlBenchmark_getTimeSec() - updateStart;
+    }
+    const double totalTime = kwlBenchmark_getTimeSec() - start;
+    
+    for (int i = 0; i < KWL_BENCHMARK_NUM_PRODUCERS; i++)
+    {
+        kwlThreadJoin(&producers[i].thread);
+        *recordTime = producers[i].recordTime > *recordTime ? producers[i].recordTime : *recordTime;
+    }
+    
+    return totalTime;
+}
+
+int kwlBenchmark_commandBuffers(int argc, const char* argv[])
+{
+    kwlBenchmarkCommandContext context;
+    context.numFrames = argc > 0 ? atoi(argv[0]) : 200;
+    context.numCommandsPerFrame = argc > 1 ? atoi(argv[1]) : 1000;
+    if (context.numFrames <= 0 || context.numCommandsPerFrame <= 0)
+    {
+        return 1;
+    }
+    
+    context.engine = kwlEngineCreateOffline(44100, 2, NULL, NULL);
+    if (context.engine == NULL)
+    {
+        printf("Could not create an offline engine instance.\n");
+        return 1;
+    }
+    
+    short samples[512] = {0};
+    kwlPCMBuffer buffer;
+    buffer.pcmData = samples;
+    buffer.numFrames = 256;
+    buffer.numChannels = 2;
+    for (int i = 0; i < KWL_BENCHMARK_NUM_EVENTS; i++)
+    {
+        context.handles[i] = kwlInstanceEventCreateWithBuffer(context.engine, &buffer, KWL_NONPOSITIONAL);
+    }
+    
+    context.queue = (kwlBenchmarkEventCall*)malloc(KWL_BENCHMARK_NUM_PRODUCERS * context.numCommandsPerFrame * 
+                                                   sizeof(kwlBenchmarkEventCall));
+    kwlMutexLockInit(&context.queueLock);
+    sprintf(context.frameDoneSemaphoreName, "kwlbenchmarkdone%d", (int)(size_t)&context);
+    context.frameDoneSemaphore = kwlSemaphoreOpen(context.frameDoneSemaphoreName);
+    
+    kwlBenchmarkProducer producers[KWL_BENCHMARK_NUM_PRODUCERS];
+    for (int i = 0; i < KWL_BENCHMARK_NUM_PRODUCERS; i++)
+    {
+        producers[i].context = &context;
+        producers[i].index = i;
+        producers[i].commandBuffer = kwlInstanceCommandBufferCreate(context.engine, context.numCommandsPerFrame);
+        sprintf(producers[i].frameStartSemaphoreName, "kwlbenchmarkstart%d", (int)(size_t)&producers[i]);
+        producers[i].frameStartSemaphore = kwlSemaphoreOpen(producers[i].frameStartSemaphoreName);
+    }
+    
+    double bufferUpdateTime = 0.0;
+    double bufferRecordTime = 0.0;
+    const double bufferTime = kwlBenchmark_runProducers(&context, producers, 1, 
+                                                        &bufferUpdateTime, &bufferRecordTime);
+    kwlError result = KWL_NO_ERROR;
+    for (int i = 0; i < KWL_BENCHMARK_NUM_PRODUCERS; i++)
+    {
+        const kwlError bufferResult = kwlCommandBufferGetError(producers[i].commandBuffer);
+        result = result == KWL_NO_ERROR ? bufferResult : result;
+    }
+    
+    double queueUpdateTime = 0.0;
+    double queueRecordTime = 0.0;
+    const double queueTime = kwlBenchmark_runProducers(&context, producers, 0, 
+                                                       &queueUpdateTime, &queueRecordTime);
+    result = result == KWL_NO_ERROR ? kwlInstanceGetError(context.engine) : result;
+    
+    for (int i = 0; i < KWL_BENCHMARK_NUM_PRODUCERS; i++)
+    {
+        kwlCommandBufferDestroy(producers[i].commandBuffer);
+        kwlSemaphoreDestroy(producers[i].frameStartSemaphore, producers[i].frameStartSemaphoreName);
+    }
+    kwlSemaphoreDestroy(context.frameDoneSemaphore, context.frameDoneSemaphoreName);
+    free(context.queue);
+    kwlEngineDestroy(context.engine);
+    
+    if (result != KWL_NO_ERROR)
+    {
+        printf("Recording or applying the commands failed (error %d).\n", result);
+        return 1;
+    }
+    
+    const double numCommands = (double)KWL_BENCHMARK_NUM_PRODUCERS * context.numFrames * context.numCommandsPerFrame;
+    const double numCommandsPerProducer = (double)context.numFrames * context.numCommandsPerFrame;
+    printf("%d producer threads, %d frames of %d commands per thread\n", 
+           KWL_BENCHMARK_NUM_PRODUCERS, context.numFrames, context.numCommandsPerFrame);
+    printf("  command buffers: record %6.1f ns, apply %6.1f ns per command, %8.1f ms total\n",
+           1e9 * bufferRecordTime / numCommandsPerProducer, 1e9 * bufferUpdateTime / numCommands, 1e3 * bufferTime);
+    printf("  mutex queue:     record %6.1f ns, apply %6.1f ns per command, %8.1f ms total\n",
+           1e9 * queueRecordTime / numCommandsPerProducer, 1e9 * queueUpdateTime / numCommands, 1e3 * queueTime);
+    
+    return 0;
+}
@@ -0,0 +1,81 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+
+
+
+#include "kwl_benchmark.h"
+#include "kwl_memory.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+int kwlBenchmark_allocationChurn(int argc, const char* argv[])
+{
+    const int numLiveBlocks = argc > 0 ? atoi(argv[0]) : 15000;
+    const int numPairs = argc > 1 ? atoi(argv[1]) : 100000;
+    if (numLiveBlocks <= 0 || numPairs <= 0)
+    {
+        return 1;
+    }
+    
+#ifdef KWL_DEBUG_MEMORY
+    printf("KWL_DEBUG_MEMORY is defined, allocations are tracked.\n");
+#else
+    printf("KWL_DEBUG_MEMORY is not defined, allocations are not tracked.\n");
+#endif /*KWL_DEBUG_MEMORY*/
+    
+    void** blocks = (void**)malloc(numLiveBlocks * sizeof(void*));
+    unsigned int random = 1;
+    for (int i = 0; i < numLiveBlocks; i++)
+    {
+        random = random * 1103515245 + 12345;
+        blocks[i] = KWL_MALLOC(16 + ((random >> 8) % 1024), KWL_MEMORY_CATEGORY_GENERAL, "benchmark block");
+    }
+    
+    /*free a pseudo random live block and allocate a new one of a pseudo random size in its place.*/
+    const double start = kwlBenchmark_getTimeSec();
+    for (int i = 0; i < numPairs; i++)
+    {
+        random = random * 1103515245 + 12345;
+        const int index = (random >> 8) % numLiveBlocks;
+        KWL_FREE(blocks[index]);
+        random = random * 1103515245 + 12345;
+        blocks[index] = KWL_MALLOC(16 + ((random >> 8) % 1024), KWL_MEMORY_CATEGORY_GENERAL, "benchmark block");
+    }
+    const double churnTime = kwlBenchmark_getTimeSec() - start;
+    
+    for (int i = 0; i < numLiveBlocks; i++)
+    {
+        KWL_FREE(blocks[i]);
+    }
+    free(blocks);
+    
+    printf("%d live blocks, %d free and allocate pairs\n", numLiveBlocks, numPairs);
+    printf("  total: %8.3f s, %8.1f ns per pair\n", churnTime, 1e9 * churnTime / numPairs);
+#ifdef KWL_DEBUG_MEMORY
+    printf("  live bytes after freeing all blocks: %d, peak bytes: %d\n", kwlDebugGetLiveBytes(), kwlDebugGetPeakBytes());
+#endif /*KWL_DEBUG_MEMORY*/
+    
+    return 0;
+}
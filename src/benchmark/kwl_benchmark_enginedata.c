@@ -0,0 +1,137 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+
+#include "kwl_benchmark.h"
+#include "kowalski.h"
+#include "kwl_memory.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/** Returns the total number of allocations made by the engine, in all memory categories.*/
+static int kwlBenchmark_getNumAllocations(void)
+{
+    int numAllocations = 0;
+    for (int i = 0; i < KWL_NUM_MEMORY_CATEGORIES; i++)
+    {
+        kwlMemoryStats stats;
+        kwlGetMemoryStats((kwlMemoryCategory)i, &stats);
+        numAllocations += stats.numAllocations;
+    }
+    return numAllocations;
+}
+
+int kwlBenchmark_engineDataLoad(int argc, const char* argv[])
+{
+    if (argc < 1)
+    {
+        return 1;
+    }
+    const int numLoads = argc > 1 ? atoi(argv[1]) : 10;
+    if (numLoads <= 0)
+    {
+        return 1;
+    }
+    
+    char engineDataPath[1024];
+    sprintf(engineDataPath, "%s/enginedataload.kwl", argv[0]);
+    
+    kwlBenchmarkProjectSize size;
+    size.numMixBuses = 200;
+    size.numMixPresets = 16;
+    size.numWaveBanks = 40;
+    size.numWaveBankEntries = 500;
+    size.numSounds = 20000;
+    size.numEvents = 20000;
+    
+    kwlEngineDataBinary bin;
+    kwlBenchmark_createEngineData(&bin, &size);
+    const kwlResultCode writeResult = kwlEngineDataBinary_writeToFile(&bin, engineDataPath);
+    kwlEngineDataBinary_free(&bin);
+    if (writeResult != KWL_SUCCESS)
+    {
+        printf("Could not write '%s'.\n", engineDataPath);
+        return 1;
+    }
+    
+    kwlEngineInstance* engine = kwlEngineCreateOffline(44100, 2, NULL, NULL);
+    if (engine == NULL)
+    {
+        printf("Could not create an offline engine instance.\n");
+        return 1;
+    }
+    
+    /*reading the file into memory is a lower bound for the load time.*/
+    double bestReadTime = 0.0;
+    int numFileBytes = 0;
+    for (int i = 0; i < numLoads; i++)
+    {
+        const double start = kwlBenchmark_getTimeSec();
+        void* fileBytes = kwlBenchmark_readFile(engineDataPath, &numFileBytes);
+        const double readTime = kwlBenchmark_getTimeSec() - start;
+        KWL_FREE(fileBytes);
+        bestReadTime = i == 0 || readTime < bestReadTime ? readTime : bestReadTime;
+    }
+    
+    double bestLoadTime = 0.0;
+    double bestUnloadTime = 0.0;
+    double totalLoadTime = 0.0;
+    int numLoadAllocations = 0;
+    kwlError result = KWL_NO_ERROR;
+    for (int i = 0; i < numLoads && result == KWL_NO_ERROR; i++)
+    {
+        const int numAllocationsBefore = kwlBenchmark_getNumAllocations();
+        double start = kwlBenchmark_getTimeSec();
+        kwlInstanceEngineDataLoad(engine, engineDataPath);
+        const double loadTime = kwlBenchmark_getTimeSec() - start;
+        numLoadAllocations = kwlBenchmark_getNumAllocations() - numAllocationsBefore;
+        result = kwlInstanceGetError(engine);
+        
+        start = kwlBenchmark_getTimeSec();
+        kwlInstanceEngineDataUnload(engine);
+        const double unloadTime = kwlBenchmark_getTimeSec() - start;
+        
+        bestLoadTime = i == 0 || loadTime < bestLoadTime ? loadTime : bestLoadTime;
+        bestUnloadTime = i == 0 || unloadTime < bestUnloadTime ? unloadTime : bestUnloadTime;
+        totalLoadTime += loadTime;
+    }
+    
+    kwlEngineDestroy(engine);
+    
+    if (result != KWL_NO_ERROR)
+    {
+        printf("Could not load '%s' (error %d).\n", engineDataPath, result);
+        return 1;
+    }
+    
+    printf("%d events, %d sounds, %d mix buses, %d mix presets, %d wave bank entries, %.1f MB, %d loads\n",
+           size.numEvents, size.numSounds, size.numMixBuses, size.numMixPresets, 
+           size.numWaveBanks * size.numWaveBankEntries, 1e-6 * numFileBytes, numLoads);
+    printf("  load:   %8.2f ms best, %8.2f ms mean, %d allocations\n", 
+           1e3 * bestLoadTime, 1e3 * totalLoadTime / numLoads, numLoadAllocations);
+    printf("  unload: %8.2f ms best\n", 1e3 * bestUnloadTime);
+    printf("  read:   %8.2f ms best, reading the file into memory\n", 1e3 * bestReadTime);
+    
+    return 0;
+}
@@ -0,0 +1,183 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+
+
+#include "kwl_benchmark.h"
+#include "kowalski.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** The number of events whose parameters are set.*/
+#define KWL_BENCHMARK_NUM_EMITTERS 10000
+
+/** A game side sound emitter component, with fields the engine does not read between the parameters.*/
+typedef struct kwlBenchmarkEmitter
+{
+    float position[3];
+    int id;
+    float velocity[3];
+    float direction[3];
+    float gain;
+    float pitch;
+    void* userData;
+} kwlBenchmarkEmitter;
+
+/** Fills the emitters with parameters that differ between runs.*/
+static void kwlBenchmark_fillEmitters(kwlBenchmarkEmitter* emitters, int run)
+{
+    for (int i = 0; i < KWL_BENCHMARK_NUM_EMITTERS; i++)
+    {
+        kwlBenchmarkEmitter* emitter = &emitters[i];
+        for (int c = 0; c < 3; c++)
+        {
+            emitter->position[c] = i * 0.1f + c + run;
+            emitter->velocity[c] = c - i * 0.01f;
+            emitter->direction[c] = c == 0 ? 1.0f + i % 7 : (c + run) * 0.5f;
+        }
+        emitter->gain = (i % 10) / 10.0f;
+        emitter->pitch = 0.5f + (i % 5) * 0.25f;
+    }
+}
+
+int kwlBenchmark_eventParameters(int argc, const char* argv[])
+{
+    const int numRuns = argc > 0 ? atoi(argv[0]) : 300;
+    if (numRuns <= 0)
+    {
+        return 1;
+    }
+    
+    kwlEngineInstance* engine = kwlEngineCreateOffline(44100, 2, NULL, NULL);
+    if (engine == NULL)
+    {
+        printf("Could not create an offline engine instance.\n");
+        return 1;
+    }
+    
+    short samples[64] = {0};
+    kwlPCMBuffer buffer;
+    buffer.pcmData = samples;
+    buffer.numFrames = 64;
+    buffer.numChannels = 1;
+    
+    kwlEventHandle* handles = (kwlEventHandle*)malloc(KWL_BENCHMARK_NUM_EMITTERS * sizeof(kwlEventHandle));
+    kwlError* errors = (kwlError*)malloc(KWL_BENCHMARK_NUM_EMITTERS * sizeof(kwlError));
+    kwlBenchmarkEmitter* emitters = 
+        (kwlBenchmarkEmitter*)calloc(KWL_BENCHMARK_NUM_EMITTERS, sizeof(kwlBenchmarkEmitter));
+    for (int i = 0; i < KWL_BENCHMARK_NUM_EMITTERS; i++)
+    {
+        handles[i] = kwlInstanceEventCreateWithBuffer(engine, &buffer, KWL_POSITIONAL);
+    }
+    kwlError result = kwlInstanceGetError(engine);
+    
+    const int stride = sizeof(kwlBenchmarkEmitter);
+    kwlEventParameterBatch allParameters;
+    memset(&allParameters, 0, sizeof(kwlEventParameterBatch));
+    allParameters.positions = emitters[0].position;
+    allParameters.positionStride = stride;
+    allParameters.velocities = emitters[0].velocity;
+    allParameters.velocityStride = stride;
+    allParameters.orientations = emitters[0].direction;
+    allParameters.orientationStride = stride;
+    allParameters.gains = &emitters[0].gain;
+    allParameters.gainStride = stride;
+    allParameters.pitches = &emitters[0].pitch;
+    allParameters.pitchStride = stride;
+    
+    kwlEventParameterBatch positionParameters;
+    memset(&positionParameters, 0, sizeof(kwlEventParameterBatch));
+    positionParameters.positions = emitters[0].position;
+    positionParameters.positionStride = stride;
+    
+    /*best times of setting all parameters and positions only, per call and batched.*/
+    double bestAllPerCall = 0.0;
+    double bestAllBatched = 0.0;
+    double bestPositionPerCall = 0.0;
+    double bestPositionBatched = 0.0;
+    for (int run = 0; run < numRuns && result == KWL_NO_ERROR; run++)
+    {
+        kwlBenchmark_fillEmitters(emitters, run);
+        
+        double start = kwlBenchmark_getTimeSec();
+        for (int i = 0; i < KWL_BENCHMARK_NUM_EMITTERS; i++)
+        {
+            const kwlBenchmarkEmitter* e = &emitters[i];
+            kwlInstanceEventSetPosition(engine, handles[i], e->position[0], e->position[1], e->position[2]);
+            kwlInstanceEventSetVelocity(engine, handles[i], e->velocity[0], e->velocity[1], e->velocity[2]);
+            kwlInstanceEventSetOrientation(engine, handles[i], e->direction[0], e->direction[1], e->direction[2]);
+            kwlInstanceEventSetGain(engine, handles[i], e->gain);
+            kwlInstanceEventSetPitch(engine, handles[i], e->pitch);
+        }
+        const double allPerCall = kwlBenchmark_getTimeSec() - start;
+        
+        start = kwlBenchmark_getTimeSec();
+        kwlInstanceEventBatchSetParameters(engine, handles, KWL_BENCHMARK_NUM_EMITTERS, &allParameters, errors);
+        const double allBatched = kwlBenchmark_getTimeSec() - start;
+        
+        start = kwlBenchmark_getTimeSec();
+        for (int i = 0; i < KWL_BENCHMARK_NUM_EMITTERS; i++)
+        {
+            const kwlBenchmarkEmitter* e = &emitters[i];
+            kwlInstanceEventSetPosition(engine, handles[i], e->position[0], e->position[1], e->position[2]);
+        }
+        const double positionPerCall = kwlBenchmark_getTimeSec() - start;
+        
+        start = kwlBenchmark_getTimeSec();
+        kwlInstanceEventBatchSetParameters(engine, handles, KWL_BENCHMARK_NUM_EMITTERS, &positionParameters, NULL);
+        const double positionBatched = kwlBenchmark_getTimeSec() - start;
+        
+        bestAllPerCall = run == 0 || allPerCall < bestAllPerCall ? allPerCall : bestAllPerCall;
+        bestAllBatched = run == 0 || allBatched < bestAllBatched ? allBatched : bestAllBatched;
+        bestPositionPerCall = run == 0 || positionPerCall < bestPositionPerCall ? positionPerCall : bestPositionPerCall;
+        bestPositionBatched = run == 0 || positionBatched < bestPositionBatched ? positionBatched : bestPositionBatched;
+        result = kwlInstanceGetError(engine);
+    }
+    
+    for (int i = 0; i < KWL_BENCHMARK_NUM_EMITTERS; i++)
+    {
+        kwlInstanceEventRelease(engine, handles[i]);
+    }
+    free(emitters);
+    free(errors);
+    free(handles);
+    kwlEngineDestroy(engine);
+    
+    if (result != KWL_NO_ERROR)
+    {
+        printf("Creating the events or setting their parameters failed (error %d).\n", result);
+        return 1;
+    }
+    
+    printf("%d positional freeform events, best of %d runs\n", KWL_BENCHMARK_NUM_EMITTERS, numRuns);
+    printf("  all parameters: per call %6.1f ns, batched %6.1f ns per event, %.2fx\n",
+           1e9 * bestAllPerCall / KWL_BENCHMARK_NUM_EMITTERS, 1e9 * bestAllBatched / KWL_BENCHMARK_NUM_EMITTERS,
+           bestAllPerCall / bestAllBatched);
+    printf("  position only:  per call %6.1f ns, batched %6.1f ns per event, %.2fx\n",
+           1e9 * bestPositionPerCall / KWL_BENCHMARK_NUM_EMITTERS, 1e9 * bestPositionBatched / KWL_BENCHMARK_NUM_EMITTERS,
+           bestPositionPerCall / bestPositionBatched);
+    
+    return 0;
+}
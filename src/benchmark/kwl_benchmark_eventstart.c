@@ -0,0 +1,244 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+
+
+#include "kwl_benchmark.h"
+#include "kowalski.h"
+#include "kwl_memory.h"
+#include "kwl_synchronization.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define KWL_BENCHMARK_EVENT_START_BUFFER_SIZE 512
+
+/** The longest time to wait for an event to become audible or to stop, in seconds.*/
+#define KWL_BENCHMARK_EVENT_START_TIMEOUT 1.0
+
+/** Output DSP unit data recording when the output first becomes audible.*/
+typedef struct kwlBenchmarkAudibleDetector
+{
+    /** Set by the mixer thread when a non-silent buffer has been rendered, cleared before each start.*/
+    volatile int isAudible;
+    /** The time the first non-silent buffer was rendered.*/
+    double audibleTime;
+} kwlBenchmarkAudibleDetector;
+
+static void kwlBenchmark_detectAudible(float* buffer, int numChannels, int numFrames, void* data)
+{
+    kwlBenchmarkAudibleDetector* detector = (kwlBenchmarkAudibleDetector*)data;
+    if (kwlAtomicLoad(&detector->isAudible) != 0)
+    {
+        return;
+    }
+    
+    for (int i = 0; i < numChannels * numFrames; i++)
+    {
+        if (buffer[i] != 0.0f)
+        {
+            detector->audibleTime = kwlBenchmark_getTimeSec();
+            kwlAtomicStore(&detector->isAudible, 1);
+            return;
+        }
+    }
+}
+
+static void kwlBenchmark_updateAudibleDetector(void* data)
+{
+    /*the detector has no parameters.*/
+}
+
+static int kwlBenchmark_compareTimes(const void* a, const void* b)
+{
+    const double timeA = *(const double*)a;
+    const double timeB = *(const double*)b;
+    return timeA < timeB ? -1 : (timeA > timeB ? 1 : 0);
+}
+
+/** 
+ * Advances an engine instance by one buffer. Offline instances are rendered, 
+ * instances driven by the audio host are given the time to render a buffer.
+ */
+static void kwlBenchmark_advance(kwlEngineInstance* engine, int isOffline, float* outBuffer)
+{
+    kwlInstanceUpdate(engine, 0.01f);
+    if (isOffline != 0)
+    {
+        kwlInstanceRender(engine, outBuffer, KWL_BENCHMARK_EVENT_START_BUFFER_SIZE);
+    }
+    else
+    {
+        kwlBenchmark_sleep(0.001);
+    }
+}
+
+int kwlBenchmark_eventStart(int argc, const char* argv[])
+{
+    if (argc < 5)
+    {
+        return 1;
+    }
+    /*"ondemand" is a host driven instance loading the wave bank on demand.*/
+    const int isOffline = strcmp(argv[0], "offline") == 0;
+    const int isOnDemand = strcmp(argv[0], "ondemand") == 0;
+    if (isOffline == 0 && isOnDemand == 0 && strcmp(argv[0], "host") != 0)
+    {
+        return 1;
+    }
+    const int numStarts = atoi(argv[3]);
+    if (numStarts <= 0)
+    {
+        return 1;
+    }
+    
+    kwlEngineInstance* engine = isOffline != 0 ? 
+        kwlEngineCreateOffline(44100, 2, NULL, NULL) :
+        kwlEngineCreate(44100, 2, 0, KWL_BENCHMARK_EVENT_START_BUFFER_SIZE, NULL, NULL);
+    if (engine == NULL)
+    {
+        printf("Could not create an engine instance.\n");
+        return 1;
+    }
+    
+    kwlInstanceEngineDataLoad(engine, argv[1]);
+    kwlWaveBankHandle waveBank = isOnDemand != 0 ? 
+        kwlInstanceWaveBankLoadOnDemand(engine, argv[2]) :
+        kwlInstanceWaveBankLoad(engine, argv[2]);
+    kwlError result = kwlInstanceGetError(engine);
+    if (result != KWL_NO_ERROR)
+    {
+        printf("Could not load '%s' and '%s' (error %d).\n", argv[1], argv[2], result);
+        kwlEngineDestroy(engine);
+        return 1;
+    }
+    
+    kwlBenchmarkAudibleDetector detector;
+    detector.isAudible = 0;
+    detector.audibleTime = 0.0;
+    kwlDSPUnitHandle dspUnit = kwlDSPUnitCreateCustom(&detector, 
+                                                      kwlBenchmark_detectAudible,
+                                                      kwlBenchmark_updateAudibleDetector,
+                                                      kwlBenchmark_updateAudibleDetector,
+                                                      NULL);
+    kwlInstanceDSPUnitAttachToOutput(engine, dspUnit);
+    
+    float* outBuffer = (float*)KWL_MALLOC(2 * KWL_BENCHMARK_EVENT_START_BUFFER_SIZE * sizeof(float), 
+                                          KWL_MEMORY_CATEGORY_GENERAL, "benchmark output buffer");
+    double* startTimes = (double*)KWL_MALLOC(numStarts * sizeof(double), 
+                                             KWL_MEMORY_CATEGORY_GENERAL, "benchmark start times");
+    double* audibleTimes = (double*)KWL_MALLOC(numStarts * sizeof(double), 
+                                               KWL_MEMORY_CATEGORY_GENERAL, "benchmark audible times");
+    
+    printf("%s instance%s, prefetch head memory of the wave bank: %d bytes\n", 
+           isOffline != 0 ? "offline" : "host driven",
+           isOnDemand != 0 ? " loading the wave bank on demand" : "",
+           kwlInstanceWaveBankGetPrefetchHeadMemory(engine, waveBank));
+    printf("%d starts per event, in us per kwlEventStart and until the first non-silent buffer is rendered\n", numStarts);
+    printf("  %-40s %8s %8s %8s %8s %8s %8s\n", "event", "mean", "median", "p90", "max", "audible", "p90");
+    
+    for (int i = 4; i < argc && result == KWL_NO_ERROR; i++)
+    {
+        kwlResidencyStats statsBefore;
+        kwlInstanceGetResidencyStats(engine, &statsBefore);
+        kwlEventHandle handle = kwlInstanceEventGetHandle(engine, argv[i]);
+        double totalTime = 0.0;
+        int numInaudibleStarts = 0;
+        for (int j = 0; j < numStarts && result == KWL_NO_ERROR; j++)
+        {
+            kwlAtomicStore(&detector.isAudible, 0);
+            const double start = kwlBenchmark_getTimeSec();
+            kwlInstanceEventStart(engine, handle);
+            startTimes[j] = kwlBenchmark_getTimeSec() - start;
+            totalTime += startTimes[j];
+            
+            /*play until the event is audible and for at least a few buffers, 
+              then stop the event and play until it is done.*/
+            int numBuffers = 0;
+            while (numBuffers < 4 || 
+                   (kwlAtomicLoad(&detector.isAudible) == 0 && 
+                    kwlBenchmark_getTimeSec() - start < KWL_BENCHMARK_EVENT_START_TIMEOUT))
+            {
+                kwlBenchmark_advance(engine, isOffline, outBuffer);
+                numBuffers++;
+            }
+            if (kwlAtomicLoad(&detector.isAudible) != 0)
+            {
+                audibleTimes[j] = detector.audibleTime - start;
+            }
+            else
+            {
+                audibleTimes[j] = kwlBenchmark_getTimeSec() - start;
+                numInaudibleStarts++;
+            }
+            
+            kwlInstanceEventStop(engine, handle);
+            const double stop = kwlBenchmark_getTimeSec();
+            while (kwlInstanceEventIsPlaying(engine, handle) && 
+                   kwlBenchmark_getTimeSec() - stop < KWL_BENCHMARK_EVENT_START_TIMEOUT)
+            {
+                kwlBenchmark_advance(engine, isOffline, outBuffer);
+            }
+            result = kwlInstanceGetError(engine);
+        }
+        
+        if (result != KWL_NO_ERROR)
+        {
+            printf("Could not start and stop '%s' (error %d).\n", argv[i], result);
+            break;
+        }
+        
+        qsort(startTimes, numStarts, sizeof(double), kwlBenchmark_compareTimes);
+        qsort(audibleTimes, numStarts, sizeof(double), kwlBenchmark_compareTimes);
+        printf("  %-40s %8.1f %8.1f %8.1f %8.1f %8.1f %8.1f\n", argv[i], 
+               1e6 * totalTime / numStarts, 
+               1e6 * startTimes[numStarts / 2], 
+               1e6 * startTimes[numStarts * 9 / 10], 
+               1e6 * startTimes[numStarts - 1],
+               1e6 * audibleTimes[numStarts / 2], 
+               1e6 * audibleTimes[numStarts * 9 / 10]);
+        if (numInaudibleStarts > 0)
+        {
+            printf("  %d starts were not audible within %.1f s.\n", numInaudibleStarts, KWL_BENCHMARK_EVENT_START_TIMEOUT);
+        }
+        if (isOnDemand != 0)
+        {
+            kwlResidencyStats statsAfter;
+            kwlInstanceGetResidencyStats(engine, &statsAfter);
+            printf("  %-40s hits %d, misses %d, virtual starts %d\n", "", 
+                   statsAfter.numHits - statsBefore.numHits,
+                   statsAfter.numMisses - statsBefore.numMisses,
+                   statsAfter.numVirtualStarts - statsBefore.numVirtualStarts);
+        }
+    }
+    
+    KWL_FREE(audibleTimes);
+    KWL_FREE(startTimes);
+    KWL_FREE(outBuffer);
+    kwlEngineDestroy(engine);
+    /*there is no function for destroying DSP units, which are allocated by the engine.*/
+    KWL_FREE(dspUnit);
+    
+    return result == KWL_NO_ERROR ? 0 : 1;
+}
@@ -0,0 +1,98 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+
+
+#include "kwl_benchmark.h"
+#include "kowalski.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+int kwlBenchmark_freeformEventChurn(int argc, const char* argv[])
+{
+    const int numLiveEvents = argc > 0 ? atoi(argv[0]) : 1024;
+    const int numIterations = argc > 1 ? atoi(argv[1]) : 1000000;
+    if (numLiveEvents <= 0 || numIterations <= 0)
+    {
+        return 1;
+    }
+    
+    kwlEngineInstance* engine = kwlEngineCreateOffline(44100, 2, NULL, NULL);
+    if (engine == NULL)
+    {
+        printf("Could not create an offline engine instance.\n");
+        return 1;
+    }
+    
+    short samples[512] = {0};
+    kwlPCMBuffer buffer;
+    buffer.pcmData = samples;
+    buffer.numFrames = 256;
+    buffer.numChannels = 2;
+    
+    kwlEventHandle* handles = (kwlEventHandle*)malloc(numLiveEvents * sizeof(kwlEventHandle));
+    for (int i = 0; i < numLiveEvents; i++)
+    {
+        handles[i] = kwlInstanceEventCreateWithBuffer(engine, &buffer, KWL_NONPOSITIONAL);
+    }
+    
+    kwlMemoryStats statsBefore;
+    kwlGetMemoryStats(KWL_MEMORY_CATEGORY_EVENT, &statsBefore);
+    
+    /*release a pseudo random live event and create a new one in its place.*/
+    unsigned int random = 1;
+    int numFailedCreates = 0;
+    const double start = kwlBenchmark_getTimeSec();
+    for (int i = 0; i < numIterations; i++)
+    {
+        random = random * 1103515245 + 12345;
+        const int index = (random >> 8) % numLiveEvents;
+        kwlInstanceEventRelease(engine, handles[index]);
+        handles[index] = kwlInstanceEventCreateWithBuffer(engine, &buffer, KWL_NONPOSITIONAL);
+        numFailedCreates += handles[index] == KWL_INVALID_HANDLE ? 1 : 0;
+    }
+    const double churnTime = kwlBenchmark_getTimeSec() - start;
+    
+    kwlMemoryStats statsAfter;
+    kwlGetMemoryStats(KWL_MEMORY_CATEGORY_EVENT, &statsAfter);
+    
+    for (int i = 0; i < numLiveEvents; i++)
+    {
+        kwlInstanceEventRelease(engine, handles[i]);
+    }
+    free(handles);
+    kwlEngineDestroy(engine);
+    
+    if (numFailedCreates > 0)
+    {
+        printf("%d of %d event creations failed.\n", numFailedCreates, numIterations);
+        return 1;
+    }
+    
+    printf("%d live buffer events, %d iterations\n", numLiveEvents, numIterations);
+    printf("  release and create: %8.1f ns, %d event allocations\n",
+           1e9 * churnTime / numIterations, statsAfter.numAllocations - statsBefore.numAllocations);
+    
+    return 0;
+}
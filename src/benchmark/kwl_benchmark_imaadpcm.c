@@ -0,0 +1,145 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+
+#include "kwl_benchmark.h"
+#include "kwl_decoder_imaadpcm.h"
+#include "kwl_memory.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Decodes a data block one nibble at a time with decodeNibble, the way the 
+ * decoder did before it switched to lookup tables.
+ */
+static void kwlDecodeIMAADPCMBlockWithNibbles(const unsigned char* datablock,
+                                              const int nBlockAlign,
+                                              const int numChannels,
+                                              short* outBuffer)
+{
+    for (int ch = 0; ch < numChannels; ch++)
+    {
+        const int headerByte = 4 * ch;
+        int predictor = (short)(datablock[headerByte] | (datablock[headerByte + 1] << 8));
+        int stepIndex = datablock[headerByte + 2] > 88 ? 88 : datablock[headerByte + 2];
+        int byteIndex = 4 * numChannels + headerByte;
+        int sampleIndex = ch;
+        
+        while (byteIndex < nBlockAlign)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                outBuffer[sampleIndex] = decodeNibble(datablock[byteIndex] & 0x0f, &predictor, &stepIndex);
+                sampleIndex += numChannels;
+                outBuffer[sampleIndex] = decodeNibble((datablock[byteIndex] & 0xf0) >> 4, &predictor, &stepIndex);
+                sampleIndex += numChannels;
+                byteIndex++;
+            }
+            byteIndex += 4 * (numChannels - 1);
+        }
+    }
+}
+
+int kwlBenchmark_imaadpcm(int argc, const char* argv[])
+{
+    if (argc < 1)
+    {
+        return 1;
+    }
+    const int numPasses = argc > 1 ? atoi(argv[1]) : 20;
+    
+    int numFileBytes = 0;
+    void* fileBytes = kwlBenchmark_readFile(argv[0], &numFileBytes);
+    if (fileBytes == NULL)
+    {
+        return 1;
+    }
+    
+    kwlAudioData audioData;
+    kwlBenchmark_initAudioData(&audioData, fileBytes, numFileBytes, KWL_ENCODING_IMA_ADPCM);
+    kwlBenchmarkDecoder decoder;
+    kwlError result = kwlBenchmarkDecoder_init(&decoder, &audioData);
+    if (result != KWL_NO_ERROR)
+    {
+        printf("Could not decode '%s' as IMA ADPCM (error %d).\n", argv[0], result);
+        KWL_FREE(fileBytes);
+        return 1;
+    }
+    
+    const kwlIMAADPCMCodecData* codecData = (const kwlIMAADPCMCodecData*)decoder.decoder.codecData;
+    const int numChannels = decoder.decoder.numChannels;
+    const int nBlockAlign = codecData->nBlockAlign;
+    const int numBlocks = codecData->dataSize / nBlockAlign;
+    const unsigned char* firstBlock = (const unsigned char*)fileBytes + codecData->firstDataBlockByte;
+    const int numBlockSamples = 8 * (nBlockAlign / (4 * numChannels) - 1) * numChannels;
+    short* referenceBuffer = (short*)KWL_MALLOC(numBlockSamples * sizeof(short), KWL_MEMORY_CATEGORY_GENERAL, "benchmark reference block");
+    
+    /*the decoder outputs one data block per buffer. check that it matches the reference.*/
+    int numMismatches = 0;
+    for (int i = 0; i < numBlocks; i++)
+    {
+        kwlBenchmarkDecoder_decodeBuffer(&decoder);
+        kwlDecodeIMAADPCMBlockWithNibbles(firstBlock + i * nBlockAlign, nBlockAlign, numChannels, referenceBuffer);
+        if (decoder.decoder.currentDecodedBufferSizeInBytes != numBlockSamples * (int)sizeof(short) ||
+            memcmp(decoder.decoder.currentDecodedBuffer, referenceBuffer, numBlockSamples * sizeof(short)) != 0)
+        {
+            numMismatches++;
+        }
+    }
+    
+    double start = kwlBenchmark_getTimeSec();
+    for (int i = 0; i < numPasses * numBlocks; i++)
+    {
+        kwlBenchmarkDecoder_decodeBuffer(&decoder);
+    }
+    const double decoderTime = kwlBenchmark_getTimeSec() - start;
+    
+    start = kwlBenchmark_getTimeSec();
+    for (int pass = 0; pass < numPasses; pass++)
+    {
+        for (int i = 0; i < numBlocks; i++)
+        {
+            kwlDecodeIMAADPCMBlockWithNibbles(firstBlock + i * nBlockAlign, nBlockAlign, numChannels, referenceBuffer);
+        }
+    }
+    const double referenceTime = kwlBenchmark_getTimeSec() - start;
+    
+    const double numMegabytes = 1e-6 * codecData->dataSize * numPasses;
+    const double numFrames = (double)numBlockSamples / numChannels * numBlocks * numPasses;
+    const int sampleRate = decoder.decoder.sampleRate > 0 ? decoder.decoder.sampleRate : 44100;
+    printf("%d channels, %d blocks of %d bytes, %d passes\n", numChannels, numBlocks, nBlockAlign, numPasses);
+    printf("  decoder:   %7.1f MB/s, %6.0f voices at %d Hz\n", 
+           numMegabytes / decoderTime, numFrames / decoderTime / sampleRate, sampleRate);
+    printf("  reference: %7.1f MB/s, %6.0f voices at %d Hz\n", 
+           numMegabytes / referenceTime, numFrames / referenceTime / sampleRate, sampleRate);
+    printf("  output %s the reference (%d mismatching blocks)\n", numMismatches == 0 ? "matches" : "DIFFERS FROM", numMismatches);
+    
+    KWL_FREE(referenceBuffer);
+    kwlBenchmarkDecoder_free(&decoder);
+    kwlBenchmark_freeAudioData(&audioData);
+    KWL_FREE(fileBytes);
+    
+    return numMismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,188 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+
+
+
+#include "kwl_benchmark.h"
+#include "kowalski.h"
+#include "kwl_memory.h"
+#include "kwl_synchronization.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define KWL_BENCHMARK_OFFLINE_BUFFER_SIZE 512
+
+#define KWL_BENCHMARK_MAX_NUM_OFFLINE_INSTANCES 64
+
+/** An offline instance and the result of rendering it.*/
+typedef struct kwlBenchmarkOfflineInstance
+{
+    kwlEngineInstance* engine;
+    const char* eventId;
+    int numBuffers;
+    unsigned long long hash;
+    kwlThread thread;
+} kwlBenchmarkOfflineInstance;
+
+/** Starts an event on an offline instance, renders a number of buffers and hashes the output.*/
+static void* kwlBenchmark_renderOfflineInstance(void* data)
+{
+    kwlBenchmarkOfflineInstance* instance = (kwlBenchmarkOfflineInstance*)data;
+    float outBuffer[2 * KWL_BENCHMARK_OFFLINE_BUFFER_SIZE];
+    
+    kwlEventHandle event = kwlInstanceEventGetHandle(instance->engine, instance->eventId);
+    kwlInstanceEventStart(instance->engine, event);
+    
+    instance->hash = KWL_BENCHMARK_HASH_SEED;
+    for (int i = 0; i < instance->numBuffers; i++)
+    {
+        kwlInstanceUpdate(instance->engine, KWL_BENCHMARK_OFFLINE_BUFFER_SIZE / 44100.0f);
+        kwlInstanceRender(instance->engine, outBuffer, KWL_BENCHMARK_OFFLINE_BUFFER_SIZE);
+        instance->hash = kwlBenchmark_hash(instance->hash, outBuffer, sizeof(outBuffer));
+    }
+    
+    kwlInstanceEventRelease(instance->engine, event);
+    return NULL;
+}
+
+/** Loads engine data and a wave bank into an instance, stopping anything playing.*/
+static kwlError kwlBenchmark_loadOfflineInstance(kwlEngineInstance* engine, const char* engineDataPath, const char* waveBankPath)
+{
+    if (kwlInstanceEngineDataIsLoaded(engine) != 0)
+    {
+        kwlInstanceEngineDataUnload(engine);
+    }
+    kwlInstanceEngineDataLoad(engine, engineDataPath);
+    kwlInstanceWaveBankLoad(engine, waveBankPath);
+    return kwlInstanceGetError(engine);
+}
+
+int kwlBenchmark_offlineInstances(int argc, const char* argv[])
+{
+    if (argc < 3)
+    {
+        return 1;
+    }
+    const int numInstances = argc > 3 ? atoi(argv[3]) : 8;
+    const int numBuffers = argc > 4 ? atoi(argv[4]) : 400;
+    if (numInstances <= 0 || numInstances > KWL_BENCHMARK_MAX_NUM_OFFLINE_INSTANCES || numBuffers <= 0)
+    {
+        return 1;
+    }
+    
+    kwlBenchmarkOfflineInstance instances[KWL_BENCHMARK_MAX_NUM_OFFLINE_INSTANCES];
+    kwlError result = KWL_NO_ERROR;
+    kwlMemoryStats stats;
+    size_t audioDataBytes = 0;
+    
+    /*create the instances, sharing the audio data of the first one.*/
+    int numCreatedInstances = 0;
+    for (int i = 0; i < numInstances && result == KWL_NO_ERROR; i++)
+    {
+        instances[i].engine = kwlEngineCreateOffline(44100, 2, NULL, i > 0 ? instances[0].engine : NULL);
+        if (instances[i].engine == NULL)
+        {
+            result = kwlInstanceGetError(NULL);
+            break;
+        }
+        numCreatedInstances++;
+        instances[i].eventId = argv[2];
+        instances[i].numBuffers = numBuffers;
+        result = kwlBenchmark_loadOfflineInstance(instances[i].engine, argv[0], argv[1]);
+        
+        if (i == 0)
+        {
+            kwlGetMemoryStats(KWL_MEMORY_CATEGORY_AUDIO_DATA, &stats);
+            audioDataBytes = stats.numLiveBytes;
+        }
+    }
+    
+    double sequentialTime = 0.0;
+    double parallelTime = 0.0;
+    int numMismatches = 0;
+    if (result == KWL_NO_ERROR)
+    {
+        kwlGetMemoryStats(KWL_MEMORY_CATEGORY_AUDIO_DATA, &stats);
+        printf("%d offline instances, audio data: %lu bytes with 1 instance, %lu bytes with %d\n", 
+               numInstances, (unsigned long)audioDataBytes, (unsigned long)stats.numLiveBytes, numInstances);
+        
+        /*render the instances one after the other...*/
+        double start = kwlBenchmark_getTimeSec();
+        for (int i = 0; i < numInstances; i++)
+        {
+            kwlBenchmark_renderOfflineInstance(&instances[i]);
+        }
+        sequentialTime = kwlBenchmark_getTimeSec() - start;
+        
+        const unsigned long long sequentialHash = instances[0].hash;
+        for (int i = 1; i < numInstances; i++)
+        {
+            numMismatches += instances[i].hash != sequentialHash ? 1 : 0;
+        }
+        
+        /*...and in parallel, each on a thread of its own, starting from freshly loaded data.*/
+        for (int i = 0; i < numInstances && result == KWL_NO_ERROR; i++)
+        {
+            result = kwlBenchmark_loadOfflineInstance(instances[i].engine, argv[0], argv[1]);
+        }
+        if (result == KWL_NO_ERROR)
+        {
+            start = kwlBenchmark_getTimeSec();
+            for (int i = 0; i < numInstances; i++)
+            {
+                kwlThreadCreate(&instances[i].thread, kwlBenchmark_renderOfflineInstance, &instances[i]);
+            }
+            for (int i = 0; i < numInstances; i++)
+            {
+                kwlThreadJoin(&instances[i].thread);
+            }
+            parallelTime = kwlBenchmark_getTimeSec() - start;
+            
+            for (int i = 0; i < numInstances; i++)
+            {
+                numMismatches += instances[i].hash != sequentialHash ? 1 : 0;
+            }
+        }
+    }
+    
+    for (int i = numCreatedInstances - 1; i >= 0; i--)
+    {
+        kwlEngineDestroy(instances[i].engine);
+    }
+    
+    if (result != KWL_NO_ERROR)
+    {
+        printf("Could not create offline instances and load '%s' and '%s' (error %d).\n", argv[0], argv[1], result);
+        return 1;
+    }
+    
+    const double audioTime = (double)numBuffers * KWL_BENCHMARK_OFFLINE_BUFFER_SIZE / 44100.0;
+    printf("  rendering %.1f s of audio per instance: sequential %.1f ms, parallel %.1f ms, speedup %.2fx\n", 
+           audioTime, 1e3 * sequentialTime, 1e3 * parallelTime, sequentialTime / parallelTime);
+    printf("  output hash %016llx, %d of %d renders differ from the first one\n", 
+           instances[0].hash, numMismatches, 2 * numInstances - 1);
+    
+    return numMismatches == 0 ? 0 : 1;
+}
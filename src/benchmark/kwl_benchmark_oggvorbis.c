@@ -0,0 +1,215 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+
+#include "kwl_benchmark.h"
+#include "kwl_memory.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Starts a decoder and decodes its first buffer, which is what starting a 
+ * streaming Ogg Vorbis event costs the decoder thread.
+ * @param audioData The audio data to start a decoder for.
+ * @param initTime Incremented by the time spent initializing the decoder.
+ * @param decodeTime Incremented by the time spent decoding the first buffer.
+ * @return The hash of the first decoded buffer, or 0 if the decoder could not be initialized.
+ */
+static unsigned long long kwlBenchmark_startAndStopDecoder(kwlAudioData* audioData, double* initTime, double* decodeTime)
+{
+    const double start = kwlBenchmark_getTimeSec();
+    kwlBenchmarkDecoder decoder;
+    if (kwlBenchmarkDecoder_init(&decoder, audioData) != KWL_NO_ERROR)
+    {
+        return 0;
+    }
+    const double initialized = kwlBenchmark_getTimeSec();
+    kwlBenchmarkDecoder_decodeBuffer(&decoder);
+    const double decoded = kwlBenchmark_getTimeSec();
+    *initTime += initialized - start;
+    *decodeTime += decoded - initialized;
+    
+    const unsigned long long hash = kwlBenchmark_hash(KWL_BENCHMARK_HASH_SEED, 
+                                                      decoder.decoder.currentDecodedBuffer, 
+                                                      decoder.decoder.currentDecodedBufferSizeInBytes);
+    kwlBenchmarkDecoder_free(&decoder);
+    return hash;
+}
+
+int kwlBenchmark_oggvorbisStart(int argc, const char* argv[])
+{
+    if (argc < 1)
+    {
+        return 1;
+    }
+    const int numStarts = argc > 1 ? atoi(argv[1]) : 300;
+    
+    int numFileBytes = 0;
+    void* fileBytes = kwlBenchmark_readFile(argv[0], &numFileBytes);
+    if (fileBytes == NULL)
+    {
+        return 1;
+    }
+    
+    /*every start gets new audio data, so the headers and codebooks are parsed each time.*/
+    unsigned long long uncachedHash = 0;
+    double uncachedInitTime = 0.0;
+    double uncachedDecodeTime = 0.0;
+    for (int i = 0; i < numStarts; i++)
+    {
+        kwlAudioData audioData;
+        kwlBenchmark_initAudioData(&audioData, fileBytes, numFileBytes, KWL_ENCODING_VORBIS);
+        uncachedHash = kwlBenchmark_startAndStopDecoder(&audioData, &uncachedInitTime, &uncachedDecodeTime);
+        kwlBenchmark_freeAudioData(&audioData);
+    }
+    
+    if (uncachedHash == 0)
+    {
+        printf("Could not decode '%s' as Ogg Vorbis.\n", argv[0]);
+        KWL_FREE(fileBytes);
+        return 1;
+    }
+    
+    /*all starts share audio data, so only the first one parses the headers and codebooks.*/
+    kwlAudioData audioData;
+    kwlBenchmark_initAudioData(&audioData, fileBytes, numFileBytes, KWL_ENCODING_VORBIS);
+    double firstInitTime = 0.0;
+    double firstDecodeTime = 0.0;
+    unsigned long long cachedHash = kwlBenchmark_startAndStopDecoder(&audioData, &firstInitTime, &firstDecodeTime);
+    
+    int numMismatches = cachedHash == uncachedHash ? 0 : 1;
+    double cachedInitTime = 0.0;
+    double cachedDecodeTime = 0.0;
+    for (int i = 0; i < numStarts; i++)
+    {
+        cachedHash = kwlBenchmark_startAndStopDecoder(&audioData, &cachedInitTime, &cachedDecodeTime);
+        if (cachedHash != uncachedHash)
+        {
+            numMismatches++;
+        }
+    }
+    kwlBenchmark_freeAudioData(&audioData);
+    
+    printf("%d starts, in us per start\n", numStarts);
+    printf("                    init   first buffer\n");
+    printf("  uncached headers: %8.1f %8.1f\n", 
+           1e6 * uncachedInitTime / numStarts, 1e6 * uncachedDecodeTime / numStarts);
+    printf("  cached headers:   %8.1f %8.1f\n", 
+           1e6 * cachedInitTime / numStarts, 1e6 * cachedDecodeTime / numStarts);
+    printf("  first start:      %8.1f %8.1f (builds the cache)\n", 
+           1e6 * firstInitTime, 1e6 * firstDecodeTime);
+    printf("  first buffer %s with cached headers (%d mismatching starts)\n", 
+           numMismatches == 0 ? "matches" : "DIFFERS", numMismatches);
+    
+    KWL_FREE(fileBytes);
+    
+    return numMismatches == 0 ? 0 : 1;
+}
+
+/**
+ * Decodes the whole stream once, returning the hash of the decoded samples 
+ * and the number of decoded frames.
+ */
+static unsigned long long kwlBenchmark_decodeStream(kwlBenchmarkDecoder* decoder, int* numFrames)
+{
+    unsigned long long hash = KWL_BENCHMARK_HASH_SEED;
+    int numBytes = 0;
+    int endOfData = 0;
+    while (!endOfData)
+    {
+        endOfData = kwlBenchmarkDecoder_decodeBuffer(decoder);
+        hash = kwlBenchmark_hash(hash, 
+                                 decoder->decoder.currentDecodedBuffer, 
+                                 decoder->decoder.currentDecodedBufferSizeInBytes);
+        numBytes += decoder->decoder.currentDecodedBufferSizeInBytes;
+    }
+    *numFrames = numBytes / (int)(sizeof(short) * decoder->decoder.numChannels);
+    return hash;
+}
+
+int kwlBenchmark_oggvorbisDecode(int argc, const char* argv[])
+{
+    if (argc < 1)
+    {
+        return 1;
+    }
+    const int numPasses = argc > 1 ? atoi(argv[1]) : 20;
+    
+    int numFileBytes = 0;
+    void* fileBytes = kwlBenchmark_readFile(argv[0], &numFileBytes);
+    if (fileBytes == NULL)
+    {
+        return 1;
+    }
+    
+    kwlAudioData audioData;
+    kwlBenchmark_initAudioData(&audioData, fileBytes, numFileBytes, KWL_ENCODING_VORBIS);
+    kwlBenchmarkDecoder decoder;
+    kwlError result = kwlBenchmarkDecoder_init(&decoder, &audioData);
+    if (result != KWL_NO_ERROR)
+    {
+        printf("Could not decode '%s' as Ogg Vorbis (error %d).\n", argv[0], result);
+        kwlBenchmark_freeAudioData(&audioData);
+        KWL_FREE(fileBytes);
+        return 1;
+    }
+    
+    /*the decoder loops seamlessly by itself. without looping, it signals the end of the stream
+      and is rewound by kwlBenchmarkDecoder_decodeBuffer, so every pass decodes the same samples.*/
+    decoder.decoder.loop = 0;
+    int numFrames = 0;
+    const unsigned long long hash = kwlBenchmark_decodeStream(&decoder, &numFrames);
+    
+    int numMismatches = 0;
+    const double start = kwlBenchmark_getTimeSec();
+    for (int i = 0; i < numPasses; i++)
+    {
+        int numPassFrames = 0;
+        if (kwlBenchmark_decodeStream(&decoder, &numPassFrames) != hash)
+        {
+            numMismatches++;
+        }
+    }
+    const double decodeTime = kwlBenchmark_getTimeSec() - start;
+    
+    const int sampleRate = decoder.decoder.sampleRate > 0 ? decoder.decoder.sampleRate : 44100;
+    const double streamDuration = (double)numFrames / sampleRate;
+#ifdef _V_NO_SIMD
+    const char* tremorBuild = "portable C";
+#else
+    const char* tremorBuild = "SIMD where available";
+#endif /* _V_NO_SIMD */
+    printf("%d channels, %d frames at %d Hz, %d passes, Tremor built with %s\n", 
+           decoder.decoder.numChannels, numFrames, sampleRate, numPasses, tremorBuild);
+    printf("  %.1f us per decoded second, %.0f times real time\n", 
+           1e6 * decodeTime / (streamDuration * numPasses), streamDuration * numPasses / decodeTime);
+    printf("  output hash %016llx, %s between passes (%d mismatching passes)\n", 
+           hash, numMismatches == 0 ? "stable" : "UNSTABLE", numMismatches);
+    
+    kwlBenchmarkDecoder_free(&decoder);
+    kwlBenchmark_freeAudioData(&audioData);
+    KWL_FREE(fileBytes);
+    
+    return numMismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,206 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+
+
+
+#include "kwl_benchmark.h"
+#include "kowalski.h"
+#include "kwl_memory.h"
+#include "kwl_synchronization.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define KWL_BENCHMARK_RELOAD_BUFFER_SIZE 512
+
+/** For how long the event plays before the first reload, in seconds.*/
+#define KWL_BENCHMARK_RELOAD_PLAY_TIME 0.05
+
+/** The longest time to wait for a reload to complete, in seconds.*/
+#define KWL_BENCHMARK_RELOAD_TIMEOUT 1.0
+
+/** Output DSP unit data counting rendered buffers and silent ones among them.*/
+typedef struct kwlBenchmarkBufferCounter
+{
+    volatile int numBuffers;
+    volatile int numSilentBuffers;
+} kwlBenchmarkBufferCounter;
+
+/** Records the result of a reload.*/
+typedef struct kwlBenchmarkReloadCompletion
+{
+    int isCompleted;
+    kwlError result;
+} kwlBenchmarkReloadCompletion;
+
+static void kwlBenchmark_countBuffers(float* buffer, int numChannels, int numFrames, void* data)
+{
+    kwlBenchmarkBufferCounter* counter = (kwlBenchmarkBufferCounter*)data;
+    int isSilent = 1;
+    for (int i = 0; i < numChannels * numFrames && isSilent != 0; i++)
+    {
+        isSilent = buffer[i] == 0.0f;
+    }
+    
+    if (isSilent != 0)
+    {
+        kwlAtomicStore(&counter->numSilentBuffers, kwlAtomicLoad(&counter->numSilentBuffers) + 1);
+    }
+    kwlAtomicStore(&counter->numBuffers, kwlAtomicLoad(&counter->numBuffers) + 1);
+}
+
+static void kwlBenchmark_updateBufferCounter(void* data)
+{
+    /*the counter has no parameters.*/
+}
+
+static void kwlBenchmark_reloadCompleted(kwlError result, void* userData)
+{
+    kwlBenchmarkReloadCompletion* completion = (kwlBenchmarkReloadCompletion*)userData;
+    completion->result = result;
+    completion->isCompleted = 1;
+}
+
+static int kwlBenchmark_compareReloadTimes(const void* a, const void* b)
+{
+    const double timeA = *(const double*)a;
+    const double timeB = *(const double*)b;
+    return timeA < timeB ? -1 : (timeA > timeB ? 1 : 0);
+}
+
+int kwlBenchmark_engineDataReload(int argc, const char* argv[])
+{
+    if (argc < 4)
+    {
+        return 1;
+    }
+    const int numReloads = atoi(argv[3]);
+    if (numReloads <= 0)
+    {
+        return 1;
+    }
+    
+    /*the engine data files to alternate between, starting with the one loaded first.*/
+    const char* paths[16];
+    int numPaths = 0;
+    paths[numPaths++] = argv[0];
+    for (int i = 4; i < argc && numPaths < 16; i++)
+    {
+        paths[numPaths++] = argv[i];
+    }
+    
+    kwlEngineInstance* engine = kwlEngineCreate(44100, 2, 0, KWL_BENCHMARK_RELOAD_BUFFER_SIZE, NULL, NULL);
+    if (engine == NULL)
+    {
+        printf("Could not create an engine instance.\n");
+        return 1;
+    }
+    
+    kwlBenchmarkBufferCounter counter;
+    memset(&counter, 0, sizeof(kwlBenchmarkBufferCounter));
+    kwlDSPUnitHandle dspUnit = kwlDSPUnitCreateCustom(&counter, 
+                                                      kwlBenchmark_countBuffers,
+                                                      kwlBenchmark_updateBufferCounter,
+                                                      kwlBenchmark_updateBufferCounter,
+                                                      NULL);
+    kwlInstanceDSPUnitAttachToOutput(engine, dspUnit);
+    
+    kwlInstanceEngineDataLoad(engine, argv[0]);
+    kwlInstanceWaveBankLoad(engine, argv[1]);
+    kwlEventHandle event = kwlInstanceEventGetHandle(engine, argv[2]);
+    kwlInstanceEventStart(engine, event);
+    kwlError result = kwlInstanceGetError(engine);
+    if (result != KWL_NO_ERROR)
+    {
+        printf("Could not load '%s' and '%s' and start '%s' (error %d).\n", argv[0], argv[1], argv[2], result);
+        kwlEngineDestroy(engine);
+        KWL_FREE(dspUnit);
+        return 1;
+    }
+    
+    const double playStart = kwlBenchmark_getTimeSec();
+    while (kwlBenchmark_getTimeSec() - playStart < KWL_BENCHMARK_RELOAD_PLAY_TIME)
+    {
+        kwlInstanceUpdate(engine, 0.001f);
+        kwlBenchmark_sleep(0.001);
+    }
+    
+    double* reloadTimes = (double*)KWL_MALLOC(numReloads * sizeof(double), 
+                                              KWL_MEMORY_CATEGORY_GENERAL, "benchmark reload times");
+    const int numBuffersBefore = kwlAtomicLoad(&counter.numBuffers);
+    const int numSilentBuffersBefore = kwlAtomicLoad(&counter.numSilentBuffers);
+    double totalTime = 0.0;
+    
+    /*reload while the event plays, updating the engine until the reload has completed.*/
+    for (int i = 0; i < numReloads && result == KWL_NO_ERROR; i++)
+    {
+        kwlBenchmarkReloadCompletion completion;
+        memset(&completion, 0, sizeof(kwlBenchmarkReloadCompletion));
+        const double start = kwlBenchmark_getTimeSec();
+        kwlInstanceEngineDataReload(engine, paths[(i + 1) % numPaths], kwlBenchmark_reloadCompleted, &completion);
+        result = kwlInstanceGetError(engine);
+        while (result == KWL_NO_ERROR && 
+               completion.isCompleted == 0 && 
+               kwlBenchmark_getTimeSec() - start < KWL_BENCHMARK_RELOAD_TIMEOUT)
+        {
+            kwlInstanceUpdate(engine, 0.001f);
+            kwlBenchmark_sleep(0.001);
+        }
+        reloadTimes[i] = kwlBenchmark_getTimeSec() - start;
+        totalTime += reloadTimes[i];
+        
+        if (result == KWL_NO_ERROR)
+        {
+            result = completion.isCompleted != 0 ? completion.result : KWL_ENGINE_DATA_RELOAD_PENDING;
+        }
+    }
+    
+    const int numBuffers = kwlAtomicLoad(&counter.numBuffers) - numBuffersBefore;
+    const int numSilentBuffers = kwlAtomicLoad(&counter.numSilentBuffers) - numSilentBuffersBefore;
+    const int isPlaying = kwlInstanceEventIsPlaying(engine, event);
+    
+    if (result == KWL_NO_ERROR)
+    {
+        qsort(reloadTimes, numReloads, sizeof(double), kwlBenchmark_compareReloadTimes);
+        printf("%d reloads cycling through %d engine data file(s) while '%s' plays\n", numReloads, numPaths, argv[2]);
+        printf("  reload until callback: mean %8.3f ms, median %8.3f ms, max %8.3f ms\n", 
+               1e3 * totalTime / numReloads, 
+               1e3 * reloadTimes[numReloads / 2], 
+               1e3 * reloadTimes[numReloads - 1]);
+        printf("  %d of %d buffers rendered during the reloads were silent, the event is %s\n", 
+               numSilentBuffers, numBuffers, isPlaying != 0 ? "still playing" : "no longer playing");
+    }
+    else
+    {
+        printf("Could not reload engine data (error %d).\n", result);
+    }
+    
+    KWL_FREE(reloadTimes);
+    kwlEngineDestroy(engine);
+    /*there is no function for destroying DSP units, which are allocated by the engine.*/
+    KWL_FREE(dspUnit);
+    
+    return result == KWL_NO_ERROR ? 0 : 1;
+}
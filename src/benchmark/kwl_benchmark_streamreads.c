@@ -0,0 +1,194 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+
+
+
+#include "kwl_benchmark.h"
+#include "kowalski.h"
+#include "kwl_filesystem.h"
+#include "kwl_synchronization.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define KWL_BENCHMARK_STREAM_READS_MAX_NUM_EVENTS 16
+
+/** The time between engine updates while the events play, in seconds.*/
+#define KWL_BENCHMARK_STREAM_READS_UPDATE_INTERVAL 0.01
+
+/** 
+ * File system user data counting the reads made through the default file system. 
+ * Reads come from the engine thread, the streaming I/O thread and decoder threads.
+ */
+typedef struct kwlBenchmarkReadCounter
+{
+    kwlMutexLock lock;
+    int numReads;
+    long long numBytesRead;
+} kwlBenchmarkReadCounter;
+
+static void* kwlBenchmark_countingOpen(void* userData, const char* path)
+{
+    const kwlFileSystem* fileSystem = kwlFileSystem_getDefault();
+    return fileSystem->open(fileSystem->userData, path);
+}
+
+static int kwlBenchmark_countingRead(void* userData, void* file, int position, void* data, int length)
+{
+    const kwlFileSystem* fileSystem = kwlFileSystem_getDefault();
+    const int numBytesRead = fileSystem->read(fileSystem->userData, file, position, data, length);
+    
+    kwlBenchmarkReadCounter* counter = (kwlBenchmarkReadCounter*)userData;
+    kwlMutexLockAcquire(&counter->lock);
+    counter->numReads++;
+    counter->numBytesRead += numBytesRead;
+    kwlMutexLockRelease(&counter->lock);
+    
+    return numBytesRead;
+}
+
+static int kwlBenchmark_countingGetSize(void* userData, void* file)
+{
+    const kwlFileSystem* fileSystem = kwlFileSystem_getDefault();
+    return fileSystem->getSize(fileSystem->userData, file);
+}
+
+static void kwlBenchmark_countingClose(void* userData, void* file)
+{
+    const kwlFileSystem* fileSystem = kwlFileSystem_getDefault();
+    fileSystem->close(fileSystem->userData, file);
+}
+
+/** Returns the counted reads and bytes and resets the counter.*/
+static void kwlBenchmark_takeReadCount(kwlBenchmarkReadCounter* counter, int* numReads, long long* numBytesRead)
+{
+    kwlMutexLockAcquire(&counter->lock);
+    *numReads = counter->numReads;
+    *numBytesRead = counter->numBytesRead;
+    counter->numReads = 0;
+    counter->numBytesRead = 0;
+    kwlMutexLockRelease(&counter->lock);
+}
+
+int kwlBenchmark_streamReads(int argc, const char* argv[])
+{
+    if (argc < 4)
+    {
+        return 1;
+    }
+    const double playTime = atof(argv[2]);
+    const int numEvents = argc - 3;
+    if (playTime <= 0.0 || numEvents > KWL_BENCHMARK_STREAM_READS_MAX_NUM_EVENTS)
+    {
+        return 1;
+    }
+    
+    kwlBenchmarkReadCounter counter;
+    memset(&counter, 0, sizeof(kwlBenchmarkReadCounter));
+    kwlMutexLockInit(&counter.lock);
+    
+    kwlFileSystem fileSystem;
+    memset(&fileSystem, 0, sizeof(kwlFileSystem));
+    fileSystem.open = kwlBenchmark_countingOpen;
+    fileSystem.read = kwlBenchmark_countingRead;
+    fileSystem.getSize = kwlBenchmark_countingGetSize;
+    fileSystem.close = kwlBenchmark_countingClose;
+    fileSystem.userData = &counter;
+    
+    kwlEngineInstance* engine = kwlEngineCreate(44100, 2, 0, 512, &fileSystem, NULL);
+    if (engine == NULL)
+    {
+        printf("Could not create an engine instance.\n");
+        return 1;
+    }
+    
+    kwlInstanceEngineDataLoad(engine, argv[0]);
+    kwlInstanceWaveBankLoad(engine, argv[1]);
+    kwlError result = kwlInstanceGetError(engine);
+    if (result != KWL_NO_ERROR)
+    {
+        printf("Could not load '%s' and '%s' (error %d).\n", argv[0], argv[1], result);
+        kwlEngineDestroy(engine);
+        return 1;
+    }
+    
+    int numLoadReads = 0;
+    long long numLoadBytes = 0;
+    kwlBenchmark_takeReadCount(&counter, &numLoadReads, &numLoadBytes);
+    
+    kwlEventHandle handles[KWL_BENCHMARK_STREAM_READS_MAX_NUM_EVENTS];
+    for (int i = 0; i < numEvents; i++)
+    {
+        handles[i] = kwlInstanceEventGetHandle(engine, argv[3 + i]);
+        kwlInstanceEventStart(engine, handles[i]);
+    }
+    
+    /*play in real time, then stop the events and wait until they are done.*/
+    const double start = kwlBenchmark_getTimeSec();
+    while (kwlBenchmark_getTimeSec() - start < playTime)
+    {
+        kwlInstanceUpdate(engine, (float)KWL_BENCHMARK_STREAM_READS_UPDATE_INTERVAL);
+        kwlBenchmark_sleep(KWL_BENCHMARK_STREAM_READS_UPDATE_INTERVAL);
+    }
+    
+    kwlStreamingIOStats stats;
+    kwlInstanceGetStreamingIOStats(engine, &stats);
+    int numReads = 0;
+    long long numBytesRead = 0;
+    kwlBenchmark_takeReadCount(&counter, &numReads, &numBytesRead);
+    
+    int numPlayingEvents = 0;
+    for (int i = 0; i < numEvents; i++)
+    {
+        numPlayingEvents += kwlInstanceEventIsPlaying(engine, handles[i]) != 0 ? 1 : 0;
+        kwlInstanceEventStop(engine, handles[i]);
+    }
+    const double stop = kwlBenchmark_getTimeSec();
+    for (int i = 0; i < numEvents; i++)
+    {
+        while (kwlInstanceEventIsPlaying(engine, handles[i]) && kwlBenchmark_getTimeSec() - stop < 1.0)
+        {
+            kwlInstanceUpdate(engine, (float)KWL_BENCHMARK_STREAM_READS_UPDATE_INTERVAL);
+            kwlBenchmark_sleep(KWL_BENCHMARK_STREAM_READS_UPDATE_INTERVAL);
+        }
+    }
+    result = kwlInstanceGetError(engine);
+    kwlEngineDestroy(engine);
+    
+    if (result != KWL_NO_ERROR)
+    {
+        printf("Could not play the events (error %d).\n", result);
+        return 1;
+    }
+    
+    printf("%d events played for %.1f s, %d still playing at the end\n", numEvents, playTime, numPlayingEvents);
+    printf("  loading:  %6d reads, %10lld bytes\n", numLoadReads, numLoadBytes);
+    printf("  playback: %6d reads, %10lld bytes, %8.1f bytes per read\n", 
+           numReads, numBytesRead, numReads > 0 ? (double)numBytesRead / numReads : 0.0);
+    printf("  streaming I/O: %d streams, %d reads, max read latency %.2f ms, %d decoder stalls\n",
+           stats.numStreams, stats.numReads, 1e3 * stats.maxReadLatency, stats.numStalls);
+    
+    return 0;
+}
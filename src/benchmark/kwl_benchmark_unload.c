@@ -0,0 +1,199 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+
+
+
+#include "kwl_benchmark.h"
+#include "kowalski.h"
+#include "kwl_memory.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define KWL_BENCHMARK_UNLOAD_BUFFER_SIZE 512
+
+/** For how long the event plays before each unload, in seconds.*/
+#define KWL_BENCHMARK_UNLOAD_PLAY_TIME 0.05
+
+/** The longest time to wait for an event to start or an unload to complete, in seconds.*/
+#define KWL_BENCHMARK_UNLOAD_TIMEOUT 1.0
+
+/** Records when an unload requested with a callback completed.*/
+typedef struct kwlBenchmarkUnloadCompletion
+{
+    int isCompleted;
+    double completionTime;
+} kwlBenchmarkUnloadCompletion;
+
+static void kwlBenchmark_unloadCompleted(void* userData)
+{
+    kwlBenchmarkUnloadCompletion* completion = (kwlBenchmarkUnloadCompletion*)userData;
+    completion->completionTime = kwlBenchmark_getTimeSec();
+    completion->isCompleted = 1;
+}
+
+static int kwlBenchmark_compareUnloadTimes(const void* a, const void* b)
+{
+    const double timeA = *(const double*)a;
+    const double timeB = *(const double*)b;
+    return timeA < timeB ? -1 : (timeA > timeB ? 1 : 0);
+}
+
+/** Sorts an array of times in seconds and prints its median and max in milliseconds.*/
+static void kwlBenchmark_printUnloadTimes(const char* label, double* times, int numTimes)
+{
+    qsort(times, numTimes, sizeof(double), kwlBenchmark_compareUnloadTimes);
+    printf("  %-32s %8.3f %8.3f\n", label, 1e3 * times[numTimes / 2], 1e3 * times[numTimes - 1]);
+}
+
+/** 
+ * Loads a wave bank, starts an event and lets the audio host render it for a while.
+ * @return The handle of the loaded wave bank, or KWL_INVALID_HANDLE if the event 
+ * could not be started.
+ */
+static kwlWaveBankHandle kwlBenchmark_loadAndPlay(kwlEngineInstance* engine, 
+                                                  const char* waveBankPath, 
+                                                  kwlEventHandle event)
+{
+    kwlWaveBankHandle waveBank = kwlInstanceWaveBankLoad(engine, waveBankPath);
+    kwlInstanceEventStart(engine, event);
+    if (kwlInstanceGetError(engine) != KWL_NO_ERROR)
+    {
+        return KWL_INVALID_HANDLE;
+    }
+    
+    const double start = kwlBenchmark_getTimeSec();
+    while (kwlBenchmark_getTimeSec() - start < KWL_BENCHMARK_UNLOAD_PLAY_TIME)
+    {
+        kwlInstanceUpdate(engine, 0.001f);
+        kwlBenchmark_sleep(0.001);
+    }
+    
+    return kwlInstanceEventIsPlaying(engine, event) != 0 ? waveBank : KWL_INVALID_HANDLE;
+}
+
+int kwlBenchmark_waveBankUnload(int argc, const char* argv[])
+{
+    if (argc < 3)
+    {
+        return 1;
+    }
+    const int numUnloads = argc > 3 ? atoi(argv[3]) : 20;
+    if (numUnloads <= 0)
+    {
+        return 1;
+    }
+    
+    kwlEngineInstance* engine = kwlEngineCreate(44100, 2, 0, KWL_BENCHMARK_UNLOAD_BUFFER_SIZE, NULL, NULL);
+    if (engine == NULL)
+    {
+        printf("Could not create an engine instance.\n");
+        return 1;
+    }
+    
+    kwlInstanceEngineDataLoad(engine, argv[0]);
+    kwlEventHandle event = kwlInstanceEventGetHandle(engine, argv[2]);
+    if (kwlInstanceGetError(engine) != KWL_NO_ERROR)
+    {
+        printf("Could not load '%s' and get the event '%s'.\n", argv[0], argv[2]);
+        kwlEngineDestroy(engine);
+        return 1;
+    }
+    
+    double* blockingTimes = (double*)KWL_MALLOC(numUnloads * sizeof(double), 
+                                                KWL_MEMORY_CATEGORY_GENERAL, "benchmark blocking unload times");
+    double* blockingThreadTimes = (double*)KWL_MALLOC(numUnloads * sizeof(double), 
+                                                      KWL_MEMORY_CATEGORY_GENERAL, "benchmark blocking unload thread times");
+    double* requestTimes = (double*)KWL_MALLOC(numUnloads * sizeof(double), 
+                                               KWL_MEMORY_CATEGORY_GENERAL, "benchmark unload request times");
+    double* completionTimes = (double*)KWL_MALLOC(numUnloads * sizeof(double), 
+                                                  KWL_MEMORY_CATEGORY_GENERAL, "benchmark unload completion times");
+    int result = 0;
+    
+    /*unload the wave bank while the event plays, blocking...*/
+    for (int i = 0; i < numUnloads && result == 0; i++)
+    {
+        kwlWaveBankHandle waveBank = kwlBenchmark_loadAndPlay(engine, argv[1], event);
+        if (waveBank == KWL_INVALID_HANDLE)
+        {
+            result = 1;
+            break;
+        }
+        
+        const double start = kwlBenchmark_getTimeSec();
+        const double threadStart = kwlBenchmark_getThreadTimeSec();
+        kwlInstanceWaveBankUnloadBlocking(engine, waveBank);
+        blockingThreadTimes[i] = kwlBenchmark_getThreadTimeSec() - threadStart;
+        blockingTimes[i] = kwlBenchmark_getTimeSec() - start;
+        result = kwlInstanceGetError(engine) != KWL_NO_ERROR ? 1 : 0;
+    }
+    
+    /*...and with a completion callback, updating the engine until the callback is invoked.*/
+    for (int i = 0; i < numUnloads && result == 0; i++)
+    {
+        kwlWaveBankHandle waveBank = kwlBenchmark_loadAndPlay(engine, argv[1], event);
+        if (waveBank == KWL_INVALID_HANDLE)
+        {
+            result = 1;
+            break;
+        }
+        
+        kwlBenchmarkUnloadCompletion completion;
+        memset(&completion, 0, sizeof(kwlBenchmarkUnloadCompletion));
+        const double start = kwlBenchmark_getTimeSec();
+        kwlInstanceWaveBankUnloadWithCallback(engine, waveBank, kwlBenchmark_unloadCompleted, &completion);
+        requestTimes[i] = kwlBenchmark_getTimeSec() - start;
+        while (completion.isCompleted == 0 && 
+               kwlBenchmark_getTimeSec() - start < KWL_BENCHMARK_UNLOAD_TIMEOUT)
+        {
+            kwlInstanceUpdate(engine, 0.001f);
+            kwlBenchmark_sleep(0.001);
+        }
+        completionTimes[i] = completion.completionTime - start;
+        result = kwlInstanceGetError(engine) != KWL_NO_ERROR || completion.isCompleted == 0 ? 1 : 0;
+    }
+    
+    if (result == 0)
+    {
+        printf("%d unloads of '%s' while '%s' plays, in ms\n", numUnloads, argv[1], argv[2]);
+        printf("  %-32s %8s %8s\n", "", "median", "max");
+        kwlBenchmark_printUnloadTimes("blocking unload", blockingTimes, numUnloads);
+        kwlBenchmark_printUnloadTimes("blocking unload thread CPU", blockingThreadTimes, numUnloads);
+        kwlBenchmark_printUnloadTimes("unload request with callback", requestTimes, numUnloads);
+        kwlBenchmark_printUnloadTimes("time until callback", completionTimes, numUnloads);
+    }
+    else
+    {
+        printf("Could not play '%s' and unload '%s' (error %d).\n", argv[2], argv[1], kwlInstanceGetError(engine));
+    }
+    
+    KWL_FREE(completionTimes);
+    KWL_FREE(requestTimes);
+    KWL_FREE(blockingThreadTimes);
+    KWL_FREE(blockingTimes);
+    kwlEngineDestroy(engine);
+    
+    return result;
+}
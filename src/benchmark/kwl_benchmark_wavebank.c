@@ -0,0 +1,147 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+
+#include "kwl_benchmark.h"
+#include "kowalski.h"
+#include "kwl_memory.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define KWL_BENCHMARK_WAVE_BANK_NUM_FRAMES 64
+
+/**
+ * Loads and unloads a wave bank a number of times, printing the best and mean load times.
+ * @return An error code.
+ */
+static kwlError kwlBenchmark_loadWaveBank(kwlEngineInstance* engine, 
+                                          const char* path, 
+                                          int onDemand, 
+                                          int numLoads, 
+                                          const char* description)
+{
+    double bestTime = 0.0;
+    double totalTime = 0.0;
+    for (int i = 0; i < numLoads; i++)
+    {
+        const double start = kwlBenchmark_getTimeSec();
+        kwlWaveBankHandle handle = onDemand ? kwlInstanceWaveBankLoadOnDemand(engine, path) : 
+                                              kwlInstanceWaveBankLoad(engine, path);
+        const double loadTime = kwlBenchmark_getTimeSec() - start;
+        
+        const kwlError result = kwlInstanceGetError(engine);
+        if (result != KWL_NO_ERROR)
+        {
+            printf("Could not load '%s' (error %d).\n", path, result);
+            return result;
+        }
+        
+        kwlInstanceWaveBankUnloadBlocking(engine, handle);
+        bestTime = i == 0 || loadTime < bestTime ? loadTime : bestTime;
+        totalTime += loadTime;
+    }
+    
+    printf("  %-22s %8.2f %8.2f\n", description, 1e3 * bestTime, 1e3 * totalTime / numLoads);
+    return KWL_NO_ERROR;
+}
+
+int kwlBenchmark_waveBankLoad(int argc, const char* argv[])
+{
+    if (argc < 1)
+    {
+        return 1;
+    }
+    const int numEntries = argc > 1 ? atoi(argv[1]) : 10000;
+    const int numLoads = argc > 2 ? atoi(argv[2]) : 5;
+    if (numEntries <= 0 || numLoads <= 0)
+    {
+        return 1;
+    }
+    
+    char engineDataPath[1024];
+    char waveBankPath[1024];
+    char shuffledWaveBankPath[1024];
+    sprintf(engineDataPath, "%s/wavebankload.kwl", argv[0]);
+    sprintf(waveBankPath, "%s/wavebankload.kwb", argv[0]);
+    sprintf(shuffledWaveBankPath, "%s/wavebankload_shuffled.kwb", argv[0]);
+    
+    /*one large wave bank, and the single event the engine data needs.*/
+    kwlBenchmarkProjectSize size;
+    size.numMixBuses = 1;
+    size.numMixPresets = 1;
+    size.numWaveBanks = 1;
+    size.numWaveBankEntries = numEntries;
+    size.numSounds = 1;
+    size.numEvents = 1;
+    
+    kwlEngineDataBinary bin;
+    kwlBenchmark_createEngineData(&bin, &size);
+    if (kwlEngineDataBinary_writeToFile(&bin, engineDataPath) != KWL_SUCCESS)
+    {
+        printf("Could not write '%s'.\n", engineDataPath);
+        kwlEngineDataBinary_free(&bin);
+        return 1;
+    }
+    kwlBenchmark_writeWaveBank(&bin, 0, KWL_BENCHMARK_WAVE_BANK_NUM_FRAMES, 0, waveBankPath);
+    kwlBenchmark_writeWaveBank(&bin, 0, KWL_BENCHMARK_WAVE_BANK_NUM_FRAMES, 1, shuffledWaveBankPath);
+    kwlEngineDataBinary_free(&bin);
+    
+    kwlEngineInstance* engine = kwlEngineCreateOffline(44100, 2, NULL, NULL);
+    if (engine == NULL)
+    {
+        printf("Could not create an offline engine instance.\n");
+        return 1;
+    }
+    
+    kwlInstanceEngineDataLoad(engine, engineDataPath);
+    kwlError result = kwlInstanceGetError(engine);
+    if (result != KWL_NO_ERROR)
+    {
+        printf("Could not load '%s' (error %d).\n", engineDataPath, result);
+        kwlEngineDestroy(engine);
+        return 1;
+    }
+    
+    printf("%d entries of %d frames, %d loads, in ms per load\n", numEntries, KWL_BENCHMARK_WAVE_BANK_NUM_FRAMES, numLoads);
+    printf("  %-22s %8s %8s\n", "", "best", "mean");
+    
+    result = kwlBenchmark_loadWaveBank(engine, waveBankPath, 0, numLoads, "in memory");
+    if (result == KWL_NO_ERROR)
+    {
+        result = kwlBenchmark_loadWaveBank(engine, waveBankPath, 1, numLoads, "on demand");
+    }
+    if (result == KWL_NO_ERROR)
+    {
+        result = kwlBenchmark_loadWaveBank(engine, shuffledWaveBankPath, 0, numLoads, "shuffled, in memory");
+    }
+    if (result == KWL_NO_ERROR)
+    {
+        result = kwlBenchmark_loadWaveBank(engine, shuffledWaveBankPath, 1, numLoads, "shuffled, on demand");
+    }
+    
+    kwlEngineDestroy(engine);
+    
+    return result == KWL_NO_ERROR ? 0 : 1;
+}
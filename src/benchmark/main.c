@@ -0,0 +1,119 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+
+#include "kwl_benchmark.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * The available benchmarks. The numbers they print are meant to be compared 
+ * between builds of different revisions on the same machine.
+ */
+static const kwlBenchmark benchmarks[] =
+{
+    {"imaadpcm", "adpcmfile [passes]", 
+     "IMA ADPCM decoding throughput, compared to a per nibble reference decoder.", 
+     kwlBenchmark_imaadpcm},
+    {"vorbisstart", "oggfile [starts]", 
+     "Ogg Vorbis decoder start time, with and without headers and codebooks shared through the audio data.", 
+     kwlBenchmark_oggvorbisStart},
+    {"vorbisdecode", "oggfile [passes]", 
+     "Ogg Vorbis decoding throughput and an output hash to compare with a build defining _V_NO_SIMD.", 
+     kwlBenchmark_oggvorbisDecode},
+    {"eventstart", "offline|host|ondemand enginedata wavebank starts eventid [eventid ...]", 
+     "Start latency and time until audible of events, for example streamed events, on an offline or host driven instance. ondemand loads the wave bank on demand on a host driven instance.", 
+     kwlBenchmark_eventStart},
+    {"wavebankload", "directory [entries] [loads]", 
+     "Load time of a synthetic wave bank written to a given directory, in memory and on demand.", 
+     kwlBenchmark_waveBankLoad},
+    {"enginedataload", "directory [loads]", 
+     "Load and unload time of engine data for a large synthetic project written to a given directory.", 
+     kwlBenchmark_engineDataLoad},
+    {"freeformchurn", "[liveevents] [iterations]", 
+     "Time to release a freeform buffer event and create a new one, with a given number of live events.", 
+     kwlBenchmark_freeformEventChurn},
+    {"commandbuffers", "[frames] [commands]", 
+     "Time to record and apply event calls from 8 threads, in command buffers and in a mutex protected queue.", 
+     kwlBenchmark_commandBuffers},
+    {"eventparameters", "[runs]", 
+     "Time to set the parameters of 10000 positional freeform events from an array of structs, per call and batched.", 
+     kwlBenchmark_eventParameters},
+    {"allocationchurn", "[liveblocks] [pairs]", 
+     "Time to free and allocate blocks among many live blocks, with allocation tracking in builds defining KWL_DEBUG_MEMORY.", 
+     kwlBenchmark_allocationChurn},
+    {"wavebankunload", "enginedata wavebank eventid [unloads]", 
+     "Wall and CPU time of blocking wave bank unloads and time until unload callbacks while an event, for example a streamed one, plays on a host driven instance.", 
+     kwlBenchmark_waveBankUnload},
+    {"enginedatareload", "enginedata wavebank eventid reloads [enginedata ...]", 
+     "Time until engine data reloads complete while an event plays on a host driven instance, alternating between the given engine data files.", 
+     kwlBenchmark_engineDataReload},
+    {"offlineinstances", "enginedata wavebank eventid [instances] [buffers]", 
+     "Audio data memory and render time of offline instances sharing audio data, sequentially and on parallel threads.", 
+     kwlBenchmark_offlineInstances},
+    {"streamreads", "enginedata wavebank seconds eventid...", 
+     "File reads and streaming I/O statistics while streamed events play in real time on a host driven instance.", 
+     kwlBenchmark_streamReads},
+};
+
+static const int numBenchmarks = sizeof(benchmarks) / sizeof(benchmarks[0]);
+
+static void printUsage()
+{
+    printf("Run a benchmark:\n");
+    printf("    kowalski_benchmark name [arguments]\n");
+    printf("\n");
+    printf("Benchmarks:\n");
+    for (int i = 0; i < numBenchmarks; i++)
+    {
+        printf("    %s %s\n", benchmarks[i].name, benchmarks[i].arguments);
+        printf("        %s\n", benchmarks[i].description);
+    }
+}
+
+int main(int argc, const char * argv[])
+{
+    if (argc < 2)
+    {
+        printUsage();
+        return 1;
+    }
+    
+    for (int i = 0; i < numBenchmarks; i++)
+    {
+        if (strcmp(argv[1], benchmarks[i].name) == 0)
+        {
+            const int result = benchmarks[i].run(argc - 2, &argv[2]);
+            if (result != 0 && argc - 2 == 0)
+            {
+                printUsage();
+            }
+            return result;
+        }
+    }
+    
+    printf("Invalid benchmark '%s'.\n\n", argv[1]);
+    printUsage();
+    return 1;
+}
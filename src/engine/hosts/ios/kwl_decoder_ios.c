@@ -147,7 +147,7 @@ static void checkAudioFileOpenError(OSStatus result)
 kwlError kwlInitDecoderIPhone(kwlDecoder* decoder)
 {
     /* Allocate decoder data.*/
-    kwlIPhoneDecoderData* data = (kwlIPhoneDecoderData*)KWL_MALLOC(sizeof(kwlIPhoneDecoderData), "iphone decoder data");
+    kwlIPhoneDecoderData* data = (kwlIPhoneDecoderData*)KWL_MALLOC(sizeof(kwlIPhoneDecoderData), KWL_MEMORY_CATEGORY_DECODER, "iphone decoder data");
     kwlMemset(data, 0, sizeof(kwlIPhoneDecoderData));
     
     /* Hook up data and callbacks to the decoder.*/
@@ -228,7 +228,7 @@ kwlError kwlInitDecoderIPhone(kwlDecoder* decoder)
     /*
      * Allocate a buffer to read packets of encoded audio data into.
      */
-    data->packetOutBuffer = KWL_MALLOC(data->packetSizeUpperBound, "iphone decoder packet out buffer");
+    data->packetOutBuffer = KWL_MALLOC(data->packetSizeUpperBound, KWL_MEMORY_CATEGORY_DECODER, "iphone decoder packet out buffer");
     
     /*
      * Create the audio converter
@@ -300,7 +300,7 @@ kwlError kwlInitDecoderIPhone(kwlDecoder* decoder)
 
     if (err == noErr)
     {
-        void *magicCookie = KWL_MALLOC(magicCookieSize, "iOS decoder magic cookie");
+        void *magicCookie = KWL_MALLOC(magicCookieSize, KWL_MEMORY_CATEGORY_DECODER, "iOS decoder magic cookie");
         if (magicCookie) 
         {
             err = AudioFileGetProperty(audioFileID, 
@@ -330,11 +330,12 @@ kwlError kwlInitDecoderIPhone(kwlDecoder* decoder)
     AudioBuffer buffer = {0, 0, NULL};
     buffer.mNumberChannels = 2;
     buffer.mDataByteSize = nFrames * 2 * buffer.mNumberChannels;
-    buffer.mData = KWL_MALLOC(buffer.mDataByteSize, "ios decoder buffer");
+    buffer.mData = KWL_MALLOC(buffer.mDataByteSize, KWL_MEMORY_CATEGORY_DECODER, "ios decoder buffer");
     data->bufferList.mNumberBuffers = 1;
     data->bufferList.mBuffers[0] = buffer;
     
     decoder->numChannels = destinationFormat.mChannelsPerFrame;
+    decoder->sampleRate = (int)destinationFormat.mSampleRate;
     decoder->maxDecodedBufferSize = 2 * nFrames * decoder->numChannels;
     decoder->currentDecodedBufferSizeInBytes = 0;
         
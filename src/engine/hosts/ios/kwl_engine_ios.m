@@ -151,9 +151,9 @@ OSStatus coreAudioInputCallback(void *inRefCon,
     while (currFrame < inNumberFrames)
     {
         int numFramesToMix = inNumberFrames - currFrame;
-        if (numFramesToMix > KWL_TEMP_BUFFER_SIZE_IN_FRAMES)
+        if (numFramesToMix > mixer->tempBufferSizeInFrames)
         {
-            numFramesToMix = KWL_TEMP_BUFFER_SIZE_IN_FRAMES;
+            numFramesToMix = mixer->tempBufferSizeInFrames;
         }
         
         /*Convert input buffer samples to floats*/
@@ -202,9 +202,9 @@ OSStatus coreAudioOutputCallback(void *inRefCon,
     while (currFrame < inNumberFrames)
     {
         int numFramesToMix = inNumberFrames - currFrame;
-        if (numFramesToMix > KWL_TEMP_BUFFER_SIZE_IN_FRAMES)
+        if (numFramesToMix > mixer->tempBufferSizeInFrames)
         {
-            numFramesToMix = KWL_TEMP_BUFFER_SIZE_IN_FRAMES;
+            numFramesToMix = mixer->tempBufferSizeInFrames;
         }
     
         /*prepare a new buffer*/
@@ -227,7 +227,7 @@ void stopAndDeinitRemoteIO()
     status = AudioUnitUninitialize(auComponentInstance);
     KWL_ASSERT(status == noErr);
     
-    free(inputBufferList.mBuffers[0].mData);
+    KWL_FREE(inputBufferList.mBuffers[0].mData);
     inputBufferList.mBuffers[0].mData = NULL;
 }
 
@@ -338,7 +338,9 @@ void initAndStartRemoteIO()
         inputBufferList.mBuffers[0].mNumberChannels = numInChannels;
         inputBufferByteSize = 2 * numInChannels * maxSliceSize;
         inputBufferList.mBuffers[0].mDataByteSize = inputBufferByteSize;
-        inputBufferList.mBuffers[0].mData = malloc(inputBufferList.mBuffers[0].mDataByteSize);
+        inputBufferList.mBuffers[0].mData = KWL_MALLOC(inputBufferList.mBuffers[0].mDataByteSize, 
+                                                       KWL_MEMORY_CATEGORY_MIXER, 
+                                                       "ios input buffer");
     }
     
     KWL_ASSERT(status == noErr);
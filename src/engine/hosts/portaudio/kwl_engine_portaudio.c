@@ -56,7 +56,7 @@ static int paCallback(const void *inputBuffer,
     
     /*Fill the output buffer. For efficiency reasons, the 
       mixer has an internal maximum buffer size determined 
-      by KWL_TEMP_BUFFER_SIZE_IN_FRAMES. If the size of the 
+      by the engine config. If the size of the 
       requested output buffer exceeds the internal buffer 
       size, multiple calls to kwlMixer_render 
       are made. This is typically not the case.*/
@@ -65,9 +65,9 @@ static int paCallback(const void *inputBuffer,
     {
         /*Compute the number of frames to mix.*/
         int numFramesToMix = framesPerBuffer - currFrame;
-        if (numFramesToMix > KWL_TEMP_BUFFER_SIZE_IN_FRAMES)
+        if (numFramesToMix > mixer->tempBufferSizeInFrames)
         {
-            numFramesToMix = KWL_TEMP_BUFFER_SIZE_IN_FRAMES;
+            numFramesToMix = mixer->tempBufferSizeInFrames;
         }
         
         /*Perform mixing.*/
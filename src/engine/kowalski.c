@@ -25,6 +25,7 @@ freely, subject to the following restrictions:
 #include "kowalski.h"
 #include "kowalski.h"
 #include "kwl_audiofileutil.h"
+#include "kwl_commandbuffer.h"
 #include "kwl_dspunit.h"
 #include "kwl_memory.h"
 #include "kwl_engine.h"
@@ -33,442 +34,760 @@ freely, subject to the following restrictions:
 #include <stdlib.h>
 #include <string.h>
 
-kwlEngine* engine = NULL;
+/** The engine instance driven by the functions that don't take an engine pointer.*/
+kwlEngine* defaultEngine = NULL;
 
+/** The first error of a call made without an engine instance.*/
 kwlError error = KWL_NO_ERROR;
 
-static void kwlSetError(kwlError err)
+static void kwlSetError(kwlEngine* engine, kwlError err)
 {
     if (err != KWL_NO_ERROR)
     {
         //printf("KWL ERROR: %d\n", err);
     }
     
-    if (error == KWL_NO_ERROR)
+    kwlError* errorSlot = engine != NULL ? &engine->error : &error;
+    if (*errorSlot == KWL_NO_ERROR)
     {
-        error = err;
+        *errorSlot = err;
     }
 }
 
-kwlError kwlGetError(void)
+kwlError kwlInstanceGetError(kwlEngineInstance* engine)
 {
-    kwlError errorToReturn = error;
-    error = KWL_NO_ERROR;
+    kwlError* errorSlot = engine != NULL ? &engine->error : &error;
+    kwlError errorToReturn = *errorSlot;
+    *errorSlot = KWL_NO_ERROR;
     return errorToReturn;
 }
 
+kwlError kwlGetError(void)
+{
+    /*calls made before initialization or after deinitialization report
+      through the global error, all other calls through the default engine*/
+    kwlError errorToReturn = kwlInstanceGetError(NULL);
+    kwlError engineError = defaultEngine != NULL ? kwlInstanceGetError(defaultEngine) : KWL_NO_ERROR;
+    return errorToReturn != KWL_NO_ERROR ? errorToReturn : engineError;
+}
+
+/** */
+void kwlInstanceEventSetPitch(kwlEngineInstance* engine, kwlEventHandle handle, float pitchInPercent)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    kwlSetError(engine, kwlEngine_eventSetPitch(engine, handle, pitchInPercent));
+}
+
+/** */
 void kwlEventSetPitch(kwlEventHandle handle, float pitchInPercent)
+{
+    kwlInstanceEventSetPitch(defaultEngine, handle, pitchInPercent);
+}
+
+void kwlInstanceEventSetGain(kwlEngineInstance* engine, kwlEventHandle handle, float gain)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
-    kwlSetError(kwlEngine_eventSetPitch(engine, handle, pitchInPercent));
+    
+    kwlSetError(engine, kwlEngine_eventSetGain(engine, handle, gain, 0));
 }
 
+/** */
 void kwlEventSetGain(kwlEventHandle handle, float gain)
+{
+    kwlInstanceEventSetGain(defaultEngine, handle, gain);
+}
+
+void kwlInstanceEventSetLinearGain(kwlEngineInstance* engine, kwlEventHandle handle, float gain)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
     
-    kwlSetError(kwlEngine_eventSetGain(engine, handle, gain, 0));
+    kwlSetError(engine, kwlEngine_eventSetGain(engine, handle, gain, 1));
 }
 
+/** */
 void kwlEventSetLinearGain(kwlEventHandle handle, float gain)
+{
+    kwlInstanceEventSetLinearGain(defaultEngine, handle, gain);
+}
+
+
+void kwlInstanceEventSetPosition(kwlEngineInstance* engine, kwlEventHandle handle, float posX, float posY, float posZ)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
     
-    kwlSetError(kwlEngine_eventSetGain(engine, handle, gain, 1));
+    kwlSetError(engine, kwlEngine_eventSetPosition(engine, handle, posX, posY, posZ));
 }
 
-
+/** */
 void kwlEventSetPosition(kwlEventHandle handle, float posX, float posY, float posZ)
+{
+    kwlInstanceEventSetPosition(defaultEngine, handle, posX, posY, posZ);
+}
+
+void kwlInstanceEventSetVelocity(kwlEngineInstance* engine, kwlEventHandle handle, float velX, float velY, float velZ)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
     
-    kwlSetError(kwlEngine_eventSetPosition(engine, handle, posX, posY, posZ));
+    kwlSetError(engine, kwlEngine_eventSetVelocity(engine, handle, velX, velY, velZ));
 }
 
+/** */
 void kwlEventSetVelocity(kwlEventHandle handle, float velX, float velY, float velZ)
+{
+    kwlInstanceEventSetVelocity(defaultEngine, handle, velX, velY, velZ);
+}
+
+void kwlInstanceEventSetOrientation(kwlEngineInstance* engine, kwlEventHandle handle, float directionX, float directionY, float directionZ)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
     
-    kwlSetError(kwlEngine_eventSetVelocity(engine, handle, velX, velY, velZ));
+    kwlSetError(engine, kwlEngine_eventSetOrientation(engine, handle, directionX, directionY, directionZ));
 }
 
+/** */
 void kwlEventSetOrientation(kwlEventHandle handle, float directionX, float directionY, float directionZ)
+{
+    kwlInstanceEventSetOrientation(defaultEngine, handle, directionX, directionY, directionZ);
+}
+
+void kwlInstanceEventSetBalance(kwlEngineInstance* engine, kwlEventHandle handle, float balance)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
     
-    kwlSetError(kwlEngine_eventSetOrientation(engine, handle, directionX, directionY, directionZ));
+    kwlSetError(engine, kwlEngine_eventSetBalance(engine, handle, balance));
 }
 
+/** */
 void kwlEventSetBalance(kwlEventHandle handle, float balance)
+{
+    kwlInstanceEventSetBalance(defaultEngine, handle, balance);
+}
+
+void kwlInstanceEventBatchSetParameters(kwlEngineInstance* engine,
+                                        const kwlEventHandle* handles, 
+                                        int numEvents, 
+                                        const kwlEventParameterBatch* parameters, 
+                                        kwlError* errors)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
     
-    kwlSetError(kwlEngine_eventSetBalance(engine, handle, balance));
+    kwlSetError(engine, kwlEngine_eventBatchSetParameters(engine, handles, numEvents, parameters, errors));
 }
 
-kwlEventHandle kwlEventGetHandle(const char* const eventId)
+/** */
+void kwlEventBatchSetParameters(const kwlEventHandle* handles, 
+                                int numEvents, 
+                                const kwlEventParameterBatch* parameters, 
+                                kwlError* errors)
+{
+    kwlInstanceEventBatchSetParameters(defaultEngine, handles, numEvents, parameters, errors);
+}
+
+kwlEventHandle kwlInstanceEventGetHandle(kwlEngineInstance* engine, const char* const eventId)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return KWL_INVALID_HANDLE;
     }
     
     kwlEventHandle handle = 0;
-    kwlSetError(kwlEngine_eventGetHandle(engine, eventId, &handle));
+    kwlSetError(engine, kwlEngine_eventGetHandle(engine, eventId, &handle));
     return handle;
 }
 
-kwlEventDefinitionHandle kwlEventDefinitionGetHandle(const char* const eventDefinitionID)
+/** */
+kwlEventHandle kwlEventGetHandle(const char* const eventId)
+{
+    return kwlInstanceEventGetHandle(defaultEngine, eventId);
+}
+
+kwlEventDefinitionHandle kwlInstanceEventDefinitionGetHandle(kwlEngineInstance* engine, const char* const eventDefinitionID)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return KWL_INVALID_HANDLE;
     }
     
     kwlEventDefinitionHandle handle = 0;
-    kwlSetError(kwlEngine_eventDefinitionGetHandle(engine, 
+    kwlSetError(engine, kwlEngine_eventDefinitionGetHandle(engine, 
                                                         eventDefinitionID, 
                                                         &handle));
     return handle;
 }
 
-kwlEventHandle kwlEventCreateWithFile(const char* const audioFilePath, kwlEventType eventType, int streamFromDisk)
+/** */
+kwlEventDefinitionHandle kwlEventDefinitionGetHandle(const char* const eventDefinitionID)
+{
+    return kwlInstanceEventDefinitionGetHandle(defaultEngine, eventDefinitionID);
+}
+
+kwlEventHandle kwlInstanceEventCreateWithFile(kwlEngineInstance* engine, const char* const audioFilePath, kwlEventType eventType, int streamFromDisk)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return KWL_INVALID_HANDLE;
     }
     
     kwlEventHandle handle = 0;
-    kwlSetError(kwlEngine_eventCreateWithFile(engine, audioFilePath, &handle, eventType, streamFromDisk));
+    kwlSetError(engine, kwlEngine_eventCreateWithFile(engine, audioFilePath, &handle, eventType, streamFromDisk));
     return handle;
 }
 
-kwlEventHandle kwlEventCreateWithBuffer(kwlPCMBuffer* buffer, kwlEventType eventType)
+/** */
+kwlEventHandle kwlEventCreateWithFile(const char* const audioFilePath, kwlEventType eventType, int streamFromDisk)
+{
+    return kwlInstanceEventCreateWithFile(defaultEngine, audioFilePath, eventType, streamFromDisk);
+}
+
+kwlEventHandle kwlInstanceEventCreateWithBuffer(kwlEngineInstance* engine, kwlPCMBuffer* buffer, kwlEventType eventType)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return KWL_INVALID_HANDLE;
     }
     
     kwlEventHandle handle = 0;
-    kwlSetError(kwlEngine_eventCreateWithBuffer(engine, buffer, &handle, eventType));
+    kwlSetError(engine, kwlEngine_eventCreateWithBuffer(engine, buffer, &handle, eventType));
     return handle;
 }
 
+/** */
+kwlEventHandle kwlEventCreateWithBuffer(kwlPCMBuffer* buffer, kwlEventType eventType)
+{
+    return kwlInstanceEventCreateWithBuffer(defaultEngine, buffer, eventType);
+}
+
+void kwlInstanceEventRelease(kwlEngineInstance* engine, kwlEventHandle handle)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    
+    kwlSetError(engine, kwlEngine_eventRelease(engine, handle));
+}
+
+/** */
 void kwlEventRelease(kwlEventHandle handle)
+{
+    kwlInstanceEventRelease(defaultEngine, handle);
+}
+
+void kwlInstanceEventStart(kwlEngineInstance* engine, kwlEventHandle handle)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
     
-    kwlSetError(kwlEngine_eventRelease(engine, handle));
+    kwlSetError(engine, kwlEngine_eventStart(engine, handle, 0, 0));
 }
 
+/** */
 void kwlEventStart(kwlEventHandle handle)
+{
+    kwlInstanceEventStart(defaultEngine, handle);
+}
+
+void kwlInstanceEventStartOneShot(kwlEngineInstance* engine, kwlEventDefinitionHandle handle)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
-    }
+    }    
     
-    kwlSetError(kwlEngine_eventStart(engine, handle, 0));
+    kwlSetError(engine, kwlEngine_eventStartOneShot(engine, handle, 0.0f, 0.0f, 0.0f, 0, NULL, NULL));
 }
 
+/** */
 void kwlEventStartOneShot(kwlEventDefinitionHandle handle)
+{
+    kwlInstanceEventStartOneShot(defaultEngine, handle);
+}
+
+void kwlInstanceEventStartOneShotAt(kwlEngineInstance* engine, kwlEventDefinitionHandle handle, float x, float y, float z)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
-    }    
+    }
     
-    kwlSetError(kwlEngine_eventStartOneShot(engine, handle, 0.0f, 0.0f, 0.0f, 0, NULL, NULL));
+    kwlSetError(engine, kwlEngine_eventStartOneShot(engine, handle, x, y, z, 1, NULL, NULL));
 }
 
+/** */
 void kwlEventStartOneShotAt(kwlEventDefinitionHandle handle, float x, float y, float z)
+{
+    kwlInstanceEventStartOneShotAt(defaultEngine, handle, x, y, z);
+}
+
+void kwlInstanceEventSetCallback(kwlEngineInstance* engine, kwlEventHandle handle, kwlEventStoppedCallack callback, void* userData)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
     
-    kwlSetError(kwlEngine_eventStartOneShot(engine, handle, x, y, z, 1, NULL, NULL));
+    kwlSetError(engine, kwlEngine_eventSetStoppedCallback(engine, handle, callback, userData));
+    
 }
 
+/** */
 void kwlEventSetCallback(kwlEventHandle handle, kwlEventStoppedCallack callback, void* userData)
+{
+    kwlInstanceEventSetCallback(defaultEngine, handle, callback, userData);
+}
+
+void kwlInstanceEventGetStreamingIOStats(kwlEngineInstance* engine, kwlEventHandle handle, kwlStreamingIOStats* stats)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    if (stats == NULL)
+    {
+        kwlSetError(engine, KWL_INVALID_PARAMETER_VALUE);
+        return;
+    }
+    
+    kwlSetError(engine, kwlEngine_eventGetStreamingIOStats(engine, handle, stats));
+}
+
+/** */
+void kwlEventGetStreamingIOStats(kwlEventHandle handle, kwlStreamingIOStats* stats)
+{
+    kwlInstanceEventGetStreamingIOStats(defaultEngine, handle, stats);
+}
+
+void kwlInstanceEventPrefetch(kwlEngineInstance* engine, kwlEventHandle handle)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
     
-    kwlSetError(kwlEngine_eventSetStoppedCallback(engine, handle, callback, userData));
+    kwlSetError(engine, kwlEngine_eventPrefetch(engine, handle));
+}
+
+/** */
+void kwlEventPrefetch(kwlEventHandle handle)
+{
+    kwlInstanceEventPrefetch(defaultEngine, handle);
+}
+
+void kwlInstanceEventStartOneShotWithCallback(kwlEngineInstance* engine, kwlEventDefinitionHandle eventDefinition, kwlEventStoppedCallack callback, void* userData)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
     
+    kwlSetError(engine, kwlEngine_eventStartOneShot(engine, eventDefinition, 0.0f, 0.0f, 0.0f, 0, callback, userData));
 }
 
+/** */
 void kwlEventStartOneShotWithCallback(kwlEventDefinitionHandle eventDefinition, kwlEventStoppedCallack callback, void* userData)
+{
+    kwlInstanceEventStartOneShotWithCallback(defaultEngine, eventDefinition, callback, userData);
+}
+
+void kwlInstanceEventStartOneShotWithCallbackAt(kwlEngineInstance* engine, kwlEventDefinitionHandle eventDefinition, float x, float y, float z, kwlEventStoppedCallack callback, void* userData)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
     
-    kwlSetError(kwlEngine_eventStartOneShot(engine, eventDefinition, 0.0f, 0.0f, 0.0f, 0, callback, userData));
+    kwlSetError(engine, kwlEngine_eventStartOneShot(engine, eventDefinition, x, y, z, 1, callback, userData));
+    
 }
 
+/** */
 void kwlEventStartOneShotWithCallbackAt(kwlEventDefinitionHandle eventDefinition, float x, float y, float z, kwlEventStoppedCallack callback, void* userData)
+{
+    kwlInstanceEventStartOneShotWithCallbackAt(defaultEngine, eventDefinition, x, y, z, callback, userData);
+}
+
+void kwlInstanceEventStartFade(kwlEngineInstance* engine, kwlEventHandle handle, float fadeTime)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
     
-    kwlSetError(kwlEngine_eventStartOneShot(engine, eventDefinition, x, y, z, 1, callback, userData));
-    
+    kwlSetError(engine, kwlEngine_eventStart(engine, handle, fadeTime, 0));
 }
 
+/** */
 void kwlEventStartFade(kwlEventHandle handle, float fadeTime)
+{
+    kwlInstanceEventStartFade(defaultEngine, handle, fadeTime);
+}
+
+void kwlInstanceEventStop(kwlEngineInstance* engine, kwlEventHandle handle)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
     
-    kwlSetError(kwlEngine_eventStart(engine, handle, fadeTime));
+    kwlSetError(engine, kwlEngine_eventStop(engine, handle, 0, 0));
 }
 
+/** */
 void kwlEventStop(kwlEventHandle handle)
+{
+    kwlInstanceEventStop(defaultEngine, handle);
+}
+
+void kwlInstanceEventStopFade(kwlEngineInstance* engine, kwlEventHandle handle, float fadeTime)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
     
-    kwlSetError(kwlEngine_eventStop(engine, handle, 0));
+    kwlSetError(engine, kwlEngine_eventStop(engine, handle, fadeTime, 0));
 }
 
+/** */
 void kwlEventStopFade(kwlEventHandle handle, float fadeTime)
+{
+    kwlInstanceEventStopFade(defaultEngine, handle, fadeTime);
+}
+
+void kwlInstanceEventStartAtFrame(kwlEngineInstance* engine, kwlEventHandle handle, long long frame)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
     
-    kwlSetError(kwlEngine_eventStop(engine, handle, fadeTime));
+    kwlSetError(engine, kwlEngine_eventStart(engine, handle, 0, frame));
 }
 
-void kwlEventPause(kwlEventHandle handle)
+/** */
+void kwlEventStartAtFrame(kwlEventHandle handle, long long frame)
+{
+    kwlInstanceEventStartAtFrame(defaultEngine, handle, frame);
+}
+
+void kwlInstanceEventStopAtFrame(kwlEngineInstance* engine, kwlEventHandle handle, long long frame)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
     
-    kwlSetError(kwlEngine_eventPause(engine, handle));
+    kwlSetError(engine, kwlEngine_eventStop(engine, handle, 0, frame));
 }
 
-void kwlEventResume(kwlEventHandle handle)
+/** */
+void kwlEventStopAtFrame(kwlEventHandle handle, long long frame)
+{
+    kwlInstanceEventStopAtFrame(defaultEngine, handle, frame);
+}
+
+void kwlInstanceEventPause(kwlEngineInstance* engine, kwlEventHandle handle)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
     
-    kwlSetError(kwlEngine_eventResume(engine, handle));
+    kwlSetError(engine, kwlEngine_eventPause(engine, handle));
 }
 
-int kwlEventIsPlaying(kwlEventHandle handle)
+/** */
+void kwlEventPause(kwlEventHandle handle)
+{
+    kwlInstanceEventPause(defaultEngine, handle);
+}
+
+void kwlInstanceEventResume(kwlEngineInstance* engine, kwlEventHandle handle)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    
+    kwlSetError(engine, kwlEngine_eventResume(engine, handle));
+}
+
+/** */
+void kwlEventResume(kwlEventHandle handle)
+{
+    kwlInstanceEventResume(defaultEngine, handle);
+}
+
+int kwlInstanceEventIsPlaying(kwlEngineInstance* engine, kwlEventHandle handle)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return 0;
     }
     
     int ret = 0;
-    kwlSetError(kwlEngine_eventIsPlaying(engine, handle, &ret));
+    kwlSetError(engine, kwlEngine_eventIsPlaying(engine, handle, &ret));
     return ret;
 }
 
+/** */
+int kwlEventIsPlaying(kwlEventHandle handle)
+{
+    return kwlInstanceEventIsPlaying(defaultEngine, handle);
+}
+
 /** 
  * 
  */
-kwlMixBusHandle kwlMixBusGetHandle(const char* const busId)
+kwlMixBusHandle kwlInstanceMixBusGetHandle(kwlEngineInstance* engine, const char* const busId)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return KWL_INVALID_HANDLE;
     }
     
     kwlMixBusHandle handle = 0;
-    kwlSetError(kwlEngine_mixBusGetHandle(engine, busId, &handle));
+    kwlSetError(engine, kwlEngine_mixBusGetHandle(engine, busId, &handle));
     return handle;
 }
 
-void kwlMixBusSetGain(kwlMixBusHandle handle, float gain)
+/** */
+kwlMixBusHandle kwlMixBusGetHandle(const char* const busId)
+{
+    return kwlInstanceMixBusGetHandle(defaultEngine, busId);
+}
+
+void kwlInstanceMixBusSetGain(kwlEngineInstance* engine, kwlMixBusHandle handle, float gain)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
     
-    kwlSetError(kwlEngine_mixBusSetGain(engine, handle, gain, 0));
+    kwlSetError(engine, kwlEngine_mixBusSetGain(engine, handle, gain, 0));
 }
 
-void kwlMixBusSetLinearGain(kwlMixBusHandle handle, float gain)
+/** */
+void kwlMixBusSetGain(kwlMixBusHandle handle, float gain)
+{
+    kwlInstanceMixBusSetGain(defaultEngine, handle, gain);
+}
+
+void kwlInstanceMixBusSetLinearGain(kwlEngineInstance* engine, kwlMixBusHandle handle, float gain)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
     
-    kwlSetError(kwlEngine_mixBusSetGain(engine, handle, gain, 1));
+    kwlSetError(engine, kwlEngine_mixBusSetGain(engine, handle, gain, 1));
 }
 
-void kwlMixBusSetPitch(kwlMixBusHandle handle, float pitch)
+/** */
+void kwlMixBusSetLinearGain(kwlMixBusHandle handle, float gain)
+{
+    kwlInstanceMixBusSetLinearGain(defaultEngine, handle, gain);
+}
+
+void kwlInstanceMixBusSetPitch(kwlEngineInstance* engine, kwlMixBusHandle handle, float pitch)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
     
-    kwlSetError(kwlEngine_mixBusSetPitch(engine, handle, pitch));
+    kwlSetError(engine, kwlEngine_mixBusSetPitch(engine, handle, pitch));
+}
+
+/** */
+void kwlMixBusSetPitch(kwlMixBusHandle handle, float pitch)
+{
+    kwlInstanceMixBusSetPitch(defaultEngine, handle, pitch);
 }
 
 
-kwlMixPresetHandle kwlMixPresetGetHandle(const char* const presetId)
+kwlMixPresetHandle kwlInstanceMixPresetGetHandle(kwlEngineInstance* engine, const char* const presetId)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return KWL_INVALID_HANDLE;
     }
     
     kwlMixPresetHandle handle = 0;
-    kwlSetError(kwlEngine_mixPresetGetHandle(engine, presetId, &handle));
+    kwlSetError(engine, kwlEngine_mixPresetGetHandle(engine, presetId, &handle));
     return handle;
 }
 
-void kwlMixPresetFadeTo(kwlMixPresetHandle presetHandle)
+/** */
+kwlMixPresetHandle kwlMixPresetGetHandle(const char* const presetId)
+{
+    return kwlInstanceMixPresetGetHandle(defaultEngine, presetId);
+}
+
+void kwlInstanceMixPresetFadeTo(kwlEngineInstance* engine, kwlMixPresetHandle presetHandle)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
     
-    kwlSetError(kwlEngine_mixPresetSetActive(engine, presetHandle, 1));
+    kwlSetError(engine, kwlEngine_mixPresetSetActive(engine, presetHandle, 1));
 }
 
-void kwlMixPresetSet(kwlMixPresetHandle presetHandle)
+/** */
+void kwlMixPresetFadeTo(kwlMixPresetHandle presetHandle)
+{
+    kwlInstanceMixPresetFadeTo(defaultEngine, presetHandle);
+}
+
+void kwlInstanceMixPresetSet(kwlEngineInstance* engine, kwlMixPresetHandle presetHandle)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
     
-    kwlSetError(kwlEngine_mixPresetSetActive(engine, presetHandle, 0));
+    kwlSetError(engine, kwlEngine_mixPresetSetActive(engine, presetHandle, 0));
 }
 
-void kwlListenerSetPosition(float posX, float posY, float posZ)
+/** */
+void kwlMixPresetSet(kwlMixPresetHandle presetHandle)
+{
+    kwlInstanceMixPresetSet(defaultEngine, presetHandle);
+}
+
+void kwlInstanceListenerSetPosition(kwlEngineInstance* engine, float posX, float posY, float posZ)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
     
-    kwlSetError(kwlEngine_setListenerPosition(engine, posX, posY, posZ));
+    kwlSetError(engine, kwlEngine_setListenerPosition(engine, posX, posY, posZ));
 }
 
-void kwlListenerSetVelocity(float velX, float velY, float velZ)
+/** */
+void kwlListenerSetPosition(float posX, float posY, float posZ)
+{
+    kwlInstanceListenerSetPosition(defaultEngine, posX, posY, posZ);
+}
+
+void kwlInstanceListenerSetVelocity(kwlEngineInstance* engine, float velX, float velY, float velZ)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
     
-    kwlSetError(kwlEngine_setListenerVelocity(engine, velX, velY, velZ));
+    kwlSetError(engine, kwlEngine_setListenerVelocity(engine, velX, velY, velZ));
 }
 
-void kwlListenerSetOrientation(float directionX, float directionY, float directionZ,
-                               float upX, float upY, float upZ)
+/** */
+void kwlListenerSetVelocity(float velX, float velY, float velZ)
+{
+    kwlInstanceListenerSetVelocity(defaultEngine, velX, velY, velZ);
+}
+
+void kwlInstanceListenerSetOrientation(kwlEngineInstance* engine,
+                                       float directionX, float directionY, float directionZ,
+                                       float upX, float upY, float upZ)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
     
-    kwlSetError(kwlEngine_setListenerOrientation(engine, 
+    kwlSetError(engine, kwlEngine_setListenerOrientation(engine, 
                                                       directionX, directionY, directionZ,
                                                       upX, upY, upZ));
 }
 
-void kwlSetDistanceAttenuationModel(kwlDistanceAttenuationModel type, 
-                                    int clamp,
-                                    float maxDistance,
-                                    float rolloffFactor,
-                                    float referenceDistance)
+/** */
+void kwlListenerSetOrientation(float directionX, float directionY, float directionZ,
+                               float upX, float upY, float upZ)
+{
+    kwlInstanceListenerSetOrientation(defaultEngine, directionX, directionY, directionZ, upX, upY, upZ);
+}
+
+void kwlInstanceSetDistanceAttenuationModel(kwlEngineInstance* engine,
+                                            kwlDistanceAttenuationModel type,
+                                            int clamp,
+                                            float maxDistance,
+                                            float rolloffFactor,
+                                            float referenceDistance)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
     
-    kwlSetError(kwlEngine_setDistanceAttenuationModel(engine,
+    kwlSetError(engine, kwlEngine_setDistanceAttenuationModel(engine,
                                                            type, 
                                                            clamp, 
                                                            maxDistance, 
@@ -476,401 +795,1076 @@ void kwlSetDistanceAttenuationModel(kwlDistanceAttenuationModel type,
                                                            referenceDistance));
 }
 
-void kwlSetDopplerShiftParameters(float speedOfSound, float dopplerScale)
-{
+/** */
+void kwlSetDistanceAttenuationModel(kwlDistanceAttenuationModel type, 
+                                    int clamp,
+                                    float maxDistance,
+                                    float rolloffFactor,
+                                    float referenceDistance)
+{
+    kwlInstanceSetDistanceAttenuationModel(defaultEngine, type, clamp, maxDistance, rolloffFactor, referenceDistance);
+}
+
+void kwlInstanceSetDopplerShiftParameters(kwlEngineInstance* engine, float speedOfSound, float dopplerScale)
+{
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
     
-    kwlSetError(kwlEngine_setDopplerShiftParameters(engine, speedOfSound, dopplerScale));
+    kwlSetError(engine, kwlEngine_setDopplerShiftParameters(engine, speedOfSound, dopplerScale));
 }
 
-void kwlSetConeAttenuationEnabled(int enableListenerCone, int enableEventCones)
+/** */
+void kwlSetDopplerShiftParameters(float speedOfSound, float dopplerScale)
+{
+    kwlInstanceSetDopplerShiftParameters(defaultEngine, speedOfSound, dopplerScale);
+}
+
+void kwlInstanceSetConeAttenuationEnabled(kwlEngineInstance* engine, int enableListenerCone, int enableEventCones)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
     
-    kwlSetError(kwlEngine_setConeAttenuationEnabled(engine, enableListenerCone, enableEventCones));
+    kwlSetError(engine, kwlEngine_setConeAttenuationEnabled(engine, enableListenerCone, enableEventCones));
 }
 
-void kwlListenerSetConeParameters(float innerConeAngle, float outerConeAngle, float outerConeGain)
+/** */
+void kwlSetConeAttenuationEnabled(int enableListenerCone, int enableEventCones)
+{
+    kwlInstanceSetConeAttenuationEnabled(defaultEngine, enableListenerCone, enableEventCones);
+}
+
+void kwlInstanceListenerSetConeParameters(kwlEngineInstance* engine, float innerConeAngle, float outerConeAngle, float outerConeGain)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
     
-    kwlSetError(kwlEngine_setListenerConeParameters(engine, innerConeAngle, outerConeAngle, outerConeGain));
+    kwlSetError(engine, kwlEngine_setListenerConeParameters(engine, innerConeAngle, outerConeAngle, outerConeGain));
 }
 
-void kwlMixerResume(void)
+/** */
+void kwlListenerSetConeParameters(float innerConeAngle, float outerConeAngle, float outerConeGain)
+{
+    kwlInstanceListenerSetConeParameters(defaultEngine, innerConeAngle, outerConeAngle, outerConeGain);
+}
+
+void kwlInstanceMixerResume(kwlEngineInstance* engine)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
     
-    kwlSetError(kwlEngine_resume(engine));
+    kwlSetError(engine, kwlEngine_resume(engine));
 }
 
-void kwlMixerPause(void)
+/** */
+void kwlMixerResume(void)
+{
+    kwlInstanceMixerResume(defaultEngine);
+}
+
+void kwlInstanceMixerPause(kwlEngineInstance* engine)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
     
-    kwlSetError(kwlEngine_pause(engine));
+    kwlSetError(engine, kwlEngine_pause(engine));
 }
 
-float kwlGetLevelLeft(void)
+/** */
+void kwlMixerPause(void)
+{
+    kwlInstanceMixerPause(defaultEngine);
+}
+
+float kwlInstanceGetLevelLeft(kwlEngineInstance* engine)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return 0.0f;
     }
     
     float levelLeft = 0.0f;
     float levelRight = 0.0f;
-    kwlSetError(kwlEngine_getOutLevels(engine, &levelLeft, &levelRight));
+    kwlSetError(engine, kwlEngine_getOutLevels(engine, &levelLeft, &levelRight));
     return levelLeft;
 }
 
-float kwlGetLevelRight(void)
+/** */
+float kwlGetLevelLeft(void)
+{
+    return kwlInstanceGetLevelLeft(defaultEngine);
+}
+
+float kwlInstanceGetLevelRight(kwlEngineInstance* engine)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return 0.0f;
     }
     
     float levelLeft = 0.0f;
     float levelRight = 0.0f;
-    kwlSetError(kwlEngine_getOutLevels(engine, &levelLeft, &levelRight));
+    kwlSetError(engine, kwlEngine_getOutLevels(engine, &levelLeft, &levelRight));
     return levelRight;
 }
 
-int kwlHasClipped(void)
+/** */
+float kwlGetLevelRight(void)
+{
+    return kwlInstanceGetLevelRight(defaultEngine);
+}
+
+int kwlInstanceHasClipped(kwlEngineInstance* engine)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return 0;
     }
     
     int hasClipped = 0;
-    kwlSetError(kwlEngine_hasClipped(engine, &hasClipped));
+    kwlSetError(engine, kwlEngine_hasClipped(engine, &hasClipped));
     return hasClipped;
 }
 
-void kwlLevelMeteringSetEnabled(int enabled)
+/** */
+int kwlHasClipped(void)
+{
+    return kwlInstanceHasClipped(defaultEngine);
+}
+
+void kwlInstanceLevelMeteringSetEnabled(kwlEngineInstance* engine, int enabled)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
     
     engine->mixer->isLevelMeteringEnabled.valueEngine = enabled;
 }
 
+/** */
+void kwlLevelMeteringSetEnabled(int enabled)
+{
+    kwlInstanceLevelMeteringSetEnabled(defaultEngine, enabled);
+}
+
 
-void kwlUpdate(float timeStepSec)
+void kwlInstanceUpdate(kwlEngineInstance* engine, float timeStepSec)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
     if (timeStepSec < 0.0f)
     {
-        kwlSetError(KWL_INVALID_PARAMETER_VALUE);
+        kwlSetError(engine, KWL_INVALID_PARAMETER_VALUE);
         return;
     }
     
-    kwlSetError(kwlEngine_update(engine, timeStepSec));
+    kwlSetError(engine, kwlEngine_update(engine, timeStepSec));
 }
 
-kwlWaveBankHandle kwlWaveBankLoad(const char* const path)
+/** */
+void kwlUpdate(float timeStepSec)
 {
-    if (engine == NULL)
-    {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
-        return KWL_INVALID_HANDLE;
-    }
-    kwlWaveBankHandle handle = 0;
-    kwlSetError(kwlEngine_loadWaveBank(engine, path, &handle, 0));
-    return handle;
+    kwlInstanceUpdate(defaultEngine, timeStepSec);
 }
 
-int kwlWaveBankIsLoaded(kwlWaveBankHandle handle)
+void kwlInstanceGetStreamingIOStats(kwlEngineInstance* engine, kwlStreamingIOStats* stats)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
-        return 0;
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
     }
-    
-    int isLoaded = 0;
-    kwlSetError(kwlEngine_waveBankIsLoaded(engine, handle, &isLoaded));
-    return isLoaded;
-}
-
-int kwlWaveBankIsReferencedByPlayingEvent(kwlWaveBankHandle handle)
-{
-    if (engine == NULL)
+    if (stats == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
-        return 0;
+        kwlSetError(engine, KWL_INVALID_PARAMETER_VALUE);
+        return;
     }
     
-    int isReferenced = 0;
-    kwlSetError(kwlEngine_waveBankIsReferencedByPlayingEvent(engine, handle, &isReferenced));
-    return isReferenced;
+    kwlSetError(engine, kwlEngine_getStreamingIOStats(engine, stats));
 }
 
-void kwlWaveBankUnload(kwlWaveBankHandle waveBankHandle)
+/** */
+void kwlGetStreamingIOStats(kwlStreamingIOStats* stats)
 {
-    if (engine == NULL)
-    {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
-        return;
-    }
-    kwlSetError(kwlEngine_requestUnloadWaveBank(engine, waveBankHandle, 0));
+    kwlInstanceGetStreamingIOStats(defaultEngine, stats);
 }
 
-void kwlWaveBankUnloadBlocking(kwlWaveBankHandle waveBankHandle)
+void kwlInstanceSetResidencyBudget(kwlEngineInstance* engine, int numBytes)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
-    kwlSetError(kwlEngine_requestUnloadWaveBank(engine, waveBankHandle, 1));
-}
-
-unsigned int kwlGetNumFramesMixed(void)
-{
-    if (engine == NULL)
+    if (numBytes < 0)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
-        return 0.0f;
+        kwlSetError(engine, KWL_INVALID_PARAMETER_VALUE);
+        return;
     }
     
-    unsigned int numFramesMixed = 0;
-    kwlSetError(kwlEngine_getNumFramesMixed(engine, &numFramesMixed));
-    return numFramesMixed;
+    kwlSetError(engine, kwlEngine_setResidencyBudget(engine, numBytes));
 }
 
-int kwlIsEngineInitialized(void)
+/** */
+void kwlSetResidencyBudget(int numBytes)
 {
-    return engine != NULL;
+    kwlInstanceSetResidencyBudget(defaultEngine, numBytes);
 }
 
-/** */
-void kwlInitialize(int sampleRate, int numOutputChannels, int numInputChannels, int bufferSize)
+void kwlInstanceSetResidencyMaxStartWaitTime(kwlEngineInstance* engine, float seconds)
 {
-    if (engine != 0)
+    if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_ALREADY_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
-    
-    if (numOutputChannels != 1 && numOutputChannels != 2)
+    if (seconds < 0.0f)
     {
-        kwlSetError(KWL_UNSUPPORTED_NUM_OUTPUT_CHANNELS);
+        kwlSetError(engine, KWL_INVALID_PARAMETER_VALUE);
         return;
     }
     
-    if (numInputChannels < 0 || numInputChannels > 2)
+    kwlSetError(engine, kwlEngine_setResidencyMaxStartWaitTime(engine, seconds));
+}
+
+/** */
+void kwlSetResidencyMaxStartWaitTime(float seconds)
+{
+    kwlInstanceSetResidencyMaxStartWaitTime(defaultEngine, seconds);
+}
+
+void kwlInstanceGetResidencyStats(kwlEngineInstance* engine, kwlResidencyStats* stats)
+{
+    if (engine == NULL)
     {
-        kwlSetError(KWL_UNSUPPORTED_NUM_INPUT_CHANNELS);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
-    
-    if (sampleRate <= 0 || bufferSize <= 0)
+    if (stats == NULL)
     {
-        kwlSetError(KWL_INVALID_PARAMETER_VALUE);
+        kwlSetError(engine, KWL_INVALID_PARAMETER_VALUE);
         return;
     }
-
-    /*create the sound engine instance*/
-    engine = (kwlEngine*)KWL_MALLOC((sizeof(kwlEngine)), "kwlInitialize");
-    kwlMemset(engine, 0, sizeof(kwlEngine));
-    kwlEngine_init(engine);
     
-    /*and initialise it*/
-    kwlSetError(kwlEngine_initialize(engine, sampleRate, numOutputChannels, numInputChannels, bufferSize));
+    kwlSetError(engine, kwlEngine_getResidencyStats(engine, stats));
 }
 
 /** */
-void kwlEngineDataLoad(const char* const dataPath)
+void kwlGetResidencyStats(kwlResidencyStats* stats)
 {
-    if (engine == NULL)
+    kwlInstanceGetResidencyStats(defaultEngine, stats);
+}
+
+void kwlGetMemoryStats(kwlMemoryCategory category, kwlMemoryStats* stats)
+{
+    if (stats == NULL || category < 0 || category >= KWL_NUM_MEMORY_CATEGORIES)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(defaultEngine, KWL_INVALID_PARAMETER_VALUE);
         return;
     }
     
-    kwlSetError(kwlEngine_engineDataLoad(engine, dataPath));
+    kwlMemory_getStats(category, stats);
+}
+
+kwlWaveBankHandle kwlInstanceWaveBankLoad(kwlEngineInstance* engine, const char* const path)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
+        return KWL_INVALID_HANDLE;
+    }
+    kwlWaveBankHandle handle = 0;
+    kwlSetError(engine, kwlEngine_loadWaveBank(engine, path, &handle, 0, 0));
+    return handle;
 }
 
 /** */
-void kwlEngineDataUnload()
+kwlWaveBankHandle kwlWaveBankLoad(const char* const path)
+{
+    return kwlInstanceWaveBankLoad(defaultEngine, path);
+}
+
+kwlWaveBankHandle kwlInstanceWaveBankLoadOnDemand(kwlEngineInstance* engine, const char* const path)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
-        return;
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
+        return KWL_INVALID_HANDLE;
     }
-    
-    kwlSetError(kwlEngine_unloadEngineDataBlocking(engine));
+    kwlWaveBankHandle handle = 0;
+    kwlSetError(engine, kwlEngine_loadWaveBank(engine, path, &handle, 0, 1));
+    return handle;
 }
 
 /** */
-int kwlEngineDataIsLoaded()
+kwlWaveBankHandle kwlWaveBankLoadOnDemand(const char* const path)
+{
+    return kwlInstanceWaveBankLoadOnDemand(defaultEngine, path);
+}
+
+int kwlInstanceWaveBankIsLoaded(kwlEngineInstance* engine, kwlWaveBankHandle handle)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return 0;
     }
     
-    int ret = 0;
-    kwlSetError(kwlEngine_isLoaded(engine, &ret));
-    return ret;
+    int isLoaded = 0;
+    kwlSetError(engine, kwlEngine_waveBankIsLoaded(engine, handle, &isLoaded));
+    return isLoaded;
 }
 
 /** */
-void kwlDeinitialize(void)
+int kwlWaveBankIsLoaded(kwlWaveBankHandle handle)
+{
+    return kwlInstanceWaveBankIsLoaded(defaultEngine, handle);
+}
+
+int kwlInstanceWaveBankIsReferencedByPlayingEvent(kwlEngineInstance* engine, kwlWaveBankHandle handle)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
-        return;
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
+        return 0;
     }
     
-    /*shut down the sound engine*/
-    kwlEngine_deinitialize(engine);
-    /*delete the sound engine instance*/
-    kwlEngine_free(engine);
-    engine = NULL;
+    int isReferenced = 0;
+    kwlSetError(engine, kwlEngine_waveBankIsReferencedByPlayingEvent(engine, handle, &isReferenced));
+    return isReferenced;
 }
 
 /** */
-void kwlDSPUnitAttachToEvent(kwlDSPUnit* dspUnit, kwlEventHandle eventHandle)
+int kwlWaveBankIsReferencedByPlayingEvent(kwlWaveBankHandle handle)
+{
+    return kwlInstanceWaveBankIsReferencedByPlayingEvent(defaultEngine, handle);
+}
+
+int kwlInstanceWaveBankGetPrefetchHeadMemory(kwlEngineInstance* engine, kwlWaveBankHandle handle)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
-        return;
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
+        return 0;
     }
     
-    kwlSetError(kwlEngine_attachDSPUnitToEvent(engine, eventHandle, dspUnit));
+    int numBytes = 0;
+    kwlSetError(engine, kwlEngine_waveBankGetPrefetchHeadMemory(engine, handle, &numBytes));
+    return numBytes;
 }
 
+/** */
+int kwlWaveBankGetPrefetchHeadMemory(kwlWaveBankHandle handle)
+{
+    return kwlInstanceWaveBankGetPrefetchHeadMemory(defaultEngine, handle);
+}
 
-void kwlDSPUnitAttachToMixBus(kwlDSPUnit* dspUnit, kwlMixBusHandle mixBusHandle)
+void kwlInstanceWaveBankUnload(kwlEngineInstance* engine, kwlWaveBankHandle waveBankHandle)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
-    
-    kwlSetError(kwlEngine_attachDSPUnitToMixBus(engine, mixBusHandle, dspUnit));
+    kwlSetError(engine, kwlEngine_requestUnloadWaveBank(engine, waveBankHandle, NULL, NULL));
 }
 
-void kwlDSPUnitAttachToInput(kwlDSPUnit* dspUnit)
+/** */
+void kwlWaveBankUnload(kwlWaveBankHandle waveBankHandle)
+{
+    kwlInstanceWaveBankUnload(defaultEngine, waveBankHandle);
+}
+
+void kwlInstanceWaveBankUnloadWithCallback(kwlEngineInstance* engine, kwlWaveBankHandle waveBankHandle, kwlUnloadCompletedCallback callback, void* userData)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
     
-    kwlSetError(kwlEngine_attachDSPUnitToInput(engine, dspUnit));
+    if (callback == NULL)
+    {
+        kwlSetError(engine, KWL_INVALID_PARAMETER_VALUE);
+        return;
+    }
+    kwlSetError(engine, kwlEngine_requestUnloadWaveBank(engine, waveBankHandle, callback, userData));
 }
 
-void kwlDSPUnitAttachToOutput(kwlDSPUnit* dspUnit)
+/** */
+void kwlWaveBankUnloadWithCallback(kwlWaveBankHandle waveBankHandle, kwlUnloadCompletedCallback callback, void* userData)
+{
+    kwlInstanceWaveBankUnloadWithCallback(defaultEngine, waveBankHandle, callback, userData);
+}
+
+void kwlInstanceWaveBankUnloadBlocking(kwlEngineInstance* engine, kwlWaveBankHandle waveBankHandle)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return;
     }
-    
-    kwlSetError(kwlEngine_attachDSPUnitToOutput(engine, dspUnit));
+    kwlSetError(engine, kwlEngine_unloadWaveBankBlocking(engine, waveBankHandle));
 }
 
-int kwlIsInputEnabled(void)
+/** */
+void kwlWaveBankUnloadBlocking(kwlWaveBankHandle waveBankHandle)
+{
+    kwlInstanceWaveBankUnloadBlocking(defaultEngine, waveBankHandle);
+}
+
+int kwlInstanceWaveBankIsUnloadPending(kwlEngineInstance* engine, kwlWaveBankHandle waveBankHandle)
 {
     if (engine == NULL)
     {
-        kwlSetError(KWL_ENGINE_IS_NOT_INITIALIZED);
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
         return 0;
     }
     
-    return engine->isInputEnabled;
+    int isPending = 0;
+    kwlSetError(engine, kwlEngine_waveBankIsUnloadPending(engine, waveBankHandle, &isPending));
+    return isPending;
 }
 
-kwlDSPUnitHandle kwlDSPUnitCreateCustom(void* userdata, 
-                                        kwlDSPCallback process, 
-                                        kwlDSPUpdateCallback updateEngine, 
-                                        kwlDSPUpdateCallback updateMixer, 
-                                        kwlDSPCleanupCallback cleanup)
+/** */
+int kwlWaveBankIsUnloadPending(kwlWaveBankHandle waveBankHandle)
 {
-    if (process == NULL)
+    return kwlInstanceWaveBankIsUnloadPending(defaultEngine, waveBankHandle);
+}
+
+unsigned int kwlInstanceGetNumFramesMixed(kwlEngineInstance* engine)
+{
+    if (engine == NULL)
     {
-        kwlSetError(KWL_INVALID_PARAMETER_VALUE);
-        return NULL;
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
+        return 0.0f;
     }
     
-    /*This method can be called regardless of the state of the engine */
-    kwlDSPUnit* newDSPUnit = (kwlDSPUnit*)KWL_MALLOC(sizeof(kwlDSPUnit), "custom DSP unit");
-    kwlMemset(newDSPUnit, 0, sizeof(kwlDSPUnit));
-    
-    newDSPUnit->type = KWL_CUSTOM_DSP_UNIT;
-    newDSPUnit->data = userdata;
-    newDSPUnit->dspCallback = process;
-    newDSPUnit->updateDSPEngineCallback = updateEngine;
-    newDSPUnit->updateDSPMixerCallback = updateMixer;
-    
-    return newDSPUnit;
+    unsigned int numFramesMixed = 0;
+    kwlSetError(engine, kwlEngine_getNumFramesMixed(engine, &numFramesMixed));
+    return numFramesMixed;
 }
 
-kwlError kwlPCMBufferLoad(const char* const path, kwlPCMBuffer* buffer)
+/** */
+unsigned int kwlGetNumFramesMixed(void)
 {
-    /** Reset input struct. */
-    buffer->numFrames = 0;
-    buffer->numChannels = 0;
-    buffer->pcmData = NULL;
-    
-    /** Load audio data into a kwlAudioData struct.*/
-    kwlAudioData audioData;
-    kwlError result = kwlLoadAudioFile(path, &audioData, 0);
-    
-    if (result != KWL_NO_ERROR)
+    return kwlInstanceGetNumFramesMixed(defaultEngine);
+}
+
+long long kwlInstanceGetTotalNumFramesMixed(kwlEngineInstance* engine)
+{
+    if (engine == NULL)
     {
-        kwlSetError(result);
-        return result;
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
+        return 0;
     }
     
-    /** Copy all non-internal fields to the target struct.*/
-    buffer->numFrames = audioData.numFrames;
-    buffer->numChannels = audioData.numChannels;
-    buffer->pcmData = (short*)audioData.bytes;
-    
-    return KWL_NO_ERROR;
+    long long numFramesMixed = 0;
+    kwlSetError(engine, kwlEngine_getTotalNumFramesMixed(engine, &numFramesMixed));
+    return numFramesMixed;
+}
+
+/** */
+long long kwlGetTotalNumFramesMixed(void)
+{
+    return kwlInstanceGetTotalNumFramesMixed(defaultEngine);
+}
+
+int kwlIsEngineInitialized(void)
+{
+    return defaultEngine != NULL;
+}
+
+/** 
+ * Returns KWL_NO_ERROR if the given parameters describe an engine instance that can be created. 
+ */
+static kwlError kwlValidateEngineParameters(int sampleRate,
+                                            int numOutputChannels,
+                                            int numInputChannels,
+                                            int bufferSize,
+                                            const kwlFileSystem* fileSystem)
+{
+    if (numOutputChannels != 1 && numOutputChannels != 2)
+    {
+        return KWL_UNSUPPORTED_NUM_OUTPUT_CHANNELS;
+    }
+    
+    if (numInputChannels < 0 || numInputChannels > 2)
+    {
+        return KWL_UNSUPPORTED_NUM_INPUT_CHANNELS;
+    }
+    
+    if (sampleRate <= 0 || bufferSize <= 0)
+    {
+        return KWL_INVALID_PARAMETER_VALUE;
+    }
+    
+    if (fileSystem != NULL &&
+        (fileSystem->open == NULL || fileSystem->read == NULL ||
+         fileSystem->getSize == NULL || fileSystem->close == NULL))
+    {
+        return KWL_INVALID_PARAMETER_VALUE;
+    }
+    
+    return KWL_NO_ERROR;
+}
+
+/** 
+ * Copies a given config, or the default config if \c config is NULL, to \c resolvedConfig
+ * and checks that it is in range.
+ */
+static kwlError kwlResolveEngineConfig(const kwlEngineConfig* config, kwlEngineConfig* resolvedConfig)
+{
+    if (config == NULL)
+    {
+        kwlEngine_getDefaultConfig(resolvedConfig);
+        return KWL_NO_ERROR;
+    }
+    
+    *resolvedConfig = *config;
+    return kwlEngine_validateConfig(resolvedConfig);
+}
+
+/** 
+ * Allocates and initializes an engine instance from validated parameters. 
+ * Returns NULL and sets the global error if the instance could not be initialized.
+ */
+static kwlEngine* kwlCreateEngine(int sampleRate,
+                                  int numOutputChannels,
+                                  int numInputChannels,
+                                  int bufferSize,
+                                  const kwlFileSystem* fileSystem,
+                                  kwlEngine* audioDataSource,
+                                  int isOffline,
+                                  const kwlEngineConfig* config)
+{
+#ifdef KWL_DEBUG_MEMORY
+    kwlDebugSetMinAllocationTableSize(config->debugAllocationTableSize);
+#endif /*KWL_DEBUG_MEMORY*/
+    
+    /*create the sound engine instance*/
+    kwlEngine* engine = (kwlEngine*)KWL_MALLOC((sizeof(kwlEngine)), KWL_MEMORY_CATEGORY_GENERAL, "kwlEngineCreate");
+    kwlMemset(engine, 0, sizeof(kwlEngine));
+    engine->fileSystem = fileSystem != NULL ? *fileSystem : *kwlFileSystem_getDefault();
+    engine->config = *config;
+    engine->isOffline = isOffline;
+    /*share the loaded audio data of the source instance, if any*/
+    engine->audioDataCache = audioDataSource != NULL ? audioDataSource->audioDataCache : NULL;
+    kwlEngine_init(engine);
+    
+    /*and initialise it*/
+    kwlError result = kwlEngine_initialize(engine, sampleRate, numOutputChannels, numInputChannels, bufferSize);
+    if (result != KWL_NO_ERROR)
+    {
+        kwlSetError(NULL, result);
+        kwlEngine_free(engine);
+        KWL_FREE(engine);
+        return NULL;
+    }
+    
+    return engine;
+}
+
+/** */
+kwlEngineInstance* kwlEngineCreate(int sampleRate,
+                                   int numOutputChannels,
+                                   int numInputChannels,
+                                   int bufferSize,
+                                   const kwlFileSystem* fileSystem,
+                                   kwlEngineInstance* audioDataSource)
+{
+    return kwlEngineCreateWithConfig(sampleRate, numOutputChannels, numInputChannels, bufferSize, fileSystem, audioDataSource, NULL);
+}
+
+/** */
+kwlEngineInstance* kwlEngineCreateOffline(int sampleRate,
+                                          int numOutputChannels,
+                                          const kwlFileSystem* fileSystem,
+                                          kwlEngineInstance* audioDataSource)
+{
+    kwlEngineConfig config;
+    kwlEngine_getDefaultConfig(&config);
+    
+    kwlError result = kwlValidateEngineParameters(sampleRate, numOutputChannels, 0, config.mixBufferSizeInFrames, fileSystem);
+    if (result != KWL_NO_ERROR)
+    {
+        kwlSetError(NULL, result);
+        return NULL;
+    }
+    
+    return kwlCreateEngine(sampleRate, numOutputChannels, 0, config.mixBufferSizeInFrames, fileSystem, audioDataSource, 1, &config);
+}
+
+/** */
+kwlEngineInstance* kwlEngineCreateWithConfig(int sampleRate,
+                                             int numOutputChannels,
+                                             int numInputChannels,
+                                             int bufferSize,
+                                             const kwlFileSystem* fileSystem,
+                                             kwlEngineInstance* audioDataSource,
+                                             const kwlEngineConfig* config)
+{
+    kwlError result = kwlValidateEngineParameters(sampleRate, numOutputChannels, numInputChannels, bufferSize, fileSystem);
+    if (result != KWL_NO_ERROR)
+    {
+        kwlSetError(NULL, result);
+        return NULL;
+    }
+    
+    kwlEngineConfig resolvedConfig;
+    result = kwlResolveEngineConfig(config, &resolvedConfig);
+    if (result != KWL_NO_ERROR)
+    {
+        kwlSetError(NULL, result);
+        return NULL;
+    }
+    
+    return kwlCreateEngine(sampleRate, numOutputChannels, numInputChannels, bufferSize, fileSystem, audioDataSource, 0, &resolvedConfig);
+}
+
+/** */
+void kwlEngineDestroy(kwlEngineInstance* engine)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(NULL, KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    
+    if (engine == defaultEngine)
+    {
+        defaultEngine = NULL;
+    }
+    
+    /*shut down the sound engine*/
+    kwlEngine_deinitialize(engine);
+    /*delete the sound engine instance*/
+    kwlEngine_free(engine);
+    KWL_FREE(engine);
+}
+
+/** */
+kwlEngineInstance* kwlEngineGetDefault(void)
+{
+    return defaultEngine;
+}
+
+/** */
+void kwlInstanceRender(kwlEngineInstance* engine, float* outBuffer, int numFrames)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    
+    kwlSetError(engine, kwlEngine_render(engine, outBuffer, numFrames));
+}
+
+/** */
+void kwlInitialize(int sampleRate, int numOutputChannels, int numInputChannels, int bufferSize)
+{
+    kwlInitializeWithFileSystem(sampleRate, numOutputChannels, numInputChannels, bufferSize, NULL);
+}
+
+/** */
+void kwlInitializeWithFileSystem(int sampleRate,
+                                 int numOutputChannels,
+                                 int numInputChannels,
+                                 int bufferSize,
+                                 const kwlFileSystem* fileSystem)
+{
+    kwlInitializeWithAllocator(sampleRate, numOutputChannels, numInputChannels, bufferSize, fileSystem, NULL);
+}
+
+/** */
+void kwlInitializeWithAllocator(int sampleRate,
+                                int numOutputChannels,
+                                int numInputChannels,
+                                int bufferSize,
+                                const kwlFileSystem* fileSystem,
+                                const kwlAllocator* allocator)
+{
+    kwlInitializeWithConfig(sampleRate, numOutputChannels, numInputChannels, bufferSize, fileSystem, allocator, NULL);
+}
+
+/** */
+void kwlInitializeWithConfig(int sampleRate,
+                             int numOutputChannels,
+                             int numInputChannels,
+                             int bufferSize,
+                             const kwlFileSystem* fileSystem,
+                             const kwlAllocator* allocator,
+                             const kwlEngineConfig* config)
+{
+    if (defaultEngine != NULL)
+    {
+        kwlSetError(defaultEngine, KWL_ENGINE_ALREADY_INITIALIZED);
+        return;
+    }
+    
+    kwlError result = kwlValidateEngineParameters(sampleRate, numOutputChannels, numInputChannels, bufferSize, fileSystem);
+    if (result != KWL_NO_ERROR)
+    {
+        kwlSetError(NULL, result);
+        return;
+    }
+    
+    kwlEngineConfig resolvedConfig;
+    result = kwlResolveEngineConfig(config, &resolvedConfig);
+    if (result != KWL_NO_ERROR)
+    {
+        kwlSetError(NULL, result);
+        return;
+    }
+    
+    /*install the allocator before the first engine allocation*/
+    kwlError allocatorResult = kwlMemory_setAllocator(allocator);
+    if (allocatorResult != KWL_NO_ERROR)
+    {
+        kwlSetError(NULL, allocatorResult);
+        return;
+    }
+
+    defaultEngine = kwlCreateEngine(sampleRate, numOutputChannels, numInputChannels, bufferSize, fileSystem, NULL, 0, &resolvedConfig);
+}
+
+/** */
+void kwlGetDefaultEngineConfig(kwlEngineConfig* config)
+{
+    if (config == NULL)
+    {
+        kwlSetError(NULL, KWL_INVALID_PARAMETER_VALUE);
+        return;
+    }
+    
+    kwlEngine_getDefaultConfig(config);
+}
+
+/** */
+void kwlInstanceGetEngineConfig(kwlEngineInstance* engine, kwlEngineConfig* config)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    if (config == NULL)
+    {
+        kwlSetError(engine, KWL_INVALID_PARAMETER_VALUE);
+        return;
+    }
+    
+    *config = engine->config;
+}
+
+/** */
+void kwlGetEngineConfig(kwlEngineConfig* config)
+{
+    kwlInstanceGetEngineConfig(defaultEngine, config);
+}
+
+/** */
+void kwlInstanceEngineDataLoad(kwlEngineInstance* engine, const char* const dataPath)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    
+    kwlSetError(engine, kwlEngine_engineDataLoad(engine, dataPath));
+}
+
+/** */
+void kwlEngineDataLoad(const char* const dataPath)
+{
+    kwlInstanceEngineDataLoad(defaultEngine, dataPath);
+}
+
+/** */
+void kwlInstanceEngineDataUnload(kwlEngineInstance* engine)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    
+    kwlSetError(engine, kwlEngine_unloadEngineDataBlocking(engine));
+}
+
+/** */
+void kwlEngineDataUnload()
+{
+    kwlInstanceEngineDataUnload(defaultEngine);
+}
+
+/** */
+void kwlInstanceEngineDataUnloadAsync(kwlEngineInstance* engine, kwlUnloadCompletedCallback callback, void* userData)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    
+    kwlSetError(engine, kwlEngine_requestUnloadEngineData(engine, callback, userData));
+}
+
+/** */
+void kwlEngineDataUnloadAsync(kwlUnloadCompletedCallback callback, void* userData)
+{
+    kwlInstanceEngineDataUnloadAsync(defaultEngine, callback, userData);
+}
+
+/** */
+int kwlInstanceEngineDataIsUnloadPending(kwlEngineInstance* engine)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
+        return 0;
+    }
+    
+    int ret = 0;
+    kwlSetError(engine, kwlEngine_engineDataIsUnloadPending(engine, &ret));
+    return ret;
+}
+
+/** */
+int kwlEngineDataIsUnloadPending()
+{
+    return kwlInstanceEngineDataIsUnloadPending(defaultEngine);
+}
+
+/** */
+void kwlInstanceEngineDataReload(kwlEngineInstance* engine, const char* const path, kwlEngineDataReloadedCallback callback, void* userData)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    
+    kwlSetError(engine, kwlEngine_requestEngineDataReload(engine, path, callback, userData));
+}
+
+/** */
+void kwlEngineDataReload(const char* const path, kwlEngineDataReloadedCallback callback, void* userData)
+{
+    kwlInstanceEngineDataReload(defaultEngine, path, callback, userData);
+}
+
+/** */
+int kwlInstanceEngineDataIsReloadPending(kwlEngineInstance* engine)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
+        return 0;
+    }
+    
+    int ret = 0;
+    kwlSetError(engine, kwlEngine_engineDataIsReloadPending(engine, &ret));
+    return ret;
+}
+
+/** */
+int kwlEngineDataIsReloadPending()
+{
+    return kwlInstanceEngineDataIsReloadPending(defaultEngine);
+}
+
+/** */
+int kwlInstanceEngineDataIsLoaded(kwlEngineInstance* engine)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
+        return 0;
+    }
+    
+    int ret = 0;
+    kwlSetError(engine, kwlEngine_isLoaded(engine, &ret));
+    return ret;
+}
+
+/** */
+int kwlEngineDataIsLoaded()
+{
+    return kwlInstanceEngineDataIsLoaded(defaultEngine);
+}
+
+/** */
+void kwlDeinitialize(void)
+{
+    kwlEngineDestroy(defaultEngine);
+}
+
+/** */
+void kwlInstanceDSPUnitAttachToEvent(kwlEngineInstance* engine, kwlDSPUnit* dspUnit, kwlEventHandle eventHandle)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    
+    kwlSetError(engine, kwlEngine_attachDSPUnitToEvent(engine, eventHandle, dspUnit));
+}
+
+/** */
+void kwlDSPUnitAttachToEvent(kwlDSPUnit* dspUnit, kwlEventHandle eventHandle)
+{
+    kwlInstanceDSPUnitAttachToEvent(defaultEngine, dspUnit, eventHandle);
+}
+
+
+void kwlInstanceDSPUnitAttachToMixBus(kwlEngineInstance* engine, kwlDSPUnit* dspUnit, kwlMixBusHandle mixBusHandle)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    
+    kwlSetError(engine, kwlEngine_attachDSPUnitToMixBus(engine, mixBusHandle, dspUnit));
+}
+
+/** */
+void kwlDSPUnitAttachToMixBus(kwlDSPUnit* dspUnit, kwlMixBusHandle mixBusHandle)
+{
+    kwlInstanceDSPUnitAttachToMixBus(defaultEngine, dspUnit, mixBusHandle);
+}
+
+void kwlInstanceDSPUnitAttachToInput(kwlEngineInstance* engine, kwlDSPUnit* dspUnit)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    
+    kwlSetError(engine, kwlEngine_attachDSPUnitToInput(engine, dspUnit));
+}
+
+/** */
+void kwlDSPUnitAttachToInput(kwlDSPUnit* dspUnit)
+{
+    kwlInstanceDSPUnitAttachToInput(defaultEngine, dspUnit);
+}
+
+void kwlInstanceDSPUnitAttachToOutput(kwlEngineInstance* engine, kwlDSPUnit* dspUnit)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
+        return;
+    }
+    
+    kwlSetError(engine, kwlEngine_attachDSPUnitToOutput(engine, dspUnit));
+}
+
+/** */
+void kwlDSPUnitAttachToOutput(kwlDSPUnit* dspUnit)
+{
+    kwlInstanceDSPUnitAttachToOutput(defaultEngine, dspUnit);
+}
+
+int kwlInstanceIsInputEnabled(kwlEngineInstance* engine)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
+        return 0;
+    }
+    
+    return engine->isInputEnabled;
+}
+
+/** */
+int kwlIsInputEnabled(void)
+{
+    return kwlInstanceIsInputEnabled(defaultEngine);
+}
+
+kwlDSPUnitHandle kwlDSPUnitCreateCustom(void* userdata, 
+                                        kwlDSPCallback process, 
+                                        kwlDSPUpdateCallback updateEngine, 
+                                        kwlDSPUpdateCallback updateMixer, 
+                                        kwlDSPCleanupCallback cleanup)
+{
+    if (process == NULL)
+    {
+        kwlSetError(defaultEngine, KWL_INVALID_PARAMETER_VALUE);
+        return NULL;
+    }
+    
+    /*This method can be called regardless of the state of the engine */
+    kwlDSPUnit* newDSPUnit = (kwlDSPUnit*)KWL_MALLOC(sizeof(kwlDSPUnit), KWL_MEMORY_CATEGORY_MIXER, "custom DSP unit");
+    kwlMemset(newDSPUnit, 0, sizeof(kwlDSPUnit));
+    
+    newDSPUnit->type = KWL_CUSTOM_DSP_UNIT;
+    newDSPUnit->data = userdata;
+    newDSPUnit->dspCallback = process;
+    newDSPUnit->updateDSPEngineCallback = updateEngine;
+    newDSPUnit->updateDSPMixerCallback = updateMixer;
+    
+    return newDSPUnit;
+}
+
+kwlError kwlInstancePCMBufferLoad(kwlEngineInstance* engine, const char* const path, kwlPCMBuffer* buffer)
+{
+    /** Reset input struct. */
+    buffer->numFrames = 0;
+    buffer->numChannels = 0;
+    buffer->pcmData = NULL;
+    
+    /** Load audio data into a kwlAudioData struct.*/
+    kwlAudioData audioData;
+    kwlError result = kwlLoadAudioFile(path, engine != NULL ? &engine->fileSystem : NULL, &audioData, 0);
+    
+    if (result != KWL_NO_ERROR)
+    {
+        kwlSetError(engine, result);
+        return result;
+    }
+    
+    /** Copy all non-internal fields to the target struct.*/
+    buffer->numFrames = audioData.numFrames;
+    buffer->numChannels = audioData.numChannels;
+    buffer->pcmData = (short*)audioData.bytes;
+    
+    return KWL_NO_ERROR;
+}
+
+/** */
+kwlError kwlPCMBufferLoad(const char* const path, kwlPCMBuffer* buffer)
+{
+    return kwlInstancePCMBufferLoad(defaultEngine, path, buffer);
 }
 
 void kwlPCMBufferFree(kwlPCMBuffer* buffer)
@@ -885,3 +1879,304 @@ void kwlPCMBufferFree(kwlPCMBuffer* buffer)
     buffer->pcmData = NULL;
 }
 
+/** */
+kwlCommandBufferHandle kwlInstanceCommandBufferCreate(kwlEngineInstance* engine, int capacity)
+{
+    if (engine == NULL)
+    {
+        kwlSetError(engine, KWL_ENGINE_IS_NOT_INITIALIZED);
+        return NULL;
+    }
+    
+    kwlCommandBuffer* buffer = NULL;
+    kwlSetError(engine, kwlEngine_createCommandBuffer(engine, capacity, &buffer));
+    return buffer;
+}
+
+/** */
+kwlCommandBufferHandle kwlCommandBufferCreate(int capacity)
+{
+    return kwlInstanceCommandBufferCreate(defaultEngine, capacity);
+}
+
+/** */
+void kwlCommandBufferDestroy(kwlCommandBufferHandle buffer)
+{
+    if (buffer == NULL)
+    {
+        kwlSetError(defaultEngine, KWL_INVALID_PARAMETER_VALUE);
+        return;
+    }
+    
+    kwlEngine* engine = buffer->engine;
+    kwlSetError(engine, kwlEngine_destroyCommandBuffer(engine, buffer));
+}
+
+/** */
+void kwlCommandBufferSubmit(kwlCommandBufferHandle buffer)
+{
+    KWL_ASSERT(buffer != NULL);
+    kwlCommandBuffer_submit(buffer);
+}
+
+/** */
+kwlError kwlCommandBufferGetError(kwlCommandBufferHandle buffer)
+{
+    KWL_ASSERT(buffer != NULL);
+    return kwlCommandBuffer_getError(buffer);
+}
+
+/** */
+void kwlCommandEventStart(kwlCommandBufferHandle buffer, kwlEventHandle handle)
+{
+    kwlCommand* command = kwlCommandBuffer_addCommand(buffer, KWL_COMMAND_EVENT_START, handle);
+    if (command != NULL)
+    {
+        command->params[0] = 0.0f;
+    }
+}
+
+/** */
+void kwlCommandEventStartFade(kwlCommandBufferHandle buffer, kwlEventHandle handle, float fadeTime)
+{
+    kwlCommand* command = kwlCommandBuffer_addCommand(buffer, KWL_COMMAND_EVENT_START, handle);
+    if (command != NULL)
+    {
+        command->params[0] = fadeTime;
+    }
+}
+
+/** */
+void kwlCommandEventStop(kwlCommandBufferHandle buffer, kwlEventHandle handle)
+{
+    kwlCommand* command = kwlCommandBuffer_addCommand(buffer, KWL_COMMAND_EVENT_STOP, handle);
+    if (command != NULL)
+    {
+        command->params[0] = 0.0f;
+    }
+}
+
+/** */
+void kwlCommandEventStopFade(kwlCommandBufferHandle buffer, kwlEventHandle handle, float fadeTime)
+{
+    kwlCommand* command = kwlCommandBuffer_addCommand(buffer, KWL_COMMAND_EVENT_STOP, handle);
+    if (command != NULL)
+    {
+        command->params[0] = fadeTime;
+    }
+}
+
+/** */
+void kwlCommandEventPause(kwlCommandBufferHandle buffer, kwlEventHandle handle)
+{
+    kwlCommandBuffer_addCommand(buffer, KWL_COMMAND_EVENT_PAUSE, handle);
+}
+
+/** */
+void kwlCommandEventResume(kwlCommandBufferHandle buffer, kwlEventHandle handle)
+{
+    kwlCommandBuffer_addCommand(buffer, KWL_COMMAND_EVENT_RESUME, handle);
+}
+
+/** */
+void kwlCommandEventRelease(kwlCommandBufferHandle buffer, kwlEventHandle handle)
+{
+    kwlCommandBuffer_addCommand(buffer, KWL_COMMAND_EVENT_RELEASE, handle);
+}
+
+/** */
+void kwlCommandEventStartOneShot(kwlCommandBufferHandle buffer, kwlEventDefinitionHandle handle)
+{
+    kwlCommandBuffer_addCommand(buffer, KWL_COMMAND_EVENT_START_ONE_SHOT, handle);
+}
+
+/** */
+void kwlCommandEventStartOneShotAt(kwlCommandBufferHandle buffer,
+                                   kwlEventDefinitionHandle handle,
+                                   float x,
+                                   float y,
+                                   float z)
+{
+    kwlCommand* command = kwlCommandBuffer_addCommand(buffer, KWL_COMMAND_EVENT_START_ONE_SHOT_AT, handle);
+    if (command != NULL)
+    {
+        command->params[0] = x;
+        command->params[1] = y;
+        command->params[2] = z;
+    }
+}
+
+/** */
+void kwlCommandEventSetGain(kwlCommandBufferHandle buffer, kwlEventHandle handle, float gain)
+{
+    kwlCommand* command = kwlCommandBuffer_addCommand(buffer, KWL_COMMAND_EVENT_SET_GAIN, handle);
+    if (command != NULL)
+    {
+        command->params[0] = gain;
+    }
+}
+
+/** */
+void kwlCommandEventSetLinearGain(kwlCommandBufferHandle buffer, kwlEventHandle handle, float gain)
+{
+    kwlCommand* command = kwlCommandBuffer_addCommand(buffer, KWL_COMMAND_EVENT_SET_LINEAR_GAIN, handle);
+    if (command != NULL)
+    {
+        command->params[0] = gain;
+    }
+}
+
+/** */
+void kwlCommandEventSetPitch(kwlCommandBufferHandle buffer, kwlEventHandle handle, float pitch)
+{
+    kwlCommand* command = kwlCommandBuffer_addCommand(buffer, KWL_COMMAND_EVENT_SET_PITCH, handle);
+    if (command != NULL)
+    {
+        command->params[0] = pitch;
+    }
+}
+
+/** */
+void kwlCommandEventSetBalance(kwlCommandBufferHandle buffer, kwlEventHandle handle, float balance)
+{
+    kwlCommand* command = kwlCommandBuffer_addCommand(buffer, KWL_COMMAND_EVENT_SET_BALANCE, handle);
+    if (command != NULL)
+    {
+        command->params[0] = balance;
+    }
+}
+
+/** */
+void kwlCommandEventSetPosition(kwlCommandBufferHandle buffer,
+                                kwlEventHandle handle,
+                                float posX,
+                                float posY,
+                                float posZ)
+{
+    kwlCommand* command = kwlCommandBuffer_addCommand(buffer, KWL_COMMAND_EVENT_SET_POSITION, handle);
+    if (command != NULL)
+    {
+        command->params[0] = posX;
+        command->params[1] = posY;
+        command->params[2] = posZ;
+    }
+}
+
+/** */
+void kwlCommandEventSetVelocity(kwlCommandBufferHandle buffer,
+                                kwlEventHandle handle,
+                                float velX,
+                                float velY,
+                                float velZ)
+{
+    kwlCommand* command = kwlCommandBuffer_addCommand(buffer, KWL_COMMAND_EVENT_SET_VELOCITY, handle);
+    if (command != NULL)
+    {
+        command->params[0] = velX;
+        command->params[1] = velY;
+        command->params[2] = velZ;
+    }
+}
+
+/** */
+void kwlCommandEventSetOrientation(kwlCommandBufferHandle buffer,
+                                   kwlEventHandle handle,
+                                   float directionX,
+                                   float directionY,
+                                   float directionZ)
+{
+    kwlCommand* command = kwlCommandBuffer_addCommand(buffer, KWL_COMMAND_EVENT_SET_ORIENTATION, handle);
+    if (command != NULL)
+    {
+        command->params[0] = directionX;
+        command->params[1] = directionY;
+        command->params[2] = directionZ;
+    }
+}
+
+/** */
+void kwlCommandListenerSetPosition(kwlCommandBufferHandle buffer, float posX, float posY, float posZ)
+{
+    kwlCommand* command = kwlCommandBuffer_addCommand(buffer, KWL_COMMAND_LISTENER_SET_POSITION, KWL_INVALID_HANDLE);
+    if (command != NULL)
+    {
+        command->params[0] = posX;
+        command->params[1] = posY;
+        command->params[2] = posZ;
+    }
+}
+
+/** */
+void kwlCommandListenerSetVelocity(kwlCommandBufferHandle buffer, float velX, float velY, float velZ)
+{
+    kwlCommand* command = kwlCommandBuffer_addCommand(buffer, KWL_COMMAND_LISTENER_SET_VELOCITY, KWL_INVALID_HANDLE);
+    if (command != NULL)
+    {
+        command->params[0] = velX;
+        command->params[1] = velY;
+        command->params[2] = velZ;
+    }
+}
+
+/** */
+void kwlCommandListenerSetOrientation(kwlCommandBufferHandle buffer,
+                                      float directionX,
+                                      float directionY,
+                                      float directionZ,
+                                      float upX,
+                                      float upY,
+                                      float upZ)
+{
+    kwlCommand* command = kwlCommandBuffer_addCommand(buffer, KWL_COMMAND_LISTENER_SET_ORIENTATION, KWL_INVALID_HANDLE);
+    if (command != NULL)
+    {
+        command->params[0] = directionX;
+        command->params[1] = directionY;
+        command->params[2] = directionZ;
+        command->params[3] = upX;
+        command->params[4] = upY;
+        command->params[5] = upZ;
+    }
+}
+
+/** */
+void kwlCommandMixBusSetGain(kwlCommandBufferHandle buffer, kwlMixBusHandle handle, float gain)
+{
+    kwlCommand* command = kwlCommandBuffer_addCommand(buffer, KWL_COMMAND_MIX_BUS_SET_GAIN, handle);
+    if (command != NULL)
+    {
+        command->params[0] = gain;
+    }
+}
+
+/** */
+void kwlCommandMixBusSetLinearGain(kwlCommandBufferHandle buffer, kwlMixBusHandle handle, float gain)
+{
+    kwlCommand* command = kwlCommandBuffer_addCommand(buffer, KWL_COMMAND_MIX_BUS_SET_LINEAR_GAIN, handle);
+    if (command != NULL)
+    {
+        command->params[0] = gain;
+    }
+}
+
+/** */
+void kwlCommandMixBusSetPitch(kwlCommandBufferHandle buffer, kwlMixBusHandle handle, float pitch)
+{
+    kwlCommand* command = kwlCommandBuffer_addCommand(buffer, KWL_COMMAND_MIX_BUS_SET_PITCH, handle);
+    if (command != NULL)
+    {
+        command->params[0] = pitch;
+    }
+}
+
+/** */
+void kwlCommandMixPresetSet(kwlCommandBufferHandle buffer, kwlMixPresetHandle presetHandle)
+{
+    kwlCommandBuffer_addCommand(buffer, KWL_COMMAND_MIX_PRESET_SET, presetHandle);
+}
+
+/** */
+void kwlCommandMixPresetFadeTo(kwlCommandBufferHandle buffer, kwlMixPresetHandle presetHandle)
+{
+    kwlCommandBuffer_addCommand(buffer, KWL_COMMAND_MIX_PRESET_FADE_TO, presetHandle);
+}
@@ -30,6 +30,8 @@
  See kowalski_ext.h for the DSP unit API.
  */
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -46,12 +48,24 @@ extern "C"
     typedef int kwlMixPresetHandle;
     /** A handle to a mix bus. */
     typedef int kwlMixBusHandle;
-    /** A handle to a specific event instance. */
+    /** 
+     * A handle to a specific event instance. Event handles are 32 bit unless the engine
+     * and the host are built with \c KWL_64_BIT_EVENT_HANDLES defined, which is needed for
+     * projects with more than about a million event instances or freeform events.
+     */
+#ifdef KWL_64_BIT_EVENT_HANDLES
+    typedef long long kwlEventHandle;
+#else
     typedef int kwlEventHandle;
+#endif /* KWL_64_BIT_EVENT_HANDLES */
     /** A handle to an event definition. */
     typedef int kwlEventDefinitionHandle;
     /** A handle to a wave bank.*/
     typedef int kwlWaveBankHandle;
+    /** An engine instance. @see kwlEngineCreate */
+    typedef struct kwlEngine kwlEngineInstance;
+    /** A buffer of commands recorded on an application thread. @see kwlCommandBufferCreate */
+    typedef struct kwlCommandBuffer* kwlCommandBufferHandle;
     
     /** @} */
     
@@ -127,6 +141,15 @@ extern "C"
         KWL_EVENT_IS_NOT_NONPOSITIONAL,
         /** The positional freeform event cannot be created from a stereo file.*/
         KWL_POSITIONAL_EVENT_MUST_BE_MONO,
+        /** 
+         * The engine data has more event instances than event handles can address. 
+         * Build with \c KWL_64_BIT_EVENT_HANDLES defined to load it.
+         */
+        KWL_TOO_MANY_EVENT_INSTANCES,
+        /** An engine data reload was requested while another one is in progress.*/
+        KWL_ENGINE_DATA_RELOAD_PENDING,
+        /** A command could not be recorded because the command buffer was full.*/
+        KWL_COMMAND_BUFFER_FULL,
     } kwlError;
     /** @} */
     
@@ -149,7 +172,233 @@ extern "C"
         /** The event is not positional.*/
         KWL_NONPOSITIONAL
     } kwlEventType;
+
+    /** Statistics of the disk reads performed on behalf of streaming events.*/
+    typedef struct kwlStreamingIOStats
+    {
+        /** The number of streams the statistics were gathered from.*/
+        int numStreams;
+        /** The number of file reads issued.*/
+        int numReads;
+        /** The total number of bytes read from disk.*/
+        long long numBytesRead;
+        /** The average duration of a file read in seconds.*/
+        float averageReadLatency;
+        /** The duration of the slowest file read in seconds.*/
+        float maxReadLatency;
+        /** The number of bytes read per second spent reading.*/
+        float readThroughput;
+        /** The number of times a decoder had to wait for data to be read from disk.*/
+        int numStalls;
+        /** The total time in seconds decoders spent waiting for data to be read from disk.*/
+        float totalStallTime;
+    } kwlStreamingIOStats;
     
+    /** 
+     * Statistics of the audio data of wave banks loaded on demand.
+     * @see kwlWaveBankLoadOnDemand
+     */
+    typedef struct kwlResidencyStats
+    {
+        /** The number of times audio data was requested by a starting event and was already in memory.*/
+        int numHits;
+        /** The number of times audio data was requested by a starting event and had to be loaded.*/
+        int numMisses;
+        /** The number of times audio data was requested by a prefetch and had to be loaded.*/
+        int numPrefetches;
+        /** The number of events that started virtually, i.e waited for their audio data without playing.*/
+        int numVirtualStarts;
+        /** The number of audio data items evicted from memory to stay within the memory budget.*/
+        int numEvictions;
+        /** The number of audio data loads that failed.*/
+        int numFailedLoads;
+        /** The total number of bytes of audio data loaded on demand.*/
+        long long numBytesLoaded;
+        /** The number of audio data items currently in memory or being loaded.*/
+        int numResidentItems;
+        /** The number of bytes of audio data currently in memory or being loaded.*/
+        int numResidentBytes;
+    } kwlResidencyStats;
+
+    /**
+     * Opens a file for reading.
+     * @param userData The user data of the file system.
+     * @param path The path of the file to open.
+     * @return A handle to the opened file, or NULL if the file could not be opened.
+     */
+    typedef void* (*kwlFileOpenFunction)(void* userData, const char* path);
+
+    /**
+     * Reads bytes at a given position of a file. Called from the engine thread, the streaming
+     * I/O thread and decoder threads, possibly at the same time for the same file, so reads
+     * must not depend on a shared file position.
+     * @param userData The user data of the file system.
+     * @param file A file handle returned by the open function.
+     * @param position The byte position in the file to read from.
+     * @param data The buffer to put the read bytes in.
+     * @param length The number of bytes to read.
+     * @return The number of bytes read, which is less than \c length only at the end of the file or on error.
+     */
+    typedef int (*kwlFileReadFunction)(void* userData, void* file, int position, void* data, int length);
+
+    /**
+     * Returns the size in bytes of a file.
+     * @param userData The user data of the file system.
+     * @param file A file handle returned by the open function.
+     */
+    typedef int (*kwlFileSizeFunction)(void* userData, void* file);
+
+    /**
+     * Closes a file.
+     * @param userData The user data of the file system.
+     * @param file A file handle returned by the open function.
+     */
+    typedef void (*kwlFileCloseFunction)(void* userData, void* file);
+
+    /**
+     * Called exactly once when a read started by an asynchronous read function completes.
+     * May be called from any thread, including from within the asynchronous read function.
+     * @param completionData The completion data passed to the asynchronous read function.
+     * @param numBytesRead The number of bytes read.
+     */
+    typedef void (*kwlFileReadCompletedCallback)(void* completionData, int numBytesRead);
+
+    /**
+     * Starts reading bytes at a given position of a file without waiting for the read to complete.
+     * The arguments are the same as for \c kwlFileReadFunction, plus a callback to invoke with
+     * the given completion data when the read has completed.
+     * @return Non-zero if the read was started, zero to have the engine perform a blocking read instead.
+     */
+    typedef int (*kwlFileReadAsyncFunction)(void* userData,
+                                            void* file,
+                                            int position,
+                                            void* data,
+                                            int length,
+                                            kwlFileReadCompletedCallback callback,
+                                            void* completionData);
+
+    /**
+     * A set of callbacks through which the engine reads all files: engine data,
+     * wave banks, streamed audio data and audio files of freeform events.
+     * Lets content be served from packed archives or memory instead of loose files.
+     * @see kwlInitializeWithFileSystem
+     */
+    typedef struct kwlFileSystem
+    {
+        /** Opens a file for reading.*/
+        kwlFileOpenFunction open;
+        /** Reads bytes at a given position of an open file.*/
+        kwlFileReadFunction read;
+        /** Returns the size of an open file.*/
+        kwlFileSizeFunction getSize;
+        /** Closes an open file.*/
+        kwlFileCloseFunction close;
+        /**
+         * Optional. Starts a read without blocking, letting the streaming I/O thread
+         * keep several reads in flight. NULL if only blocking reads are supported.
+         */
+        kwlFileReadAsyncFunction readAsync;
+        /** User data passed to all callbacks.*/
+        void* userData;
+    } kwlFileSystem;
+
+    /** The categories engine allocations are grouped in, passed to the allocator callbacks. */
+    typedef enum
+    {
+        /** Allocations not belonging to any of the other categories.*/
+        KWL_MEMORY_CATEGORY_GENERAL = 0,
+        /** Loaded engine data, i.e event definitions, sounds, mix buses and mix presets.*/
+        KWL_MEMORY_CATEGORY_ENGINE_DATA,
+        /** Wave bank tables and paths.*/
+        KWL_MEMORY_CATEGORY_WAVE_BANK,
+        /** Audio samples and the structures sharing them.*/
+        KWL_MEMORY_CATEGORY_AUDIO_DATA,
+        /** Freeform events and per event instance data.*/
+        KWL_MEMORY_CATEGORY_EVENT,
+        /** Decoders, their buffers and codec library allocations.*/
+        KWL_MEMORY_CATEGORY_DECODER,
+        /** The mixer, mix buses, DSP units and message queues.*/
+        KWL_MEMORY_CATEGORY_MIXER,
+        /** Streaming I/O buffers and file read buffers.*/
+        KWL_MEMORY_CATEGORY_STREAMING,
+        /** The number of memory categories.*/
+        KWL_NUM_MEMORY_CATEGORIES
+    } kwlMemoryCategory;
+
+    /**
+     * Allocates a block of memory. Called from any engine thread, possibly at the same time.
+     * @param userData The user data of the allocator.
+     * @param size The number of bytes to allocate.
+     * @param category The category of the allocation.
+     * @return The allocated block, aligned at least like malloc, or NULL on failure.
+     */
+    typedef void* (*kwlAllocFunction)(void* userData, size_t size, kwlMemoryCategory category);
+
+    /**
+     * Resizes a block returned by the allocation or reallocation function, like realloc.
+     * @param userData The user data of the allocator.
+     * @param pointer The block to resize.
+     * @param size The new size in bytes.
+     * @param category The category of the allocation.
+     * @return The resized block, or NULL on failure.
+     */
+    typedef void* (*kwlReallocFunction)(void* userData, void* pointer, size_t size, kwlMemoryCategory category);
+
+    /**
+     * Allocates a block of memory aligned to a given power of two number of bytes.
+     * @param userData The user data of the allocator.
+     * @param size The number of bytes to allocate.
+     * @param alignment The required alignment in bytes.
+     * @param category The category of the allocation.
+     * @return The allocated block, or NULL on failure.
+     */
+    typedef void* (*kwlAlignedAllocFunction)(void* userData, size_t size, size_t alignment, kwlMemoryCategory category);
+
+    /**
+     * Frees a block returned by any of the other allocator functions.
+     * @param userData The user data of the allocator.
+     * @param pointer The block to free.
+     * @param category The category the block was allocated with.
+     */
+    typedef void (*kwlFreeFunction)(void* userData, void* pointer, kwlMemoryCategory category);
+
+    /**
+     * A set of callbacks through which the engine allocates all of its memory,
+     * including the memory of the Ogg Vorbis decoder.
+     * @see kwlInitializeWithAllocator
+     */
+    typedef struct kwlAllocator
+    {
+        /** Allocates a block.*/
+        kwlAllocFunction alloc;
+        /** Resizes a block.*/
+        kwlReallocFunction realloc;
+        /** 
+         * Optional. Allocates an aligned block. If NULL, aligned blocks are carved
+         * out of larger blocks returned by \c alloc.
+         */
+        kwlAlignedAllocFunction alignedAlloc;
+        /** Frees a block.*/
+        kwlFreeFunction free;
+        /** User data passed to all callbacks.*/
+        void* userData;
+    } kwlAllocator;
+
+    /** Allocation statistics of a memory category, gathered since the process started.*/
+    typedef struct kwlMemoryStats
+    {
+        /** The number of blocks currently allocated.*/
+        int numLiveAllocations;
+        /** The total number of allocations made.*/
+        int numAllocations;
+        /** The number of bytes currently allocated, not counting allocator overhead.*/
+        size_t numLiveBytes;
+        /** The highest number of bytes allocated at any one time.*/
+        size_t numPeakBytes;
+        /** The total number of bytes allocated.*/
+        size_t numTotalBytes;
+    } kwlMemoryStats;
+
     
     /** The value of invalid handles returned from the Kowalski engine.*/
     static const int KWL_INVALID_HANDLE = 0xffffffff;
@@ -455,6 +704,67 @@ extern "C"
      */
     void kwlEventSetBalance(kwlEventHandle handle, float balance);
     
+    /**
+     * Parameter arrays for ::kwlEventBatchSetParameters, laid out to match game side component
+     * arrays. Element \c i of an array is read \c i times its stride bytes past its first element,
+     * so an array can point into an array of structs as well as into a plain float array.
+     * A stride of 0 means the elements are tightly packed. Parameters whose array is NULL are left unchanged.
+     */
+    typedef struct kwlEventParameterBatch
+    {
+        /** Positions, each given as x, y and z. See ::kwlEventSetPosition.*/
+        const float* positions;
+        /** The number of bytes between consecutive positions.*/
+        int positionStride;
+        /** Velocities, each given as x, y and z. See ::kwlEventSetVelocity.*/
+        const float* velocities;
+        /** The number of bytes between consecutive velocities.*/
+        int velocityStride;
+        /** Orientations, each given as x, y and z of a non-zero direction. See ::kwlEventSetOrientation.*/
+        const float* orientations;
+        /** The number of bytes between consecutive orientations.*/
+        int orientationStride;
+        /** Gains. See ::kwlEventSetGain and ::kwlEventSetLinearGain.*/
+        const float* gains;
+        /** The number of bytes between consecutive gains.*/
+        int gainStride;
+        /** Non-zero if \c gains are linear amplitude scale factors.*/
+        int isLinearGain;
+        /** Pitches. See ::kwlEventSetPitch.*/
+        const float* pitches;
+        /** The number of bytes between consecutive pitches.*/
+        int pitchStride;
+    } kwlEventParameterBatch;
+    
+    /**
+     * <p>Sets the parameters of a number of event instances in a single pass. This has the same
+     * effect as calling the corresponding setter for each parameter of each event instance, but
+     * each handle is only looked up once and no per call overhead is paid.</p>
+     * <p>If a parameter of an event instance cannot be set, the error the corresponding setter
+     * would have reported is stored for that event instance in \c errors, if given, and the remaining
+     * parameters and event instances are still processed. The first such error is also reported
+     * by ::kwlGetError.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_INVALID_PARAMETER_VALUE if \c handles or \c parameters is NULL, \c numEvents is negative
+     * or a stride is negative.</li>
+     * <li>The first error of an event instance, as described above.</li>
+     * </ul>
+     * </p>
+     * @param handles An array of \c numEvents event handles.
+     * @param numEvents The number of event instances to set the parameters of.
+     * @param parameters The parameter arrays, each holding at least \c numEvents elements if not NULL.
+     * @param errors An optional array of \c numEvents error codes that receives the first error
+     * of each event instance, or \c KWL_NO_ERROR.
+     * @see kwlGetError
+     */
+    void kwlEventBatchSetParameters(const kwlEventHandle* handles, 
+                                    int numEvents, 
+                                    const kwlEventParameterBatch* parameters, 
+                                    kwlError* errors);
+    
     /**
      * <p>Starts playback of a given event instance. If the instance is already playing, the behaviour
      * is defined by the retrigger mode of its event definition.</p>
@@ -575,6 +885,55 @@ extern "C"
      */
     void kwlEventStopFade(kwlEventHandle handle, float fadeTime);
     
+    /**
+     * <p>Starts playback of a given event instance at a given frame on the mixer clock 
+     * returned by \c kwlGetTotalNumFramesMixed. The start is sample accurate, i.e the first
+     * frame of the event is mixed at exactly the requested frame. Since the engine 
+     * and the mixer communicate asynchronously, the start frame should be at least two buffers
+     * plus one \c kwlUpdate interval ahead of the current frame. Start frames that have already been 
+     * mixed start the event at the beginning of the next mixed buffer.
+     * If the instance is already playing, the behaviour is defined by the retrigger mode 
+     * of its event definition.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_INVALID_EVENT_INSTANCE_HANDLE if the provided handle does not correspond to an event instance.</li>
+     * <li>\c KWL_INVALID_PARAMETER_VALUE if \c frame is negative.</li>
+     * </ul>
+     * </p>
+     * @param handle An event handle corresponding to the event to start.
+     * @param frame The mixer frame at which to start the event.
+     * @see kwlEventStart
+     * @see kwlEventStopAtFrame
+     * @see kwlGetTotalNumFramesMixed
+     * @see kwlGetError
+     */
+    void kwlEventStartAtFrame(kwlEventHandle handle, long long frame);
+    
+    /**
+     * <p>Stops playback of a given event instance at a given frame on the mixer clock 
+     * returned by \c kwlGetTotalNumFramesMixed. The last frame of the event is mixed 
+     * at the frame before the requested one. Stop frames that have already been mixed 
+     * stop the event at the beginning of the next mixed buffer.
+     * If the instance is not playing, this method does nothing.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_INVALID_EVENT_INSTANCE_HANDLE if the provided handle does not correspond to an event instance.</li>
+     * <li>\c KWL_INVALID_PARAMETER_VALUE if \c frame is negative.</li>
+     * </ul>
+     * </p>
+     * @param handle An event handle corresponding to the event to stop.
+     * @param frame The mixer frame at which to stop the event.
+     * @see kwlEventStop
+     * @see kwlEventStartAtFrame
+     * @see kwlGetTotalNumFramesMixed
+     * @see kwlGetError
+     */
+    void kwlEventStopAtFrame(kwlEventHandle handle, long long frame);
+    
     /**
      * <p>Pauses an event instance, suspending playback but leaving it active in the mixer.
      * If the instance is currently paused or not playing,
@@ -708,6 +1067,42 @@ extern "C"
      */        
     void kwlEventStartOneShotWithCallbackAt(kwlEventDefinitionHandle eventDefinition, float x, float y, float z, kwlEventStoppedCallack callback, void* userData);
     
+    /**
+     * <p>Gets statistics of the disk reads performed for a given streaming event
+     * since it started playing. The statistics are all zero if the event is not playing
+     * or does not stream its audio data from disk.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_INVALID_EVENT_INSTANCE_HANDLE if the provided handle does not correspond to an event instance.</li>
+     * <li>\c KWL_INVALID_PARAMETER_VALUE if \c stats is \c NULL.</li>
+     * </ul>
+     * </p>
+     * @param handle An event handle corresponding to the event to get statistics for.
+     * @param stats Receives the statistics.
+     * @see kwlGetStreamingIOStats
+     * @see kwlGetError
+     */
+    void kwlEventGetStreamingIOStats(kwlEventHandle handle, kwlStreamingIOStats* stats);
+    
+    /**
+     * <p>Hints that a given event is about to be started, so that any of its audio data
+     * belonging to wave banks loaded on demand gets loaded in the background. Does nothing
+     * for audio data that is already in memory or streamed from disk.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_INVALID_EVENT_INSTANCE_HANDLE if the given handle does not correspond to an event.</li>
+     * </ul>
+     * </p>
+     * @param handle The event to prefetch the audio data of.
+     * @see kwlWaveBankLoadOnDemand
+     * @see kwlGetError
+     */
+    void kwlEventPrefetch(kwlEventHandle handle);
+    
     /** @} */
     
     /************************************************************************/
@@ -1026,6 +1421,24 @@ extern "C"
      */
     unsigned int kwlGetNumFramesMixed(void);
     
+    /**
+     * <p>Returns the total number of frames of audio mixed since the mixer started, as a 
+     * 64 bit value. This is the clock used for scheduling sample accurate event starts and stops. 
+     * The returned value is updated by \c kwlUpdate and lags the actual mixer position by up 
+     * to one buffer.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * </ul>
+     * </p>
+     * @return The number of frames of audio mixed since the mixer started.
+     * @see kwlEventStartAtFrame
+     * @see kwlEventStopAtFrame
+     * @see kwlGetError()
+     */
+    long long kwlGetTotalNumFramesMixed(void);
+    
     /** @} */
     
     /************************************************************************/
@@ -1034,10 +1447,23 @@ extern "C"
      *  Wave bank related functions.
      */
     /** @{ */
+    
+    /**
+     * <p>Called when a requested wave bank or engine data unload has completed. The
+     * callback is invoked on the application thread from \c kwlUpdate, also if the
+     * unload could be completed right away.</p>
+     * @param userData Optional user data.
+     * @see kwlWaveBankUnloadWithCallback
+     * @see kwlEngineDataUnloadAsync
+     */
+    typedef void (*kwlUnloadCompletedCallback)(void* userData);
+    
     /**
      * <p>Loads the audio data contained in a given wave bank file. If the given wave
      * bank is already loaded, all this method does is return a handle to the
-     * wave bank without doing any actual loading.</p>
+     * wave bank without doing any actual loading. Entries with the same content as
+     * entries of another loaded wave bank share their audio data with those entries
+     * instead of being read again.</p>
      * <p>
      * <strong>Error codes:</strong>
      * <ul>
@@ -1050,7 +1476,9 @@ extern "C"
      * <li>\c KWL_WAVE_BANK_ENTRY_MISMATCH if there is not a one-to-one correspondence between the
      * audio data entryies in the wave bank file and the entries in the corresponding
      * wave bank structure in the engine.</li>
+     * <li>\c KWL_CORRUPT_BINARY_DATA if the wave bank file contains invalid entries.</li>
      * </ul>
+     * If an error occurs, no audio data is loaded.
      * </p>
      * @param fileName The path of the wave bank file to load.
      * @return A handle to the loaded wave bank or \c KWL_INVALID_HANDLE if an error occurred.
@@ -1061,12 +1489,40 @@ extern "C"
      */
     kwlWaveBankHandle kwlWaveBankLoad(const char* const fileName);
     
+    /**
+     * <p>Loads the table of contents of a given wave bank file, without loading any audio data.
+     * Audio data that is not streamed from disk is loaded the first time an event using it
+     * is started or prefetched, and is evicted, least recently used first, when the total 
+     * amount of audio data loaded on demand exceeds the budget set with \c kwlSetResidencyBudget.
+     * An event started before its audio data has been loaded waits for at most the time set with
+     * \c kwlSetResidencyMaxStartWaitTime, then starts virtually: it counts as playing but is
+     * not heard until its audio data is in memory, at which point it starts from the beginning.
+     * The wave bank file is kept open while the wave bank is loaded.
+     * If the given wave bank is already loaded, all this method does is return a handle
+     * to the wave bank.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>The same as for \c kwlWaveBankLoad.</li>
+     * </ul>
+     * </p>
+     * @param fileName The path of the wave bank file to load.
+     * @return A handle to the loaded wave bank or \c KWL_INVALID_HANDLE if an error occurred.
+     * @see kwlWaveBankLoad
+     * @see kwlEventPrefetch
+     * @see kwlGetResidencyStats
+     * @see kwlGetError
+     */
+    kwlWaveBankHandle kwlWaveBankLoadOnDemand(const char* const fileName);
+    
     /**
      * <p>Unloads the audio data of a given wave bank. If the wave bank is not
-     * loaded, this method does nothing. Any currently playing events
-     * using audio data from the wave bank will be stopped prior to unloading the
-     * wave bank, so it is safe to call this method at any point. This method
-     * may return before the actual unloading takes place.</p>
+     * loaded, this method does nothing. Any currently playing events using audio data
+     * from the wave bank are stopped prior to unloading the wave bank, so it is safe to 
+     * call this method at any point. If there are such events, this method returns before
+     * the actual unloading takes place. Audio data with the same content as audio data of 
+     * another loaded wave bank is only held in memory once, and stays in memory as long as 
+     * any wave bank or playing event uses it.</p>
      * <p>
      * <strong>Error codes:</strong>
      * <ul>
@@ -1079,15 +1535,40 @@ extern "C"
      * @see kwlWaveBankIsLoaded
      * @see kwlWaveBankLoad
      * @see kwlWaveBankUnloadBlocking
+     * @see kwlWaveBankUnloadWithCallback
      * @see kwlGetError
      */
     void kwlWaveBankUnload(kwlWaveBankHandle handle);
     
+    /**
+     * <p>Does exactly the same as kwlWaveBankUnload, but invokes a given callback from
+     * \c kwlUpdate once the wave bank has been unloaded. While the unload is pending,
+     * \c kwlWaveBankIsUnloadPending returns a non-zero value.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_ENGINE_DATA_NOT_LOADED if no engine data is currently loaded.</li>
+     * <li>\c KWL_INVALID_WAVE_BANK_HANDLE if the given handle does not correspond to a wave bank.</li>
+     * <li>\c KWL_INVALID_PARAMETER_VALUE if \c callback is \c NULL.</li>
+     * </ul>
+     * If an error occurs, the callback is not invoked.
+     * </p>
+     * @param handle A handle corresponding to the wave bank to unload.
+     * @param callback The callback to invoke when the wave bank has been unloaded.
+     * @param userData User data that gets passed to the callback. Can be \c NULL.
+     * @see kwlWaveBankUnload
+     * @see kwlWaveBankIsUnloadPending
+     * @see kwlGetError
+     */
+    void kwlWaveBankUnloadWithCallback(kwlWaveBankHandle handle, kwlUnloadCompletedCallback callback, void* userData);
+    
     /**
      * <p>Does exactly the same as kwlWaveBankUnload, but blocks until the wave bank
      * has been unloaded which means that by the time the method returns,
-     * the wave bank is guaranteed to be unloaded. Note: This blocking behaviour may incur
-     * a pause, as opposed to kwlWaveBankUnload.</p>
+     * the wave bank is guaranteed to be unloaded. If playing events stream audio data
+     * from the wave bank, the calling thread sleeps until the mixer has stopped them, 
+     * which takes at least one mixer buffer. This requires the mixer to be running.</p>
      * <p>
      * <strong>Error codes:</strong>
      * <ul>
@@ -1104,6 +1585,26 @@ extern "C"
      */
     void kwlWaveBankUnloadBlocking(kwlWaveBankHandle handle);
     
+    /**
+     * <p>Checks if an unload of a given wave bank has been requested but has not completed
+     * yet, i.e if the engine is waiting for the mixer to stop events streaming audio data
+     * from the wave bank.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_ENGINE_DATA_NOT_LOADED if no engine data is currently loaded.</li>
+     * <li>\c KWL_INVALID_WAVE_BANK_HANDLE if the given handle does not correspond to a wave bank.</li>
+     * </ul>
+     * </p>
+     * @param handle A handle corresponding to the wave bank to check.
+     * @return A non-zero integer if an unload of the wave bank is pending, zero otherwise.
+     * @see kwlWaveBankUnload
+     * @see kwlWaveBankUnloadWithCallback
+     * @see kwlGetError
+     */
+    int kwlWaveBankIsUnloadPending(kwlWaveBankHandle handle);
+    
     /**
      * <p>Checks if a given wave bank is currently loaded. Returns a non-zero integer if this
      * is the case, zero otherwise.</p>
@@ -1140,6 +1641,24 @@ extern "C"
      */
     int kwlWaveBankIsReferencedByPlayingEvent(kwlWaveBankHandle handle);
     
+    /**
+     * <p>Gets the amount of memory used by the prefetch heads of a given wave bank, i.e
+     * the decoded audio kept in memory for audio data streamed from disk, so that events 
+     * can start playing without waiting for the disk. Prefetch heads are specified
+     * per audio data item in the project data.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_ENGINE_DATA_NOT_LOADED if no engine data is currently loaded.</li>
+     * <li>\c KWL_INVALID_WAVE_BANK_HANDLE if the given handle does not correspond to a wave bank.</li>
+     * </ul>
+     * </p>
+     * @param handle A handle corresponding to the wave bank.
+     * @return The number of bytes used by prefetch heads. Zero if the wave bank is not loaded.
+     */
+    int kwlWaveBankGetPrefetchHeadMemory(kwlWaveBankHandle handle);
+    
     /** @} */
     
     /************************************************************************/
@@ -1190,7 +1709,158 @@ extern "C"
      * @see kwlGetError
      */
     void kwlInitialize(int sampleRate, int numOutputChannels, int numInputChannels, int bufferSize);
+
+    /**
+     * <p>Initializes the Kowalski Engine like \c kwlInitialize, reading all files through
+     * a given set of file system callbacks instead of the C standard library.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_ALREADY_INITIALIZED if the Kowalski engine is already initialized.</li>
+     * <li>\c KWL_INVALID_PARAMETER_VALUE if any callback other than the asynchronous read is NULL.</li>
+     * </ul>
+     * </p>
+     * @param sampleRate The desired sample rate in Hz.
+     * @param numOutputChannels The desired number of output channels. 1 for mono, 2 for stereo.
+     * @param numInputChannels The desired number of input channels. 1 for mono, 2 for stereo or 0 to
+     * disable audio input.
+     * @param bufferSize The desired buffer size in bytes.
+     * @param fileSystem The file system callbacks, copied by the engine. NULL to read files with the C standard library.
+     * @see kwlInitialize
+     */
+    void kwlInitializeWithFileSystem(int sampleRate,
+                                     int numOutputChannels,
+                                     int numInputChannels,
+                                     int bufferSize,
+                                     const kwlFileSystem* fileSystem);
+
+    /**
+     * <p>Initializes the Kowalski Engine like \c kwlInitializeWithFileSystem, making all engine
+     * allocations through a given allocator instead of the C standard library. The allocator
+     * stays in use until a later initialization installs another one; blocks are always freed
+     * through the allocator that allocated them.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_ALREADY_INITIALIZED if the Kowalski engine is already initialized.</li>
+     * <li>\c KWL_INVALID_PARAMETER_VALUE if any allocator callback other than the aligned allocation
+     * is NULL, if any file system callback other than the asynchronous read is NULL or if blocks
+     * allocated by a different allocator given to a previous initialization are still allocated.</li>
+     * </ul>
+     * </p>
+     * @param sampleRate The desired sample rate in Hz.
+     * @param numOutputChannels The desired number of output channels. 1 for mono, 2 for stereo.
+     * @param numInputChannels The desired number of input channels. 1 for mono, 2 for stereo or 0 to
+     * disable audio input.
+     * @param bufferSize The desired buffer size in bytes.
+     * @param fileSystem The file system callbacks, copied by the engine. NULL to read files with the C standard library.
+     * @param allocator The allocator callbacks, copied by the engine. NULL to allocate with the C standard library.
+     * @see kwlInitialize
+     * @see kwlGetMemoryStats
+     */
+    void kwlInitializeWithAllocator(int sampleRate,
+                                    int numOutputChannels,
+                                    int numInputChannels,
+                                    int bufferSize,
+                                    const kwlFileSystem* fileSystem,
+                                    const kwlAllocator* allocator);
+
+    /**
+     * Capacity limits and buffer sizes of an engine instance. Start from the values filled in by
+     * ::kwlGetDefaultEngineConfig and change the ones to tune, trading memory for latency or capacity.
+     * @see kwlInitializeWithConfig
+     */
+    typedef struct kwlEngineConfig
+    {
+        /** 
+         * The maximum number of events decoding audio data at the same time, i.e events that stream 
+         * from disk or play compressed audio data other than IMA ADPCM. Each such event decodes on a 
+         * thread of its own, so this also limits the number of decoding threads. Default 10.
+         */
+        int numDecoders;
+        /** 
+         * The maximum number of events playing in-memory IMA ADPCM audio data at the same time. 
+         * These events are decoded on the mixer thread, by decoders allocated up front. Default 64.
+         */
+        int numInlineDecoders;
+        /** The size in bytes of the two buffers a PCM decoder decodes into. Default 2048.*/
+        int pcmDecoderBufferSize;
+        /** The size in bytes of the two buffers an Ogg Vorbis decoder decodes into. Default 131072.*/
+        int oggVorbisDecoderBufferSize;
+        /** 
+         * The maximum number of messages passed between the engine and the mixer per buffer, 
+         * e.g to start, stop or move events. Default 500.
+         */
+        int messageQueueSize;
+        /** 
+         * The maximum number of frames the mixer renders in one go. Larger buffers requested by the 
+         * audio device are rendered in several passes. Default 1024.
+         */
+        int mixBufferSizeInFrames;
+        /** The number of freeform events allocated up front. Default 32.*/
+        int numPreallocatedFreeformEvents;
+        /** The number of freeform events allocated at a time once the preallocated ones are in use. Default 32.*/
+        int freeformEventPoolChunkSize;
+        /** 
+         * The minimum number of buckets of the table tracking live allocations in builds with
+         * \c KWL_DEBUG_MEMORY defined. The table is shared by all engine instances and grows as
+         * needed. Ignored in other builds. Default 4096.
+         */
+        int debugAllocationTableSize;
+    } kwlEngineConfig;
+    
+    /**
+     * <p>Fills in a given config with the values used by engines initialized without a config.</p>
+     * @param config The config to fill in.
+     * @see kwlInitializeWithConfig
+     */
+    void kwlGetDefaultEngineConfig(kwlEngineConfig* config);
     
+    /**
+     * <p>Initializes the Kowalski Engine like \c kwlInitializeWithAllocator, sizing its buffers and
+     * limits by a given config.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_ALREADY_INITIALIZED if the Kowalski engine is already initialized.</li>
+     * <li>\c KWL_INVALID_PARAMETER_VALUE for the reasons given for \c kwlInitializeWithAllocator or if a
+     * field of \c config is out of range. Decoder buffers must hold at least one frame of 16 bit stereo
+     * audio, i.e 4 bytes, \c numPreallocatedFreeformEvents must not be negative and all other fields
+     * must be positive.</li>
+     * </ul>
+     * </p>
+     * @param sampleRate The desired sample rate in Hz.
+     * @param numOutputChannels The desired number of output channels. 1 for mono, 2 for stereo.
+     * @param numInputChannels The desired number of input channels. 1 for mono, 2 for stereo or 0 to
+     * disable audio input.
+     * @param bufferSize The desired buffer size in bytes.
+     * @param fileSystem The file system callbacks, copied by the engine. NULL to read files with the C standard library.
+     * @param allocator The allocator callbacks, copied by the engine. NULL to allocate with the C standard library.
+     * @param config The config, copied by the engine. NULL to use the default config.
+     * @see kwlGetDefaultEngineConfig
+     * @see kwlGetEngineConfig
+     */
+    void kwlInitializeWithConfig(int sampleRate,
+                                 int numOutputChannels,
+                                 int numInputChannels,
+                                 int bufferSize,
+                                 const kwlFileSystem* fileSystem,
+                                 const kwlAllocator* allocator,
+                                 const kwlEngineConfig* config);
+    
+    /**
+     * <p>Gets the config the engine was initialized with.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine is not initialized.</li>
+     * </ul>
+     * </p>
+     * @param config The config to fill in.
+     * @see kwlInitializeWithConfig
+     */
+    void kwlGetEngineConfig(kwlEngineConfig* config);
+
     /**
      * <p>Loads non-audio engine data from a given file. If engine data is already loaded, this
      * function does nothing.</p>
@@ -1199,9 +1869,13 @@ extern "C"
      * <ul>
      * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
      * <li>\c KWL_FILE_NOT_FOUND if the given engine data file cannot be found.</li>
-     * <li>\c KWL_UNKNOWN_FILE_FORMAT if the given file is not a valid Kowalski engine data file.</li>
+     * <li>\c KWL_UNKNOWN_FILE_FORMAT if the given file is not a valid Kowalski engine data file
+     * or was built with an older version of the tools.</li>
+     * <li>\c KWL_CORRUPT_BINARY_DATA if the engine data file is truncated or inconsistent.</li>
      * </ul>
      * </p>
+     * <p>The file is read with a single read into one allocation that holds all loaded
+     * engine data, which is freed in one go by \c kwlEngineDataUnload.</p>
      * @param path The engine data file to load.
      * @see kwlEngineDataUnload
      * @see kwlEngineDataIsLoaded
@@ -1213,7 +1887,8 @@ extern "C"
      * <p>Unloads any currently loaded non-audio engine data and any loaded wave banks.
      * Any data driven event currently playing will be stopped prior to the unloading so
      * it is safe to call this function at any point. If no engine data is loaded, this function
-     * does nothing.</p>
+     * does nothing. The calling thread sleeps until the mixer has stopped all data driven events, 
+     * which takes at least one mixer buffer. This requires the mixer to be running.</p>
      * <p>
      * <strong>Error codes:</strong>
      * <ul>
@@ -1221,35 +1896,125 @@ extern "C"
      * </ul>
      * </p>
      * @see kwlEngineDataLoad
+     * @see kwlEngineDataUnloadAsync
      * @see kwlEngineDataIsLoaded
      * @see kwlGetError
      */
     void kwlEngineDataUnload(void);
     
     /**
-     * <p>Checks if engine data is currently loaded.</p>
+     * <p>Does exactly the same as \c kwlEngineDataUnload, but returns right away. Engine data 
+     * is unloaded from \c kwlUpdate once the mixer has stopped all data driven events, 
+     * after which the given callback, if any, is invoked. Until then, engine data counts as
+     * loaded and \c kwlEngineDataIsUnloadPending returns a non-zero value.</p>
      * <p>
      * <strong>Error codes:</strong>
      * <ul>
      * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
      * </ul>
-     * </p>  
-     * @return A non-zero integer if engine data is currently loaded, zero otherwise.
-     * @see kwlEngineDataLoad 
-     * @see kwlEngineDataUnload 
+     * </p>
+     * @param callback The callback to invoke when engine data has been unloaded. Can be \c NULL.
+     * @param userData User data that gets passed to the callback. Can be \c NULL.
+     * @see kwlEngineDataUnload
+     * @see kwlEngineDataIsUnloadPending
      * @see kwlGetError
      */
-    int kwlEngineDataIsLoaded(void);
+    void kwlEngineDataUnloadAsync(kwlUnloadCompletedCallback callback, void* userData);
     
     /**
-     *<p>Returns a non-zero integer if audio input is currently enabled and zero otherwise</p>
+     * <p>Checks if an engine data unload has been requested but has not completed yet.</p>
      * <p>
      * <strong>Error codes:</strong>
      * <ul>
      * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
      * </ul>
      * </p>
-     * @see kwlDSPUnitAttachToInput
+     * @return A non-zero integer if an engine data unload is pending, zero otherwise.
+     * @see kwlEngineDataUnloadAsync
+     * @see kwlGetError
+     */
+    int kwlEngineDataIsUnloadPending(void);
+    
+    /**
+     * <p>Called when a requested engine data reload has completed or failed. The callback is
+     * invoked on the application thread from \c kwlUpdate.</p>
+     * @param result \c KWL_NO_ERROR if the reloaded engine data has replaced the previous data, 
+     * an error code describing why the previous data was kept otherwise.
+     * @param userData Optional user data.
+     * @see kwlEngineDataReload
+     */
+    typedef void (*kwlEngineDataReloadedCallback)(kwlError result, void* userData);
+    
+    /**
+     * <p>Replaces the currently loaded engine data with the engine data in a given file without 
+     * interrupting playback. The file is parsed on a background thread and the new data is swapped
+     * in from \c kwlUpdate at a mixer buffer boundary, after which the given callback, if any, 
+     * is invoked.</p>
+     * <p>Event definitions, mix buses and mix presets are matched by ID. Playing events and event 
+     * handles carry over to the matching event definitions, as do the user gain, pitch and DSP unit
+     * of each mix bus and the weights of the mix presets. Events of definitions that were removed, 
+     * changed between streaming and non-streaming or that lost instances are stopped. Mix bus, 
+     * mix preset, event definition and wave bank handles are indices, so handles obtained before 
+     * the reload should be looked up again if items were added or removed.</p>
+     * <p>The wave banks of the reloaded data must list the same audio data entries as the 
+     * current data while any wave bank is loaded, so that loaded audio data can be kept.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_ENGINE_DATA_NOT_LOADED if no engine data is loaded or an engine data unload is pending.</li>
+     * <li>\c KWL_ENGINE_DATA_RELOAD_PENDING if another reload is in progress.</li>
+     * <li>\c KWL_FILE_NOT_FOUND if the given engine data file cannot be found.</li>
+     * </ul>
+     * </p>
+     * <p>Errors found while parsing, like \c KWL_UNKNOWN_FILE_FORMAT or \c KWL_CORRUPT_BINARY_DATA,
+     * and \c KWL_WAVE_BANK_ENTRY_MISMATCH are passed to the callback.</p>
+     * @param path The engine data file to load.
+     * @param callback The callback to invoke when the reload has completed or failed. Can be \c NULL.
+     * @param userData User data that gets passed to the callback. Can be \c NULL.
+     * @see kwlEngineDataIsReloadPending
+     * @see kwlGetError
+     */
+    void kwlEngineDataReload(const char* const path, kwlEngineDataReloadedCallback callback, void* userData);
+    
+    /**
+     * <p>Checks if an engine data reload has been requested but has not completed yet.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * </ul>
+     * </p>
+     * @return A non-zero integer if an engine data reload is pending, zero otherwise.
+     * @see kwlEngineDataReload
+     * @see kwlGetError
+     */
+    int kwlEngineDataIsReloadPending(void);
+    
+    /**
+     * <p>Checks if engine data is currently loaded.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * </ul>
+     * </p>  
+     * @return A non-zero integer if engine data is currently loaded, zero otherwise.
+     * @see kwlEngineDataLoad 
+     * @see kwlEngineDataUnload 
+     * @see kwlGetError
+     */
+    int kwlEngineDataIsLoaded(void);
+    
+    /**
+     *<p>Returns a non-zero integer if audio input is currently enabled and zero otherwise</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * </ul>
+     * </p>
+     * @see kwlDSPUnitAttachToInput
      */
     int kwlIsInputEnabled(void);
     
@@ -1358,6 +2123,89 @@ extern "C"
      */
     void kwlUpdate(float timeStepSec);
     
+    /**
+     * <p>Gets statistics of all disk reads performed for streaming events since
+     * the engine was initialized.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_INVALID_PARAMETER_VALUE if \c stats is \c NULL.</li>
+     * </ul>
+     * </p>
+     * @param stats Receives the statistics.
+     * @see kwlEventGetStreamingIOStats
+     * @see kwlGetError
+     */
+    void kwlGetStreamingIOStats(kwlStreamingIOStats* stats);
+    
+    /**
+     * <p>Sets the maximum number of bytes of audio data loaded on demand to keep in memory.
+     * When the budget is exceeded, audio data not used by any playing event is evicted, least
+     * recently used first. Audio data used by playing events is never evicted, so the budget may
+     * be exceeded temporarily.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_INVALID_PARAMETER_VALUE if \c numBytes is negative.</li>
+     * </ul>
+     * </p>
+     * @param numBytes The budget in bytes. Zero means no limit, which is the default.
+     * @see kwlWaveBankLoadOnDemand
+     * @see kwlGetError
+     */
+    void kwlSetResidencyBudget(int numBytes);
+    
+    /**
+     * <p>Sets the maximum time \c kwlEventStart and friends may spend loading the audio 
+     * data of an event from a wave bank loaded on demand before starting the event virtually.
+     * The default is 5 milliseconds.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_INVALID_PARAMETER_VALUE if \c seconds is negative.</li>
+     * </ul>
+     * </p>
+     * @param seconds The maximum wait time in seconds. Zero to never wait.
+     * @see kwlWaveBankLoadOnDemand
+     * @see kwlGetError
+     */
+    void kwlSetResidencyMaxStartWaitTime(float seconds);
+    
+    /**
+     * <p>Gets statistics of the audio data of wave banks loaded on demand since 
+     * the engine was initialized.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_INVALID_PARAMETER_VALUE if \c stats is \c NULL.</li>
+     * </ul>
+     * </p>
+     * @param stats Receives the statistics.
+     * @see kwlWaveBankLoadOnDemand
+     * @see kwlGetError
+     */
+    void kwlGetResidencyStats(kwlResidencyStats* stats);
+    
+    /**
+     * <p>Gets the allocation statistics of a given memory category. Can be called whether
+     * or not the engine is initialized.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_INVALID_PARAMETER_VALUE if \c stats is \c NULL or \c category is not a valid category.</li>
+     * </ul>
+     * </p>
+     * @param category The category to get statistics for.
+     * @param stats Receives the statistics.
+     * @see kwlInitializeWithAllocator
+     * @see kwlGetError
+     */
+    void kwlGetMemoryStats(kwlMemoryCategory category, kwlMemoryStats* stats);
+    
     /** 
      * <p>OpenGL style error flag interface. When an error occurs, the error code is set internally
      * and cleared (i.e set to KWL_NO_ERROR) when this method is called. If more than one error occurs before calling this
@@ -1485,6 +2333,543 @@ extern "C"
     
     /** @} */ /*End of DSP units group*/
     
+    /************************************************************************/
+    /**
+     * @name Engine instances
+     * <p>Functions for running several independent engine instances in one process, 
+     * for example for offline rendering or split screen games. The functions without 
+     * an engine pointer act on the default instance created by ::kwlInitialize.</p>
+     * <p>Each \c kwlInstance function behaves like the function with the same name 
+     * without the \c Instance prefix, but acts on the given engine instance. Errors 
+     * are reported per instance and are retrieved using ::kwlInstanceGetError. 
+     * Calls with different instances may be made from different threads, but calls
+     * with the same instance must not be made concurrently.</p>
+     */
+    /** @{ */
+    
+    /**
+     * <p>Creates an engine instance that renders through the audio host.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_UNSUPPORTED_NUM_OUTPUT_CHANNELS if the number of output channels is not 1 or 2.</li>
+     * <li>\c KWL_UNSUPPORTED_NUM_INPUT_CHANNELS if the number of input channels is not 0, 1 or 2.</li>
+     * <li>\c KWL_INVALID_PARAMETER_VALUE if the sample rate or buffer size is not positive
+     * or if the file system is incomplete.</li>
+     * </ul>
+     * </p>
+     * @param sampleRate The sample rate of the instance.
+     * @param numOutputChannels The number of output channels.
+     * @param numInputChannels The number of input channels.
+     * @param bufferSize The buffer size of the audio host, in frames.
+     * @param fileSystem The file system to load data through, or \c NULL to use stdio.
+     * @param audioDataSource An instance whose loaded wave bank audio data should be shared
+     * with the new instance, or \c NULL. Wave banks loaded by any of the sharing instances 
+     * are only read and stored once.
+     * @return The new instance, or \c NULL on failure. The error is returned by 
+     * ::kwlInstanceGetError with a \c NULL argument.
+     * @see kwlEngineDestroy
+     */
+    kwlEngineInstance* kwlEngineCreate(int sampleRate,
+                                       int numOutputChannels,
+                                       int numInputChannels,
+                                       int bufferSize,
+                                       const kwlFileSystem* fileSystem,
+                                       kwlEngineInstance* audioDataSource);
+    
+    /**
+     * <p>Creates an engine instance without an audio host. The instance produces audio 
+     * only when ::kwlInstanceRender is called. Offline instances share nothing but 
+     * optionally audio data with other instances, so several of them can render in
+     * parallel on different threads.</p>
+     * @see kwlEngineCreate
+     * @see kwlInstanceRender
+     */
+    kwlEngineInstance* kwlEngineCreateOffline(int sampleRate,
+                                              int numOutputChannels,
+                                              const kwlFileSystem* fileSystem,
+                                              kwlEngineInstance* audioDataSource);
+    
+    /**
+     * <p>Creates an engine instance like ::kwlEngineCreate, sizing its buffers and limits by a given
+     * config. Returns \c NULL and sets the error returned by ::kwlGetError to \c KWL_INVALID_PARAMETER_VALUE
+     * if a field of the config is out of range, as described for ::kwlInitializeWithConfig.</p>
+     * @param config The config, copied by the instance. NULL to use the default config.
+     * @see kwlEngineCreate
+     * @see kwlInstanceGetEngineConfig
+     */
+    kwlEngineInstance* kwlEngineCreateWithConfig(int sampleRate,
+                                                 int numOutputChannels,
+                                                 int numInputChannels,
+                                                 int bufferSize,
+                                                 const kwlFileSystem* fileSystem,
+                                                 kwlEngineInstance* audioDataSource,
+                                                 const kwlEngineConfig* config);
+    
+    /**
+     * <p>Shuts down and frees a given engine instance, unloading its engine data and 
+     * wave banks. Shared audio data is freed when the last instance using it is destroyed.
+     * Destroying the default instance is equivalent to calling ::kwlDeinitialize.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if \c engine is \c NULL.</li>
+     * </ul>
+     * </p>
+     */
+    void kwlEngineDestroy(kwlEngineInstance* engine);
+    
+    /**
+     * Returns the instance created by ::kwlInitialize, or \c NULL if the engine is not initialized.
+     */
+    kwlEngineInstance* kwlEngineGetDefault(void);
+    
+    /**
+     * <p>Renders a given number of frames of interleaved output from an offline 
+     * engine instance. Messages between the engine and the mixer are exchanged at 
+     * every buffer, so ::kwlInstanceUpdate should be called between renders just like
+     * with a host driven instance.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if \c engine is \c NULL.</li>
+     * <li>\c KWL_INVALID_PARAMETER_VALUE if the instance is not offline, if \c outBuffer
+     * is \c NULL or if \c numFrames is negative.</li>
+     * </ul>
+     * </p>
+     * @param engine The offline instance to render.
+     * @param outBuffer Receives \c numFrames frames of interleaved output.
+     * @param numFrames The number of frames to render.
+     * @see kwlEngineCreateOffline
+     */
+    void kwlInstanceRender(kwlEngineInstance* engine, float* outBuffer, int numFrames);
+    
+    /**
+     * Returns and clears the first error generated by a call with a given instance.
+     * Pass \c NULL to get the error of calls made without an instance, for example
+     * failed ::kwlEngineCreate calls.
+     * @see kwlGetError
+     */
+    kwlError kwlInstanceGetError(kwlEngineInstance* engine);
+    
+    /** @see kwlPCMBufferLoad */
+    kwlError kwlInstancePCMBufferLoad(kwlEngineInstance* engine, const char* const path, kwlPCMBuffer* buffer);
+    
+    /** @see kwlEventGetHandle */
+    kwlEventHandle kwlInstanceEventGetHandle(kwlEngineInstance* engine, const char* const eventId);
+    
+    /** @see kwlEventDefinitionGetHandle */
+    kwlEventDefinitionHandle kwlInstanceEventDefinitionGetHandle(kwlEngineInstance* engine, const char* const eventDefinitionID);
+    
+    /** @see kwlEventCreateWithFile */
+    kwlEventHandle kwlInstanceEventCreateWithFile(kwlEngineInstance* engine, const char* const audioFilePath, kwlEventType eventType, int streamFromDisk);
+    
+    /** @see kwlEventRelease */
+    void kwlInstanceEventRelease(kwlEngineInstance* engine, kwlEventHandle handle);
+    
+    /** @see kwlEventSetPitch */
+    void kwlInstanceEventSetPitch(kwlEngineInstance* engine, kwlEventHandle handle, float pitchInPercent);
+    
+    /** @see kwlEventSetGain */
+    void kwlInstanceEventSetGain(kwlEngineInstance* engine, kwlEventHandle handle, float gain);
+    
+    /** @see kwlEventSetLinearGain */
+    void kwlInstanceEventSetLinearGain(kwlEngineInstance* engine, kwlEventHandle handle, float gain);
+    
+    /** @see kwlEventSetPosition */
+    void kwlInstanceEventSetPosition(kwlEngineInstance* engine, kwlEventHandle handle, float posX, float posY, float posZ);
+    
+    /** @see kwlEventSetVelocity */
+    void kwlInstanceEventSetVelocity(kwlEngineInstance* engine, kwlEventHandle handle, float velX, float velY, float velZ);
+    
+    /** @see kwlEventSetOrientation */
+    void kwlInstanceEventSetOrientation(kwlEngineInstance* engine, kwlEventHandle handle, float directionX, float directionY, float directionZ);
+    
+    /** @see kwlEventSetBalance */
+    void kwlInstanceEventSetBalance(kwlEngineInstance* engine, kwlEventHandle handle, float balance);
+    
+    /** @see kwlEventBatchSetParameters */
+    void kwlInstanceEventBatchSetParameters(kwlEngineInstance* engine,
+                                            const kwlEventHandle* handles, 
+                                            int numEvents, 
+                                            const kwlEventParameterBatch* parameters, 
+                                            kwlError* errors);
+    
+    /** @see kwlEventStart */
+    void kwlInstanceEventStart(kwlEngineInstance* engine, kwlEventHandle handle);
+    
+    /** @see kwlEventStartOneShot */
+    void kwlInstanceEventStartOneShot(kwlEngineInstance* engine, kwlEventDefinitionHandle handle);
+    
+    /** @see kwlEventStartOneShotAt */
+    void kwlInstanceEventStartOneShotAt(kwlEngineInstance* engine, kwlEventDefinitionHandle handle, float x, float y, float z);
+    
+    /** @see kwlEventStartFade */
+    void kwlInstanceEventStartFade(kwlEngineInstance* engine, kwlEventHandle handle, float fadeTime);
+    
+    /** @see kwlEventStop */
+    void kwlInstanceEventStop(kwlEngineInstance* engine, kwlEventHandle handle);
+    
+    /** @see kwlEventStopFade */
+    void kwlInstanceEventStopFade(kwlEngineInstance* engine, kwlEventHandle handle, float fadeTime);
+    
+    /** @see kwlEventStartAtFrame */
+    void kwlInstanceEventStartAtFrame(kwlEngineInstance* engine, kwlEventHandle handle, long long frame);
+    
+    /** @see kwlEventStopAtFrame */
+    void kwlInstanceEventStopAtFrame(kwlEngineInstance* engine, kwlEventHandle handle, long long frame);
+    
+    /** @see kwlEventPause */
+    void kwlInstanceEventPause(kwlEngineInstance* engine, kwlEventHandle handle);
+    
+    /** @see kwlEventResume */
+    void kwlInstanceEventResume(kwlEngineInstance* engine, kwlEventHandle handle);
+    
+    /** @see kwlEventIsPlaying */
+    int kwlInstanceEventIsPlaying(kwlEngineInstance* engine, kwlEventHandle handle);
+    
+    /** @see kwlEventCreateWithBuffer */
+    kwlEventHandle kwlInstanceEventCreateWithBuffer(kwlEngineInstance* engine, kwlPCMBuffer* buffer, kwlEventType eventType);
+    
+    /** @see kwlEventSetCallback */
+    void kwlInstanceEventSetCallback(kwlEngineInstance* engine, kwlEventHandle handle, kwlEventStoppedCallack callback, void* userData);
+    
+    /** @see kwlEventStartOneShotWithCallback */
+    void kwlInstanceEventStartOneShotWithCallback(kwlEngineInstance* engine, kwlEventDefinitionHandle eventDefinition, kwlEventStoppedCallack callback, void* userData);
+    
+    /** @see kwlEventStartOneShotWithCallbackAt */
+    void kwlInstanceEventStartOneShotWithCallbackAt(kwlEngineInstance* engine, kwlEventDefinitionHandle eventDefinition, float x, float y, float z, kwlEventStoppedCallack callback, void* userData);
+    
+    /** @see kwlEventGetStreamingIOStats */
+    void kwlInstanceEventGetStreamingIOStats(kwlEngineInstance* engine, kwlEventHandle handle, kwlStreamingIOStats* stats);
+    
+    /** @see kwlEventPrefetch */
+    void kwlInstanceEventPrefetch(kwlEngineInstance* engine, kwlEventHandle handle);
+    
+    /** @see kwlMixBusGetHandle */
+    kwlMixBusHandle kwlInstanceMixBusGetHandle(kwlEngineInstance* engine, const char* const busId);
+    
+    /** @see kwlMixBusSetPitch */
+    void kwlInstanceMixBusSetPitch(kwlEngineInstance* engine, kwlMixBusHandle handle, float pitch);
+    
+    /** @see kwlMixBusSetGain */
+    void kwlInstanceMixBusSetGain(kwlEngineInstance* engine, kwlMixBusHandle handle, float gain);
+    
+    /** @see kwlMixBusSetLinearGain */
+    void kwlInstanceMixBusSetLinearGain(kwlEngineInstance* engine, kwlMixBusHandle handle, float gain);
+    
+    /** @see kwlMixPresetGetHandle */
+    kwlMixPresetHandle kwlInstanceMixPresetGetHandle(kwlEngineInstance* engine, const char* const presetId);
+    
+    /** @see kwlMixPresetFadeTo */
+    void kwlInstanceMixPresetFadeTo(kwlEngineInstance* engine, kwlMixPresetHandle presetHandle);
+    
+    /** @see kwlMixPresetSet */
+    void kwlInstanceMixPresetSet(kwlEngineInstance* engine, kwlMixPresetHandle presetHandle);
+    
+    /** @see kwlListenerSetPosition */
+    void kwlInstanceListenerSetPosition(kwlEngineInstance* engine, float posX, float posY, float posZ);
+    
+    /** @see kwlListenerSetVelocity */
+    void kwlInstanceListenerSetVelocity(kwlEngineInstance* engine, float velX, float velY, float velZ);
+    
+    /** @see kwlListenerSetOrientation */
+    void kwlInstanceListenerSetOrientation(kwlEngineInstance* engine,
+                                           float directionX, float directionY, float directionZ,
+                                           float upX, float upY, float upZ);
+    
+    /** @see kwlListenerSetConeParameters */
+    void kwlInstanceListenerSetConeParameters(kwlEngineInstance* engine, float innerConeAngle, float outerConeAngle, float outerConeGain);
+    
+    /** @see kwlSetDistanceAttenuationModel */
+    void kwlInstanceSetDistanceAttenuationModel(kwlEngineInstance* engine,
+                                                kwlDistanceAttenuationModel type,
+                                                int clamp,
+                                                float maxDistance,
+                                                float rolloffFactor,
+                                                float referenceDistance);
+    
+    /** @see kwlSetDopplerShiftParameters */
+    void kwlInstanceSetDopplerShiftParameters(kwlEngineInstance* engine, float speedOfSound, float dopplerScale);
+    
+    /** @see kwlSetConeAttenuationEnabled */
+    void kwlInstanceSetConeAttenuationEnabled(kwlEngineInstance* engine, int enableListenerCone, int enableEventCones);
+    
+    /** @see kwlGetNumFramesMixed */
+    unsigned int kwlInstanceGetNumFramesMixed(kwlEngineInstance* engine);
+    
+    /** @see kwlGetTotalNumFramesMixed */
+    long long kwlInstanceGetTotalNumFramesMixed(kwlEngineInstance* engine);
+    
+    /** @see kwlWaveBankLoad */
+    kwlWaveBankHandle kwlInstanceWaveBankLoad(kwlEngineInstance* engine, const char* const path);
+    
+    /** @see kwlWaveBankLoadOnDemand */
+    kwlWaveBankHandle kwlInstanceWaveBankLoadOnDemand(kwlEngineInstance* engine, const char* const path);
+    
+    /** @see kwlWaveBankUnload */
+    void kwlInstanceWaveBankUnload(kwlEngineInstance* engine, kwlWaveBankHandle waveBankHandle);
+    
+    /** @see kwlWaveBankUnloadWithCallback */
+    void kwlInstanceWaveBankUnloadWithCallback(kwlEngineInstance* engine, kwlWaveBankHandle waveBankHandle, kwlUnloadCompletedCallback callback, void* userData);
+    
+    /** @see kwlWaveBankUnloadBlocking */
+    void kwlInstanceWaveBankUnloadBlocking(kwlEngineInstance* engine, kwlWaveBankHandle waveBankHandle);
+    
+    /** @see kwlWaveBankIsUnloadPending */
+    int kwlInstanceWaveBankIsUnloadPending(kwlEngineInstance* engine, kwlWaveBankHandle waveBankHandle);
+    
+    /** @see kwlWaveBankIsLoaded */
+    int kwlInstanceWaveBankIsLoaded(kwlEngineInstance* engine, kwlWaveBankHandle handle);
+    
+    /** @see kwlWaveBankIsReferencedByPlayingEvent */
+    int kwlInstanceWaveBankIsReferencedByPlayingEvent(kwlEngineInstance* engine, kwlWaveBankHandle handle);
+    
+    /** @see kwlWaveBankGetPrefetchHeadMemory */
+    int kwlInstanceWaveBankGetPrefetchHeadMemory(kwlEngineInstance* engine, kwlWaveBankHandle handle);
+    
+    /** @see kwlEngineDataLoad */
+    void kwlInstanceEngineDataLoad(kwlEngineInstance* engine, const char* const dataPath);
+    
+    /** @see kwlEngineDataUnload */
+    void kwlInstanceEngineDataUnload(kwlEngineInstance* engine);
+    
+    /** @see kwlEngineDataUnloadAsync */
+    void kwlInstanceEngineDataUnloadAsync(kwlEngineInstance* engine, kwlUnloadCompletedCallback callback, void* userData);
+    
+    /** @see kwlEngineDataIsUnloadPending */
+    int kwlInstanceEngineDataIsUnloadPending(kwlEngineInstance* engine);
+    
+    /** @see kwlEngineDataReload */
+    void kwlInstanceEngineDataReload(kwlEngineInstance* engine, const char* const path, kwlEngineDataReloadedCallback callback, void* userData);
+    
+    /** @see kwlEngineDataIsReloadPending */
+    int kwlInstanceEngineDataIsReloadPending(kwlEngineInstance* engine);
+    
+    /** @see kwlEngineDataIsLoaded */
+    int kwlInstanceEngineDataIsLoaded(kwlEngineInstance* engine);
+    
+    /** @see kwlIsInputEnabled */
+    int kwlInstanceIsInputEnabled(kwlEngineInstance* engine);
+    
+    /** @see kwlMixerResume */
+    void kwlInstanceMixerResume(kwlEngineInstance* engine);
+    
+    /** @see kwlMixerPause */
+    void kwlInstanceMixerPause(kwlEngineInstance* engine);
+    
+    /** @see kwlLevelMeteringSetEnabled */
+    void kwlInstanceLevelMeteringSetEnabled(kwlEngineInstance* engine, int enabled);
+    
+    /** @see kwlGetLevelLeft */
+    float kwlInstanceGetLevelLeft(kwlEngineInstance* engine);
+    
+    /** @see kwlGetLevelRight */
+    float kwlInstanceGetLevelRight(kwlEngineInstance* engine);
+    
+    /** @see kwlHasClipped */
+    int kwlInstanceHasClipped(kwlEngineInstance* engine);
+    
+    /** @see kwlUpdate */
+    void kwlInstanceUpdate(kwlEngineInstance* engine, float timeStepSec);
+    
+    /** @see kwlGetStreamingIOStats */
+    void kwlInstanceGetStreamingIOStats(kwlEngineInstance* engine, kwlStreamingIOStats* stats);
+    
+    /** @see kwlSetResidencyBudget */
+    void kwlInstanceSetResidencyBudget(kwlEngineInstance* engine, int numBytes);
+    
+    /** @see kwlSetResidencyMaxStartWaitTime */
+    void kwlInstanceSetResidencyMaxStartWaitTime(kwlEngineInstance* engine, float seconds);
+    
+    /** @see kwlGetResidencyStats */
+    void kwlInstanceGetResidencyStats(kwlEngineInstance* engine, kwlResidencyStats* stats);
+    
+    /** @see kwlGetEngineConfig */
+    void kwlInstanceGetEngineConfig(kwlEngineInstance* engine, kwlEngineConfig* config);
+    
+    /** @see kwlDSPUnitAttachToEvent */
+    void kwlInstanceDSPUnitAttachToEvent(kwlEngineInstance* engine, kwlDSPUnitHandle dspUnit, kwlEventHandle eventHandle);
+    
+    /** @see kwlDSPUnitAttachToInput */
+    void kwlInstanceDSPUnitAttachToInput(kwlEngineInstance* engine, kwlDSPUnitHandle dspUnit);
+    
+    /** @see kwlDSPUnitAttachToMixBus */
+    void kwlInstanceDSPUnitAttachToMixBus(kwlEngineInstance* engine, kwlDSPUnitHandle dspUnit, kwlMixBusHandle mixBusHandle);
+    
+    /** @see kwlDSPUnitAttachToOutput */
+    void kwlInstanceDSPUnitAttachToOutput(kwlEngineInstance* engine, kwlDSPUnitHandle dspUnit);
+    
+    /** @} */ /*End of engine instances group*/
+    
+    /************************************************************************/
+    /**
+     * @name Command buffers
+     * <p>Command buffers let any thread make the calls of the setter functions, which 
+     * otherwise must be made on the thread calling ::kwlUpdate. Each producer thread 
+     * records commands into a command buffer of its own and submits them in batches, 
+     * without locking. The next ::kwlUpdate executes the submitted commands of one 
+     * buffer at a time, in the order the buffers were created, and each buffer in the 
+     * order its commands were recorded. Commands submitted before ::kwlUpdate is called 
+     * are thus executed in the same order on every run.</p>
+     * <p>Command buffers are created and destroyed on the thread calling ::kwlUpdate.
+     * Handles passed to the record functions must be obtained on that thread as well. 
+     * A given command buffer must only be recorded into by one thread at a time.</p>
+     * <p>Errors of recording and executing commands are not passed to ::kwlGetError.
+     * They are retrieved per buffer using ::kwlCommandBufferGetError.</p>
+     */
+    /** @{ */
+    
+    /**
+     * <p>Creates a command buffer for a producer thread.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_ENGINE_IS_NOT_INITIALIZED if the Kowalski engine has not been initialized.</li>
+     * <li>\c KWL_INVALID_PARAMETER_VALUE if \c capacity is not positive.</li>
+     * </ul>
+     * </p>
+     * @param capacity The maximum number of recorded commands that have not been executed yet.
+     * @return The new command buffer, or \c NULL on failure.
+     * @see kwlCommandBufferDestroy
+     */
+    kwlCommandBufferHandle kwlCommandBufferCreate(int capacity);
+    
+    /** 
+     * Creates a command buffer executed by a given engine instance.
+     * @see kwlCommandBufferCreate 
+     */
+    kwlCommandBufferHandle kwlInstanceCommandBufferCreate(kwlEngineInstance* engine, int capacity);
+    
+    /**
+     * <p>Executes the submitted commands of a command buffer and destroys it. 
+     * Commands that have not been submitted are discarded. Command buffers are 
+     * also destroyed along with their engine instance.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_INVALID_PARAMETER_VALUE if \c buffer is \c NULL.</li>
+     * </ul>
+     * </p>
+     */
+    void kwlCommandBufferDestroy(kwlCommandBufferHandle buffer);
+    
+    /**
+     * Makes the commands recorded since the previous submit available to the 
+     * next ::kwlUpdate. Called on the thread recording into the buffer.
+     */
+    void kwlCommandBufferSubmit(kwlCommandBufferHandle buffer);
+    
+    /**
+     * <p>Returns and clears the first error of recording commands into a given 
+     * buffer or of executing them. Called on the thread recording into the buffer.</p>
+     * <p>
+     * <strong>Error codes:</strong>
+     * <ul>
+     * <li>\c KWL_COMMAND_BUFFER_FULL if a command was discarded because \c capacity commands 
+     * were waiting to be executed.</li>
+     * <li>The error codes of the functions corresponding to the executed commands.</li>
+     * </ul>
+     * </p>
+     */
+    kwlError kwlCommandBufferGetError(kwlCommandBufferHandle buffer);
+    
+    /** Records a call to ::kwlEventStart. */
+    void kwlCommandEventStart(kwlCommandBufferHandle buffer, kwlEventHandle handle);
+    
+    /** Records a call to ::kwlEventStartFade. */
+    void kwlCommandEventStartFade(kwlCommandBufferHandle buffer, kwlEventHandle handle, float fadeTime);
+    
+    /** Records a call to ::kwlEventStop. */
+    void kwlCommandEventStop(kwlCommandBufferHandle buffer, kwlEventHandle handle);
+    
+    /** Records a call to ::kwlEventStopFade. */
+    void kwlCommandEventStopFade(kwlCommandBufferHandle buffer, kwlEventHandle handle, float fadeTime);
+    
+    /** Records a call to ::kwlEventPause. */
+    void kwlCommandEventPause(kwlCommandBufferHandle buffer, kwlEventHandle handle);
+    
+    /** Records a call to ::kwlEventResume. */
+    void kwlCommandEventResume(kwlCommandBufferHandle buffer, kwlEventHandle handle);
+    
+    /** Records a call to ::kwlEventRelease. */
+    void kwlCommandEventRelease(kwlCommandBufferHandle buffer, kwlEventHandle handle);
+    
+    /** Records a call to ::kwlEventStartOneShot. */
+    void kwlCommandEventStartOneShot(kwlCommandBufferHandle buffer, kwlEventDefinitionHandle handle);
+    
+    /** Records a call to ::kwlEventStartOneShotAt. */
+    void kwlCommandEventStartOneShotAt(kwlCommandBufferHandle buffer,
+                                       kwlEventDefinitionHandle handle,
+                                       float x,
+                                       float y,
+                                       float z);
+    
+    /** Records a call to ::kwlEventSetGain. */
+    void kwlCommandEventSetGain(kwlCommandBufferHandle buffer, kwlEventHandle handle, float gain);
+    
+    /** Records a call to ::kwlEventSetLinearGain. */
+    void kwlCommandEventSetLinearGain(kwlCommandBufferHandle buffer, kwlEventHandle handle, float gain);
+    
+    /** Records a call to ::kwlEventSetPitch. */
+    void kwlCommandEventSetPitch(kwlCommandBufferHandle buffer, kwlEventHandle handle, float pitch);
+    
+    /** Records a call to ::kwlEventSetBalance. */
+    void kwlCommandEventSetBalance(kwlCommandBufferHandle buffer, kwlEventHandle handle, float balance);
+    
+    /** Records a call to ::kwlEventSetPosition. */
+    void kwlCommandEventSetPosition(kwlCommandBufferHandle buffer,
+                                    kwlEventHandle handle,
+                                    float posX,
+                                    float posY,
+                                    float posZ);
+    
+    /** Records a call to ::kwlEventSetVelocity. */
+    void kwlCommandEventSetVelocity(kwlCommandBufferHandle buffer,
+                                    kwlEventHandle handle,
+                                    float velX,
+                                    float velY,
+                                    float velZ);
+    
+    /** Records a call to ::kwlEventSetOrientation. */
+    void kwlCommandEventSetOrientation(kwlCommandBufferHandle buffer,
+                                       kwlEventHandle handle,
+                                       float directionX,
+                                       float directionY,
+                                       float directionZ);
+    
+    /** Records a call to ::kwlListenerSetPosition. */
+    void kwlCommandListenerSetPosition(kwlCommandBufferHandle buffer, float posX, float posY, float posZ);
+    
+    /** Records a call to ::kwlListenerSetVelocity. */
+    void kwlCommandListenerSetVelocity(kwlCommandBufferHandle buffer, float velX, float velY, float velZ);
+    
+    /** Records a call to ::kwlListenerSetOrientation. */
+    void kwlCommandListenerSetOrientation(kwlCommandBufferHandle buffer,
+                                          float directionX,
+                                          float directionY,
+                                          float directionZ,
+                                          float upX,
+                                          float upY,
+                                          float upZ);
+    
+    /** Records a call to ::kwlMixBusSetGain. */
+    void kwlCommandMixBusSetGain(kwlCommandBufferHandle buffer, kwlMixBusHandle handle, float gain);
+    
+    /** Records a call to ::kwlMixBusSetLinearGain. */
+    void kwlCommandMixBusSetLinearGain(kwlCommandBufferHandle buffer, kwlMixBusHandle handle, float gain);
+    
+    /** Records a call to ::kwlMixBusSetPitch. */
+    void kwlCommandMixBusSetPitch(kwlCommandBufferHandle buffer, kwlMixBusHandle handle, float pitch);
+    
+    /** Records a call to ::kwlMixPresetSet. */
+    void kwlCommandMixPresetSet(kwlCommandBufferHandle buffer, kwlMixPresetHandle presetHandle);
+    
+    /** Records a call to ::kwlMixPresetFadeTo. */
+    void kwlCommandMixPresetFadeTo(kwlCommandBufferHandle buffer, kwlMixPresetHandle presetHandle);
+    
+    /** @} */ /*End of command buffers group*/
+    
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
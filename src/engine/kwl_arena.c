@@ -0,0 +1,84 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+
+#include "kwl_arena.h"
+#include "kwl_memory.h"
+
+/** The number of bytes reserved for the chunk header, keeping the payload aligned.*/
+#define KWL_ARENA_CHUNK_HEADER_SIZE ((sizeof(kwlArenaChunk) + KWL_ARENA_ALIGNMENT - 1) & ~((size_t)KWL_ARENA_ALIGNMENT - 1))
+
+static size_t kwlArena_align(size_t size)
+{
+    return (size + KWL_ARENA_ALIGNMENT - 1) & ~((size_t)KWL_ARENA_ALIGNMENT - 1);
+}
+
+void kwlArena_init(kwlArena* arena, kwlMemoryCategory category, size_t chunkSize)
+{
+    arena->category = category;
+    arena->chunkSize = kwlArena_align(chunkSize);
+    arena->chunks = NULL;
+    arena->position = NULL;
+    arena->end = NULL;
+}
+
+void* kwlArena_alloc(kwlArena* arena, size_t size)
+{
+    size = kwlArena_align(size);
+    if (arena->chunks == NULL || size > (size_t)(arena->end - arena->position))
+    {
+        /*start a new chunk. the rest of the current one is wasted.*/
+        const size_t payloadSize = size > arena->chunkSize ? size : arena->chunkSize;
+        kwlArenaChunk* chunk = (kwlArenaChunk*)KWL_MALLOC_ALIGNED(KWL_ARENA_CHUNK_HEADER_SIZE + payloadSize,
+                                                                 KWL_ARENA_ALIGNMENT,
+                                                                 arena->category,
+                                                                 "arena chunk");
+        if (chunk == NULL)
+        {
+            return NULL;
+        }
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+        arena->position = (char*)chunk + KWL_ARENA_CHUNK_HEADER_SIZE;
+        arena->end = arena->position + payloadSize;
+    }
+    
+    void* block = arena->position;
+    arena->position += size;
+    return block;
+}
+
+void kwlArena_free(kwlArena* arena)
+{
+    kwlArenaChunk* chunk = arena->chunks;
+    while (chunk != NULL)
+    {
+        kwlArenaChunk* next = chunk->next;
+        KWL_FREE(chunk);
+        chunk = next;
+    }
+    
+    arena->chunks = NULL;
+    arena->position = NULL;
+    arena->end = NULL;
+}
@@ -0,0 +1,82 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+
+#ifndef KWL_ARENA_H
+#define KWL_ARENA_H
+
+/*! \file */
+
+#include "kowalski.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+/** The alignment of all blocks allocated from an arena.*/
+#define KWL_ARENA_ALIGNMENT 16
+
+/** A chunk of memory blocks are carved from, followed by its payload.*/
+typedef struct kwlArenaChunk
+{
+    /** The previously allocated chunk, if any.*/
+    struct kwlArenaChunk* next;
+} kwlArenaChunk;
+
+/**
+ * A bump allocator for data that is freed all at once, like the tables of a loaded
+ * wave bank. Blocks are carved from chunks allocated through the engine allocator
+ * and are only released when the whole arena is freed.
+ */
+typedef struct kwlArena
+{
+    /** The memory category the chunks are allocated with.*/
+    kwlMemoryCategory category;
+    /** The payload size of new chunks. Larger blocks get a chunk of their own.*/
+    size_t chunkSize;
+    /** The most recently allocated chunk, or NULL if no chunk has been allocated.*/
+    kwlArenaChunk* chunks;
+    /** The next free byte in the current chunk.*/
+    char* position;
+    /** The end of the current chunk.*/
+    char* end;
+} kwlArena;
+
+/** Sets up an empty arena. No memory is allocated until the first block is requested.*/
+void kwlArena_init(kwlArena* arena, kwlMemoryCategory category, size_t chunkSize);
+
+/** 
+ * Allocates a block of a given size, aligned to KWL_ARENA_ALIGNMENT bytes.
+ * @return The block, or NULL if a new chunk could not be allocated.
+ */
+void* kwlArena_alloc(kwlArena* arena, size_t size);
+
+/** Frees all blocks allocated from an arena. The arena can be used again afterwards.*/
+void kwlArena_free(kwlArena* arena);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /*KWL_ARENA_H*/
@@ -21,17 +21,39 @@ freely, subject to the following restrictions:
    distribution.
 */
 
+#include "kwl_assert.h"
 #include "kwl_audiodata.h"
 #include "kwl_memory.h"
 
 void kwlAudioData_free(kwlAudioData* audioData)
 {
-    if (audioData->bytes != NULL)
+    if (audioData->sharedBuffer != NULL)
+    {
+        /*Events still playing the data keep the buffer alive.*/
+        kwlSharedAudioBuffer_release(audioData->sharedBuffer);
+        audioData->sharedBuffer = NULL;
+        audioData->bytes = NULL;
+    }
+    else if (audioData->bytes != NULL)
     {
         KWL_FREE(audioData->bytes);
         audioData->bytes = NULL;
     }
     
+    if (audioData->sharedDecoderData != NULL)
+    {
+        kwlSharedDecoderData_release(audioData->sharedDecoderData);
+        audioData->sharedDecoderData = NULL;
+    }
+    
+    if (audioData->prefetchHead != NULL)
+    {
+        KWL_FREE(audioData->prefetchHead);
+        audioData->prefetchHead = NULL;
+        audioData->numPrefetchHeadFrames = 0;
+        audioData->numPrefetchHeadChannels = 0;
+    }
+    
     audioData->isLoaded = 0;
 }
 
@@ -43,3 +65,30 @@ int kwlAudioData_isLinearPCM(kwlAudioData* audioData)
            audioData->encoding == KWL_ENCODING_SIGNED_8BIT_PCM ||
            audioData->encoding == KWL_ENCODING_UNSIGNED_8BIT_PCM;
 }
+
+kwlSharedDecoderData* kwlSharedDecoderData_create(void* data, void (*freeData)(void* data))
+{
+    kwlSharedDecoderData* sharedData = 
+        (kwlSharedDecoderData*)KWL_MALLOC(sizeof(kwlSharedDecoderData), KWL_MEMORY_CATEGORY_DECODER, "shared decoder data");
+    sharedData->refCount = 1;
+    sharedData->data = data;
+    sharedData->freeData = freeData;
+    return sharedData;
+}
+
+void kwlSharedDecoderData_retain(kwlSharedDecoderData* sharedData)
+{
+    KWL_ASSERT(sharedData->refCount > 0);
+    sharedData->refCount++;
+}
+
+void kwlSharedDecoderData_release(kwlSharedDecoderData* sharedData)
+{
+    KWL_ASSERT(sharedData->refCount > 0);
+    sharedData->refCount--;
+    if (sharedData->refCount == 0)
+    {
+        sharedData->freeData(sharedData->data);
+        KWL_FREE(sharedData);
+    }
+}
@@ -25,6 +25,7 @@
 
 /*! \file */
 
+#include "kwl_audiodatacache.h"
 #include "kwl_inputstream.h"
 #include "kwl_wavebank.h"
 
@@ -60,6 +61,32 @@ extern "C"
     } kwlAudioEncoding;
     
     
+    /**
+     * Reference counted, codec specific data shared by all decoders
+     * of a given piece of audio data, for example parsed stream headers.
+     * Only accessed from the engine thread.
+     */
+    typedef struct kwlSharedDecoderData
+    {
+        /** The number of references: one held by the audio data and one per decoder using it.*/
+        int refCount;
+        /** The codec specific data.*/
+        void* data;
+        /** A codec specific function that frees \c data once the last reference is released.*/
+        void (*freeData)(void* data);
+    } kwlSharedDecoderData;
+    
+    /** The residency states of audio data belonging to wave banks loaded on demand.*/
+    typedef enum kwlResidencyState
+    {
+        /** The audio data is not in memory.*/
+        KWL_NOT_RESIDENT = 0,
+        /** The audio data is being read into memory.*/
+        KWL_LOADING,
+        /** The audio data is in memory.*/
+        KWL_RESIDENT
+    } kwlResidencyState;
+    
     /**
      * A structure describing a piece of audio data. In the case
      * of PCM data, the data is just an array of signed, interleaved 16 bit samples.
@@ -86,10 +113,26 @@ extern "C"
         int numFrames;
         /** The number of channels of the audio. Only used for PCM data. */
         int numChannels;
+        /** The sample rate of the audio in Hz. Zero if unknown, in which case the output sample rate is assumed. */
+        int sampleRate;
+        /** The first frame of the region played when looping. Only used by decoders.*/
+        int loopStart;
+        /** The frame following the region played when looping. 0 means the end of the data. Only used by decoders.*/
+        int loopEnd;
         /** The total number of bytes of loaded audio data. A value of 0 indicates that no data is loaded. */
         int numBytes;
         /** */
         void* bytes;
+        /** 
+         * The content hash written by the wave bank builder, used to share identical audio data
+         * between wave banks. 0 if unknown.
+         */
+        unsigned long long contentHash;
+        /** 
+         * The reference counted buffer holding \c bytes, shared with other wave bank entries with the
+         * same content and retained by playing events. NULL if \c bytes is not owned by a shared buffer.
+         */
+        kwlSharedAudioBuffer* sharedBuffer;
         int isEntireFile;
         /** Non-zero if the non-PCM data (if any) should be streamed from disk.*/
         int streamFromDisk;
@@ -99,6 +142,31 @@ extern "C"
         int isLoaded;
         /** */
         int isBigEndian;
+        /** Data shared by all decoders of this audio data. NULL until created by the first decoder.*/
+        kwlSharedDecoderData* sharedDecoderData;
+        /** 
+         * Decoded frames (interleaved, 16 bit) from the start of streamed audio data, played from
+         * memory while a starting decoder seeks past them and decodes its first buffer. 
+         * NULL if the audio data has no prefetch head.
+         */
+        short* prefetchHead;
+        /** The number of frames in \c prefetchHead.*/
+        int numPrefetchHeadFrames;
+        /** The number of channels in \c prefetchHead.*/
+        int numPrefetchHeadChannels;
+        /** 
+         * The residency state of audio data loaded on demand. Only accessed from the engine thread.
+         * The mixer only sees \c bytes, which is set once the audio data is resident.
+         */
+        kwlResidencyState residencyState;
+        /** The load reading the audio data into memory. Only valid while loading.*/
+        struct kwlStreamingIOLoad* residencyLoad;
+        /** The neighbours of the audio data in the list of loading or resident audio data of the engine.*/
+        struct kwlAudioData* residencyPrev;
+        /** @see residencyPrev*/
+        struct kwlAudioData* residencyNext;
+        /** Set to the current eviction pass of the engine while the audio data is used by a playing event.*/
+        int residencyUsePass;
     } kwlAudioData;
     
     /** Releasesa any resources associated with a given audio data instance.*/
@@ -109,6 +177,27 @@ extern "C"
      */
     int kwlAudioData_isLinearPCM(kwlAudioData* audioData);
     
+    /**
+     * Creates shared decoder data with a reference count of one.
+     * @param data The codec specific data.
+     * @param freeData A function that frees the codec specific data.
+     * @return The created shared decoder data.
+     */
+    kwlSharedDecoderData* kwlSharedDecoderData_create(void* data, void (*freeData)(void* data));
+    
+    /**
+     * Adds a reference to some shared decoder data.
+     * @param sharedData The shared decoder data.
+     */
+    void kwlSharedDecoderData_retain(kwlSharedDecoderData* sharedData);
+    
+    /**
+     * Removes a reference to some shared decoder data, freeing it
+     * if this was the last reference.
+     * @param sharedData The shared decoder data.
+     */
+    void kwlSharedDecoderData_release(kwlSharedDecoderData* sharedData);
+    
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
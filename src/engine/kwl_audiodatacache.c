@@ -0,0 +1,235 @@
+/*
+ Copyright (c) 2010-2012 Per Gantelius
+
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any damages
+ arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it
+ freely, subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented; you must not
+ claim that you wrote the original software. If you use this software
+ in a product, an acknowledgment in the product documentation would be
+ appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such, and must not be
+ misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#include "kwl_assert.h"
+#include "kwl_audiodatacache.h"
+#include "kwl_memory.h"
+
+/** Returns the bucket index of a given content hash.*/
+static int kwlAudioDataCache_getBucketIndex(kwlAudioDataCache* cache, unsigned long long contentHash)
+{
+    return (int)(contentHash % (unsigned long long)cache->numBuckets);
+}
+
+/** Moves the cached buffers to a new bucket array of a given size. Must be called with the cache lock held.*/
+static void kwlAudioDataCache_resizeBuckets(kwlAudioDataCache* cache, int numBuckets)
+{
+    kwlSharedAudioBuffer** oldBuckets = cache->buckets;
+    const int numOldBuckets = cache->numBuckets;
+    cache->buckets = (kwlSharedAudioBuffer**)KWL_MALLOCANDZERO(numBuckets * sizeof(kwlSharedAudioBuffer*), 
+                                                                KWL_MEMORY_CATEGORY_AUDIO_DATA, 
+                                                                "audio data cache buckets");
+    cache->numBuckets = numBuckets;
+    
+    for (int i = 0; i < numOldBuckets; i++)
+    {
+        kwlSharedAudioBuffer* buffer = oldBuckets[i];
+        while (buffer != NULL)
+        {
+            kwlSharedAudioBuffer* next = buffer->nextInBucket;
+            const int bucketIndex = kwlAudioDataCache_getBucketIndex(cache, buffer->contentHash);
+            buffer->nextInBucket = cache->buckets[bucketIndex];
+            cache->buckets[bucketIndex] = buffer;
+            buffer = next;
+        }
+    }
+    
+    KWL_FREE(oldBuckets);
+}
+
+/** Looks up a buffer without adding a reference. Must be called with the cache lock held.*/
+static kwlSharedAudioBuffer* kwlAudioDataCache_lookUp(kwlAudioDataCache* cache, 
+                                                      unsigned long long contentHash, 
+                                                      int numBytes)
+{
+    if (contentHash == 0)
+    {
+        return NULL;
+    }
+    
+    kwlSharedAudioBuffer* buffer = cache->buckets[kwlAudioDataCache_getBucketIndex(cache, contentHash)];
+    while (buffer != NULL)
+    {
+        if (buffer->contentHash == contentHash && buffer->numBytes == numBytes)
+        {
+            return buffer;
+        }
+        buffer = buffer->nextInBucket;
+    }
+    
+    return NULL;
+}
+
+void kwlAudioDataCache_init(kwlAudioDataCache* cache)
+{
+    kwlMemset(cache, 0, sizeof(kwlAudioDataCache));
+    kwlMutexLockInit(&cache->lock);
+    kwlAudioDataCache_resizeBuckets(cache, KWL_AUDIO_DATA_CACHE_MIN_NUM_BUCKETS);
+}
+
+void kwlAudioDataCache_free(kwlAudioDataCache* cache)
+{
+    KWL_ASSERT(cache->numBuffers == 0 && "audio data buffers are still referenced");
+    for (int i = 0; i < cache->numBuckets; i++)
+    {
+        KWL_ASSERT(cache->buckets[i] == NULL);
+    }
+    KWL_FREE(cache->buckets);
+    cache->buckets = NULL;
+    cache->numBuckets = 0;
+}
+
+kwlAudioDataCache* kwlAudioDataCache_new(void)
+{
+    kwlAudioDataCache* cache = (kwlAudioDataCache*)KWL_MALLOC(sizeof(kwlAudioDataCache), 
+                                                              KWL_MEMORY_CATEGORY_AUDIO_DATA, 
+                                                              "audio data cache");
+    kwlAudioDataCache_init(cache);
+    cache->refCount = 1;
+    return cache;
+}
+
+void kwlAudioDataCache_retain(kwlAudioDataCache* cache)
+{
+    kwlMutexLockAcquire(&cache->lock);
+    cache->refCount++;
+    kwlMutexLockRelease(&cache->lock);
+}
+
+void kwlAudioDataCache_release(kwlAudioDataCache* cache)
+{
+    kwlMutexLockAcquire(&cache->lock);
+    KWL_ASSERT(cache->refCount > 0);
+    const int refCount = --cache->refCount;
+    kwlMutexLockRelease(&cache->lock);
+    
+    if (refCount == 0)
+    {
+        kwlAudioDataCache_free(cache);
+        KWL_FREE(cache);
+    }
+}
+
+kwlSharedAudioBuffer* kwlAudioDataCache_findBuffer(kwlAudioDataCache* cache, 
+                                                   unsigned long long contentHash, 
+                                                   int numBytes)
+{
+    kwlMutexLockAcquire(&cache->lock);
+    kwlSharedAudioBuffer* buffer = kwlAudioDataCache_lookUp(cache, contentHash, numBytes);
+    if (buffer != NULL)
+    {
+        buffer->refCount++;
+    }
+    kwlMutexLockRelease(&cache->lock);
+    
+    return buffer;
+}
+
+kwlSharedAudioBuffer* kwlAudioDataCache_addBuffer(kwlAudioDataCache* cache,
+                                                  unsigned long long contentHash,
+                                                  int numBytes,
+                                                  void* bytes)
+{
+    kwlMutexLockAcquire(&cache->lock);
+    
+    kwlSharedAudioBuffer* buffer = kwlAudioDataCache_lookUp(cache, contentHash, numBytes);
+    if (buffer != NULL)
+    {
+        /*Someone else got there first.*/
+        buffer->refCount++;
+        kwlMutexLockRelease(&cache->lock);
+        KWL_FREE(bytes);
+        return buffer;
+    }
+    
+    buffer = (kwlSharedAudioBuffer*)KWL_MALLOC(sizeof(kwlSharedAudioBuffer), KWL_MEMORY_CATEGORY_AUDIO_DATA, "shared audio buffer");
+    buffer->contentHash = contentHash;
+    buffer->numBytes = numBytes;
+    buffer->bytes = bytes;
+    buffer->refCount = 1;
+    buffer->cache = cache;
+    buffer->nextInBucket = NULL;
+    
+    if (contentHash != 0)
+    {
+        if (cache->numCachedBuffers >= cache->numBuckets)
+        {
+            kwlAudioDataCache_resizeBuckets(cache, 2 * cache->numBuckets);
+        }
+        
+        const int bucketIndex = kwlAudioDataCache_getBucketIndex(cache, contentHash);
+        buffer->nextInBucket = cache->buckets[bucketIndex];
+        cache->buckets[bucketIndex] = buffer;
+        cache->numCachedBuffers++;
+    }
+    
+    cache->numBuffers++;
+    cache->numBytes += numBytes;
+    
+    kwlMutexLockRelease(&cache->lock);
+    
+    return buffer;
+}
+
+void kwlSharedAudioBuffer_retain(kwlSharedAudioBuffer* buffer)
+{
+    kwlMutexLockAcquire(&buffer->cache->lock);
+    KWL_ASSERT(buffer->refCount > 0);
+    buffer->refCount++;
+    kwlMutexLockRelease(&buffer->cache->lock);
+}
+
+void kwlSharedAudioBuffer_release(kwlSharedAudioBuffer* buffer)
+{
+    kwlAudioDataCache* cache = buffer->cache;
+    kwlMutexLockAcquire(&cache->lock);
+    
+    KWL_ASSERT(buffer->refCount > 0);
+    buffer->refCount--;
+    if (buffer->refCount > 0)
+    {
+        kwlMutexLockRelease(&cache->lock);
+        return;
+    }
+    
+    if (buffer->contentHash != 0)
+    {
+        kwlSharedAudioBuffer** link = &cache->buckets[kwlAudioDataCache_getBucketIndex(cache, buffer->contentHash)];
+        while (*link != buffer)
+        {
+            KWL_ASSERT(*link != NULL);
+            link = &(*link)->nextInBucket;
+        }
+        *link = buffer->nextInBucket;
+        cache->numCachedBuffers--;
+    }
+    
+    cache->numBuffers--;
+    cache->numBytes -= buffer->numBytes;
+    
+    kwlMutexLockRelease(&cache->lock);
+    
+    KWL_FREE(buffer->bytes);
+    KWL_FREE(buffer);
+}
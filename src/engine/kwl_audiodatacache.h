@@ -0,0 +1,164 @@
+/*
+ Copyright (c) 2010-2012 Per Gantelius
+
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any damages
+ arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it
+ freely, subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented; you must not
+ claim that you wrote the original software. If you use this software
+ in a product, an acknowledgment in the product documentation would be
+ appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such, and must not be
+ misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#ifndef KWL_AUDIO_DATA_CACHE_H
+#define KWL_AUDIO_DATA_CACHE_H
+
+/*! \file */
+
+#include "kwl_synchronization.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+/** 
+ * The initial number of hash buckets of an audio data cache. The number of buckets is doubled 
+ * whenever the cache holds more buffers than buckets.
+ */
+#define KWL_AUDIO_DATA_CACHE_MIN_NUM_BUCKETS 256
+
+struct kwlAudioDataCache;
+    
+/**
+ * A reference counted buffer of audio data bytes, shared by all wave bank entries with the same
+ * content and by all playing events using any of those entries. The buffer is freed when the
+ * last reference is released, so unloading a wave bank does not invalidate the audio data of
+ * events that are still playing it.
+ */
+typedef struct kwlSharedAudioBuffer
+{
+    /** The content hash written by the wave bank builder. 0 if the buffer is not in the cache.*/
+    unsigned long long contentHash;
+    /** The number of bytes in \c bytes.*/
+    int numBytes;
+    /** The audio data bytes. Owned by the buffer.*/
+    void* bytes;
+    /** The number of references. Protected by the cache lock.*/
+    int refCount;
+    /** The cache the buffer belongs to.*/
+    struct kwlAudioDataCache* cache;
+    /** The next buffer in the same hash bucket.*/
+    struct kwlSharedAudioBuffer* nextInBucket;
+} kwlSharedAudioBuffer;
+
+/**
+ * A hash table of the shared audio buffers of all loaded wave bank entries, keyed by content hash,
+ * so that identical audio data referenced by more than one wave bank is only held in memory once.
+ * Accessed from the engine thread and from wave bank loading threads. A cache may be shared by 
+ * several engines, which then hold identical audio data loaded by any of them once.
+ */
+typedef struct kwlAudioDataCache
+{
+    /** Singly linked lists of cached buffers, indexed by their content hash modulo the number of buckets.*/
+    kwlSharedAudioBuffer** buckets;
+    /** The number of entries in \c buckets.*/
+    int numBuckets;
+    /** The number of buffers in \c buckets.*/
+    int numCachedBuffers;
+    /** Protects the buckets and the reference counts of the buffers.*/
+    kwlMutexLock lock;
+    /** The number of live buffers, cached or not.*/
+    int numBuffers;
+    /** The total number of bytes held by live buffers.*/
+    int numBytes;
+    /** The number of engines using the cache. Protected by the cache lock.*/
+    int refCount;
+} kwlAudioDataCache;
+
+/**
+ * Initializes an empty audio data cache.
+ * @param cache The cache to initialize.
+ */
+void kwlAudioDataCache_init(kwlAudioDataCache* cache);
+
+/**
+ * Frees an audio data cache. All buffers must have been released.
+ * @param cache The cache to free.
+ */
+void kwlAudioDataCache_free(kwlAudioDataCache* cache);
+
+/**
+ * Creates an empty audio data cache, referenced by the caller.
+ * @return The new cache.
+ */
+kwlAudioDataCache* kwlAudioDataCache_new(void);
+
+/**
+ * Adds a reference to a cache created with \c kwlAudioDataCache_new.
+ * @param cache The cache.
+ */
+void kwlAudioDataCache_retain(kwlAudioDataCache* cache);
+
+/**
+ * Removes a reference to a cache created with \c kwlAudioDataCache_new, freeing
+ * it if this was the last reference. All buffers must have been released by then.
+ * @param cache The cache.
+ */
+void kwlAudioDataCache_release(kwlAudioDataCache* cache);
+
+/**
+ * Looks up a buffer with a given content hash and size.
+ * @param cache The cache.
+ * @param contentHash The content hash. 0 never matches.
+ * @param numBytes The size of the audio data in bytes.
+ * @return The buffer, with a reference added for the caller, or NULL if there is no such buffer.
+ */
+kwlSharedAudioBuffer* kwlAudioDataCache_findBuffer(kwlAudioDataCache* cache, 
+                                                   unsigned long long contentHash, 
+                                                   int numBytes);
+
+/**
+ * Creates a buffer from given audio data bytes and adds it to the cache. If a matching buffer 
+ * was added since the caller looked for one, the bytes are freed and that buffer is returned instead.
+ * @param cache The cache.
+ * @param contentHash The content hash of the bytes. 0 to create a buffer that is not cached.
+ * @param numBytes The number of bytes.
+ * @param bytes Audio data bytes allocated with KWL_MALLOC. Ownership is transferred to the cache.
+ * @return The buffer, with a reference held by the caller.
+ */
+kwlSharedAudioBuffer* kwlAudioDataCache_addBuffer(kwlAudioDataCache* cache,
+                                                  unsigned long long contentHash,
+                                                  int numBytes,
+                                                  void* bytes);
+
+/**
+ * Adds a reference to a given buffer.
+ * @param buffer The buffer.
+ */
+void kwlSharedAudioBuffer_retain(kwlSharedAudioBuffer* buffer);
+
+/**
+ * Removes a reference to a given buffer, removing it from its cache and freeing
+ * it if this was the last reference.
+ * @param buffer The buffer.
+ */
+void kwlSharedAudioBuffer_release(kwlSharedAudioBuffer* buffer);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /*KWL_AUDIO_DATA_CACHE_H*/
@@ -25,13 +25,34 @@
 #include "kwl_memory.h"
 
 #include "assert.h"
+#include <math.h>
+
+/** 
+ * Reads an 80 bit IEEE 754 extended precision float (big endian byte order),
+ * as used for AIFF sample rates.
+ */
+static double kwlReadExtendedFloatBE(kwlInputStream* stream)
+{
+    const int signAndExponent = kwlInputStream_readShortBE(stream) & 0xffff;
+    const unsigned int mantissaHi = (unsigned int)kwlInputStream_readIntBE(stream);
+    const unsigned int mantissaLo = (unsigned int)kwlInputStream_readIntBE(stream);
+    
+    const int exponent = (signAndExponent & 0x7fff) - 16383;
+    double value = ldexp((double)mantissaHi, exponent - 31) + ldexp((double)mantissaLo, exponent - 63);
+    if (mantissaHi == 0 && mantissaLo == 0)
+    {
+        value = 0.0;
+    }
+    
+    return (signAndExponent & 0x8000) != 0 ? -value : value;
+}
 
 static void* kwlAllocateBufferWithEntireStream(kwlInputStream* stream, int* fileSize)
 {
     kwlInputStream_seek(stream, 0, SEEK_END);
     *fileSize = kwlInputStream_tell(stream);
     KWL_ASSERT(*fileSize > 0);
-    signed char* buffer = (signed char*)KWL_MALLOC(*fileSize ,"entire file buffer");
+    signed char* buffer = (signed char*)KWL_MALLOC(*fileSize ,KWL_MEMORY_CATEGORY_AUDIO_DATA, "entire file buffer");
     kwlInputStream_seek(stream, 0, SEEK_SET);
     int readBytes = kwlInputStream_read(stream, buffer, *fileSize);
     KWL_ASSERT(readBytes == *fileSize);
@@ -39,33 +60,33 @@ static void* kwlAllocateBufferWithEntireStream(kwlInputStream* stream, int* file
     return buffer;
 }
 
-kwlError kwlLoadAudioFile(const char* path, kwlAudioData* audioData, kwlAudioDataLoadingMode mode)
+kwlError kwlLoadAudioFile(const char* path, const kwlFileSystem* fileSystem, kwlAudioData* audioData, kwlAudioDataLoadingMode mode)
 {
-    kwlError error = kwlLoadAIFF(path, audioData, mode);
+    kwlError error = kwlLoadAIFF(path, fileSystem, audioData, mode);
     if (error == KWL_NO_ERROR)
     {
         return error;
     }
     
-    error = kwlLoadAU(path, audioData, mode);
+    error = kwlLoadAU(path, fileSystem, audioData, mode);
     if (error == KWL_NO_ERROR)
     {
         return error;
     }
     
-    error = kwlLoadWAV(path, audioData, mode);
+    error = kwlLoadWAV(path, fileSystem, audioData, mode);
     if (error == KWL_NO_ERROR)
     {
         return error;
     }
     
-    error = kwlLoadOggVorbis(path, audioData, mode);
+    error = kwlLoadOggVorbis(path, fileSystem, audioData, mode);
     
     if (error != KWL_NO_ERROR)
     {
         audioData->encoding = KWL_ENCODING_UNKNOWN;
         kwlInputStream stream;
-        kwlError result = kwlInputStream_initWithFile(&stream, path);
+        kwlError result = kwlInputStream_initWithFile(&stream, path, fileSystem);
         if (result == KWL_NO_ERROR && mode == KWL_LOAD_ENTIRE_FILE)
         {
             audioData->bytes = kwlAllocateBufferWithEntireStream(&stream, &audioData->numBytes);
@@ -75,11 +96,11 @@ kwlError kwlLoadAudioFile(const char* path, kwlAudioData* audioData, kwlAudioDat
     return error;
 }
 
-kwlError kwlLoadAIFF(const char* path, kwlAudioData* audioData, kwlAudioDataLoadingMode mode)
+kwlError kwlLoadAIFF(const char* path, const kwlFileSystem* fileSystem, kwlAudioData* audioData, kwlAudioDataLoadingMode mode)
 {
     /* see http://www-mmsp.ece.mcgill.ca/Documents/AudioFormats/AIFF/Docs/AIFF-1.3.pdf */
     kwlInputStream stream;
-    kwlInputStream_initWithFile(&stream, path);
+    kwlInputStream_initWithFile(&stream, path, fileSystem);
     if (stream.file == NULL)
     {
         return KWL_FILE_NOT_FOUND;
@@ -147,8 +168,8 @@ kwlError kwlLoadAIFFFromStream(kwlInputStream* stream, kwlAudioData* audioData,
             numChannels = kwlInputStream_readShortBE(stream);
             numFrames = kwlInputStream_readIntBE(stream);
             sampleSize = kwlInputStream_readShortBE(stream);
-            /*Ignore the the sample rate for now, so skip those 10 bits.*/
-            kwlInputStream_skip(stream, chunkSize - (2 + 4 + 2));
+            audioData->sampleRate = (int)(kwlReadExtendedFloatBE(stream) + 0.5);
+            kwlInputStream_skip(stream, chunkSize - (2 + 4 + 2 + 10));
             commonChunkFound = 1;
             
             int unsupportedSampleSize = sampleSize != 8 &&
@@ -181,7 +202,7 @@ kwlError kwlLoadAIFFFromStream(kwlInputStream* stream, kwlAudioData* audioData,
             if (mode == KWL_CONVERT_TO_INT16_OR_FAIL)
             {
                 kwlInputStream_skip(stream, offset);
-                readSamples = KWL_MALLOC(dataSizeInBytes, "aiff audio data");
+                readSamples = KWL_MALLOC(dataSizeInBytes, KWL_MEMORY_CATEGORY_AUDIO_DATA, "aiff audio data");
                 kwlInputStream_read(stream, (signed char*)readSamples, dataSizeInBytes);
             }
             
@@ -259,10 +280,10 @@ kwlError kwlLoadAIFFFromStream(kwlInputStream* stream, kwlAudioData* audioData,
     return KWL_NO_ERROR;
 }
 
-kwlError kwlLoadWAV(const char* path, kwlAudioData* audioData, kwlAudioDataLoadingMode mode)
+kwlError kwlLoadWAV(const char* path, const kwlFileSystem* fileSystem, kwlAudioData* audioData, kwlAudioDataLoadingMode mode)
 {
     kwlInputStream stream;
-    kwlInputStream_initWithFile(&stream, path);
+    kwlInputStream_initWithFile(&stream, path, fileSystem);
     if (stream.file == NULL)
     {
         return KWL_FILE_NOT_FOUND;
@@ -315,6 +336,7 @@ static kwlError kwlLoadWAVFromStreamWithOptionalIMA4Params(kwlInputStream* strea
     int fmtChunkFound = 0;
     int dataChunkFound = 0;
     short numChannels = 0;
+    int sampleRate = 0;
     short nBlockAlign = 0;
     short audioFormat = 0;
     short bitsPerSample = 0;
@@ -333,7 +355,7 @@ static kwlError kwlLoadWAVFromStreamWithOptionalIMA4Params(kwlInputStream* strea
             const int chunkSize = kwlInputStream_readIntLE(stream);
             audioFormat = kwlInputStream_readShortLE(stream);
             numChannels = kwlInputStream_readShortLE(stream);
-            const int sampleRate = kwlInputStream_readIntLE(stream);
+            sampleRate = kwlInputStream_readIntLE(stream);
             const int  byteRate = kwlInputStream_readIntLE(stream);
             nBlockAlign = kwlInputStream_readShortLE(stream);
             if (nBlockAlignOut != NULL)
@@ -400,7 +422,7 @@ static kwlError kwlLoadWAVFromStreamWithOptionalIMA4Params(kwlInputStream* strea
             void* readSamples = NULL;
             if (mode == KWL_CONVERT_TO_INT16_OR_FAIL)
             {
-                readSamples = KWL_MALLOC(chunkSize, "read wav audio data");
+                readSamples = KWL_MALLOC(chunkSize, KWL_MEMORY_CATEGORY_AUDIO_DATA, "read wav audio data");
                 kwlInputStream_read(stream, (signed char*)readSamples, chunkSize);
             }
             else
@@ -454,6 +476,7 @@ static kwlError kwlLoadWAVFromStreamWithOptionalIMA4Params(kwlInputStream* strea
             audioData->isLoaded = mode != KWL_SKIP_AUDIO_DATA ? 1 : 0;
             audioData->streamFromDisk = 0;
             audioData->numChannels = numChannels;
+            audioData->sampleRate = sampleRate;
             audioData->waveBank = NULL;
             
             kwlInputStream_skip(stream, chunkSize); //TODO: remove?
@@ -501,10 +524,10 @@ kwlError kwlLoadIMAADPCMWAVMetadataFromStream(kwlInputStream* stream,
                                                       nBlockAlign);
 }
 
-kwlError kwlLoadAU(const char* path, kwlAudioData* audioData, kwlAudioDataLoadingMode mode)
+kwlError kwlLoadAU(const char* path, const kwlFileSystem* fileSystem, kwlAudioData* audioData, kwlAudioDataLoadingMode mode)
 {
     kwlInputStream stream;
-    kwlInputStream_initWithFile(&stream, path);
+    kwlInputStream_initWithFile(&stream, path, fileSystem);
     if (stream.file == NULL)
     {
         kwlInputStream_close(&stream);
@@ -589,7 +612,7 @@ kwlError kwlLoadAUFromStream(kwlInputStream* stream, kwlAudioData* audioData, kw
     
     if (mode == KWL_CONVERT_TO_INT16_OR_FAIL)
     {
-        void* readSamples = KWL_MALLOC(dataSizeInBytes, "read au audio data");
+        void* readSamples = KWL_MALLOC(dataSizeInBytes, KWL_MEMORY_CATEGORY_AUDIO_DATA, "read au audio data");
         kwlInputStream_read(stream, (signed char*)readSamples, dataSizeInBytes);
         finalSamples = kwlConvertBufferTo16BitSigned((char*)readSamples,
                                                      dataSizeInBytes,
@@ -613,6 +636,7 @@ kwlError kwlLoadAUFromStream(kwlInputStream* stream, kwlAudioData* audioData, kw
     
     audioData->numFrames = numSamples / numChannels;
     audioData->numChannels = numChannels;
+    audioData->sampleRate = sampleRate;
     audioData->numBytes = numSamples * 2;
     audioData->bytes = finalSamples;
     audioData->isLoaded = mode != KWL_SKIP_AUDIO_DATA ? 1 : 0;
@@ -620,12 +644,12 @@ kwlError kwlLoadAUFromStream(kwlInputStream* stream, kwlAudioData* audioData, kw
     return KWL_NO_ERROR;
 }
 
-kwlError kwlLoadOggVorbis(const char* path, kwlAudioData* audioData, kwlAudioDataLoadingMode mode)
+kwlError kwlLoadOggVorbis(const char* path, const kwlFileSystem* fileSystem, kwlAudioData* audioData, kwlAudioDataLoadingMode mode)
 {
     kwlMemset(audioData, 0, sizeof(kwlAudioData));
     
     kwlInputStream stream;
-    kwlInputStream_initWithFile(&stream, path);
+    kwlInputStream_initWithFile(&stream, path, fileSystem);
     if (stream.file == NULL)
     {
         return KWL_FILE_NOT_FOUND;
@@ -681,6 +705,7 @@ kwlError kwlLoadOggVorbis(const char* path, kwlAudioData* audioData, kwlAudioDat
         
         if (!isVorbis)
         {
+            kwlInputStream_close(&stream);
             return KWL_UNKNOWN_FILE_FORMAT;
         }
         
@@ -695,6 +720,7 @@ kwlError kwlLoadOggVorbis(const char* path, kwlAudioData* audioData, kwlAudioDat
     
     audioData->encoding = KWL_ENCODING_VORBIS;
     audioData->numChannels = numChannels;
+    audioData->sampleRate = (int)sampleRate;
     audioData->numFrames = 0;
     
     if (mode == KWL_SKIP_AUDIO_DATA)
@@ -745,7 +771,7 @@ short* kwlConvertBufferTo16BitSigned(char* inBuffer,
     const int numSamples = inBufferSizeInBytes / bytesPerSample;
     *outBufferSizeInBytes = numSamples * 2;
     short* outBuffer = inBufferEncoding == KWL_ENCODING_SIGNED_16BIT_PCM ? (short*)inBuffer :
-    (short*)KWL_MALLOC(*outBufferSizeInBytes, "converted audio buffer");
+    (short*)KWL_MALLOC(*outBufferSizeInBytes, KWL_MEMORY_CATEGORY_AUDIO_DATA, "converted audio buffer");
     
     switch (inBufferEncoding)
     {
@@ -27,6 +27,7 @@ freely, subject to the following restrictions:
 /*! \file */ 
 
 #include "kwl_audiodata.h"
+#include "kwl_filesystem.h"
 #include "kowalski.h"
 
 #ifdef __cplusplus
@@ -52,9 +53,10 @@ typedef enum  {
 /** 
  * Loads PCM data from an AIFF file.
  * @param path The path of the file to load.
+ * @param fileSystem The file system to read the file through. NULL for the default file system.
  * @param audioData A kwlAudioData struct to load the file into.
  */
-kwlError kwlLoadAIFF(const char* path, kwlAudioData* audioData, kwlAudioDataLoadingMode mode);
+kwlError kwlLoadAIFF(const char* path, const kwlFileSystem* fileSystem, kwlAudioData* audioData, kwlAudioDataLoadingMode mode);
     
 /**
  * Loads AIFF PCM data from input stream and advances the input stream read position
@@ -70,9 +72,10 @@ kwlError kwlLoadAIFFFromStream(kwlInputStream* stream, kwlAudioData* audioData,
 /** 
  * Loads PCM data from an WAV file.
  * @param path The path of the file to load.
+ * @param fileSystem The file system to read the file through. NULL for the default file system.
  * @param audioData A kwlAudioData struct to load the file into.
  */
-kwlError kwlLoadWAV(const char* path, kwlAudioData* audioData, kwlAudioDataLoadingMode mode);
+kwlError kwlLoadWAV(const char* path, const kwlFileSystem* fileSystem, kwlAudioData* audioData, kwlAudioDataLoadingMode mode);
     
 /**
  * Loads WAV PCM data from input stream and advances the input stream read position
@@ -88,9 +91,10 @@ kwlError kwlLoadWAVFromStream(kwlInputStream* stream, kwlAudioData* audioData, k
 /** 
  * Loads PCM data from an AU file.
  * @param path The path of the file to load.
+ * @param fileSystem The file system to read the file through. NULL for the default file system.
  * @param audioData A kwlAudioData struct to load the file into.
  */
-kwlError kwlLoadAU(const char* path, kwlAudioData* audioData, kwlAudioDataLoadingMode mode);
+kwlError kwlLoadAU(const char* path, const kwlFileSystem* fileSystem, kwlAudioData* audioData, kwlAudioDataLoadingMode mode);
 
 /**
  * Loads WAV PCM data from input stream and advances the input stream read position
@@ -106,16 +110,18 @@ kwlError kwlLoadAUFromStream(kwlInputStream* stream, kwlAudioData* audioData, kw
 /** 
  * Loads vorbis data from an OGG file.
  * @param path The path of the file to load.
+ * @param fileSystem The file system to read the file through. NULL for the default file system.
  * @param audioData A kwlAudioData struct to load the file into.
  */
-kwlError kwlLoadOggVorbis(const char* path, kwlAudioData* audioData, kwlAudioDataLoadingMode mode);
+kwlError kwlLoadOggVorbis(const char* path, const kwlFileSystem* fileSystem, kwlAudioData* audioData, kwlAudioDataLoadingMode mode);
     
 /** 
  * Loads audio data from a given audio file.
  * @param path The path of the file to load.
+ * @param fileSystem The file system to read the file through. NULL for the default file system.
  * @param audioData A kwlAudioData struct to load the file into.
  */
-kwlError kwlLoadAudioFile(const char* path, kwlAudioData* audioData, kwlAudioDataLoadingMode mode);
+kwlError kwlLoadAudioFile(const char* path, const kwlFileSystem* fileSystem, kwlAudioData* audioData, kwlAudioDataLoadingMode mode);
     
 short* kwlConvertBufferTo16BitSigned(char* inBuffer, 
                                      int inBufferSizeInBytes,
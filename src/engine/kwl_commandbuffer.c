@@ -0,0 +1,113 @@
+/*
+ Copyright (c) 2010-2012 Per Gantelius
+
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any damages
+ arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it
+ freely, subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented; you must not
+ claim that you wrote the original software. If you use this software
+ in a product, an acknowledgment in the product documentation would be
+ appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such, and must not be
+ misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+
+#include "kwl_assert.h"
+#include "kwl_commandbuffer.h"
+#include "kwl_memory.h"
+#include "kwl_synchronization.h"
+
+void kwlCommandBuffer_init(kwlCommandBuffer* buffer, struct kwlEngine* engine, int capacity)
+{
+    KWL_ASSERT(capacity > 0);
+    kwlMemset(buffer, 0, sizeof(kwlCommandBuffer));
+    buffer->engine = engine;
+    /*one slot is kept free to tell a full buffer from an empty one*/
+    buffer->numSlots = capacity + 1;
+    buffer->commands = (kwlCommand*)KWL_MALLOC(buffer->numSlots * sizeof(kwlCommand), 
+                                               KWL_MEMORY_CATEGORY_GENERAL, 
+                                               "command buffer");
+}
+
+void kwlCommandBuffer_free(kwlCommandBuffer* buffer)
+{
+    KWL_FREE(buffer->commands);
+    buffer->commands = NULL;
+    buffer->numSlots = 0;
+}
+
+kwlCommand* kwlCommandBuffer_addCommand(kwlCommandBuffer* buffer, kwlCommandType type, kwlEventHandle handle)
+{
+    KWL_ASSERT(buffer != NULL);
+    const int writeIndex = buffer->writeIndex;
+    const int nextWriteIndex = writeIndex + 1 == buffer->numSlots ? 0 : writeIndex + 1;
+    if (nextWriteIndex == buffer->cachedReadIndex)
+    {
+        /*the buffer looks full. see how far the engine thread has come before giving up.*/
+        buffer->cachedReadIndex = kwlAtomicLoad(&buffer->readIndex);
+        if (nextWriteIndex == buffer->cachedReadIndex)
+        {
+            if (buffer->recordError == KWL_NO_ERROR)
+            {
+                buffer->recordError = KWL_COMMAND_BUFFER_FULL;
+            }
+            return NULL;
+        }
+    }
+    
+    kwlCommand* command = &buffer->commands[writeIndex];
+    command->type = type;
+    command->handle = handle;
+    buffer->writeIndex = nextWriteIndex;
+    return command;
+}
+
+void kwlCommandBuffer_submit(kwlCommandBuffer* buffer)
+{
+    kwlAtomicStore(&buffer->submittedIndex, buffer->writeIndex);
+}
+
+void kwlCommandBuffer_getPendingCommands(kwlCommandBuffer* buffer, int* firstIndex, int* endIndex)
+{
+    *firstIndex = kwlAtomicLoad(&buffer->readIndex);
+    *endIndex = kwlAtomicLoad(&buffer->submittedIndex);
+}
+
+void kwlCommandBuffer_setExecuted(kwlCommandBuffer* buffer, int endIndex)
+{
+    kwlAtomicStore(&buffer->readIndex, endIndex);
+}
+
+void kwlCommandBuffer_setExecuteError(kwlCommandBuffer* buffer, kwlError error)
+{
+    if (error != KWL_NO_ERROR)
+    {
+        kwlAtomicCompareAndSwap(&buffer->executeError, KWL_NO_ERROR, error);
+    }
+}
+
+kwlError kwlCommandBuffer_getError(kwlCommandBuffer* buffer)
+{
+    kwlError error = buffer->recordError;
+    buffer->recordError = KWL_NO_ERROR;
+    
+    /*take the execution error, leaving room for the next one*/
+    const int executeError = kwlAtomicLoad(&buffer->executeError);
+    if (executeError != KWL_NO_ERROR)
+    {
+        kwlAtomicCompareAndSwap(&buffer->executeError, executeError, KWL_NO_ERROR);
+    }
+    
+    return error != KWL_NO_ERROR ? error : (kwlError)executeError;
+}
@@ -0,0 +1,179 @@
+/*
+ Copyright (c) 2010-2012 Per Gantelius
+
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any damages
+ arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it
+ freely, subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented; you must not
+ claim that you wrote the original software. If you use this software
+ in a product, an acknowledgment in the product documentation would be
+ appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such, and must not be
+ misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#ifndef KWL_COMMAND_BUFFER_H
+#define KWL_COMMAND_BUFFER_H
+
+/*! \file */
+
+#include "kowalski.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+struct kwlEngine;
+    
+/** The types of commands that can be recorded into a command buffer.*/
+typedef enum kwlCommandType
+{
+    KWL_COMMAND_EVENT_START = 0,
+    KWL_COMMAND_EVENT_STOP,
+    KWL_COMMAND_EVENT_PAUSE,
+    KWL_COMMAND_EVENT_RESUME,
+    KWL_COMMAND_EVENT_RELEASE,
+    KWL_COMMAND_EVENT_START_ONE_SHOT,
+    KWL_COMMAND_EVENT_START_ONE_SHOT_AT,
+    KWL_COMMAND_EVENT_SET_GAIN,
+    KWL_COMMAND_EVENT_SET_LINEAR_GAIN,
+    KWL_COMMAND_EVENT_SET_PITCH,
+    KWL_COMMAND_EVENT_SET_BALANCE,
+    KWL_COMMAND_EVENT_SET_POSITION,
+    KWL_COMMAND_EVENT_SET_VELOCITY,
+    KWL_COMMAND_EVENT_SET_ORIENTATION,
+    KWL_COMMAND_LISTENER_SET_POSITION,
+    KWL_COMMAND_LISTENER_SET_VELOCITY,
+    KWL_COMMAND_LISTENER_SET_ORIENTATION,
+    KWL_COMMAND_MIX_BUS_SET_GAIN,
+    KWL_COMMAND_MIX_BUS_SET_LINEAR_GAIN,
+    KWL_COMMAND_MIX_BUS_SET_PITCH,
+    KWL_COMMAND_MIX_PRESET_SET,
+    KWL_COMMAND_MIX_PRESET_FADE_TO
+} kwlCommandType;
+
+/** A recorded call to one of the setters of the public API.*/
+typedef struct kwlCommand
+{
+    /** The type of the command.*/
+    kwlCommandType type;
+    /** The event, event definition, mix bus or mix preset handle the command applies to.*/
+    kwlEventHandle handle;
+    /** The float arguments of the command, for example a gain, a fade time or a position.*/
+    float params[6];
+} kwlCommand;
+
+/**
+ * A single producer, single consumer ring buffer of commands, recorded on one 
+ * application thread and executed on the engine thread. Recording does not lock 
+ * or use atomic operations; recorded commands are published to the engine thread 
+ * in batches by \c kwlCommandBuffer_submit.
+ */
+typedef struct kwlCommandBuffer
+{
+    /** The engine executing the commands.*/
+    struct kwlEngine* engine;
+    /** The ring buffer of commands, with one slot more than the capacity.*/
+    kwlCommand* commands;
+    /** The number of slots in \c commands.*/
+    int numSlots;
+    
+    /** The slot to record the next command into. Only accessed by the producer.*/
+    int writeIndex;
+    /** The most recently read value of \c readIndex. Only accessed by the producer.*/
+    int cachedReadIndex;
+    /** The first error of recording commands. Only accessed by the producer.*/
+    kwlError recordError;
+    /** Keeps the fields written by the producer and by the engine thread on different cache lines.*/
+    char padding[64];
+    
+    /** The slot following the last submitted command. Written by the producer, accessed atomically.*/
+    volatile int submittedIndex;
+    /** The slot of the next command to execute. Written by the engine thread, accessed atomically.*/
+    volatile int readIndex;
+    /** The first error of executing commands. Accessed atomically.*/
+    volatile int executeError;
+    
+    /** The next command buffer of the engine, in creation order.*/
+    struct kwlCommandBuffer* next;
+} kwlCommandBuffer;
+
+/**
+ * Initializes a command buffer.
+ * @param buffer The buffer to initialize.
+ * @param engine The engine executing the commands.
+ * @param capacity The maximum number of recorded commands not yet executed.
+ */
+void kwlCommandBuffer_init(kwlCommandBuffer* buffer, struct kwlEngine* engine, int capacity);
+
+/**
+ * Releases the commands of a command buffer.
+ * @param buffer The buffer.
+ */
+void kwlCommandBuffer_free(kwlCommandBuffer* buffer);
+
+/**
+ * Adds a command to a command buffer. Called by the producer. The returned command 
+ * may be filled in until the buffer is submitted.
+ * @param buffer The buffer.
+ * @param type The type of the command.
+ * @param handle The handle the command applies to.
+ * @return The added command, or NULL if the buffer is full, in which 
+ * case \c KWL_COMMAND_BUFFER_FULL is recorded as the error of the buffer.
+ */
+kwlCommand* kwlCommandBuffer_addCommand(kwlCommandBuffer* buffer, kwlCommandType type, kwlEventHandle handle);
+
+/**
+ * Makes all commands added since the previous submit available to the engine thread. 
+ * Called by the producer.
+ * @param buffer The buffer.
+ */
+void kwlCommandBuffer_submit(kwlCommandBuffer* buffer);
+
+/**
+ * Returns the submitted commands that have not been executed yet. Called by the engine thread.
+ * Commands from the slot \c *firstIndex up to, but not including, the slot \c *endIndex are
+ * pending, wrapping around at the end of the ring buffer.
+ * @param buffer The buffer.
+ * @param firstIndex Receives the slot of the first pending command.
+ * @param endIndex Receives the slot following the last pending command.
+ */
+void kwlCommandBuffer_getPendingCommands(kwlCommandBuffer* buffer, int* firstIndex, int* endIndex);
+
+/**
+ * Frees the slots of executed commands for recording. Called by the engine thread.
+ * @param buffer The buffer.
+ * @param endIndex The slot following the last executed command.
+ */
+void kwlCommandBuffer_setExecuted(kwlCommandBuffer* buffer, int endIndex);
+
+/**
+ * Records the error of an executed command, unless an earlier error has not been read yet.
+ * Called by the engine thread.
+ * @param buffer The buffer.
+ * @param error The error.
+ */
+void kwlCommandBuffer_setExecuteError(kwlCommandBuffer* buffer, kwlError error);
+
+/**
+ * Returns and clears the first error of recording or executing commands. Called by the producer.
+ * @param buffer The buffer.
+ */
+kwlError kwlCommandBuffer_getError(kwlCommandBuffer* buffer);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /*KWL_COMMAND_BUFFER_H*/
@@ -30,6 +30,7 @@ freely, subject to the following restrictions:
 #include "kwl_decoder_ios.h"
 #endif /*KWL_IPHONE*/
 #include "kwl_decoder_oggvorbis.h"
+#include "kwl_engine.h"
 #include "kwl_memory.h"
 
 static void kwlDecoder_swapBuffers(kwlDecoder* decoder)
@@ -39,37 +40,45 @@ static void kwlDecoder_swapBuffers(kwlDecoder* decoder)
     decoder->currentDecodedBuffer = temp;
 }
 
-kwlError kwlDecoder_init(kwlDecoder* decoder, kwlEventInstance* event)
+/**
+ * Decodes a new buffer into the back buffer and swaps buffers. If the end of
+ * the audio data was reached, the decoder is either rewound or flagged as done.
+ * @return Non-zero if the end of the audio data was reached.
+ */
+static int kwlDecoder_decodeAndSwapBuffers(kwlDecoder* decoder)
 {
-    kwlAudioData* audioData = event->definition_engine->streamAudioData;
-    /*reset the decoder struct.*/
-    kwlMemset(decoder, 0, sizeof(kwlDecoder));
+    int endOfData = decoder->decodeBuffer(decoder);
     
-    decoder->loop = event->definition_engine->loopIfStreaming;
+    kwlDecoder_swapBuffers(decoder);
     
-    /*
-     * Hook up audio data, that could either be from a file or from an already loaded buffer
-     */
-    if (audioData->streamFromDisk != 0)
+    if (endOfData != 0)
     {
-        KWL_ASSERT(audioData->fileOffset >= 0);
-        kwlError result = kwlInputStream_initWithFileRegion(&decoder->audioDataStream,
-                                                            audioData->waveBank->waveBankFilePath,
-                                                            audioData->fileOffset,
-                                                            audioData->numBytes);
-        KWL_ASSERT(result == KWL_NO_ERROR);
-    }
-    else
-    {   
-        kwlInputStream_initWithBuffer(&decoder->audioDataStream,
-                                      audioData->bytes,
-                                      0, 
-                                      audioData->numBytes);
+        if (decoder->loop == 0)
+        {
+            decoder->threadJoinRequested = 1;
+        }
+        else
+        {
+            /*This is a looping decoder. Try to rewind the stream*/
+            int rewindResult = decoder->rewind(decoder);
+            if (rewindResult == 0)
+            {
+                /*rewind failed, stop playing*/
+                decoder->threadJoinRequested = 1;
+            }
+        }
     }
     
-    /*
-     * do codec specific initialization.
-     */
+    return endOfData;
+}
+
+/**
+ * Performs codec specific initialization of a decoder whose audio data and
+ * input stream have been set.
+ */
+static kwlError kwlDecoder_initCodec(kwlDecoder* decoder)
+{
+    kwlAudioData* audioData = decoder->audioData;
     kwlError result = KWL_UNSUPPORTED_ENCODING;
     
     if (audioData->encoding == KWL_ENCODING_IMA_ADPCM)
@@ -92,35 +101,141 @@ kwlError kwlDecoder_init(kwlDecoder* decoder, kwlEventInstance* event)
     }
     #endif /*KWL_IPHONE*/
     
+    return result;
+}
+
+int kwlDecoder_canDecodeInline(kwlAudioData* audioData)
+{
+    return audioData->streamFromDisk == 0 && 
+           audioData->encoding == KWL_ENCODING_IMA_ADPCM;
+}
+
+kwlError kwlDecoder_init(kwlDecoder* decoder, 
+                         kwlEventInstance* event, 
+                         kwlStreamingIO* streamingIO,
+                         int decodeOnMixerThread,
+                         const kwlEngineConfig* config)
+{
+    kwlAudioData* audioData = event->definition_engine->streamAudioData;
+    /*reset the decoder struct.*/
+    kwlMemset(decoder, 0, sizeof(kwlDecoder));
+    
+    decoder->config = config;
+    decoder->decodeInline = decodeOnMixerThread != 0 || kwlDecoder_canDecodeInline(audioData);
+    decoder->audioData = audioData;
+    
+    decoder->loop = event->definition_engine->loopIfStreaming;
+    decoder->loopStart = audioData->loopStart;
+    decoder->loopEnd = audioData->loopEnd;
+    /*codecs may override this with the sample rate found in the encoded data.*/
+    decoder->sampleRate = audioData->sampleRate;
+    
+    /*
+     * Hook up audio data, that could either be from a file or from an already loaded buffer
+     */
+    if (audioData->streamFromDisk != 0)
+    {
+        /*read the file region through the streaming I/O service, using the file the wave bank keeps open.*/
+        KWL_ASSERT(audioData->fileOffset >= 0);
+        kwlError result = kwlStreamingIO_openStream(streamingIO,
+                                                    audioData->waveBank->streamingFile,
+                                                    audioData->fileOffset,
+                                                    audioData->numBytes,
+                                                    &decoder->ioStream);
+        if (result != KWL_NO_ERROR)
+        {
+            return result;
+        }
+        decoder->streamingIO = streamingIO;
+        kwlInputStream_initWithReadFunction(&decoder->audioDataStream,
+                                            kwlStreamingIO_read,
+                                            decoder->ioStream,
+                                            audioData->fileOffset,
+                                            audioData->numBytes);
+    }
+    else
+    {   
+        kwlInputStream_initWithBuffer(&decoder->audioDataStream,
+                                      audioData->bytes,
+                                      0, 
+                                      audioData->numBytes);
+    }
+    
+    /*
+     * do codec specific initialization.
+     */
+    kwlError result = kwlDecoder_initCodec(decoder);
+    
     if (result != KWL_NO_ERROR)
     {
         decoder->deinit(decoder);
+        kwlInputStream_close(&decoder->audioDataStream);
+        if (decoder->ioStream != NULL)
+        {
+            kwlStreamingIO_closeStream(decoder->streamingIO, decoder->ioStream);
+            decoder->ioStream = NULL;
+        }
         return result;
     }
     
     KWL_ASSERT(decoder->numChannels > 0);
     
+    if (decoder->ioStream != NULL)
+    {
+        /*size the read-ahead window by the bitrate found by the codec*/
+        kwlStreamingIO_setStreamBytesPerSecond(decoder->streamingIO, decoder->ioStream, decoder->bytesPerSecond);
+    }
+    
     decoder->currentDecodedBuffer = 
-        (short*)KWL_MALLOC(sizeof(short) * decoder->maxDecodedBufferSize, "decoder back buffer");
+        (short*)KWL_MALLOC(sizeof(short) * decoder->maxDecodedBufferSize, KWL_MEMORY_CATEGORY_DECODER, "decoder back buffer");
     decoder->currentDecodedBufferFront = 
-        (short*)KWL_MALLOC(sizeof(short) * decoder->maxDecodedBufferSize, "decoder front buffer");
+        (short*)KWL_MALLOC(sizeof(short) * decoder->maxDecodedBufferSize, KWL_MEMORY_CATEGORY_DECODER, "decoder front buffer");
     decoder->currentDecodedBufferSizeInBytes = 0;
     
-    /*
-     * Before starting the decoding thread, call the decode function 
-     * synchronously to get the first buffer of decoded samples.
-     */
-    int decodingResult = decoder->decodeBuffer(decoder);
-    
-    kwlDecoder_swapBuffers(decoder);
-    
-    /*TODO: check the decoding result. the event could be done playing here.*/
+    if (audioData->prefetchHead != NULL && 
+        audioData->numPrefetchHeadChannels == decoder->numChannels &&
+        decoder->seek != NULL && 
+        decoder->decodeInline == 0)
+    {
+        /*
+         * Start playing the prefetch head from memory. The decoding thread seeks 
+         * to the end of the head and decodes the first buffer meanwhile.
+         */
+        decoder->startFrame = audioData->numPrefetchHeadFrames;
+        decoder->isDecoding = 1;
+        event->currentPCMBuffer = audioData->prefetchHead;
+        event->currentPCMBufferSize = audioData->numPrefetchHeadFrames;
+    }
+    else
+    {
+        /*
+         * Before starting the decoding thread, call the decode function 
+         * synchronously to get the first buffer of decoded samples.
+         */
+        if (decoder->decodeInline != 0)
+        {
+            kwlDecoder_decodeAndSwapBuffers(decoder);
+        }
+        else
+        {
+            decoder->decodeBuffer(decoder);
+            kwlDecoder_swapBuffers(decoder);
+        }
+        
+        /*TODO: check the decoding result. the event could be done playing here.*/
+        event->currentPCMBuffer = decoder->currentDecodedBufferFront;
+        event->currentPCMBufferSize = decoder->currentDecodedBufferSizeInBytes / (2 * decoder->numChannels);
+    }
     event->currentPCMFrameIndex = 0;
-    event->currentPCMBuffer = decoder->currentDecodedBufferFront;
-    event->currentPCMBufferSize = decoder->currentDecodedBufferSizeInBytes / (2 * decoder->numChannels);
     
     event->currentNumChannels = decoder->numChannels;
+    event->currentSampleRate = decoder->sampleRate;
     
+    if (decoder->decodeInline != 0)
+    {
+        /*subsequent buffers are decoded by the mixer when needed.*/
+        return result;
+    }
     
     /*Create a semaphore with a unique name based on the addess of the decoder*/
     sprintf(decoder->semaphoreName, "decoder%d", (int)decoder);
@@ -135,13 +250,16 @@ kwlError kwlDecoder_init(kwlDecoder* decoder, kwlEventInstance* event)
 
 void kwlDecoder_deinit(kwlDecoder* decoder)
 {
-    /*Shut down the decoder.*/
-    decoder->threadJoinRequested = 1;
-    kwlSemaphorePost(decoder->semaphore);
-    kwlThreadJoin(&decoder->decodingThread);
-    
-    /*Dispose of the semaphore.*/
-    kwlSemaphoreDestroy(decoder->semaphore, decoder->semaphoreName);
+    if (decoder->decodeInline == 0)
+    {
+        /*Shut down the decoder.*/
+        decoder->threadJoinRequested = 1;
+        kwlSemaphorePost(decoder->semaphore);
+        kwlThreadJoin(&decoder->decodingThread);
+        
+        /*Dispose of the semaphore.*/
+        kwlSemaphoreDestroy(decoder->semaphore, decoder->semaphoreName);
+    }
     
     /*Free back and front buffers.*/
     KWL_FREE(decoder->currentDecodedBuffer);
@@ -153,6 +271,12 @@ void kwlDecoder_deinit(kwlDecoder* decoder)
     /*Codec specific cleanup.*/
     decoder->deinit(decoder);
     
+    if (decoder->ioStream != NULL)
+    {
+        kwlStreamingIO_closeStream(decoder->streamingIO, decoder->ioStream);
+        decoder->ioStream = NULL;
+    }
+    
     decoder->codecData = NULL;
 }
 
@@ -171,29 +295,21 @@ void* kwlDecoder_decodingLoop(void* data)
             return NULL;
         }
         decoder->isDecoding = 1;
-        int endOfData = decoder->decodeBuffer(decoder);
-        
-        kwlDecoder_swapBuffers(decoder);
-        
-        decoder->isDecoding = 0;
-        
-        if (endOfData != 0)
+        if (decoder->startFrame > 0)
         {
-            if (decoder->loop == 0)
+            /*resume decoding where the prefetch head ends.*/
+            const int seekResult = decoder->seek(decoder, decoder->startFrame);
+            decoder->startFrame = 0;
+            if (seekResult == 0)
             {
+                decoder->currentDecodedBufferSizeInBytes = 0;
                 decoder->threadJoinRequested = 1;
-            }
-            else
-            {
-                /*This is a looping decoder. Try to rewind the stream*/
-                int rewindResult = decoder->rewind(decoder);
-                if (rewindResult == 0)
-                {
-                    /*rewind failed, stop playing*/
-                    decoder->threadJoinRequested = 1;
-                }
+                decoder->isDecoding = 0;
+                return NULL;
             }
         }
+        kwlDecoder_decodeAndSwapBuffers(decoder);
+        decoder->isDecoding = 0;
         
         //printf("decoded buffer, result %d. waiting for semaphore...\n", decoder->threadJoinRequested);
         if (decoder->threadJoinRequested != 0)
@@ -208,6 +324,22 @@ void* kwlDecoder_decodingLoop(void* data)
 
 int kwlDecoder_decodeNewBufferForEvent(kwlDecoder* decoder, kwlEventInstance* event)
 {
+    if (decoder->decodeInline != 0)
+    {
+        if (decoder->threadJoinRequested != 0)
+        {
+            /*the buffer that just finished playing was the last one.*/
+            return 1;
+        }
+        kwlDecoder_decodeAndSwapBuffers(decoder);
+        
+        event->currentPCMBuffer = decoder->currentDecodedBufferFront;
+        event->currentPCMFrameIndex = event->currentPCMFrameIndex - event->currentPCMBufferSize;
+        KWL_ASSERT(event->currentPCMFrameIndex >= 0);
+        event->currentPCMBufferSize = decoder->currentDecodedBufferSizeInBytes / (2 * decoder->numChannels);
+        return 0;
+    }
+    
     if (decoder->isDecoding)
     {
         printf("still decoding, missed buffer!\n");
@@ -222,8 +354,115 @@ int kwlDecoder_decodeNewBufferForEvent(kwlDecoder* decoder, kwlEventInstance* ev
     
     event->currentPCMBufferSize = decoder->currentDecodedBufferSizeInBytes / (2 * decoder->numChannels);
     event->currentNumChannels = decoder->numChannels;
+    event->currentSampleRate = decoder->sampleRate;
     
+    /*sample the end flag before waking up the decoding thread, since it may
+      otherwise reach the end while decoding the next buffer and make this one look like the last.*/
+    const int isLastBuffer = decoder->threadJoinRequested;
+    
+    /*flag the decoder as busy before waking it up, so that a buffer request
+      arriving before the decoding thread is scheduled is not handed the stale front buffer.*/
+    decoder->isDecoding = 1;
     kwlSemaphorePost(decoder->semaphore);
     //printf("assigned front buffer %d\n", (int)decoder->currentDecodedBufferFront);
-    return decoder->threadJoinRequested; //TODO: proper return value
+    return isLastBuffer;
+}
+
+kwlError kwlDecoder_createPrefetchHead(kwlAudioData* audioData,
+                                       const char* const path,
+                                       const kwlFileSystem* fileSystem,
+                                       int numMilliseconds)
+{
+    KWL_ASSERT(audioData->streamFromDisk != 0);
+    KWL_ASSERT(audioData->prefetchHead == NULL);
+    
+    /*the head is decoded once, when the wave bank is loaded, so it is decoded with the default buffer sizes.*/
+    kwlEngineConfig config;
+    kwlEngine_getDefaultConfig(&config);
+    
+    kwlDecoder decoder;
+    kwlMemset(&decoder, 0, sizeof(kwlDecoder));
+    decoder.config = &config;
+    decoder.audioData = audioData;
+    decoder.sampleRate = audioData->sampleRate;
+    
+    kwlError result = kwlInputStream_initWithFileRegion(&decoder.audioDataStream,
+                                                        path,
+                                                        fileSystem,
+                                                        audioData->fileOffset,
+                                                        audioData->numBytes);
+    if (result != KWL_NO_ERROR)
+    {
+        return result;
+    }
+    
+    result = kwlDecoder_initCodec(&decoder);
+    if (result != KWL_NO_ERROR)
+    {
+        kwlInputStream_close(&decoder.audioDataStream);
+        return result;
+    }
+    
+    const int numChannels = decoder.numChannels;
+    int numFrames = (int)((long long)numMilliseconds * decoder.sampleRate / 1000);
+    if (audioData->loopEnd > 0 && numFrames > audioData->loopEnd)
+    {
+        /*keep the head within the loop region.*/
+        numFrames = audioData->loopEnd;
+    }
+    
+    decoder.currentDecodedBuffer = 
+        (short*)KWL_MALLOC(sizeof(short) * decoder.maxDecodedBufferSize, KWL_MEMORY_CATEGORY_DECODER, "prefetch head decoder buffer");
+    short* head = NULL;
+    int numHeadFrames = 0;
+    
+    /*a decoder that can not seek can not resume after the head.*/
+    while (decoder.seek != NULL && numHeadFrames < numFrames)
+    {
+        const int endOfData = decoder.decodeBuffer(&decoder);
+        const int numDecodedFrames = decoder.currentDecodedBufferSizeInBytes / (2 * numChannels);
+        
+        if (audioData->encoding == KWL_ENCODING_IMA_ADPCM && 
+            numHeadFrames + numDecodedFrames > numFrames)
+        {
+            /*IMA ADPCM decoders only resume at data block boundaries, 
+              so only keep whole decoded data blocks.*/
+            numFrames = numHeadFrames;
+            break;
+        }
+        
+        if (head == NULL)
+        {
+            head = (short*)KWL_MALLOC(sizeof(short) * numFrames * numChannels, KWL_MEMORY_CATEGORY_DECODER, "prefetch head");
+        }
+        
+        const int numFramesToCopy = numDecodedFrames < numFrames - numHeadFrames ?
+                                    numDecodedFrames : numFrames - numHeadFrames;
+        kwlMemcpy(&head[numHeadFrames * numChannels], 
+                  decoder.currentDecodedBuffer, 
+                  sizeof(short) * numFramesToCopy * numChannels);
+        numHeadFrames += numFramesToCopy;
+        
+        if (endOfData != 0 || numDecodedFrames == 0)
+        {
+            break;
+        }
+    }
+    
+    if (numHeadFrames > 0)
+    {
+        audioData->prefetchHead = head;
+        audioData->numPrefetchHeadFrames = numHeadFrames;
+        audioData->numPrefetchHeadChannels = numChannels;
+    }
+    else if (head != NULL)
+    {
+        KWL_FREE(head);
+    }
+    
+    KWL_FREE(decoder.currentDecodedBuffer);
+    decoder.deinit(&decoder);
+    kwlInputStream_close(&decoder.audioDataStream);
+    
+    return KWL_NO_ERROR;
 }
@@ -29,6 +29,7 @@ freely, subject to the following restrictions:
 #include "kowalski.h"
 #include "kwl_audiodata.h"
 #include "kwl_eventinstance.h"
+#include "kwl_streamingio.h"
 #include "kwl_synchronization.h"
 
 #ifdef __cplusplus
@@ -36,6 +37,18 @@ extern "C"
 {
 #endif /* __cplusplus */
     
+/** The default number of decoders of an engine, i.e of events decoding at the same time. */
+#define KWL_NUM_DECODERS 10
+
+/** The default number of decoders of an engine for events decoding in-memory IMA ADPCM data on the mixer thread. */
+#define KWL_NUM_INLINE_DECODERS 64
+
+/** The default size in bytes of the buffers a PCM decoder decodes into. */
+#define KWL_PCM_DECODER_BUFFER_SIZE 2048
+
+/** The default size in bytes of the buffers an Ogg Vorbis decoder decodes into. */
+#define KWL_OGG_VORBIS_DECODER_BUFFER_SIZE (4096 << 5)
+    
 /** An audio decoder. */
 typedef struct kwlDecoder
 {
@@ -47,6 +60,8 @@ typedef struct kwlDecoder
     char* semaphoreName[256];
     /** */
     int isDecoding;
+    /** The audio data being decoded.*/
+    kwlAudioData* audioData;
     /** An input stream providing the decoder with data.*/
     kwlInputStream audioDataStream;
     /** A buffer of the most recently decoded samples (interleaved, 16 bit).*/
@@ -55,35 +70,98 @@ typedef struct kwlDecoder
     int threadJoinRequested;
     /** */
     int loop;
+    /** The first frame of the region to play when looping.*/
+    int loopStart;
+    /** The frame following the region to play when looping. 0 means the end of the audio data.*/
+    int loopEnd;
     /** The number of decoded bytes in the temporary buffer.*/
     int currentDecodedBufferSizeInBytes;    
     /** In bytes. */
     int maxDecodedBufferSize;    
     /** The number of decoded audio channels.*/
     int numChannels;
+    /** The sample rate of the decoded audio in Hz. Zero if unknown.*/
+    int sampleRate;
+    /** The approximate number of encoded bytes consumed per second of audio. Set by codecs, zero if unknown.*/
+    int bytesPerSecond;
+    /** The service reading streamed audio data from disk. NULL if the audio data is in memory.*/
+    struct kwlStreamingIO* streamingIO;
+    /** The stream reading the audio data from disk through \c streamingIO.*/
+    struct kwlStreamingIOStream* ioStream;
+    /** 
+     * Non-zero if buffers are decoded on demand on the mixer thread instead of 
+     * on a dedicated decoding thread.
+     */
+    int decodeInline;
     /** Codec specific state data.*/
     void* codecData;
-    /** A codec specific callback that fills the decoder's buffer of decoded samples. */
+    /** The config of the engine the decoder belongs to. Codecs size their buffers by it.*/
+    const kwlEngineConfig* config;
+    /** 
+     * A codec specific callback that fills the decoder's buffer of decoded samples.
+     * Codecs supporting loop regions continue at \c loopStart in the same buffer 
+     * when reaching \c loopEnd, instead of signalling the end of the audio data.
+     */
     int (*decodeBuffer)(struct kwlDecoder* decoder);
     /** A pointer to a codec specific cleanup function. */
     void (*deinit)(struct kwlDecoder* decoder);
     /** 
      * A pointer to a codec specific method that rewinds the decoder 
-     * to the start of the audio stream. A non-zero return value indicates success.
+     * to the start of the loop region. A non-zero return value indicates success.
      */
     int (*rewind)(struct kwlDecoder* decoder);
+    /** 
+     * A pointer to a codec specific method that moves the decoder to a given frame. 
+     * A non-zero return value indicates success. NULL if the codec can not seek.
+     */
+    int (*seek)(struct kwlDecoder* decoder, int frame);
+    /** 
+     * The frame the decoding thread seeks to before decoding its first buffer, 
+     * used when starting from a prefetch head. Zero if no seek is needed.
+     */
+    int startFrame;
 } kwlDecoder;
 
+/**
+ * Checks if a given piece of audio data is cheap enough to decode on the
+ * mixer thread. This is currently the case for IMA ADPCM data held in memory.
+ * @param audioData The audio data to check.
+ * @return Non-zero if the audio data should be decoded inline, zero otherwise.
+ */
+int kwlDecoder_canDecodeInline(kwlAudioData* audioData);
+    
 /** 
  * Initializes a given decoder instance. The decoder type is determined by the encoding of the 
  * audio data provided.
  * @param decoder
  * @param audioData
+ * @param streamingIO The service to read audio data streamed from disk through.
+ * @param decodeOnMixerThread Non-zero to decode all buffers inline, regardless of the audio data.
+ * Used by offline engines, whose mixer would otherwise outrun the decoding thread.
+ * @param config The config of the engine, which must outlive the decoder.
  */
-kwlError kwlDecoder_init(kwlDecoder* decoder, struct kwlEventInstance* event);
+kwlError kwlDecoder_init(kwlDecoder* decoder, 
+                         struct kwlEventInstance* event, 
+                         struct kwlStreamingIO* streamingIO,
+                         int decodeOnMixerThread,
+                         const kwlEngineConfig* config);
     
 void kwlDecoder_deinit(kwlDecoder* decoder);
 
+/**
+ * Decodes the start of a given piece of audio data streamed from disk into its prefetch head.
+ * The head is not created if the codec can not resume decoding at the end of the head.
+ * @param audioData The audio data. Must be streamed from disk and have no prefetch head.
+ * @param path The path of the wave bank file containing the audio data.
+ * @param fileSystem The file system to read the wave bank file through.
+ * @param numMilliseconds The length of the head in milliseconds.
+ * @return \c KWL_NO_ERROR on success or if no head was created, an error code otherwise.
+ */
+kwlError kwlDecoder_createPrefetchHead(kwlAudioData* audioData,
+                                       const char* const path,
+                                       const kwlFileSystem* fileSystem,
+                                       int numMilliseconds);
+
 void* kwlDecoder_decodingLoop(void*);
     
 int kwlDecoder_decodeNewBufferForEvent(kwlDecoder* decoder, struct kwlEventInstance* event);
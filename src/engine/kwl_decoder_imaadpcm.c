@@ -25,11 +25,301 @@ freely, subject to the following restrictions:
 #include "kwl_decoder_imaadpcm.h"
 #include "kwl_memory.h"
 
+/** The maximum number of channels of IMA ADPCM data.*/
+#define KWL_IMA_ADPCM_MAX_NUM_CHANNELS 8
+
+/**
+ * The magnitude of the predictor delta for each step index and the three
+ * magnitude bits of a nibble. Equivalent to the shift-and-add computation in
+ * decodeNibble.
+ */
+static const int KWL_IMA_ADPCM_DIFF_TABLE[89][8] = {
+    {0, 1, 3, 4, 7, 8, 10, 11},
+    {1, 3, 5, 7, 9, 11, 13, 15},
+    {1, 3, 5, 7, 10, 12, 14, 16},
+    {1, 3, 6, 8, 11, 13, 16, 18},
+    {1, 3, 6, 8, 12, 14, 17, 19},
+    {1, 4, 7, 10, 13, 16, 19, 22},
+    {1, 4, 7, 10, 14, 17, 20, 23},
+    {1, 4, 8, 11, 15, 18, 22, 25},
+    {2, 6, 10, 14, 18, 22, 26, 30},
+    {2, 6, 10, 14, 19, 23, 27, 31},
+    {2, 6, 11, 15, 21, 25, 30, 34},
+    {2, 7, 12, 17, 23, 28, 33, 38},
+    {2, 7, 13, 18, 25, 30, 36, 41},
+    {3, 9, 15, 21, 28, 34, 40, 46},
+    {3, 10, 17, 24, 31, 38, 45, 52},
+    {3, 10, 18, 25, 34, 41, 49, 56},
+    {4, 12, 21, 29, 38, 46, 55, 63},
+    {4, 13, 22, 31, 41, 50, 59, 68},
+    {5, 15, 25, 35, 46, 56, 66, 76},
+    {5, 16, 27, 38, 50, 61, 72, 83},
+    {6, 18, 31, 43, 56, 68, 81, 93},
+    {6, 19, 33, 46, 61, 74, 88, 101},
+    {7, 22, 37, 52, 67, 82, 97, 112},
+    {8, 24, 41, 57, 74, 90, 107, 123},
+    {9, 27, 45, 63, 82, 100, 118, 136},
+    {10, 30, 50, 70, 90, 110, 130, 150},
+    {11, 33, 55, 77, 99, 121, 143, 165},
+    {12, 36, 60, 84, 109, 133, 157, 181},
+    {13, 39, 66, 92, 120, 146, 173, 199},
+    {14, 43, 73, 102, 132, 161, 191, 220},
+    {16, 48, 81, 113, 146, 178, 211, 243},
+    {17, 52, 88, 123, 160, 195, 231, 266},
+    {19, 58, 97, 136, 176, 215, 254, 293},
+    {21, 64, 107, 150, 194, 237, 280, 323},
+    {23, 70, 118, 165, 213, 260, 308, 355},
+    {26, 78, 130, 182, 235, 287, 339, 391},
+    {28, 85, 143, 200, 258, 315, 373, 430},
+    {31, 94, 157, 220, 284, 347, 410, 473},
+    {34, 103, 173, 242, 313, 382, 452, 521},
+    {38, 114, 191, 267, 345, 421, 498, 574},
+    {42, 126, 210, 294, 379, 463, 547, 631},
+    {46, 138, 231, 323, 417, 509, 602, 694},
+    {51, 153, 255, 357, 459, 561, 663, 765},
+    {56, 168, 280, 392, 505, 617, 729, 841},
+    {61, 184, 308, 431, 555, 678, 802, 925},
+    {68, 204, 340, 476, 612, 748, 884, 1020},
+    {74, 223, 373, 522, 672, 821, 971, 1120},
+    {82, 246, 411, 575, 740, 904, 1069, 1233},
+    {90, 271, 452, 633, 814, 995, 1176, 1357},
+    {99, 298, 497, 696, 895, 1094, 1293, 1492},
+    {109, 328, 547, 766, 985, 1204, 1423, 1642},
+    {120, 360, 601, 841, 1083, 1323, 1564, 1804},
+    {132, 397, 662, 927, 1192, 1457, 1722, 1987},
+    {145, 436, 728, 1019, 1311, 1602, 1894, 2185},
+    {160, 480, 801, 1121, 1442, 1762, 2083, 2403},
+    {176, 528, 881, 1233, 1587, 1939, 2292, 2644},
+    {194, 582, 970, 1358, 1746, 2134, 2522, 2910},
+    {213, 639, 1066, 1492, 1920, 2346, 2773, 3199},
+    {234, 703, 1173, 1642, 2112, 2581, 3051, 3520},
+    {258, 774, 1291, 1807, 2324, 2840, 3357, 3873},
+    {284, 852, 1420, 1988, 2556, 3124, 3692, 4260},
+    {312, 936, 1561, 2185, 2811, 3435, 4060, 4684},
+    {343, 1030, 1717, 2404, 3092, 3779, 4466, 5153},
+    {378, 1134, 1890, 2646, 3402, 4158, 4914, 5670},
+    {415, 1246, 2078, 2909, 3742, 4573, 5405, 6236},
+    {457, 1372, 2287, 3202, 4117, 5032, 5947, 6862},
+    {503, 1509, 2516, 3522, 4529, 5535, 6542, 7548},
+    {553, 1660, 2767, 3874, 4981, 6088, 7195, 8302},
+    {608, 1825, 3043, 4260, 5479, 6696, 7914, 9131},
+    {669, 2008, 3348, 4687, 6027, 7366, 8706, 10045},
+    {736, 2209, 3683, 5156, 6630, 8103, 9577, 11050},
+    {810, 2431, 4052, 5673, 7294, 8915, 10536, 12157},
+    {891, 2674, 4457, 6240, 8023, 9806, 11589, 13372},
+    {980, 2941, 4902, 6863, 8825, 10786, 12747, 14708},
+    {1078, 3235, 5393, 7550, 9708, 11865, 14023, 16180},
+    {1186, 3559, 5932, 8305, 10679, 13052, 15425, 17798},
+    {1305, 3915, 6526, 9136, 11747, 14357, 16968, 19578},
+    {1435, 4306, 7178, 10049, 12922, 15793, 18665, 21536},
+    {1579, 4737, 7896, 11054, 14214, 17372, 20531, 23689},
+    {1737, 5211, 8686, 12160, 15636, 19110, 22585, 26059},
+    {1911, 5733, 9555, 13377, 17200, 21022, 24844, 28666},
+    {2102, 6306, 10511, 14715, 18920, 23124, 27329, 31533},
+    {2312, 6937, 11562, 16187, 20812, 25437, 30062, 34687},
+    {2543, 7630, 12718, 17805, 22893, 27980, 33068, 38155},
+    {2798, 8394, 13990, 19586, 25183, 30779, 36375, 41971},
+    {3077, 9232, 15388, 21543, 27700, 33855, 40011, 46166},
+    {3385, 10156, 16928, 23699, 30471, 37242, 44014, 50785},
+    {3724, 11172, 18621, 26069, 33518, 40966, 48415, 55863},
+    {4095, 12286, 20478, 28669, 36862, 45053, 53245, 61436}
+};
+
+/**
+ * The clamped step index following each step index and the three
+ * magnitude bits of a nibble.
+ */
+static const unsigned char KWL_IMA_ADPCM_NEXT_STEP_INDEX_TABLE[89][8] = {
+    {0, 0, 0, 0, 2, 4, 6, 8},
+    {0, 0, 0, 0, 3, 5, 7, 9},
+    {1, 1, 1, 1, 4, 6, 8, 10},
+    {2, 2, 2, 2, 5, 7, 9, 11},
+    {3, 3, 3, 3, 6, 8, 10, 12},
+    {4, 4, 4, 4, 7, 9, 11, 13},
+    {5, 5, 5, 5, 8, 10, 12, 14},
+    {6, 6, 6, 6, 9, 11, 13, 15},
+    {7, 7, 7, 7, 10, 12, 14, 16},
+    {8, 8, 8, 8, 11, 13, 15, 17},
+    {9, 9, 9, 9, 12, 14, 16, 18},
+    {10, 10, 10, 10, 13, 15, 17, 19},
+    {11, 11, 11, 11, 14, 16, 18, 20},
+    {12, 12, 12, 12, 15, 17, 19, 21},
+    {13, 13, 13, 13, 16, 18, 20, 22},
+    {14, 14, 14, 14, 17, 19, 21, 23},
+    {15, 15, 15, 15, 18, 20, 22, 24},
+    {16, 16, 16, 16, 19, 21, 23, 25},
+    {17, 17, 17, 17, 20, 22, 24, 26},
+    {18, 18, 18, 18, 21, 23, 25, 27},
+    {19, 19, 19, 19, 22, 24, 26, 28},
+    {20, 20, 20, 20, 23, 25, 27, 29},
+    {21, 21, 21, 21, 24, 26, 28, 30},
+    {22, 22, 22, 22, 25, 27, 29, 31},
+    {23, 23, 23, 23, 26, 28, 30, 32},
+    {24, 24, 24, 24, 27, 29, 31, 33},
+    {25, 25, 25, 25, 28, 30, 32, 34},
+    {26, 26, 26, 26, 29, 31, 33, 35},
+    {27, 27, 27, 27, 30, 32, 34, 36},
+    {28, 28, 28, 28, 31, 33, 35, 37},
+    {29, 29, 29, 29, 32, 34, 36, 38},
+    {30, 30, 30, 30, 33, 35, 37, 39},
+    {31, 31, 31, 31, 34, 36, 38, 40},
+    {32, 32, 32, 32, 35, 37, 39, 41},
+    {33, 33, 33, 33, 36, 38, 40, 42},
+    {34, 34, 34, 34, 37, 39, 41, 43},
+    {35, 35, 35, 35, 38, 40, 42, 44},
+    {36, 36, 36, 36, 39, 41, 43, 45},
+    {37, 37, 37, 37, 40, 42, 44, 46},
+    {38, 38, 38, 38, 41, 43, 45, 47},
+    {39, 39, 39, 39, 42, 44, 46, 48},
+    {40, 40, 40, 40, 43, 45, 47, 49},
+    {41, 41, 41, 41, 44, 46, 48, 50},
+    {42, 42, 42, 42, 45, 47, 49, 51},
+    {43, 43, 43, 43, 46, 48, 50, 52},
+    {44, 44, 44, 44, 47, 49, 51, 53},
+    {45, 45, 45, 45, 48, 50, 52, 54},
+    {46, 46, 46, 46, 49, 51, 53, 55},
+    {47, 47, 47, 47, 50, 52, 54, 56},
+    {48, 48, 48, 48, 51, 53, 55, 57},
+    {49, 49, 49, 49, 52, 54, 56, 58},
+    {50, 50, 50, 50, 53, 55, 57, 59},
+    {51, 51, 51, 51, 54, 56, 58, 60},
+    {52, 52, 52, 52, 55, 57, 59, 61},
+    {53, 53, 53, 53, 56, 58, 60, 62},
+    {54, 54, 54, 54, 57, 59, 61, 63},
+    {55, 55, 55, 55, 58, 60, 62, 64},
+    {56, 56, 56, 56, 59, 61, 63, 65},
+    {57, 57, 57, 57, 60, 62, 64, 66},
+    {58, 58, 58, 58, 61, 63, 65, 67},
+    {59, 59, 59, 59, 62, 64, 66, 68},
+    {60, 60, 60, 60, 63, 65, 67, 69},
+    {61, 61, 61, 61, 64, 66, 68, 70},
+    {62, 62, 62, 62, 65, 67, 69, 71},
+    {63, 63, 63, 63, 66, 68, 70, 72},
+    {64, 64, 64, 64, 67, 69, 71, 73},
+    {65, 65, 65, 65, 68, 70, 72, 74},
+    {66, 66, 66, 66, 69, 71, 73, 75},
+    {67, 67, 67, 67, 70, 72, 74, 76},
+    {68, 68, 68, 68, 71, 73, 75, 77},
+    {69, 69, 69, 69, 72, 74, 76, 78},
+    {70, 70, 70, 70, 73, 75, 77, 79},
+    {71, 71, 71, 71, 74, 76, 78, 80},
+    {72, 72, 72, 72, 75, 77, 79, 81},
+    {73, 73, 73, 73, 76, 78, 80, 82},
+    {74, 74, 74, 74, 77, 79, 81, 83},
+    {75, 75, 75, 75, 78, 80, 82, 84},
+    {76, 76, 76, 76, 79, 81, 83, 85},
+    {77, 77, 77, 77, 80, 82, 84, 86},
+    {78, 78, 78, 78, 81, 83, 85, 87},
+    {79, 79, 79, 79, 82, 84, 86, 88},
+    {80, 80, 80, 80, 83, 85, 87, 88},
+    {81, 81, 81, 81, 84, 86, 88, 88},
+    {82, 82, 82, 82, 85, 87, 88, 88},
+    {83, 83, 83, 83, 86, 88, 88, 88},
+    {84, 84, 84, 84, 87, 88, 88, 88},
+    {85, 85, 85, 85, 88, 88, 88, 88},
+    {86, 86, 86, 86, 88, 88, 88, 88},
+    {87, 87, 87, 87, 88, 88, 88, 88}
+};
+
+
+/**
+ * Decodes the 8 samples of a single data word, writing them to every
+ * stride:th element of outBuffer.
+ */
+static inline void kwlDecodeIMAADPCMDataWord(const unsigned char* dataWord,
+                                             int* predictor,
+                                             int* stepIndex,
+                                             short* outBuffer,
+                                             const int stride)
+{
+    unsigned int nibbles = dataWord[0] | 
+                           (dataWord[1] << 8) | 
+                           (dataWord[2] << 16) | 
+                           ((unsigned int)dataWord[3] << 24);
+    int p = *predictor;
+    int s = *stepIndex;
+    
+    for (int i = 0; i < 8; i++)
+    {
+        const int magnitudeBits = nibbles & 7;
+        const int delta = KWL_IMA_ADPCM_DIFF_TABLE[s][magnitudeBits];
+        p += (nibbles & 8) ? -delta : delta;
+        p = p > 32767 ? 32767 : (p < -32768 ? -32768 : p);
+        s = KWL_IMA_ADPCM_NEXT_STEP_INDEX_TABLE[s][magnitudeBits];
+        outBuffer[i * stride] = (short)p;
+        nibbles >>= 4;
+    }
+    
+    *predictor = p;
+    *stepIndex = s;
+}
+
+/**
+ * Decodes an nBlockAlign byte data block into interleaved 16 bit samples. All
+ * channels are decoded in a single pass over the block, in the order the data words 
+ * are stored.
+ */
+static void kwlDecodeIMAADPCMBlock(const unsigned char* datablock,
+                                   const int nBlockAlign,
+                                   const int numChannels,
+                                   short* outBuffer)
+{
+    KWL_ASSERT(numChannels > 0 && numChannels <= KWL_IMA_ADPCM_MAX_NUM_CHANNELS);
+    
+    int predictors[KWL_IMA_ADPCM_MAX_NUM_CHANNELS];
+    int stepIndices[KWL_IMA_ADPCM_MAX_NUM_CHANNELS];
+    
+    /*get step table index and predictor value from the header word of each channel*/
+    for (int ch = 0; ch < numChannels; ch++)
+    {
+        const unsigned char* headerWord = &datablock[4 * ch];
+        predictors[ch] = (short)(headerWord[0] | (headerWord[1] << 8));
+        stepIndices[ch] = headerWord[2] > 88 ? 88 : headerWord[2];
+        /*sanity check. reserved last byte of the header word should be 0.*/
+        KWL_ASSERT(headerWord[3] == 0 && "non-zero reserved ADPCM header block byte");
+    }
+    
+    const int nDataWordsPerChannel = nBlockAlign / (4 * numChannels) - 1;
+    const unsigned char* dataWord = &datablock[4 * numChannels];
+    
+    if (numChannels == 1)
+    {
+        for (int i = 0; i < nDataWordsPerChannel; i++)
+        {
+            kwlDecodeIMAADPCMDataWord(dataWord, &predictors[0], &stepIndices[0], outBuffer, 1);
+            dataWord += 4;
+            outBuffer += 8;
+        }
+    }
+    else if (numChannels == 2)
+    {
+        for (int i = 0; i < nDataWordsPerChannel; i++)
+        {
+            kwlDecodeIMAADPCMDataWord(dataWord, &predictors[0], &stepIndices[0], outBuffer, 2);
+            kwlDecodeIMAADPCMDataWord(dataWord + 4, &predictors[1], &stepIndices[1], outBuffer + 1, 2);
+            dataWord += 8;
+            outBuffer += 16;
+        }
+    }
+    else
+    {
+        for (int i = 0; i < nDataWordsPerChannel; i++)
+        {
+            for (int ch = 0; ch < numChannels; ch++)
+            {
+                kwlDecodeIMAADPCMDataWord(dataWord, &predictors[ch], &stepIndices[ch], outBuffer + ch, numChannels);
+                dataWord += 4;
+            }
+            outBuffer += 8 * numChannels;
+        }
+    }
+}
+
 kwlError kwlInitDecoderIMAADPCM(kwlDecoder* decoder)
 {
     /*Allocate decoder data.*/
     kwlIMAADPCMCodecData* data = 
-        (kwlIMAADPCMCodecData*)KWL_MALLOC(sizeof(kwlIMAADPCMCodecData), "IMAADPCM decoder data");
+        (kwlIMAADPCMCodecData*)KWL_MALLOC(sizeof(kwlIMAADPCMCodecData), KWL_MEMORY_CATEGORY_DECODER, "IMAADPCM decoder data");
     kwlMemset(data, 0, sizeof(kwlIMAADPCMCodecData));
     
     /* Hook up data and callbacks to the decoder.*/
@@ -37,6 +327,7 @@ kwlError kwlInitDecoderIMAADPCM(kwlDecoder* decoder)
     decoder->decodeBuffer = kwlDecodeBufferIMAADPCM;
     decoder->deinit = kwlDeinitDecoderIMAADPCM;
     decoder->rewind = kwlRewindDecoderIMAADPCM;
+    decoder->seek = kwlSeekDecoderIMAADPCM;
     
     kwlLoadIMAADPCMWAVMetadataFromStream(&decoder->audioDataStream, 
                                          &data->adpcmDataDescription,
@@ -48,12 +339,30 @@ kwlError kwlInitDecoderIMAADPCM(kwlDecoder* decoder)
       a decoded one is 16, so we need nBlockAlign * 4 bytes to hold a decoded datablock.*/
     decoder->maxDecodedBufferSize = data->nBlockAlign * 4;
     decoder->numChannels = data->adpcmDataDescription.numChannels;
+    if (data->adpcmDataDescription.sampleRate > 0)
+    {
+        decoder->sampleRate = data->adpcmDataDescription.sampleRate;
+    }
     KWL_ASSERT((data->dataSize % data->nBlockAlign) == 0);
     
     KWL_ASSERT(decoder->numChannels > 0);
     
     /*allocate a buffer for the current data block */
-    data->currentDatablock = (unsigned char*)KWL_MALLOC(data->nBlockAlign, "IMAADPCM data block buffer");
+    data->currentDatablock = (unsigned char*)KWL_MALLOC(data->nBlockAlign, KWL_MEMORY_CATEGORY_DECODER, "IMAADPCM data block buffer");
+    
+    data->numFramesPerBlock = 8 * (data->nBlockAlign / (4 * decoder->numChannels) - 1);
+    decoder->bytesPerSecond = (int)(data->nBlockAlign * (long long)decoder->sampleRate / data->numFramesPerBlock);
+    data->currentFrame = 0;
+    data->decodedDatablockIndex = -1;
+    
+    /*loop regions that do not start and end at data block boundaries are played by 
+      copying frames from a separately decoded data block.*/
+    if (decoder->loop != 0 && (decoder->loopStart > 0 || decoder->loopEnd > 0))
+    {
+        data->decodedDatablock = 
+            (short*)KWL_MALLOC(sizeof(short) * data->numFramesPerBlock * decoder->numChannels, 
+                               KWL_MEMORY_CATEGORY_DECODER, "IMAADPCM decoded data block buffer");
+    }
     
     /*go to the start of the first data block*/
     kwlInputStream_seek(&decoder->audioDataStream, data->firstDataBlockByte, SEEK_SET);
@@ -66,13 +375,123 @@ void kwlDeinitDecoderIMAADPCM(kwlDecoder* decoder)
     kwlIMAADPCMCodecData* data = (kwlIMAADPCMCodecData*)decoder->codecData;
     
     KWL_FREE(data->currentDatablock);
+    if (data->decodedDatablock != NULL)
+    {
+        KWL_FREE(data->decodedDatablock);
+    }
     KWL_FREE(data);
 }
 
+/**
+ * Reads and decodes the data block with a given index into the decoded data block
+ * buffer, unless it is already there. 
+ * @return Non-zero on success, zero if the data block could not be read.
+ */
+static int kwlDecodeIMAADPCMBlockWithIndex(kwlDecoder* decoder, int blockIndex)
+{
+    kwlIMAADPCMCodecData* codecData = (kwlIMAADPCMCodecData*)decoder->codecData;
+    
+    if (codecData->decodedDatablockIndex == blockIndex)
+    {
+        return 1;
+    }
+    
+    /*data blocks are independent, so any block can be decoded after a seek.*/
+    const int blockByte = blockIndex * codecData->nBlockAlign;
+    if (blockByte != codecData->currentByte)
+    {
+        kwlInputStream_seek(&decoder->audioDataStream, codecData->firstDataBlockByte + blockByte, SEEK_SET);
+        codecData->currentByte = blockByte;
+    }
+    
+    int bytesRead = kwlInputStream_read(&decoder->audioDataStream,
+                                        (signed char*)codecData->currentDatablock,
+                                        codecData->nBlockAlign);
+    if (bytesRead != codecData->nBlockAlign)
+    {
+        return 0;
+    }
+    codecData->currentByte += bytesRead;
+    
+    kwlDecodeIMAADPCMBlock(codecData->currentDatablock,
+                           codecData->nBlockAlign,
+                           decoder->numChannels,
+                           codecData->decodedDatablock);
+    codecData->decodedDatablockIndex = blockIndex;
+    return 1;
+}
+
+/**
+ * Fills the output buffer with one data block worth of frames from the loop region 
+ * of the decoder. When the end of the region is reached, the rest of the buffer 
+ * is filled starting at the first frame of the region.
+ * @return Non-zero if the audio data could not be read, zero otherwise.
+ */
+static int kwlDecodeLoopRegionIMAADPCM(kwlDecoder* decoder)
+{
+    kwlIMAADPCMCodecData* codecData = (kwlIMAADPCMCodecData*)decoder->codecData;
+    
+    const int numChannels = decoder->numChannels;
+    const int numFramesPerBlock = codecData->numFramesPerBlock;
+    const int numFramesInStream = (codecData->dataSize / codecData->nBlockAlign) * numFramesPerBlock;
+    
+    int endFrame = numFramesInStream;
+    if (decoder->loopEnd > 0 && decoder->loopEnd < endFrame)
+    {
+        endFrame = decoder->loopEnd;
+    }
+    const int loopStart = decoder->loopStart < endFrame ? decoder->loopStart : 0;
+    
+    int numFramesDecoded = 0;
+    int endOfData = endFrame <= 0 ? 1 : 0;
+    
+    while (endOfData == 0 && numFramesDecoded < numFramesPerBlock)
+    {
+        const int blockIndex = codecData->currentFrame / numFramesPerBlock;
+        if (kwlDecodeIMAADPCMBlockWithIndex(decoder, blockIndex) == 0)
+        {
+            endOfData = 1;
+            break;
+        }
+        
+        /*copy as many frames as possible from the decoded block, stopping at the 
+          end of the output buffer or the loop region.*/
+        const int firstFrameInBlock = codecData->currentFrame - blockIndex * numFramesPerBlock;
+        int numFrames = numFramesPerBlock - firstFrameInBlock;
+        if (numFrames > numFramesPerBlock - numFramesDecoded)
+        {
+            numFrames = numFramesPerBlock - numFramesDecoded;
+        }
+        if (numFrames > endFrame - codecData->currentFrame)
+        {
+            numFrames = endFrame - codecData->currentFrame;
+        }
+        
+        kwlMemcpy(&decoder->currentDecodedBuffer[numFramesDecoded * numChannels],
+                  &codecData->decodedDatablock[firstFrameInBlock * numChannels],
+                  sizeof(short) * numFrames * numChannels);
+        
+        numFramesDecoded += numFrames;
+        codecData->currentFrame += numFrames;
+        if (codecData->currentFrame >= endFrame)
+        {
+            codecData->currentFrame = loopStart;
+        }
+    }
+    
+    decoder->currentDecodedBufferSizeInBytes = 2 * numFramesDecoded * numChannels;
+    return endOfData;
+}
+
 int kwlDecodeBufferIMAADPCM(kwlDecoder* decoder)
 {
     kwlIMAADPCMCodecData* codecData = (kwlIMAADPCMCodecData*)decoder->codecData;
     
+    if (codecData->decodedDatablock != NULL)
+    {
+        return kwlDecodeLoopRegionIMAADPCM(decoder);
+    }
+    
     /*
      each data block is nBlockAlign bytes and starts with numChannels header words followed by
      nBlockAlign/(4 * numChannels) - 1 data words per channel. 
@@ -103,7 +522,7 @@ int kwlDecodeBufferIMAADPCM(kwlDecoder* decoder)
     
     /* read the next encoded data block */
     int bytesRead = kwlInputStream_read(&decoder->audioDataStream,
-                                        codecData->currentDatablock,
+                                        (signed char*)codecData->currentDatablock,
                                         codecData->nBlockAlign);
     if (bytesRead == 0)
     {
@@ -117,85 +536,16 @@ int kwlDecodeBufferIMAADPCM(kwlDecoder* decoder)
     /* decode the data block */
     const int numChannels = decoder->numChannels;
     const int nDataWordsPerChannel = codecData->nBlockAlign/ (4 * numChannels) - 1;
-    unsigned char* datablock = codecData->currentDatablock;
     short* outBuffer = decoder->currentDecodedBuffer;
     
-    kwlMemset(outBuffer, 0, 4 * codecData->nBlockAlign);
-    
-    /*Loop over the interleaved data words*/
-    for (int ch = 0; ch < numChannels; ch++)
-    {
-        const int byteOffset = ch * 4; /*the byte offset for the current channel (word offset * 4)*/
-        
-        /*get step table index and predictor value from the header word for the current channel*/
-        int predictor = (short)(datablock[byteOffset] | ((datablock[byteOffset + 1] << 8) & 0xff00));
-        int stepIndex = datablock[byteOffset + 2];
-        
-        /*sanity check. reserved last byte of the header word should be 0.*/
-        char reserved = datablock[byteOffset + 3];
-        KWL_ASSERT(reserved == 0 && "non-zero reserved ADPCM header block byte");
-        
-        int byteIdx = numChannels * 4 + byteOffset; //the byte index of the first data word for this channel
-        int idx = ch;
-        
-        while (byteIdx < codecData->nBlockAlign)
-        {
-            /*
-             decode each nibble of the current data word, 
-             containing 8 encoded samples, for the current channel 
-             */
-            outBuffer[idx] = decodeNibble(datablock[byteIdx] & 0x0f, &predictor, &stepIndex);
-            idx += numChannels;
-            outBuffer[idx] = decodeNibble((datablock[byteIdx] & 0xf0) >> 4, &predictor, &stepIndex);
-            idx += numChannels;
-            byteIdx++;
-            
-            outBuffer[idx] = decodeNibble(datablock[byteIdx] & 0x0f, &predictor, &stepIndex);
-            idx += numChannels;
-            outBuffer[idx] = decodeNibble((datablock[byteIdx] & 0xf0) >> 4, &predictor, &stepIndex);
-            idx += numChannels;
-            byteIdx++;
-            
-            outBuffer[idx] = decodeNibble(datablock[byteIdx] & 0x0f, &predictor, &stepIndex);
-            idx += numChannels;
-            outBuffer[idx] = decodeNibble((datablock[byteIdx] & 0xf0) >> 4, &predictor, &stepIndex);
-            idx += numChannels;
-            byteIdx++;
-            
-            outBuffer[idx] = decodeNibble(datablock[byteIdx] & 0x0f, &predictor, &stepIndex);
-            idx += numChannels;
-            outBuffer[idx] = decodeNibble((datablock[byteIdx] & 0xf0) >> 4, &predictor, &stepIndex);
-            idx += numChannels;
-            byteIdx++;
-            
-            byteIdx += (numChannels - 1) << 2; /*jump to the next data word for the current channel*/
-        }
-    }
+    kwlDecodeIMAADPCMBlock(codecData->currentDatablock,
+                           codecData->nBlockAlign,
+                           numChannels,
+                           outBuffer);
     
-    /* Loop if requested. */
+    /* Whole data blocks are output, so looping the entire audio data only 
+       requires seeking back to the first block after the last one. */
     int isLastBlock = codecData->currentByte >= codecData->dataSize ? 1 : 0;
-    if (isLastBlock != 0 &&
-        decoder->loop)
-    {
-        int minZeroFrameIdx = nDataWordsPerChannel;
-        for (int ch = 0; ch < numChannels; ch++)
-        {
-            int idx = ch;
-            for (int i = 0; i < nDataWordsPerChannel; i++)
-            {
-                if(outBuffer[idx] == 0)
-                {
-                    if (i < minZeroFrameIdx)
-                    {
-                        minZeroFrameIdx = i;
-                    }
-                }
-                
-                idx += numChannels;
-            }
-        }
-        //printf("minZeroFrameIdx %d\n", minZeroFrameIdx);
-    }
     
     /*2 for 2 bytes per 16 bit output sample, 8 for 8 samples per data word.*/
     decoder->currentDecodedBufferSizeInBytes = 2 * 8 * nDataWordsPerChannel * numChannels;
@@ -206,6 +556,40 @@ int kwlRewindDecoderIMAADPCM(kwlDecoder* decoder)
 {
     kwlIMAADPCMCodecData* codecData = (kwlIMAADPCMCodecData*)decoder->codecData;
     codecData->currentByte = 0;
+    codecData->currentFrame = decoder->loopStart;
+    codecData->decodedDatablockIndex = -1;
     kwlInputStream_seek(&decoder->audioDataStream, codecData->firstDataBlockByte, SEEK_SET);
     return 1;
 }
+
+int kwlSeekDecoderIMAADPCM(kwlDecoder* decoder, int frame)
+{
+    kwlIMAADPCMCodecData* codecData = (kwlIMAADPCMCodecData*)decoder->codecData;
+    const int blockIndex = frame / codecData->numFramesPerBlock;
+    
+    if (blockIndex * codecData->nBlockAlign > codecData->dataSize)
+    {
+        return 0;
+    }
+    
+    if (codecData->decodedDatablock != NULL)
+    {
+        /*loop regions are copied frame by frame, so any frame can be sought to.*/
+        codecData->currentFrame = frame;
+        return 1;
+    }
+    
+    /*whole data blocks are decoded into the output buffer, so only block boundaries can be sought to.*/
+    if (frame != blockIndex * codecData->numFramesPerBlock)
+    {
+        return 0;
+    }
+    
+    codecData->currentByte = blockIndex * codecData->nBlockAlign;
+    codecData->currentFrame = frame;
+    codecData->decodedDatablockIndex = -1;
+    kwlInputStream_seek(&decoder->audioDataStream, 
+                        codecData->firstDataBlockByte + codecData->currentByte, 
+                        SEEK_SET);
+    return 1;
+}
@@ -50,6 +50,14 @@ typedef struct kwlIMAADPCMCodecData
     int currentByte;
     /** A buffer containing the current encoded datablock. */
     unsigned char* currentDatablock;
+    /** The number of decoded frames per data block.*/
+    int numFramesPerBlock;
+    /** The index of the next frame to output when playing a loop region.*/
+    int currentFrame;
+    /** The decoded samples of a data block, used when playing a loop region.*/
+    short* decodedDatablock;
+    /** The index of the data block in \c decodedDatablock, or -1 if none.*/
+    int decodedDatablockIndex;
     
 } kwlIMAADPCMCodecData;
     
@@ -79,6 +87,13 @@ int kwlDecodeBufferIMAADPCM(kwlDecoder* decoder);
     
 int kwlRewindDecoderIMAADPCM(kwlDecoder* decoder);
 
+/**
+ * Moves a given IMA ADPCM decoder to a given frame. Unless the decoder plays
+ * a loop region, the frame must be the first frame of a data block.
+ * @return Non-zero on success, zero otherwise.
+ */
+int kwlSeekDecoderIMAADPCM(kwlDecoder* decoder, int frame);
+
 /** 
  * Decodes an IMA ADPCM nibble to a 16 bit pcm sample.
  */
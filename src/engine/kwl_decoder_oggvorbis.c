@@ -28,11 +28,83 @@ freely, subject to the following restrictions:
 
 #include "kwl_assert.h"
 
+/**
+ * Frees a fully opened OggVorbis_File holding shared headers and codebooks.
+ */
+static void kwlFreeSharedOggVorbisHeaders(void* data)
+{
+    OggVorbis_File* headers = (OggVorbis_File*)data;
+    ov_clear(headers);
+    KWL_FREE(headers);
+}
+
+/**
+ * Parses the headers of an Ogg Vorbis stream and builds its codebooks, 
+ * producing an OggVorbis_File that decoder files can be opened from.
+ */
+static OggVorbis_File* kwlCreateSharedOggVorbisHeaders(kwlInputStream* stream, ov_callbacks callbacks)
+{
+    OggVorbis_File* headers = (OggVorbis_File*)KWL_MALLOC(sizeof(OggVorbis_File), KWL_MEMORY_CATEGORY_DECODER, "shared ogg vorbis headers");
+    int result = ov_open_callbacks(stream, headers, NULL, 0, callbacks);
+    if (result < 0)
+    {
+        KWL_FREE(headers);
+        return NULL;
+    }
+    
+    /*the shared headers never read from a stream of their own.*/
+    headers->datasource = NULL;
+    
+    /*codebooks are built the first time a dsp state is initialized for a given vorbis_info,
+      so do that here instead of when the first decoder starts decoding.*/
+    vorbis_dsp_state dspState;
+    vorbis_synthesis_init(&dspState, headers->vi);
+    vorbis_dsp_clear(&dspState);
+    
+    return headers;
+}
+
+/**
+ * Opens an OggVorbis_File that reads from a given stream, using previously
+ * parsed headers and codebooks. Only per stream decoding state is allocated.
+ */
+static int kwlOpenOggVorbisFileWithSharedHeaders(kwlInputStream* stream,
+                                                 OggVorbis_File* file,
+                                                 const OggVorbis_File* headers)
+{
+    /*share the link tables and vorbis_info/vorbis_comment structs...*/
+    kwlMemcpy(file, headers, sizeof(OggVorbis_File));
+    file->datasource = stream;
+    
+    /*...but create a new framing and decoding state.*/
+    file->oy = ogg_sync_create();
+    file->os = ogg_stream_create(headers->current_serialno);
+    kwlMemset(&file->vd, 0, sizeof(vorbis_dsp_state));
+    kwlMemset(&file->vb, 0, sizeof(vorbis_block));
+    file->ready_state = OPENED;
+    
+    /*seek to the first audio page.*/
+    return ov_raw_seek(file, file->dataoffsets[0]);
+}
+
+/**
+ * Releases the per stream state of an OggVorbis_File opened using
+ * kwlOpenOggVorbisFileWithSharedHeaders.
+ */
+static void kwlClearOggVorbisFileWithSharedHeaders(OggVorbis_File* file)
+{
+    vorbis_block_clear(&file->vb);
+    vorbis_dsp_clear(&file->vd);
+    ogg_stream_destroy(file->os);
+    ogg_sync_destroy(file->oy);
+    kwlMemset(file, 0, sizeof(OggVorbis_File));
+}
+
 kwlError kwlInitDecoderOggVorbis(kwlDecoder* decoder)
 {
     /*Allocate decoder data.*/
     kwlOggVorbisDecoderData* data = 
-        (kwlOggVorbisDecoderData*)KWL_MALLOC(sizeof(kwlOggVorbisDecoderData), "ogg vorbis decoder data");
+        (kwlOggVorbisDecoderData*)KWL_MALLOC(sizeof(kwlOggVorbisDecoderData), KWL_MEMORY_CATEGORY_DECODER, "ogg vorbis decoder data");
     kwlMemset(data, 0, sizeof(kwlOggVorbisDecoderData));
 
     /* Hook up data and callbacks to the decoder.*/
@@ -40,6 +112,7 @@ kwlError kwlInitDecoderOggVorbis(kwlDecoder* decoder)
     decoder->decodeBuffer = &kwlDecodeBufferOggVorbis;
     decoder->deinit = &kwlDeinitDecoderOggVorbis;
     decoder->rewind = &kwlRewindDecoderOggVorbis;
+    decoder->seek = &kwlSeekDecoderOggVorbis;
     
     /*Open the file for reading, providing data from the decoder input stream.*/
     ov_callbacks callbacks;
@@ -48,11 +121,25 @@ kwlError kwlInitDecoderOggVorbis(kwlDecoder* decoder)
     callbacks.tell_func = &ovTellCallback;
     callbacks.close_func = &ovCloseCallback;
 
-    int result = ov_open_callbacks(&decoder->audioDataStream, 
-                                   &data->oggVorbisFile, 
-                                   NULL, 
-                                   0, 
-                                   callbacks);
+    /*Parse the headers and build the codebooks the first time this audio data is decoded...*/
+    kwlAudioData* audioData = decoder->audioData;
+    if (audioData->sharedDecoderData == NULL)
+    {
+        OggVorbis_File* headers = kwlCreateSharedOggVorbisHeaders(&decoder->audioDataStream, callbacks);
+        if (headers == NULL)
+        {
+            return KWL_UNKNOWN_FILE_FORMAT;
+        }
+        audioData->sharedDecoderData = kwlSharedDecoderData_create(headers, kwlFreeSharedOggVorbisHeaders);
+    }
+    
+    /*...and open a file that only owns the per stream decoding state.*/
+    data->sharedHeaders = audioData->sharedDecoderData;
+    kwlSharedDecoderData_retain(data->sharedHeaders);
+    
+    int result = kwlOpenOggVorbisFileWithSharedHeaders(&decoder->audioDataStream,
+                                                       &data->oggVorbisFile,
+                                                       (OggVorbis_File*)data->sharedHeaders->data);
     
     if(result < 0)
     {
@@ -63,9 +150,11 @@ kwlError kwlInitDecoderOggVorbis(kwlDecoder* decoder)
      
     decoder->numChannels = info->channels;
     KWL_ASSERT(decoder->numChannels == 1 || decoder->numChannels == 2);
+    decoder->sampleRate = (int)info->rate;
+    decoder->bytesPerSecond = info->bitrate_nominal > 0 ? (int)(info->bitrate_nominal / 8) : 0;
     /*printf("opened ov stream, %d channels\n", decoder->numChannels);*/
     
-    decoder->maxDecodedBufferSize = KWL_OGG_NUM_BUFFERED_FRAMES; //TODO: really frames?
+    decoder->maxDecodedBufferSize = decoder->config->oggVorbisDecoderBufferSize;
     
     
     
@@ -75,8 +164,11 @@ kwlError kwlInitDecoderOggVorbis(kwlDecoder* decoder)
 void kwlDeinitDecoderOggVorbis(kwlDecoder* decoder)
 {
     kwlOggVorbisDecoderData* data = (kwlOggVorbisDecoderData*)decoder->codecData;
-    OggVorbis_File* file = &data->oggVorbisFile;
-    ov_clear(file);
+    kwlClearOggVorbisFileWithSharedHeaders(&data->oggVorbisFile);
+    if (data->sharedHeaders != NULL)
+    {
+        kwlSharedDecoderData_release(data->sharedHeaders);
+    }
     KWL_FREE(decoder->codecData);
 }
 
@@ -84,6 +176,12 @@ int kwlDecodeBufferOggVorbis(kwlDecoder* decoder)
 {
     kwlOggVorbisDecoderData* data = (kwlOggVorbisDecoderData*)decoder->codecData;
     
+    const int bytesPerFrame = 2 * decoder->numChannels;
+    /*the frame at which decoding wraps around to the loop start, or zero for the end of the stream.*/
+    const ogg_int64_t endFrame = decoder->loop != 0 ? decoder->loopEnd : 0;
+    int numBytesSinceRewind = 0;
+    int hasRewound = 0;
+    
     /*clear the buffer of decoded samples...*/
     decoder->currentDecodedBufferSizeInBytes = 0;
     kwlMemset(decoder->currentDecodedBuffer, 0, decoder->maxDecodedBufferSize);
@@ -93,24 +191,51 @@ int kwlDecodeBufferOggVorbis(kwlDecoder* decoder)
     while (decoder->currentDecodedBufferSizeInBytes < decoder->maxDecodedBufferSize)
     {
         int currentSection;
-        /*dont request more bytes than we need to fill the current output buffer.*/
+        /*dont request more bytes than we need to fill the current output buffer
+          or to reach the end of the loop region.*/
         int bytesToRead = decoder->maxDecodedBufferSize - decoder->currentDecodedBufferSizeInBytes;
-        int numReadBytes = ov_read(&data->oggVorbisFile, 
+        if (endFrame > 0 && (endFrame - data->currentFrame) * bytesPerFrame < bytesToRead)
+        {
+            bytesToRead = (int)(endFrame - data->currentFrame) * bytesPerFrame;
+        }
+        
+        int numReadBytes = 0;
+        if (bytesToRead > 0)
+        {
+            numReadBytes = ov_read(&data->oggVorbisFile, 
                                    (char*)(&decoder->currentDecodedBuffer[decoder->currentDecodedBufferSizeInBytes >> 1]), 
                                    bytesToRead, 
                                    &currentSection);
+        }
+        
+        if (numReadBytes < 0)
+        {
+            KWL_ASSERT(0 && "error reading ogg vorbis stream ");
+            return 1; /*TODO: handle diffrently?*/
+        }
+        
         decoder->currentDecodedBufferSizeInBytes += numReadBytes;
+        data->currentFrame += numReadBytes / bytesPerFrame;
+        numBytesSinceRewind += numReadBytes;
         /*printf("decoder->currentDecodedBufferSizeInBytes %d\n", decoder->currentDecodedBufferSizeInBytes);*/
-        if (numReadBytes == 0)
+        
+        if (numReadBytes > 0 && (endFrame == 0 || data->currentFrame < endFrame))
         {
-            /*end of file reached, signal that the stream has been fully decoded.*/
-            return 1;
+            continue;
         }
-        else if (numReadBytes < 1)
+        
+        /*The end of the stream or the loop region was reached. Seek to the start of the
+          loop region and keep filling the buffer, unless not looping or the region is empty.*/
+        if (decoder->loop == 0 ||
+            (hasRewound != 0 && numBytesSinceRewind == 0) ||
+            kwlRewindDecoderOggVorbis(decoder) == 0)
         {
-            KWL_ASSERT(0 && "error reading ogg vorbis stream ");
-            return 1; /*TODO: handle diffrently?*/
+            /*end of file reached, signal that the stream has been fully decoded.*/
+            return 1;
         }
+        
+        hasRewound = 1;
+        numBytesSinceRewind = 0;
     }
     
     /*if we made it here, a new buffer was decoded without problems and without reaching the
@@ -148,9 +273,25 @@ long ovTellCallback(void *datasource)
 int kwlRewindDecoderOggVorbis(kwlDecoder* decoder)
 {
     kwlOggVorbisDecoderData* data = (kwlOggVorbisDecoderData*)decoder->codecData;
-    int result = ov_pcm_seek(&data->oggVorbisFile, 0);
+    
+    /*the seek is sample accurate, so decoding continues at the exact start of the loop region.*/
+    ogg_int64_t loopStart = decoder->loopStart;
+    if (loopStart >= ov_pcm_total(&data->oggVorbisFile, -1))
+    {
+        loopStart = 0;
+    }
+    
+    return kwlSeekDecoderOggVorbis(decoder, (int)loopStart);
+}
+
+int kwlSeekDecoderOggVorbis(kwlDecoder* decoder, int frame)
+{
+    kwlOggVorbisDecoderData* data = (kwlOggVorbisDecoderData*)decoder->codecData;
+    
+    int result = ov_pcm_seek(&data->oggVorbisFile, frame);
     if (result == 0)
     {
+        data->currentFrame = frame;
         return 1;
     }
     else
@@ -36,9 +36,6 @@ extern "C"
 {
 #endif /* __cplusplus */
 
-//TODO: set properly
-static const int KWL_OGG_NUM_BUFFERED_FRAMES = 4096 << 5;
-
 /** 
  * A struct encapsulating the state of an Ogg Vorbis (http://www.vorbis.com/faq/ ) stream decoder. 
  * The tremor library (http://wiki.xiph.org/index.php/Tremor ) is used to do the 
@@ -46,8 +43,18 @@ static const int KWL_OGG_NUM_BUFFERED_FRAMES = 4096 << 5;
  */
 typedef struct
 {
-    /** The Ogg Vorbis file providing encoded data.*/
+    /** 
+     * The Ogg Vorbis file providing encoded data. Its stream headers and 
+     * codebooks are owned by \c sharedHeaders.
+     */
     OggVorbis_File oggVorbisFile;
+    /** 
+     * The parsed headers and codebooks of the audio data, shared by all 
+     * decoders of the same audio data.
+     */
+    kwlSharedDecoderData* sharedHeaders;
+    /** The index of the next frame to decode.*/
+    ogg_int64_t currentFrame;
 } kwlOggVorbisDecoderData;
 
 /** 
@@ -65,7 +72,8 @@ kwlError kwlInitDecoderOggVorbis(kwlDecoder* decoder);
 void kwlDeinitDecoderOggVorbis(kwlDecoder* decoder);
     
 /** 
- * Fills the output buffer of the decoder with new decoded samples.
+ * Fills the output buffer of the decoder with new decoded samples. If the decoder
+ * is looping, the end of the loop region is followed by its start in the same buffer.
  * @param decoder The decoder to use.
  * @return Non-zero if the end of the stream is reached, zero otherwise.
  */
@@ -106,6 +114,12 @@ int ovCloseCallback(void *datasource);
 long ovTellCallback(void *datasource);
 
 int kwlRewindDecoderOggVorbis(kwlDecoder* decoder);
+
+/**
+ * Moves a given Ogg Vorbis decoder to a given frame. The seek is sample accurate.
+ * @return Non-zero on success, zero otherwise.
+ */
+int kwlSeekDecoderOggVorbis(kwlDecoder* decoder, int frame);
     
 #ifdef __cplusplus
 }
@@ -29,7 +29,7 @@ kwlError kwlInitDecoderPCM(kwlDecoder* decoder)
 {
     /*Allocate decoder data.*/
     kwlPCMDecoderData* data = 
-        (kwlPCMDecoderData*)KWL_MALLOC(sizeof(kwlPCMDecoderData), "pcm decoder data");
+        (kwlPCMDecoderData*)KWL_MALLOC(sizeof(kwlPCMDecoderData), KWL_MEMORY_CATEGORY_DECODER, "pcm decoder data");
     kwlMemset(data, 0, sizeof(kwlPCMDecoderData));
 
     /* Hook up data and callbacks to the decoder.*/
@@ -37,6 +37,7 @@ kwlError kwlInitDecoderPCM(kwlDecoder* decoder)
     decoder->decodeBuffer = kwlDecodeBufferPCM;
     decoder->deinit = kwlDeinitDecoderPCM;
     decoder->rewind = kwlRewindDecoderPCM;
+    decoder->seek = kwlSeekDecoderPCM;
     
     kwlError result = kwlLoadAIFFFromStream(&decoder->audioDataStream, 
                                             &data->pcmDataDescription,
@@ -94,10 +95,20 @@ kwlError kwlInitDecoderPCM(kwlDecoder* decoder)
         return KWL_UNSUPPORTED_ENCODING;
     }
     
-    decoder->maxDecodedBufferSize = 4096 >> 1;
+    decoder->maxDecodedBufferSize = decoder->config->pcmDecoderBufferSize;
     decoder->numChannels = data->pcmDataDescription.numChannels;
-    data->scratchBufferNumBytes = decoder->maxDecodedBufferSize;//TODO:make this work for all encodings!
-    data->scratchBuffer = (char*)KWL_MALLOC(data->scratchBufferNumBytes, "pcm decoder scratch buffer");
+    if (data->pcmDataDescription.sampleRate > 0)
+    {
+        decoder->sampleRate = data->pcmDataDescription.sampleRate;
+    }
+    
+    /*the scratch buffer holds the encoded frames of one buffer of 16 bit output samples.*/
+    const int maxNumFrames = decoder->maxDecodedBufferSize / (2 * decoder->numChannels);
+    data->bytesPerFrame = data->bytesPerSample * decoder->numChannels;
+    decoder->bytesPerSecond = data->bytesPerFrame * decoder->sampleRate;
+    data->scratchBufferNumBytes = maxNumFrames * data->bytesPerFrame;
+    data->scratchBuffer = (char*)KWL_MALLOC(data->scratchBufferNumBytes, KWL_MEMORY_CATEGORY_DECODER, "pcm decoder scratch buffer");
+    data->currentFrame = 0;
     
     return KWL_NO_ERROR;
 }
@@ -122,58 +133,106 @@ int kwlDecodeBufferPCM(kwlDecoder* decoder)
 {
     kwlPCMDecoderData* data = (kwlPCMDecoderData*)decoder->codecData;
     
-    /*Read a new chunk of data into the scratch buffer*/
-    int numBytesRead = kwlInputStream_read(&decoder->audioDataStream, 
-                                           data->scratchBuffer, 
-                                           data->scratchBufferNumBytes);
+    const int bytesPerFrame = data->bytesPerFrame;
+    const int maxNumFrames = data->scratchBufferNumBytes / bytesPerFrame;
+    /*the number of frames in the stream, or zero if not known.*/
+    const int numFramesInStream = data->pcmDataDescription.numFrames;
+    
+    /*the frame at which reading stops or wraps around to the loop start.*/
+    int endFrame = numFramesInStream;
+    if (decoder->loop != 0 && decoder->loopEnd > 0 &&
+        (endFrame == 0 || decoder->loopEnd < endFrame))
+    {
+        endFrame = decoder->loopEnd;
+    }
+    
+    int endOfData = 0;
+    int numFramesDecoded = 0;
+    int numFramesSinceRewind = 0;
+    int hasRewound = 0;
+    
+    /*Read new chunks of data into the scratch buffer until it is full. When looping,
+      the start of the loop region is read right after its end.*/
+    while (numFramesDecoded < maxNumFrames)
+    {
+        int numFramesToRead = maxNumFrames - numFramesDecoded;
+        if (endFrame > 0 && data->currentFrame + numFramesToRead > endFrame)
+        {
+            numFramesToRead = endFrame - data->currentFrame;
+        }
+        
+        int numFramesRead = 0;
+        if (numFramesToRead > 0)
+        {
+            int numBytesRead = kwlInputStream_read(&decoder->audioDataStream, 
+                                                   &data->scratchBuffer[numFramesDecoded * bytesPerFrame], 
+                                                   numFramesToRead * bytesPerFrame);
+            numFramesRead = numBytesRead / bytesPerFrame;
+        }
+        
+        numFramesDecoded += numFramesRead;
+        numFramesSinceRewind += numFramesRead;
+        data->currentFrame += numFramesRead;
+        
+        if (numFramesRead == numFramesToRead &&
+            (endFrame == 0 || data->currentFrame < endFrame))
+        {
+            continue;
+        }
+        
+        /*The end of the stream or the loop region was reached. Stop if not looping or if 
+          the loop region turned out to be empty, otherwise continue from the loop start.*/
+        if (decoder->loop == 0 ||
+            (hasRewound != 0 && numFramesSinceRewind == 0) ||
+            kwlRewindDecoderPCM(decoder) == 0)
+        {
+            endOfData = 1;
+            break;
+        }
+        
+        hasRewound = 1;
+        numFramesSinceRewind = 0;
+    }
+    
+    const int numBytesDecoded = numFramesDecoded * bytesPerFrame;
     
     /*Convert the chunk to signed 16 bit*/
     switch (data->pcmDataDescription.encoding) 
     {
         case KWL_ENCODING_UNSIGNED_8BIT_PCM:
         {
-            KWL_ASSERT(2 * data->scratchBufferNumBytes == decoder->maxDecodedBufferSize);
-            
             kwlUInt8ToInt16(data->scratchBuffer, 
-                            numBytesRead, 
+                            numBytesDecoded, 
                             decoder->currentDecodedBuffer);
             break;
         }
         case KWL_ENCODING_SIGNED_8BIT_PCM:
         {
-            KWL_ASSERT(2 * data->scratchBufferNumBytes == decoder->maxDecodedBufferSize);
-            
             kwlInt8ToInt16(data->scratchBuffer, 
-                           numBytesRead, 
+                           numBytesDecoded, 
                            decoder->currentDecodedBuffer);
             break;
         }
         case KWL_ENCODING_SIGNED_16BIT_PCM:
         {
-            KWL_ASSERT(data->scratchBufferNumBytes == decoder->maxDecodedBufferSize);
-            
             kwlInt16ToInt16(data->scratchBuffer, 
-                            numBytesRead, 
+                            numBytesDecoded, 
                             decoder->currentDecodedBuffer, 
                             data->pcmDataDescription.isBigEndian);
             break;
         }
         case KWL_ENCODING_SIGNED_24BIT_PCM:
         {
-            KWL_ASSERT(2 * data->scratchBufferNumBytes == 3 * decoder->maxDecodedBufferSize);
-            
             kwlInt24ToInt16(data->scratchBuffer, 
-                            numBytesRead, 
+                            numBytesDecoded, 
                             decoder->currentDecodedBuffer, 
                             data->pcmDataDescription.isBigEndian);
             break;
         }
         case KWL_ENCODING_SIGNED_32BIT_PCM:
         {
-            KWL_ASSERT(data->scratchBufferNumBytes == 2 * decoder->maxDecodedBufferSize);
-            
             kwlInt32ToInt16(data->scratchBuffer, 
-                            numBytesRead, 
+                            numBytesDecoded, 
                             decoder->currentDecodedBuffer, 
                             data->pcmDataDescription.isBigEndian);
             break;
@@ -184,20 +243,42 @@ int kwlDecodeBufferPCM(kwlDecoder* decoder)
         }
     }
     
-    decoder->currentDecodedBufferSizeInBytes = numBytesRead;
+    /*2 bytes per decoded 16 bit sample, regardless of the source encoding.*/
+    decoder->currentDecodedBufferSizeInBytes = 2 * numFramesDecoded * decoder->numChannels;
     
     /* Return 1 to signal that we reached the end of the audio data, zero otherwise.*/
-    return numBytesRead < decoder->maxDecodedBufferSize ? 1 : 0;
+    return endOfData;
 }
 
 int kwlRewindDecoderPCM(kwlDecoder* decoder)
 {
     kwlPCMDecoderData* data = (kwlPCMDecoderData*)decoder->codecData;
     
-    /*seek to the first sample*/
+    int loopStart = decoder->loopStart;
+    if (data->pcmDataDescription.numFrames > 0 && 
+        loopStart >= data->pcmDataDescription.numFrames)
+    {
+        loopStart = 0;
+    }
+    
+    /*seek to the first sample of the loop region*/
+    return kwlSeekDecoderPCM(decoder, loopStart);
+}
+
+int kwlSeekDecoderPCM(kwlDecoder* decoder, int frame)
+{
+    kwlPCMDecoderData* data = (kwlPCMDecoderData*)decoder->codecData;
+    
+    if (data->pcmDataDescription.numFrames > 0 && 
+        frame > data->pcmDataDescription.numFrames)
+    {
+        return 0;
+    }
+    
     KWL_ASSERT(data->pcmDataDescription.fileOffset > 0);
     kwlInputStream_seek(&decoder->audioDataStream, 
-                        data->pcmDataDescription.fileOffset, 
+                        data->pcmDataDescription.fileOffset + frame * data->bytesPerFrame, 
                         SEEK_SET);
+    data->currentFrame = frame;
     return 1;
 }
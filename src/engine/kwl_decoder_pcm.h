@@ -44,6 +44,10 @@ typedef struct
     char* scratchBuffer;
     int scratchBufferNumBytes;
     int bytesPerSample;
+    /** The size of an encoded frame in bytes.*/
+    int bytesPerFrame;
+    /** The index of the next frame to read from the stream.*/
+    int currentFrame;
 } kwlPCMDecoderData;
     
 /** 
@@ -61,13 +65,27 @@ kwlError kwlInitDecoderPCM(kwlDecoder* decoder);
 void kwlDeinitDecoderPCM(kwlDecoder* decoder);
 
 /** 
- * Fills the output buffer of the decoder with new decoded samples.
+ * Fills the output buffer of the decoder with new decoded samples. If the decoder
+ * is looping, the end of the loop region is followed by its start in the same buffer.
  * @param decoder The decoder to use.
  * @return Non-zero if the end of the stream is reached, zero otherwise.
  */
 int kwlDecodeBufferPCM(kwlDecoder* decoder);
-    
+
+/** 
+ * Moves the read position of a given PCM decoder to the start of its loop region.
+ * @param decoder The decoder to rewind.
+ * @return Non-zero on success, zero otherwise.
+ */
 int kwlRewindDecoderPCM(kwlDecoder* decoder);
+
+/** 
+ * Moves the read position of a given PCM decoder to a given frame.
+ * @param decoder The decoder to seek.
+ * @param frame The frame to decode next.
+ * @return Non-zero on success, zero if the frame is past the end of the audio data.
+ */
+int kwlSeekDecoderPCM(kwlDecoder* decoder, int frame);
     
 #ifdef __cplusplus
 }
@@ -24,10 +24,12 @@ freely, subject to the following restrictions:
 #include "kwl_asm.h"
 #include "kwl_audiodata.h"
 #include "kwl_audiofileutil.h"
+#include "kwl_commandbuffer.h"
 #include "kwl_synchronization.h"
 #include "kwl_decoder.h"
 #include "kwl_eventinstance.h"
 #include "kwl_eventdefinition.h"
+#include "kwl_freeformevent.h"
 #include "kwl_memory.h"
 #include "kwl_messagequeue.h"
 #include "kwl_positionalaudiolistener.h"
@@ -38,89 +40,99 @@ freely, subject to the following restrictions:
 
 #include "kwl_assert.h"
 #include <math.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+static kwlError kwlEngine_sendEventStart(kwlEngine* engine, 
+                                         kwlEventInstance* eventToPlay, 
+                                         float fadeInTimeSec,
+                                         long long startFrame);
+static void kwlEngine_stopVirtualEventsReferencingWaveBank(kwlEngine* engine, kwlWaveBank* waveBank);
+static void kwlEngine_retainAudioBuffers(kwlEngine* engine, kwlEventInstance* event);
+static void kwlEngine_releaseAudioBuffers(kwlEngine* engine, kwlEventInstance* event);
+static int kwlEngine_isWaveBankUsedByPlayingEvent(kwlEngine* engine, kwlWaveBank* waveBank);
+static int kwlEngine_growEventHandleSlotArray(kwlEngine* engine, int numSlots);
+static int kwlEngine_allocateEventHandleSlot(kwlEngine* engine, kwlEventInstance* event, int isFreeform);
+static void kwlEngine_freeEventHandleSlot(kwlEngine* engine, int slotIndex);
+static void kwlEngine_releaseDataEventHandles(kwlEngine* engine);
+static void kwlEngine_cancelEngineDataReload(kwlEngine* engine);
+static void kwlEngine_processMixerMessages(kwlEngine* engine);
+
 int kwlEngine_isFreeformEventHandle(kwlEngine* engine, kwlEventHandle handle)
 {
-    int mask = 1 << 31;
-    int isFreeForm = handle & mask;
-    return isFreeForm;
+    const kwlEventHandleBits bits = (kwlEventHandleBits)handle;
+    return (int)((bits >> (8 * sizeof(kwlEventHandleBits) - 1)) & 1);
 }
 
-int kwlEngine_getFreeformIndexFromHandle(kwlEngine* engine, kwlEventHandle handle)
+int kwlEngine_getSlotIndexFromHandle(kwlEngine* engine, kwlEventHandle handle)
 {
-    return handle & 0xffff;
+    return (int)((kwlEventHandleBits)handle & KWL_EVENT_HANDLE_INDEX_MASK);
 }
 
 kwlEventInstance* kwlEngine_getEventFromHandle(kwlEngine* engine, kwlEventHandle handle)
 {
+    if (handle == KWL_INVALID_HANDLE)
+    {
+        return NULL;
+    }
+    
+    const kwlEventHandleBits bits = (kwlEventHandleBits)handle;
+    const kwlEventHandleBits index = bits & KWL_EVENT_HANDLE_INDEX_MASK;
+    const unsigned int generation = 
+        (unsigned int)((bits >> KWL_EVENT_HANDLE_NUM_INDEX_BITS) & KWL_EVENT_HANDLE_GENERATION_MASK);
     kwlEventInstance* event = NULL;
     
-    if (kwlEngine_isFreeformEventHandle(engine, handle))
+    if (index < (kwlEventHandleBits)engine->eventHandleSlotArraySize)
     {
-        int freeformEventIndex = handle & 0xffff;
-        if (freeformEventIndex >= 0 &&
-            freeformEventIndex < engine->freeformEventArraySize)
+        kwlEventHandleSlot* slot = &engine->eventHandleSlots[index];
+        if (slot->generation == generation &&
+            slot->isFreeform == kwlEngine_isFreeformEventHandle(engine, handle))
         {
-            event = engine->freeformEvents[freeformEventIndex];
+            event = slot->event;
         }
     }
-    else
-    {
-        int eventDefinitionIndex = handle & 0xffff;
-        int eventInstanceIndex = (handle & 0x7fff) >> 16;
-        
-        if (eventDefinitionIndex >= 0 && 
-            eventDefinitionIndex < engine->engineData.numEventDefinitions)
-        {
-            if (eventInstanceIndex >= 0 && 
-                eventInstanceIndex < engine->engineData.eventDefinitions[eventDefinitionIndex].instanceCount)
-            {
-                event = &engine->engineData.events[eventDefinitionIndex][eventInstanceIndex];
-            }
-        }
-    }    
-    /* A return value of NULL is valid and means that the event handle was invalid.*/
+    
+    /* A return value of NULL is valid and means that the event handle was invalid or stale.*/
     return event;
 }
 
 /** */
-kwlEventHandle computeEventHandle(int eventDefinitionOrFreeformIndex, int eventInstanceIndex, int isFreeForm)
+kwlEventHandle computeEventHandle(int slotIndex, unsigned int generation, int isFreeForm)
 {
     /*
      The event handle uniquely indentifies an event instance that could either 
-     be loaded from data or created in code as a freeform event. A data event
-     is uniquely defined by an event definition index and an event instance index
-     and a freeform event by its index into the array of freeform events.
+     be loaded from data or created in code as a freeform event. Both kinds of
+     events are identified by the index of their slot in the array of event
+     handle slots.
      
-     An event handle is a 32 bit int encoded as follows:
+     By default, an event handle is a 32 bit int encoded as follows:
      
-     bit number |        32             |  31  |  ...  |  17  |  16  |  ...  |  1  |
+     bit number |        32             |  31  |  ...  |  21  |  20  |  ...  |  1  |
                 |-----------------------|-------------------------------------------
-                |0 for data events      |these 15 bits encode |these 16 bits encode the 
-                |1 for freeform events  |the event instance   |event definition index for data
-                |                       |index and are zero   |events and the array index for 
-                |                       |for freeform events  |freeform events.
+                |0 for data events      |these 11 bits encode |these 20 bits encode the 
+                |1 for freeform events  |the generation of    |index of the event 
+                |                       |the slot             |handle slot.
      
-     This encoding scheme means that the maximum number of event instances per definition is 32767
-     and the maximum number of event definitions and freeform events is 65535.
+     With KWL_64_BIT_EVENT_HANDLES defined, handles are 64 bit with 31 generation bits 
+     and 32 index bits. The last index is never used, so that no valid handle equals
+     KWL_INVALID_HANDLE.
      
-     KWL_INVALID_HANDLE = 0xffffffff is used to represent invalid handles.
+     Resolving a handle is a bounds check, an array lookup and a comparison of generations
+     and event kinds.
      */
     
-    KWL_ASSERT(eventDefinitionOrFreeformIndex >= 0);
-    KWL_ASSERT(eventInstanceIndex >= 0);
-    KWL_ASSERT(eventDefinitionOrFreeformIndex < (1 << 16));
-    KWL_ASSERT(eventInstanceIndex < (1 << 15));
+    KWL_ASSERT(slotIndex >= 0);
+    KWL_ASSERT(slotIndex < KWL_EVENT_HANDLE_NUM_INDICES);
+    KWL_ASSERT((generation & ~KWL_EVENT_HANDLE_GENERATION_MASK) == 0);
     
-    int bit32 = (isFreeForm != 0 ? 1 : 0) << 31;
-    int bits31To17 = eventInstanceIndex << 16;
-    int bits1To16 = eventDefinitionOrFreeformIndex;
+    const kwlEventHandleBits freeformBit = 
+        (kwlEventHandleBits)(isFreeForm != 0 ? 1 : 0) << (8 * sizeof(kwlEventHandleBits) - 1);
+    const kwlEventHandleBits generationBits = 
+        ((kwlEventHandleBits)generation & KWL_EVENT_HANDLE_GENERATION_MASK) << KWL_EVENT_HANDLE_NUM_INDEX_BITS;
+    const kwlEventHandleBits indexBits = (kwlEventHandleBits)slotIndex;
     
-    int handle = bit32 | bits31To17 | bits1To16;
-    /*printf("computing event handle: dIdx=%d, iIdx=%d, handle=%d\n", eventDefinitionIndex, eventInstanceIndex, handle);*/
-    return handle;
+    return (kwlEventHandle)(freeformBit | generationBits | indexBits);
 }
 
 kwlWaveBankHandle kwlEngine_getHandleFromWaveBank(kwlEngine* engine, kwlWaveBank* waveBank)
@@ -142,19 +154,56 @@ kwlWaveBankHandle kwlEngine_getHandleFromWaveBank(kwlEngine* engine, kwlWaveBank
     return KWL_INVALID_HANDLE;
 }
 
+void kwlEngine_getDefaultConfig(kwlEngineConfig* config)
+{
+    kwlMemset(config, 0, sizeof(kwlEngineConfig));
+    config->numDecoders = KWL_NUM_DECODERS;
+    config->numInlineDecoders = KWL_NUM_INLINE_DECODERS;
+    config->pcmDecoderBufferSize = KWL_PCM_DECODER_BUFFER_SIZE;
+    config->oggVorbisDecoderBufferSize = KWL_OGG_VORBIS_DECODER_BUFFER_SIZE;
+    config->messageQueueSize = KWL_MESSAGE_QUEUE_SIZE;
+    config->mixBufferSizeInFrames = KWL_TEMP_BUFFER_SIZE_IN_FRAMES;
+    config->numPreallocatedFreeformEvents = KWL_NUM_PREALLOCATED_FREEFORM_EVENTS;
+    config->freeformEventPoolChunkSize = KWL_FREEFORM_EVENT_POOL_CHUNK_SIZE;
+    config->debugAllocationTableSize = KWL_DEBUG_ALLOCATION_TABLE_INITIAL_SIZE;
+}
+
+kwlError kwlEngine_validateConfig(const kwlEngineConfig* config)
+{
+    /*a decoder buffer must hold at least one frame of 16 bit stereo audio.*/
+    const int minDecoderBufferSize = 2 * sizeof(short);
+    
+    if (config->numDecoders <= 0 ||
+        config->numInlineDecoders <= 0 ||
+        config->pcmDecoderBufferSize < minDecoderBufferSize ||
+        config->oggVorbisDecoderBufferSize < minDecoderBufferSize ||
+        config->messageQueueSize <= 0 ||
+        config->mixBufferSizeInFrames <= 0 ||
+        config->numPreallocatedFreeformEvents < 0 ||
+        config->freeformEventPoolChunkSize <= 0 ||
+        config->debugAllocationTableSize <= 0)
+    {
+        return KWL_INVALID_PARAMETER_VALUE;
+    }
+    
+    return KWL_NO_ERROR;
+}
+
 /** */
 void kwlEngine_init(kwlEngine* engine)
 {
+    const kwlEngineConfig* config = &engine->config;
+    
     /*create message queues*/
-    kwlMessageQueue_init(&engine->toMixerQueue);
-    kwlMessageQueue_init(&engine->toMixerQueueShared);
-    kwlMessageQueue_init(&engine->fromMixerQueue);
+    kwlMessageQueue_init(&engine->toMixerQueue, config->messageQueueSize);
+    kwlMessageQueue_init(&engine->toMixerQueueShared, config->messageQueueSize);
+    kwlMessageQueue_init(&engine->fromMixerQueue, config->messageQueueSize);
     
-    kwlMessageQueue_init(&engine->wavebankLoadingQueue);
-    kwlMessageQueue_init(&engine->wavebankLoadingQueueShared);
+    kwlMessageQueue_init(&engine->wavebankLoadingQueue, config->messageQueueSize);
+    kwlMessageQueue_init(&engine->wavebankLoadingQueueShared, config->messageQueueSize);
     
     /*create the software mixer*/
-    engine->mixer = kwlMixer_new();
+    engine->mixer = kwlMixer_new(config->messageQueueSize);
     engine->mixer->engine = engine;
     
     /*init positional audio listener and settings */
@@ -167,59 +216,186 @@ void kwlEngine_init(kwlEngine* engine)
     engine->engineData.mixBuses = NULL;    
     engine->engineData.masterBus = NULL;
     
-    engine->freeformEventArraySize = 0;
-    engine->freeformEvents = NULL;
+    engine->eventHandleSlotArraySize = 0;
+    engine->eventHandleSlots = NULL;
+    engine->freeEventHandleSlots = NULL;
+    engine->firstFreeEventHandleSlot = 0;
+    engine->numFreeEventHandleSlots = 0;
+    
+    /*preallocate freeform events so creating them does not allocate until the pool runs out*/
+    kwlFreeformEventPool_init(&engine->freeformEventPool, 
+                              config->numPreallocatedFreeformEvents, 
+                              config->freeformEventPoolChunkSize);
+    kwlEngine_growEventHandleSlotArray(engine, config->numPreallocatedFreeformEvents);
     
-    int KWL_NUM_DECODERS = 10;
-    engine->numDecoders = KWL_NUM_DECODERS;
-    engine->decoders = (kwlDecoder*)KWL_MALLOC(sizeof(kwlDecoder) * KWL_NUM_DECODERS, "decoders");
-    kwlMemset(engine->decoders, 0, sizeof(kwlDecoder) * KWL_NUM_DECODERS);
+    engine->numDecoders = config->numDecoders;
+    engine->decoders = (kwlDecoder*)KWL_MALLOC(sizeof(kwlDecoder) * engine->numDecoders, KWL_MEMORY_CATEGORY_DECODER, "decoders");
+    kwlMemset(engine->decoders, 0, sizeof(kwlDecoder) * engine->numDecoders);
+    
+    engine->numInlineDecoders = config->numInlineDecoders;
+    engine->inlineDecoders = (kwlDecoder*)KWL_MALLOC(sizeof(kwlDecoder) * engine->numInlineDecoders, KWL_MEMORY_CATEGORY_DECODER, "inline decoders");
+    kwlMemset(engine->inlineDecoders, 0, sizeof(kwlDecoder) * engine->numInlineDecoders);
     
     //set up main mutex lock
     kwlMutexLockInit(&engine->mixerEngineMutexLock);
     engine->mixer->mixerEngineMutexLock = &engine->mixerEngineMutexLock;
     
+    //set up the semaphore the engine thread waits on for unloads to complete
+    sprintf(engine->mixerMessageSemaphoreName, "kwlengine%d", (int)(size_t)engine);
+    engine->mixerMessageSemaphore = kwlSemaphoreOpen(engine->mixerMessageSemaphoreName);
+    engine->mixer->mixerMessageSemaphore = engine->mixerMessageSemaphore;
+    engine->mixer->isEngineWaitingForMessages = 0;
+    
+    engine->pendingUnloads = NULL;
+    engine->numPendingUnloads = 0;
+    engine->pendingUnloadArraySize = 0;
+    
+    engine->pendingReload.state = KWL_RELOAD_IDLE;
+    kwlMutexLockInit(&engine->pendingReload.lock);
+    
     //set up wavebank loading mutex
     kwlMutexLockInit(&engine->wavebankLoadingMutexLock);
+    
+    //read files with the C standard library unless other file system callbacks were given
+    if (engine->fileSystem.open == NULL)
+    {
+        engine->fileSystem = *kwlFileSystem_getDefault();
+    }
+    
+    //start the thread reading data for streaming decoders
+    kwlStreamingIO_init(&engine->streamingIO, &engine->fileSystem);
+    
+    kwlResidency_init(&engine->residency);
+    
+    /*use the audio data cache of another engine, if one was given, or a cache of its own*/
+    if (engine->audioDataCache != NULL)
+    {
+        kwlAudioDataCache_retain(engine->audioDataCache);
+    }
+    else
+    {
+        engine->audioDataCache = kwlAudioDataCache_new();
+    }
 }
 
 void kwlEngine_free(kwlEngine* engine)
 {
     KWL_ASSERT(engine != NULL);
     
+    kwlEngine_cancelEngineDataReload(engine);
+    
     kwlMessageQueue_free(&engine->toMixerQueue);
     kwlMessageQueue_free(&engine->toMixerQueueShared);
     kwlMessageQueue_free(&engine->fromMixerQueue);
     
+    kwlMessageQueue_free(&engine->wavebankLoadingQueue);
+    kwlMessageQueue_free(&engine->wavebankLoadingQueueShared);
+    
+    kwlMixer_free(engine->mixer);
+    engine->mixer = NULL;
+    
+    /*release the data of any freeform events the host did not release*/
+    if (engine->engineData.isLoaded != 0)
+    {
+        kwlEngine_releaseDataEventHandles(engine);
+    }
+    int i;
+    for (i = 0; i < engine->eventHandleSlotArraySize; i++)
+    {
+        if (engine->eventHandleSlots[i].event != NULL && engine->eventHandleSlots[i].isFreeform != 0)
+        {
+            kwlEventInstance_releaseFreeformEvent(&engine->freeformEventPool, engine->eventHandleSlots[i].event);
+        }
+    }
+    kwlFreeformEventPool_free(&engine->freeformEventPool);
+    
+    if (engine->eventHandleSlots != NULL)
+    {
+        KWL_FREE(engine->eventHandleSlots);
+        KWL_FREE(engine->freeEventHandleSlots);
+        engine->eventHandleSlots = NULL;
+        engine->freeEventHandleSlots = NULL;
+        engine->eventHandleSlotArraySize = 0;
+        engine->firstFreeEventHandleSlot = 0;
+        engine->numFreeEventHandleSlots = 0;
+    }
+    
     KWL_FREE(engine->decoders);
+    KWL_FREE(engine->inlineDecoders);
+    
+    if (engine->pendingUnloads != NULL)
+    {
+        KWL_FREE(engine->pendingUnloads);
+        engine->pendingUnloads = NULL;
+        engine->numPendingUnloads = 0;
+        engine->pendingUnloadArraySize = 0;
+    }
+    kwlSemaphoreDestroy(engine->mixerMessageSemaphore, engine->mixerMessageSemaphoreName);
+    
+    kwlStreamingIO_free(&engine->streamingIO);
+    
+    while (engine->commandBuffers != NULL)
+    {
+        kwlCommandBuffer* nextBuffer = engine->commandBuffers->next;
+        kwlCommandBuffer_free(engine->commandBuffers);
+        KWL_FREE(engine->commandBuffers);
+        engine->commandBuffers = nextBuffer;
+    }
+    
+    kwlAudioDataCache_release(engine->audioDataCache);
+    engine->audioDataCache = NULL;
 }
 
 kwlError kwlEngine_loadWaveBank(kwlEngine* engine, 
                                      const char* const waveBankPath, 
                                      kwlWaveBankHandle* handle,
-                                     int threaded)
+                                     int threaded,
+                                     int loadOnDemand)
 {
     if (!engine->engineData.isLoaded)
     {
         return KWL_ENGINE_DATA_NOT_LOADED;
     }
     
-    /*TODO: handle the case of more than one wave bank sharing a piece of audio data.*/
-
-    /* Check that we have a valid wave bank binary file and that its entries match those
-       in engine data.*/
-    kwlWaveBank* matchingWaveBank = NULL;
-    kwlError verifyResult = kwlWaveBank_verifyWaveBankBinary(engine, waveBankPath, &matchingWaveBank);
+    /* Check that we have a valid wave bank binary file matching a wave bank in engine data.
+       The entries are matched while loading them.*/
+    kwlInputStream stream;
+    kwlError openResult = kwlInputStream_initWithFile(&stream, waveBankPath, &engine->fileSystem);
+    if (openResult != KWL_NO_ERROR)
+    {
+        kwlInputStream_close(&stream);
+        return openResult;
+    }
     
-    if (verifyResult != KWL_NO_ERROR)
+    kwlWaveBank* matchingWaveBank = NULL;
+    kwlError headerResult = kwlWaveBank_readWaveBankBinaryHeader(engine, &stream, &matchingWaveBank);
+    if (headerResult != KWL_NO_ERROR)
     {
-        return verifyResult;
+        kwlInputStream_close(&stream);
+        return headerResult;
     }
     KWL_ASSERT(matchingWaveBank);
+    
+    if (matchingWaveBank->isLoaded != 0)
+    {
+        /*Already loaded. Reloading would leak the audio data and, for wave banks 
+          loaded on demand, the open wave bank file.*/
+        kwlInputStream_close(&stream);
+        if (handle != NULL)
+        {
+            *handle = kwlEngine_getHandleFromWaveBank(engine, matchingWaveBank);
+        }
+        return KWL_NO_ERROR;
+    }
 
-    /*If we made it this far, the wave bank binary data lines up with a wave
+    /*If we made it this far, the wave bank binary data belongs to a wave
      bank structure of the engine so we're ready to load the audio data.*/
-    kwlError result = kwlWaveBank_loadAudioData(matchingWaveBank, waveBankPath, threaded);
+    kwlError result = kwlWaveBank_loadAudioData(matchingWaveBank, 
+                                                engine->audioDataCache,
+                                                waveBankPath, 
+                                                &stream,
+                                                threaded, 
+                                                loadOnDemand);
         
     /*Only care about the handle if this is a blocking call. For non-blocking calls,
       it gets passed to the loading finished callback.*/
@@ -309,7 +485,213 @@ kwlError kwlEngine_waveBankIsReferencedByPlayingEvent(kwlEngine* engine, kwlWave
     return KWL_NO_ERROR;
 }
 
-kwlError kwlEngine_requestUnloadWaveBank(kwlEngine* engine, kwlWaveBankHandle handle, int blockUntilUnloaded)
+kwlError kwlEngine_waveBankGetPrefetchHeadMemory(kwlEngine* engine, kwlWaveBankHandle handle, int* numBytes)
+{
+    if (engine->engineData.isLoaded == 0)
+    {
+        return KWL_ENGINE_DATA_NOT_LOADED;
+    }
+    
+    if (handle < 0 || handle >= engine->engineData.numWaveBanks || handle == KWL_INVALID_HANDLE)
+    {
+        return KWL_INVALID_WAVE_BANK_HANDLE;
+    }
+    
+    *numBytes = kwlWaveBank_getPrefetchHeadMemory(&engine->engineData.waveBanks[handle]);
+    return KWL_NO_ERROR;
+}
+
+/** 
+ * Adds a pending unload of a given wave bank, or of engine data if \c waveBank is NULL,
+ * in a given state. 
+ */
+static kwlPendingUnload* kwlEngine_addPendingUnload(kwlEngine* engine,
+                                                    kwlWaveBank* waveBank,
+                                                    kwlUnloadState state,
+                                                    kwlUnloadCompletedCallback callback,
+                                                    void* userData)
+{
+    if (engine->numPendingUnloads == engine->pendingUnloadArraySize)
+    {
+        const int newSize = engine->pendingUnloadArraySize == 0 ? 8 : 2 * engine->pendingUnloadArraySize;
+        engine->pendingUnloads = (kwlPendingUnload*)KWL_REALLOC(engine->pendingUnloads, 
+                                                                newSize * sizeof(kwlPendingUnload),
+                                                                KWL_MEMORY_CATEGORY_GENERAL,
+                                                                "pending unloads");
+        engine->pendingUnloadArraySize = newSize;
+    }
+    
+    kwlPendingUnload* unload = &engine->pendingUnloads[engine->numPendingUnloads];
+    engine->numPendingUnloads++;
+    unload->state = state;
+    unload->waveBank = waveBank;
+    unload->callback = callback;
+    unload->callbackUserData = userData;
+    return unload;
+}
+
+/** 
+ * Returns non-zero if an unload of a given wave bank, or of engine data if \c waveBank is NULL,
+ * has been requested and not completed.
+ */
+static int kwlEngine_isUnloadPending(kwlEngine* engine, kwlWaveBank* waveBank)
+{
+    int i;
+    for (i = 0; i < engine->numPendingUnloads; i++)
+    {
+        if (engine->pendingUnloads[i].waveBank == waveBank &&
+            engine->pendingUnloads[i].state != KWL_UNLOAD_COMPLETED)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Sends the message requesting the mixer to stop the events using the data of a given pending
+ * unload. The mixer acknowledges each message once, so no message is sent if the mixer is already
+ * stopping the events for another unload of the same data. If the message queue is full, the 
+ * unload is left in the \c KWL_UNLOAD_SENDING_REQUEST state and the message is resent by
+ * \c kwlEngine_update.
+ */
+static void kwlEngine_sendUnloadRequest(kwlEngine* engine, kwlPendingUnload* unload)
+{
+    int i;
+    for (i = 0; i < engine->numPendingUnloads; i++)
+    {
+        kwlPendingUnload* unloadi = &engine->pendingUnloads[i];
+        if (unloadi != unload && 
+            unloadi->waveBank == unload->waveBank &&
+            unloadi->state == KWL_UNLOAD_WAITING_FOR_MIXER)
+        {
+            unload->state = KWL_UNLOAD_WAITING_FOR_MIXER;
+            return;
+        }
+    }
+    
+    /*For wave banks, the mixer stops all playing events referencing audio data from the wave bank.
+      For engine data, the mixer stops all data driven events and changes its mix bus array to only 
+      contain the always valid master bus. Once the events are stopped, the mixer sends a message back
+      to the engine indicating that it is safe to unload the data.*/
+    int result = 0;
+    if (unload->waveBank != NULL)
+    {
+        result = kwlMessageQueue_addMessage(&engine->toMixerQueue, KWL_STOP_ALL_EVENTS_REFERENCING_WAVE_BANK, unload->waveBank);
+    }
+    else
+    {
+        result = kwlMessageQueue_addMessage(&engine->toMixerQueue, KWL_PREPARE_ENGINE_DATA_UNLOAD, NULL);
+    }
+    
+    if (result != 0)
+    {
+        unload->state = KWL_UNLOAD_WAITING_FOR_MIXER;
+    }
+}
+
+/** Resends any unload requests that did not fit in the message queue.*/
+static void kwlEngine_sendPendingUnloadRequests(kwlEngine* engine)
+{
+    int i;
+    for (i = 0; i < engine->numPendingUnloads; i++)
+    {
+        if (engine->pendingUnloads[i].state == KWL_UNLOAD_SENDING_REQUEST)
+        {
+            kwlEngine_sendUnloadRequest(engine, &engine->pendingUnloads[i]);
+        }
+    }
+}
+
+/** 
+ * Marks the pending unloads of a given wave bank as completed. If \c waveBank is NULL,
+ * engine data has been unloaded and all pending unloads are marked as completed, since 
+ * all wave banks were unloaded with it.
+ */
+static void kwlEngine_completePendingUnloads(kwlEngine* engine, kwlWaveBank* waveBank)
+{
+    int i;
+    for (i = 0; i < engine->numPendingUnloads; i++)
+    {
+        if (waveBank == NULL || engine->pendingUnloads[i].waveBank == waveBank)
+        {
+            engine->pendingUnloads[i].state = KWL_UNLOAD_COMPLETED;
+            engine->pendingUnloads[i].waveBank = NULL;
+        }
+    }
+}
+
+/** 
+ * Removes completed unloads and invokes their callbacks. Each unload is removed before its callback
+ * is invoked, so callbacks may request new unloads.
+ */
+static void kwlEngine_invokeUnloadCallbacks(kwlEngine* engine)
+{
+    int i = 0;
+    while (i < engine->numPendingUnloads)
+    {
+        if (engine->pendingUnloads[i].state != KWL_UNLOAD_COMPLETED)
+        {
+            i++;
+            continue;
+        }
+        
+        const kwlPendingUnload completed = engine->pendingUnloads[i];
+        int j;
+        for (j = i + 1; j < engine->numPendingUnloads; j++)
+        {
+            engine->pendingUnloads[j - 1] = engine->pendingUnloads[j];
+        }
+        engine->numPendingUnloads--;
+        
+        if (completed.callback != NULL)
+        {
+            completed.callback(completed.callbackUserData);
+        }
+    }
+}
+
+/**
+ * Blocks until all unloads of a given wave bank, or of engine data if \c waveBank is NULL,
+ * have completed. Instead of repeatedly updating the engine, the calling thread exchanges
+ * messages with the mixer and sleeps until the mixer passes new messages back.
+ */
+static void kwlEngine_waitForPendingUnloads(kwlEngine* engine, kwlWaveBank* waveBank)
+{
+    while (kwlEngine_isUnloadPending(engine, waveBank))
+    {
+        kwlEngine_sendPendingUnloadRequests(engine);
+        
+        kwlMutexLockAcquire(&engine->mixerEngineMutexLock);
+        kwlMessageQueue_flushTo(&engine->toMixerQueue, &engine->toMixerQueueShared);
+        kwlMessageQueue_flushTo(&engine->mixer->toEngineQueueShared, &engine->fromMixerQueue);
+        const int noMessages = engine->fromMixerQueue.numMessages == 0;
+        engine->mixer->isEngineWaitingForMessages = noMessages && engine->isOffline == 0;
+        kwlMutexLockRelease(&engine->mixerEngineMutexLock);
+        
+        if (noMessages && engine->isOffline != 0)
+        {
+            /*No audio thread runs the mixer of an offline engine, so let the mixer process
+              the messages and pass its replies back on this thread by rendering an empty buffer.*/
+            float emptyBuffer[2];
+            kwlMixer_render(engine->mixer, emptyBuffer, 0);
+        }
+        else if (noMessages)
+        {
+            /*Sleep until the mixer has passed new messages. These are picked up on the next iteration.*/
+            kwlSemaphoreWait(engine->mixerMessageSemaphore);
+        }
+        else
+        {
+            kwlEngine_processMixerMessages(engine);
+        }
+    }
+}
+
+kwlError kwlEngine_requestUnloadWaveBank(kwlEngine* engine, 
+                                         kwlWaveBankHandle handle, 
+                                         kwlUnloadCompletedCallback callback,
+                                         void* userData)
 {   
     if (engine->engineData.isLoaded == 0)
     {
@@ -321,33 +703,82 @@ kwlError kwlEngine_requestUnloadWaveBank(kwlEngine* engine, kwlWaveBankHandle ha
         return KWL_INVALID_WAVE_BANK_HANDLE;
     }
     
-    /*Send a message to the mixer to stop all playing events referencing audio data from the wave bank.
-      Once the events are stopped, the mixer sends a message back to the engine indicating that it
-      is safe to unload the wavebank.*/
     kwlWaveBank* waveBankToUnload = &engine->engineData.waveBanks[handle];
     
-    if (waveBankToUnload->isLoaded == 0)
+    if (kwlEngine_isUnloadPending(engine, waveBankToUnload))
     {
+        /*Complete along with the unload that is already waiting for the mixer.*/
+        kwlPendingUnload* unload = kwlEngine_addPendingUnload(engine, 
+                                                              waveBankToUnload, 
+                                                              KWL_UNLOAD_SENDING_REQUEST, 
+                                                              callback, 
+                                                              userData);
+        kwlEngine_sendUnloadRequest(engine, unload);
         return KWL_NO_ERROR;
     }
     
-    int result = kwlMessageQueue_addMessage(&engine->toMixerQueue, KWL_STOP_ALL_EVENTS_REFERENCING_WAVE_BANK, waveBankToUnload);
-    if (result == 0)
+    if (waveBankToUnload->isLoaded == 0)
     {
-        return KWL_MESSAGE_QUEUE_FULL;
+        if (callback != NULL)
+        {
+            kwlEngine_addPendingUnload(engine, NULL, KWL_UNLOAD_COMPLETED, callback, userData);
+        }
+        return KWL_NO_ERROR;
     }
     
-    if (blockUntilUnloaded != 0)
+    kwlEngine_stopVirtualEventsReferencingWaveBank(engine, waveBankToUnload);
+    
+    if (kwlEngine_isWaveBankUsedByPlayingEvent(engine, waveBankToUnload) == 0)
     {
-        //TODO: do this in a better way. this will cause a freeze if the audio thread is not running
-        /*If a blocking unload was requested, wait for the wavebank to get unloaded before
-         returning.*/
-        while (waveBankToUnload->isLoaded != 0)
+        /*No event is playing audio data from the wave bank, so it can be unloaded right away.*/
+        kwlResidency_releaseWaveBank(&engine->residency, &engine->streamingIO, waveBankToUnload);
+        kwlWaveBank_unload(waveBankToUnload);
+        if (callback != NULL)
         {
-            kwlUpdate(0);
+            kwlEngine_addPendingUnload(engine, NULL, KWL_UNLOAD_COMPLETED, callback, userData);
         }
+        return KWL_NO_ERROR;
+    }
+    
+    /*The mixer reads the audio data entries of the wave bank directly, so the wave bank is unloaded
+      by kwlEngine_update once the mixer has stopped the events using it.*/
+    kwlPendingUnload* unload = kwlEngine_addPendingUnload(engine, 
+                                                          waveBankToUnload, 
+                                                          KWL_UNLOAD_SENDING_REQUEST, 
+                                                          callback, 
+                                                          userData);
+    kwlEngine_sendUnloadRequest(engine, unload);
+    
+    return KWL_NO_ERROR;
+}
+
+kwlError kwlEngine_unloadWaveBankBlocking(kwlEngine* engine, kwlWaveBankHandle handle)
+{
+    kwlError result = kwlEngine_requestUnloadWaveBank(engine, handle, NULL, NULL);
+    if (result != KWL_NO_ERROR)
+    {
+        return result;
+    }
+    
+    kwlEngine_waitForPendingUnloads(engine, &engine->engineData.waveBanks[handle]);
+    return KWL_NO_ERROR;
+}
+
+kwlError kwlEngine_waveBankIsUnloadPending(kwlEngine* engine, kwlWaveBankHandle handle, int* isPending)
+{
+    *isPending = 0;
+    
+    if (engine->engineData.isLoaded == 0)
+    {
+        return KWL_ENGINE_DATA_NOT_LOADED;
+    }
+    
+    if (handle < 0 || handle >= engine->engineData.numWaveBanks || handle == KWL_INVALID_HANDLE)
+    {
+        return KWL_INVALID_WAVE_BANK_HANDLE;
     }
     
+    *isPending = kwlEngine_isUnloadPending(engine, &engine->engineData.waveBanks[handle]);
     return KWL_NO_ERROR;
 }
 
@@ -376,7 +807,13 @@ kwlError kwlEngine_eventGetHandle(kwlEngine* engine, const char* const eventID,
                 kwlEventInstance* const eventj = &engine->engineData.events[i][j];
                 if (eventj->isAssociatedWithHandle == 0)
                 {
-                    *handle = computeEventHandle(i, j, 0);
+                    const int slotIdx = kwlEngine_allocateEventHandleSlot(engine, eventj, 0);
+                    if (slotIdx < 0)
+                    {
+                        return KWL_NO_FREE_EVENT_INSTANCES;
+                    }
+                    *handle = computeEventHandle(slotIdx, engine->eventHandleSlots[slotIdx].generation, 0);
+                    eventj->handleSlotIndex = slotIdx;
                     eventj->isAssociatedWithHandle = 1;
                     return KWL_NO_ERROR;
                 }
@@ -413,37 +850,147 @@ kwlError kwlEngine_eventDefinitionGetHandle(kwlEngine* engine,
     return KWL_UNKNOWN_EVENT_DEFINITION_ID;
 }
 
-void kwlEngine_addFreeformEvent(kwlEngine* engine, kwlEventInstance* event, kwlEventHandle* handle)
+/** 
+ * Grows the array of event handle slots by a number of slots and appends the new slots
+ * to the free slot queue. Returns zero if the arrays could not be reallocated.
+ */
+static int kwlEngine_growEventHandleSlotArray(kwlEngine* engine, int numSlots)
 {
-    /*find a free slot in the freeform event array. reallocate the array if needed */
-    int slotIdx = -1;
+    /*the slot index has to fit in a handle.*/
+    const int maxNumSlots = KWL_EVENT_HANDLE_NUM_INDICES;
+    const int newSize = engine->eventHandleSlotArraySize + numSlots > maxNumSlots ? 
+                        maxNumSlots : engine->eventHandleSlotArraySize + numSlots;
+    if (newSize <= engine->eventHandleSlotArraySize)
+    {
+        return 0;
+    }
+    
+    kwlEventHandleSlot* eventHandleSlots = 
+        (kwlEventHandleSlot*)KWL_REALLOC(engine->eventHandleSlots,
+                                         newSize * sizeof(kwlEventHandleSlot),
+                                         KWL_MEMORY_CATEGORY_EVENT, "event handle slots");
+    if (eventHandleSlots == NULL)
+    {
+        return 0;
+    }
+    engine->eventHandleSlots = eventHandleSlots;
+    
+    int* freeSlots = (int*)KWL_MALLOC(newSize * sizeof(int), KWL_MEMORY_CATEGORY_EVENT, "free event handle slots");
+    if (freeSlots == NULL)
+    {
+        return 0;
+    }
+    
+    /*unwrap the queued free slots, then append the new slots lowest index first*/
     int i;
-    for (i = 0; i < engine->freeformEventArraySize; i++)
+    for (i = 0; i < engine->numFreeEventHandleSlots; i++)
+    {
+        const int queueIdx = (engine->firstFreeEventHandleSlot + i) % engine->eventHandleSlotArraySize;
+        freeSlots[i] = engine->freeEventHandleSlots[queueIdx];
+    }
+    for (i = engine->eventHandleSlotArraySize; i < newSize; i++)
+    {
+        engine->eventHandleSlots[i].event = NULL;
+        engine->eventHandleSlots[i].generation = 0;
+        engine->eventHandleSlots[i].isFreeform = 0;
+        freeSlots[engine->numFreeEventHandleSlots] = i;
+        engine->numFreeEventHandleSlots++;
+    }
+    KWL_FREE(engine->freeEventHandleSlots);
+    engine->freeEventHandleSlots = freeSlots;
+    engine->firstFreeEventHandleSlot = 0;
+    engine->eventHandleSlotArraySize = newSize;
+    
+    return 1;
+}
+
+/** 
+ * Takes the least recently freed event handle slot, growing the array of slots if needed, and puts 
+ * a given event in it. Returns the index of the slot or -1 if the array could not be grown.
+ */
+static int kwlEngine_allocateEventHandleSlot(kwlEngine* engine, kwlEventInstance* event, int isFreeform)
+{
+    if (engine->numFreeEventHandleSlots == 0)
     {
-        if (engine->freeformEvents[i] == NULL)
+        const int numSlots = engine->eventHandleSlotArraySize > 0 ? 
+                             engine->eventHandleSlotArraySize : engine->config.freeformEventPoolChunkSize;
+        if (kwlEngine_growEventHandleSlotArray(engine, numSlots) == 0)
         {
-            slotIdx = i;
-            break;
+            return -1;
         }
     }
     
+    const int slotIdx = engine->freeEventHandleSlots[engine->firstFreeEventHandleSlot];
+    engine->firstFreeEventHandleSlot = (engine->firstFreeEventHandleSlot + 1) % engine->eventHandleSlotArraySize;
+    engine->numFreeEventHandleSlots--;
+    KWL_ASSERT(engine->eventHandleSlots[slotIdx].event == NULL);
+    engine->eventHandleSlots[slotIdx].event = event;
+    engine->eventHandleSlots[slotIdx].isFreeform = isFreeform;
+    
+    return slotIdx;
+}
+
+/** 
+ * Clears a given event handle slot and appends it to the free slot queue so it can be reused,
+ * unless its generation has wrapped around. Handles to the slot must have been invalidated.
+ */
+static void kwlEngine_freeEventHandleSlot(kwlEngine* engine, int slotIndex)
+{
+    KWL_ASSERT(slotIndex >= 0 && slotIndex < engine->eventHandleSlotArraySize);
+    KWL_ASSERT(engine->eventHandleSlots[slotIndex].event != NULL);
+    engine->eventHandleSlots[slotIndex].event = NULL;
+    
+    /*every generation of this slot has been handed out, so reusing it would revive stale handles.*/
+    if (engine->eventHandleSlots[slotIndex].generation == 0)
+    {
+        return;
+    }
+    
+    const int queueIdx = (engine->firstFreeEventHandleSlot + engine->numFreeEventHandleSlots) % engine->eventHandleSlotArraySize;
+    engine->freeEventHandleSlots[queueIdx] = slotIndex;
+    engine->numFreeEventHandleSlots++;
+}
+
+/** 
+ * Releases the handle of a data driven event instance, invalidating any copies of it.
+ * The instance can then be associated with a new handle.
+ */
+static void kwlEngine_releaseDataEventHandle(kwlEngine* engine, kwlEventInstance* event)
+{
+    KWL_ASSERT(event->isAssociatedWithHandle != 0);
+    kwlEventHandleSlot* slot = &engine->eventHandleSlots[event->handleSlotIndex];
+    KWL_ASSERT(slot->event == event);
+    slot->generation = (slot->generation + 1) & KWL_EVENT_HANDLE_GENERATION_MASK;
+    kwlEngine_freeEventHandleSlot(engine, event->handleSlotIndex);
+    event->isAssociatedWithHandle = 0;
+    event->handleSlotIndex = -1;
+}
+
+/** Releases the handles of all event instances of the loaded engine data, before it is unloaded.*/
+static void kwlEngine_releaseDataEventHandles(kwlEngine* engine)
+{
+    int i;
+    for (i = 0; i < engine->engineData.numEventInstances; i++)
+    {
+        if (engine->engineData.eventInstances[i].isAssociatedWithHandle != 0)
+        {
+            kwlEngine_releaseDataEventHandle(engine, &engine->engineData.eventInstances[i]);
+        }
+    }
+}
+
+static kwlError kwlEngine_addFreeformEvent(kwlEngine* engine, kwlEventInstance* event, kwlEventHandle* handle)
+{
+    const int slotIdx = kwlEngine_allocateEventHandleSlot(engine, event, 1);
     if (slotIdx < 0)
     {
-        /*no free slots, reallocate the array 
-         and pick the newly allocated slot*/
-        engine->freeformEventArraySize++;
-        engine->freeformEvents = (kwlEventInstance**)KWL_REALLOC(engine->freeformEvents,
-                                                                 engine->freeformEventArraySize * sizeof(kwlEventInstance*),
-                                                                 "freeform event array");
-        engine->freeformEvents[engine->freeformEventArraySize - 1] = NULL;
-        
-        slotIdx = engine->freeformEventArraySize - 1;
+        return KWL_NO_FREE_EVENT_INSTANCES;
     }
     
-    *handle = computeEventHandle(slotIdx, 0, 1);
-    //printf("slot idx %d, handle %d, event %d\n", slotIdx, *handle, createdEvent);
+    *handle = computeEventHandle(slotIdx, engine->eventHandleSlots[slotIdx].generation, 1);
+    ((kwlFreeformEvent*)event)->slotIndex = slotIdx;
     
-    engine->freeformEvents[slotIdx] = event;
+    return KWL_NO_ERROR;
 }
 
 kwlError kwlEngine_eventCreateWithBuffer(kwlEngine* engine, kwlPCMBuffer* buffer, 
@@ -451,12 +998,16 @@ kwlError kwlEngine_eventCreateWithBuffer(kwlEngine* engine, kwlPCMBuffer* buffer
 {
     *handle = KWL_INVALID_HANDLE;
     kwlEventInstance* createdEvent = NULL;
-    kwlError result = kwlEventInstance_createFreeformEventFromBuffer(&createdEvent, buffer, type);
+    kwlError result = kwlEventInstance_createFreeformEventFromBuffer(&engine->freeformEventPool, &createdEvent, buffer, type);
     
     if (result == KWL_NO_ERROR)
     {
         KWL_ASSERT(createdEvent != NULL);
-        kwlEngine_addFreeformEvent(engine, createdEvent, handle);
+        result = kwlEngine_addFreeformEvent(engine, createdEvent, handle);
+        if (result != KWL_NO_ERROR)
+        {
+            kwlEventInstance_releaseFreeformEvent(&engine->freeformEventPool, createdEvent);
+        }
     }
     
     return result;
@@ -465,13 +1016,18 @@ kwlError kwlEngine_eventCreateWithBuffer(kwlEngine* engine, kwlPCMBuffer* buffer
 kwlError kwlEngine_eventCreateWithFile(kwlEngine* engine, const char* const audioFilePath, 
                                             kwlEventHandle* handle, kwlEventType type, int streamFromDisk)
 {
+    *handle = KWL_INVALID_HANDLE;
     kwlEventInstance* createdEvent = NULL;
-    kwlError result = kwlEventInstance_createFreeformEventFromFile(&createdEvent, audioFilePath, type, streamFromDisk);
+    kwlError result = kwlEventInstance_createFreeformEventFromFile(&engine->freeformEventPool, &createdEvent, audioFilePath, &engine->fileSystem, type, streamFromDisk);
     
     if (result == KWL_NO_ERROR)
     {
         KWL_ASSERT(createdEvent != NULL);
-        kwlEngine_addFreeformEvent(engine, createdEvent, handle);
+        result = kwlEngine_addFreeformEvent(engine, createdEvent, handle);
+        if (result != KWL_NO_ERROR)
+        {
+            kwlEventInstance_releaseFreeformEvent(&engine->freeformEventPool, createdEvent);
+        }
     }
     
     return result;
@@ -483,23 +1039,16 @@ kwlError kwlEngine_unloadFreeformEvent(kwlEngine* engine, kwlEventInstance* even
     KWL_ASSERT(event != NULL);
     KWL_ASSERT(event->isPlaying == 0);
     
-    int matchFound = 0;
-    int eventIndex;
-    for (eventIndex = 0; eventIndex < engine->freeformEventArraySize; eventIndex++)
-    {
-        if (engine->freeformEvents[eventIndex] == event)
-        {
-            matchFound = 1;
-            break;
-        }
-    }
+    const int eventIndex = ((kwlFreeformEvent*)event)->slotIndex;
+    KWL_ASSERT(eventIndex >= 0 && eventIndex < engine->eventHandleSlotArraySize &&
+               engine->eventHandleSlots[eventIndex].event == event && 
+               "trying to free a freeform event that is not in the engine's list");
     
-    KWL_ASSERT(matchFound != 0 && "trying to free a freeform event that is not in the engine's list");
-    /*Clear the event slot so it can be reused. */
-    engine->freeformEvents[eventIndex] = NULL;
+    /*Clear the event slot and queue it so it can be reused. */
+    kwlEngine_freeEventHandleSlot(engine, eventIndex);
     
     /*Release event data.*/
-    kwlEventInstance_releaseFreeformEvent(event);
+    kwlEventInstance_releaseFreeformEvent(&engine->freeformEventPool, event);
     
     return KWL_NO_ERROR;
 }
@@ -513,9 +1062,18 @@ kwlError kwlEngine_eventRelease(kwlEngine* engine, kwlEventHandle handle)
         return KWL_INVALID_EVENT_INSTANCE_HANDLE;
     }
     
+    /*Clear callbacks. This is done first since a freeform event that is not 
+      playing is freed below.*/
+    eventToRelease->stoppedCallback = NULL;
+    eventToRelease->stoppedCallbackUserData = NULL;
+    
     /*If this is a freeform event, dispose of any data allocated for it.*/
     if (kwlEngine_isFreeformEventHandle(engine, handle))
     {   
+        /*Invalidate handles to the slot, even if the event is unloaded later.*/
+        kwlEventHandleSlot* slot = &engine->eventHandleSlots[kwlEngine_getSlotIndexFromHandle(engine, handle)];
+        slot->generation = (slot->generation + 1) & KWL_EVENT_HANDLE_GENERATION_MASK;
+        
         if (eventToRelease->isPlaying == 0)
         {
             kwlEngine_unloadFreeformEvent(engine, eventToRelease);
@@ -531,6 +1089,8 @@ kwlError kwlEngine_eventRelease(kwlEngine* engine, kwlEventHandle handle)
             if (result == 0)
             {
                 KWL_ASSERT(0);
+                /*the event is not released, so the handle stays valid.*/
+                slot->generation = (slot->generation - 1) & KWL_EVENT_HANDLE_GENERATION_MASK;
                 return KWL_MESSAGE_QUEUE_FULL;
             }
         }
@@ -542,13 +1102,9 @@ kwlError kwlEngine_eventRelease(kwlEngine* engine, kwlEventHandle handle)
         eventToRelease->userGain = 1.0f;
         eventToRelease->userPitch = 1.0f;
         eventToRelease->dspUnit.valueEngine = NULL;
-        eventToRelease->isAssociatedWithHandle = 0;
+        kwlEngine_releaseDataEventHandle(engine, eventToRelease);
     }
     
-    /*Clear callbacks*/
-    eventToRelease->stoppedCallback = NULL;
-    eventToRelease->stoppedCallbackUserData = NULL;
-    
     return KWL_NO_ERROR;
 }
 
@@ -1104,9 +1660,548 @@ void kwlEngine_updateEvents(kwlEngine* engine)
 }
 
 
+/** Stops an event that was started virtually and has not been sent to the mixer.*/
+static void kwlEngine_stopVirtualEvent(kwlEngine* engine, kwlEventInstance* event)
+{
+    KWL_ASSERT(event->isVirtual != 0);
+    event->isVirtual = 0;
+    event->isPlaying = 0;
+    kwlEngine_removeEventFromPlayingList(engine, event);
+    
+    if (event->stoppedCallback != NULL)
+    {
+        event->stoppedCallback(event->stoppedCallbackUserData);
+    }
+}
+
+/** 
+ * Stops all virtual events referencing a given wave bank. 
+ * @param waveBank The wave bank or NULL to stop all virtual events.
+ */
+static void kwlEngine_stopVirtualEventsReferencingWaveBank(kwlEngine* engine, kwlWaveBank* waveBank)
+{
+    kwlEventInstance* event = engine->playingEventList;
+    while (event != NULL)
+    {
+        kwlEventInstance* nextEvent = event->nextEvent_engine;
+        if (event->isVirtual != 0)
+        {
+            int isReferenced = waveBank == NULL;
+            for (int i = 0; i < event->definition_engine->numReferencedWaveBanks; i++)
+            {
+                if (event->definition_engine->referencedWaveBanks[i] == waveBank)
+                {
+                    isReferenced = 1;
+                }
+            }
+            
+            if (isReferenced != 0)
+            {
+                kwlEngine_stopVirtualEvent(engine, event);
+            }
+        }
+        event = nextEvent;
+    }
+}
+
+/** 
+ * Sends virtual events whose audio data has been loaded to the mixer and stops 
+ * virtual events whose audio data could not be loaded.
+ */
+static void kwlEngine_updateVirtualEvents(kwlEngine* engine)
+{
+    kwlEventInstance* event = engine->playingEventList;
+    while (event != NULL)
+    {
+        kwlEventInstance* nextEvent = event->nextEvent_engine;
+        if (event->isVirtual != 0)
+        {
+            if (kwlResidency_isEventResident(event->definition_engine) != 0)
+            {
+                kwlError result = kwlEngine_sendEventStart(engine, 
+                                                           event, 
+                                                           event->virtualFadeInTimeSec, 
+                                                           event->virtualStartFrame);
+                if (result == KWL_MESSAGE_QUEUE_FULL)
+                {
+                    /*The event was not sent. Release its decoder and try again next update.*/
+                    if (event->decoder != NULL)
+                    {
+                        kwlDecoder_deinit(event->decoder);
+                        event->decoder = NULL;
+                    }
+                    event->isVirtual = 1;
+                }
+                else if (result != KWL_NO_ERROR)
+                {
+                    kwlEngine_stopVirtualEvent(engine, event);
+                }
+            }
+            else if (kwlResidency_isEventLoading(event->definition_engine) == 0)
+            {
+                kwlEngine_stopVirtualEvent(engine, event);
+            }
+        }
+        event = nextEvent;
+    }
+}
+
+/** Parses the engine data of a requested reload. The entry point of the reload thread.*/
+static void* kwlEngine_engineDataReloadThreadEntryPoint(void* data)
+{
+    kwlPendingReload* reload = (kwlPendingReload*)data;
+    kwlError result = kwlEngineData_load(&reload->data, &reload->stream);
+    kwlInputStream_close(&reload->stream);
+    
+    kwlMutexLockAcquire(&reload->lock);
+    reload->result = result;
+    reload->isParsed = 1;
+    kwlMutexLockRelease(&reload->lock);
+    
+    return NULL;
+}
+
+/** Ends the engine data reload in progress and invokes its callback with a given result.*/
+static void kwlEngine_completeEngineDataReload(kwlEngine* engine, kwlError result)
+{
+    kwlPendingReload* reload = &engine->pendingReload;
+    
+    /*the data is either the parsed data that was not swapped in or the data it replaced.*/
+    kwlEngineData_unload(&reload->data);
+    if (reload->swap.eventInstanceMap != NULL)
+    {
+        KWL_FREE(reload->swap.eventInstanceMap);
+        reload->swap.eventInstanceMap = NULL;
+    }
+    reload->state = KWL_RELOAD_IDLE;
+    
+    if (reload->callback != NULL)
+    {
+        reload->callback(result, reload->callbackUserData);
+    }
+}
+
+/** 
+ * Returns the event instance of reloaded engine data that has taken over from a given 
+ * instance of the engine data it replaced, or the given instance if there is none.
+ */
+static kwlEventInstance* kwlEngine_getReloadedEventInstance(kwlEngine* engine, kwlEventInstance* event)
+{
+    kwlPendingReload* reload = &engine->pendingReload;
+    if (reload->state != KWL_RELOAD_WAITING_FOR_MIXER ||
+        event < reload->swap.previousEventInstances ||
+        event >= reload->swap.previousEventInstances + reload->swap.numPreviousEventInstances)
+    {
+        return event;
+    }
+    
+    kwlEventInstance* newEvent = reload->swap.eventInstanceMap[event - reload->swap.previousEventInstances];
+    return newEvent != NULL ? newEvent : event;
+}
+
+/** 
+ * Returns the index of the event definition of the loaded engine data with the same id as a given
+ * definition, or -1 if there is none. The definition at \c expectedIndex is checked first, since 
+ * reloaded engine data usually lists the definitions in the same order.
+ */
+static int kwlEngine_findEventDefinition(kwlEngine* engine, kwlEventDefinition* definition, int expectedIndex)
+{
+    const int numEventDefinitions = engine->engineData.numEventDefinitions;
+    if (expectedIndex < numEventDefinitions &&
+        strcmp(engine->engineData.eventDefinitions[expectedIndex].id, definition->id) == 0)
+    {
+        return expectedIndex;
+    }
+    
+    int i;
+    for (i = 0; i < numEventDefinitions; i++)
+    {
+        if (strcmp(engine->engineData.eventDefinitions[i].id, definition->id) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Swaps in the engine data of a reload, which has taken over the wave banks of the loaded data.
+ * Each instance of an event definition present in both data sets is taken over by the instance
+ * with the same index in the new data, which gets the state of the old instance and its place in 
+ * the list of playing events. The handles of instances without a match are released and virtual 
+ * ones are stopped. The mixer stops the other ones when it switches over to the new data.
+ */
+static void kwlEngine_swapEngineData(kwlEngine* engine)
+{
+    kwlPendingReload* reload = &engine->pendingReload;
+    
+    kwlEngineData_copyMixSettings(&reload->data, &engine->engineData);
+    
+    /*swap the data sets. reload->data holds the previous data from here on.*/
+    const kwlEngineData previousData = engine->engineData;
+    engine->engineData = reload->data;
+    reload->data = previousData;
+    
+    kwlEngineDataSwap* swap = &reload->swap;
+    swap->mixBuses = engine->engineData.mixBuses;
+    swap->numMixBuses = engine->engineData.numMixBuses;
+    swap->previousEventInstances = previousData.eventInstances;
+    swap->numPreviousEventInstances = previousData.numEventInstances;
+    swap->eventInstanceMap = 
+        (kwlEventInstance**)KWL_MALLOC(sizeof(kwlEventInstance*) * (previousData.numEventInstances + 1), 
+                                       KWL_MEMORY_CATEGORY_ENGINE_DATA, 
+                                       "event instance map");
+    kwlMemset(swap->eventInstanceMap, 0, sizeof(kwlEventInstance*) * (previousData.numEventInstances + 1));
+    
+    /*match the instances of the event definitions present in both data sets. streaming events 
+      keep playing only if they stream the same audio data, which their decoders are reading.*/
+    int i;
+    for (i = 0; i < previousData.numEventDefinitions; i++)
+    {
+        kwlEventDefinition* previousDefinition = &previousData.eventDefinitions[i];
+        const int definitionIndex = kwlEngine_findEventDefinition(engine, previousDefinition, i);
+        if (definitionIndex < 0)
+        {
+            continue;
+        }
+        
+        kwlEventDefinition* definition = &engine->engineData.eventDefinitions[definitionIndex];
+        if (definition->streamAudioData != previousDefinition->streamAudioData ||
+            (definition->sound == NULL) != (previousDefinition->sound == NULL))
+        {
+            continue;
+        }
+        
+        const int numPreviousInstances = previousDefinition->instanceCount < 1 ? 1 : previousDefinition->instanceCount;
+        const int numInstances = definition->instanceCount < 1 ? 1 : definition->instanceCount;
+        int j;
+        for (j = 0; j < numPreviousInstances && j < numInstances; j++)
+        {
+            kwlEventInstance* previousEvent = &previousData.events[i][j];
+            kwlEventInstance* event = &engine->engineData.events[definitionIndex][j];
+            kwlEventInstance_copyEngineState(event, previousEvent);
+            if (event->isAssociatedWithHandle != 0)
+            {
+                engine->eventHandleSlots[event->handleSlotIndex].event = event;
+            }
+            swap->eventInstanceMap[previousEvent - previousData.eventInstances] = event;
+        }
+    }
+    
+    reload->state = KWL_RELOAD_WAITING_FOR_MIXER;
+    
+    /*put the new instances in place of the old ones in the list of playing events*/
+    kwlEventInstance** link = &engine->playingEventList;
+    while (*link != NULL)
+    {
+        kwlEventInstance* event = kwlEngine_getReloadedEventInstance(engine, *link);
+        if (event != *link)
+        {
+            event->nextEvent_engine = (*link)->nextEvent_engine;
+            *link = event;
+            if (event->isVirtual == 0)
+            {
+                /*keep the audio data of the new event definition in memory while the event plays.*/
+                kwlEngine_retainAudioBuffers(engine, event);
+            }
+        }
+        link = &(*link)->nextEvent_engine;
+    }
+    
+    /*release the instances without a match. virtual events have not reached the mixer and are stopped 
+      here, the others stay in the list of playing events until the mixer reports them as stopped.*/
+    for (i = 0; i < previousData.numEventInstances; i++)
+    {
+        kwlEventInstance* previousEvent = &previousData.eventInstances[i];
+        if (swap->eventInstanceMap[i] != NULL)
+        {
+            continue;
+        }
+        
+        if (previousEvent->isAssociatedWithHandle != 0)
+        {
+            kwlEngine_releaseDataEventHandle(engine, previousEvent);
+        }
+        if (previousEvent->isVirtual != 0)
+        {
+            kwlEngine_stopVirtualEvent(engine, previousEvent);
+        }
+    }
+    
+    /*the mixer starts using the new mix buses right away, so compute their parameters now.*/
+    kwlEngine_updateMixPresets(engine, 0.0f);
+    for (i = 0; i < engine->engineData.numMixBuses; i++)
+    {
+        kwlMixBus* bus = &engine->engineData.mixBuses[i];
+        bus->totalGainLeft.valueShared = bus->mixPresetGainLeft * bus->userGainLeft;
+        bus->totalGainLeft.valueMixer = bus->totalGainLeft.valueShared;
+        bus->totalGainRight.valueShared = bus->mixPresetGainRight * bus->userGainRight;
+        bus->totalGainRight.valueMixer = bus->totalGainRight.valueShared;
+        bus->totalPitch.valueShared = bus->mixPresetPitch * bus->userPitch;
+        bus->totalPitch.valueMixer = bus->totalPitch.valueShared;
+        bus->dspUnit.valueShared = bus->dspUnit.valueEngine;
+        bus->dspUnit.valueMixer = bus->dspUnit.valueEngine;
+    }
+    
+    int success = kwlMessageQueue_addMessage(&engine->toMixerQueue, KWL_SWAP_ENGINE_DATA, swap);
+    KWL_ASSERT(success != 0);
+}
+
+/** 
+ * Swaps in the engine data of a reload once it has been parsed, or discards it if it can not 
+ * replace the loaded data. The swap is postponed while wave bank unloads are pending, since 
+ * they reference the wave banks the new data takes over, and while the message queue is full.
+ */
+static void kwlEngine_updateEngineDataReload(kwlEngine* engine)
+{
+    kwlPendingReload* reload = &engine->pendingReload;
+    if (reload->state == KWL_RELOAD_PARSING)
+    {
+        kwlMutexLockAcquire(&reload->lock);
+        const int isParsed = reload->isParsed;
+        kwlMutexLockRelease(&reload->lock);
+        if (isParsed == 0)
+        {
+            return;
+        }
+        
+        kwlThreadJoin(&reload->thread);
+        reload->state = KWL_RELOAD_PARSED;
+    }
+    
+    if (reload->state != KWL_RELOAD_PARSED)
+    {
+        return;
+    }
+    
+    kwlError result = reload->result;
+    if (result == KWL_NO_ERROR &&
+        (engine->engineData.isLoaded == 0 || kwlEngine_isUnloadPending(engine, NULL) != 0))
+    {
+        result = KWL_ENGINE_DATA_NOT_LOADED;
+    }
+    
+    if (result == KWL_NO_ERROR)
+    {
+        int i;
+        for (i = 0; i < engine->numPendingUnloads; i++)
+        {
+            if (engine->pendingUnloads[i].state != KWL_UNLOAD_COMPLETED)
+            {
+                return;
+            }
+        }
+        if (engine->toMixerQueue.numMessages >= engine->toMixerQueue.maxQueueSize)
+        {
+            return;
+        }
+        
+        result = kwlEngineData_adoptWaveBanks(&reload->data, &engine->engineData);
+    }
+    
+    if (result != KWL_NO_ERROR)
+    {
+        kwlEngine_completeEngineDataReload(engine, result);
+        return;
+    }
+    
+    kwlEngine_swapEngineData(engine);
+}
+
+/** Waits for the reload thread, if any, and discards engine data that has not been swapped in.*/
+static void kwlEngine_cancelEngineDataReload(kwlEngine* engine)
+{
+    kwlPendingReload* reload = &engine->pendingReload;
+    if (reload->state == KWL_RELOAD_PARSING)
+    {
+        kwlThreadJoin(&reload->thread);
+        reload->state = KWL_RELOAD_PARSED;
+    }
+    
+    if (reload->state == KWL_RELOAD_PARSED)
+    {
+        kwlEngine_completeEngineDataReload(engine, KWL_ENGINE_DATA_NOT_LOADED);
+    }
+}
+
+/** 
+ * Processes the messages from the mixer that have been copied to \c fromMixerQueue and
+ * completes any unloads the mixer has acknowledged.
+ */
+static void kwlEngine_processMixerMessages(kwlEngine* engine)
+{
+    int numMessages = engine->fromMixerQueue.numMessages;
+    
+    int unloadEngineDataRequested = 0;
+    int i;
+    for (i = 0; i < numMessages; i++)
+    {
+        kwlMessage* message = &engine->fromMixerQueue.messages[i];
+        kwlMessageType type = message->type;
+        void* messageData = message->data;
+        /*printf("engine: processing incoming message %d/%d of type %d\n", i + 1, numMessages, type);*/
+        
+        if (type == KWL_EVENT_STOPPED ||
+            type == KWL_UNLOAD_FREEFORM_EVENT)
+        {
+            /*an event may have stopped in the mixer before it switched over to reloaded engine data.*/
+            kwlEventInstance* event = kwlEngine_getReloadedEventInstance(engine, (kwlEventInstance*)messageData);
+            event->isPlaying = 0;
+            if (event->decoder != NULL)
+            {
+                kwlDecoder_deinit(event->decoder);
+                event->decoder = NULL;
+            }
+            kwlEngine_releaseAudioBuffers(engine, event);
+            printf("    %s: %s\n", type == KWL_EVENT_STOPPED ? "event stopped" : "unload freeform event", 
+                   event->definition_engine->id);
+            kwlEngine_removeEventFromPlayingList(engine, event);
+            
+            if (type == KWL_UNLOAD_FREEFORM_EVENT)
+            {
+                kwlEngine_unloadFreeformEvent(engine, event);
+            }
+            
+            if (event->stoppedCallback != NULL)
+            {
+                event->stoppedCallback(event->stoppedCallbackUserData);
+            }
+        }
+        else if (type == KWL_UNLOAD_WAVEBANK)
+        {
+            kwlWaveBank* waveBank = (kwlWaveBank*)messageData;
+            printf("    unload wave bank: %s\n", waveBank->id);
+            kwlResidency_releaseWaveBank(&engine->residency, &engine->streamingIO, waveBank);
+            kwlWaveBank_unload(waveBank);
+            kwlEngine_completePendingUnloads(engine, waveBank);
+        }
+        else if (type == KWL_ENGINE_DATA_SWAPPED)
+        {
+            /*the mixer no longer references the engine data replaced by a reload.*/
+            kwlEngine_completeEngineDataReload(engine, KWL_NO_ERROR);
+        }
+        else if (type == KWL_UNLOAD_ENGINE_DATA)
+        {
+            /*Unload engine data after all messages have been processed.*/
+            KWL_ASSERT(unloadEngineDataRequested == 0);
+            printf("received KWL_UNLOAD_ENGINE_DATA\n");
+            unloadEngineDataRequested = 1;
+        }
+    }
+    
+    if (unloadEngineDataRequested != 0)
+    {
+        for (i = 0; i < engine->engineData.numWaveBanks; i++)
+        {
+            kwlResidency_releaseWaveBank(&engine->residency, &engine->streamingIO, &engine->engineData.waveBanks[i]);
+        }
+        kwlEngine_releaseDataEventHandles(engine);
+        kwlEngineData_unload(&engine->engineData);
+        kwlEngine_completePendingUnloads(engine, NULL);
+    }
+    
+    engine->fromMixerQueue.numMessages = 0;
+    
+    kwlEngine_invokeUnloadCallbacks(engine);
+}
+
+/** Executes a command recorded into a command buffer by calling the corresponding engine function.*/
+static kwlError kwlEngine_executeCommand(kwlEngine* engine, const kwlCommand* command)
+{
+    const kwlEventHandle handle = command->handle;
+    const float* params = command->params;
+    switch (command->type)
+    {
+        case KWL_COMMAND_EVENT_START:
+            return kwlEngine_eventStart(engine, handle, params[0], 0);
+        case KWL_COMMAND_EVENT_STOP:
+            return kwlEngine_eventStop(engine, handle, params[0], 0);
+        case KWL_COMMAND_EVENT_PAUSE:
+            return kwlEngine_eventPause(engine, handle);
+        case KWL_COMMAND_EVENT_RESUME:
+            return kwlEngine_eventResume(engine, handle);
+        case KWL_COMMAND_EVENT_RELEASE:
+            return kwlEngine_eventRelease(engine, handle);
+        case KWL_COMMAND_EVENT_START_ONE_SHOT:
+            return kwlEngine_eventStartOneShot(engine, (kwlEventDefinitionHandle)handle, 0.0f, 0.0f, 0.0f, 0, NULL, NULL);
+        case KWL_COMMAND_EVENT_START_ONE_SHOT_AT:
+            return kwlEngine_eventStartOneShot(engine, (kwlEventDefinitionHandle)handle, params[0], params[1], params[2], 1, NULL, NULL);
+        case KWL_COMMAND_EVENT_SET_GAIN:
+            return kwlEngine_eventSetGain(engine, handle, params[0], 0);
+        case KWL_COMMAND_EVENT_SET_LINEAR_GAIN:
+            return kwlEngine_eventSetGain(engine, handle, params[0], 1);
+        case KWL_COMMAND_EVENT_SET_PITCH:
+            return kwlEngine_eventSetPitch(engine, handle, params[0]);
+        case KWL_COMMAND_EVENT_SET_BALANCE:
+            return kwlEngine_eventSetBalance(engine, handle, params[0]);
+        case KWL_COMMAND_EVENT_SET_POSITION:
+            return kwlEngine_eventSetPosition(engine, handle, params[0], params[1], params[2]);
+        case KWL_COMMAND_EVENT_SET_VELOCITY:
+            return kwlEngine_eventSetVelocity(engine, handle, params[0], params[1], params[2]);
+        case KWL_COMMAND_EVENT_SET_ORIENTATION:
+            return kwlEngine_eventSetOrientation(engine, handle, params[0], params[1], params[2]);
+        case KWL_COMMAND_LISTENER_SET_POSITION:
+            return kwlEngine_setListenerPosition(engine, params[0], params[1], params[2]);
+        case KWL_COMMAND_LISTENER_SET_VELOCITY:
+            return kwlEngine_setListenerVelocity(engine, params[0], params[1], params[2]);
+        case KWL_COMMAND_LISTENER_SET_ORIENTATION:
+            return kwlEngine_setListenerOrientation(engine, params[0], params[1], params[2], params[3], params[4], params[5]);
+        case KWL_COMMAND_MIX_BUS_SET_GAIN:
+            return kwlEngine_mixBusSetGain(engine, (kwlMixBusHandle)handle, params[0], 0);
+        case KWL_COMMAND_MIX_BUS_SET_LINEAR_GAIN:
+            return kwlEngine_mixBusSetGain(engine, (kwlMixBusHandle)handle, params[0], 1);
+        case KWL_COMMAND_MIX_BUS_SET_PITCH:
+            return kwlEngine_mixBusSetPitch(engine, (kwlMixBusHandle)handle, params[0]);
+        case KWL_COMMAND_MIX_PRESET_SET:
+            return kwlEngine_mixPresetSetActive(engine, (kwlMixPresetHandle)handle, 0);
+        case KWL_COMMAND_MIX_PRESET_FADE_TO:
+            return kwlEngine_mixPresetSetActive(engine, (kwlMixPresetHandle)handle, 1);
+    }
+    
+    KWL_ASSERT(0 && "unknown command type");
+    return KWL_INVALID_PARAMETER_VALUE;
+}
+
+/** 
+ * Executes the submitted commands of a given command buffer in the order they were recorded,
+ * passing any errors back to the buffer.
+ */
+static void kwlEngine_executeCommandBuffer(kwlEngine* engine, kwlCommandBuffer* buffer)
+{
+    int commandIndex = 0;
+    int endIndex = 0;
+    kwlCommandBuffer_getPendingCommands(buffer, &commandIndex, &endIndex);
+    if (commandIndex == endIndex)
+    {
+        /*nothing was submitted since the last update*/
+        return;
+    }
+    
+    while (commandIndex != endIndex)
+    {
+        kwlCommandBuffer_setExecuteError(buffer, kwlEngine_executeCommand(engine, &buffer->commands[commandIndex]));
+        commandIndex = commandIndex + 1 == buffer->numSlots ? 0 : commandIndex + 1;
+    }
+    kwlCommandBuffer_setExecuted(buffer, endIndex);
+}
+
 kwlError kwlEngine_update(kwlEngine* engine, float timeStepSec)
 {
+    /*swap in reloaded engine data first, so that the parameters of the new data are shared below.*/
+    kwlEngine_updateEngineDataReload(engine);
+    
+    /*execute commands recorded on other threads, one buffer at a time in creation order.*/
+    kwlCommandBuffer* commandBuffer = engine->commandBuffers;
+    while (commandBuffer != NULL)
+    {
+        kwlEngine_executeCommandBuffer(engine, commandBuffer);
+        commandBuffer = commandBuffer->next;
+    }
+    
     kwlEngine_updateEvents(engine);        
+    
+    kwlResidency_update(&engine->residency, &engine->streamingIO, engine->playingEventList);
+    kwlEngine_updateVirtualEvents(engine);
     kwlEngine_updateMixPresets(engine, timeStepSec);
         
     kwlDSPUnit* inputDspUnit = (kwlDSPUnit*)engine->mixer->inputDSPUnit.valueEngine;
@@ -1121,6 +2216,9 @@ kwlError kwlEngine_update(kwlEngine* engine, float timeStepSec)
         outputDspUnit->updateDSPEngineCallback(outputDspUnit->data);
     }
     
+    /*resend any unload requests that did not fit in the message queue*/
+    kwlEngine_sendPendingUnloadRequests(engine);
+    
     /*************************************************************************
       The following section of code manipulates variables that are accessed from 
       both the engine thread and the mixer thread, so a lock is required to 
@@ -1183,130 +2281,243 @@ kwlError kwlEngine_update(kwlEngine* engine, float timeStepSec)
     kwlMutexLockRelease(&engine->mixerEngineMutexLock);
     
     /*process messages from the mixer*/
-    int numMessages = engine->fromMixerQueue.numMessages;
-    
-    int unloadEngineDataRequested = 0;
-    for (i = 0; i < numMessages; i++)
+    kwlEngine_processMixerMessages(engine);
+
+    return KWL_NO_ERROR;
+}
+
+kwlError kwlEngine_resume(kwlEngine* engine)
+{
+    engine->mixer->isPaused.valueEngine = 0;
+    return KWL_NO_ERROR;
+}
+
+kwlError kwlEngine_pause(kwlEngine* engine)
+{
+    engine->mixer->isPaused.valueEngine = 1;
+    return KWL_NO_ERROR;
+}
+
+/** Returns the first decoder of a pool that is not in use, or NULL if all of them are.*/
+static kwlDecoder* kwlEngine_getFreeDecoder(kwlDecoder* decoders, int numDecoders)
+{
+    for (int i = 0; i < numDecoders; i++)
     {
-        kwlMessage* message = &engine->fromMixerQueue.messages[i];
-        kwlMessageType type = message->type;
-        void* messageData = message->data;
-        /*printf("engine: processing incoming message %d/%d of type %d\n", i + 1, numMessages, type);*/
-        
-        if (type == KWL_EVENT_STOPPED ||
-            type == KWL_UNLOAD_FREEFORM_EVENT)
+        if (decoders[i].codecData == NULL)
         {
-            kwlEventInstance* event = (kwlEventInstance*)messageData;
-            event->isPlaying = 0;
-            if (event->decoder != NULL)
-            {
-                kwlDecoder_deinit(event->decoder);
-            }
-            printf("    %s: %s\n", type == KWL_EVENT_STOPPED ? "event stopped" : "unload freeform event", 
-                   event->definition_engine->id);
-            kwlEngine_removeEventFromPlayingList(engine, event);
-            
-            if (type == KWL_UNLOAD_FREEFORM_EVENT)
-            {
-                kwlEngine_unloadFreeformEvent(engine, event);
-            }
-            
-            if (event->stoppedCallback != NULL)
-            {
-                event->stoppedCallback(event->stoppedCallbackUserData);
-            }
+            return &decoders[i];
         }
-        else if (type == KWL_UNLOAD_WAVEBANK)
+    }
+    return NULL;
+}
+
+/** 
+ * Sets up the decoder of an event that is not playing in the mixer, if any, marks the event as 
+ * playing and sends a start message to the mixer. Also used to start virtual events once their
+ * audio data is in memory, in which case the event is already marked as playing.
+ */
+static kwlError kwlEngine_sendEventStart(kwlEngine* engine, 
+                                         kwlEventInstance* eventToPlay, 
+                                         float fadeInTimeSec,
+                                         long long startFrame)
+{
+    /* If this is a streaming event...*/
+    if (eventToPlay->definition_engine->streamAudioData != NULL)
+    {
+        if (eventToPlay->definition_engine->streamAudioData->isLoaded == 0)
         {
-            kwlWaveBank* waveBank = (kwlWaveBank*)messageData;
-            printf("    unload wave bank: %s\n", waveBank->id);
-            kwlWaveBank_unload(waveBank);
+            return KWL_NO_ERROR; /*TODO: return some other error here?*/
         }
-        else if (type == KWL_UNLOAD_ENGINE_DATA)
+        /*...find a free decoder, either one decoding on the mixer thread or one with a thread of its own...*/
+        if (kwlDecoder_canDecodeInline(eventToPlay->definition_engine->streamAudioData))
         {
-            /*Unload engine data after all messages have been processed.*/
-            KWL_ASSERT(unloadEngineDataRequested == 0);
-            printf("received KWL_UNLOAD_ENGINE_DATA\n");
-            unloadEngineDataRequested = 1;
+            eventToPlay->decoder = kwlEngine_getFreeDecoder(engine->inlineDecoders, engine->numInlineDecoders);
+        }
+        else
+        {
+            eventToPlay->decoder = kwlEngine_getFreeDecoder(engine->decoders, engine->numDecoders);
+        }
+        if (eventToPlay->decoder == NULL)
+        {
+            return KWL_NO_FREE_DECODERS;
+        }
+        
+        /*...and initialise it*/
+        kwlError initResult = kwlDecoder_init(eventToPlay->decoder, 
+                                              eventToPlay,
+                                              &engine->streamingIO,
+                                              engine->isOffline,
+                                              &engine->config);
+
+        if (initResult != KWL_NO_ERROR)
+        {
+            eventToPlay->decoder = NULL;
+            return initResult;
         }
     }
+        
+    /*mark the event as playing and send a start message to the mixer.*/
+    if (eventToPlay->isPlaying == 0)
+    {
+        eventToPlay->isPlaying = 1;
+        kwlEngine_addEventToPlayingList(engine, eventToPlay);
+    }
+    eventToPlay->isVirtual = 0;
+    int result = kwlMessageQueue_addMessageWithParamAtFrame(&engine->toMixerQueue, 
+                                                            KWL_EVENT_START, 
+                                                            eventToPlay, 
+                                                            fadeInTimeSec,
+                                                            startFrame);
     
-    if (unloadEngineDataRequested != 0)
+    if (result == 0)
     {
-        kwlEngineData_unload(&engine->engineData);
+        return KWL_MESSAGE_QUEUE_FULL;
     }
     
-    engine->fromMixerQueue.numMessages = 0;
-
+    kwlEngine_retainAudioBuffers(engine, eventToPlay);
+    
     return KWL_NO_ERROR;
 }
 
-kwlError kwlEngine_resume(kwlEngine* engine)
+/** Returns non-zero if a given event holds a reference to a given shared audio buffer.*/
+static int kwlEngine_isAudioBufferRetained(kwlEventInstance* event, kwlSharedAudioBuffer* buffer)
 {
-    engine->mixer->isPaused.valueEngine = 0;
-    return KWL_NO_ERROR;
+    for (int i = 0; i < event->numRetainedAudioBuffers; i++)
+    {
+        if (event->retainedAudioBuffers[i] == buffer)
+        {
+            return 1;
+        }
+    }
+    return 0;
 }
 
-kwlError kwlEngine_pause(kwlEngine* engine)
+/** 
+ * Adds references to the shared buffers of the audio data of an event sent to the mixer,
+ * which are kept until the mixer reports that the event has stopped.
+ */
+static void kwlEngine_retainAudioBuffers(kwlEngine* engine, kwlEventInstance* event)
 {
-    engine->mixer->isPaused.valueEngine = 1;
-    return KWL_NO_ERROR;
+    kwlAudioData** audioData = NULL;
+    int numAudioData = 0;
+    kwlEventDefinition_getAudioData(event->definition_engine, &audioData, &numAudioData);
+    
+    /*Buffers already held from an earlier start, or from the instance an engine data 
+      reload took the event over from, are not retained again.*/
+    int numBuffers = 0;
+    for (int i = 0; i < numAudioData; i++)
+    {
+        if (audioData[i]->sharedBuffer != NULL &&
+            kwlEngine_isAudioBufferRetained(event, audioData[i]->sharedBuffer) == 0)
+        {
+            numBuffers++;
+        }
+    }
+    
+    if (numBuffers == 0)
+    {
+        return;
+    }
+    
+    event->retainedAudioBuffers = 
+        (kwlSharedAudioBuffer**)KWL_REALLOC(event->retainedAudioBuffers,
+                                            sizeof(kwlSharedAudioBuffer*) * (event->numRetainedAudioBuffers + numBuffers), 
+                                            KWL_MEMORY_CATEGORY_EVENT, 
+                                            "retained audio buffers");
+    for (int i = 0; i < numAudioData; i++)
+    {
+        kwlSharedAudioBuffer* buffer = audioData[i]->sharedBuffer;
+        if (buffer != NULL && kwlEngine_isAudioBufferRetained(event, buffer) == 0)
+        {
+            kwlSharedAudioBuffer_retain(buffer);
+            event->retainedAudioBuffers[event->numRetainedAudioBuffers] = buffer;
+            event->numRetainedAudioBuffers++;
+        }
+    }
 }
 
-kwlError kwlEngine_startEventInstance(kwlEngine* engine, 
-                                           kwlEventInstance* eventToPlay, 
-                                           float fadeInTimeSec)
+/** Releases the audio data buffers retained by an event that has stopped playing in the mixer.*/
+static void kwlEngine_releaseAudioBuffers(kwlEngine* engine, kwlEventInstance* event)
 {
-    /* If the event is not playing. */
-    if (eventToPlay->isPlaying == 0)
+    if (event->retainedAudioBuffers == NULL)
     {
-        /* If this is a streaming event...*/
-        if (eventToPlay->definition_engine->streamAudioData != NULL)
+        return;
+    }
+    
+    for (int i = 0; i < event->numRetainedAudioBuffers; i++)
+    {
+        kwlSharedAudioBuffer_release(event->retainedAudioBuffers[i]);
+    }
+    KWL_FREE(event->retainedAudioBuffers);
+    event->retainedAudioBuffers = NULL;
+    event->numRetainedAudioBuffers = 0;
+}
+
+/** 
+ * Returns non-zero if a playing event references audio data from a given wave bank, in which 
+ * case the mixer may be reading the audio data, the wave bank file or the prefetch heads of 
+ * the wave bank until the event stops.
+ */
+static int kwlEngine_isWaveBankUsedByPlayingEvent(kwlEngine* engine, kwlWaveBank* waveBank)
+{
+    kwlEventInstance* event = engine->playingEventList;
+    while (event != NULL)
+    {
+        for (int i = 0; i < event->definition_engine->numReferencedWaveBanks; i++)
         {
-            if (eventToPlay->definition_engine->streamAudioData->isLoaded == 0)
-            {
-                return KWL_NO_ERROR; /*TODO: return some other error here?*/
-            }
-            /*...find a decoder and initialise it*/
-            int freeDecoderIdx = -1;
-            int i;
-            for (i = 0; i < engine->numDecoders; i++)
-            {
-                if (engine->decoders[i].codecData == NULL)
-                {
-                    freeDecoderIdx = i;
-                    break;
-                }
-            }
-            if (freeDecoderIdx < 0)
+            if (event->definition_engine->referencedWaveBanks[i] == waveBank)
             {
-                return KWL_NO_FREE_DECODERS;
+                return 1;
             }
-            eventToPlay->decoder = &engine->decoders[freeDecoderIdx];
-            kwlError initResult = kwlDecoder_init(eventToPlay->decoder, 
-                                                  eventToPlay);
+        }
+        event = event->nextEvent_engine;
+    }
+    
+    return 0;
+}
 
-            if (initResult != KWL_NO_ERROR)
-            {
-                return initResult;
-            }
+kwlError kwlEngine_startEventInstance(kwlEngine* engine, 
+                                           kwlEventInstance* eventToPlay, 
+                                           float fadeInTimeSec,
+                                           long long startFrame)
+{
+    /* If the event is not playing. */
+    if (eventToPlay->isPlaying == 0)
+    {
+        /*Make sure any audio data loaded on demand is in memory, waiting briefly for it if needed.*/
+        kwlEventDefinition* definition = eventToPlay->definition_engine;
+        int isResident = kwlResidency_requestEvent(&engine->residency, 
+                                                   &engine->streamingIO, 
+                                                   definition, 
+                                                   engine->playingEventList, 
+                                                   0);
+        if (isResident == 0 && engine->residency.maxStartWaitTimeSec > 0.0f)
+        {
+            isResident = kwlResidency_waitForEvent(&engine->residency, 
+                                                   &engine->streamingIO, 
+                                                   definition, 
+                                                   engine->residency.maxStartWaitTimeSec);
         }
-            
-        /*mark the event as playing and send a start message to the mixer.*/
-        eventToPlay->isPlaying = 1;
-        kwlEngine_addEventToPlayingList(engine, eventToPlay);
-        int result = kwlMessageQueue_addMessageWithParam(&engine->toMixerQueue, 
-                                                         KWL_EVENT_START, 
-                                                         eventToPlay, 
-                                                         fadeInTimeSec);
         
-        if (result == 0)
+        if (isResident == 0)
         {
-            return KWL_MESSAGE_QUEUE_FULL;
+            /*Start the event virtually. It is sent to the mixer from kwlEngine_update once its 
+              audio data is in memory.*/
+            eventToPlay->isVirtual = 1;
+            eventToPlay->virtualFadeInTimeSec = fadeInTimeSec;
+            eventToPlay->virtualStartFrame = startFrame;
+            eventToPlay->isPlaying = 1;
+            kwlEngine_addEventToPlayingList(engine, eventToPlay);
+            engine->residency.stats.numVirtualStarts++;
+            return KWL_NO_ERROR;
         }
+        
+        return kwlEngine_sendEventStart(engine, eventToPlay, fadeInTimeSec, startFrame);
     }
-    /* If the event is playing and is not a streaming event, retrigger it. */
-    else if (eventToPlay->definition_engine->streamAudioData == NULL)
+    /* If the event is playing and is not a streaming event, retrigger it. 
+       Virtual events start from the beginning anyway.*/
+    else if (eventToPlay->definition_engine->streamAudioData == NULL &&
+             eventToPlay->isVirtual == 0)
     {
         /*the event is already flagged as playing. this means that it is either:
          1. playing in the mixer (the most likely case)
@@ -1315,10 +2526,11 @@ kwlError kwlEngine_startEventInstance(kwlEngine* engine,
         /*mark the event as playing and send a retrigger message to the mixer.*/
         eventToPlay->isPlaying = 1;
         //kwlEngine_addEventToPlayingList(engine, eventToPlay);
-        int result = kwlMessageQueue_addMessageWithParam(&engine->toMixerQueue, 
-                                                         KWL_EVENT_RETRIGGER, 
-                                                         eventToPlay, 
-                                                         fadeInTimeSec);
+        int result = kwlMessageQueue_addMessageWithParamAtFrame(&engine->toMixerQueue, 
+                                                                KWL_EVENT_RETRIGGER, 
+                                                                eventToPlay, 
+                                                                fadeInTimeSec,
+                                                                startFrame);
         
         if (result == 0)
         {
@@ -1329,7 +2541,7 @@ kwlError kwlEngine_startEventInstance(kwlEngine* engine,
     return KWL_NO_ERROR;
 }
 
-kwlError kwlEngine_eventStart(kwlEngine* engine, const int handle, float fadeInTimeSec)
+kwlError kwlEngine_eventStart(kwlEngine* engine, const kwlEventHandle handle, float fadeInTimeSec, long long startFrame)
 {
     kwlEventInstance* eventToPlay = kwlEngine_getEventFromHandle(engine, handle);
     
@@ -1338,12 +2550,12 @@ kwlError kwlEngine_eventStart(kwlEngine* engine, const int handle, float fadeInT
         return KWL_INVALID_EVENT_INSTANCE_HANDLE;
     }
     
-    if (fadeInTimeSec < 0.0f)
+    if (fadeInTimeSec < 0.0f || startFrame < 0)
     {
         return KWL_INVALID_PARAMETER_VALUE;
     }
     
-    return kwlEngine_startEventInstance(engine, eventToPlay, fadeInTimeSec);
+    return kwlEngine_startEventInstance(engine, eventToPlay, fadeInTimeSec, startFrame);
     
 }
 
@@ -1477,10 +2689,10 @@ kwlError kwlEngine_eventStartOneShot(kwlEngine* engine,
     instanceToStart->stoppedCallback = stoppedCallback;
     instanceToStart->stoppedCallbackUserData = stoppedCallbackUserData;
     
-    return kwlEngine_startEventInstance(engine, instanceToStart, 0.0f);
+    return kwlEngine_startEventInstance(engine, instanceToStart, 0.0f, 0);
 }
 
-kwlError kwlEngine_eventSetStoppedCallback(kwlEngine* engine, const int handle, 
+kwlError kwlEngine_eventSetStoppedCallback(kwlEngine* engine, const kwlEventHandle handle, 
                                                 kwlEventStoppedCallack stoppedCallback,
                                                 void* stoppedCallbackUserData)
 {
@@ -1502,7 +2714,7 @@ kwlError kwlEngine_eventSetStoppedCallback(kwlEngine* engine, const int handle,
 }
 
 /** */
-kwlError kwlEngine_eventStop(kwlEngine* engine, const int handle, float fadeOutTimeSec)
+kwlError kwlEngine_eventStop(kwlEngine* engine, const kwlEventHandle handle, float fadeOutTimeSec, long long stopFrame)
 {
     kwlEventInstance* eventToStop = kwlEngine_getEventFromHandle(engine, handle);
     if (eventToStop == NULL)
@@ -1510,12 +2722,20 @@ kwlError kwlEngine_eventStop(kwlEngine* engine, const int handle, float fadeOutT
         return KWL_INVALID_EVENT_INSTANCE_HANDLE;
     }
     
-    if (fadeOutTimeSec < 0.0f)
+    if (fadeOutTimeSec < 0.0f || stopFrame < 0)
     {
         return KWL_INVALID_PARAMETER_VALUE;
     }
     
-    int result = kwlMessageQueue_addMessageWithParam(&engine->toMixerQueue, KWL_EVENT_STOP, eventToStop, fadeOutTimeSec);
+    if (eventToStop->isVirtual != 0)
+    {
+        /*The mixer does not know about the event yet.*/
+        kwlEngine_stopVirtualEvent(engine, eventToStop);
+        return KWL_NO_ERROR;
+    }
+    
+    int result = kwlMessageQueue_addMessageWithParamAtFrame(&engine->toMixerQueue, KWL_EVENT_STOP, 
+                                                            eventToStop, fadeOutTimeSec, stopFrame);
     if (result == 0)
     {
         return KWL_MESSAGE_QUEUE_FULL;
@@ -1525,7 +2745,7 @@ kwlError kwlEngine_eventStop(kwlEngine* engine, const int handle, float fadeOutT
 }
 
 /** */
-kwlError kwlEngine_eventPause(kwlEngine* engine, const int handle)
+kwlError kwlEngine_eventPause(kwlEngine* engine, const kwlEventHandle handle)
 {
     kwlEventInstance* eventToPause = kwlEngine_getEventFromHandle(engine, handle);
     if (eventToPause == NULL)
@@ -1543,7 +2763,7 @@ kwlError kwlEngine_eventPause(kwlEngine* engine, const int handle)
 }
 
 /** */
-kwlError kwlEngine_eventResume(kwlEngine* engine, const int handle)
+kwlError kwlEngine_eventResume(kwlEngine* engine, const kwlEventHandle handle)
 {
     kwlEventInstance* eventToResume = kwlEngine_getEventFromHandle(engine, handle);
     if (eventToResume == NULL)
@@ -1561,7 +2781,7 @@ kwlError kwlEngine_eventResume(kwlEngine* engine, const int handle)
 }
 
 /** */
-kwlError kwlEngine_eventIsPlaying(kwlEngine* engine, const int handle, int* isPlaying)
+kwlError kwlEngine_eventIsPlaying(kwlEngine* engine, const kwlEventHandle handle, int* isPlaying)
 {
     kwlEventInstance* event = kwlEngine_getEventFromHandle(engine, handle);
     if (event == NULL)
@@ -1574,25 +2794,24 @@ kwlError kwlEngine_eventIsPlaying(kwlEngine* engine, const int handle, int* isPl
     return KWL_NO_ERROR;
 }
 
-kwlError kwlEngine_eventSetPitch(kwlEngine* engine, kwlEventHandle eventHandle, float pitch)
+kwlError kwlEngine_eventGetStreamingIOStats(kwlEngine* engine, const kwlEventHandle handle, kwlStreamingIOStats* stats)
 {
-    kwlEventInstance* event = kwlEngine_getEventFromHandle(engine, eventHandle);
+    kwlMemset(stats, 0, sizeof(kwlStreamingIOStats));
+    
+    kwlEventInstance* event = kwlEngine_getEventFromHandle(engine, handle);
     if (event == NULL)
     {
         return KWL_INVALID_EVENT_INSTANCE_HANDLE;
     }
     
-    if (pitch < 0.0f)
+    if (event->decoder != NULL && event->decoder->ioStream != NULL)
     {
-        return KWL_INVALID_PARAMETER_VALUE;
+        kwlStreamingIO_getStreamStats(&engine->streamingIO, event->decoder->ioStream, stats);
     }
-    
-    event->userPitch = pitch;
-    
     return KWL_NO_ERROR;
 }
 
-kwlError kwlEngine_eventSetPosition(kwlEngine* engine, kwlEventHandle handle, float posX, float posY, float posZ)
+kwlError kwlEngine_eventPrefetch(kwlEngine* engine, kwlEventHandle handle)
 {
     kwlEventInstance* event = kwlEngine_getEventFromHandle(engine, handle);
     if (event == NULL)
@@ -1600,6 +2819,28 @@ kwlError kwlEngine_eventSetPosition(kwlEngine* engine, kwlEventHandle handle, fl
         return KWL_INVALID_EVENT_INSTANCE_HANDLE;
     }
     
+    kwlResidency_requestEvent(&engine->residency, 
+                              &engine->streamingIO, 
+                              event->definition_engine, 
+                              engine->playingEventList, 
+                              1);
+    return KWL_NO_ERROR;
+}
+
+static kwlError kwlEngine_setEventInstancePitch(kwlEventInstance* event, float pitch)
+{
+    if (pitch < 0.0f)
+    {
+        return KWL_INVALID_PARAMETER_VALUE;
+    }
+    
+    event->userPitch = pitch;
+    
+    return KWL_NO_ERROR;
+}
+
+static kwlError kwlEngine_setEventInstancePosition(kwlEventInstance* event, float posX, float posY, float posZ)
+{
     if (event->definition_engine->isPositional == 0)
     {
         return KWL_EVENT_IS_NOT_POSITIONAL;
@@ -1612,14 +2853,8 @@ kwlError kwlEngine_eventSetPosition(kwlEngine* engine, kwlEventHandle handle, fl
     return KWL_NO_ERROR;
 }
 
-kwlError kwlEngine_eventSetOrientation(kwlEngine* engine, kwlEventHandle handle, float directionX, float directionY, float directionZ)
+static kwlError kwlEngine_setEventInstanceOrientation(kwlEventInstance* event, float directionX, float directionY, float directionZ)
 {
-    kwlEventInstance* event = kwlEngine_getEventFromHandle(engine, handle);
-    if (event == NULL)
-    {
-        return KWL_INVALID_EVENT_INSTANCE_HANDLE;
-    }
-    
     if (event->definition_engine->isPositional == 0)
     {
         return KWL_EVENT_IS_NOT_POSITIONAL;
@@ -1639,14 +2874,8 @@ kwlError kwlEngine_eventSetOrientation(kwlEngine* engine, kwlEventHandle handle,
     return KWL_NO_ERROR;
 }
 
-kwlError kwlEngine_eventSetVelocity(kwlEngine* engine, kwlEventHandle handle, float velX, float velY, float velZ)
+static kwlError kwlEngine_setEventInstanceVelocity(kwlEventInstance* event, float velX, float velY, float velZ)
 {
-    kwlEventInstance* event = kwlEngine_getEventFromHandle(engine, handle);
-    if (event == NULL)
-    {
-        return KWL_INVALID_EVENT_INSTANCE_HANDLE;
-    }
-    
     if (event->definition_engine->isPositional == 0)
     {
         return KWL_EVENT_IS_NOT_POSITIONAL;
@@ -1659,6 +2888,62 @@ kwlError kwlEngine_eventSetVelocity(kwlEngine* engine, kwlEventHandle handle, fl
     return KWL_NO_ERROR;
 }
 
+static kwlError kwlEngine_setEventInstanceGain(kwlEventInstance* event, float gain, int isLinearGain)
+{
+    if (gain < 0.0f)
+    {
+        return KWL_INVALID_PARAMETER_VALUE;
+    }
+    
+    event->userGain = isLinearGain == 1 ? gain : logGainToLinGain(gain);
+    
+    return KWL_NO_ERROR;
+}
+
+kwlError kwlEngine_eventSetPitch(kwlEngine* engine, kwlEventHandle eventHandle, float pitch)
+{
+    kwlEventInstance* event = kwlEngine_getEventFromHandle(engine, eventHandle);
+    if (event == NULL)
+    {
+        return KWL_INVALID_EVENT_INSTANCE_HANDLE;
+    }
+    
+    return kwlEngine_setEventInstancePitch(event, pitch);
+}
+
+kwlError kwlEngine_eventSetPosition(kwlEngine* engine, kwlEventHandle handle, float posX, float posY, float posZ)
+{
+    kwlEventInstance* event = kwlEngine_getEventFromHandle(engine, handle);
+    if (event == NULL)
+    {
+        return KWL_INVALID_EVENT_INSTANCE_HANDLE;
+    }
+    
+    return kwlEngine_setEventInstancePosition(event, posX, posY, posZ);
+}
+
+kwlError kwlEngine_eventSetOrientation(kwlEngine* engine, kwlEventHandle handle, float directionX, float directionY, float directionZ)
+{
+    kwlEventInstance* event = kwlEngine_getEventFromHandle(engine, handle);
+    if (event == NULL)
+    {
+        return KWL_INVALID_EVENT_INSTANCE_HANDLE;
+    }
+    
+    return kwlEngine_setEventInstanceOrientation(event, directionX, directionY, directionZ);
+}
+
+kwlError kwlEngine_eventSetVelocity(kwlEngine* engine, kwlEventHandle handle, float velX, float velY, float velZ)
+{
+    kwlEventInstance* event = kwlEngine_getEventFromHandle(engine, handle);
+    if (event == NULL)
+    {
+        return KWL_INVALID_EVENT_INSTANCE_HANDLE;
+    }
+    
+    return kwlEngine_setEventInstanceVelocity(event, velX, velY, velZ);
+}
+
 kwlError kwlEngine_eventSetBalance(kwlEngine* engine, kwlEventHandle handle, float balance)
 {
     kwlEventInstance* event = kwlEngine_getEventFromHandle(engine, handle);
@@ -1690,14 +2975,100 @@ kwlError kwlEngine_eventSetGain(kwlEngine* engine, kwlEventHandle eventHandle, f
         return KWL_INVALID_EVENT_INSTANCE_HANDLE;
     }
     
-    if (gain < 0.0f)
+    return kwlEngine_setEventInstanceGain(event, gain, isLinearGain);
+}
+
+/** Stores \c error in \c firstError unless an earlier error is stored there.*/
+static void kwlEngine_keepFirstError(kwlError* firstError, kwlError error)
+{
+    if (*firstError == KWL_NO_ERROR)
+    {
+        *firstError = error;
+    }
+}
+
+kwlError kwlEngine_eventBatchSetParameters(kwlEngine* engine, 
+                                           const kwlEventHandle* handles, 
+                                           int numEvents, 
+                                           const kwlEventParameterBatch* parameters, 
+                                           kwlError* errors)
+{
+    if (handles == NULL || parameters == NULL || numEvents < 0 ||
+        parameters->positionStride < 0 || parameters->velocityStride < 0 || 
+        parameters->orientationStride < 0 || parameters->gainStride < 0 || 
+        parameters->pitchStride < 0)
     {
         return KWL_INVALID_PARAMETER_VALUE;
     }
     
-    event->userGain = isLinearGain == 1 ? gain : logGainToLinGain(gain);
+    /*A stride of 0 means tightly packed elements.*/
+    const int vectorSize = 3 * (int)sizeof(float);
+    const int positionStride = parameters->positionStride == 0 ? vectorSize : parameters->positionStride;
+    const int velocityStride = parameters->velocityStride == 0 ? vectorSize : parameters->velocityStride;
+    const int orientationStride = parameters->orientationStride == 0 ? vectorSize : parameters->orientationStride;
+    const int gainStride = parameters->gainStride == 0 ? (int)sizeof(float) : parameters->gainStride;
+    const int pitchStride = parameters->pitchStride == 0 ? (int)sizeof(float) : parameters->pitchStride;
+    const int isLinearGain = parameters->isLinearGain != 0;
     
-    return KWL_NO_ERROR;
+    const char* position = (const char*)parameters->positions;
+    const char* velocity = (const char*)parameters->velocities;
+    const char* orientation = (const char*)parameters->orientations;
+    const char* gain = (const char*)parameters->gains;
+    const char* pitch = (const char*)parameters->pitches;
+    
+    kwlError firstError = KWL_NO_ERROR;
+    
+    int i;
+    for (i = 0; i < numEvents; i++)
+    {
+        kwlError result = KWL_NO_ERROR;
+        kwlEventInstance* event = kwlEngine_getEventFromHandle(engine, handles[i]);
+        if (event == NULL)
+        {
+            result = KWL_INVALID_EVENT_INSTANCE_HANDLE;
+        }
+        else
+        {
+            if (position != NULL)
+            {
+                const float* p = (const float*)(position + (size_t)i * positionStride);
+                kwlEngine_keepFirstError(&result, kwlEngine_setEventInstancePosition(event, p[0], p[1], p[2]));
+            }
+            
+            if (velocity != NULL)
+            {
+                const float* v = (const float*)(velocity + (size_t)i * velocityStride);
+                kwlEngine_keepFirstError(&result, kwlEngine_setEventInstanceVelocity(event, v[0], v[1], v[2]));
+            }
+            
+            if (orientation != NULL)
+            {
+                const float* d = (const float*)(orientation + (size_t)i * orientationStride);
+                kwlEngine_keepFirstError(&result, kwlEngine_setEventInstanceOrientation(event, d[0], d[1], d[2]));
+            }
+            
+            if (gain != NULL)
+            {
+                const float* g = (const float*)(gain + (size_t)i * gainStride);
+                kwlEngine_keepFirstError(&result, kwlEngine_setEventInstanceGain(event, *g, isLinearGain));
+            }
+            
+            if (pitch != NULL)
+            {
+                const float* p = (const float*)(pitch + (size_t)i * pitchStride);
+                kwlEngine_keepFirstError(&result, kwlEngine_setEventInstancePitch(event, *p));
+            }
+        }
+        
+        if (errors != NULL)
+        {
+            errors[i] = result;
+        }
+        
+        kwlEngine_keepFirstError(&firstError, result);
+    }
+    
+    return firstError;
 }
 
 kwlError kwlEngine_attachDSPUnitToEvent(kwlEngine* engine, kwlEventHandle eventHandle, kwlDSPUnit* dspUnit)
@@ -1877,7 +3248,13 @@ kwlError kwlEngine_initialize(kwlEngine* engine,
     engine->mixer->numInChannels = numInChannels;
     engine->isInputEnabled = numInChannels > 0 ? 1 : 0;
     
-    kwlMixer_allocateTempBuffers(engine->mixer);
+    kwlMixer_allocateTempBuffers(engine->mixer, engine->config.mixBufferSizeInFrames);
+    
+    /*offline engines are rendered by the application instead of the host*/
+    if (engine->isOffline != 0)
+    {
+        return KWL_NO_ERROR;
+    }
     
     kwlError result = kwlEngine_hostSpecificInitialize(engine, sampleRate, numOutChannels, numInChannels, bufferSize);
     
@@ -1898,7 +3275,7 @@ kwlError kwlEngine_engineDataLoad(kwlEngine* engine, const char* const dataFile)
     }
     
     kwlInputStream stream;
-    kwlError result = kwlInputStream_initWithFile(&stream, dataFile);
+    kwlError result = kwlInputStream_initWithFile(&stream, dataFile, &engine->fileSystem);
 
     if (result != KWL_NO_ERROR)
     {
@@ -1925,39 +3302,178 @@ kwlError kwlEngine_engineDataLoad(kwlEngine* engine, const char* const dataFile)
     return KWL_NO_ERROR;
 }
 
-kwlError kwlEngine_unloadEngineDataBlocking(kwlEngine* engine)
+kwlError kwlEngine_requestUnloadEngineData(kwlEngine* engine, kwlUnloadCompletedCallback callback, void* userData)
 {
     if (engine->engineData.isLoaded == 0)
     {
+        if (callback != NULL)
+        {
+            kwlEngine_addPendingUnload(engine, NULL, KWL_UNLOAD_COMPLETED, callback, userData);
+        }
         return KWL_NO_ERROR;
     }
     
-    /*Send a message to the mixer requesting it to: 
-     - stop any playing data driven events
-     - change its mix bus array to only contain the always valid master bus.
-      The mixer then sends a KWL_UNLOAD_ENGINE_DATA message back to the engine thread
-      that triggers the actual unloading.*/
-    int result = kwlMessageQueue_addMessage(&engine->toMixerQueue, KWL_PREPARE_ENGINE_DATA_UNLOAD, NULL);
-    //printf("posted KWL_PREPARE_ENGINE_DATA_UNLOAD\n");
-    KWL_ASSERT(result != 0);
+    if (kwlEngine_isUnloadPending(engine, NULL) == 0)
+    {
+        kwlEngine_stopVirtualEventsReferencingWaveBank(engine, NULL);
+    }
+    
+    /*Engine data is unloaded by kwlEngine_update when the mixer sends a KWL_UNLOAD_ENGINE_DATA
+      message back, after stopping all data driven events and clearing its mix buses.*/
+    kwlPendingUnload* unload = kwlEngine_addPendingUnload(engine, 
+                                                          NULL, 
+                                                          KWL_UNLOAD_SENDING_REQUEST, 
+                                                          callback, 
+                                                          userData);
+    kwlEngine_sendUnloadRequest(engine, unload);
+    
+    return KWL_NO_ERROR;
+}
+
+kwlError kwlEngine_unloadEngineDataBlocking(kwlEngine* engine)
+{
+    kwlError result = kwlEngine_requestUnloadEngineData(engine, NULL, NULL);
+    if (result != KWL_NO_ERROR)
+    {
+        return result;
+    }
+    
+    kwlEngine_waitForPendingUnloads(engine, NULL);
+    return KWL_NO_ERROR;
+}
+
+kwlError kwlEngine_engineDataIsUnloadPending(kwlEngine* engine, int* isPending)
+{
+    *isPending = kwlEngine_isUnloadPending(engine, NULL);
+    return KWL_NO_ERROR;
+}
+
+kwlError kwlEngine_requestEngineDataReload(kwlEngine* engine, 
+                                           const char* const dataFile, 
+                                           kwlEngineDataReloadedCallback callback, 
+                                           void* userData)
+{
+    kwlPendingReload* reload = &engine->pendingReload;
+    if (reload->state != KWL_RELOAD_IDLE)
+    {
+        return KWL_ENGINE_DATA_RELOAD_PENDING;
+    }
+    
+    if (engine->engineData.isLoaded == 0 || kwlEngine_isUnloadPending(engine, NULL) != 0)
+    {
+        return KWL_ENGINE_DATA_NOT_LOADED;
+    }
     
-    /*Block until the engine data has been unloaded.*/
-    while (engine->engineData.isLoaded != 0)
+    /*open the file right away, so that a missing file is reported to the caller.*/
+    kwlError result = kwlInputStream_initWithFile(&reload->stream, dataFile, &engine->fileSystem);
+    if (result != KWL_NO_ERROR)
     {
-        /*printf("waiting for mixer to stop data driven events and clear mix buses\n");*/
-        kwlUpdate(0);
+        kwlInputStream_close(&reload->stream);
+        return result;
     }
     
+    kwlMemset(&reload->data, 0, sizeof(kwlEngineData));
+    kwlMemset(&reload->swap, 0, sizeof(kwlEngineDataSwap));
+    reload->isParsed = 0;
+    reload->result = KWL_NO_ERROR;
+    reload->callback = callback;
+    reload->callbackUserData = userData;
+    reload->state = KWL_RELOAD_PARSING;
+    
+    /*parse the file on a thread of its own. the data is swapped in by kwlEngine_update.*/
+    kwlThreadCreate(&reload->thread, kwlEngine_engineDataReloadThreadEntryPoint, reload);
+    
+    return KWL_NO_ERROR;
+}
+
+kwlError kwlEngine_engineDataIsReloadPending(kwlEngine* engine, int* isPending)
+{
+    *isPending = engine->pendingReload.state != KWL_RELOAD_IDLE;
     return KWL_NO_ERROR;
 }
 
 /** */
 void kwlEngine_deinitialize(kwlEngine* engine)
 {
-    /* Unload any engine data and wave banks*/
-    kwlEngineDataUnload();
+    /* Discard any engine data being reloaded, then unload any engine data and wave banks*/
+    kwlEngine_cancelEngineDataReload(engine);
+    kwlEngine_unloadEngineDataBlocking(engine);
     /* Shut down the sound system.*/
-    kwlEngine_hostSpecificDeinitialize(engine);
+    if (engine->isOffline == 0)
+    {
+        kwlEngine_hostSpecificDeinitialize(engine);
+    }
+}
+
+kwlError kwlEngine_render(kwlEngine* engine, float* outBuffer, int numFrames)
+{
+    if (engine->isOffline == 0 || outBuffer == NULL || numFrames < 0)
+    {
+        return KWL_INVALID_PARAMETER_VALUE;
+    }
+    
+    /*the mixer renders at most mixBufferSizeInFrames frames at a time, 
+      so larger buffers are rendered in several passes.*/
+    const int numOutChannels = engine->mixer->numOutChannels;
+    int currFrame = 0;
+    while (currFrame < numFrames)
+    {
+        int numFramesToMix = numFrames - currFrame;
+        if (numFramesToMix > engine->mixer->tempBufferSizeInFrames)
+        {
+            numFramesToMix = engine->mixer->tempBufferSizeInFrames;
+        }
+        
+        kwlMixer_render(engine->mixer, &outBuffer[currFrame * numOutChannels], numFramesToMix);
+        currFrame += numFramesToMix;
+    }
+    
+    return KWL_NO_ERROR;
+}
+
+kwlError kwlEngine_createCommandBuffer(kwlEngine* engine, int capacity, kwlCommandBuffer** buffer)
+{
+    if (capacity <= 0)
+    {
+        return KWL_INVALID_PARAMETER_VALUE;
+    }
+    
+    kwlCommandBuffer* newBuffer = (kwlCommandBuffer*)KWL_MALLOC(sizeof(kwlCommandBuffer), 
+                                                                KWL_MEMORY_CATEGORY_GENERAL, 
+                                                                "command buffer");
+    kwlCommandBuffer_init(newBuffer, engine, capacity);
+    
+    /*append the buffer, so that buffers are executed in creation order*/
+    kwlCommandBuffer** link = &engine->commandBuffers;
+    while (*link != NULL)
+    {
+        link = &(*link)->next;
+    }
+    *link = newBuffer;
+    
+    *buffer = newBuffer;
+    return KWL_NO_ERROR;
+}
+
+kwlError kwlEngine_destroyCommandBuffer(kwlEngine* engine, kwlCommandBuffer* buffer)
+{
+    kwlCommandBuffer** link = &engine->commandBuffers;
+    while (*link != NULL && *link != buffer)
+    {
+        link = &(*link)->next;
+    }
+    
+    if (*link == NULL)
+    {
+        return KWL_INVALID_PARAMETER_VALUE;
+    }
+    
+    /*commands that were submitted before the buffer was destroyed still take effect*/
+    kwlEngine_executeCommandBuffer(engine, buffer);
+    *link = buffer->next;
+    kwlCommandBuffer_free(buffer);
+    KWL_FREE(buffer);
+    return KWL_NO_ERROR;
 }
 
 kwlError kwlEngine_getNumFramesMixed(kwlEngine* engine, unsigned int* numFrames)
@@ -1976,6 +3492,46 @@ kwlError kwlEngine_getNumFramesMixed(kwlEngine* engine, unsigned int* numFrames)
     return KWL_NO_ERROR;
 }
 
+kwlError kwlEngine_getTotalNumFramesMixed(kwlEngine* engine, long long* numFrames)
+{
+    *numFrames = engine->mixer->numFramesMixed.valueEngine;
+    return KWL_NO_ERROR;
+}
+
+kwlError kwlEngine_getStreamingIOStats(kwlEngine* engine, kwlStreamingIOStats* stats)
+{
+    kwlStreamingIO_getStats(&engine->streamingIO, stats);
+    return KWL_NO_ERROR;
+}
+
+kwlError kwlEngine_setResidencyBudget(kwlEngine* engine, int numBytes)
+{
+    if (numBytes < 0)
+    {
+        return KWL_INVALID_PARAMETER_VALUE;
+    }
+    
+    engine->residency.budget = numBytes;
+    return KWL_NO_ERROR;
+}
+
+kwlError kwlEngine_setResidencyMaxStartWaitTime(kwlEngine* engine, float seconds)
+{
+    if (seconds < 0.0f)
+    {
+        return KWL_INVALID_PARAMETER_VALUE;
+    }
+    
+    engine->residency.maxStartWaitTimeSec = seconds;
+    return KWL_NO_ERROR;
+}
+
+kwlError kwlEngine_getResidencyStats(kwlEngine* engine, kwlResidencyStats* stats)
+{
+    *stats = engine->residency.stats;
+    return KWL_NO_ERROR;
+}
+
 kwlError kwlEngine_hasClipped(kwlEngine* engine, int* hasClipped)
 {
     if (engine->mixer->isLevelMeteringEnabled.valueEngine == 0)  
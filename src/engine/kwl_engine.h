@@ -28,6 +28,8 @@ freely, subject to the following restrictions:
 #include "kowalski.h"
 #include "kwl_audiodata.h"
 #include "kwl_enginedata.h"
+#include "kwl_filesystem.h"
+#include "kwl_freeformeventpool.h"
 #include "kwl_dspunit.h"
 #include "kwl_eventinstance.h"
 #include "kwl_inputstream.h"
@@ -37,15 +39,132 @@ freely, subject to the following restrictions:
 #include "kwl_positionalaudiosettings.h"
 #include "kwl_mixer.h"
 #include "kwl_sounddefinition.h"
+#include "kwl_residency.h"
+#include "kwl_streamingio.h"
 #include "kwl_wavebank.h"
 
 #ifdef __cplusplus
 extern "C"
 {
 #endif /* __cplusplus */
+
+/** 
+ * @name Event handle encoding
+ * An event handle holds a freeform flag in its most significant bit, followed by a
+ * generation counter and an index. The index is the slot of the event in the engine's array
+ * of event handle slots, which is shared by data driven and freeform events. The generation
+ * is compared to the generation of the slot, which is incremented when the event is released,
+ * so stale handles are rejected instead of addressing a reused event. Since handles do not 
+ * address event instances directly, the instance in a slot can be replaced when engine data
+ * is reloaded. A slot whose generation wraps around is retired, so a released handle is never
+ * valid again. With 32 bit handles, this limits an engine to about 2^31 handles in total.
+ */
+/** @{ */
+#ifdef KWL_64_BIT_EVENT_HANDLES
+/** An unsigned integer with the size of an event handle.*/
+typedef unsigned long long kwlEventHandleBits;
+/** The number of index bits of an event handle.*/
+#define KWL_EVENT_HANDLE_NUM_INDEX_BITS 32
+/** The number of event handle indices. The last index is never used, so no handle equals \c KWL_INVALID_HANDLE.*/
+#define KWL_EVENT_HANDLE_NUM_INDICES 0x7fffffff
+#else
+/** An unsigned integer with the size of an event handle.*/
+typedef unsigned int kwlEventHandleBits;
+/** The number of index bits of an event handle.*/
+#define KWL_EVENT_HANDLE_NUM_INDEX_BITS 20
+/** The number of event handle indices. The last index is never used, so no handle equals \c KWL_INVALID_HANDLE.*/
+#define KWL_EVENT_HANDLE_NUM_INDICES ((1 << KWL_EVENT_HANDLE_NUM_INDEX_BITS) - 1)
+#endif /* KWL_64_BIT_EVENT_HANDLES */
+/** The number of generation bits of an event handle.*/
+#define KWL_EVENT_HANDLE_NUM_GENERATION_BITS (8 * sizeof(kwlEventHandleBits) - KWL_EVENT_HANDLE_NUM_INDEX_BITS - 1)
+/** The mask applied to generation counters.*/
+#define KWL_EVENT_HANDLE_GENERATION_MASK ((((kwlEventHandleBits)1) << KWL_EVENT_HANDLE_NUM_GENERATION_BITS) - 1)
+/** The mask of the index bits of an event handle.*/
+#define KWL_EVENT_HANDLE_INDEX_MASK ((((kwlEventHandleBits)1) << KWL_EVENT_HANDLE_NUM_INDEX_BITS) - 1)
+/** @} */
+
+/** An entry in the engine's array of event handle slots.*/
+typedef struct kwlEventHandleSlot
+{
+    /** The event associated with the handles to this slot, or NULL if the slot is free.*/
+    struct kwlEventInstance* event;
+    /** 
+     * Incremented when the event in this slot is released, invalidating handles to it. 
+     * A slot is retired instead of reused when its generation wraps around to zero, so 
+     * a handle never becomes valid again.
+     */
+    unsigned int generation;
+    /** Non-zero if the event in this slot is a freeform event, zero if it is a data driven event.*/
+    int isFreeform;
+} kwlEventHandleSlot;
+    
+/** The states of a requested wave bank or engine data unload.*/
+typedef enum kwlUnloadState
+{
+    /** The unload request could not be sent to the mixer because the message queue was full. Resent by \c kwlEngine_update.*/
+    KWL_UNLOAD_SENDING_REQUEST = 0,
+    /** Waiting for the mixer to stop the events using the data to unload.*/
+    KWL_UNLOAD_WAITING_FOR_MIXER,
+    /** The data has been unloaded. The completion callback is invoked by \c kwlEngine_update.*/
+    KWL_UNLOAD_COMPLETED
+} kwlUnloadState;
+
+/** A requested wave bank or engine data unload whose completion callback has not been invoked yet.*/
+typedef struct kwlPendingUnload
+{
+    /** The state of the unload.*/
+    kwlUnloadState state;
+    /** The wave bank to unload, or NULL if engine data is unloaded.*/
+    kwlWaveBank* waveBank;
+    /** Invoked when the unload has completed. Can be NULL.*/
+    kwlUnloadCompletedCallback callback;
+    /** Passed to \c callback.*/
+    void* callbackUserData;
+} kwlPendingUnload;
+    
+/** The states of a requested engine data reload.*/
+typedef enum kwlReloadState
+{
+    /** No reload is in progress.*/
+    KWL_RELOAD_IDLE = 0,
+    /** The new engine data is being parsed on the reload thread.*/
+    KWL_RELOAD_PARSING,
+    /** The new engine data has been parsed and is swapped in by \c kwlEngine_update.*/
+    KWL_RELOAD_PARSED,
+    /** The new engine data has been swapped in. Waiting for the mixer to stop using the previous data.*/
+    KWL_RELOAD_WAITING_FOR_MIXER
+} kwlReloadState;
+
+/** A requested engine data reload whose completion callback has not been invoked yet.*/
+typedef struct kwlPendingReload
+{
+    /** The state of the reload.*/
+    kwlReloadState state;
+    /** The thread parsing the new engine data.*/
+    kwlThread thread;
+    /** Protects \c isParsed, which is set from the reload thread.*/
+    kwlMutexLock lock;
+    /** Non-zero once the reload thread is done parsing.*/
+    int isParsed;
+    /** The stream the new engine data is read from.*/
+    kwlInputStream stream;
+    /** The result of parsing the new engine data.*/
+    kwlError result;
+    /** 
+     * The new engine data until it is swapped in, then the engine data it replaced until the
+     * mixer has switched over.
+     */
+    kwlEngineData data;
+    /** The description of the swap passed to the mixer.*/
+    kwlEngineDataSwap swap;
+    /** Invoked when the reload has completed or failed. Can be NULL.*/
+    kwlEngineDataReloadedCallback callback;
+    /** Passed to \c callback.*/
+    void* callbackUserData;
+} kwlPendingReload;
     
 /** 
- * A struct representing the singleton Kowalski sound engine. 
+ * A struct representing an instance of the Kowalski sound engine. 
  */
 typedef struct kwlEngine
 {
@@ -66,6 +185,20 @@ typedef struct kwlEngine
      * like message queues.
      */
     kwlMutexLock mixerEngineMutexLock;
+    /** 
+     * Posted by the mixer when it passes messages to the engine thread while the engine
+     * thread waits for an unload to complete.
+     */
+    kwlSemaphore* mixerMessageSemaphore;
+    /** The unique name of \c mixerMessageSemaphore.*/
+    char mixerMessageSemaphoreName[64];
+    
+    /** The requested wave bank and engine data unloads, in the order they were requested.*/
+    kwlPendingUnload* pendingUnloads;
+    /** The number of entries in \c pendingUnloads.*/
+    int numPendingUnloads;
+    /** The capacity of \c pendingUnloads.*/
+    int pendingUnloadArraySize;
     
     /**
      * A mutex lock protecting the queue used for wavebank loading messages.
@@ -77,10 +210,25 @@ typedef struct kwlEngine
     /** A struct containing information about the current 3D audio listener. */
     kwlPositionalAudioListener listener;
     
-    /** The current size of the array of freeform events, i.e events created in code.*/
-    int freeformEventArraySize;
-    /** An array of freeform events, i.e events created in code. This array is dynamically resized and may contain null entries. */
-    struct kwlEventInstance** freeformEvents;
+    /** The current size of the array of event handle slots.*/
+    int eventHandleSlotArraySize;
+    /** 
+     * The slots of the data driven and freeform events that are associated with handles. 
+     * This array is grown in chunks and may contain free slots.
+     */
+    kwlEventHandleSlot* eventHandleSlots;
+    /** 
+     * A ring buffer queue of the indices of the null entries in \c eventHandleSlots, so free slots 
+     * are found in constant time. Slots are reused in the order they were freed, which spreads 
+     * generation increments over all free slots.
+     */
+    int* freeEventHandleSlots;
+    /** The position of the first index in the \c freeEventHandleSlots queue.*/
+    int firstFreeEventHandleSlot;
+    /** The number of indices in \c freeEventHandleSlots.*/
+    int numFreeEventHandleSlots;
+    /** The pool freeform events and the data they own are taken from.*/
+    kwlFreeformEventPool freeformEventPool;
     
     int isInputEnabled;
     
@@ -89,6 +237,34 @@ typedef struct kwlEngine
     int numDecoders;
     /** */
     struct kwlDecoder* decoders;
+    /** The number of decoders in \c inlineDecoders.*/
+    int numInlineDecoders;
+    /** The decoders of events decoding in-memory audio data on the mixer thread.*/
+    struct kwlDecoder* inlineDecoders;
+    /** The callbacks all files are read through. Set before \c kwlEngine_init is called.*/
+    kwlFileSystem fileSystem;
+    /** The capacity limits and buffer sizes of the engine. Set before \c kwlEngine_init is called.*/
+    kwlEngineConfig config;
+    /** Performs the disk reads of decoders streaming audio data from wave bank files.*/
+    kwlStreamingIO streamingIO;
+    /** Keeps track of the audio data of wave banks loaded on demand.*/
+    kwlResidency residency;
+    /** 
+     * Shares the audio data of identical entries of different wave banks. The cache may be shared 
+     * with other engines. Set before \c kwlEngine_init is called to share the cache of another engine,
+     * otherwise a new cache is created.
+     */
+    kwlAudioDataCache* audioDataCache;
+    
+    /** 
+     * Non-zero if the engine does not output audio through the host and is rendered by the 
+     * application instead. Set before \c kwlEngine_initialize is called.
+     */
+    int isOffline;
+    /** The first error of the public API calls made with this engine since the error was last read.*/
+    kwlError error;
+    /** The command buffers recorded into by application threads, in creation order.*/
+    struct kwlCommandBuffer* commandBuffers;
     
     /** 
      * A linked list of currently playing events, ie events for which a 'start event' message has been sent and
@@ -101,9 +277,18 @@ typedef struct kwlEngine
     
     /** The currently loaded engine data.*/
     kwlEngineData engineData;
+    
+    /** The engine data reload in progress, if any.*/
+    kwlPendingReload pendingReload;
 
 } kwlEngine; 
     
+/** Fills in the config used by engines created without one. */
+void kwlEngine_getDefaultConfig(kwlEngineConfig* config);
+
+/** Returns KWL_INVALID_PARAMETER_VALUE if a field of a given config is out of range. */
+kwlError kwlEngine_validateConfig(const kwlEngineConfig* config);
+    
 /** Initializes a newly allocated sound engine instance. */
 void kwlEngine_init(kwlEngine* engine);
     
@@ -114,7 +299,7 @@ void kwlEngine_free(kwlEngine* engine);
  * Event methods
  ***********************************************************************/
 /** */
-kwlError kwlEngine_eventGetHandle(kwlEngine* engine, const char* const eventId, int* handle);
+kwlError kwlEngine_eventGetHandle(kwlEngine* engine, const char* const eventId, kwlEventHandle* handle);
 
 /** */
 kwlError kwlEngine_eventDefinitionGetHandle(kwlEngine* engine, 
@@ -135,14 +320,15 @@ kwlError kwlEngine_eventRelease(kwlEngine* engine, kwlEventHandle handle);
 /** */
 kwlError kwlEngine_unloadFreeformEvent(kwlEngine* engine, struct kwlEventInstance* event);
 
-/** */
-kwlError kwlEngine_eventStart(kwlEngine* engine, const int handle, float fadeInTimeSec);
+/** Starts a given event at a given mixer frame. A start frame of zero starts the event immediately.*/
+kwlError kwlEngine_eventStart(kwlEngine* engine, const kwlEventHandle handle, float fadeInTimeSec, long long startFrame);
     
 /** */
-kwlError kwlEngine_startEventInstance(kwlEngine* engine, struct kwlEventInstance* event, float fadeInTimeSec);
+kwlError kwlEngine_startEventInstance(kwlEngine* engine, struct kwlEventInstance* event, 
+                                      float fadeInTimeSec, long long startFrame);
     
-/** */
-kwlError kwlEngine_eventStop(kwlEngine* engine, const int handle, float fadeOutTimeSec);
+/** Stops a given event at a given mixer frame. A stop frame of zero stops the event immediately.*/
+kwlError kwlEngine_eventStop(kwlEngine* engine, const kwlEventHandle handle, float fadeOutTimeSec, long long stopFrame);
 
 /** */
 kwlError kwlEngine_eventStartOneShot(kwlEngine* engine, 
@@ -152,18 +338,24 @@ kwlError kwlEngine_eventStartOneShot(kwlEngine* engine,
                                           kwlEventStoppedCallack stoppedCallback,
                                           void* stoppedCallbackUserData);
 
-kwlError kwlEngine_eventSetStoppedCallback(kwlEngine* engine, const int handle, 
+kwlError kwlEngine_eventSetStoppedCallback(kwlEngine* engine, const kwlEventHandle handle, 
                                                 kwlEventStoppedCallack stoppedCallback,
                                                 void* stoppedCallbackUserData);
     
 /** */
-kwlError kwlEngine_eventPause(kwlEngine* engine, const int handle);
+kwlError kwlEngine_eventPause(kwlEngine* engine, const kwlEventHandle handle);
     
 /** */
-kwlError kwlEngine_eventResume(kwlEngine* engine, const int handle);    
+kwlError kwlEngine_eventResume(kwlEngine* engine, const kwlEventHandle handle);    
     
 /** */
-kwlError kwlEngine_eventIsPlaying(kwlEngine* engine, const int handle, int* isPlaying);
+kwlError kwlEngine_eventIsPlaying(kwlEngine* engine, const kwlEventHandle handle, int* isPlaying);
+
+/** Gets the disk read statistics of a streaming event. */
+kwlError kwlEngine_eventGetStreamingIOStats(kwlEngine* engine, const kwlEventHandle handle, kwlStreamingIOStats* stats);
+
+/** Starts loading the audio data of a given event that is loaded on demand, without starting the event. */
+kwlError kwlEngine_eventPrefetch(kwlEngine* engine, kwlEventHandle handle);
     
 /** */
 kwlError kwlEngine_eventSetPitch(kwlEngine* engine, kwlEventHandle event, float pitchPercent);
@@ -183,6 +375,16 @@ kwlError kwlEngine_eventSetBalance(kwlEngine* engine, kwlEventHandle handle, flo
 /** */
 kwlError kwlEngine_eventSetGain(kwlEngine* engine, kwlEventHandle eventHandle, float gain, int isLinearGain);
     
+/** 
+ * Sets the parameters of a number of events, storing the first error of each event in \c errors if
+ * it is not NULL. Returns the first error of any event.
+ */
+kwlError kwlEngine_eventBatchSetParameters(kwlEngine* engine, 
+                                           const kwlEventHandle* handles, 
+                                           int numEvents, 
+                                           const kwlEventParameterBatch* parameters, 
+                                           kwlError* errors);
+    
 /** Adds a given event to the linked list of currently playing events. */
 void kwlEngine_addEventToPlayingList(kwlEngine* engine, struct kwlEventInstance* eventToAdd);
     
@@ -195,8 +397,8 @@ struct kwlEventInstance* kwlEngine_getEventFromHandle(kwlEngine* engine, kwlEven
 /** Returns non-zero if the given handle corresponds to a freeform event, zero otherwise.*/
 int kwlEngine_isFreeformEventHandle(kwlEngine* engine, kwlEventHandle handle);   
 
-/** */
-int kwlEngine_getFreeformIndexFromHandle(kwlEngine* engine, kwlEventHandle handle);
+/** Returns the index of the event handle slot encoded in a given handle.*/
+int kwlEngine_getSlotIndexFromHandle(kwlEngine* engine, kwlEventHandle handle);
     
 /** */
 void kwlEngine_updateEvents(kwlEngine* engine);
@@ -291,26 +493,64 @@ kwlError kwlEngine_isLoaded(kwlEngine* engine, int* ret);
 /** */
 kwlError kwlEngine_engineDataLoad(kwlEngine* engine, const char* const dataFile);
     
-/** */
-kwlError kwlEngine_engineDataUnload(kwlEngine* engine);
+/** 
+ * Requests the mixer to stop all data driven events, after which engine data is unloaded
+ * from \c kwlEngine_update and the given callback, if not NULL, is invoked.
+ */
+kwlError kwlEngine_requestUnloadEngineData(kwlEngine* engine, kwlUnloadCompletedCallback callback, void* userData);
 
-/** */
+/** Unloads engine data, waiting for the mixer to stop all data driven events.*/
 kwlError kwlEngine_unloadEngineDataBlocking(kwlEngine* engine);
+
+/** Checks if an engine data unload has been requested but has not completed yet.*/
+kwlError kwlEngine_engineDataIsUnloadPending(kwlEngine* engine, int* isPending);
+
+/** 
+ * Starts parsing engine data from a given file on a background thread. The new data is swapped in 
+ * by \c kwlEngine_update once parsed, after which the given callback, if not NULL, is invoked.
+ */
+kwlError kwlEngine_requestEngineDataReload(kwlEngine* engine, 
+                                           const char* const dataFile, 
+                                           kwlEngineDataReloadedCallback callback, 
+                                           void* userData);
+
+/** Checks if an engine data reload has been requested but has not completed yet.*/
+kwlError kwlEngine_engineDataIsReloadPending(kwlEngine* engine, int* isPending);
     
 /** Releases all loaded audio and engine data and shuts down the underlying sound system. */
 void kwlEngine_deinitialize(kwlEngine* engine);
 
+/** 
+ * Renders a given number of frames of an offline engine, mixing at most 
+ * \c mixBufferSizeInFrames frames of the engine configuration at a time.
+ */
+kwlError kwlEngine_render(kwlEngine* engine, float* outBuffer, int numFrames);
+
+/** 
+ * Creates a command buffer executed by the engine, after all command buffers created before it.
+ */
+kwlError kwlEngine_createCommandBuffer(kwlEngine* engine, int capacity, struct kwlCommandBuffer** buffer);
+
+/** 
+ * Executes the submitted commands of a given command buffer and frees it.
+ */
+kwlError kwlEngine_destroyCommandBuffer(kwlEngine* engine, struct kwlCommandBuffer* buffer);
+
 /***********************************************************************
  * Data loading/unloading methods
  ***********************************************************************/
 /** Loads engine data (ie non-audio data) from a given stream. */
 kwlError kwlEngine_loadEngineData(kwlEngine* engine, kwlInputStream* stream);
     
-/** Loads the audio data entries in Kowalski wave bank binary file. */
+/** 
+ * Loads the audio data entries in Kowalski wave bank binary file. If \c loadOnDemand is non-zero,
+ * only the table of contents is read and entries are loaded when first used.
+ */
 kwlError kwlEngine_loadWaveBank(kwlEngine* engine, 
                                      const char* const waveBankFile, 
                                      kwlWaveBankHandle* handle,
-                                     int threaded);
+                                     int threaded,
+                                     int loadOnDemand);
 
 /** */
 kwlError kwlEngine_waveBankIsLoaded(kwlEngine* engine, kwlWaveBankHandle handle, int* isLoaded);
@@ -318,14 +558,46 @@ kwlError kwlEngine_waveBankIsLoaded(kwlEngine* engine, kwlWaveBankHandle handle,
 /** */
 kwlError kwlEngine_waveBankIsReferencedByPlayingEvent(kwlEngine* engine, kwlWaveBankHandle handle, int* isReferenced);
 
-/** */
-kwlError kwlEngine_requestUnloadWaveBank(kwlEngine* engine, kwlWaveBankHandle waveBankHandle, int blockUntilUnloaded);
+/** Gets the number of bytes used by the prefetch heads of a given wave bank.*/
+kwlError kwlEngine_waveBankGetPrefetchHeadMemory(kwlEngine* engine, kwlWaveBankHandle handle, int* numBytes);
+
+/** 
+ * Unloads a given wave bank right away if no playing event streams from it. Otherwise, 
+ * requests the mixer to stop the events using it, after which the wave bank is unloaded from 
+ * \c kwlEngine_update. The given callback, if not NULL, is invoked from \c kwlEngine_update
+ * once the wave bank is unloaded.
+ */
+kwlError kwlEngine_requestUnloadWaveBank(kwlEngine* engine, 
+                                         kwlWaveBankHandle waveBankHandle, 
+                                         kwlUnloadCompletedCallback callback,
+                                         void* userData);
+
+/** Unloads a given wave bank, waiting for the mixer to stop any events streaming from it.*/
+kwlError kwlEngine_unloadWaveBankBlocking(kwlEngine* engine, kwlWaveBankHandle waveBankHandle);
+
+/** Checks if an unload of a given wave bank has been requested but has not completed yet.*/
+kwlError kwlEngine_waveBankIsUnloadPending(kwlEngine* engine, kwlWaveBankHandle waveBankHandle, int* isPending);
 
 /** */
 kwlWaveBankHandle kwlEngine_getHandleFromWaveBank(kwlEngine* engine, kwlWaveBank* waveBank);
 
 /** */
 kwlError kwlEngine_getNumFramesMixed(kwlEngine* engine, unsigned int* numFrames);
+
+/** Gets the total number of frames mixed since the mixer started. */
+kwlError kwlEngine_getTotalNumFramesMixed(kwlEngine* engine, long long* numFrames);
+
+/** Gets the disk read statistics of all streaming events since the engine was initialized. */
+kwlError kwlEngine_getStreamingIOStats(kwlEngine* engine, kwlStreamingIOStats* stats);
+
+/** Sets the maximum number of bytes of audio data loaded on demand to keep in memory. Zero means no limit. */
+kwlError kwlEngine_setResidencyBudget(kwlEngine* engine, int numBytes);
+
+/** Sets the maximum time an event start waits for audio data loaded on demand before starting virtually. */
+kwlError kwlEngine_setResidencyMaxStartWaitTime(kwlEngine* engine, float seconds);
+
+/** Gets the statistics of audio data loaded on demand since the engine was initialized. */
+kwlError kwlEngine_getResidencyStats(kwlEngine* engine, kwlResidencyStats* stats);
     
 /** */
 kwlError kwlEngine_getOutLevels(kwlEngine* engine, float* leftLevel, float* rightLevel);
@@ -21,6 +21,7 @@
  distribution.
  */
 
+#include <limits.h>
 #include <math.h>
 #include <string.h>
 
@@ -29,6 +30,39 @@
 #include "kwl_memory.h"
 #include "kwl_sounddefinition.h"
 
+/** The alignment of each array carved from the engine data block. */
+#define KWL_ENGINE_DATA_ALIGNMENT 16
+
+static size_t kwlEngineData_align(size_t size)
+{
+    return (size + KWL_ENGINE_DATA_ALIGNMENT - 1) & ~((size_t)KWL_ENGINE_DATA_ALIGNMENT - 1);
+}
+
+/** Returns the number of bytes needed for the wave banks and audio data entries described by a given set of counts.*/
+static size_t kwlEngineData_getWaveBankSize(const kwlEngineDataCounts* counts)
+{
+    return kwlEngineData_align(counts->numWaveBanks * sizeof(kwlWaveBank)) +
+           kwlEngineData_align(counts->numAudioDataEntries * sizeof(kwlAudioData));
+}
+
+/** 
+ * Returns the number of bytes needed for the runtime structures described by a given set of counts,
+ * except the wave banks and audio data entries.
+ */
+static size_t kwlEngineData_getRuntimeSize(const kwlEngineDataCounts* counts)
+{
+    return kwlEngineData_align(counts->numMixBuses * sizeof(kwlMixBus)) +
+           kwlEngineData_align(counts->numSubBusReferences * sizeof(kwlMixBus*)) +
+           kwlEngineData_align(counts->numMixPresets * sizeof(kwlMixPreset)) +
+           kwlEngineData_align((size_t)counts->numMixPresets * counts->numMixBuses * sizeof(kwlMixBusParameters)) +
+           kwlEngineData_align(counts->numSounds * sizeof(kwlSoundDefinition)) +
+           kwlEngineData_align(counts->numSoundAudioDataReferences * sizeof(kwlAudioData*)) +
+           kwlEngineData_align(counts->numEventDefinitions * sizeof(kwlEventDefinition)) +
+           kwlEngineData_align(counts->numEventDefinitions * sizeof(kwlEventInstance*)) +
+           kwlEngineData_align(counts->numEventInstances * sizeof(kwlEventInstance)) +
+           kwlEngineData_align(counts->numEventWaveBankReferences * sizeof(kwlWaveBank*));
+}
+
 kwlError kwlEngineData_load(kwlEngineData* data, kwlInputStream* stream)
 {
     if (data->isLoaded)
@@ -36,28 +70,143 @@ kwlError kwlEngineData_load(kwlEngineData* data, kwlInputStream* stream)
         KWL_ASSERT(0 && "TODO: free current data");
     }
     
+    /*read the header, which holds everything needed to size the engine data block*/
+    signed char header[KWL_ENGINE_DATA_BINARY_HEADER_SIZE];
+    if (kwlInputStream_read(stream, header, KWL_ENGINE_DATA_BINARY_HEADER_SIZE) != KWL_ENGINE_DATA_BINARY_HEADER_SIZE)
+    {
+        return KWL_UNKNOWN_FILE_FORMAT;
+    }
+    
     /*check file identifier*/
     int i;
     for (i = 0; i < KWL_ENGINE_DATA_BINARY_FILE_IDENTIFIER_LENGTH; i++)
     {
-        const char identifierChari = kwlInputStream_readChar(stream);
-        if (identifierChari != KWL_ENGINE_DATA_BINARY_FILE_IDENTIFIER[i])
+        if (header[i] != KWL_ENGINE_DATA_BINARY_FILE_IDENTIFIER[i])
         {
             return KWL_UNKNOWN_FILE_FORMAT;
         }
     }
     
-    /*Load chunks*/
+    kwlInputStream headerStream;
+    kwlInputStream_initWithBuffer(&headerStream,
+                                  header,
+                                  KWL_ENGINE_DATA_BINARY_FILE_IDENTIFIER_LENGTH,
+                                  KWL_ENGINE_DATA_BINARY_HEADER_SIZE - KWL_ENGINE_DATA_BINARY_FILE_IDENTIFIER_LENGTH);
+    const int version = kwlInputStream_readIntBE(&headerStream);
+    if (version != KWL_ENGINE_DATA_BINARY_VERSION)
+    {
+        return KWL_UNKNOWN_FILE_FORMAT;
+    }
+    
+    const int imageSize = kwlInputStream_readIntBE(&headerStream);
+    kwlEngineDataCounts counts;
+    counts.numMixBuses = kwlInputStream_readIntBE(&headerStream);
+    counts.numSubBusReferences = kwlInputStream_readIntBE(&headerStream);
+    counts.numMixPresets = kwlInputStream_readIntBE(&headerStream);
+    counts.numWaveBanks = kwlInputStream_readIntBE(&headerStream);
+    counts.numAudioDataEntries = kwlInputStream_readIntBE(&headerStream);
+    counts.numSounds = kwlInputStream_readIntBE(&headerStream);
+    counts.numSoundAudioDataReferences = kwlInputStream_readIntBE(&headerStream);
+    counts.numEventDefinitions = kwlInputStream_readIntBE(&headerStream);
+    counts.numEventInstances = kwlInputStream_readIntBE(&headerStream);
+    counts.numEventWaveBankReferences = kwlInputStream_readIntBE(&headerStream);
+    const int numChunks = kwlInputStream_readIntBE(&headerStream);
+    
+    const int countsAreValid = counts.numMixBuses >= 0 && counts.numSubBusReferences >= 0 &&
+                               counts.numMixPresets >= 0 && counts.numWaveBanks >= 0 &&
+                               counts.numAudioDataEntries >= 0 && counts.numSounds >= 0 &&
+                               counts.numSoundAudioDataReferences >= 0 && counts.numEventDefinitions >= 0 &&
+                               counts.numEventInstances >= 0 && counts.numEventWaveBankReferences >= 0;
+    if (!countsAreValid || numChunks <= 0 ||
+        imageSize < KWL_ENGINE_DATA_BINARY_HEADER_SIZE + numChunks * KWL_ENGINE_DATA_CHUNK_TABLE_ENTRY_SIZE)
+    {
+        return KWL_CORRUPT_BINARY_DATA;
+    }
+    
+    /*every event instance needs an event handle index.*/
+    if (counts.numEventInstances >= KWL_EVENT_HANDLE_NUM_INDICES)
+    {
+        return KWL_TOO_MANY_EVENT_INSTANCES;
+    }
+    
+    /*set up an arena with a single chunk holding the file image and the runtime structures.*/
+    const size_t runtimeSize = kwlEngineData_getRuntimeSize(&counts);
+    kwlArena_init(&data->arena, 
+                  KWL_MEMORY_CATEGORY_ENGINE_DATA, 
+                  kwlEngineData_align(imageSize) + runtimeSize);
+    kwlArena_init(&data->waveBankArena, 
+                  KWL_MEMORY_CATEGORY_ENGINE_DATA, 
+                  kwlEngineData_getWaveBankSize(&counts));
+    
+    kwlEngineDataImage image;
+    image.counts = counts;
+    image.bytes = (char*)kwlArena_alloc(&data->arena, imageSize);
+    image.size = imageSize;
+    image.numChunks = numChunks;
+    image.strings = NULL;
+    image.stringsSize = 0;
+    image.arena = &data->arena;
+    image.numRuntimeBytesLeft = runtimeSize;
+    
+    /*read the rest of the file in one go*/
+    kwlMemcpy(image.bytes, header, KWL_ENGINE_DATA_BINARY_HEADER_SIZE);
+    const int numBytesToRead = imageSize - KWL_ENGINE_DATA_BINARY_HEADER_SIZE;
+    kwlError result = KWL_NO_ERROR;
+    if (kwlInputStream_read(stream,
+                            (signed char*)&image.bytes[KWL_ENGINE_DATA_BINARY_HEADER_SIZE],
+                            numBytesToRead) != numBytesToRead)
+    {
+        result = KWL_CORRUPT_BINARY_DATA;
+    }
     
-    kwlEngineData_loadMixBusData(data, stream);
-    kwlEngineData_loadMixPresetData(data, stream);
-    kwlEngineData_loadWaveBankData(data, stream);
+    /*look up the string table. it must end with a null terminator for 
+      any in-bounds string offset to yield a terminated string.*/
+    if (result == KWL_NO_ERROR)
+    {
+        kwlInputStream stringStream;
+        result = kwlEngineDataImage_openChunk(&image, KWL_STRINGS_CHUNK_ID, &stringStream);
+        if (result == KWL_NO_ERROR)
+        {
+            image.strings = &image.bytes[stringStream.offset];
+            image.stringsSize = stringStream.size;
+            if (image.strings[image.stringsSize - 1] != '\0')
+            {
+                result = KWL_CORRUPT_BINARY_DATA;
+            }
+        }
+    }
+    
+    /*Load chunks*/
+    if (result == KWL_NO_ERROR)
+    {
+        result = kwlEngineData_loadMixBusData(data, &image);
+    }
+    if (result == KWL_NO_ERROR)
+    {
+        result = kwlEngineData_loadMixPresetData(data, &image);
+    }
+    if (result == KWL_NO_ERROR)
+    {
+        result = kwlEngineData_loadWaveBankData(data, &image);
+    }
     
     /*must happen after wave bank loading*/
-    kwlEngineData_loadSoundData(data, stream);
+    if (result == KWL_NO_ERROR)
+    {
+        result = kwlEngineData_loadSoundData(data, &image);
+    }
     
     /*must happen after sound, wave bank and mix bus loading.*/
-    kwlEngineData_loadEventData(data, stream);
+    if (result == KWL_NO_ERROR)
+    {
+        result = kwlEngineData_loadEventData(data, &image);
+    }
+    
+    if (result != KWL_NO_ERROR)
+    {
+        kwlEngineData_unload(data);
+        return result;
+    }
     
     data->isLoaded = 1;
     
@@ -73,38 +222,259 @@ void kwlEngineData_unload(kwlEngineData* data)
         kwlWaveBank_unload(&data->waveBanks[i]);
     }
     
-    /* Free non-audio data*/
-    kwlEngineData_freeEventData(data);
-    kwlEngineData_freeSoundData(data);
-    kwlEngineData_freeMixPresetData(data);
-    kwlEngineData_freeMixBusData(data);
-    kwlEngineData_freeWaveBankData(data);
+    /* Free non-audio data, which all lives in the engine data arenas*/
+    kwlArena_free(&data->arena);
+    kwlArena_free(&data->waveBankArena);
+    
+    data->numMixBuses = 0;
+    data->mixBuses = NULL;
+    data->masterBus = NULL;
+    data->numMixPresets = 0;
+    data->mixPresets = NULL;
+    data->numWaveBanks = 0;
+    data->waveBanks = NULL;
+    data->totalNumAudioDataEntries = 0;
+    data->audioDataEntries = NULL;
+    data->numSoundDefinitions = 0;
+    data->sounds = NULL;
+    data->numEventDefinitions = 0;
+    data->eventDefinitions = NULL;
+    data->events = NULL;
+    data->numEventInstances = 0;
+    data->eventInstances = NULL;
     
     data->isLoaded = 0;
 }
 
-kwlError kwlEngineData_loadMixBusData(kwlEngineData* data, kwlInputStream* stream)
+kwlError kwlEngineData_adoptWaveBanks(kwlEngineData* data, kwlEngineData* previousData)
 {
-    kwlInputStream_seekToEngineDataChunk(stream, KWL_MIX_BUSES_CHUNK_ID);
+    /*check that the wave banks and audio data entries are the same, in the same order.*/
+    int layoutMatches = data->numWaveBanks == previousData->numWaveBanks &&
+                        data->totalNumAudioDataEntries == previousData->totalNumAudioDataEntries;
+    int i;
+    for (i = 0; i < data->numWaveBanks && layoutMatches != 0; i++)
+    {
+        layoutMatches = strcmp(data->waveBanks[i].id, previousData->waveBanks[i].id) == 0 &&
+                        data->waveBanks[i].numAudioDataEntries == previousData->waveBanks[i].numAudioDataEntries;
+    }
+    for (i = 0; i < data->totalNumAudioDataEntries && layoutMatches != 0; i++)
+    {
+        layoutMatches = strcmp(data->audioDataEntries[i].filePath, previousData->audioDataEntries[i].filePath) == 0;
+    }
+    
+    if (layoutMatches == 0)
+    {
+        /*the new data can only keep its own wave banks if nothing uses the previous ones.*/
+        for (i = 0; i < previousData->numWaveBanks; i++)
+        {
+            if (previousData->waveBanks[i].isLoaded != 0)
+            {
+                return KWL_WAVE_BANK_ENTRY_MISMATCH;
+            }
+        }
+        return KWL_NO_ERROR;
+    }
+    
+    /*point the references of the new data at the wave banks and audio data entries of the previous data.*/
+    for (i = 0; i < data->numSoundDefinitions; i++)
+    {
+        kwlSoundDefinition* sound = &data->sounds[i];
+        int j;
+        for (j = 0; j < sound->numAudioDataEntries; j++)
+        {
+            sound->audioDataEntries[j] = &previousData->audioDataEntries[sound->audioDataEntries[j] - data->audioDataEntries];
+        }
+    }
+    for (i = 0; i < data->numEventDefinitions; i++)
+    {
+        kwlEventDefinition* definition = &data->eventDefinitions[i];
+        if (definition->streamAudioData != NULL)
+        {
+            definition->streamAudioData = &previousData->audioDataEntries[definition->streamAudioData - data->audioDataEntries];
+        }
+        int j;
+        for (j = 0; j < definition->numReferencedWaveBanks; j++)
+        {
+            definition->referencedWaveBanks[j] = &previousData->waveBanks[definition->referencedWaveBanks[j] - data->waveBanks];
+        }
+    }
+    
+    /*the ids and paths of the previous data live in its file image, which is freed along with it.*/
+    for (i = 0; i < data->numWaveBanks; i++)
+    {
+        previousData->waveBanks[i].id = data->waveBanks[i].id;
+    }
+    for (i = 0; i < data->totalNumAudioDataEntries; i++)
+    {
+        previousData->audioDataEntries[i].filePath = data->audioDataEntries[i].filePath;
+    }
+    
+    /*hand the wave bank arena over to the new data.*/
+    kwlArena_free(&data->waveBankArena);
+    data->waveBankArena = previousData->waveBankArena;
+    data->waveBanks = previousData->waveBanks;
+    data->audioDataEntries = previousData->audioDataEntries;
+    
+    kwlArena_init(&previousData->waveBankArena, KWL_MEMORY_CATEGORY_ENGINE_DATA, 0);
+    previousData->numWaveBanks = 0;
+    previousData->waveBanks = NULL;
+    previousData->totalNumAudioDataEntries = 0;
+    previousData->audioDataEntries = NULL;
+    
+    return KWL_NO_ERROR;
+}
+
+void kwlEngineData_copyMixSettings(kwlEngineData* data, const kwlEngineData* previousData)
+{
+    int i;
+    for (i = 0; i < data->numMixBuses; i++)
+    {
+        kwlMixBus* bus = &data->mixBuses[i];
+        int j;
+        for (j = 0; j < previousData->numMixBuses; j++)
+        {
+            const kwlMixBus* previousBus = &previousData->mixBuses[j];
+            if (strcmp(bus->id, previousBus->id) == 0)
+            {
+                bus->userGainLeft = previousBus->userGainLeft;
+                bus->userGainRight = previousBus->userGainRight;
+                bus->userPitch = previousBus->userPitch;
+                bus->dspUnit.valueEngine = previousBus->dspUnit.valueEngine;
+                break;
+            }
+        }
+    }
+    
+    /*find the presets present in both data sets. if none of them is active, keep the default preset.*/
+    int isMatchingPresetActive = 0;
+    for (i = 0; i < data->numMixPresets; i++)
+    {
+        int j;
+        for (j = 0; j < previousData->numMixPresets; j++)
+        {
+            if (strcmp(data->mixPresets[i].id, previousData->mixPresets[j].id) == 0 &&
+                (previousData->mixPresets[j].targetWeight > 0.0f || previousData->mixPresets[j].weight > 0.0f))
+            {
+                isMatchingPresetActive = 1;
+            }
+        }
+    }
+    
+    if (isMatchingPresetActive == 0)
+    {
+        return;
+    }
+    
+    for (i = 0; i < data->numMixPresets; i++)
+    {
+        kwlMixPreset* preset = &data->mixPresets[i];
+        preset->weight = 0.0f;
+        preset->targetWeight = 0.0f;
+        int j;
+        for (j = 0; j < previousData->numMixPresets; j++)
+        {
+            if (strcmp(preset->id, previousData->mixPresets[j].id) == 0)
+            {
+                preset->weight = previousData->mixPresets[j].weight;
+                preset->targetWeight = previousData->mixPresets[j].targetWeight;
+                break;
+            }
+        }
+    }
+}
+
+kwlError kwlEngineDataImage_openChunk(kwlEngineDataImage* image, int chunkId, kwlInputStream* chunkStream)
+{
+    kwlInputStream tableStream;
+    kwlInputStream_initWithBuffer(&tableStream,
+                                  image->bytes,
+                                  KWL_ENGINE_DATA_BINARY_HEADER_SIZE,
+                                  image->numChunks * KWL_ENGINE_DATA_CHUNK_TABLE_ENTRY_SIZE);
+    int i;
+    for (i = 0; i < image->numChunks; i++)
+    {
+        const int currentChunkId = kwlInputStream_readIntBE(&tableStream);
+        const int chunkOffset = kwlInputStream_readIntBE(&tableStream);
+        const int chunkSize = kwlInputStream_readIntBE(&tableStream);
+        if (currentChunkId == chunkId)
+        {
+            if (chunkOffset < KWL_ENGINE_DATA_BINARY_HEADER_SIZE || chunkSize <= 0 ||
+                chunkOffset > image->size - chunkSize)
+            {
+                return KWL_CORRUPT_BINARY_DATA;
+            }
+            kwlInputStream_initWithBuffer(chunkStream, image->bytes, chunkOffset, chunkSize);
+            return KWL_NO_ERROR;
+        }
+    }
+    
+    return KWL_CORRUPT_BINARY_DATA;
+}
+
+const char* kwlEngineDataImage_readString(kwlEngineDataImage* image, kwlInputStream* stream)
+{
+    const int stringOffset = kwlInputStream_readIntBE(stream);
+    if (stringOffset < 0 || stringOffset >= image->stringsSize)
+    {
+        return NULL;
+    }
+    return &image->strings[stringOffset];
+}
+
+void* kwlEngineDataImage_allocate(kwlEngineDataImage* image, int numElements, int elementSize)
+{
+    if (numElements < 0)
+    {
+        return NULL;
+    }
+    const size_t size = kwlEngineData_align((size_t)numElements * elementSize);
+    if (size > image->numRuntimeBytesLeft)
+    {
+        return NULL;
+    }
+    image->numRuntimeBytesLeft -= size;
+    
+    void* ret = kwlArena_alloc(image->arena, size);
+    kwlMemset(ret, 0, size);
+    return ret;
+}
+
+kwlError kwlEngineData_loadMixBusData(kwlEngineData* data, kwlEngineDataImage* image)
+{
+    kwlInputStream chunkStream;
+    kwlInputStream* stream = &chunkStream;
+    kwlError result = kwlEngineDataImage_openChunk(image, KWL_MIX_BUSES_CHUNK_ID, stream);
+    if (result != KWL_NO_ERROR)
+    {
+        return result;
+    }
     KWL_ASSERT(data->mixBuses == NULL);
     
-    /*allocate memory for the mix bus data*/
+    /*carve out memory for the mix bus data*/
     const int numMixBuses = kwlInputStream_readIntBE(stream);
+    const int numSubBusReferences = image->counts.numSubBusReferences;
     KWL_ASSERT(numMixBuses > 0);
     data->numMixBuses = numMixBuses;
-    data->mixBuses =
-    (kwlMixBus*)KWL_MALLOC(numMixBuses * sizeof(kwlMixBus),
-                           "kwlEngineData_loadMixBusData: mixer bus array");
-    kwlMemset(data->mixBuses, 0, numMixBuses * sizeof(kwlMixBus));
+    data->mixBuses = (kwlMixBus*)kwlEngineDataImage_allocate(image, numMixBuses, sizeof(kwlMixBus));
+    kwlMixBus** subBuses = (kwlMixBus**)kwlEngineDataImage_allocate(image, numSubBusReferences, sizeof(kwlMixBus*));
+    if (data->mixBuses == NULL || subBuses == NULL)
+    {
+        return KWL_CORRUPT_BINARY_DATA;
+    }
     
     /*read mix bus data*/
+    int subBusIdx = 0;
     int i;
     for (i = 0; i < numMixBuses; i++)
     {
         kwlMixBus* const mixBusi = &data->mixBuses[i];
         kwlMixBus_init(mixBusi);
         
-        mixBusi->id = kwlInputStream_readASCIIString(stream);
+        mixBusi->id = (char*)kwlEngineDataImage_readString(image, stream);
+        if (mixBusi->id == NULL)
+        {
+            return KWL_CORRUPT_BINARY_DATA;
+        }
         if (strcmp(mixBusi->id, "master") == 0)
         {
             KWL_ASSERT(data->masterBus == NULL && "multiple master buses found");
@@ -114,12 +484,16 @@ kwlError kwlEngineData_loadMixBusData(kwlEngineData* data, kwlInputStream* strea
         
         const int numSubBuses = kwlInputStream_readIntBE(stream);
         KWL_ASSERT(numSubBuses >= 0);
+        if (numSubBuses < 0 || numSubBuses > numSubBusReferences - subBusIdx)
+        {
+            return KWL_CORRUPT_BINARY_DATA;
+        }
         mixBusi->numSubBuses = numSubBuses;
         mixBusi->subBuses = NULL;
         if (numSubBuses > 0)
         {
-            mixBusi->subBuses = (kwlMixBus**)KWL_MALLOC(numSubBuses * sizeof(kwlMixBus*),
-                                                        "kwlEngineData_loadMixBusData: sub buses");
+            mixBusi->subBuses = &subBuses[subBusIdx];
+            subBusIdx += numSubBuses;
             int j;
             for (j = 0; j < numSubBuses; j++)
             {
@@ -135,53 +509,45 @@ kwlError kwlEngineData_loadMixBusData(kwlEngineData* data, kwlInputStream* strea
     return KWL_NO_ERROR;
 }
 
-void kwlEngineData_freeMixBusData(kwlEngineData* data)
+kwlError kwlEngineData_loadMixPresetData(kwlEngineData* data, kwlEngineDataImage* image)
 {
-    if (data->mixBuses == NULL)
-    {
-        return;
-    }
-    
-    /*free the mix bus IDs*/
-    const int numMixBuses = data->numMixBuses;
-    int i;
-    for (i = 0; i < numMixBuses; i++)
+    kwlInputStream chunkStream;
+    kwlInputStream* stream = &chunkStream;
+    kwlError result = kwlEngineDataImage_openChunk(image, KWL_MIX_PRESETS_CHUNK_ID, stream);
+    if (result != KWL_NO_ERROR)
     {
-        if (data->mixBuses[i].subBuses != NULL)
-        {
-            KWL_FREE(data->mixBuses[i].subBuses);
-        }
-        KWL_FREE(data->mixBuses[i].id);
+        return result;
     }
-    
-    /*free the mix bus array*/
-    KWL_FREE(data->mixBuses);
-    data->mixBuses = NULL;
-    data->masterBus = NULL;
-    data->mixBuses = NULL;;
-    data->numMixBuses = 0;;
-    data->masterBus = NULL;
-}
-
-kwlError kwlEngineData_loadMixPresetData(kwlEngineData* data, kwlInputStream* stream)
-{
-    kwlInputStream_seekToEngineDataChunk(stream, KWL_MIX_PRESETS_CHUNK_ID);
     KWL_ASSERT(data->mixBuses != 0); /*needed for mix bus lookup per param set*/
     
-    /*allocate memory for the mix preset data*/
+    /*carve out memory for the mix preset data*/
     const int numMixPresets = kwlInputStream_readIntBE(stream);
     KWL_ASSERT(numMixPresets > 0);
     data->numMixPresets = numMixPresets;
     const int numParameterSets = data->numMixBuses;
     int defaultPresetIndex = -1;
-    data->mixPresets = (kwlMixPreset*)KWL_MALLOC(sizeof(kwlMixPreset) * numMixPresets,
-                                                 "kwlEngineData_loadMixPresetData");
+    data->mixPresets = (kwlMixPreset*)kwlEngineDataImage_allocate(image, numMixPresets, sizeof(kwlMixPreset));
+    kwlMixBusParameters* parameterSets = NULL;
+    if (data->mixPresets != NULL && numParameterSets > 0 && numMixPresets <= INT_MAX / numParameterSets)
+    {
+        parameterSets = (kwlMixBusParameters*)kwlEngineDataImage_allocate(image,
+                                                                          numMixPresets * numParameterSets,
+                                                                          sizeof(kwlMixBusParameters));
+    }
+    if (parameterSets == NULL)
+    {
+        return KWL_CORRUPT_BINARY_DATA;
+    }
     
     /*read data*/
     int i;
     for (i = 0; i < numMixPresets; i++)
     {
-        data->mixPresets[i].id = kwlInputStream_readASCIIString(stream);
+        data->mixPresets[i].id = (char*)kwlEngineDataImage_readString(image, stream);
+        if (data->mixPresets[i].id == NULL)
+        {
+            return KWL_CORRUPT_BINARY_DATA;
+        }
         const int isDefault = kwlInputStream_readIntBE(stream);
         if (isDefault != 0)
         {
@@ -197,9 +563,7 @@ kwlError kwlEngineData_loadMixPresetData(kwlEngineData* data, kwlInputStream* st
         }
         
         data->mixPresets[i].numParameterSets = numParameterSets;
-        data->mixPresets[i].parameterSets =
-        (kwlMixBusParameters*)KWL_MALLOC(sizeof(kwlMixBusParameters) * numParameterSets,
-                                         "kwlEngineData_loadMixPresetData");
+        data->mixPresets[i].parameterSets = &parameterSets[i * numParameterSets];
         int j;
         for (j = 0; j < numParameterSets; j++)
         {
@@ -216,61 +580,67 @@ kwlError kwlEngineData_loadMixPresetData(kwlEngineData* data, kwlInputStream* st
     return KWL_NO_ERROR;
 }
 
-void kwlEngineData_freeMixPresetData(kwlEngineData* data)
+kwlError kwlEngineData_loadWaveBankData(kwlEngineData* data, kwlEngineDataImage* image)
 {
-    if (data->mixPresets == NULL)
-    {
-        return;
-    }
-    
-    const int numMixPresets = data->numMixPresets;
-    
-    /*free any memory allocated per mix preset*/
-    int i;
-    for (i = 0; i < numMixPresets; i++)
+    kwlInputStream chunkStream;
+    kwlInputStream* stream = &chunkStream;
+    kwlError result = kwlEngineDataImage_openChunk(image, KWL_WAVE_BANKS_CHUNK_ID, stream);
+    if (result != KWL_NO_ERROR)
     {
-        KWL_FREE(data->mixPresets[i].id);
-        KWL_FREE(data->mixPresets[i].parameterSets);
+        return result;
     }
     
-    /*free the mix preset array*/
-    KWL_FREE(data->mixPresets);
-    data->mixPresets = NULL;
-    data->numMixPresets = 0;
-}
-
-kwlError kwlEngineData_loadWaveBankData(kwlEngineData* data, kwlInputStream* stream)
-{
-    kwlInputStream_seekToEngineDataChunk(stream, KWL_WAVE_BANKS_CHUNK_ID);
-    
     /*deserialize wave bank structures*/
     const int totalnumAudioDataEntries = kwlInputStream_readIntBE(stream);
     KWL_ASSERT(totalnumAudioDataEntries > 0);
     const int numWaveBanks = kwlInputStream_readIntBE(stream);
     KWL_ASSERT(numWaveBanks > 0);
+    if (totalnumAudioDataEntries < 0 || totalnumAudioDataEntries > image->counts.numAudioDataEntries ||
+        numWaveBanks < 0 || numWaveBanks > image->counts.numWaveBanks)
+    {
+        return KWL_CORRUPT_BINARY_DATA;
+    }
     
+    /*the wave banks and audio data entries live in an arena of their own, sized from the header counts.*/
+    const size_t audioDataEntriesSize = kwlEngineData_align(totalnumAudioDataEntries * sizeof(kwlAudioData));
     data->totalNumAudioDataEntries = totalnumAudioDataEntries;
-    data->audioDataEntries = (kwlAudioData*)KWL_MALLOC(totalnumAudioDataEntries * sizeof(kwlAudioData), "kwlEngineData_loadWaveBankData");
-    kwlMemset(data->audioDataEntries, 0, totalnumAudioDataEntries * sizeof(kwlAudioData));
+    data->audioDataEntries = (kwlAudioData*)kwlArena_alloc(&data->waveBankArena, audioDataEntriesSize);
     
+    const size_t waveBanksSize = kwlEngineData_align(numWaveBanks * sizeof(kwlWaveBank));
     data->numWaveBanks = numWaveBanks;
-    data->waveBanks = (kwlWaveBank*)KWL_MALLOC(numWaveBanks * sizeof(kwlWaveBank), "kwlEngineData_loadWaveBankData");
-    kwlMemset(data->waveBanks, 0, numWaveBanks * sizeof(kwlWaveBank));
+    data->waveBanks = (kwlWaveBank*)kwlArena_alloc(&data->waveBankArena, waveBanksSize);
+    if (data->audioDataEntries == NULL || data->waveBanks == NULL)
+    {
+        data->numWaveBanks = 0;
+        return KWL_CORRUPT_BINARY_DATA;
+    }
+    kwlMemset(data->audioDataEntries, 0, audioDataEntriesSize);
+    kwlMemset(data->waveBanks, 0, waveBanksSize);
     
     int i;
     int audioDataItemIdx = 0;
     for (i = 0; i < numWaveBanks; i++)
     {
         kwlWaveBank* waveBanki = &data->waveBanks[i];
-        waveBanki->id = kwlInputStream_readASCIIString(stream);
+        waveBanki->id = kwlEngineDataImage_readString(image, stream);
         const int numAudioDataEntries = kwlInputStream_readIntBE(stream);
         KWL_ASSERT(numAudioDataEntries > 0);
+        if (waveBanki->id == NULL ||
+            numAudioDataEntries < 0 ||
+            numAudioDataEntries > totalnumAudioDataEntries - audioDataItemIdx)
+        {
+            return KWL_CORRUPT_BINARY_DATA;
+        }
         waveBanki->numAudioDataEntries = numAudioDataEntries;
         waveBanki->audioDataItems = &data->audioDataEntries[audioDataItemIdx];
         int j;
         for (j = 0; j < numAudioDataEntries; j++)
         {
-            data->audioDataEntries[audioDataItemIdx].filePath = kwlInputStream_readASCIIString(stream);
+            data->audioDataEntries[audioDataItemIdx].filePath = kwlEngineDataImage_readString(image, stream);
+            if (data->audioDataEntries[audioDataItemIdx].filePath == NULL)
+            {
+                return KWL_CORRUPT_BINARY_DATA;
+            }
             data->audioDataEntries[audioDataItemIdx].waveBank = waveBanki;
             audioDataItemIdx++;
         }
@@ -279,45 +649,31 @@ kwlError kwlEngineData_loadWaveBankData(kwlEngineData* data, kwlInputStream* str
     return KWL_NO_ERROR;
 }
 
-void kwlEngineData_freeWaveBankData(kwlEngineData* data)
+kwlError kwlEngineData_loadSoundData(kwlEngineData* data, kwlEngineDataImage* image)
 {
-    if (data->waveBanks != NULL)
+    kwlInputStream chunkStream;
+    kwlInputStream* stream = &chunkStream;
+    kwlError result = kwlEngineDataImage_openChunk(image, KWL_SOUNDS_CHUNK_ID, stream);
+    if (result != KWL_NO_ERROR)
     {
-        const int numWaveBanks = data->numWaveBanks;
-        int i;
-        for (i = 0; i < numWaveBanks; i++)
-        {
-            KWL_FREE((void*)data->waveBanks[i].id);
-        }
-        KWL_FREE(data->waveBanks);
-        data->waveBanks = NULL;
+        return result;
     }
     
-    if (data->audioDataEntries != NULL)
-    {
-        const int numAudioDataEntries = data->totalNumAudioDataEntries;
-        int i;
-        for (i = 0; i < numAudioDataEntries; i++)
-        {
-            KWL_FREE((void*)data->audioDataEntries[i].filePath);
-        }
-        KWL_FREE(data->audioDataEntries);
-        data->audioDataEntries = NULL;
-    }
-}
-
-kwlError kwlEngineData_loadSoundData(kwlEngineData* data, kwlInputStream* stream)
-{
-    kwlInputStream_seekToEngineDataChunk(stream, KWL_SOUNDS_CHUNK_ID);
-    
-    /*allocate memory for sound definitions*/
+    /*carve out memory for sound definitions*/
     const int numSoundDefinitions = kwlInputStream_readIntBE(stream);
     KWL_ASSERT(numSoundDefinitions >= 0 && "the number of sound definitions must be non-negative");
+    const int numAudioDataReferences = image->counts.numSoundAudioDataReferences;
     data->numSoundDefinitions = numSoundDefinitions;
-    data->sounds = (kwlSoundDefinition*)KWL_MALLOC(numSoundDefinitions * sizeof(kwlSoundDefinition), "sound definitions");
-    kwlMemset(data->sounds, 0, numSoundDefinitions * sizeof(kwlSoundDefinition));
+    data->sounds = (kwlSoundDefinition*)kwlEngineDataImage_allocate(image, numSoundDefinitions, sizeof(kwlSoundDefinition));
+    kwlAudioData** audioDataReferences =
+        (kwlAudioData**)kwlEngineDataImage_allocate(image, numAudioDataReferences, sizeof(kwlAudioData*));
+    if (data->sounds == NULL || audioDataReferences == NULL)
+    {
+        return KWL_CORRUPT_BINARY_DATA;
+    }
     
     /*read sound definitions*/
+    int audioDataReferenceIdx = 0;
     int i;
     for (i = 0; i < numSoundDefinitions; i++)
     {
@@ -332,9 +688,13 @@ kwlError kwlEngineData_loadSoundData(kwlEngineData* data, kwlInputStream* stream
         
         const int numWaveReferences = kwlInputStream_readIntBE(stream);
         KWL_ASSERT(numWaveReferences > 0);
-        data->sounds[i].audioDataEntries = (kwlAudioData**)KWL_MALLOC(numWaveReferences * sizeof(kwlAudioData*),
-                                                                      "kwlEngineData_loadSoundData: wave list");
+        if (numWaveReferences < 0 || numWaveReferences > numAudioDataReferences - audioDataReferenceIdx)
+        {
+            return KWL_CORRUPT_BINARY_DATA;
+        }
+        data->sounds[i].audioDataEntries = &audioDataReferences[audioDataReferenceIdx];
         data->sounds[i].numAudioDataEntries = numWaveReferences;
+        audioDataReferenceIdx += numWaveReferences;
         
         int j;
         for (j = 0; j < numWaveReferences; j++)
@@ -354,27 +714,15 @@ kwlError kwlEngineData_loadSoundData(kwlEngineData* data, kwlInputStream* stream
     return KWL_NO_ERROR;
 }
 
-void kwlEngineData_freeSoundData(kwlEngineData* data)
+kwlError kwlEngineData_loadEventData(kwlEngineData* data, kwlEngineDataImage* image)
 {
-    if (data->sounds == NULL)
-    {
-        return;
-    }
-    
-    int i;
-    for (i = 0; i < data->numSoundDefinitions; i++)
+    kwlInputStream chunkStream;
+    kwlInputStream* stream = &chunkStream;
+    kwlError result = kwlEngineDataImage_openChunk(image, KWL_EVENTS_CHUNK_ID, stream);
+    if (result != KWL_NO_ERROR)
     {
-        KWL_FREE(data->sounds[i].audioDataEntries);
+        return result;
     }
-    KWL_FREE(data->sounds);
-    data->sounds = NULL;
-    data->numSoundDefinitions = 0;
-    
-}
-
-kwlError kwlEngineData_loadEventData(kwlEngineData* data, kwlInputStream* stream)
-{
-    kwlInputStream_seekToEngineDataChunk(stream, KWL_EVENTS_CHUNK_ID);
     KWL_ASSERT(data->sounds != NULL);
     KWL_ASSERT(data->events == NULL);
     KWL_ASSERT(data->eventDefinitions == NULL);
@@ -382,28 +730,41 @@ kwlError kwlEngineData_loadEventData(kwlEngineData* data, kwlInputStream* stream
     /*read the total number of event definitions*/
     const int numEventDefinitions = kwlInputStream_readIntBE(stream);
     KWL_ASSERT(numEventDefinitions > 0);
+    const int numEventInstances = image->counts.numEventInstances;
+    const int numWaveBankReferences = image->counts.numEventWaveBankReferences;
     data->numEventDefinitions = numEventDefinitions;
-    data->events =
-    (kwlEventInstance**)KWL_MALLOC(numEventDefinitions * sizeof(kwlEventInstance*), "kwlEngineData_loadEventData");
-    kwlMemset(data->events, 0, numEventDefinitions * sizeof(kwlEventInstance*));
+    data->events = (kwlEventInstance**)kwlEngineDataImage_allocate(image, numEventDefinitions, sizeof(kwlEventInstance*));
     data->eventDefinitions =
-    (kwlEventDefinition*)KWL_MALLOC(numEventDefinitions * sizeof(kwlEventDefinition), "kwlEngineData_loadEventData");
-    kwlMemset(data->eventDefinitions, 0, numEventDefinitions * sizeof(kwlEventDefinition));
+        (kwlEventDefinition*)kwlEngineDataImage_allocate(image, numEventDefinitions, sizeof(kwlEventDefinition));
+    kwlEventInstance* instances =
+        (kwlEventInstance*)kwlEngineDataImage_allocate(image, numEventInstances, sizeof(kwlEventInstance));
+    kwlWaveBank** waveBankReferences =
+        (kwlWaveBank**)kwlEngineDataImage_allocate(image, numWaveBankReferences, sizeof(kwlWaveBank*));
+    if (data->events == NULL || data->eventDefinitions == NULL ||
+        instances == NULL || waveBankReferences == NULL)
+    {
+        data->numEventDefinitions = 0;
+        return KWL_CORRUPT_BINARY_DATA;
+    }
     
+    int instanceIdx = 0;
+    int waveBankReferenceIdx = 0;
     for (int i = 0; i < numEventDefinitions; i++)
     {
         kwlEventDefinition* definitioni = &data->eventDefinitions[i];
         /*read the id of this event definition*/
-        definitioni->id = kwlInputStream_readASCIIString(stream);
+        definitioni->id = (char*)kwlEngineDataImage_readString(image, stream);
         
         const int instanceCount = kwlInputStream_readIntBE(stream);
         KWL_ASSERT(instanceCount >= -1);
         definitioni->instanceCount = instanceCount;
         const int numInstancesToAllocate = instanceCount < 1 ? 1 : instanceCount;
-        data->events[i] =
-            (kwlEventInstance*)KWL_MALLOC(numInstancesToAllocate * sizeof(kwlEventInstance),
-                                          "kwlEngineData_loadEventData");
-        kwlMemset(data->events[i], 0, numInstancesToAllocate * sizeof(kwlEventInstance));
+        if (definitioni->id == NULL || numInstancesToAllocate > numEventInstances - instanceIdx)
+        {
+            return KWL_CORRUPT_BINARY_DATA;
+        }
+        data->events[i] = &instances[instanceIdx];
+        instanceIdx += numInstancesToAllocate;
         
         definitioni->gain = kwlInputStream_readFloatBE(stream);
         definitioni->pitch = kwlInputStream_readFloatBE(stream);
@@ -463,8 +824,13 @@ kwlError kwlEngineData_loadEventData(kwlEngineData* data, kwlInputStream* stream
         /*read referenced wave banks*/
         definitioni->numReferencedWaveBanks = kwlInputStream_readIntBE(stream);
         KWL_ASSERT(definitioni->numReferencedWaveBanks < 10000 && definitioni->numReferencedWaveBanks >= 0);
-        definitioni->referencedWaveBanks =
-        (kwlWaveBank**)KWL_MALLOC(definitioni->numReferencedWaveBanks * sizeof(kwlWaveBank*), "wave bank refs");
+        if (definitioni->numReferencedWaveBanks < 0 ||
+            definitioni->numReferencedWaveBanks > numWaveBankReferences - waveBankReferenceIdx)
+        {
+            return KWL_CORRUPT_BINARY_DATA;
+        }
+        definitioni->referencedWaveBanks = &waveBankReferences[waveBankReferenceIdx];
+        waveBankReferenceIdx += definitioni->numReferencedWaveBanks;
         int j;
         for (j = 0; j < definitioni->numReferencedWaveBanks; j++)
         {
@@ -480,32 +846,9 @@ kwlError kwlEngineData_loadEventData(kwlEngineData* data, kwlInputStream* stream
         }
     }
     
-    return KWL_NO_ERROR;
+    data->eventInstances = instances;
+    data->numEventInstances = instanceIdx;
     
-}
-
-void kwlEngineData_freeEventData(kwlEngineData* data)
-{
-    if (data->events == NULL &&
-        data->eventDefinitions == NULL)
-    {
-        return;
-    }
-    
-    const int numEventDefinitions = data->numEventDefinitions;
-    
-    int i;
-    for (i = 0; i < numEventDefinitions; i++)
-    {
-        kwlEventDefinition* defi = &data->eventDefinitions[i];
-        KWL_FREE(data->events[i]);
-        KWL_FREE(defi->referencedWaveBanks);
-        KWL_FREE(defi->id);
-    }
+    return KWL_NO_ERROR;
     
-    KWL_FREE(data->events);
-    data->events = NULL;
-    KWL_FREE(data->eventDefinitions);
-    data->eventDefinitions = NULL;
-    data->numEventDefinitions = 0;
 }
@@ -26,6 +26,7 @@
 
 /*! \file */ 
 
+#include "kwl_arena.h"
 #include "kwl_audiodata.h"
 #include "kwl_mixbus.h"
 #include "kwl_mixpreset.h"
@@ -55,6 +56,25 @@ struct kwlWaveBank;
 /** The ID of the wave bank data chunk in an engine data binary file. */
 #define KWL_WAVE_BANKS_CHUNK_ID 0x736b6277
     
+/** The ID of the string table chunk in an engine data binary file. */
+#define KWL_STRINGS_CHUNK_ID 0x73727473
+    
+/** The version of the engine data binary layout, stored right after the file identifier. */
+#define KWL_ENGINE_DATA_BINARY_VERSION 2
+    
+/** The number of element counts stored in the engine data binary header. */
+#define KWL_ENGINE_DATA_NUM_ELEMENT_COUNTS 10
+    
+/** 
+ * The size in bytes of the engine data binary header, ie the file identifier followed by
+ * the version, the file size, the element counts and the number of chunks.
+ * The header is followed by the chunk table.
+ */
+#define KWL_ENGINE_DATA_BINARY_HEADER_SIZE (KWL_ENGINE_DATA_BINARY_FILE_IDENTIFIER_LENGTH + 4 * (3 + KWL_ENGINE_DATA_NUM_ELEMENT_COUNTS))
+    
+/** The size in bytes of an entry in the chunk table, ie the chunk ID, the chunk offset and the chunk size. */
+#define KWL_ENGINE_DATA_CHUNK_TABLE_ENTRY_SIZE 12
+    
 /** 
  * The file identifier for engine binaries, ie the sequence of bytes
  * that all engine data binary files start with.
@@ -65,6 +85,63 @@ static const char KWL_ENGINE_DATA_BINARY_FILE_IDENTIFIER[KWL_ENGINE_DATA_BINARY_
 };
     
     
+/**
+ * The number of elements of each kind in an engine data binary. These are stored in
+ * the file header so that the engine can size the single block all engine data
+ * lives in before reading the rest of the file.
+ */
+typedef struct kwlEngineDataCounts
+{
+    /** The number of mix buses. */
+    int numMixBuses;
+    /** The total number of sub bus references of all mix buses. */
+    int numSubBusReferences;
+    /** The number of mix presets. */
+    int numMixPresets;
+    /** The number of wave banks. */
+    int numWaveBanks;
+    /** The total number of audio data entries of all wave banks. */
+    int numAudioDataEntries;
+    /** The number of sound definitions. */
+    int numSounds;
+    /** The total number of audio data references of all sound definitions. */
+    int numSoundAudioDataReferences;
+    /** The number of event definitions. */
+    int numEventDefinitions;
+    /** The total number of event instances to allocate for all event definitions. */
+    int numEventInstances;
+    /** The total number of wave bank references of all event definitions. */
+    int numEventWaveBankReferences;
+} kwlEngineDataCounts;
+    
+/**
+ * An engine data binary file image, read into the arena that all loaded
+ * engine data lives in. The runtime structures are carved from the same
+ * arena and strings point into the image.
+ */
+typedef struct kwlEngineDataImage
+{
+    /** The element counts from the file header. */
+    kwlEngineDataCounts counts;
+    /** The file contents. Chunk offsets are relative to the start of this buffer. */
+    char* bytes;
+    /** The size of the file in bytes. */
+    int size;
+    /** The number of entries in the chunk table. */
+    int numChunks;
+    /** The null terminated strings referenced by offset from the other chunks. */
+    const char* strings;
+    /** The size of the string table in bytes. */
+    int stringsSize;
+    /** The arena to carve runtime structures from. */
+    kwlArena* arena;
+    /** 
+     * The number of bytes of runtime structures left to carve, as sized from the header
+     * counts. Guards against chunks that do not match the counts.
+     */
+    size_t numRuntimeBytesLeft;
+} kwlEngineDataImage;
+    
 /**
  * A struct containing engine data loaded from a binary file.
  */
@@ -101,49 +178,104 @@ typedef struct kwlEngineData
     struct kwlEventDefinition* eventDefinitions;
     /** An array of arrays of event instances read from data. Instance i of event definition j is at [j][i]. */
     struct kwlEventInstance** events;
+    /** The total number of event instances of all event definitions.*/
+    int numEventInstances;
+    /** 
+     * All event instances of all event definitions, in definition order. The arrays in
+     * \c events point into this array. Event handles store indices into it.
+     */
+    struct kwlEventInstance* eventInstances;
     
     /** The number of sound definitions currently loaded from engine data.*/
     int numSoundDefinitions;
     /** An array of sound definitions. */
     struct kwlSoundDefinition* sounds;
     
+    /** 
+     * The arena holding all of the above arrays except the wave banks and audio data entries, 
+     * along with the engine data file image, in a single chunk. Freed in one go when the 
+     * engine data is unloaded.
+     */
+    kwlArena arena;
+    /** 
+     * The arena holding the wave banks and audio data entries. Kept separate from \c arena
+     * so that engine data replacing this data can take over the wave banks as they are.
+     */
+    kwlArena waveBankArena;
+    
 } kwlEngineData;
 
-/** */
+/**
+ * Loads engine data from a given stream. The header is read first, then the
+ * rest of the file is read with a single read into the single chunk of an arena
+ * that also holds all runtime structures.
+ * @param data The engine data to load into.
+ * @param stream The stream to read from.
+ * @return \c KWL_UNKNOWN_FILE_FORMAT if the stream does not contain an engine data binary
+ * of the current version, \c KWL_CORRUPT_BINARY_DATA if the data is inconsistent and
+ * \c KWL_NO_ERROR otherwise.
+ */
 kwlError kwlEngineData_load(kwlEngineData* data, kwlInputStream* stream);
 
-/** */
+/** Unloads any loaded wave banks and frees the arena holding the engine data. */
 void kwlEngineData_unload(kwlEngineData* data);
-    
-/** */
-kwlError kwlEngineData_loadMixBusData(kwlEngineData* data, kwlInputStream* stream);
 
-/** */
-void kwlEngineData_freeMixBusData(kwlEngineData* data);
-
-/** */
-kwlError kwlEngineData_loadMixPresetData(kwlEngineData* data, kwlInputStream* stream);
+/**
+ * Lets newly loaded engine data take over the wave banks and audio data entries of the 
+ * engine data it replaces, so that loaded audio data and any references to it held by
+ * playing events, decoders and the residency stay valid. The wave banks of the previous 
+ * data are detached from it and are not unloaded when it is.
+ * @param data The newly loaded engine data.
+ * @param previousData The engine data to replace.
+ * @return \c KWL_WAVE_BANK_ENTRY_MISMATCH if the wave banks and audio data entries of the
+ * two data sets differ while a wave bank of the previous data is loaded, \c KWL_NO_ERROR 
+ * otherwise. If the wave banks differ but none is loaded, the new data keeps its own.
+ */
+kwlError kwlEngineData_adoptWaveBanks(kwlEngineData* data, kwlEngineData* previousData);
 
-/** */
-void kwlEngineData_freeMixPresetData(kwlEngineData* data);
+/**
+ * Copies the user gain, user pitch and DSP unit of each mix bus and the weights of each mix preset 
+ * from the engine data it replaces, matching buses and presets by ID. If none of the matching presets
+ * is active, the default preset of the new data stays active.
+ * @param data The newly loaded engine data.
+ * @param previousData The engine data to replace.
+ */
+void kwlEngineData_copyMixSettings(kwlEngineData* data, const kwlEngineData* previousData);
+    
+/**
+ * Initializes a buffer backed stream reading a given chunk of an engine data image.
+ * @return \c KWL_CORRUPT_BINARY_DATA if there is no such chunk or if the chunk
+ * does not fit in the image, \c KWL_NO_ERROR otherwise.
+ */
+kwlError kwlEngineDataImage_openChunk(kwlEngineDataImage* image, int chunkId, kwlInputStream* chunkStream);
 
-/** */
-kwlError kwlEngineData_loadWaveBankData(kwlEngineData* data, kwlInputStream* stream);
+/**
+ * Reads a string table offset from a given stream and returns the corresponding
+ * string in the image, or NULL if the offset is out of bounds.
+ */
+const char* kwlEngineDataImage_readString(kwlEngineDataImage* image, kwlInputStream* stream);
 
+/**
+ * Carves an array with a given number of elements from the part of the engine data block
+ * reserved for runtime structures.
+ * @return A pointer to the array or NULL if the reserved space is exhausted.
+ */
+void* kwlEngineDataImage_allocate(kwlEngineDataImage* image, int numElements, int elementSize);
+    
 /** */
-void kwlEngineData_freeWaveBankData(kwlEngineData* data);
+kwlError kwlEngineData_loadMixBusData(kwlEngineData* data, kwlEngineDataImage* image);
 
 /** */
-kwlError kwlEngineData_loadSoundData(kwlEngineData* data, kwlInputStream* stream);
+kwlError kwlEngineData_loadMixPresetData(kwlEngineData* data, kwlEngineDataImage* image);
 
 /** */
-void kwlEngineData_freeSoundData(kwlEngineData* data);
+kwlError kwlEngineData_loadWaveBankData(kwlEngineData* data, kwlEngineDataImage* image);
 
 /** */
-kwlError kwlEngineData_loadEventData(kwlEngineData* data, kwlInputStream* stream);
+kwlError kwlEngineData_loadSoundData(kwlEngineData* data, kwlEngineDataImage* image);
 
 /** */
-void kwlEngineData_freeEventData(kwlEngineData* data);
+kwlError kwlEngineData_loadEventData(kwlEngineData* data, kwlEngineDataImage* image);
 
 
 #ifdef __cplusplus
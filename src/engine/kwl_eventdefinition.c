@@ -27,3 +27,24 @@ void kwlEventDefinition_init(kwlEventDefinition* eventDefinition)
 {
     kwlMemset(eventDefinition, 0, sizeof(kwlEventDefinition));
 }
+
+void kwlEventDefinition_getAudioData(kwlEventDefinition* eventDefinition,
+                                     kwlAudioData*** audioData,
+                                     int* numAudioData)
+{
+    if (eventDefinition->streamAudioData != NULL)
+    {
+        *audioData = &eventDefinition->streamAudioData;
+        *numAudioData = 1;
+    }
+    else if (eventDefinition->sound != NULL)
+    {
+        *audioData = eventDefinition->sound->audioDataEntries;
+        *numAudioData = eventDefinition->sound->numAudioDataEntries;
+    }
+    else
+    {
+        *audioData = NULL;
+        *numAudioData = 0;
+    }
+}
@@ -102,6 +102,15 @@ typedef struct kwlEventDefinition
 } kwlEventDefinition;
 
 void kwlEventDefinition_init(kwlEventDefinition* eventDefinition);
+
+/** 
+ * Gets the audio data played by the instances of a given event definition: the stream
+ * audio data of streaming events or the audio data entries of the sound otherwise.
+ */
+void kwlEventDefinition_getAudioData(kwlEventDefinition* eventDefinition,
+                                     kwlAudioData*** audioData,
+                                     int* numAudioData);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */    
@@ -24,6 +24,8 @@ freely, subject to the following restrictions:
 #include "kwl_asm.h"
 #include "kwl_audiofileutil.h"
 #include "kwl_eventinstance.h"
+#include "kwl_freeformevent.h"
+#include "kwl_freeformeventpool.h"
 #include "kwl_synchronization.h"
 #include "kwl_sounddefinition.h"
 
@@ -53,6 +55,7 @@ void kwlEventInstance_init(kwlEventInstance* event)
     
     event->userGain = 1.0f;
     event->userPitch = 1.0f;    
+    event->handleSlotIndex = -1;
     event->balance = 0.0f;
     
     event->numBuffersPlayed = 0;
@@ -63,6 +66,7 @@ void kwlEventInstance_init(kwlEventInstance* event)
     event->fadeGain = 1.0f;
     event->soundPitch = 1.0f;
     event->playbackState = KWL_STOPPED;
+    event->stopDelayInFrames = -1;
 }
 
 void kwlEventInstance_start(kwlEventInstance* event)
@@ -74,99 +78,151 @@ void kwlEventInstance_start(kwlEventInstance* event)
     event->soundPitch = 1.0f;
     event->prevEffectiveGain[0] = -1.0f;
     event->prevEffectiveGain[1] = -1.0f;
+    event->startDelayInFrames = 0;
+    event->stopDelayInFrames = -1;
 }
 
-kwlError kwlEventInstance_createFreeformEventFromBuffer(kwlEventInstance** event, kwlPCMBuffer* buffer, kwlEventType type)
+void kwlEventInstance_stop(kwlEventInstance* event, float fadeGainIncrPerFrame)
 {
-    if (buffer->numFrames < 1 ||
-        buffer->numChannels < 1 || 
-        buffer->numChannels > 2 ||
-        buffer->pcmData == NULL)
+    if (event->isPaused)
     {
-        return KWL_INVALID_PARAMETER_VALUE;
+        /*Always stop paused events immediately.*/
+        event->playbackState = KWL_STOP_REQUESTED;
+    }
+    else if (fadeGainIncrPerFrame < 0.0f)
+    {
+        /*Start the fade out. The event will get removed from the mixer when
+          the fade gain reaches 0.*/
+        event->fadeGainIncrPerFrame = fadeGainIncrPerFrame;
+    }
+    else if (event->definition_mixer->sound != NULL)
+    {
+        if (event->definition_mixer->sound->playbackMode == KWL_IN_RANDOM_OUT ||
+            event->definition_mixer->sound->playbackMode == KWL_IN_RANDOM_NO_REPEAT_OUT ||
+            event->definition_mixer->sound->playbackMode == KWL_IN_SEQUENTIAL_OUT)
+        {
+            event->playbackState = KWL_PLAY_LAST_BUFFER_AND_STOP_REQUESTED;
+        }
+        else
+        {
+            event->playbackState = KWL_STOP_REQUESTED;
+        }
+    }
+    else
+    {
+        event->playbackState = KWL_STOP_REQUESTED;
     }
+}
+
+void kwlEventInstance_copyEngineState(kwlEventInstance* event, kwlEventInstance* source)
+{
+    event->gainLeft.valueEngine = source->gainLeft.valueEngine;
+    event->gainLeft.valueShared = source->gainLeft.valueShared;
+    event->gainRight.valueEngine = source->gainRight.valueEngine;
+    event->gainRight.valueShared = source->gainRight.valueShared;
+    event->pitch.valueEngine = source->pitch.valueEngine;
+    event->pitch.valueShared = source->pitch.valueShared;
+    event->dspUnit.valueEngine = source->dspUnit.valueEngine;
+    event->dspUnit.valueShared = source->dspUnit.valueShared;
     
-    kwlAudioData* audioData = (kwlAudioData*)KWL_MALLOC(sizeof(kwlAudioData), 
-                                                        "freeform event audio data struct");
-    kwlMemset(audioData, 0, sizeof(kwlAudioData));
+    /*the mixer keeps reading the decoder of the source until it switches over.*/
+    event->decoder = source->decoder;
     
-    audioData->numChannels = buffer->numChannels;
-    audioData->numFrames = buffer->numFrames;
-    audioData->numBytes = buffer->numFrames * buffer->numChannels * 2;/*2 bytes per 16 bit sample*/
-    audioData->bytes = buffer->pcmData;
-    audioData->encoding = KWL_ENCODING_SIGNED_16BIT_PCM;
+    event->positionX = source->positionX;
+    event->positionY = source->positionY;
+    event->positionZ = source->positionZ;
+    event->velocityX = source->velocityX;
+    event->velocityY = source->velocityY;
+    event->velocityZ = source->velocityZ;
+    event->directionX = source->directionX;
+    event->directionY = source->directionY;
+    event->directionZ = source->directionZ;
+    event->userGain = source->userGain;
+    event->userPitch = source->userPitch;
+    event->balance = source->balance;
+    
+    event->isAssociatedWithHandle = source->isAssociatedWithHandle;
+    event->handleSlotIndex = source->handleSlotIndex;
+    event->isPlaying = source->isPlaying;
+    event->isVirtual = source->isVirtual;
+    event->virtualFadeInTimeSec = source->virtualFadeInTimeSec;
+    event->virtualStartFrame = source->virtualStartFrame;
     
-    /*The id "freeform buffer event" is used later to indicate that the sample data should not be released.
-      This should really be handled in a better way.*/
-    return kwlEventInstance_createFreeformEventFromAudioData(event, audioData, type, "freeform buffer event");
+    event->retainedAudioBuffers = source->retainedAudioBuffers;
+    event->numRetainedAudioBuffers = source->numRetainedAudioBuffers;
+    source->retainedAudioBuffers = NULL;
+    source->numRetainedAudioBuffers = 0;
+    
+    event->stoppedCallback = source->stoppedCallback;
+    event->stoppedCallbackUserData = source->stoppedCallbackUserData;
 }
 
-kwlError kwlEventInstance_createFreeformEventFromFile(kwlEventInstance** event, const char* const audioFilePath, 
-                                              kwlEventType type, int streamFromDisk)
+void kwlEventInstance_copyMixerState(kwlEventInstance* event, kwlEventInstance* source)
 {
+    event->gainLeft.valueMixer = source->gainLeft.valueMixer;
+    event->gainRight.valueMixer = source->gainRight.valueMixer;
+    event->pitch.valueMixer = source->pitch.valueMixer;
+    event->dspUnit.valueMixer = source->dspUnit.valueMixer;
     
-    KWL_ASSERT(streamFromDisk == 0 && "stream flag not supported yet");
-    
-    /*try to load the audio file data*/
-    kwlAudioData* audioData = (kwlAudioData*)KWL_MALLOC(sizeof(kwlAudioData), 
-                                                        "freeform event audio data struct");
-    kwlMemset(audioData, 0, sizeof(kwlAudioData));
+    event->soundPitch = source->soundPitch;
+    event->pitchAccumulator = source->pitchAccumulator;
+    event->isPaused = source->isPaused;
+    event->playbackState = source->playbackState;
     
-    kwlError error = kwlLoadAudioFile(audioFilePath, audioData, KWL_CONVERT_TO_INT16_OR_FAIL);
-    if (error != KWL_NO_ERROR)
-    {
-        KWL_FREE(audioData);
-        return error;
-    }
+    event->currentPCMBuffer = source->currentPCMBuffer;
+    event->currentNumChannels = source->currentNumChannels;
+    event->currentSampleRate = source->currentSampleRate;
+    event->currentPCMBufferSize = source->currentPCMBufferSize;
+    event->currentPCMFrameIndex = source->currentPCMFrameIndex;
+    event->currentAudioDataIndex = source->currentAudioDataIndex;
+    event->numBuffersPlayed = source->numBuffersPlayed;
     
-    if (type == KWL_POSITIONAL &&
-        audioData->numChannels != 1)
+    /*the sound of the new definition may have fewer audio data entries.*/
+    kwlSoundDefinition* sound = event->definition_mixer->sound;
+    if (sound != NULL && event->currentAudioDataIndex >= sound->numAudioDataEntries)
     {
-        kwlAudioData_free(audioData);
-        KWL_FREE(audioData);
-        return KWL_POSITIONAL_EVENT_MUST_BE_MONO;
+        event->currentAudioDataIndex = 0;
     }
     
-    return kwlEventInstance_createFreeformEventFromAudioData(event, audioData, type, "freeform event");
+    event->fadeGain = source->fadeGain;
+    event->fadeGainIncrPerFrame = source->fadeGainIncrPerFrame;
+    event->prevEffectiveGain[0] = source->prevEffectiveGain[0];
+    event->prevEffectiveGain[1] = source->prevEffectiveGain[1];
+    event->startDelayInFrames = source->startDelayInFrames;
+    event->stopDelayInFrames = source->stopDelayInFrames;
+    event->scheduledStopFadeGainIncrPerFrame = source->scheduledStopFadeGainIncrPerFrame;
 }
 
-kwlError kwlEventInstance_createFreeformEventFromAudioData(kwlEventInstance** event, kwlAudioData* audioData, kwlEventType type, const char* eventId)
+/** 
+ * Sets up the instance, definition and sound of a freeform event bundle whose 
+ * audio data has been filled in. As opposed to a data driven event, a freeform 
+ * event does not reference sounds and event definitions in the engine, but owns 
+ * its local data that is recycled when the event is released.
+ */
+static void kwlEventInstance_initFreeformEvent(kwlFreeformEvent* freeformEvent, kwlEventType type, const char* eventId)
 {
-    /*create the event. as opposed to a data driven event, a freeform event does
-     not reference sounds and event definitions in the engine, but own its local data
-     that is freed when the event is released.*/
-    kwlEventInstance* createdEvent = (kwlEventInstance*)KWL_MALLOC(sizeof(kwlEventInstance), "freeform event instance");
+    kwlEventInstance* createdEvent = &freeformEvent->instance;
     kwlEventInstance_init(createdEvent);
     
-    kwlSoundDefinition* sound = NULL;
-    kwlAudioData* streamAudioData = NULL;
+    kwlAudioData* audioData = &freeformEvent->audioData;
+    KWL_ASSERT(audioData->encoding == KWL_ENCODING_SIGNED_16BIT_PCM && "TODO: support creating non-pcm events");
     
-    /*create a sound if we loaded a PCM file.*/
-    if (audioData->encoding == KWL_ENCODING_SIGNED_16BIT_PCM)
-    {
-        sound = (kwlSoundDefinition*)KWL_MALLOC(sizeof(kwlSoundDefinition), "freeform event: sound");
-        kwlSoundDefinition_init(sound);
-        sound->audioDataEntries = (kwlAudioData**)KWL_MALLOC(sizeof(kwlAudioData*), 
-                                                             "freeform event: sound audio data array list");
-        sound->audioDataEntries[0] = audioData;
-        sound->numAudioDataEntries = 1;
-        sound->playbackMode = KWL_SEQUENTIAL;
-        sound->playbackCount = 1;
-        sound->deferStop = 0;
-        sound->gain = 1.0f;
-        sound->pitch = 1.0f;
-        sound->pitchVariation = 0.0f;
-        sound->gainVariation = 0.0f;
-    }
-    else
-    {
-        KWL_ASSERT(0 && "TODO: support creating non-pcm events");
-    }
+    /*set up a sound playing the audio data once.*/
+    kwlSoundDefinition* sound = &freeformEvent->sound;
+    kwlSoundDefinition_init(sound);
+    freeformEvent->audioDataEntries[0] = audioData;
+    sound->audioDataEntries = freeformEvent->audioDataEntries;
+    sound->numAudioDataEntries = 1;
+    sound->playbackMode = KWL_SEQUENTIAL;
+    sound->playbackCount = 1;
+    sound->deferStop = 0;
+    sound->gain = 1.0f;
+    sound->pitch = 1.0f;
+    sound->pitchVariation = 0.0f;
+    sound->gainVariation = 0.0f;
     
-    /*create an event definition*/
-    kwlEventDefinition* eventDefinition = 
-    (kwlEventDefinition*)KWL_MALLOC(sizeof(kwlEventDefinition), 
-                                    "freeform event definition");
+    /*set up the event definition*/
+    kwlEventDefinition* eventDefinition = &freeformEvent->definition;
     kwlEventDefinition_init(eventDefinition);
     
     eventDefinition->id = eventId;
@@ -179,7 +235,7 @@ kwlError kwlEventInstance_createFreeformEventFromAudioData(kwlEventInstance** ev
     eventDefinition->outerConeGain = 1.0f;
     eventDefinition->retriggerMode = KWL_RETRIGGER;
     eventDefinition->stealingMode = KWL_DONT_STEAL;
-    eventDefinition->streamAudioData = streamAudioData;
+    eventDefinition->streamAudioData = NULL;
     eventDefinition->sound = sound;
     eventDefinition->numReferencedWaveBanks = 0;
     eventDefinition->referencedWaveBanks = NULL;
@@ -189,43 +245,100 @@ kwlError kwlEventInstance_createFreeformEventFromAudioData(kwlEventInstance** ev
     
     createdEvent->definition_mixer = eventDefinition;
     createdEvent->definition_engine = eventDefinition;
+}
+
+kwlError kwlEventInstance_createFreeformEventFromBuffer(kwlFreeformEventPool* pool,
+                                                        kwlEventInstance** event, 
+                                                        kwlPCMBuffer* buffer, 
+                                                        kwlEventType type)
+{
+    if (buffer->numFrames < 1 ||
+        buffer->numChannels < 1 || 
+        buffer->numChannels > 2 ||
+        buffer->pcmData == NULL)
+    {
+        return KWL_INVALID_PARAMETER_VALUE;
+    }
+    
+    kwlFreeformEvent* freeformEvent = kwlFreeformEventPool_acquire(pool);
+    if (freeformEvent == NULL)
+    {
+        return KWL_NO_FREE_EVENT_INSTANCES;
+    }
     
-    *event = createdEvent;
+    kwlAudioData* audioData = &freeformEvent->audioData;
+    kwlMemset(audioData, 0, sizeof(kwlAudioData));
+    audioData->numChannels = buffer->numChannels;
+    audioData->numFrames = buffer->numFrames;
+    audioData->numBytes = buffer->numFrames * buffer->numChannels * 2;/*2 bytes per 16 bit sample*/
+    audioData->bytes = buffer->pcmData;
+    audioData->encoding = KWL_ENCODING_SIGNED_16BIT_PCM;
+    
+    /*the sample data belongs to the caller and is not released with the event.*/
+    freeformEvent->isBufferEvent = 1;
+    kwlEventInstance_initFreeformEvent(freeformEvent, type, "freeform buffer event");
+    *event = &freeformEvent->instance;
     
     return KWL_NO_ERROR;
 }
 
-void kwlEventInstance_releaseFreeformEvent(kwlEventInstance* event)
+kwlError kwlEventInstance_createFreeformEventFromFile(kwlFreeformEventPool* pool,
+                                                      kwlEventInstance** event, 
+                                                      const char* const audioFilePath, 
+                                                      const kwlFileSystem* fileSystem, 
+                                                      kwlEventType type, 
+                                                      int streamFromDisk)
 {
-    /*Free all data associated with the freeform event.*/
-    kwlEventDefinition* eventDefinition = event->definition_engine;
-    if (eventDefinition->streamAudioData != NULL)
+    
+    KWL_ASSERT(streamFromDisk == 0 && "stream flag not supported yet");
+    
+    kwlFreeformEvent* freeformEvent = kwlFreeformEventPool_acquire(pool);
+    if (freeformEvent == NULL)
     {
-        KWL_ASSERT(0); /* double check this*/
-        kwlAudioData_free(eventDefinition->streamAudioData);
-        KWL_FREE(eventDefinition->streamAudioData);
+        return KWL_NO_FREE_EVENT_INSTANCES;
     }
-    else if (eventDefinition->sound != NULL)
+    
+    /*try to load the audio file data*/
+    kwlAudioData* audioData = &freeformEvent->audioData;
+    kwlMemset(audioData, 0, sizeof(kwlAudioData));
+    
+    kwlError error = kwlLoadAudioFile(audioFilePath, fileSystem, audioData, KWL_CONVERT_TO_INT16_OR_FAIL);
+    if (error != KWL_NO_ERROR)
     {
-        /*TODO: this check could be more robust. it will cause a memory
-         leak for freeform events created from files with the name
-         "freeform buffer event"*/
-        if (strcmp(eventDefinition->id, "freeform buffer event") == 0)
-        {
-            /*don't release audio data buffer for freeform buffer events.*/
-            eventDefinition->sound->audioDataEntries[0]->bytes = NULL;
-        }
-        /* Free loaded audio data */
-        kwlAudioData_free(eventDefinition->sound->audioDataEntries[0]);
-        /* Free allocated audio data and sound structs */
-        KWL_FREE(eventDefinition->sound->audioDataEntries[0]);
-        KWL_FREE(eventDefinition->sound->audioDataEntries);
-        KWL_FREE(eventDefinition->sound);
+        kwlFreeformEventPool_release(pool, freeformEvent);
+        return error;
+    }
+    
+    if (type == KWL_POSITIONAL &&
+        audioData->numChannels != 1)
+    {
+        kwlAudioData_free(audioData);
+        kwlFreeformEventPool_release(pool, freeformEvent);
+        return KWL_POSITIONAL_EVENT_MUST_BE_MONO;
     }
     
-    /* Finally, free the event instance and the event definition. */
-    KWL_FREE(eventDefinition);
-    KWL_FREE(event);
+    freeformEvent->isBufferEvent = 0;
+    kwlEventInstance_initFreeformEvent(freeformEvent, type, "freeform event");
+    *event = &freeformEvent->instance;
+    
+    return KWL_NO_ERROR;
+}
+
+void kwlEventInstance_releaseFreeformEvent(kwlFreeformEventPool* pool, kwlEventInstance* event)
+{
+    kwlFreeformEvent* freeformEvent = (kwlFreeformEvent*)event;
+    KWL_ASSERT(event->definition_engine == &freeformEvent->definition);
+    
+    if (freeformEvent->isBufferEvent != 0)
+    {
+        /*don't release audio data buffer for freeform buffer events.*/
+        freeformEvent->audioData.bytes = NULL;
+    }
+    /* Free loaded audio data */
+    kwlAudioData_free(&freeformEvent->audioData);
+    
+    /* Finally, hand the event, its definition and sound back to the pool. */
+    kwlFreeformEventPool_release(pool, freeformEvent);
 }
 
 
@@ -251,16 +364,18 @@ int kwlEventInstance_getNumRemainingOutFrames(kwlEventInstance* event, float pit
     }
 }
 
-int kwlEventInstance_render(kwlEventInstance* event, 
-                    float* outBuffer,
-                    const int numOutChannels,
-                    const int numFrames,
-                    const float accumulatedBusPitch)
+static int kwlEventInstance_renderFrames(kwlEventInstance* event, 
+                                         float* outBuffer,
+                                         const int numOutChannels,
+                                         const int numFrames,
+                                         const float accumulatedBusPitch,
+                                         const float outputSampleRate)
 {
     /* initial playback logic checks */
     {
         if (event->playbackState == KWL_STOP_AND_UNLOAD_REQUESTED)
         {
+            kwlClearFloatBuffer(outBuffer, numFrames * numOutChannels);
             return 1;
         }
         else if (event->playbackState == KWL_STOP_REQUESTED)
@@ -273,6 +388,7 @@ int kwlEventInstance_render(kwlEventInstance* event,
                 event->definition_mixer->sound->deferStop == 0 : 1;
             if (allowsImmediateStop != 0)
             {
+                kwlClearFloatBuffer(outBuffer, numFrames * numOutChannels);
                 return 1;
             }
         }
@@ -310,6 +426,7 @@ int kwlEventInstance_render(kwlEventInstance* event,
         {
             event->fadeGain = 0.0f;
             /** The fade out just finished, signal that the event should be stopped.*/
+            kwlClearFloatBuffer(outBuffer, numFrames * numOutChannels);
             return 1;
         }
     }
@@ -328,8 +445,11 @@ int kwlEventInstance_render(kwlEventInstance* event,
     int donePlaying = 0;
     while (!endOfOutBufferReached)
     {
+        /*audio at a sample rate other than the output sample rate is resampled by pitch shifting.*/
+        const float sampleRateRatio = event->currentSampleRate > 0 && outputSampleRate > 0.0f ? 
+                                      event->currentSampleRate / outputSampleRate : 1.0f;
         /*if the event pitch is close enough to 1, pitch shifting is not applied.*/
-        float effectivePitch = event->pitch.valueMixer * event->soundPitch * accumulatedBusPitch;
+        float effectivePitch = event->pitch.valueMixer * event->soundPitch * accumulatedBusPitch * sampleRateRatio;
         if (effectivePitch < PITCH_EPSILON)
         {
             effectivePitch = PITCH_EPSILON;
@@ -498,3 +618,82 @@ int kwlEventInstance_render(kwlEventInstance* event,
     
     return donePlaying;
 }
+
+int kwlEventInstance_render(kwlEventInstance* event, 
+                    float* outBuffer,
+                    const int numOutChannels,
+                    const int numFrames,
+                    const float accumulatedBusPitch,
+                    const float outputSampleRate)
+{
+    if (event->startDelayInFrames == 0 && event->stopDelayInFrames < 0)
+    {
+        /*The common case: nothing is scheduled within this buffer.*/
+        return kwlEventInstance_renderFrames(event, outBuffer, numOutChannels, numFrames, 
+                                            accumulatedBusPitch, outputSampleRate);
+    }
+    
+    if (event->isPaused != 0 && event->playbackState == KWL_PLAYING)
+    {
+        /*Paused events don't advance towards their scheduled start or stop.*/
+        kwlClearFloatBuffer(outBuffer, numFrames * numOutChannels);
+        return 0;
+    }
+    
+    /*Render silence up to the scheduled start frame, if any.*/
+    int startFrameIdx = 0;
+    if (event->startDelayInFrames > 0)
+    {
+        startFrameIdx = event->startDelayInFrames < numFrames ? (int)event->startDelayInFrames : numFrames;
+        event->startDelayInFrames -= startFrameIdx;
+        kwlClearFloatBuffer(outBuffer, startFrameIdx * numOutChannels);
+    }
+    
+    /*Render up to the scheduled stop frame, if any.*/
+    int stopFrameIdx = numFrames;
+    if (event->stopDelayInFrames >= 0 && event->stopDelayInFrames < numFrames)
+    {
+        stopFrameIdx = (int)event->stopDelayInFrames;
+    }
+    if (event->stopDelayInFrames >= 0)
+    {
+        event->stopDelayInFrames = event->stopDelayInFrames < numFrames ? 0 : event->stopDelayInFrames - numFrames;
+    }
+    
+    int donePlaying = 0;
+    int frameIdx = startFrameIdx;
+    if (stopFrameIdx > frameIdx)
+    {
+        donePlaying = kwlEventInstance_renderFrames(event, 
+                                                    &outBuffer[frameIdx * numOutChannels], 
+                                                    numOutChannels, 
+                                                    stopFrameIdx - frameIdx, 
+                                                    accumulatedBusPitch,
+                                                    outputSampleRate);
+        frameIdx = stopFrameIdx;
+    }
+    
+    /*Apply the scheduled stop once the stop frame has been reached and render the rest of the buffer.*/
+    if (event->stopDelayInFrames == 0 && donePlaying == 0)
+    {
+        event->stopDelayInFrames = -1;
+        kwlEventInstance_stop(event, event->scheduledStopFadeGainIncrPerFrame);
+        if (frameIdx < numFrames)
+        {
+            donePlaying = kwlEventInstance_renderFrames(event, 
+                                                        &outBuffer[frameIdx * numOutChannels], 
+                                                        numOutChannels, 
+                                                        numFrames - frameIdx, 
+                                                        accumulatedBusPitch,
+                                                        outputSampleRate);
+        }
+        frameIdx = numFrames;
+    }
+    
+    if (frameIdx < numFrames)
+    {
+        kwlClearFloatBuffer(&outBuffer[frameIdx * numOutChannels], (numFrames - frameIdx) * numOutChannels);
+    }
+    
+    return donePlaying;
+}
@@ -129,15 +129,40 @@ typedef struct kwlEventInstance
     char isPaused;
     /** Non-zero if this instance is associated with an event handle*/
     char isAssociatedWithHandle;
+    /** 
+     * The event handle slot of this data driven event instance. Only valid while 
+     * \c isAssociatedWithHandle is non-zero. Freeform events keep their slot index in
+     * \c kwlFreeformEvent instead.
+     */
+    int handleSlotIndex;
     /** The current playback state of the event. Accessed only from the mixer thread.*/
     kwlEventPlaybackState playbackState;
     /** Non-zero if the event is currently playing, zero otherwise. Accessed only from the engine thread.*/
     char isPlaying;
+    /** 
+     * Non-zero if the event was started while its audio data was being loaded on demand and has not
+     * been sent to the mixer yet. Accessed only from the engine thread.
+     */
+    char isVirtual;
+    /** The fade in time to start a virtual event with once its audio data is in memory.*/
+    float virtualFadeInTimeSec;
+    /** The frame to start a virtual event at once its audio data is in memory.*/
+    long long virtualStartFrame;
+    /** 
+     * The shared buffers of the audio data of the event, retained while the event plays in the mixer
+     * so that unloading a wave bank does not free audio data the mixer may still be reading.
+     * Accessed only from the engine thread.
+     */
+    kwlSharedAudioBuffer** retainedAudioBuffers;
+    /** The number of buffers in \c retainedAudioBuffers.*/
+    int numRetainedAudioBuffers;
         
     /** The buffer that the event is currently getting its audio from.*/
     short* currentPCMBuffer;
     /** */
     char currentNumChannels;
+    /** The sample rate of the current audio buffer in Hz. Zero means the output sample rate.*/
+    int currentSampleRate;
     /** The number of frames in the current audio buffer.*/
     int currentPCMBufferSize;
     /** The read position (ie current frame) in the current audio buffer.*/
@@ -157,6 +182,18 @@ typedef struct kwlEventInstance
     float fadeGainIncrPerFrame;
     /** Used for per buffer gain ramps.*/
     float prevEffectiveGain[2];
+    /** 
+     * The number of frames of silence to render before playback starts. Used for
+     * sample accurate scheduled starts. Only accessed from the mixer thread.
+     */
+    long long startDelayInFrames;
+    /** 
+     * The number of frames to render before a scheduled stop takes effect or a negative
+     * value if no stop is scheduled. Only accessed from the mixer thread.
+     */
+    long long stopDelayInFrames;
+    /** The fade gain increment per frame to use when a scheduled stop takes effect. */
+    float scheduledStopFadeGainIncrPerFrame;
     /** A callback to invoke when the event stops.*/
     kwlEventStoppedCallack stoppedCallback;
     /** A pointer to pass to the event stopped callback.*/
@@ -174,24 +211,56 @@ void kwlEventInstance_init(kwlEventInstance* event);
  */
 void kwlEventInstance_start(kwlEventInstance* event);
 
-/** */
-kwlError kwlEventInstance_createFreeformEventFromBuffer(kwlEventInstance** event, 
-                                                kwlPCMBuffer* buffer, 
-                                                kwlEventType type);
-/** */
-kwlError kwlEventInstance_createFreeformEventFromFile(kwlEventInstance** event, 
-                                              const char* const audioFilePath, 
-                                              kwlEventType type, 
-                                              int streamFromDisk);
-    
-/** */
-kwlError kwlEventInstance_createFreeformEventFromAudioData(kwlEventInstance** event, 
-                                                   kwlAudioData* data, 
-                                                   kwlEventType type, 
-                                                   const char* eventId);
-    
-/** */
-void kwlEventInstance_releaseFreeformEvent(kwlEventInstance* event);
+/**
+ * Requests a playing event instance to stop. Called from the mixer thread.
+ * @param event The event to stop.
+ * @param fadeGainIncrPerFrame The (negative) fade gain increment per frame to apply or 
+ * zero to stop without fading.
+ */
+void kwlEventInstance_stop(kwlEventInstance* event, float fadeGainIncrPerFrame);
+
+/**
+ * Copies the state owned by the engine thread from an event instance of engine data being 
+ * replaced to the matching instance of the new engine data. The audio buffers retained by 
+ * the source are handed over to the new instance. Called from the engine thread.
+ * @param event The instance of the new engine data.
+ * @param source The instance of the engine data being replaced.
+ */
+void kwlEventInstance_copyEngineState(kwlEventInstance* event, kwlEventInstance* source);
+
+/**
+ * Copies the playback state owned by the mixer thread from an event instance of engine data 
+ * being replaced to the matching instance of the new engine data, so that playback continues 
+ * seamlessly. Called from the mixer thread.
+ * @param event The instance of the new engine data.
+ * @param source The instance of the engine data being replaced.
+ */
+void kwlEventInstance_copyMixerState(kwlEventInstance* event, kwlEventInstance* source);
+
+/** 
+ * Creates a freeform event playing the samples of a PCM buffer owned by the caller.
+ * @param pool The pool to take the event from.
+ */
+kwlError kwlEventInstance_createFreeformEventFromBuffer(struct kwlFreeformEventPool* pool,
+                                                        kwlEventInstance** event, 
+                                                        kwlPCMBuffer* buffer, 
+                                                        kwlEventType type);
+/** 
+ * Creates a freeform event playing the contents of an audio file.
+ * @param pool The pool to take the event from.
+ */
+kwlError kwlEventInstance_createFreeformEventFromFile(struct kwlFreeformEventPool* pool,
+                                                      kwlEventInstance** event, 
+                                                      const char* const audioFilePath, 
+                                                      const kwlFileSystem* fileSystem,
+                                                      kwlEventType type, 
+                                                      int streamFromDisk);
+    
+/** 
+ * Frees any audio data loaded for a freeform event and returns the event to its pool.
+ * @param pool The pool the event was taken from.
+ */
+void kwlEventInstance_releaseFreeformEvent(struct kwlFreeformEventPool* pool, kwlEventInstance* event);
     
 /**
  * Returns the number of remaining output frames the current buffer of this event
@@ -202,13 +271,16 @@ void kwlEventInstance_releaseFreeformEvent(kwlEventInstance* event);
 int kwlEventInstance_getNumRemainingOutFrames(kwlEventInstance* event, float pitch);    
 
 /** 
- * 
+ * Renders a given number of frames of the event to a buffer, honouring any
+ * scheduled start or stop falling within the rendered frames.
+ * Returns non-zero if the event finished playing and should be removed from the mixer.
  */
 int kwlEventInstance_render(kwlEventInstance* event, 
                     float* outBuffer,
                     const int numOutChannels,
                     const int numFrames,
-                    float accumulatedBusPitch);
+                    float accumulatedBusPitch,
+                    float outputSampleRate);
 
 #ifdef __cplusplus
 }
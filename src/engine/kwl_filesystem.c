@@ -0,0 +1,141 @@
+/*
+ Copyright (c) 2010-2012 Per Gantelius
+
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any damages
+ arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it
+ freely, subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented; you must not
+ claim that you wrote the original software. If you use this software
+ in a product, an acknowledgment in the product documentation would be
+ appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such, and must not be
+ misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+#include "kwl_filesystem.h"
+#include "kwl_memory.h"
+
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <stdlib.h>
+#include <windows.h>
+#else
+#include <errno.h>
+#include <unistd.h>
+#endif /*_WIN32*/
+
+static void* kwlFileSystem_stdioOpen(void* userData, const char* path)
+{
+#ifdef _WIN32
+    /*make sure we're in binary mode to avoid nasty line ending surprises*/
+    _set_fmode(_O_BINARY);
+#endif /*_WIN32*/
+    return fopen(path, "rb");
+}
+
+/**
+ * Reads bytes at a given position of a file. The read does not use or move
+ * the position of the FILE, so a file can be read from any thread.
+ */
+static int kwlFileSystem_stdioRead(void* userData, void* file, int position, void* data, int length)
+{
+    signed char* destination = (signed char*)data;
+#ifdef _WIN32
+    HANDLE fileHandle = (HANDLE)_get_osfhandle(_fileno((FILE*)file));
+    int numBytesRead = 0;
+    while (numBytesRead < length)
+    {
+        OVERLAPPED overlapped;
+        kwlMemset(&overlapped, 0, sizeof(OVERLAPPED));
+        overlapped.Offset = (DWORD)(position + numBytesRead);
+        DWORD result = 0;
+        if (ReadFile(fileHandle, destination + numBytesRead, (DWORD)(length - numBytesRead), &result, &overlapped) == 0 ||
+            result == 0)
+        {
+            break;
+        }
+        numBytesRead += (int)result;
+    }
+    return numBytesRead;
+#else
+    const int fileDescriptor = fileno((FILE*)file);
+    int numBytesRead = 0;
+    while (numBytesRead < length)
+    {
+        const ssize_t result = pread(fileDescriptor, destination + numBytesRead, length - numBytesRead, position + numBytesRead);
+        if (result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (result <= 0)
+        {
+            break;
+        }
+        numBytesRead += (int)result;
+    }
+    return numBytesRead;
+#endif /*_WIN32*/
+}
+
+static int kwlFileSystem_stdioGetSize(void* userData, void* file)
+{
+    /*reads are positional, so nothing depends on the position of the FILE.*/
+    fseek((FILE*)file, 0, SEEK_END);
+    return (int)ftell((FILE*)file);
+}
+
+static void kwlFileSystem_stdioClose(void* userData, void* file)
+{
+    fclose((FILE*)file);
+}
+
+static const kwlFileSystem kwlFileSystem_stdio =
+{
+    kwlFileSystem_stdioOpen,
+    kwlFileSystem_stdioRead,
+    kwlFileSystem_stdioGetSize,
+    kwlFileSystem_stdioClose,
+    NULL,
+    NULL
+};
+
+const kwlFileSystem* kwlFileSystem_getDefault(void)
+{
+    return &kwlFileSystem_stdio;
+}
+
+void* kwlFileSystem_open(const kwlFileSystem* fileSystem, const char* path)
+{
+    fileSystem = fileSystem != NULL ? fileSystem : &kwlFileSystem_stdio;
+    return fileSystem->open(fileSystem->userData, path);
+}
+
+int kwlFileSystem_read(const kwlFileSystem* fileSystem, void* file, int position, void* data, int length)
+{
+    fileSystem = fileSystem != NULL ? fileSystem : &kwlFileSystem_stdio;
+    return fileSystem->read(fileSystem->userData, file, position, data, length);
+}
+
+int kwlFileSystem_getSize(const kwlFileSystem* fileSystem, void* file)
+{
+    fileSystem = fileSystem != NULL ? fileSystem : &kwlFileSystem_stdio;
+    return fileSystem->getSize(fileSystem->userData, file);
+}
+
+void kwlFileSystem_close(const kwlFileSystem* fileSystem, void* file)
+{
+    fileSystem = fileSystem != NULL ? fileSystem : &kwlFileSystem_stdio;
+    fileSystem->close(fileSystem->userData, file);
+}
@@ -0,0 +1,81 @@
+/*
+ Copyright (c) 2010-2012 Per Gantelius
+
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any damages
+ arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it
+ freely, subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented; you must not
+ claim that you wrote the original software. If you use this software
+ in a product, an acknowledgment in the product documentation would be
+ appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such, and must not be
+ misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+#ifndef KWL_FILE_SYSTEM_H
+#define KWL_FILE_SYSTEM_H
+
+/*! \file */
+
+#include "kowalski.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+/**
+ * Returns the file system reading files with the C standard library, using
+ * positional platform reads so that a file can be read from several threads at once.
+ * This is the file system of engines initialized without custom file system callbacks
+ * and of the tools.
+ */
+const kwlFileSystem* kwlFileSystem_getDefault(void);
+
+/**
+ * Opens a file through a given file system.
+ * @param fileSystem The file system. NULL for the default file system.
+ * @param path The path of the file to open.
+ * @return A handle to the opened file, or NULL if the file could not be opened.
+ */
+void* kwlFileSystem_open(const kwlFileSystem* fileSystem, const char* path);
+
+/**
+ * Reads bytes at a given position of a file opened through a given file system.
+ * @param fileSystem The file system the file was opened with. NULL for the default file system.
+ * @param file The file to read from.
+ * @param position The byte position to read from.
+ * @param data The buffer to put the read bytes in.
+ * @param length The number of bytes to read.
+ * @return The number of bytes read.
+ */
+int kwlFileSystem_read(const kwlFileSystem* fileSystem, void* file, int position, void* data, int length);
+
+/**
+ * Returns the size in bytes of a file opened through a given file system.
+ * @param fileSystem The file system the file was opened with. NULL for the default file system.
+ * @param file The file.
+ */
+int kwlFileSystem_getSize(const kwlFileSystem* fileSystem, void* file);
+
+/**
+ * Closes a file opened through a given file system.
+ * @param fileSystem The file system the file was opened with. NULL for the default file system.
+ * @param file The file to close.
+ */
+void kwlFileSystem_close(const kwlFileSystem* fileSystem, void* file);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /*KWL_FILE_SYSTEM_H*/
@@ -0,0 +1,75 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+
+#ifndef KWL_FREEFORM_EVENT_H
+#define KWL_FREEFORM_EVENT_H
+
+/*! \file */
+
+#include "kwl_audiodata.h"
+#include "kwl_eventdefinition.h"
+#include "kwl_eventinstance.h"
+#include "kwl_sounddefinition.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+/**
+ * A freeform event, i.e an event created in code, along with the definition, sound
+ * and audio data it owns. Data driven events reference data in the engine instead.
+ * Bundles are recycled through a kwlFreeformEventPool.
+ */
+typedef struct kwlFreeformEvent
+{
+    /** 
+     * The event instance. This must be the first member, so that the instance
+     * pointers handed to the rest of the engine can be cast back to the bundle.
+     */
+    kwlEventInstance instance;
+    /** The definition of the event.*/
+    kwlEventDefinition definition;
+    /** The sound played by the event.*/
+    kwlSoundDefinition sound;
+    /** The audio data played by the sound.*/
+    kwlAudioData audioData;
+    /** The audio data list of the sound, holding \c audioData.*/
+    kwlAudioData* audioDataEntries[1];
+    /** 
+     * Non-zero if the samples of the audio data are owned by the caller,
+     * as for events created from a PCM buffer.
+     */
+    int isBufferEvent;
+    /** The index of the event's slot in the engine's array of event handle slots.*/
+    int slotIndex;
+    /** The next unused bundle in the pool, if this bundle is not in use.*/
+    struct kwlFreeformEvent* nextFree;
+} kwlFreeformEvent;
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /*KWL_FREEFORM_EVENT_H*/
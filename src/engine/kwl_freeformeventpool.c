@@ -0,0 +1,101 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+
+#include "kwl_assert.h"
+#include "kwl_freeformevent.h"
+#include "kwl_freeformeventpool.h"
+
+/** Allocates a chunk of bundles and adds them to the free list.*/
+static int kwlFreeformEventPool_grow(kwlFreeformEventPool* pool, int numEvents)
+{
+    KWL_ASSERT(numEvents > 0);
+    kwlFreeformEvent* events = 
+        (kwlFreeformEvent*)kwlArena_alloc(&pool->arena, numEvents * sizeof(kwlFreeformEvent));
+    if (events == NULL)
+    {
+        return 0;
+    }
+    
+    /*link the bundles so that the first one in the chunk is handed out first*/
+    int i;
+    for (i = numEvents - 1; i >= 0; i--)
+    {
+        events[i].nextFree = pool->freeList;
+        pool->freeList = &events[i];
+    }
+    
+    pool->numEvents += numEvents;
+    pool->numFreeEvents += numEvents;
+    
+    return 1;
+}
+
+void kwlFreeformEventPool_init(kwlFreeformEventPool* pool, int numPreallocatedEvents, int numEventsPerChunk)
+{
+    KWL_ASSERT(numEventsPerChunk > 0);
+    kwlArena_init(&pool->arena, KWL_MEMORY_CATEGORY_EVENT, numEventsPerChunk * sizeof(kwlFreeformEvent));
+    pool->freeList = NULL;
+    pool->numEventsPerChunk = numEventsPerChunk;
+    pool->numEvents = 0;
+    pool->numFreeEvents = 0;
+    
+    if (numPreallocatedEvents > 0)
+    {
+        kwlFreeformEventPool_grow(pool, numPreallocatedEvents);
+    }
+}
+
+kwlFreeformEvent* kwlFreeformEventPool_acquire(kwlFreeformEventPool* pool)
+{
+    if (pool->freeList == NULL)
+    {
+        if (kwlFreeformEventPool_grow(pool, pool->numEventsPerChunk) == 0)
+        {
+            return NULL;
+        }
+    }
+    
+    kwlFreeformEvent* event = pool->freeList;
+    pool->freeList = event->nextFree;
+    event->nextFree = NULL;
+    pool->numFreeEvents--;
+    
+    return event;
+}
+
+void kwlFreeformEventPool_release(kwlFreeformEventPool* pool, kwlFreeformEvent* event)
+{
+    KWL_ASSERT(event != NULL);
+    event->nextFree = pool->freeList;
+    pool->freeList = event;
+    pool->numFreeEvents++;
+}
+
+void kwlFreeformEventPool_free(kwlFreeformEventPool* pool)
+{
+    kwlArena_free(&pool->arena);
+    pool->freeList = NULL;
+    pool->numEvents = 0;
+    pool->numFreeEvents = 0;
+}
@@ -0,0 +1,91 @@
+/*
+Copyright (c) 2010-2012 Per Gantelius
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+
+#ifndef KWL_FREEFORM_EVENT_POOL_H
+#define KWL_FREEFORM_EVENT_POOL_H
+
+/*! \file */
+
+#include "kowalski.h"
+#include "kwl_arena.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+/** The default number of freeform events preallocated when the engine is initialized.*/
+#define KWL_NUM_PREALLOCATED_FREEFORM_EVENTS 32
+
+/** The default number of freeform events allocated at a time when the pool runs out.*/
+#define KWL_FREEFORM_EVENT_POOL_CHUNK_SIZE 32
+
+struct kwlFreeformEvent;
+
+/**
+ * A pool of freeform event bundles, each holding an event instance along with the
+ * definition, sound and audio data it owns. Bundles are allocated in chunks and
+ * recycled through a free list, so creating and releasing freeform events
+ * does not allocate once the pool has grown to the number of events in use.
+ */
+typedef struct kwlFreeformEventPool
+{
+    /** The chunks the bundles are carved from.*/
+    kwlArena arena;
+    /** The first unused bundle, or NULL if all bundles are in use.*/
+    struct kwlFreeformEvent* freeList;
+    /** The number of bundles allocated when the pool grows.*/
+    int numEventsPerChunk;
+    /** The total number of bundles allocated by the pool.*/
+    int numEvents;
+    /** The number of bundles in the free list.*/
+    int numFreeEvents;
+} kwlFreeformEventPool;
+
+/** 
+ * Sets up a pool and preallocates a number of bundles.
+ * @param pool The pool to initialize.
+ * @param numPreallocatedEvents The number of bundles to allocate up front.
+ * @param numEventsPerChunk The number of bundles to allocate when the pool runs out.
+ */
+void kwlFreeformEventPool_init(kwlFreeformEventPool* pool, int numPreallocatedEvents, int numEventsPerChunk);
+
+/** 
+ * Takes an unused bundle from a pool, allocating a new chunk of bundles if needed.
+ * The contents of the returned bundle are undefined.
+ * @return The bundle, or NULL if a new chunk could not be allocated.
+ */
+struct kwlFreeformEvent* kwlFreeformEventPool_acquire(kwlFreeformEventPool* pool);
+
+/** Returns a bundle acquired from a pool to it.*/
+void kwlFreeformEventPool_release(kwlFreeformEventPool* pool, struct kwlFreeformEvent* event);
+
+/** Frees all bundles of a pool, including bundles that are in use.*/
+void kwlFreeformEventPool_free(kwlFreeformEventPool* pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /*KWL_FREEFORM_EVENT_POOL_H*/
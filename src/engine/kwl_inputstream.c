@@ -22,15 +22,10 @@ freely, subject to the following restrictions:
 */
 
 #include "kwl_assert.h"
+#include "kwl_enginedata.h"
 #include "kwl_inputstream.h"
 #include "kwl_memory.h"
 
-
-#ifdef _WIN32
-#include <stdlib.h>
-#include <fcntl.h>
-#endif
-
 void kwlInputStream_free(kwlInputStream* stream)
 {
     kwlInputStream_close(stream);
@@ -40,50 +35,50 @@ void kwlInputStream_free(kwlInputStream* stream)
 void kwlInputStream_init(kwlInputStream* stream)
 {
     stream->file = NULL;
+    stream->fileSystem = NULL;
+    stream->fileBuffer = NULL;
+    stream->fileBufferStart = 0;
+    stream->fileBufferSize = 0;
     stream->size = 0;
     stream->offset = 0;
     stream->readPos = 0;
     stream->buffer = NULL;
-}
-
-FILE* kwlInputStream_openFile(kwlInputStream* stream, const char* const path)
-{
-#ifdef _WIN32
-    /*make sure we're in binary mode to avoid nasty line ending surprises*/
-    _set_fmode(_O_BINARY);
-	return fopen(path, "rb");
-#else
-	return fopen(path, "rb");
-#endif
+    stream->readFunction = NULL;
+    stream->readFunctionData = NULL;
 }
 
 /** */
-kwlError kwlInputStream_initWithFile(kwlInputStream* const stream, const char* const path)
+kwlError kwlInputStream_initWithFile(kwlInputStream* const stream, const char* const path, const kwlFileSystem* fileSystem)
 {
     kwlInputStream_init(stream);
     
-    stream->file = kwlInputStream_openFile(stream, path);
+    stream->fileSystem = fileSystem;
+    stream->file = kwlFileSystem_open(fileSystem, path);
     if (stream->file == NULL)
     {
         return KWL_FILE_NOT_FOUND;
     }
     
-    stream->size = -1; /*negative size signals that the size is unknown*/
+    stream->size = kwlFileSystem_getSize(fileSystem, stream->file);
     stream->offset = 0;
     stream->readPos = 0;
     stream->buffer = NULL;
-    fseek(stream->file, stream->offset, SEEK_SET);
      
     return KWL_NO_ERROR;
 }
 
-kwlError kwlInputStream_initWithFileRegion(kwlInputStream* const stream, const char* const path, int offset, int size)
+kwlError kwlInputStream_initWithFileRegion(kwlInputStream* const stream,
+                                           const char* const path,
+                                           const kwlFileSystem* fileSystem,
+                                           int offset,
+                                           int size)
 {
     kwlInputStream_init(stream);
     KWL_ASSERT(size > 0);
     KWL_ASSERT(offset >= 0);
     
-    stream->file = kwlInputStream_openFile(stream, path);
+    stream->fileSystem = fileSystem;
+    stream->file = kwlFileSystem_open(fileSystem, path);
     if (stream->file == NULL)
     {
         return KWL_FILE_NOT_FOUND;
@@ -93,7 +88,6 @@ kwlError kwlInputStream_initWithFileRegion(kwlInputStream* const stream, const c
     stream->offset = offset;
     stream->readPos = offset;
     stream->buffer = NULL;
-    fseek(stream->file, stream->offset, SEEK_SET);
 
     return KWL_NO_ERROR;
 }
@@ -111,80 +105,108 @@ void kwlInputStream_initWithBuffer(kwlInputStream* const stream, void* buffer, i
     stream->file = NULL;
 }
 
-void kwlInputStream_skip(kwlInputStream* const stream, size_t size)
+void kwlInputStream_initWithReadFunction(kwlInputStream* const stream,
+                                         kwlInputStreamReadFunction readFunction,
+                                         void* readFunctionData,
+                                         int offset,
+                                         int size)
 {
-    if (stream->file != NULL && stream->buffer == NULL)
-    {
-        KWL_ASSERT(stream->file != NULL);
-        fseek(stream->file, size, SEEK_CUR);
-        stream->readPos = ftell(stream->file);
-    }
-    else if (stream->file == NULL && stream->buffer != NULL)
+    kwlInputStream_init(stream);
+    KWL_ASSERT(size > 0);
+    KWL_ASSERT(offset >= 0);
+    KWL_ASSERT(readFunction != NULL);
+    
+    stream->size = size;
+    stream->offset = offset;
+    stream->readPos = offset;
+    stream->readFunction = readFunction;
+    stream->readFunctionData = readFunctionData;
+}
+
+/**
+ * Reads a number of bytes from the file of a stream at the current read position.
+ * Small reads, like the ones made when parsing headers, are served from a buffer
+ * filled one file read at a time. Larger reads go straight to the destination.
+ */
+static int kwlInputStream_readFile(kwlInputStream* const stream, signed char* data, int length)
+{
+    int numBytesRead = 0;
+    while (numBytesRead < length)
     {
-        stream->readPos += size;
-        if (stream->readPos > stream->offset + stream->size)
+        const int position = stream->readPos + numBytesRead;
+        const int bufferIndex = position - stream->fileBufferStart;
+        if (bufferIndex >= 0 && bufferIndex < stream->fileBufferSize)
+        {
+            int numBytesToCopy = stream->fileBufferSize - bufferIndex;
+            if (numBytesToCopy > length - numBytesRead)
+            {
+                numBytesToCopy = length - numBytesRead;
+            }
+            kwlMemcpy(data + numBytesRead, stream->fileBuffer + bufferIndex, numBytesToCopy);
+            numBytesRead += numBytesToCopy;
+        }
+        else if (length - numBytesRead >= KWL_INPUT_STREAM_FILE_BUFFER_SIZE)
         {
-            stream->readPos = stream->offset + stream->size;    
+            numBytesRead += kwlFileSystem_read(stream->fileSystem,
+                                               stream->file,
+                                               position,
+                                               data + numBytesRead,
+                                               length - numBytesRead);
+            break;
+        }
+        else
+        {
+            if (stream->fileBuffer == NULL)
+            {
+                stream->fileBuffer = (signed char*)KWL_MALLOC(KWL_INPUT_STREAM_FILE_BUFFER_SIZE, KWL_MEMORY_CATEGORY_STREAMING, "input stream file buffer");
+            }
+            stream->fileBufferStart = position;
+            stream->fileBufferSize = kwlFileSystem_read(stream->fileSystem,
+                                                        stream->file,
+                                                        position,
+                                                        stream->fileBuffer,
+                                                        KWL_INPUT_STREAM_FILE_BUFFER_SIZE);
+            if (stream->fileBufferSize <= 0)
+            {
+                stream->fileBufferSize = 0;
+                break;
+            }
         }
     }
-    else 
+    return numBytesRead;
+}
+
+void kwlInputStream_skip(kwlInputStream* const stream, size_t size)
+{
+    KWL_ASSERT(stream->file != NULL || stream->buffer != NULL || stream->readFunction != NULL);
+    stream->readPos += size;
+    if (stream->readPos > stream->offset + stream->size)
     {
-        KWL_ASSERT(0);
+        stream->readPos = stream->offset + stream->size;    
     }
-
 }
 
 /** */
 void kwlInputStream_reset(kwlInputStream* const stream)
 {
-    if (stream->file != NULL && stream->buffer == NULL)
-    {
-        fseek(stream->file, stream->offset, SEEK_SET);
-    }
-    else if (stream->file == NULL && stream->buffer != NULL)
-    {
-        stream->readPos = stream->offset;
-    }
-    else 
-    {
-        KWL_ASSERT(0);
-    }
-    
+    KWL_ASSERT(stream->file != NULL || stream->buffer != NULL || stream->readFunction != NULL);
+    stream->readPos = stream->offset;
 }
 
 int kwlInputStream_isAtEndOfStream(kwlInputStream* const stream)
 {
-    if (stream->file != NULL && stream->buffer == NULL)
-    {
-        if (stream->size < 0)
-        {
-            return feof(stream->file);
-        }
-        else 
-        {
-            return stream->readPos >= stream->offset + stream->size;
-        }
-    }
-    else if (stream->file == NULL && stream->buffer != NULL)
-    {
-        return stream->readPos >= stream->offset + stream->size;
-    }
-    else 
-    {
-		return 0;
-        KWL_ASSERT(0);
-    }
+    return stream->readPos >= stream->offset + stream->size;
 }
 
 int kwlInputStream_tell(kwlInputStream* const stream)
 {
-    if (stream->file != NULL && stream->buffer == NULL)
+    if (stream->file == NULL && stream->buffer != NULL)
     {
-        return ftell(stream->file) - stream->offset;
+        return stream->readPos;
     }
-    else if (stream->file == NULL && stream->buffer != NULL)
+    else if (stream->file != NULL || stream->readFunction != NULL)
     {
-        return stream->readPos;
+        return stream->readPos - stream->offset;
     }
     else 
     {
@@ -196,60 +218,55 @@ int kwlInputStream_tell(kwlInputStream* const stream)
 
 int kwlInputStream_seek(kwlInputStream* const stream, long pos, int p)
 {
-    if (stream->file != NULL && stream->buffer == NULL)
+    if (stream->file == NULL && stream->buffer != NULL)
     {
         if (p == SEEK_SET)
         {
             stream->readPos = stream->offset + pos;
-            return fseek(stream->file, stream->offset + pos, p);
         }
         else if (p == SEEK_CUR)
         {
-            return fseek(stream->file, pos, p);
+            stream->readPos += pos;
         }
         else if (p == SEEK_END)
         {
-            if (stream->size < 0)
-            {
-                /*if the size is unknown, assume we're getting data from a file*/
-                fseek(stream->file, pos, p);
-            }
-            else
-            {
-                /*if we're getting data from file region, first go to the end of the region...*/
-                fseek(stream->file, stream->offset + stream->size, SEEK_SET);
-                /*then seek relative to the current position (ie the end).*/
-                fseek(stream->file, pos, SEEK_CUR);
-            }
-        }        
+            stream->readPos = stream->offset + stream->size + pos;
+        }
         else
         {
             KWL_ASSERT(0);
         }
+        if (stream->readPos < stream->offset || stream->readPos > stream->offset + stream->size)
+        {
+            stream->readPos = stream->offset; /*TODO: handle properly.*/
+            return -1;
+        }
+        return 0;
     }
-    else if (stream->file == NULL && stream->buffer != NULL)
+    else if (stream->file != NULL || stream->readFunction != NULL)
     {
+        long newReadPos = stream->readPos;
         if (p == SEEK_SET)
         {
-            stream->readPos = stream->offset + pos;
+            newReadPos = stream->offset + pos;
         }
         else if (p == SEEK_CUR)
         {
-            stream->readPos += pos;
+            newReadPos = stream->readPos + pos;
         }
         else if (p == SEEK_END)
         {
-            stream->readPos = stream->offset + stream->size + pos;
+            newReadPos = stream->offset + stream->size + pos;
         }
         else
         {
             KWL_ASSERT(0);
         }
-        if (stream->readPos < stream->offset || stream->readPos > stream->offset + stream->size)
+        if (newReadPos < stream->offset || newReadPos > stream->offset + stream->size)
         {
-            stream->readPos = stream->offset; /*TODO: handle properly.*/
             return -1;
         }
+        stream->readPos = (int)newReadPos;
         return 0;
     }
     else 
@@ -264,18 +281,15 @@ int kwlInputStream_read(kwlInputStream* const stream, signed char* data, int len
 {
     if (stream->file != NULL && stream->buffer == NULL)
     {
+        /* File based stream.*/
         int bytesToRead = length;
-        
-        /*Don't read past the end of streams with a known size*/
-        if (stream->readPos + length > stream->offset + stream->size && 
-            stream->size > 0)
+        if (stream->readPos + length > stream->offset + stream->size)
         {
             bytesToRead = stream->offset + stream->size - stream->readPos;
             KWL_ASSERT(bytesToRead >= 0);
         }
         
-        /* File based stream.*/
-        int bytesRead = fread(data, 1, bytesToRead, stream->file);
+        int bytesRead = kwlInputStream_readFile(stream, data, bytesToRead);
         stream->readPos += bytesRead;
         return bytesRead;
     }
@@ -293,6 +307,20 @@ int kwlInputStream_read(kwlInputStream* const stream, signed char* data, int len
         stream->readPos += bytesToRead;
         return bytesToRead;
     }
+    else if (stream->readFunction != NULL)
+    {
+        /* Read function based stream.*/
+        int bytesToRead = length;
+        if (stream->readPos + length > stream->offset + stream->size)
+        {
+            bytesToRead = stream->offset + stream->size - stream->readPos;
+            KWL_ASSERT(bytesToRead >= 0);
+        }
+        
+        int bytesRead = stream->readFunction(stream->readFunctionData, stream->readPos, data, bytesToRead);
+        stream->readPos += bytesRead;
+        return bytesRead;
+    }
     else 
     {
         KWL_ASSERT(0 && "stream must have either a file or a buffer");
@@ -390,7 +418,7 @@ char* kwlInputStream_readASCIIString(kwlInputStream* const stream)
     KWL_ASSERT(stringLength > 0);
     KWL_ASSERT(stringLength < 10000 && "sanity check");
     
-    char* returnString = (char*)KWL_MALLOC((stringLength + 1) * sizeof(char), "kwlInputStream_readASCIIString");
+    char* returnString = (char*)KWL_MALLOC((stringLength + 1) * sizeof(char), KWL_MEMORY_CATEGORY_GENERAL, "kwlInputStream_readASCIIString");
     kwlMemset(returnString, 0, (stringLength + 1) * sizeof(char));
     int i;
     for (i = 0; i < stringLength; i++)
@@ -408,36 +436,45 @@ void kwlInputStream_close(kwlInputStream* const stream)
 {
     if (stream->file != NULL)
     {
-        fclose(stream->file);
+        kwlFileSystem_close(stream->fileSystem, stream->file);
     }
+    if (stream->fileBuffer != NULL)
+    {
+        KWL_FREE(stream->fileBuffer);
+    }
+    stream->fileSystem = NULL;
+    stream->fileBuffer = NULL;
+    stream->fileBufferStart = 0;
+    stream->fileBufferSize = 0;
     stream->size = 0;
     stream->offset = 0;
     stream->readPos = 0;
     stream->buffer = NULL;
     stream->file = NULL;
+    stream->readFunction = NULL;
+    stream->readFunctionData = NULL;
 }
 
 int kwlInputStream_seekToEngineDataChunk(kwlInputStream* stream, int chunkId)
 {
-    /*move to the start of the stream*/
+    /*move to the chunk table, which follows the number of chunks at the end of the header*/
     kwlInputStream_reset(stream);
-    /*move to first chunk*/
-    kwlInputStream_skip(stream, /*KWL_ENGINE_DATA_BINARY_FILE_IDENTIFIER_LENGTH*/9); //TODO: don't hardcode this
+    kwlInputStream_skip(stream, KWL_ENGINE_DATA_BINARY_HEADER_SIZE - 4);
+    const int numChunks = kwlInputStream_readIntBE(stream);
     
-    while (!kwlInputStream_isAtEndOfStream(stream))
+    int i;
+    for (i = 0; i < numChunks; i++)
     {
         const int currentChunkId = kwlInputStream_readIntBE(stream);
+        const int chunkOffset = kwlInputStream_readIntBE(stream);
         const int chunkSize = kwlInputStream_readIntBE(stream);
         if (currentChunkId == chunkId)
         {
+            kwlInputStream_seek(stream, chunkOffset, SEEK_SET);
             return chunkSize;
         }
-        else
-        {
-            kwlInputStream_skip(stream, chunkSize);
-        }
     }
     
     KWL_ASSERT(0 && "no matching chunk id found");
     return 0;
-}
\ No newline at end of file
+}
@@ -27,6 +27,7 @@
 /*! \file */
 
 #include "kowalski.h"
+#include "kwl_filesystem.h"
 #include <stdio.h>
 
 #ifdef __cplusplus
@@ -34,39 +35,53 @@ extern "C"
 {
 #endif /* __cplusplus */
     
+    /** The size in bytes of the buffer small reads from file streams are served from.*/
+#define KWL_INPUT_STREAM_FILE_BUFFER_SIZE 4096
+    
+    /**
+     * A function providing an input stream with data.
+     * @param readFunctionData User data associated with the stream.
+     * @param position The absolute byte position to read from.
+     * @param data The buffer to put read data in.
+     * @param length The number of bytes to read.
+     * @return The number of bytes actually read.
+     */
+    typedef int (*kwlInputStreamReadFunction)(void* readFunctionData, int position, signed char* data, int length);
+    
     /**
      * A struct representing an input stream, getting its data from
-     * either a file or a buffer.
+     * either a file, a buffer or a read function.
      */
     typedef struct kwlInputStream
     {
-        /** A pointer to a file providing the stream with data (NULL if the stream gets its data from a buffer). */
-        FILE* file;
+        /** A file providing the stream with data (NULL if the stream gets its data from a buffer). */
+        void* file;
+        /** The file system \c file was opened with. NULL for the default file system. */
+        const kwlFileSystem* fileSystem;
+        /** Holds the bytes following the position of the last small read from \c file. Allocated on demand. */
+        signed char* fileBuffer;
+        /** The file position of the first byte in \c fileBuffer. */
+        int fileBufferStart;
+        /** The number of valid bytes in \c fileBuffer. */
+        int fileBufferSize;
         /** A pointer to a buffer providing the stream with data (NULL if the stream gets its data from a file). */
         void* buffer;
-        /**
-         * The size in bytes of the stream data source. A negative size indicates that the size is unknown,
-         * which is the case when reading files.
-         */
+        /** The size in bytes of the stream data source. */
         int size;
         /** The offset in bytes into the underlying data.*/
         int offset;
         /** The current byte position, relative to the start of the underlying data. */
         int readPos;
+        /** A function providing the stream with data (NULL if the stream gets its data from a file or a buffer). */
+        kwlInputStreamReadFunction readFunction;
+        /** User data passed to \c readFunction. */
+        void* readFunctionData;
     } kwlInputStream;
     
     void kwlInputStream_init(kwlInputStream* stream);
     
     void kwlInputStream_free(kwlInputStream* stream);
     
-    /**
-     * Opens a file and returns a pointer to it.
-     * @param stream A pointer to the kwlInputStream struct.
-     * @param path The path of the file to open.
-     * @return A pointer to the newly opened file or NULL if the file could not be opened.
-     */
-    FILE* kwlInputStream_openFile(kwlInputStream* stream, const char* const path);
-    
     /**
      * Initializes an input stream getting its data from a memory buffer region.
      * @param stream The input stream to initialize.
@@ -80,19 +95,39 @@ extern "C"
      * Initializes an input stream getting its data from a region within a file.
      * @param stream The input stream to initialize.
      * @param path The path to the file to associate \c stream with.
+     * @param fileSystem The file system to open the file with. NULL for the default file system.
      * @param offset The byte offset into the file.
      * @param size The size of the region.
      * @return Returns \c KWL_FILE_NOT_FOUND if the specified file does not exist and \c KWL_NO_ERROR otherwise.
      */
-    kwlError kwlInputStream_initWithFileRegion(kwlInputStream* const stream, const char* const path, int offset, int size);
+    kwlError kwlInputStream_initWithFileRegion(kwlInputStream* const stream,
+                                               const char* const path,
+                                               const kwlFileSystem* fileSystem,
+                                               int offset,
+                                               int size);
+    
+    /**
+     * Initializes an input stream getting its data from a region read through a given function.
+     * @param stream The input stream to initialize.
+     * @param readFunction The function to read data with.
+     * @param readFunctionData User data to pass to \c readFunction.
+     * @param offset The absolute byte position of the start of the region.
+     * @param size The size of the region.
+     */
+    void kwlInputStream_initWithReadFunction(kwlInputStream* const stream,
+                                             kwlInputStreamReadFunction readFunction,
+                                             void* readFunctionData,
+                                             int offset,
+                                             int size);
     
     /**
      * Initializes the input stream, getting its data from a given file.
      * @param stream The input stream to initialize.
      * @param path The path to the file to associate \c stream with.
+     * @param fileSystem The file system to open the file with. NULL for the default file system.
      * @return Returns \c KWL_FILE_NOT_FOUND if the specified file does not exist and \c KWL_NO_ERROR otherwise.
      */
-    kwlError kwlInputStream_initWithFile(kwlInputStream* const stream, const char* const path);
+    kwlError kwlInputStream_initWithFile(kwlInputStream* const stream, const char* const path, const kwlFileSystem* fileSystem);
     
     /**
      * Closes a stream and disposes of the underlying file, if any. Any memory buffer associated with the
@@ -102,7 +137,7 @@ extern "C"
     void kwlInputStream_close(kwlInputStream* const stream);
     
     /**
-     * Moves the read position of a file stream a given number of bytes.
+     * Moves the read position of a stream a given number of bytes.
      * @param stream The input stream to advance the read position of.
      * @param size The number of bytes by which to advance the read position.
      */
@@ -203,7 +238,11 @@ extern "C"
     float kwlInputStream_readFloatLE(kwlInputStream* const stream);
 
     /**
-     *
+     * Moves the read position of a stream reading an engine data binary to the start
+     * of a given chunk, looked up in the chunk table following the file header.
+     * @param stream The input stream to seek in.
+     * @param chunkId The ID of the chunk to seek to.
+     * @return The size of the chunk in bytes.
      */
     int kwlInputStream_seekToEngineDataChunk(kwlInputStream* stream, int chunkId);
     
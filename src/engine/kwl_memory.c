@@ -24,6 +24,7 @@ freely, subject to the following restrictions:
 #include "kwl_memory.h"
 
 #include "kwl_assert.h"
+#include "kwl_synchronization.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -37,182 +38,774 @@ void* kwlMemset(void* location, int value, size_t size)
     return memset(location, value, size);
 }
 
-void* kwlMallocAndZero(size_t size)
+/** Set in the flags of blocks allocated by the host allocator rather than the default one.*/
+#define KWL_MEMORY_BLOCK_HOST_ALLOCATOR 0x1
+/** The flags bits holding the base 2 logarithm of the alignment of over-aligned blocks.*/
+#define KWL_MEMORY_BLOCK_ALIGNMENT_SHIFT 8
+/** The alignment of blocks returned by malloc and thus of blocks allocated without explicit alignment.*/
+#define KWL_MEMORY_DEFAULT_ALIGNMENT (2 * sizeof(void*))
+
+/** 
+ * Bookkeeping stored right in front of every block handed out by kwlMalloc, 
+ * in the last bytes of the KWL_MEMORY_BLOCK_HEADER_SIZE reserved ones.
+ */
+typedef struct kwlMemoryBlockHeader
 {
-    void* ptr = kwlMalloc(size);
-    kwlMemset(ptr, 0, size);
-    return ptr;
-}
+    /** The requested size of the block.*/
+    size_t size;
+    /** The category of the block.*/
+    unsigned short category;
+    /** Flags describing where the block came from and how it is aligned.*/
+    unsigned short flags;
+    /** The number of bytes between the start of the underlying allocation and the block.*/
+    unsigned int offset;
+} kwlMemoryBlockHeader;
 
-void* kwlRealloc(void* ptr, size_t size)
+typedef char kwlMemoryBlockHeaderFits[sizeof(kwlMemoryBlockHeader) <= KWL_MEMORY_BLOCK_HEADER_SIZE ? 1 : -1];
+
+static void* kwlMemory_defaultAlloc(void* userData, size_t size, kwlMemoryCategory category)
 {
-    return realloc(ptr, size);
+    return malloc(size);
 }
 
-void* kwlMalloc(size_t size)
+static void* kwlMemory_defaultRealloc(void* userData, void* pointer, size_t size, kwlMemoryCategory category)
 {
-    return malloc(size);
+    return realloc(pointer, size);
 }
 
-void kwlFree(void* pointer)
+static void kwlMemory_defaultFree(void* userData, void* pointer, kwlMemoryCategory category)
 {
     free(pointer);
 }
 
-#ifdef KWL_DEBUG_MEMORY
-int liveBytes = 0;
-int totalBytes = 0;
+static const kwlAllocator kwlMemory_defaultAllocator =
+{
+    kwlMemory_defaultAlloc,
+    kwlMemory_defaultRealloc,
+    NULL,
+    kwlMemory_defaultFree,
+    NULL
+};
+
+static int memoryInitialized = 0;
+/** Guards the statistics and the host allocator bookkeeping.*/
+static kwlMutexLock memoryLock;
+/** The allocator set by the host. Kept after it is replaced by the default allocator, to free its blocks.*/
+static kwlAllocator hostAllocator;
+/** Non-zero if new blocks are allocated by \c hostAllocator.*/
+static int useHostAllocator = 0;
+/** The number of live blocks allocated by \c hostAllocator.*/
+static int numLiveHostBlocks = 0;
+static kwlMemoryStats categoryStats[KWL_NUM_MEMORY_CATEGORIES];
+
+/**
+ * Lazily sets up the allocation bookkeeping. This is not thread safe in itself, but the
+ * first allocation is made by kwlInitialize (or by the tools) before any other thread is started.
+ */
+static void kwlMemory_ensureInitialized(void)
+{
+    if (memoryInitialized)
+    {
+        return;
+    }
+    
+    kwlMutexLockInit(&memoryLock);
+    memoryInitialized = 1;
+}
+
+static kwlMemoryBlockHeader* kwlMemory_getHeader(void* pointer)
+{
+    return (kwlMemoryBlockHeader*)((char*)pointer - sizeof(kwlMemoryBlockHeader));
+}
+
+static const kwlAllocator* kwlMemory_getBlockAllocator(const kwlMemoryBlockHeader* header)
+{
+    return (header->flags & KWL_MEMORY_BLOCK_HOST_ALLOCATOR) != 0 ? &hostAllocator : &kwlMemory_defaultAllocator;
+}
+
+/** Must be called with the memory lock held.*/
+static void kwlMemory_recordAllocation(const kwlMemoryBlockHeader* header)
+{
+    kwlMemoryStats* stats = &categoryStats[header->category];
+    stats->numLiveAllocations++;
+    stats->numAllocations++;
+    stats->numLiveBytes += header->size;
+    stats->numTotalBytes += header->size;
+    if (stats->numLiveBytes > stats->numPeakBytes)
+    {
+        stats->numPeakBytes = stats->numLiveBytes;
+    }
+    
+    if ((header->flags & KWL_MEMORY_BLOCK_HOST_ALLOCATOR) != 0)
+    {
+        numLiveHostBlocks++;
+    }
+}
+
+/** Must be called with the memory lock held.*/
+static void kwlMemory_recordDeletion(const kwlMemoryBlockHeader* header)
+{
+    kwlMemoryStats* stats = &categoryStats[header->category];
+    stats->numLiveAllocations--;
+    stats->numLiveBytes -= header->size;
+    
+    if ((header->flags & KWL_MEMORY_BLOCK_HOST_ALLOCATOR) != 0)
+    {
+        numLiveHostBlocks--;
+    }
+}
 
-void* kwlDebugMallocAndZero(size_t size, const char* const tag)
+/** 
+ * Allocates a block with a header through the current allocator. Blocks aligned to more than
+ * malloc does are placed \c alignment bytes into an aligned allocation if the allocator 
+ * supports it, or at the first aligned address after the header of a larger allocation otherwise.
+ */
+static void* kwlMemory_allocate(size_t size, size_t alignment, kwlMemoryCategory category)
 {
-    void* ptr = kwlDebugMalloc(size, tag);
-    kwlMemset(ptr, 0, size);
+    KWL_ASSERT(category >= 0 && category < KWL_NUM_MEMORY_CATEGORIES);
+    KWL_ASSERT((alignment & (alignment - 1)) == 0 && "alignment must be a power of two");
+    kwlMemory_ensureInitialized();
+    
+    const int isHostBlock = useHostAllocator;
+    const kwlAllocator* allocator = isHostBlock ? &hostAllocator : &kwlMemory_defaultAllocator;
+    
+    char* base = NULL;
+    char* pointer = NULL;
+    unsigned short flags = isHostBlock ? KWL_MEMORY_BLOCK_HOST_ALLOCATOR : 0;
+    if (alignment <= KWL_MEMORY_DEFAULT_ALIGNMENT)
+    {
+        base = (char*)allocator->alloc(allocator->userData, size + KWL_MEMORY_BLOCK_HEADER_SIZE, category);
+        pointer = base + KWL_MEMORY_BLOCK_HEADER_SIZE;
+    }
+    else
+    {
+        int alignmentShift = 0;
+        while (((size_t)1 << alignmentShift) < alignment)
+        {
+            alignmentShift++;
+        }
+        flags |= alignmentShift << KWL_MEMORY_BLOCK_ALIGNMENT_SHIFT;
+        
+        if (allocator->alignedAlloc != NULL)
+        {
+            base = (char*)allocator->alignedAlloc(allocator->userData, size + alignment, alignment, category);
+            pointer = base + alignment;
+        }
+        else
+        {
+            base = (char*)allocator->alloc(allocator->userData, size + alignment + KWL_MEMORY_BLOCK_HEADER_SIZE, category);
+            pointer = (char*)(((size_t)base + KWL_MEMORY_BLOCK_HEADER_SIZE + alignment - 1) & ~(alignment - 1));
+        }
+    }
+    
+    if (base == NULL)
+    {
+        return NULL;
+    }
+    
+    kwlMemoryBlockHeader* header = kwlMemory_getHeader(pointer);
+    header->size = size;
+    header->category = (unsigned short)category;
+    header->flags = flags;
+    header->offset = (unsigned int)(pointer - base);
+    
+    kwlMutexLockAcquire(&memoryLock);
+    kwlMemory_recordAllocation(header);
+    kwlMutexLockRelease(&memoryLock);
+    
+    return pointer;
+}
+
+void* kwlMallocAndZero(size_t size, kwlMemoryCategory category)
+{
+    void* ptr = kwlMalloc(size, category);
+    if (ptr != NULL)
+    {
+        kwlMemset(ptr, 0, size);
+    }
     return ptr;
 }
 
-void* kwlDebugRealloc(void* ptr, size_t size, const char* const tag)
+void* kwlRealloc(void* ptr, size_t size, kwlMemoryCategory category)
 {
     if (ptr == NULL)
     {
-        return kwlDebugMalloc(size, tag);
+        return kwlMalloc(size, category);
     }
     
-    /*find a free slot in the allocation table*/
-    int allocationSlotIndex = -1;
-    for (int i = 0; i < KWL_DEBUG_ALLOCATION_TABLE_SIZE; i++)
+    kwlMemoryBlockHeader* header = kwlMemory_getHeader(ptr);
+    const size_t oldSize = header->size;
+    const int alignmentShift = header->flags >> KWL_MEMORY_BLOCK_ALIGNMENT_SHIFT;
+    if (alignmentShift > 0)
     {
-        if (kwlDebugAllocationAddresses[i] == ptr)
+        /*over-aligned blocks cannot be resized in place by the allocator, move them.*/
+        void* newPtr = kwlMallocAligned(size, (size_t)1 << alignmentShift, category);
+        if (newPtr != NULL)
         {
-            allocationSlotIndex = i;
-            break;
+            kwlMemcpy(newPtr, ptr, oldSize < size ? oldSize : size);
+            kwlFree(ptr);
         }
+        return newPtr;
+    }
+    
+    /*the block stays with the allocator that allocated it.*/
+    const kwlAllocator* allocator = kwlMemory_getBlockAllocator(header);
+    kwlMemoryBlockHeader oldHeader = *header;
+    char* base = (char*)ptr - KWL_MEMORY_BLOCK_HEADER_SIZE;
+    char* newBase = (char*)allocator->realloc(allocator->userData, 
+                                              base, 
+                                              size + KWL_MEMORY_BLOCK_HEADER_SIZE, 
+                                              (kwlMemoryCategory)oldHeader.category);
+    if (newBase == NULL)
+    {
+        return NULL;
+    }
+    
+    char* newPtr = newBase + KWL_MEMORY_BLOCK_HEADER_SIZE;
+    header = kwlMemory_getHeader(newPtr);
+    header->size = size;
+    header->category = (unsigned short)category;
+    
+    kwlMutexLockAcquire(&memoryLock);
+    kwlMemory_recordDeletion(&oldHeader);
+    kwlMemory_recordAllocation(header);
+    kwlMutexLockRelease(&memoryLock);
+    
+    return newPtr;
+}
+
+void* kwlMalloc(size_t size, kwlMemoryCategory category)
+{
+    return kwlMemory_allocate(size, 0, category);
+}
+
+void* kwlMallocAligned(size_t size, size_t alignment, kwlMemoryCategory category)
+{
+    return kwlMemory_allocate(size, alignment, category);
+}
+
+void kwlFree(void* pointer)
+{
+    if (pointer == NULL)
+    {
+        return;
     }
     
-    KWL_ASSERT(allocationSlotIndex >= 0 && "reallocating untracked pointer");
+    kwlMemoryBlockHeader* header = kwlMemory_getHeader(pointer);
+    const kwlAllocator* allocator = kwlMemory_getBlockAllocator(header);
+    const kwlMemoryCategory category = (kwlMemoryCategory)header->category;
+    char* base = (char*)pointer - header->offset;
     
-    void* newPtr = realloc(ptr, size);
+    kwlMutexLockAcquire(&memoryLock);
+    kwlMemory_recordDeletion(header);
+    kwlMutexLockRelease(&memoryLock);
+    
+    allocator->free(allocator->userData, base, category);
+}
+
+kwlError kwlMemory_setAllocator(const kwlAllocator* allocator)
+{
+    if (allocator != NULL &&
+        (allocator->alloc == NULL || allocator->realloc == NULL || allocator->free == NULL))
+    {
+        return KWL_INVALID_PARAMETER_VALUE;
+    }
+    
+    kwlMemory_ensureInitialized();
+    kwlMutexLockAcquire(&memoryLock);
+    
+    kwlError result = KWL_NO_ERROR;
+    if (allocator == NULL)
+    {
+        /*keep the host allocator around for freeing its remaining blocks*/
+        useHostAllocator = 0;
+    }
+    else if (numLiveHostBlocks > 0 && memcmp(allocator, &hostAllocator, sizeof(kwlAllocator)) != 0)
+    {
+        /*blocks of the current host allocator could no longer be freed*/
+        result = KWL_INVALID_PARAMETER_VALUE;
+    }
+    else
+    {
+        hostAllocator = *allocator;
+        useHostAllocator = 1;
+    }
+    
+    kwlMutexLockRelease(&memoryLock);
+    return result;
+}
+
+void kwlMemory_getStats(kwlMemoryCategory category, kwlMemoryStats* stats)
+{
+    KWL_ASSERT(category >= 0 && category < KWL_NUM_MEMORY_CATEGORIES);
+    kwlMemory_ensureInitialized();
     
-    size_t oldSize = kwlDebugAllocationSizes[allocationSlotIndex];
-    size_t delta = size - oldSize;
+    kwlMutexLockAcquire(&memoryLock);
+    *stats = categoryStats[category];
+    kwlMutexLockRelease(&memoryLock);
+}
+
+#ifdef KWL_DEBUG_MEMORY
+
+#include <stdint.h>
+
+/** Aggregated statistics for a tag or a subsystem, kept in a linked list.*/
+typedef struct kwlDebugStatsNode
+{
+    kwlDebugAllocationStats stats;
+    /** Storage for subsystem names, which are derived from file names.*/
+    char nameBuffer[KWL_DEBUG_SUBSYSTEM_NAME_SIZE];
+    struct kwlDebugStatsNode* next;
+} kwlDebugStatsNode;
+
+/** 
+ * A unique tag/file pointer pair. Allocations refer to their site, so that 
+ * tag and subsystem statistics can be updated without any string comparisons.
+ */
+typedef struct kwlDebugAllocationSite
+{
+    const char* tag;
+    const char* file;
+    kwlDebugStatsNode* tagStats;
+    kwlDebugStatsNode* subsystemStats;
+    struct kwlDebugAllocationSite* next;
+} kwlDebugAllocationSite;
+
+/** A live allocation, stored in a hash table bucket list keyed by address.*/
+typedef struct kwlDebugAllocation
+{
+    void* address;
+    size_t size;
+    kwlDebugAllocationSite* site;
+    struct kwlDebugAllocation* next;
+} kwlDebugAllocation;
+
+/** The number of allocation records to allocate at a time.*/
+#define KWL_DEBUG_ALLOCATION_CHUNK_SIZE 1024
+/** The number of buckets in the allocation site hash table.*/
+#define KWL_DEBUG_SITE_TABLE_SIZE 256
+
+static int debugMemoryInitialized = 0;
+static kwlMutexLock debugMemoryLock;
+
+static kwlDebugAllocation** allocationTable = NULL;
+static int allocationTableSize = 0;
+static int numLiveAllocations = 0;
+static kwlDebugAllocation* freeAllocations = NULL;
+
+static kwlDebugAllocationSite* siteTable[KWL_DEBUG_SITE_TABLE_SIZE];
+static kwlDebugStatsNode* tagStatsList = NULL;
+static int numTags = 0;
+static kwlDebugStatsNode* subsystemStatsList = NULL;
+static int numSubsystems = 0;
+
+static size_t liveBytes = 0;
+static size_t peakBytes = 0;
+static size_t totalBytes = 0;
+
+/**
+ * Lazily sets up the tracker. This is not thread safe in itself, but the first
+ * tracked allocation is made by kwlInitialize (or by the tools) before any other
+ * thread is started.
+ */
+static void kwlDebugMemory_ensureInitialized(void)
+{
+    if (debugMemoryInitialized)
+    {
+        return;
+    }
     
-    kwlDebugAllocationSizes[allocationSlotIndex] += delta;
-    kwlDebugAllocationAddresses[allocationSlotIndex] = newPtr;
-    for (int i = 0; i < KWL_DEBUG_ALLOCATION_TAG_SIZE - 1; i++)
+    kwlMutexLockInit(&debugMemoryLock);
+    allocationTableSize = KWL_DEBUG_ALLOCATION_TABLE_INITIAL_SIZE;
+    allocationTable = (kwlDebugAllocation**)calloc(allocationTableSize, sizeof(kwlDebugAllocation*));
+    KWL_ASSERT(allocationTable != NULL);
+    debugMemoryInitialized = 1;
+}
+
+static unsigned int kwlDebugMemory_hashPointer(const void* pointer)
+{
+    uintptr_t value = (uintptr_t)pointer;
+    /*the low bits are always zero due to alignment*/
+    value ^= value >> 16;
+    return (unsigned int)((value >> 3) * 2654435761u);
+}
+
+static void kwlDebugMemory_updateStats(kwlDebugAllocationStats* stats, size_t size, int isAllocation)
+{
+    if (isAllocation)
     {
-        kwlDebugAllocationTags[allocationSlotIndex][i] = tag[i];
-        if (tag[i] == '\0')
+        stats->liveBytes += size;
+        stats->totalBytes += size;
+        stats->liveCount++;
+        stats->totalCount++;
+        if (stats->liveBytes > stats->peakBytes)
+        {
+            stats->peakBytes = stats->liveBytes;
+        }
+        if (stats->liveCount > stats->peakCount)
         {
-            break;
+            stats->peakCount = stats->liveCount;
+        }
+    }
+    else
+    {
+        stats->liveBytes -= size;
+        stats->liveCount--;
+    }
+}
+
+/** Derives a subsystem name like "wavebank" from a path like ".../kwl_wavebank.c".*/
+static void kwlDebugMemory_getSubsystemName(const char* file, char* name)
+{
+    const char* start = file;
+    for (const char* c = file; *c != '\0'; c++)
+    {
+        if (*c == '/' || *c == '\\')
+        {
+            start = c + 1;
         }
     }
     
-    liveBytes += delta;
-    totalBytes += delta;
+    if (strncmp(start, "kwl_", 4) == 0)
+    {
+        start += 4;
+    }
     
-    return newPtr;
+    int i = 0;
+    while (start[i] != '\0' && start[i] != '.' && i < KWL_DEBUG_SUBSYSTEM_NAME_SIZE - 1)
+    {
+        name[i] = start[i];
+        i++;
+    }
+    name[i] = '\0';
 }
 
-void* kwlDebugMalloc(size_t size, const char* const tag)
+static kwlDebugStatsNode* kwlDebugMemory_getStatsNode(kwlDebugStatsNode** list, int* listSize, const char* name)
 {
-    if (size == 0)
+    kwlDebugStatsNode* node = *list;
+    while (node != NULL)
     {
-        return NULL;
+        if (strcmp(node->stats.name, name) == 0)
+        {
+            return node;
+        }
+        node = node->next;
     }
     
-    /*find a free slot in the allocation table*/
-    int allocationSlotIndex = -1;
-    for (int i = 0; i < KWL_DEBUG_ALLOCATION_TABLE_SIZE; i++)
+    node = (kwlDebugStatsNode*)calloc(1, sizeof(kwlDebugStatsNode));
+    KWL_ASSERT(node != NULL);
+    node->stats.name = name;
+    node->next = *list;
+    *list = node;
+    (*listSize)++;
+    return node;
+}
+
+/** Must be called with the debug memory lock held.*/
+static kwlDebugAllocationSite* kwlDebugMemory_getSite(const char* tag, const char* file)
+{
+    unsigned int bucket = (kwlDebugMemory_hashPointer(tag) ^ kwlDebugMemory_hashPointer(file)) % KWL_DEBUG_SITE_TABLE_SIZE;
+    kwlDebugAllocationSite* site = siteTable[bucket];
+    while (site != NULL)
     {
-        if (kwlDebugAllocationAddresses[i] == NULL)
+        if (site->tag == tag && site->file == file)
         {
-            allocationSlotIndex = i;
-            break;
+            return site;
         }
+        site = site->next;
+    }
+    
+    /*first allocation from this tag/file pair. resolve the tag and subsystem stats by name.*/
+    site = (kwlDebugAllocationSite*)calloc(1, sizeof(kwlDebugAllocationSite));
+    KWL_ASSERT(site != NULL);
+    site->tag = tag;
+    site->file = file;
+    site->tagStats = kwlDebugMemory_getStatsNode(&tagStatsList, &numTags, tag);
+    
+    char subsystemName[KWL_DEBUG_SUBSYSTEM_NAME_SIZE];
+    kwlDebugMemory_getSubsystemName(file, subsystemName);
+    site->subsystemStats = kwlDebugMemory_getStatsNode(&subsystemStatsList, &numSubsystems, subsystemName);
+    if (site->subsystemStats->stats.name == subsystemName)
+    {
+        /*newly created node, point the name at storage that outlives this call*/
+        kwlMemcpy(site->subsystemStats->nameBuffer, subsystemName, KWL_DEBUG_SUBSYSTEM_NAME_SIZE);
+        site->subsystemStats->stats.name = site->subsystemStats->nameBuffer;
     }
-    KWL_ASSERT(allocationSlotIndex >= 0 && "no free allocation table slots");
-    /*printf("size = %d\n", size);*/
-    /*allocate the block*/
-    void* ptr = malloc(size);
     
-    /*record the allocation*/
-    kwlDebugAllocationAddresses[allocationSlotIndex] = ptr;
-    for (int i = 0; i < KWL_DEBUG_ALLOCATION_TAG_SIZE - 1; i++)
+    site->next = siteTable[bucket];
+    siteTable[bucket] = site;
+    return site;
+}
+
+/** Must be called with the debug memory lock held.*/
+static void kwlDebugMemory_resizeAllocationTable(int newSize)
+{
+    kwlDebugAllocation** newTable = (kwlDebugAllocation**)calloc(newSize, sizeof(kwlDebugAllocation*));
+    KWL_ASSERT(newTable != NULL);
+    
+    for (int i = 0; i < allocationTableSize; i++)
     {
-        kwlDebugAllocationTags[allocationSlotIndex][i] = tag[i];
-        if (tag[i] == '\0')
+        kwlDebugAllocation* allocation = allocationTable[i];
+        while (allocation != NULL)
         {
-            break;
+            kwlDebugAllocation* next = allocation->next;
+            unsigned int bucket = kwlDebugMemory_hashPointer(allocation->address) % newSize;
+            allocation->next = newTable[bucket];
+            newTable[bucket] = allocation;
+            allocation = next;
         }
     }
     
-    kwlDebugAllocationTags[allocationSlotIndex][KWL_DEBUG_ALLOCATION_TAG_SIZE - 1] = '\0';
-    kwlDebugAllocationSizes[allocationSlotIndex] = size;
-    liveBytes += size;
-    totalBytes += size;
-    /*printf("malloc: live bytes = %d\n", liveBytes);*/
-    /*return a pointer to the allocated block*/
-    return ptr;
+    free(allocationTable);
+    allocationTable = newTable;
+    allocationTableSize = newSize;
 }
 
-void kwlDebugFree(void* pointer)
+/** Must be called with the debug memory lock held.*/
+static void kwlDebugMemory_recordAllocation(void* address, size_t size, kwlDebugAllocationSite* site)
 {
-    if (pointer == NULL)
+    if (numLiveAllocations >= allocationTableSize)
     {
-        return;
+        kwlDebugMemory_resizeAllocationTable(2 * allocationTableSize);
     }
     
-    /*record the deletion*/
-    int allocationSlotIndex = -1;
-    for (int i = 0; i < KWL_DEBUG_ALLOCATION_TABLE_SIZE; i++)
+    if (freeAllocations == NULL)
     {
-        if (kwlDebugAllocationAddresses[i] == pointer)
+        /*records are never released, they are recycled through the free list*/
+        kwlDebugAllocation* chunk = (kwlDebugAllocation*)malloc(KWL_DEBUG_ALLOCATION_CHUNK_SIZE * sizeof(kwlDebugAllocation));
+        KWL_ASSERT(chunk != NULL);
+        for (int i = 0; i < KWL_DEBUG_ALLOCATION_CHUNK_SIZE; i++)
         {
-            allocationSlotIndex = i;
-            break;
+            chunk[i].next = freeAllocations;
+            freeAllocations = &chunk[i];
         }
     }
-    /*no matching slot found. this means that this is a double free
+    
+    kwlDebugAllocation* allocation = freeAllocations;
+    freeAllocations = allocation->next;
+    
+    allocation->address = address;
+    allocation->size = size;
+    allocation->site = site;
+    
+    unsigned int bucket = kwlDebugMemory_hashPointer(address) % allocationTableSize;
+    allocation->next = allocationTable[bucket];
+    allocationTable[bucket] = allocation;
+    numLiveAllocations++;
+    
+    kwlDebugMemory_updateStats(&site->tagStats->stats, size, 1);
+    kwlDebugMemory_updateStats(&site->subsystemStats->stats, size, 1);
+    liveBytes += size;
+    totalBytes += size;
+    if (liveBytes > peakBytes)
+    {
+        peakBytes = liveBytes;
+    }
+}
+
+/** 
+ * Removes the record of the allocation at the given address and returns its size. 
+ * Must be called with the debug memory lock held.
+ */
+static size_t kwlDebugMemory_removeAllocation(void* address)
+{
+    unsigned int bucket = kwlDebugMemory_hashPointer(address) % allocationTableSize;
+    kwlDebugAllocation** link = &allocationTable[bucket];
+    while (*link != NULL && (*link)->address != address)
+    {
+        link = &(*link)->next;
+    }
+    
+    /*no matching record found. this means that this is a double free
       or that the given address points to a block of memory that was
-      not allocated using KWL_ALLOC.*/
-    KWL_ASSERT(allocationSlotIndex >= 0 && "double free?");
+      not allocated using KWL_MALLOC.*/
+    KWL_ASSERT(*link != NULL && "double free?");
     
-    /*clear the allocation table entry*/
-    kwlDebugAllocationAddresses[allocationSlotIndex] = NULL;
-    for (int i = 0; i < KWL_DEBUG_ALLOCATION_TAG_SIZE; i++)
+    kwlDebugAllocation* allocation = *link;
+    *link = allocation->next;
+    numLiveAllocations--;
+    
+    size_t size = allocation->size;
+    kwlDebugMemory_updateStats(&allocation->site->tagStats->stats, size, 0);
+    kwlDebugMemory_updateStats(&allocation->site->subsystemStats->stats, size, 0);
+    liveBytes -= size;
+    
+    allocation->next = freeAllocations;
+    freeAllocations = allocation;
+    
+    return size;
+}
+
+void* kwlDebugMallocAndZero(size_t size, kwlMemoryCategory category, const char* const tag, const char* const file)
+{
+    void* ptr = kwlDebugMalloc(size, 0, category, tag, file);
+    if (ptr != NULL)
+    {
+        kwlMemset(ptr, 0, size);
+    }
+    return ptr;
+}
+
+void* kwlDebugRealloc(void* ptr, size_t size, kwlMemoryCategory category, const char* const tag, const char* const file)
+{
+    if (ptr == NULL)
     {
-        kwlDebugAllocationTags[allocationSlotIndex][i] = '\0';
+        return kwlDebugMalloc(size, 0, category, tag, file);
     }
     
-    liveBytes -= kwlDebugAllocationSizes[allocationSlotIndex];
-    /*printf("free: live bytes = %d\n", liveBytes);*/
-    /*free the memory block*/
-    free(pointer);
+    if (size == 0)
+    {
+        kwlDebugFree(ptr);
+        return NULL;
+    }
+    
+    /*the old record has to be removed before the block is handed back to the
+      heap, since another thread may get the same address from malloc.*/
+    kwlMutexLockAcquire(&debugMemoryLock);
+    kwlDebugMemory_removeAllocation(ptr);
+    kwlMutexLockRelease(&debugMemoryLock);
+    
+    void* newPtr = kwlRealloc(ptr, size, category);
+    KWL_ASSERT(newPtr != NULL);
+    
+    kwlMutexLockAcquire(&debugMemoryLock);
+    kwlDebugMemory_recordAllocation(newPtr, size, kwlDebugMemory_getSite(tag, file));
+    kwlMutexLockRelease(&debugMemoryLock);
+    
+    return newPtr;
+}
+
+void* kwlDebugMalloc(size_t size, size_t alignment, kwlMemoryCategory category, const char* const tag, const char* const file)
+{
+    if (size == 0)
+    {
+        return NULL;
+    }
+    
+    kwlDebugMemory_ensureInitialized();
+    
+    void* ptr = alignment != 0 ? kwlMallocAligned(size, alignment, category) : kwlMalloc(size, category);
+    if (ptr == NULL)
+    {
+        return NULL;
+    }
+    
+    kwlMutexLockAcquire(&debugMemoryLock);
+    kwlDebugMemory_recordAllocation(ptr, size, kwlDebugMemory_getSite(tag, file));
+    kwlMutexLockRelease(&debugMemoryLock);
+    
+    return ptr;
+}
+
+void kwlDebugFree(void* pointer)
+{
+    if (pointer == NULL)
+    {
+        return;
+    }
+    
+    KWL_ASSERT(debugMemoryInitialized && "freeing untracked pointer");
+    
+    kwlMutexLockAcquire(&debugMemoryLock);
+    kwlDebugMemory_removeAllocation(pointer);
+    kwlMutexLockRelease(&debugMemoryLock);
+    
+    kwlFree(pointer);
+}
+
+void kwlDebugSetMinAllocationTableSize(int minSize)
+{
+    kwlDebugMemory_ensureInitialized();
+    
+    kwlMutexLockAcquire(&debugMemoryLock);
+    if (minSize > allocationTableSize)
+    {
+        kwlDebugMemory_resizeAllocationTable(minSize);
+    }
+    kwlMutexLockRelease(&debugMemoryLock);
 }
 
 int kwlDebugGetLiveBytes(void)
 {
-    return liveBytes;
+    return (int)liveBytes;
+}
+
+int kwlDebugGetPeakBytes(void)
+{
+    return (int)peakBytes;
 }
 
 int kwlDebugGetTotalBytes(void)
 {
-    return totalBytes;
+    return (int)totalBytes;
 }
 
+static int kwlDebugMemory_copyStats(kwlDebugStatsNode* list, int listSize, kwlDebugAllocationStats* stats, int maxNumStats)
+{
+    if (!debugMemoryInitialized)
+    {
+        return 0;
+    }
+    
+    kwlMutexLockAcquire(&debugMemoryLock);
+    int i = 0;
+    for (kwlDebugStatsNode* node = list; node != NULL && i < maxNumStats; node = node->next)
+    {
+        stats[i++] = node->stats;
+    }
+    kwlMutexLockRelease(&debugMemoryLock);
+    
+    return listSize;
+}
 
-void kwlDebugPrintAllocationReport()
+int kwlDebugGetTagStats(kwlDebugAllocationStats* stats, int maxNumStats)
 {
-    printf("Live allocations, %d bytes total :\n", liveBytes);
-    printf("-----------------------------------------\n");
-    int i;
-    for (i = 0; i < KWL_DEBUG_ALLOCATION_TABLE_SIZE; i++)
+    return kwlDebugMemory_copyStats(tagStatsList, numTags, stats, maxNumStats);
+}
+
+int kwlDebugGetSubsystemStats(kwlDebugAllocationStats* stats, int maxNumStats)
+{
+    return kwlDebugMemory_copyStats(subsystemStatsList, numSubsystems, stats, maxNumStats);
+}
+
+static void kwlDebugMemory_printStats(const kwlDebugStatsNode* list, int liveOnly)
+{
+    printf("%-40s %12s %8s %12s %8s\n", "name", "live bytes", "live", "peak bytes", "peak");
+    for (const kwlDebugStatsNode* node = list; node != NULL; node = node->next)
     {
-        if (kwlDebugAllocationAddresses[i] != NULL)
+        const kwlDebugAllocationStats* stats = &node->stats;
+        if (liveOnly && stats->liveCount == 0)
         {
-            printf("%s (%d bytes)\n", &kwlDebugAllocationTags[i][0], kwlDebugAllocationSizes[i]);
+            continue;
         }
+        printf("%-40s %12lu %8d %12lu %8d\n", 
+               stats->name, 
+               (unsigned long)stats->liveBytes, 
+               stats->liveCount, 
+               (unsigned long)stats->peakBytes, 
+               stats->peakCount);
+    }
+}
+
+void kwlDebugPrintAllocationReport()
+{
+    if (!debugMemoryInitialized)
+    {
+        printf("No tracked allocations.\n");
+        return;
     }
+    
+    kwlMutexLockAcquire(&debugMemoryLock);
+    printf("Live allocations, %lu bytes in %d blocks (peak %lu bytes):\n", 
+           (unsigned long)liveBytes, numLiveAllocations, (unsigned long)peakBytes);
+    printf("-----------------------------------------\n");
+    printf("Per subsystem:\n");
+    kwlDebugMemory_printStats(subsystemStatsList, 0);
+    printf("-----------------------------------------\n");
+    printf("Per tag (live only):\n");
+    kwlDebugMemory_printStats(tagStatsList, 1);
     printf("-----------------------------------------\n");
+    kwlMutexLockRelease(&debugMemoryLock);
 }
 #else
 
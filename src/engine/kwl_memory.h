@@ -26,6 +26,7 @@ freely, subject to the following restrictions:
 
 /*! \file */ 
 
+#include "kowalski.h"
 #include <stdio.h>
 
 #ifdef __cplusplus
@@ -33,71 +34,155 @@ extern "C"
 {
 #endif /* __cplusplus */
 
+/** 
+ * The number of bytes reserved in front of every block allocated by the engine. The 
+ * reserved bytes record the size, category and origin of the block.
+ */
+#define KWL_MEMORY_BLOCK_HEADER_SIZE 16
+
+/** 
+ * The default initial number of buckets in the live allocation hash table of 
+ * debug memory builds. Grows as needed.
+ */
+#define KWL_DEBUG_ALLOCATION_TABLE_INITIAL_SIZE 4096
+
 /** */
 void* kwlMemcpy(void* to, const void* from, size_t size);
 /** */
 void* kwlMemset(void* location, int value, size_t size);
-void* kwlRealloc(void* ptr, size_t size);
-void* kwlMallocAndZero(size_t size);
-void* kwlMalloc(size_t size);
+/** 
+ * Resizes a block allocated by \c kwlMalloc, \c kwlMallocAligned or \c kwlRealloc,
+ * keeping its alignment. Behaves like \c kwlMalloc if \c ptr is NULL.
+ */
+void* kwlRealloc(void* ptr, size_t size, kwlMemoryCategory category);
+void* kwlMallocAndZero(size_t size, kwlMemoryCategory category);
+/** Allocates a block through the current allocator, recording it under a given category.*/
+void* kwlMalloc(size_t size, kwlMemoryCategory category);
+/** Allocates a block aligned to a given power of two number of bytes.*/
+void* kwlMallocAligned(size_t size, size_t alignment, kwlMemoryCategory category);
+/** Frees a block through the allocator it was allocated with.*/
 void kwlFree(void* pointer);
 
+/**
+ * Sets the allocator used for all subsequent engine allocations. NULL restores the
+ * C standard library allocator. Blocks are always freed through the allocator that
+ * allocated them, so this can be called while such blocks are live, except to replace
+ * one host allocator with another while blocks allocated by the first are still live.
+ * @return \c KWL_INVALID_PARAMETER_VALUE if a required callback is missing or the 
+ * allocator cannot be replaced, \c KWL_NO_ERROR otherwise.
+ */
+kwlError kwlMemory_setAllocator(const kwlAllocator* allocator);
+
+/** Gets the allocation statistics of a given category.*/
+void kwlMemory_getStats(kwlMemoryCategory category, kwlMemoryStats* stats);
+
 
 #ifndef KWL_DEBUG_MEMORY
 
 /**
  * This macro should be used for all memory allocations in the Kowalski Engine.
  * If the symbol KWL_DEBUG_MEMORY is not defined, KWL_MALLOC reduces to a call
- * to malloc. This macro exists both to allow for allocation tracking (if 
- * KWL_DEBUG_MEMORY is defined) and to make it easy to use custom allocators if need be.
- * The tag parameter is a const* char const string identifying the allocation.
+ * to kwlMalloc, which allocates through the allocator passed to 
+ * \c kwlInitializeWithAllocator (or malloc by default). The category parameter 
+ * is a \c kwlMemoryCategory that is passed on to the allocator and used for 
+ * per category statistics. The tag parameter is a const* char const string 
+ * identifying the allocation, used for allocation tracking if KWL_DEBUG_MEMORY 
+ * is defined.
  */
-#define KWL_REALLOC(ptr, size, tag) kwlRealloc(ptr, size)
-#define KWL_MALLOC(size, tag) kwlMalloc(size)
-#define KWL_MALLOCANDZERO(size, tag) kwlMallocAndZero(size)
+#define KWL_REALLOC(ptr, size, category, tag) kwlRealloc(ptr, size, category)
+#define KWL_MALLOC(size, category, tag) kwlMalloc(size, category)
+#define KWL_MALLOCANDZERO(size, category, tag) kwlMallocAndZero(size, category)
+#define KWL_MALLOC_ALIGNED(size, alignment, category, tag) kwlMallocAligned(size, alignment, category)
 /**
  * This macro should be used for all memory deletions in the Kowalski Engine.
  * If the symbol KWL_DEBUG_MEMORY is not defined, KWL_FREE reduces to a call
- * to free.
+ * to kwlFree.
  */
 #define KWL_FREE(ptr) kwlFree(ptr)
 
 
 #else
 
-#define KWL_REALLOC(ptr, size, tag) kwlDebugRealloc(ptr, size, tag)
-#define KWL_MALLOC(size, tag) kwlDebugMalloc(size, tag)
-#define KWL_MALLOCANDZERO(size, tag) kwlDebugMallocAndZero(size, tag)
+/*
+ * In debug memory builds, every allocation is recorded together with its tag
+ * and the source file it was made from. The file name (minus the kwl_ prefix
+ * and extension) is used as the subsystem name in allocation reports.
+ */
+#define KWL_REALLOC(ptr, size, category, tag) kwlDebugRealloc(ptr, size, category, tag, __FILE__)
+#define KWL_MALLOC(size, category, tag) kwlDebugMalloc(size, 0, category, tag, __FILE__)
+#define KWL_MALLOCANDZERO(size, category, tag) kwlDebugMallocAndZero(size, category, tag, __FILE__)
+#define KWL_MALLOC_ALIGNED(size, alignment, category, tag) kwlDebugMalloc(size, alignment, category, tag, __FILE__)
 #define KWL_FREE(ptr) kwlDebugFree(ptr)
-/** The size of the debug allocation tracking table.*/
-#define KWL_DEBUG_ALLOCATION_TABLE_SIZE 16000
-/** The max length of an allocation tag.*/
-#define KWL_DEBUG_ALLOCATION_TAG_SIZE 50
-    
-/** A table of memory locations associated with individual calls to KWL_MALLOC.*/
-void* kwlDebugAllocationAddresses[KWL_DEBUG_ALLOCATION_TABLE_SIZE];
-    
-/** A table of block sizes associated with individual calls to KWL_MALLOC.*/
-int kwlDebugAllocationSizes[KWL_DEBUG_ALLOCATION_TABLE_SIZE];
-    
-/** A table of tags associated with individual calls to KWL_MALLOC.*/
-char kwlDebugAllocationTags[KWL_DEBUG_ALLOCATION_TABLE_SIZE][KWL_DEBUG_ALLOCATION_TAG_SIZE];
-    
-/** Prints all recorded allocations that have not been deleted.*/    
+/** The max length of a subsystem name derived from a source file name.*/
+#define KWL_DEBUG_SUBSYSTEM_NAME_SIZE 32
+
+/** 
+ * Aggregated allocation statistics for a single tag or subsystem. 
+ */
+typedef struct kwlDebugAllocationStats
+{
+    /** The tag or subsystem name.*/
+    const char* name;
+    /** The number of currently allocated bytes.*/
+    size_t liveBytes;
+    /** The highest number of simultaneously allocated bytes seen so far.*/
+    size_t peakBytes;
+    /** The total number of bytes allocated, including freed blocks.*/
+    size_t totalBytes;
+    /** The number of currently allocated blocks.*/
+    int liveCount;
+    /** The highest number of simultaneously allocated blocks seen so far.*/
+    int peakCount;
+    /** The total number of allocated blocks, including freed ones.*/
+    int totalCount;
+} kwlDebugAllocationStats;
+
+/** 
+ * Prints live and peak allocation statistics per subsystem and per tag. 
+ * Tags with no live allocations are omitted from the per tag listing.
+ */    
 void kwlDebugPrintAllocationReport(void);
+
+/** 
+ * Copies the statistics of up to \c maxNumStats tags to \c stats.
+ * @return The total number of tags seen so far.
+ */
+int kwlDebugGetTagStats(kwlDebugAllocationStats* stats, int maxNumStats);
+
+/** 
+ * Copies the statistics of up to \c maxNumStats subsystems to \c stats.
+ * @return The total number of subsystems seen so far.
+ */
+int kwlDebugGetSubsystemStats(kwlDebugAllocationStats* stats, int maxNumStats);
+    
+/** 
+ * Makes sure the live allocation hash table has at least \c minSize buckets,
+ * rehashing the recorded allocations if the table has to grow. Does nothing
+ * if \c minSize is not positive.
+ */
+void kwlDebugSetMinAllocationTableSize(int minSize);
     
 /** Returns the number of currently allocated bytes.*/    
 int kwlDebugGetLiveBytes(void);
+
+/** Returns the highest number of simultaneously allocated bytes in this run.*/    
+int kwlDebugGetPeakBytes(void);
     
 /** Returns the total number of bytes allocated in this run, including freed blocks.*/    
 int kwlDebugGetTotalBytes(void);
 
-void* kwlDebugMallocAndZero(size_t size, const char* const tag);
+void* kwlDebugMallocAndZero(size_t size, kwlMemoryCategory category, const char* const tag, const char* const file);
 
-void* kwlDebugRealloc(void* ptr, size_t size, const char* const tag);
+void* kwlDebugRealloc(void* ptr, size_t size, kwlMemoryCategory category, const char* const tag, const char* const file);
     
-/** Allocates a block of memory and records the allocation. */
-void* kwlDebugMalloc(size_t size, const char* const tag);
+/** 
+ * Allocates a block of memory through \c kwlMalloc, or \c kwlMallocAligned if 
+ * \c alignment is non-zero, and records the allocation. \c tag and \c file 
+ * are not copied and must outlive the allocation, which string literals and
+ * __FILE__ do. Safe to call from any thread once the first tracked allocation
+ * has been made.
+ */
+void* kwlDebugMalloc(size_t size, size_t alignment, kwlMemoryCategory category, const char* const tag, const char* const file);
     
 /** Deletes a block of memory and records the deletion. Also checks for double deletes. */
 void kwlDebugFree(void* pointer);
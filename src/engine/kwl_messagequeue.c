@@ -24,10 +24,10 @@ freely, subject to the following restrictions:
 #include <string.h>
 #include "kwl_messagequeue.h"
 
-void kwlMessageQueue_init(kwlMessageQueue* queue)
+void kwlMessageQueue_init(kwlMessageQueue* queue, int maxQueueSize)
 {
-    queue->messages = (kwlMessage*)KWL_MALLOC(KWL_MESSAGE_QUEUE_SIZE * sizeof(kwlMessage), "message queue");
-    queue->maxQueueSize = KWL_MESSAGE_QUEUE_SIZE;
+    queue->messages = (kwlMessage*)KWL_MALLOC(maxQueueSize * sizeof(kwlMessage), KWL_MEMORY_CATEGORY_MIXER, "message queue");
+    queue->maxQueueSize = maxQueueSize;
     queue->numMessages = 0;
 }
 
@@ -60,6 +60,12 @@ int kwlMessageQueue_addMessage(kwlMessageQueue* queue, kwlMessageType type, void
 }
 
 int kwlMessageQueue_addMessageWithParam(kwlMessageQueue* queue, kwlMessageType type, void* data, float param)
+{
+    return kwlMessageQueue_addMessageWithParamAtFrame(queue, type, data, param, 0);
+}
+
+int kwlMessageQueue_addMessageWithParamAtFrame(kwlMessageQueue* queue, kwlMessageType type, 
+                                               void* data, float param, long long frame)
 {
     if (queue->numMessages >= queue->maxQueueSize)
     {
@@ -70,6 +76,7 @@ int kwlMessageQueue_addMessageWithParam(kwlMessageQueue* queue, kwlMessageType t
     queue->messages[queue->numMessages].type = type;
     queue->messages[queue->numMessages].data = data;
     queue->messages[queue->numMessages].param = param;
+    queue->messages[queue->numMessages].frame = frame;
     queue->numMessages++;
     return 1;
 }
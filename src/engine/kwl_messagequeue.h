@@ -35,7 +35,7 @@ extern "C"
 #endif /* __cplusplus */
 
 /** 
- * The size of the message queues used for sending messages
+ * The default size of the message queues used for sending messages
  * between the engine and mixer threads.
  */
 #define KWL_MESSAGE_QUEUE_SIZE 500
@@ -72,7 +72,11 @@ typedef enum
     /** Sent from the mixer to the engine thread indicating that it's safe to unload engine data.*/
     KWL_UNLOAD_ENGINE_DATA,
     /** Sent from the engine to notify the mixer that a new mix bus hierarchy has been loaded.*/
-    KWL_SET_MASTER_BUS
+    KWL_SET_MASTER_BUS,
+    /** Sent from the engine to the mixer, requesting it to switch over to reloaded engine data.*/
+    KWL_SWAP_ENGINE_DATA,
+    /** Sent from the mixer to the engine once it no longer references the engine data replaced by a reload.*/
+    KWL_ENGINE_DATA_SWAPPED
      
 } kwlMessageType;
 
@@ -87,6 +91,11 @@ typedef struct
     void* data;
     /** An optional parameter assocaited with the message.*/
     float param;
+    /** 
+     * The mixer frame at which the message should take effect. Messages with a 
+     * frame that has already been mixed take effect immediately.
+     */
+    long long frame;
 } kwlMessage;
 
 /**
@@ -106,8 +115,9 @@ typedef struct
 /**
  * Initializes a message queue.
  * @param The queue to initialize.
+ * @param maxQueueSize The maximum number of messages the queue holds.
  */
-void kwlMessageQueue_init(kwlMessageQueue* queue);
+void kwlMessageQueue_init(kwlMessageQueue* queue, int maxQueueSize);
     
 void kwlMessageQueue_free(kwlMessageQueue* queue);
 
@@ -128,6 +138,18 @@ void kwlMessageQueue_flushTo(kwlMessageQueue* srcQueue, kwlMessageQueue* destQue
 int kwlMessageQueue_addMessage(kwlMessageQueue* queue, kwlMessageType type, void* data);
     
 int kwlMessageQueue_addMessageWithParam(kwlMessageQueue* queue, kwlMessageType type, void* data, float param);
+
+/** 
+ * Adds a message to a given queue that should take effect at a given mixer frame.
+ * @param queue The queue to add the message to.
+ * @param type The type of the message to add.
+ * @param data The data to associated with the added message.
+ * @param param The parameter to associate with the added message.
+ * @param frame The mixer frame at which the message should take effect.
+ * @return A non zero integer if the message was successfully added or zero if the target queue is full.
+ */
+int kwlMessageQueue_addMessageWithParamAtFrame(kwlMessageQueue* queue, kwlMessageType type, 
+                                               void* data, float param, long long frame);
     
 #ifdef __cplusplus
 }
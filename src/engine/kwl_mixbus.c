@@ -29,7 +29,7 @@ freely, subject to the following restrictions:
 
 kwlMixBus* kwlMixBus_alloc()
 {
-    kwlMixBus* newMixBus = (kwlMixBus*)KWL_MALLOC(sizeof(kwlMixBus), "kwlMixBus_alloc");
+    kwlMixBus* newMixBus = (kwlMixBus*)KWL_MALLOC(sizeof(kwlMixBus), KWL_MEMORY_CATEGORY_MIXER, "kwlMixBus_alloc");
     kwlMemset(newMixBus, 0, sizeof(kwlMixBus));
     kwlMixBus_init(newMixBus);
     return newMixBus;
@@ -194,7 +194,8 @@ void kwlMixBus_render(kwlMixBus* mixBus,
                                                    eventScratchBuffer, 
                                                    numOutChannels,
                                                    numFrames,
-                                                   accumulatedPitch);
+                                                   accumulatedPitch,
+                                                   mixer->sampleRate);
                 
         /*mix event temp buffer into mixbus temp buffer*/
         kwlMixFloatBuffer(eventScratchBuffer, 
@@ -34,14 +34,15 @@ freely, subject to the following restrictions:
 #include "kwl_assert.h"
 #include <math.h>
 
-kwlMixer* kwlMixer_new(void)
+kwlMixer* kwlMixer_new(int messageQueueSize)
 {
-    kwlMixer* newMixer = (kwlMixer*)KWL_MALLOC(sizeof(kwlMixer), "kwlMixer_new");
+    kwlMixer* newMixer = (kwlMixer*)KWL_MALLOC(sizeof(kwlMixer), KWL_MEMORY_CATEGORY_MIXER, "kwlMixer_new");
     kwlMemset(newMixer, 0, sizeof(kwlMixer));
     
-    kwlMessageQueue_init(&newMixer->toEngineQueue);
-    kwlMessageQueue_init(&newMixer->toEngineQueueShared);
-    kwlMessageQueue_init(&newMixer->fromEngineQueue);
+    kwlMessageQueue_init(&newMixer->toEngineQueue, messageQueueSize);
+    kwlMessageQueue_init(&newMixer->toEngineQueueShared, messageQueueSize);
+    kwlMessageQueue_init(&newMixer->toEngineQueueAfterRender, messageQueueSize);
+    kwlMessageQueue_init(&newMixer->fromEngineQueue, messageQueueSize);
 
     kwlMixBus_init(&newMixer->freeformEventsBus);
     newMixer->freeformEventsBus.id = "freeform event bus";
@@ -52,16 +53,17 @@ kwlMixer* kwlMixer_new(void)
     return newMixer;
 }
 
-void kwlMixer_allocateTempBuffers(kwlMixer* mixer)
+void kwlMixer_allocateTempBuffers(kwlMixer* mixer, int numFrames)
 {
-    int tempBufferSize = sizeof(float) * KWL_TEMP_BUFFER_SIZE_IN_FRAMES * mixer->numOutChannels;
-    mixer->tempMixBusBuffer = (float*)KWL_MALLOC(tempBufferSize, "mixer temp buffer");
-    mixer->tempEventBuffer = (float*)KWL_MALLOC(tempBufferSize, "mixer temp buffer");
-    mixer->outBuffer = (float*)KWL_MALLOC(tempBufferSize, "mixer temp out buffer");
+    mixer->tempBufferSizeInFrames = numFrames;
+    int tempBufferSize = sizeof(float) * numFrames * mixer->numOutChannels;
+    mixer->tempMixBusBuffer = (float*)KWL_MALLOC(tempBufferSize, KWL_MEMORY_CATEGORY_MIXER, "mixer temp buffer");
+    mixer->tempEventBuffer = (float*)KWL_MALLOC(tempBufferSize, KWL_MEMORY_CATEGORY_MIXER, "mixer temp buffer");
+    mixer->outBuffer = (float*)KWL_MALLOC(tempBufferSize, KWL_MEMORY_CATEGORY_MIXER, "mixer temp out buffer");
     
     if (mixer->numInChannels > 0)
     {
-        mixer->inBuffer = (float*)KWL_MALLOC(tempBufferSize, "mixer temp in buffer");
+        mixer->inBuffer = (float*)KWL_MALLOC(tempBufferSize, KWL_MEMORY_CATEGORY_MIXER, "mixer temp in buffer");
     }
 }
 
@@ -74,6 +76,7 @@ void kwlMixer_free(kwlMixer* mixer)
     
     kwlMessageQueue_free(&mixer->toEngineQueue);
     kwlMessageQueue_free(&mixer->toEngineQueueShared);
+    kwlMessageQueue_free(&mixer->toEngineQueueAfterRender);
     kwlMessageQueue_free(&mixer->fromEngineQueue);
     
     if (mixer->numInChannels > 0)
@@ -119,6 +122,13 @@ void kwlMixer_updateOutput(kwlMixer* const mixer)
         /*copy buffered outgoing*/
         kwlMessageQueue_flushTo(&mixer->toEngineQueue, &mixer->toEngineQueueShared);
         
+        /*wake up the engine thread if it is waiting for an unload to be acknowledged*/
+        if (mixer->isEngineWaitingForMessages != 0 && mixer->toEngineQueueShared.numMessages > 0)
+        {
+            mixer->isEngineWaitingForMessages = 0;
+            kwlSemaphorePost(mixer->mixerMessageSemaphore);
+        }
+        
         /*update data driven mix buses and events*/
         int i;
         for (i = 0; i < mixer->numMixBuses; i++)
@@ -247,6 +257,12 @@ void kwlMixer_processMessages(kwlMixer* const mixer)
                 event->playbackState = KWL_STOP_REQUESTED;
             }
             
+            /* delay the start if it is scheduled for a frame beyond the start of this buffer */
+            if (message->frame > mixer->numFramesMixed.valueMixer)
+            {
+                event->startDelayInFrames = message->frame - mixer->numFramesMixed.valueMixer;
+            }
+            
             /*add the event to its bus.*/
             if (retrigger == 0)
             {
@@ -267,35 +283,18 @@ void kwlMixer_processMessages(kwlMixer* const mixer)
             KWL_ASSERT(messageData != NULL);
             kwlEventInstance* event = (kwlEventInstance*)message->data;
             float fadeOutTime = message->param;
-            if (event->isPaused)
+            float fadeGainIncrPerFrame = fadeOutTime > 0.0f ? -1.0f / (fadeOutTime * mixer->sampleRate) : 0.0f;
+            if (message->frame > mixer->numFramesMixed.valueMixer)
             {
-                /*Always stop paused events immediately.*/
-                event->playbackState = KWL_STOP_REQUESTED;
-            }
-            else if (fadeOutTime > 0.0f)
-            {
-                /*Start the fade out. The event will get removed from the mixer when
-                  the fade gain reaches 0.*/
-                event->fadeGainIncrPerFrame = -1.0f / (fadeOutTime * mixer->sampleRate);
-            }
-            else if (event->definition_mixer->sound != NULL)
-            {
-                if (event->definition_mixer->sound->playbackMode == KWL_IN_RANDOM_OUT ||
-                    event->definition_mixer->sound->playbackMode == KWL_IN_RANDOM_NO_REPEAT_OUT ||
-                    event->definition_mixer->sound->playbackMode == KWL_IN_SEQUENTIAL_OUT)
-                {
-                    event->playbackState = KWL_PLAY_LAST_BUFFER_AND_STOP_REQUESTED;
-                }
-                else
-                {
-                    event->playbackState = KWL_STOP_REQUESTED;
-                }
+                /*The stop is scheduled for a frame beyond the start of this buffer. 
+                  It takes effect when the event is rendered.*/
+                event->stopDelayInFrames = message->frame - mixer->numFramesMixed.valueMixer;
+                event->scheduledStopFadeGainIncrPerFrame = fadeGainIncrPerFrame;
             }
             else
             {
-                event->playbackState = KWL_STOP_REQUESTED;
+                kwlEventInstance_stop(event, fadeGainIncrPerFrame);
             }
-            
         }
         else if (type == KWL_EVENT_PAUSE)
         {
@@ -318,9 +317,9 @@ void kwlMixer_processMessages(kwlMixer* const mixer)
             kwlWaveBank* waveBank = (kwlWaveBank*)message->data;
             kwlMixer_stopAllEventsReferencingWaveBank(mixer, waveBank);
             /*printf("stopped all events referencing %s\n", waveBank->id);*/
-            /* Send a message to the engine thread indicating that it's safe to unload the wave bank.
-               IMPORTANT NOTE: This relies on kwlMixer_updateOutput being called BEFORE kwlMixer_processMessages*/
-            int result = kwlMessageQueue_addMessage(&mixer->toEngineQueue, KWL_UNLOAD_WAVEBANK, waveBank);
+            /* Send a message to the engine thread indicating that it's safe to unload the wave bank
+               once the events have been stopped by rendering the current buffer.*/
+            int result = kwlMessageQueue_addMessage(&mixer->toEngineQueueAfterRender, KWL_UNLOAD_WAVEBANK, waveBank);
             KWL_ASSERT(result == 1 && "mixer: outgoing message queue exhausted ");
         }
         else if (type == KWL_SET_MASTER_BUS)
@@ -329,6 +328,10 @@ void kwlMixer_processMessages(kwlMixer* const mixer)
             int numBuses = (int)message->param;
             kwlMixer_setMixBusArray(mixer, newBusArray, numBuses);
         }
+        else if (type == KWL_SWAP_ENGINE_DATA)
+        {
+            kwlMixer_swapEngineData(mixer, (kwlEngineDataSwap*)message->data);
+        }
         else
         {
             KWL_ASSERT(NULL && "unknown message type");
@@ -438,6 +441,42 @@ void kwlMixer_setMixBusArray(kwlMixer* mixer, kwlMixBus* buses, int numBuses)
     mixer->mixBuses = buses;
 }
 
+void kwlMixer_swapEngineData(kwlMixer* mixer, kwlEngineDataSwap* swap)
+{
+    /*hand the playing events of the previous engine data over to their new instances, which 
+      continue from the same buffer position in the bus of the new event definition.*/
+    int busIndex;
+    for (busIndex = 0; busIndex < mixer->numMixBuses; busIndex++)
+    {
+        kwlEventInstance* event = mixer->mixBuses[busIndex].eventList;
+        while (event != NULL)
+        {
+            kwlEventInstance* nextEvent = event->nextEvent_mixer;
+            const int instanceIndex = (int)(event - swap->previousEventInstances);
+            KWL_ASSERT(instanceIndex >= 0 && instanceIndex < swap->numPreviousEventInstances);
+            kwlEventInstance* newEvent = swap->eventInstanceMap[instanceIndex];
+            if (newEvent != NULL)
+            {
+                kwlEventInstance_copyMixerState(newEvent, event);
+                kwlMixBus_addEvent(newEvent->definition_mixer->mixBus, newEvent);
+            }
+            else
+            {
+                kwlMixer_sendEventStoppedMessage(mixer, event);
+            }
+            event->nextEvent_mixer = NULL;
+            event = nextEvent;
+        }
+        mixer->mixBuses[busIndex].eventList = NULL;
+    }
+    
+    kwlMixer_resetMixBuses(mixer);
+    kwlMixer_setMixBusArray(mixer, swap->mixBuses, swap->numMixBuses);
+    
+    int result = kwlMessageQueue_addMessage(&mixer->toEngineQueue, KWL_ENGINE_DATA_SWAPPED, swap);
+    KWL_ASSERT(result == 1 && "mixer: outgoing message queue exhausted ");
+}
+
 void kwlMixer_resetMixBuses(kwlMixer* mixer)
 {
     /*Reset any data driven mix buses in preparation for engine data unloading.*/
@@ -529,6 +568,9 @@ void kwlMixer_render(kwlMixer* mixer,
         KWL_ASSERT(result == 1 && "mixer: outgoing message queue exhausted ");
     }
     
+    /*send messages that must reach the engine after the stop messages of this buffer.*/
+    kwlMessageQueue_flushTo(&mixer->toEngineQueueAfterRender, &mixer->toEngineQueue);
+    
     /*pass the filled buffer through the master dsp unit, if any*/
     kwlDSPUnit* dspUnit = (kwlDSPUnit*)mixer->outputDSPUnit.valueMixer;
     if (dspUnit != NULL)
@@ -36,7 +36,7 @@ extern "C"
 {
 #endif /* __cplusplus */
     
-    /*Ideally, the temp buffers should be bigger than the output buffers.*/
+    /*The default size of the temp buffers. Ideally, the temp buffers should be bigger than the output buffers.*/
 #define KWL_TEMP_BUFFER_SIZE_IN_FRAMES 1024
     
     /*forward declarations*/
@@ -49,6 +49,28 @@ extern "C"
     static const float PITCH_EPSILON = 0.001f;
     
     
+    /** 
+     * Describes how the mixer switches from the mix buses and event instances of engine data 
+     * being replaced to those of reloaded engine data. Passed with \c KWL_SWAP_ENGINE_DATA.
+     */
+    typedef struct kwlEngineDataSwap
+    {
+        /** The mix buses of the reloaded engine data.*/
+        kwlMixBus* mixBuses;
+        /** The number of mix buses in \c mixBuses.*/
+        int numMixBuses;
+        /** The event instances of the engine data being replaced.*/
+        struct kwlEventInstance* previousEventInstances;
+        /** The number of event instances in \c previousEventInstances.*/
+        int numPreviousEventInstances;
+        /** 
+         * The instance of the reloaded engine data taking over from each instance in 
+         * \c previousEventInstances, or NULL if its event definition was removed or changed 
+         * in a way that prevents it from playing on.
+         */
+        struct kwlEventInstance** eventInstanceMap;
+    } kwlEngineDataSwap;
+    
     /** A struct encapsulating the */
     typedef struct kwlMixer
     {
@@ -104,6 +126,12 @@ extern "C"
          * must be called proior to any manipulation to protect the data.
          */
         kwlMessageQueue toEngineQueueShared;
+        /** 
+         * Outgoing messages that are moved to \c toEngineQueue once the current buffer has been rendered,
+         * so that they reach the engine thread after the stop messages of events stopped in that buffer.
+         * This queue is exclusive to the mixer thread.
+         */
+        kwlMessageQueue toEngineQueueAfterRender;
         
         
         
@@ -121,15 +149,25 @@ extern "C"
         float* outBuffer;
         /** A temporary buffer to mix the output of events into.*/
         float* tempEventBuffer;
+        /** The number of frames the temporary buffers hold, i.e the maximum number of frames to render at a time.*/
+        int tempBufferSizeInFrames;
         /** A temporary buffer to mix the output of mix buses into.*/
         float* tempMixBusBuffer;
         /** Non-zero if the mix bus hierarchy should be reset, zero otherwise.*/
         int resetMixBusesRequested;
         /** */
         kwlMutexLock* mixerEngineMutexLock;
+        /** 
+         * Non-zero if the engine thread is waiting for \c mixerMessageSemaphore to be posted.
+         * Only accessed with the mixer engine lock held.
+         */
+        int isEngineWaitingForMessages;
+        /** Posted when messages are passed to the engine thread while \c isEngineWaitingForMessages is non-zero.*/
+        kwlSemaphore* mixerMessageSemaphore;
     } kwlMixer;
     
-    kwlMixer* kwlMixer_new(void);
+    /** Creates a mixer whose message queues hold a given number of messages.*/
+    kwlMixer* kwlMixer_new(int messageQueueSize);
     
     void kwlMixer_free(kwlMixer* mixer);
     
@@ -145,11 +183,18 @@ extern "C"
     void kwlMixer_setMixBusArray(kwlMixer* mixer, kwlMixBus* buses, int numBuses);
     /** */
     void kwlMixer_resetMixBuses(kwlMixer* mixer);
+    /** 
+     * Moves the playing data driven events over to the matching instances of reloaded engine data,
+     * stops the events that have no match and replaces the mix bus array. Acknowledged with a
+     * \c KWL_ENGINE_DATA_SWAPPED message to the engine, after which the previous engine data may be freed.
+     */
+    void kwlMixer_swapEngineData(kwlMixer* mixer, kwlEngineDataSwap* swap);
     /** Processes any enqueued incoming messages from the engine thread. */
     void kwlMixer_processMessages(kwlMixer* mixer);
     void kwlMixer_updateOutput(kwlMixer* mixer);
     void kwlMixer_updateInput(kwlMixer* mixer);
-    void kwlMixer_allocateTempBuffers(kwlMixer* mixer);
+    /** Allocates temporary buffers for rendering up to a given number of frames at a time.*/
+    void kwlMixer_allocateTempBuffers(kwlMixer* mixer, int numFrames);
     
     /**
      * Performs mixing into an output buffer of a given size.
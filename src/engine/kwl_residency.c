@@ -0,0 +1,409 @@
+/*
+ Copyright (c) 2010-2012 Per Gantelius
+
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any damages
+ arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it
+ freely, subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented; you must not
+ claim that you wrote the original software. If you use this software
+ in a product, an acknowledgment in the product documentation would be
+ appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such, and must not be
+ misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#include "kwl_assert.h"
+#include "kwl_eventdefinition.h"
+#include "kwl_eventinstance.h"
+#include "kwl_memory.h"
+#include "kwl_residency.h"
+#include "kwl_sounddefinition.h"
+#include "kwl_wavebank.h"
+
+void kwlResidency_init(kwlResidency* residency)
+{
+    kwlMemset(residency, 0, sizeof(kwlResidency));
+    residency->maxStartWaitTimeSec = KWL_DEFAULT_RESIDENCY_MAX_START_WAIT_TIME;
+}
+
+int kwlResidency_isManaged(kwlAudioData* audioData)
+{
+    return audioData->waveBank != NULL &&
+           audioData->waveBank->loadOnDemand != 0 &&
+           audioData->isLoaded != 0 &&
+           audioData->streamFromDisk == 0;
+}
+
+/** Removes audio data from the list of loading audio data or from the list of resident audio data.*/
+static void kwlResidency_unlink(kwlResidency* residency, kwlAudioData* audioData)
+{
+    if (audioData->residencyPrev != NULL)
+    {
+        audioData->residencyPrev->residencyNext = audioData->residencyNext;
+    }
+    else if (residency->loadingList == audioData)
+    {
+        residency->loadingList = audioData->residencyNext;
+    }
+    else
+    {
+        KWL_ASSERT(residency->mostRecentlyUsed == audioData);
+        residency->mostRecentlyUsed = audioData->residencyNext;
+    }
+    
+    if (audioData->residencyNext != NULL)
+    {
+        audioData->residencyNext->residencyPrev = audioData->residencyPrev;
+    }
+    else if (residency->leastRecentlyUsed == audioData)
+    {
+        residency->leastRecentlyUsed = audioData->residencyPrev;
+    }
+    
+    audioData->residencyPrev = NULL;
+    audioData->residencyNext = NULL;
+}
+
+/** Inserts resident audio data first in the list of resident audio data.*/
+static void kwlResidency_linkMostRecentlyUsed(kwlResidency* residency, kwlAudioData* audioData)
+{
+    audioData->residencyPrev = NULL;
+    audioData->residencyNext = residency->mostRecentlyUsed;
+    if (residency->mostRecentlyUsed != NULL)
+    {
+        residency->mostRecentlyUsed->residencyPrev = audioData;
+    }
+    else
+    {
+        residency->leastRecentlyUsed = audioData;
+    }
+    residency->mostRecentlyUsed = audioData;
+}
+
+/** Marks the audio data used by all playing events with a new eviction pass.*/
+static void kwlResidency_markPlayingEvents(kwlResidency* residency, kwlEventInstance* playingEvents)
+{
+    residency->usePass++;
+    
+    kwlEventInstance* event = playingEvents;
+    while (event != NULL)
+    {
+        kwlAudioData** audioData = NULL;
+        int numAudioData = 0;
+        kwlEventDefinition_getAudioData(event->definition_engine, &audioData, &numAudioData);
+        for (int i = 0; i < numAudioData; i++)
+        {
+            audioData[i]->residencyUsePass = residency->usePass;
+        }
+        event = event->nextEvent_engine;
+    }
+}
+
+/** 
+ * Evicts least recently used audio data that is not marked with the current eviction pass 
+ * until a given number of additional bytes fits within the budget, if possible. The most
+ * recently used audio data is kept, so that a prefetched item larger than the budget
+ * survives until its event starts.
+ */
+static void kwlResidency_evict(kwlResidency* residency, int numBytesToAdd)
+{
+    if (residency->budget <= 0)
+    {
+        return;
+    }
+    
+    kwlAudioData* candidate = residency->leastRecentlyUsed;
+    while (candidate != NULL &&
+           candidate != residency->mostRecentlyUsed &&
+           residency->stats.numResidentBytes + numBytesToAdd > residency->budget)
+    {
+        kwlAudioData* moreRecentlyUsed = candidate->residencyPrev;
+        if (candidate->residencyUsePass != residency->usePass)
+        {
+            kwlResidency_unlink(residency, candidate);
+            /*No decoders are using the audio data, since no playing event uses it.*/
+            if (candidate->sharedDecoderData != NULL)
+            {
+                kwlSharedDecoderData_release(candidate->sharedDecoderData);
+                candidate->sharedDecoderData = NULL;
+            }
+            /*Other wave banks or events may still hold the buffer.*/
+            kwlSharedAudioBuffer_release(candidate->sharedBuffer);
+            candidate->sharedBuffer = NULL;
+            candidate->bytes = NULL;
+            candidate->residencyState = KWL_NOT_RESIDENT;
+            residency->stats.numResidentBytes -= candidate->numBytes;
+            residency->stats.numResidentItems--;
+            residency->stats.numEvictions++;
+        }
+        candidate = moreRecentlyUsed;
+    }
+}
+
+/** Frees the load of a given piece of audio data and makes the audio data available if all bytes were read.*/
+static void kwlResidency_completeLoad(kwlResidency* residency, kwlAudioData* audioData)
+{
+    kwlStreamingIOLoad* load = audioData->residencyLoad;
+    kwlResidency_unlink(residency, audioData);
+    audioData->residencyLoad = NULL;
+    
+    if (load->hasFailed == 0)
+    {
+        audioData->sharedBuffer = kwlAudioDataCache_addBuffer(audioData->waveBank->audioDataCache,
+                                                              audioData->contentHash,
+                                                              audioData->numBytes,
+                                                              load->destination);
+        audioData->bytes = audioData->sharedBuffer->bytes;
+        audioData->residencyState = KWL_RESIDENT;
+        kwlResidency_linkMostRecentlyUsed(residency, audioData);
+        residency->stats.numBytesLoaded += audioData->numBytes;
+    }
+    else
+    {
+        KWL_FREE(load->destination);
+        audioData->residencyState = KWL_NOT_RESIDENT;
+        residency->stats.numResidentBytes -= audioData->numBytes;
+        residency->stats.numResidentItems--;
+        residency->stats.numFailedLoads++;
+    }
+    
+    KWL_FREE(load);
+}
+
+/** Cancels the load of a given piece of audio data and frees its buffer.*/
+static void kwlResidency_cancelLoad(kwlResidency* residency, kwlStreamingIO* streamingIO, kwlAudioData* audioData)
+{
+    kwlStreamingIOLoad* load = audioData->residencyLoad;
+    kwlStreamingIO_cancelLoad(streamingIO, load);
+    kwlResidency_unlink(residency, audioData);
+    audioData->residencyLoad = NULL;
+    audioData->residencyState = KWL_NOT_RESIDENT;
+    residency->stats.numResidentBytes -= audioData->numBytes;
+    residency->stats.numResidentItems--;
+    KWL_FREE(load->destination);
+    KWL_FREE(load);
+}
+
+int kwlResidency_requestEvent(kwlResidency* residency,
+                              kwlStreamingIO* streamingIO,
+                              kwlEventDefinition* eventDefinition,
+                              kwlEventInstance* playingEvents,
+                              int isPrefetch)
+{
+    kwlAudioData** audioData = NULL;
+    int numAudioData = 0;
+    kwlEventDefinition_getAudioData(eventDefinition, &audioData, &numAudioData);
+    
+    /*Mark the audio data of this event as used, so it does not evict itself.*/
+    kwlResidency_markPlayingEvents(residency, playingEvents);
+    for (int i = 0; i < numAudioData; i++)
+    {
+        audioData[i]->residencyUsePass = residency->usePass;
+    }
+    
+    int isResident = 1;
+    for (int i = 0; i < numAudioData; i++)
+    {
+        kwlAudioData* item = audioData[i];
+        if (kwlResidency_isManaged(item) == 0)
+        {
+            continue;
+        }
+        
+        if (item->residencyState == KWL_RESIDENT)
+        {
+            if (isPrefetch == 0)
+            {
+                residency->stats.numHits++;
+            }
+            kwlResidency_unlink(residency, item);
+            kwlResidency_linkMostRecentlyUsed(residency, item);
+            continue;
+        }
+        
+        if (item->residencyState == KWL_NOT_RESIDENT)
+        {
+            /*Use the audio data of another loaded wave bank with the same content, if any.*/
+            kwlSharedAudioBuffer* sharedBuffer = kwlAudioDataCache_findBuffer(item->waveBank->audioDataCache,
+                                                                              item->contentHash,
+                                                                              item->numBytes);
+            if (sharedBuffer != NULL)
+            {
+                if (isPrefetch == 0)
+                {
+                    residency->stats.numHits++;
+                }
+                kwlResidency_evict(residency, item->numBytes);
+                item->sharedBuffer = sharedBuffer;
+                item->bytes = sharedBuffer->bytes;
+                item->residencyState = KWL_RESIDENT;
+                kwlResidency_linkMostRecentlyUsed(residency, item);
+                residency->stats.numResidentBytes += item->numBytes;
+                residency->stats.numResidentItems++;
+                continue;
+            }
+        }
+        
+        isResident = 0;
+        if (item->residencyState == KWL_LOADING)
+        {
+            continue;
+        }
+        
+        if (isPrefetch == 0)
+        {
+            residency->stats.numMisses++;
+        }
+        else
+        {
+            residency->stats.numPrefetches++;
+        }
+        
+        kwlResidency_evict(residency, item->numBytes);
+        
+        kwlStreamingIOLoad* load = (kwlStreamingIOLoad*)KWL_MALLOC(sizeof(kwlStreamingIOLoad), KWL_MEMORY_CATEGORY_STREAMING, "residency load");
+        signed char* destination = (signed char*)KWL_MALLOC(item->numBytes, KWL_MEMORY_CATEGORY_AUDIO_DATA, "resident audio data");
+        kwlStreamingIO_startLoad(streamingIO, 
+                                 load, 
+                                 item->waveBank->streamingFile, 
+                                 item->fileOffset, 
+                                 item->numBytes, 
+                                 destination);
+        item->residencyLoad = load;
+        item->residencyState = KWL_LOADING;
+        
+        item->residencyPrev = NULL;
+        item->residencyNext = residency->loadingList;
+        if (residency->loadingList != NULL)
+        {
+            residency->loadingList->residencyPrev = item;
+        }
+        residency->loadingList = item;
+        
+        residency->stats.numResidentBytes += item->numBytes;
+        residency->stats.numResidentItems++;
+    }
+    
+    return isResident;
+}
+
+int kwlResidency_waitForEvent(kwlResidency* residency,
+                              kwlStreamingIO* streamingIO,
+                              kwlEventDefinition* eventDefinition,
+                              float maxWaitTimeSec)
+{
+    kwlAudioData** audioData = NULL;
+    int numAudioData = 0;
+    kwlEventDefinition_getAudioData(eventDefinition, &audioData, &numAudioData);
+    
+    const double deadline = kwlStreamingIO_getTimeSec() + maxWaitTimeSec;
+    for (int i = 0; i < numAudioData; i++)
+    {
+        kwlAudioData* item = audioData[i];
+        if (item->residencyState != KWL_LOADING)
+        {
+            continue;
+        }
+        
+        double timeLeft = deadline - kwlStreamingIO_getTimeSec();
+        if (timeLeft < 0.0)
+        {
+            timeLeft = 0.0;
+        }
+        
+        if (kwlStreamingIO_finishLoad(streamingIO, item->residencyLoad, (float)timeLeft) != 0)
+        {
+            kwlResidency_completeLoad(residency, item);
+        }
+    }
+    
+    return kwlResidency_isEventResident(eventDefinition);
+}
+
+int kwlResidency_isEventResident(kwlEventDefinition* eventDefinition)
+{
+    kwlAudioData** audioData = NULL;
+    int numAudioData = 0;
+    kwlEventDefinition_getAudioData(eventDefinition, &audioData, &numAudioData);
+    
+    for (int i = 0; i < numAudioData; i++)
+    {
+        if (kwlResidency_isManaged(audioData[i]) != 0 &&
+            audioData[i]->residencyState != KWL_RESIDENT)
+        {
+            return 0;
+        }
+    }
+    
+    return 1;
+}
+
+int kwlResidency_isEventLoading(kwlEventDefinition* eventDefinition)
+{
+    kwlAudioData** audioData = NULL;
+    int numAudioData = 0;
+    kwlEventDefinition_getAudioData(eventDefinition, &audioData, &numAudioData);
+    
+    for (int i = 0; i < numAudioData; i++)
+    {
+        if (audioData[i]->residencyState == KWL_LOADING)
+        {
+            return 1;
+        }
+    }
+    
+    return 0;
+}
+
+void kwlResidency_update(kwlResidency* residency,
+                         kwlStreamingIO* streamingIO,
+                         kwlEventInstance* playingEvents)
+{
+    kwlAudioData* item = residency->loadingList;
+    while (item != NULL)
+    {
+        kwlAudioData* next = item->residencyNext;
+        if (kwlStreamingIO_finishLoad(streamingIO, item->residencyLoad, 0.0f) != 0)
+        {
+            kwlResidency_completeLoad(residency, item);
+        }
+        item = next;
+    }
+    
+    if (residency->budget > 0 && residency->stats.numResidentBytes > residency->budget)
+    {
+        kwlResidency_markPlayingEvents(residency, playingEvents);
+        kwlResidency_evict(residency, 0);
+    }
+}
+
+void kwlResidency_releaseWaveBank(kwlResidency* residency,
+                                  kwlStreamingIO* streamingIO,
+                                  kwlWaveBank* waveBank)
+{
+    for (int i = 0; i < waveBank->numAudioDataEntries; i++)
+    {
+        kwlAudioData* item = &waveBank->audioDataItems[i];
+        if (item->residencyState == KWL_LOADING)
+        {
+            kwlResidency_cancelLoad(residency, streamingIO, item);
+        }
+        else if (item->residencyState == KWL_RESIDENT)
+        {
+            kwlResidency_unlink(residency, item);
+            item->residencyState = KWL_NOT_RESIDENT;
+            residency->stats.numResidentBytes -= item->numBytes;
+            residency->stats.numResidentItems--;
+        }
+    }
+}
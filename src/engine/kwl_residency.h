@@ -0,0 +1,143 @@
+/*
+ Copyright (c) 2010-2012 Per Gantelius
+
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any damages
+ arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it
+ freely, subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented; you must not
+ claim that you wrote the original software. If you use this software
+ in a product, an acknowledgment in the product documentation would be
+ appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such, and must not be
+ misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#ifndef KWL_RESIDENCY_H
+#define KWL_RESIDENCY_H
+
+/*! \file */
+
+#include "kowalski.h"
+#include "kwl_audiodata.h"
+#include "kwl_streamingio.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+struct kwlEventInstance;
+struct kwlEventDefinition;
+
+/** The default maximum time in seconds an event start waits for audio data loaded on demand.*/
+#define KWL_DEFAULT_RESIDENCY_MAX_START_WAIT_TIME 0.005f
+
+/**
+ * Keeps track of the audio data of wave banks loaded on demand: which items are loading,
+ * which are in memory and in what order they were last used. Audio data is read through
+ * the streaming I/O service and items not used by any playing event are evicted, least 
+ * recently used first, when the memory budget is exceeded. Only accessed from the engine thread.
+ */
+typedef struct kwlResidency
+{
+    /** The maximum number of bytes of audio data to keep in memory. Zero means no limit.*/
+    int budget;
+    /** The maximum time in seconds an event start may spend waiting for audio data.*/
+    float maxStartWaitTimeSec;
+    /** A linked list of audio data being loaded.*/
+    kwlAudioData* loadingList;
+    /** The most recently used resident audio data.*/
+    kwlAudioData* mostRecentlyUsed;
+    /** The least recently used resident audio data, i.e the next candidate for eviction.*/
+    kwlAudioData* leastRecentlyUsed;
+    /** Incremented before every eviction, to mark audio data used by playing events.*/
+    int usePass;
+    /** Hit, miss and eviction statistics, including the current number of resident items and bytes.*/
+    kwlResidencyStats stats;
+} kwlResidency;
+
+/**
+ * Initializes a residency manager with no memory budget.
+ * @param residency The residency manager to initialize.
+ */
+void kwlResidency_init(kwlResidency* residency);
+
+/**
+ * Returns non-zero if a given piece of audio data is loaded on demand, i.e if it belongs
+ * to a loaded wave bank that was loaded on demand and is not streamed from disk.
+ */
+int kwlResidency_isManaged(kwlAudioData* audioData);
+
+/**
+ * Marks all audio data used by a given event definition, i.e its streamed audio data or the audio data
+ * of its sound, as used and starts loading the items that are not in memory, evicting unused items
+ * if needed to stay within the budget.
+ * @param residency The residency manager.
+ * @param streamingIO The streaming I/O service to load through.
+ * @param eventDefinition The event definition.
+ * @param playingEvents The list of playing events of the engine. Their audio data is not evicted.
+ * @param isPrefetch Non-zero if the request is a prefetch hint rather than an event start.
+ * @return Non-zero if all audio data of the event definition is in memory, zero otherwise.
+ */
+int kwlResidency_requestEvent(kwlResidency* residency,
+                              kwlStreamingIO* streamingIO,
+                              struct kwlEventDefinition* eventDefinition,
+                              struct kwlEventInstance* playingEvents,
+                              int isPrefetch);
+
+/**
+ * Waits for the audio data used by a given event definition to finish loading, for at most a given time.
+ * @param residency The residency manager.
+ * @param streamingIO The streaming I/O service the audio data is loaded through.
+ * @param eventDefinition The event definition.
+ * @param maxWaitTimeSec The maximum number of seconds to wait.
+ * @return Non-zero if all audio data of the event definition is in memory, zero otherwise.
+ */
+int kwlResidency_waitForEvent(kwlResidency* residency,
+                              kwlStreamingIO* streamingIO,
+                              struct kwlEventDefinition* eventDefinition,
+                              float maxWaitTimeSec);
+
+/** Returns non-zero if all audio data used by a given event definition that is loaded on demand is in memory.*/
+int kwlResidency_isEventResident(struct kwlEventDefinition* eventDefinition);
+
+/** Returns non-zero if any audio data used by a given event definition is being loaded.*/
+int kwlResidency_isEventLoading(struct kwlEventDefinition* eventDefinition);
+
+/**
+ * Makes audio data that has finished loading available to events and evicts unused audio data
+ * if the budget is exceeded. Called once per engine update.
+ * @param residency The residency manager.
+ * @param streamingIO The streaming I/O service audio data is loaded through.
+ * @param playingEvents The list of playing events of the engine. Their audio data is not evicted.
+ */
+void kwlResidency_update(kwlResidency* residency,
+                         kwlStreamingIO* streamingIO,
+                         struct kwlEventInstance* playingEvents);
+
+/**
+ * Cancels loads of and stops tracking the audio data of a given wave bank. Must be called
+ * before the wave bank is unloaded. The audio data itself is freed when the wave bank is unloaded.
+ * @param residency The residency manager.
+ * @param streamingIO The streaming I/O service audio data is loaded through.
+ * @param waveBank The wave bank about to be unloaded.
+ */
+void kwlResidency_releaseWaveBank(kwlResidency* residency,
+                                  kwlStreamingIO* streamingIO,
+                                  kwlWaveBank* waveBank);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /*KWL_RESIDENCY_H*/
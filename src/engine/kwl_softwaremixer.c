@@ -36,7 +36,7 @@ freely, subject to the following restrictions:
 
 kwlSoftwareMixer* kwlSoftwareMixer_new()
 {
-    kwlSoftwareMixer* newMixer = (kwlSoftwareMixer*)KWL_MALLOC(sizeof(kwlSoftwareMixer), "kwlSoftwareMixer_new");
+    kwlSoftwareMixer* newMixer = (kwlSoftwareMixer*)KWL_MALLOC(sizeof(kwlSoftwareMixer), KWL_MEMORY_CATEGORY_MIXER, "kwlSoftwareMixer_new");
     kwlMemset(newMixer, 0, sizeof(kwlSoftwareMixer));
     
     kwlMessageQueue_init(&newMixer->toEngineQueue);
@@ -55,13 +55,13 @@ kwlSoftwareMixer* kwlSoftwareMixer_new()
 void kwlSoftwareMixer_allocateTempBuffers(kwlSoftwareMixer* mixer)
 {
     int tempBufferSize = sizeof(float) * KWL_TEMP_BUFFER_SIZE_IN_FRAMES * mixer->numOutChannels;
-    mixer->tempMixBusBuffer = (float*)KWL_MALLOC(tempBufferSize, "mixer temp buffer");
-    mixer->tempEventBuffer = (float*)KWL_MALLOC(tempBufferSize, "mixer temp buffer");
-    mixer->outBuffer = (float*)KWL_MALLOC(tempBufferSize, "mixer temp out buffer");
+    mixer->tempMixBusBuffer = (float*)KWL_MALLOC(tempBufferSize, KWL_MEMORY_CATEGORY_MIXER, "mixer temp buffer");
+    mixer->tempEventBuffer = (float*)KWL_MALLOC(tempBufferSize, KWL_MEMORY_CATEGORY_MIXER, "mixer temp buffer");
+    mixer->outBuffer = (float*)KWL_MALLOC(tempBufferSize, KWL_MEMORY_CATEGORY_MIXER, "mixer temp out buffer");
     
     if (mixer->numInChannels > 0)
     {
-        mixer->inBuffer = (float*)KWL_MALLOC(tempBufferSize, "mixer temp in buffer");
+        mixer->inBuffer = (float*)KWL_MALLOC(tempBufferSize, KWL_MEMORY_CATEGORY_MIXER, "mixer temp in buffer");
     }
 }
 
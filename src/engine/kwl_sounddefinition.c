@@ -233,6 +233,7 @@ int kwlSoundDefinition_pickNextBufferForEvent(kwlSoundDefinition* sound, kwlEven
     event->currentPCMBuffer = (short*)nextAudioData->bytes;
     event->currentPCMBufferSize = numFrames - 1;
     event->currentNumChannels = nextAudioData->numChannels;
+    event->currentSampleRate = nextAudioData->sampleRate;
     
     /*Finally, return 0 to indicate that playback should continue.*/
     return 0;
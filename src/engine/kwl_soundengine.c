@@ -169,7 +169,7 @@ void kwlSoundEngine_init(kwlSoundEngine* engine)
     
     int KWL_NUM_DECODERS = 10;
     engine->numDecoders = KWL_NUM_DECODERS;
-    engine->decoders = (kwlDecoder*)KWL_MALLOC(sizeof(kwlDecoder) * KWL_NUM_DECODERS, "decoders");
+    engine->decoders = (kwlDecoder*)KWL_MALLOC(sizeof(kwlDecoder) * KWL_NUM_DECODERS, KWL_MEMORY_CATEGORY_DECODER, "decoders");
     kwlMemset(engine->decoders, 0, sizeof(kwlDecoder) * KWL_NUM_DECODERS);
     
     //set up main mutex lock
@@ -0,0 +1,900 @@
+/*
+ Copyright (c) 2010-2012 Per Gantelius
+
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any damages
+ arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it
+ freely, subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented; you must not
+ claim that you wrote the original software. If you use this software
+ in a product, an acknowledgment in the product documentation would be
+ appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such, and must not be
+ misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+#include "kwl_assert.h"
+#include "kwl_memory.h"
+#include "kwl_streamingio.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif /*_WIN32*/
+
+double kwlStreamingIO_getTimeSec(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + 1e-9 * (double)time.tv_nsec;
+#endif /*_WIN32*/
+}
+
+static int kwlStreamingIO_alignDown(int position)
+{
+    return position - position % KWL_STREAMING_IO_BLOCK_SIZE;
+}
+
+/**
+ * Returns the read-ahead window size of a stream consuming a given number of bytes per second.
+ */
+static int kwlStreamingIO_getWindowCapacity(kwlStreamingIOStream* stream, int bytesPerSecond)
+{
+    int capacity = (int)(bytesPerSecond * KWL_STREAMING_IO_READ_AHEAD_SEC);
+    /*round up to whole blocks, plus one block of slack for aligning the first read of the window.*/
+    capacity = kwlStreamingIO_alignDown(capacity + KWL_STREAMING_IO_BLOCK_SIZE - 1) + KWL_STREAMING_IO_BLOCK_SIZE;
+    if (capacity < KWL_STREAMING_IO_MIN_WINDOW_SIZE)
+    {
+        capacity = KWL_STREAMING_IO_MIN_WINDOW_SIZE;
+    }
+    else if (capacity > KWL_STREAMING_IO_MAX_WINDOW_SIZE)
+    {
+        capacity = KWL_STREAMING_IO_MAX_WINDOW_SIZE;
+    }
+
+    /*there is no point in buffering more than the entire region.*/
+    const int regionCapacity = kwlStreamingIO_alignDown(stream->regionEnd - stream->regionStart +
+                                                        KWL_STREAMING_IO_BLOCK_SIZE - 1) +
+                                                        KWL_STREAMING_IO_BLOCK_SIZE;
+    return capacity < regionCapacity ? capacity : regionCapacity;
+}
+
+/**
+ * Moves the unread bytes of a stream window to the start of the window buffer and
+ * applies any requested change of window size. Must be called with the lock held
+ * and no read in flight for the stream.
+ */
+static void kwlStreamingIO_compactWindow(kwlStreamingIOStream* stream)
+{
+    KWL_ASSERT(stream->isReading == 0);
+
+    /*bytes before the read position are consumed. note that the read position may be
+      ahead of the end of the window after the window was moved to an aligned position.*/
+    const int keepFrom = stream->readPos < stream->windowEnd ? stream->readPos : stream->windowEnd;
+    const int numBytesToDrop = keepFrom - stream->windowStart;
+    if (numBytesToDrop > 0)
+    {
+        memmove(stream->window, stream->window + numBytesToDrop, stream->windowEnd - keepFrom);
+        stream->windowStart = keepFrom;
+    }
+
+    /*Windows of reused streams are only shrunk if they are much larger than needed,
+      to avoid reallocating the window every time a stream is opened.*/
+    const int numBytesInWindow = stream->windowEnd - stream->windowStart;
+    const int resizeWindow = stream->requestedWindowCapacity > stream->windowCapacity ||
+                             2 * stream->requestedWindowCapacity <= stream->windowCapacity;
+    if (resizeWindow != 0 && stream->requestedWindowCapacity >= numBytesInWindow)
+    {
+        signed char* newWindow = (signed char*)KWL_MALLOC(stream->requestedWindowCapacity, KWL_MEMORY_CATEGORY_STREAMING, "streaming io window");
+        kwlMemcpy(newWindow, stream->window, numBytesInWindow);
+        KWL_FREE(stream->window);
+        stream->window = newWindow;
+        stream->windowCapacity = stream->requestedWindowCapacity;
+    }
+}
+
+/**
+ * Returns the number of bytes to read into the window of a stream, or zero
+ * if the stream does not need a read. Reads end on a block boundary unless
+ * they reach the end of the region. Must be called with the lock held.
+ */
+static int kwlStreamingIO_getReadSize(kwlStreamingIOStream* stream)
+{
+    const int numBytesLeftInRegion = stream->regionEnd - stream->windowEnd;
+    if (numBytesLeftInRegion <= 0)
+    {
+        return 0;
+    }
+
+    /*the space left once consumed bytes have been compacted away*/
+    const int keepFrom = stream->readPos < stream->windowEnd ? stream->readPos : stream->windowEnd;
+    const int numFreeBytes = stream->windowCapacity - (stream->windowEnd - keepFrom);
+    if (numFreeBytes >= numBytesLeftInRegion)
+    {
+        return numBytesLeftInRegion;
+    }
+
+    const int readEnd = kwlStreamingIO_alignDown(stream->windowEnd + numFreeBytes);
+    if (readEnd > stream->windowEnd)
+    {
+        return readEnd - stream->windowEnd;
+    }
+    else if (stream->isWaiting != 0)
+    {
+        /*never let a waiting decoder wait for a full block of free space.*/
+        return numFreeBytes;
+    }
+
+    return 0;
+}
+
+/**
+ * Picks the stream to read for next: the one that will run out of buffered data first.
+ * Must be called with the lock held.
+ * @param timeUntilUnderrun Receives the number of seconds of data buffered for the picked stream.
+ */
+static kwlStreamingIOStream* kwlStreamingIO_getMostUrgentStream(kwlStreamingIO* streamingIO,
+                                                                double* timeUntilUnderrun)
+{
+    kwlStreamingIOStream* mostUrgentStream = NULL;
+    double minTimeUntilUnderrun = 0.0;
+
+    kwlStreamingIOStream* stream = streamingIO->streams;
+    while (stream != NULL)
+    {
+        if (stream->isReading == 0 && kwlStreamingIO_getReadSize(stream) > 0)
+        {
+            const int numBufferedBytes = stream->windowEnd - stream->readPos;
+            double timeUntilUnderrun = 0.0;
+            if (stream->isWaiting == 0 && numBufferedBytes > 0)
+            {
+                /*streams with an unknown rate are ranked as if they had a second of data buffered.*/
+                timeUntilUnderrun = stream->bytesPerSecond > 0 ?
+                                    numBufferedBytes / (double)stream->bytesPerSecond : 1.0;
+            }
+
+            if (mostUrgentStream == NULL || timeUntilUnderrun < minTimeUntilUnderrun)
+            {
+                mostUrgentStream = stream;
+                minTimeUntilUnderrun = timeUntilUnderrun;
+            }
+        }
+        stream = stream->next;
+    }
+
+    *timeUntilUnderrun = minTimeUntilUnderrun;
+    return mostUrgentStream;
+}
+
+/** Returns the first load with blocks left to read, or NULL if there is none. Must be called with the lock held.*/
+static kwlStreamingIOLoad* kwlStreamingIO_getNextLoad(kwlStreamingIO* streamingIO)
+{
+    kwlStreamingIOLoad* load = streamingIO->loads;
+    while (load != NULL && load->nextReadPos >= load->regionEnd)
+    {
+        load = load->next;
+    }
+    return load;
+}
+
+/** Wakes up the I/O thread if it is idle. Must be called with the lock held.*/
+static void kwlStreamingIO_wakeUp(kwlStreamingIO* streamingIO)
+{
+    if (streamingIO->isIdle != 0)
+    {
+        streamingIO->isIdle = 0;
+        kwlSemaphorePost(streamingIO->semaphore);
+    }
+}
+
+/**
+ * Prepares a read of the next block of a load. Must be called with the lock held
+ * and with blocks left to read for the load.
+ */
+static void kwlStreamingIO_beginLoadRead(kwlStreamingIO* streamingIO, kwlStreamingIOLoad* load, kwlStreamingIORead* read)
+{
+    const int readPosition = load->nextReadPos;
+    int readSize = kwlStreamingIO_alignDown(readPosition) + KWL_STREAMING_IO_BLOCK_SIZE - readPosition;
+    if (readSize > load->regionEnd - readPosition)
+    {
+        readSize = load->regionEnd - readPosition;
+    }
+    load->nextReadPos += readSize;
+    load->numReadsInFlight++;
+
+    /*each block is read into its own part of the destination, so several blocks may be read at once.*/
+    kwlMemset(read, 0, sizeof(kwlStreamingIORead));
+    read->streamingIO = streamingIO;
+    read->load = load;
+    read->file = load->file;
+    read->position = readPosition;
+    read->size = readSize;
+    read->destination = load->destination + (readPosition - load->regionStart);
+}
+
+/** Applies a completed block read of a load. Must be called with the lock held.*/
+static void kwlStreamingIO_endLoadRead(kwlStreamingIORead* read, int numBytesRead)
+{
+    kwlStreamingIO* streamingIO = read->streamingIO;
+    kwlStreamingIOLoad* load = read->load;
+    load->numReadsInFlight--;
+    load->numBytesLoaded += numBytesRead;
+    if (numBytesRead < read->size)
+    {
+        /*give up on the rest of the region rather than retrying forever.*/
+        load->hasFailed = 1;
+        load->nextReadPos = load->regionEnd;
+    }
+
+    if (load->isWaiting != 0 && load->numReadsInFlight == 0)
+    {
+        load->isWaiting = 0;
+        kwlSemaphorePost(streamingIO->loadSemaphore);
+    }
+}
+
+/** Removes a load without reads in flight from the service. Must be called with the lock held.*/
+static void kwlStreamingIO_unlinkLoad(kwlStreamingIO* streamingIO, kwlStreamingIOLoad* load)
+{
+    KWL_ASSERT(load->numReadsInFlight == 0);
+    kwlStreamingIOLoad** link = &streamingIO->loads;
+    while (*link != load)
+    {
+        KWL_ASSERT(*link != NULL && "the load is not registered");
+        link = &(*link)->next;
+    }
+    *link = load->next;
+    load->next = NULL;
+}
+
+/** Waits for the reads in flight of a load to complete. Must be called with the lock held.*/
+static void kwlStreamingIO_waitForLoadReads(kwlStreamingIO* streamingIO, kwlStreamingIOLoad* load)
+{
+    while (load->numReadsInFlight > 0)
+    {
+        load->isWaiting = 1;
+        kwlMutexLockRelease(&streamingIO->lock);
+        kwlSemaphoreWait(streamingIO->loadSemaphore);
+        kwlMutexLockAcquire(&streamingIO->lock);
+    }
+}
+
+/**
+ * Prepares a read of the next part of the region of a stream into its window.
+ * Must be called with the lock held and no read in flight for the stream.
+ */
+static void kwlStreamingIO_beginWindowRead(kwlStreamingIO* streamingIO, kwlStreamingIOStream* stream, kwlStreamingIORead* read)
+{
+    kwlStreamingIO_compactWindow(stream);
+    stream->isReading = 1;
+
+    /*Decoders may copy from the filled part of the window while the read is
+      in flight, but nobody else touches the part being read into.*/
+    kwlMemset(read, 0, sizeof(kwlStreamingIORead));
+    read->streamingIO = streamingIO;
+    read->stream = stream;
+    read->file = stream->file;
+    read->position = stream->windowEnd;
+    read->size = kwlStreamingIO_getReadSize(stream);
+    read->destination = stream->window + (stream->windowEnd - stream->windowStart);
+    read->windowGeneration = stream->windowGeneration;
+}
+
+/** Applies a completed read into the window of a stream. Must be called with the lock held.*/
+static void kwlStreamingIO_endWindowRead(kwlStreamingIORead* read, int numBytesRead, double readTime)
+{
+    kwlStreamingIOStream* stream = read->stream;
+    stream->isReading = 0;
+    stream->stats.numReads++;
+    stream->stats.numBytesRead += numBytesRead;
+    stream->totalReadTimeSec += readTime;
+    if (readTime > stream->stats.maxReadLatency)
+    {
+        stream->stats.maxReadLatency = (float)readTime;
+    }
+
+    if (read->windowGeneration == stream->windowGeneration)
+    {
+        stream->windowEnd += numBytesRead;
+        if (numBytesRead < read->size)
+        {
+            /*treat the rest of the region as missing rather than retrying forever.*/
+            stream->regionEnd = stream->windowEnd;
+        }
+    }
+
+    if (stream->isWaiting != 0)
+    {
+        stream->isWaiting = 0;
+        kwlSemaphorePost(stream->semaphore);
+    }
+}
+
+/** Applies a completed read of a stream or a load. Must be called with the lock held.*/
+static void kwlStreamingIO_endRead(kwlStreamingIORead* read, int numBytesRead)
+{
+    if (read->stream != NULL)
+    {
+        kwlStreamingIO_endWindowRead(read, numBytesRead, kwlStreamingIO_getTimeSec() - read->startTime);
+    }
+    else
+    {
+        kwlStreamingIO_endLoadRead(read, numBytesRead);
+    }
+}
+
+/**
+ * Performs a prepared read on the calling thread. Must be called with the lock held.
+ * The lock is released during the file read.
+ */
+static void kwlStreamingIO_performRead(kwlStreamingIO* streamingIO, kwlStreamingIORead* read)
+{
+    kwlMutexLockRelease(&streamingIO->lock);
+
+    read->startTime = kwlStreamingIO_getTimeSec();
+    const int numBytesRead = kwlFileSystem_read(streamingIO->fileSystem,
+                                                read->file,
+                                                read->position,
+                                                read->destination,
+                                                read->size);
+
+    kwlMutexLockAcquire(&streamingIO->lock);
+
+    kwlStreamingIO_endRead(read, numBytesRead);
+}
+
+/**
+ * Completes a read started with the asynchronous read function of the file system.
+ * Called by the file system on any thread, possibly before the read function returns.
+ */
+static void kwlStreamingIO_readCompleted(void* completionData, int numBytesRead)
+{
+    kwlStreamingIORead* read = (kwlStreamingIORead*)completionData;
+    kwlStreamingIO* streamingIO = read->streamingIO;
+
+    kwlMutexLockAcquire(&streamingIO->lock);
+
+    kwlStreamingIO_endRead(read, numBytesRead);
+
+    read->next = streamingIO->freeReads;
+    streamingIO->freeReads = read;
+    streamingIO->numAsyncReadsInFlight--;
+    /*there is room for another read in flight.*/
+    kwlStreamingIO_wakeUp(streamingIO);
+
+    kwlMutexLockRelease(&streamingIO->lock);
+}
+
+/**
+ * Starts a prepared read with the asynchronous read function of the file system, falling
+ * back to a blocking read if the file system declines. Must be called with the lock held.
+ * The lock is released while the read is started.
+ */
+static void kwlStreamingIO_startAsyncRead(kwlStreamingIO* streamingIO, kwlStreamingIORead* read)
+{
+    streamingIO->numAsyncReadsInFlight++;
+
+    kwlMutexLockRelease(&streamingIO->lock);
+
+    read->startTime = kwlStreamingIO_getTimeSec();
+    const kwlFileSystem* fileSystem = streamingIO->fileSystem;
+    const int hasStarted = fileSystem->readAsync(fileSystem->userData,
+                                                 read->file,
+                                                 read->position,
+                                                 read->destination,
+                                                 read->size,
+                                                 kwlStreamingIO_readCompleted,
+                                                 read);
+    if (hasStarted == 0)
+    {
+        kwlStreamingIO_readCompleted(read, kwlFileSystem_read(fileSystem,
+                                                              read->file,
+                                                              read->position,
+                                                              read->destination,
+                                                              read->size));
+    }
+
+    kwlMutexLockAcquire(&streamingIO->lock);
+}
+
+/**
+ * Reads the next block of a load on the calling thread. Must be called with the lock held
+ * and with blocks left to read for the load. The lock is released during the file read.
+ */
+static void kwlStreamingIO_readLoadBlock(kwlStreamingIO* streamingIO, kwlStreamingIOLoad* load)
+{
+    kwlStreamingIORead read;
+    kwlStreamingIO_beginLoadRead(streamingIO, load, &read);
+    kwlStreamingIO_performRead(streamingIO, &read);
+}
+
+/**
+ * Reads the next part of the region of a stream into its window on the calling thread. Must be called
+ * with the lock held and no read in flight for the stream. The lock is released during the file read.
+ */
+static void kwlStreamingIO_readIntoWindow(kwlStreamingIO* streamingIO, kwlStreamingIOStream* stream)
+{
+    kwlStreamingIORead read;
+    kwlStreamingIO_beginWindowRead(streamingIO, stream, &read);
+    kwlStreamingIO_performRead(streamingIO, &read);
+}
+
+/** The entry point of the I/O thread.*/
+static void* kwlStreamingIO_ioLoop(void* data)
+{
+    kwlStreamingIO* streamingIO = (kwlStreamingIO*)data;
+    const int isAsync = streamingIO->fileSystem->readAsync != NULL;
+
+    while (1)
+    {
+        kwlMutexLockAcquire(&streamingIO->lock);
+
+        if (streamingIO->threadJoinRequested != 0)
+        {
+            kwlMutexLockRelease(&streamingIO->lock);
+            return NULL;
+        }
+
+        double timeUntilUnderrun = 0.0;
+        kwlStreamingIOStream* stream = kwlStreamingIO_getMostUrgentStream(streamingIO, &timeUntilUnderrun);
+        kwlStreamingIOLoad* load = kwlStreamingIO_getNextLoad(streamingIO);
+        if ((stream == NULL && load == NULL) ||
+            streamingIO->numAsyncReadsInFlight >= KWL_STREAMING_IO_MAX_ASYNC_READS)
+        {
+            /*nothing to read. sleep until a stream is opened, read from or seeked, a load
+              is started or an asynchronous read completes.*/
+            streamingIO->isIdle = 1;
+            kwlMutexLockRelease(&streamingIO->lock);
+            kwlSemaphoreWait(streamingIO->semaphore);
+            continue;
+        }
+
+        kwlStreamingIORead syncRead;
+        kwlStreamingIORead* read = &syncRead;
+        if (isAsync != 0)
+        {
+            /*reads started asynchronously outlive this iteration.*/
+            read = streamingIO->freeReads;
+            if (read != NULL)
+            {
+                streamingIO->freeReads = read->next;
+            }
+            else
+            {
+                read = (kwlStreamingIORead*)KWL_MALLOC(sizeof(kwlStreamingIORead), KWL_MEMORY_CATEGORY_STREAMING, "streaming io read");
+            }
+        }
+
+        if (load != NULL && (stream == NULL || timeUntilUnderrun > KWL_STREAMING_IO_LOAD_PRIORITY_SEC))
+        {
+            /*streams have enough data buffered to let a load go first.*/
+            kwlStreamingIO_beginLoadRead(streamingIO, load, read);
+        }
+        else
+        {
+            kwlStreamingIO_beginWindowRead(streamingIO, stream, read);
+        }
+
+        if (isAsync != 0)
+        {
+            kwlStreamingIO_startAsyncRead(streamingIO, read);
+        }
+        else
+        {
+            kwlStreamingIO_performRead(streamingIO, read);
+        }
+
+        kwlMutexLockRelease(&streamingIO->lock);
+    }
+
+    return NULL;
+}
+
+/** Adds the statistics of a stream to a set of totals.*/
+static void kwlStreamingIO_accumulateStats(kwlStreamingIOStats* total, kwlStreamingIOStats* stats)
+{
+    total->numStreams += stats->numStreams;
+    total->numReads += stats->numReads;
+    total->numBytesRead += stats->numBytesRead;
+    total->numStalls += stats->numStalls;
+    if (stats->maxReadLatency > total->maxReadLatency)
+    {
+        total->maxReadLatency = stats->maxReadLatency;
+    }
+}
+
+/** Fills in the statistics derived from accumulated read and stall times.*/
+static void kwlStreamingIO_finishStats(kwlStreamingIOStats* stats, double totalReadTimeSec, double totalStallTimeSec)
+{
+    stats->averageReadLatency = stats->numReads > 0 ? (float)(totalReadTimeSec / stats->numReads) : 0.0f;
+    stats->readThroughput = totalReadTimeSec > 0.0 ? (float)(stats->numBytesRead / totalReadTimeSec) : 0.0f;
+    stats->totalStallTime = (float)totalStallTimeSec;
+}
+
+void kwlStreamingIO_init(kwlStreamingIO* streamingIO, const kwlFileSystem* fileSystem)
+{
+    kwlMemset(streamingIO, 0, sizeof(kwlStreamingIO));
+    kwlMutexLockInit(&streamingIO->lock);
+    streamingIO->fileSystem = fileSystem != NULL ? fileSystem : kwlFileSystem_getDefault();
+
+    /*Create a semaphore with a unique name based on the addess of the service*/
+    sprintf(streamingIO->semaphoreName, "streamingio%d", (int)(size_t)streamingIO);
+    streamingIO->semaphore = kwlSemaphoreOpen(streamingIO->semaphoreName);
+    sprintf(streamingIO->loadSemaphoreName, "streamingioload%d", (int)(size_t)streamingIO);
+    streamingIO->loadSemaphore = kwlSemaphoreOpen(streamingIO->loadSemaphoreName);
+
+    kwlThreadCreate(&streamingIO->ioThread, kwlStreamingIO_ioLoop, streamingIO);
+}
+
+void kwlStreamingIO_free(kwlStreamingIO* streamingIO)
+{
+    KWL_ASSERT(streamingIO->streams == NULL && "all streams must be closed");
+    KWL_ASSERT(streamingIO->loads == NULL && "all loads must be finished or cancelled");
+    KWL_ASSERT(streamingIO->numAsyncReadsInFlight == 0);
+
+    kwlMutexLockAcquire(&streamingIO->lock);
+    streamingIO->threadJoinRequested = 1;
+    kwlSemaphorePost(streamingIO->semaphore);
+    kwlMutexLockRelease(&streamingIO->lock);
+
+    kwlThreadJoin(&streamingIO->ioThread);
+    kwlSemaphoreDestroy(streamingIO->semaphore, streamingIO->semaphoreName);
+    kwlSemaphoreDestroy(streamingIO->loadSemaphore, streamingIO->loadSemaphoreName);
+
+    while (streamingIO->freeStreams != NULL)
+    {
+        kwlStreamingIOStream* stream = streamingIO->freeStreams;
+        streamingIO->freeStreams = stream->next;
+        kwlSemaphoreDestroy(stream->semaphore, stream->semaphoreName);
+        KWL_FREE(stream->window);
+        KWL_FREE(stream);
+    }
+
+    while (streamingIO->freeReads != NULL)
+    {
+        kwlStreamingIORead* read = streamingIO->freeReads;
+        streamingIO->freeReads = read->next;
+        KWL_FREE(read);
+    }
+}
+
+kwlError kwlStreamingIO_openStream(kwlStreamingIO* streamingIO,
+                                   void* file,
+                                   int offset,
+                                   int size,
+                                   kwlStreamingIOStream** stream)
+{
+    KWL_ASSERT(offset >= 0);
+    KWL_ASSERT(size > 0);
+    *stream = NULL;
+
+    if (file == NULL)
+    {
+        return KWL_FILE_NOT_FOUND;
+    }
+
+    kwlMutexLockAcquire(&streamingIO->lock);
+
+    /*reuse a closed stream if there is one, keeping its window and semaphore.*/
+    kwlStreamingIOStream* newStream = streamingIO->freeStreams;
+    signed char* window = NULL;
+    int windowCapacity = 0;
+    kwlSemaphore* semaphore = NULL;
+    char semaphoreName[64];
+    if (newStream != NULL)
+    {
+        streamingIO->freeStreams = newStream->next;
+        window = newStream->window;
+        windowCapacity = newStream->windowCapacity;
+        semaphore = newStream->semaphore;
+        strcpy(semaphoreName, newStream->semaphoreName);
+    }
+    else
+    {
+        newStream = (kwlStreamingIOStream*)KWL_MALLOC(sizeof(kwlStreamingIOStream), KWL_MEMORY_CATEGORY_STREAMING, "streaming io stream");
+        sprintf(semaphoreName, "streamingio%d_%d", (int)(size_t)streamingIO, streamingIO->streamCounter++);
+        semaphore = kwlSemaphoreOpen(semaphoreName);
+    }
+
+    kwlMemset(newStream, 0, sizeof(kwlStreamingIOStream));
+    newStream->streamingIO = streamingIO;
+    newStream->file = file;
+    newStream->regionStart = offset;
+    newStream->regionEnd = offset + size;
+    newStream->requestedWindowCapacity = kwlStreamingIO_getWindowCapacity(newStream, 0);
+    if (window == NULL)
+    {
+        window = (signed char*)KWL_MALLOC(newStream->requestedWindowCapacity, KWL_MEMORY_CATEGORY_STREAMING, "streaming io window");
+        windowCapacity = newStream->requestedWindowCapacity;
+    }
+    newStream->window = window;
+    newStream->windowCapacity = windowCapacity;
+    newStream->semaphore = semaphore;
+    strcpy(newStream->semaphoreName, semaphoreName);
+
+    /*start the first read at the block containing the start of the region.*/
+    newStream->windowStart = kwlStreamingIO_alignDown(offset);
+    newStream->windowEnd = newStream->windowStart;
+    newStream->readPos = offset;
+    newStream->stats.numStreams = 1;
+
+    newStream->next = streamingIO->streams;
+    streamingIO->streams = newStream;
+    /*start filling the window right away*/
+    kwlStreamingIO_wakeUp(streamingIO);
+
+    kwlMutexLockRelease(&streamingIO->lock);
+
+    *stream = newStream;
+    return KWL_NO_ERROR;
+}
+
+void kwlStreamingIO_closeStream(kwlStreamingIO* streamingIO, kwlStreamingIOStream* stream)
+{
+    kwlMutexLockAcquire(&streamingIO->lock);
+
+    /*wait for any read into the window to finish*/
+    while (stream->isReading != 0)
+    {
+        stream->isWaiting = 1;
+        kwlMutexLockRelease(&streamingIO->lock);
+        kwlSemaphoreWait(stream->semaphore);
+        kwlMutexLockAcquire(&streamingIO->lock);
+    }
+
+    /*unlink the stream*/
+    kwlStreamingIOStream** link = &streamingIO->streams;
+    while (*link != stream)
+    {
+        KWL_ASSERT(*link != NULL && "the stream is not registered");
+        link = &(*link)->next;
+    }
+    *link = stream->next;
+
+    kwlStreamingIO_accumulateStats(&streamingIO->closedStreamStats, &stream->stats);
+    streamingIO->closedStreamReadTimeSec += stream->totalReadTimeSec;
+    streamingIO->closedStreamStallTimeSec += stream->totalStallTimeSec;
+
+    /*keep the stream around for reuse. the file belongs to the wave bank.*/
+    stream->file = NULL;
+    stream->next = streamingIO->freeStreams;
+    streamingIO->freeStreams = stream;
+
+    kwlMutexLockRelease(&streamingIO->lock);
+}
+
+void kwlStreamingIO_setStreamBytesPerSecond(kwlStreamingIO* streamingIO,
+                                            kwlStreamingIOStream* stream,
+                                            int bytesPerSecond)
+{
+    kwlMutexLockAcquire(&streamingIO->lock);
+    stream->bytesPerSecond = bytesPerSecond;
+    /*the window is resized the next time it is read into.*/
+    stream->requestedWindowCapacity = kwlStreamingIO_getWindowCapacity(stream, bytesPerSecond);
+    kwlMutexLockRelease(&streamingIO->lock);
+}
+
+int kwlStreamingIO_read(void* data, int position, signed char* destination, int length)
+{
+    kwlStreamingIOStream* stream = (kwlStreamingIOStream*)data;
+    kwlStreamingIO* streamingIO = stream->streamingIO;
+    int numBytesCopied = 0;
+    int hasStalled = 0;
+
+    kwlMutexLockAcquire(&streamingIO->lock);
+
+    if (position < stream->regionStart || position >= stream->regionEnd)
+    {
+        kwlMutexLockRelease(&streamingIO->lock);
+        return 0;
+    }
+    if (length > stream->regionEnd - position)
+    {
+        length = stream->regionEnd - position;
+    }
+
+    while (numBytesCopied < length)
+    {
+        const int currentPosition = position + numBytesCopied;
+
+        if (currentPosition < stream->windowStart ||
+            currentPosition >= kwlStreamingIO_alignDown(stream->windowEnd) + KWL_STREAMING_IO_BLOCK_SIZE)
+        {
+            /*A seek outside the window and the block following it. Discard the window and start over
+              at the block containing the requested position. A read in flight, if any, is dropped
+              when it completes.*/
+            int newWindowStart = kwlStreamingIO_alignDown(currentPosition);
+            if (newWindowStart < kwlStreamingIO_alignDown(stream->regionStart))
+            {
+                newWindowStart = kwlStreamingIO_alignDown(stream->regionStart);
+            }
+            stream->windowStart = newWindowStart;
+            stream->windowEnd = newWindowStart;
+            stream->windowGeneration++;
+        }
+
+        stream->readPos = currentPosition;
+        const int numBufferedBytes = stream->windowEnd - currentPosition;
+
+        if (numBufferedBytes > 0)
+        {
+            const int numBytesToCopy = numBufferedBytes < length - numBytesCopied ?
+                                       numBufferedBytes : length - numBytesCopied;
+            kwlMemcpy(destination + numBytesCopied,
+                      stream->window + (currentPosition - stream->windowStart),
+                      numBytesToCopy);
+            numBytesCopied += numBytesToCopy;
+            stream->readPos += numBytesToCopy;
+        }
+        else if (currentPosition >= stream->regionEnd)
+        {
+            /*the region was truncated by a read error.*/
+            break;
+        }
+        else
+        {
+            /*The window is empty.*/
+            if (hasStalled == 0)
+            {
+                stream->stats.numStalls++;
+                hasStalled = 1;
+            }
+            const double stallStartTime = kwlStreamingIO_getTimeSec();
+
+            if (stream->isReading == 0)
+            {
+                /*Nothing is being read into the window, typically right after the stream was
+                  opened or seeked. Read on this thread instead of waiting for the I/O thread.
+                  Reads are positional, so this does not interfere with other reads of the file.*/
+                kwlStreamingIO_readIntoWindow(streamingIO, stream);
+            }
+            else
+            {
+                /*Wait for the read in flight to finish.*/
+                stream->isWaiting = 1;
+                kwlMutexLockRelease(&streamingIO->lock);
+                kwlSemaphoreWait(stream->semaphore);
+                kwlMutexLockAcquire(&streamingIO->lock);
+            }
+
+            stream->totalStallTimeSec += kwlStreamingIO_getTimeSec() - stallStartTime;
+        }
+    }
+
+    /*the consumed bytes may leave room for another read.*/
+    if (kwlStreamingIO_getReadSize(stream) > 0)
+    {
+        kwlStreamingIO_wakeUp(streamingIO);
+    }
+
+    kwlMutexLockRelease(&streamingIO->lock);
+
+    return numBytesCopied;
+}
+
+void kwlStreamingIO_startLoad(kwlStreamingIO* streamingIO,
+                              kwlStreamingIOLoad* load,
+                              void* file,
+                              int offset,
+                              int size,
+                              signed char* destination)
+{
+    KWL_ASSERT(file != NULL);
+    KWL_ASSERT(offset >= 0);
+    KWL_ASSERT(size > 0);
+
+    kwlMemset(load, 0, sizeof(kwlStreamingIOLoad));
+    load->file = file;
+    load->regionStart = offset;
+    load->regionEnd = offset + size;
+    load->destination = destination;
+    load->nextReadPos = offset;
+
+    kwlMutexLockAcquire(&streamingIO->lock);
+
+    /*loads are served in the order they were started.*/
+    kwlStreamingIOLoad** link = &streamingIO->loads;
+    while (*link != NULL)
+    {
+        link = &(*link)->next;
+    }
+    *link = load;
+    kwlStreamingIO_wakeUp(streamingIO);
+
+    kwlMutexLockRelease(&streamingIO->lock);
+}
+
+int kwlStreamingIO_finishLoad(kwlStreamingIO* streamingIO, kwlStreamingIOLoad* load, float maxWaitTimeSec)
+{
+    const double deadline = kwlStreamingIO_getTimeSec() + maxWaitTimeSec;
+
+    kwlMutexLockAcquire(&streamingIO->lock);
+
+    while (load->nextReadPos < load->regionEnd || load->numReadsInFlight > 0)
+    {
+        if (maxWaitTimeSec <= 0.0f || kwlStreamingIO_getTimeSec() >= deadline)
+        {
+            kwlMutexLockRelease(&streamingIO->lock);
+            return 0;
+        }
+
+        if (load->nextReadPos < load->regionEnd)
+        {
+            /*read the next block on this thread rather than waiting for the I/O thread to get to it.*/
+            kwlStreamingIO_readLoadBlock(streamingIO, load);
+        }
+        else
+        {
+            /*only reads issued by the I/O thread remain. they are at most a block each.*/
+            kwlStreamingIO_waitForLoadReads(streamingIO, load);
+        }
+    }
+
+    kwlStreamingIO_unlinkLoad(streamingIO, load);
+
+    kwlMutexLockRelease(&streamingIO->lock);
+    return 1;
+}
+
+void kwlStreamingIO_cancelLoad(kwlStreamingIO* streamingIO, kwlStreamingIOLoad* load)
+{
+    kwlMutexLockAcquire(&streamingIO->lock);
+
+    /*stop issuing reads and wait for the ones in flight.*/
+    load->nextReadPos = load->regionEnd;
+    kwlStreamingIO_waitForLoadReads(streamingIO, load);
+    kwlStreamingIO_unlinkLoad(streamingIO, load);
+
+    kwlMutexLockRelease(&streamingIO->lock);
+}
+
+void kwlStreamingIO_getStreamStats(kwlStreamingIO* streamingIO,
+                                   kwlStreamingIOStream* stream,
+                                   kwlStreamingIOStats* stats)
+{
+    kwlMutexLockAcquire(&streamingIO->lock);
+    *stats = stream->stats;
+    kwlStreamingIO_finishStats(stats, stream->totalReadTimeSec, stream->totalStallTimeSec);
+    kwlMutexLockRelease(&streamingIO->lock);
+}
+
+void kwlStreamingIO_getStats(kwlStreamingIO* streamingIO, kwlStreamingIOStats* stats)
+{
+    kwlMutexLockAcquire(&streamingIO->lock);
+
+    *stats = streamingIO->closedStreamStats;
+    double totalReadTimeSec = streamingIO->closedStreamReadTimeSec;
+    double totalStallTimeSec = streamingIO->closedStreamStallTimeSec;
+
+    kwlStreamingIOStream* stream = streamingIO->streams;
+    while (stream != NULL)
+    {
+        kwlStreamingIO_accumulateStats(stats, &stream->stats);
+        totalReadTimeSec += stream->totalReadTimeSec;
+        totalStallTimeSec += stream->totalStallTimeSec;
+        stream = stream->next;
+    }
+
+    kwlStreamingIO_finishStats(stats, totalReadTimeSec, totalStallTimeSec);
+
+    kwlMutexLockRelease(&streamingIO->lock);
+}
@@ -0,0 +1,340 @@
+/*
+ Copyright (c) 2010-2012 Per Gantelius
+
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any damages
+ arising from the use of this software.
+
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it
+ freely, subject to the following restrictions:
+
+ 1. The origin of this software must not be misrepresented; you must not
+ claim that you wrote the original software. If you use this software
+ in a product, an acknowledgment in the product documentation would be
+ appreciated but is not required.
+
+ 2. Altered source versions must be plainly marked as such, and must not be
+ misrepresented as being the original software.
+
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+#ifndef KWL_STREAMING_IO_H
+#define KWL_STREAMING_IO_H
+
+/*! \file */
+
+#include "kowalski.h"
+#include "kwl_filesystem.h"
+#include "kwl_synchronization.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+/**
+ * The granularity in bytes of the file reads issued by the streaming I/O service.
+ * Reads start and end on multiples of this size, except at the edges of stream regions.
+ */
+#define KWL_STREAMING_IO_BLOCK_SIZE (64 * 1024)
+/** The number of seconds of encoded data each stream tries to keep buffered ahead of its decoder.*/
+#define KWL_STREAMING_IO_READ_AHEAD_SEC 1.0f
+/** The smallest read-ahead window of a stream, in bytes.*/
+#define KWL_STREAMING_IO_MIN_WINDOW_SIZE (2 * KWL_STREAMING_IO_BLOCK_SIZE)
+/** The largest read-ahead window of a stream, in bytes.*/
+#define KWL_STREAMING_IO_MAX_WINDOW_SIZE (16 * KWL_STREAMING_IO_BLOCK_SIZE)
+/** Streams with more than this many seconds of buffered data let the I/O thread read for loads first.*/
+#define KWL_STREAMING_IO_LOAD_PRIORITY_SEC 0.5f
+/** The maximum number of reads the I/O thread keeps in flight with a file system supporting asynchronous reads.*/
+#define KWL_STREAMING_IO_MAX_ASYNC_READS 8
+
+/**
+ * A region of a file read by the streaming I/O service on behalf of a decoder.
+ * The service keeps a read-ahead window of the region in memory that the decoder
+ * consumes from. All fields except the file and the region start are protected by
+ * the service lock. The region end is moved back if a file read comes up short.
+ * Closed streams are kept by the service and reused, window and semaphore included.
+ */
+typedef struct kwlStreamingIOStream
+{
+    /** The service the stream was opened with.*/
+    struct kwlStreamingIO* streamingIO;
+    /**
+     * The file containing the region, opened through the file system of the service. Not owned by
+     * the stream, since all streams of a wave bank share the file opened when the wave bank was loaded.
+     * Only read from using positional reads, by the I/O thread or by a decoder thread finding the window empty.
+     */
+    void* file;
+    /** The byte position in the file of the first byte of the region.*/
+    int regionStart;
+    /** The byte position in the file following the last byte of the region.*/
+    int regionEnd;
+    /** The approximate number of bytes per second consumed by the decoder, used for prioritizing reads.*/
+    int bytesPerSecond;
+    /** The read-ahead window, holding the bytes of the file in the range [\c windowStart, \c windowEnd).*/
+    signed char* window;
+    /** The size in bytes of \c window.*/
+    int windowCapacity;
+    /** The window size requested for the current bitrate. Applied before the next read into the window.*/
+    int requestedWindowCapacity;
+    /** The file position of the first byte in the window.*/
+    int windowStart;
+    /** The file position following the last byte in the window.*/
+    int windowEnd;
+    /** The file position the decoder will read from next.*/
+    int readPos;
+    /** Incremented every time the window is discarded, so reads in flight can tell that their data is stale.*/
+    int windowGeneration;
+    /** Non-zero while a read into the window of this stream is in flight.*/
+    int isReading;
+    /** Non-zero while a decoder thread waits for \c semaphore to be posted.*/
+    int isWaiting;
+    /** A semaphore the decoder waits on when the window is empty.*/
+    kwlSemaphore* semaphore;
+    /** The unique name of \c semaphore.*/
+    char semaphoreName[64];
+    /** Read statistics of this stream.*/
+    kwlStreamingIOStats stats;
+    /** The total time in seconds spent in file reads for this stream.*/
+    double totalReadTimeSec;
+    /** The total time in seconds the decoder spent waiting for data.*/
+    double totalStallTimeSec;
+    /** The next stream in the list of registered streams or in the list of free streams.*/
+    struct kwlStreamingIOStream* next;
+} kwlStreamingIOStream;
+
+/**
+ * A file region read in its entirety into a given buffer by the streaming I/O service,
+ * for example audio data loaded into memory on demand. Loads are read one block at a
+ * time by the I/O thread when no stream is about to run out of data, or by a thread
+ * waiting for the load to finish. All fields except the file, the region and the
+ * destination are protected by the service lock.
+ */
+typedef struct kwlStreamingIOLoad
+{
+    /** The file containing the region, opened through the file system of the service. Not owned by the load.*/
+    void* file;
+    /** The byte position in the file of the first byte of the region.*/
+    int regionStart;
+    /** The byte position in the file following the last byte of the region.*/
+    int regionEnd;
+    /** The buffer receiving the bytes of the region.*/
+    signed char* destination;
+    /** The file position of the first byte no read has been issued for yet.*/
+    int nextReadPos;
+    /** The number of bytes read so far.*/
+    int numBytesLoaded;
+    /** The number of block reads in flight.*/
+    int numReadsInFlight;
+    /** Non-zero if a file read came up short, in which case the rest of the region is not read.*/
+    int hasFailed;
+    /** Non-zero while a thread waits for the reads in flight to finish.*/
+    int isWaiting;
+    /** The next load in the list of loads of the service.*/
+    struct kwlStreamingIOLoad* next;
+} kwlStreamingIOLoad;
+
+/**
+ * A single file read into the window of a stream or the destination of a load.
+ * Reads started with the asynchronous read function of the file system are
+ * allocated by the I/O thread and kept in a free list once completed.
+ */
+typedef struct kwlStreamingIORead
+{
+    /** The service issuing the read.*/
+    struct kwlStreamingIO* streamingIO;
+    /** The stream to read into the window of, or NULL if reading for a load.*/
+    kwlStreamingIOStream* stream;
+    /** The load to read for, or NULL if reading into the window of a stream.*/
+    kwlStreamingIOLoad* load;
+    /** The file to read from.*/
+    void* file;
+    /** The file position to read from.*/
+    int position;
+    /** The number of bytes to read.*/
+    int size;
+    /** The buffer receiving the read bytes.*/
+    signed char* destination;
+    /** The window generation of the stream when the read was issued.*/
+    int windowGeneration;
+    /** The time stamp of the start of the read.*/
+    double startTime;
+    /** The next read in the list of free reads.*/
+    struct kwlStreamingIORead* next;
+} kwlStreamingIORead;
+
+/**
+ * A service performing the file reads of streaming decoders on a dedicated thread.
+ * Reads are issued in large aligned blocks into per stream read-ahead windows
+ * and the stream with the least buffered playback time is always served first.
+ */
+typedef struct kwlStreamingIO
+{
+    /** The file system all files of streams and loads are read through.*/
+    const kwlFileSystem* fileSystem;
+    /** The thread performing read-ahead file reads.*/
+    kwlThread ioThread;
+    /** A semaphore posted to wake up the I/O thread when there may be work to do.*/
+    kwlSemaphore* semaphore;
+    /** The unique name of \c semaphore.*/
+    char semaphoreName[64];
+    /** Protects the stream list, the stream windows and the statistics.*/
+    kwlMutexLock lock;
+    /** Non-zero when the I/O thread is waiting for \c semaphore to be posted.*/
+    int isIdle;
+    /** Non-zero when the I/O thread should exit.*/
+    int threadJoinRequested;
+    /** A linked list of registered streams.*/
+    kwlStreamingIOStream* streams;
+    /** A linked list of closed streams that can be reused without allocating a window or a semaphore.*/
+    kwlStreamingIOStream* freeStreams;
+    /** A linked list of loads that have not been finished or cancelled.*/
+    kwlStreamingIOLoad* loads;
+    /** A semaphore posted when the last read in flight of a load waited for completes.*/
+    kwlSemaphore* loadSemaphore;
+    /** The unique name of \c loadSemaphore.*/
+    char loadSemaphoreName[64];
+    /** Completed asynchronous reads that can be reused.*/
+    kwlStreamingIORead* freeReads;
+    /** The number of reads started with the asynchronous read function of the file system that have not completed.*/
+    int numAsyncReadsInFlight;
+    /** Used to give each stream semaphore a unique name.*/
+    int streamCounter;
+    /** Accumulated statistics of streams that have been closed.*/
+    kwlStreamingIOStats closedStreamStats;
+    /** The total time in seconds spent in file reads for closed streams.*/
+    double closedStreamReadTimeSec;
+    /** The total time in seconds decoders of closed streams spent waiting for data.*/
+    double closedStreamStallTimeSec;
+} kwlStreamingIO;
+
+/** Returns a monotonic time stamp in seconds.*/
+double kwlStreamingIO_getTimeSec(void);
+
+/**
+ * Initializes a streaming I/O service and starts its I/O thread. If the file system
+ * supports asynchronous reads, the I/O thread keeps up to \c KWL_STREAMING_IO_MAX_ASYNC_READS
+ * reads in flight instead of waiting for each read to complete.
+ * @param streamingIO The service to initialize.
+ * @param fileSystem The file system to read through. Must outlive the service. NULL for the default file system.
+ */
+void kwlStreamingIO_init(kwlStreamingIO* streamingIO, const kwlFileSystem* fileSystem);
+
+/**
+ * Stops the I/O thread of a streaming I/O service and releases its resources,
+ * including closed streams kept for reuse. All streams must be closed and all
+ * loads finished or cancelled before calling this function.
+ * @param streamingIO The service to free.
+ */
+void kwlStreamingIO_free(kwlStreamingIO* streamingIO);
+
+/**
+ * Opens a file region for reading through a given streaming I/O service. The file
+ * is not closed with the stream and must stay open until the stream has been closed.
+ * @param streamingIO The service to read through.
+ * @param file The file containing the region, opened through the file system of the service.
+ * @param offset The byte offset of the region in the file.
+ * @param size The size of the region in bytes.
+ * @param stream Receives the opened stream, or NULL on failure.
+ * @return \c KWL_FILE_NOT_FOUND if \c file is NULL, \c KWL_NO_ERROR otherwise.
+ */
+kwlError kwlStreamingIO_openStream(kwlStreamingIO* streamingIO,
+                                   void* file,
+                                   int offset,
+                                   int size,
+                                   kwlStreamingIOStream** stream);
+
+/**
+ * Closes a stream opened with \c kwlStreamingIO_openStream, waiting for any
+ * read in flight to finish. The statistics of the stream are added to the
+ * totals of the service and the stream is kept for reuse by later streams.
+ * @param streamingIO The service the stream was opened with.
+ * @param stream The stream to close.
+ */
+void kwlStreamingIO_closeStream(kwlStreamingIO* streamingIO, kwlStreamingIOStream* stream);
+
+/**
+ * Sets the approximate rate at which the decoder of a given stream consumes data.
+ * This determines the priority of the stream and the size of its read-ahead window.
+ * @param streamingIO The service the stream was opened with.
+ * @param stream The stream.
+ * @param bytesPerSecond The number of bytes per second. Zero if unknown.
+ */
+void kwlStreamingIO_setStreamBytesPerSecond(kwlStreamingIO* streamingIO,
+                                            kwlStreamingIOStream* stream,
+                                            int bytesPerSecond);
+
+/**
+ * Reads from a stream, blocking until the requested bytes are in the read-ahead window.
+ * If the window is empty and no read is in flight, the calling thread reads into the
+ * window itself rather than waiting for the I/O thread. Has the signature of a
+ * \c kwlInputStream read function, so that streams can be wrapped in input streams.
+ * @param stream A pointer to the \c kwlStreamingIOStream to read from.
+ * @param position The absolute file position to read from.
+ * @param data The buffer to copy the read bytes to.
+ * @param length The number of bytes to read.
+ * @return The number of bytes read, which is less than \c length only at the end of the region.
+ */
+int kwlStreamingIO_read(void* stream, int position, signed char* data, int length);
+
+/**
+ * Starts reading a file region into a given buffer in the background.
+ * @param streamingIO The service to read through.
+ * @param load The load to start. Must stay valid until the load has been finished or cancelled.
+ * @param file The file containing the region, opened through the file system of the service.
+ * Must stay open until the load has been finished or cancelled.
+ * @param offset The byte offset of the region in the file.
+ * @param size The size of the region in bytes.
+ * @param destination The buffer to read the region into. Must hold at least \c size bytes.
+ */
+void kwlStreamingIO_startLoad(kwlStreamingIO* streamingIO,
+                              kwlStreamingIOLoad* load,
+                              void* file,
+                              int offset,
+                              int size,
+                              signed char* destination);
+
+/**
+ * Checks if a given load has finished, helping it along on the calling thread for at most a given time.
+ * Blocks not yet being read by the I/O thread are read on the calling thread, one at a time, until the
+ * time is up, so the call may return up to one block read late. Finished loads are removed from the service.
+ * @param streamingIO The service the load was started with.
+ * @param load The load.
+ * @param maxWaitTimeSec The maximum number of seconds to spend reading or waiting. Zero to just check.
+ * @return Non-zero if the load has finished, in which case \c hasFailed tells if all bytes were read.
+ */
+int kwlStreamingIO_finishLoad(kwlStreamingIO* streamingIO, kwlStreamingIOLoad* load, float maxWaitTimeSec);
+
+/**
+ * Cancels a load that has not been finished, waiting for any read in flight to complete. 
+ * The destination buffer and the file may be released once this function returns.
+ * @param streamingIO The service the load was started with.
+ * @param load The load to cancel.
+ */
+void kwlStreamingIO_cancelLoad(kwlStreamingIO* streamingIO, kwlStreamingIOLoad* load);
+
+/**
+ * Gets the read statistics of a given stream.
+ * @param streamingIO The service the stream was opened with.
+ * @param stream The stream.
+ * @param stats Receives the statistics.
+ */
+void kwlStreamingIO_getStreamStats(kwlStreamingIO* streamingIO,
+                                   kwlStreamingIOStream* stream,
+                                   kwlStreamingIOStats* stats);
+
+/**
+ * Gets the read statistics of all streams, open and closed, of a given service.
+ * @param streamingIO The service.
+ * @param stats Receives the statistics.
+ */
+void kwlStreamingIO_getStats(kwlStreamingIO* streamingIO, kwlStreamingIOStats* stats);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /*KWL_STREAMING_IO_H*/
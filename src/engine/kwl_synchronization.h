@@ -188,6 +188,23 @@ void kwlMutexLockAcquire(kwlMutexLock* lock);
  */
 void kwlMutexLockRelease(kwlMutexLock* lock);
     
+/**
+ * Atomically reads an integer shared between threads. Acts as a full memory barrier.
+ */
+int kwlAtomicLoad(volatile int* value);
+
+/**
+ * Atomically writes an integer shared between threads. Acts as a full memory barrier.
+ */
+void kwlAtomicStore(volatile int* value, int newValue);
+
+/**
+ * Atomically replaces an integer shared between threads if it has a given value. 
+ * Acts as a full memory barrier.
+ * @return Non-zero if the value was replaced, zero otherwise.
+ */
+int kwlAtomicCompareAndSwap(volatile int* value, int expectedValue, int newValue);
+    
 typedef void * (*kwlThreadEntryPoint)(void* data);
     
 void kwlThreadCreate(kwlThread* thread, kwlThreadEntryPoint entryPoint, void* data);
@@ -177,8 +177,8 @@ kwlMutexLockAcquisitionResult kwlMutexLockTryAcquire(kwlMutexLock* lock)
 
 void kwlMutexLockAcquire(kwlMutexLock* lock)
 {
-    int rc = pthread_mutex_trylock(lock);
-    KWL_ASSERT(rc == 0 || rc == EBUSY);
+    int rc = pthread_mutex_lock(lock);
+    KWL_ASSERT(rc == 0);
 }
 
 void kwlMutexLockRelease(kwlMutexLock* lock)
@@ -187,6 +187,25 @@ void kwlMutexLockRelease(kwlMutexLock* lock)
     KWL_ASSERT(rc == 0);
 }
 
+int kwlAtomicLoad(volatile int* value)
+{
+    return __sync_fetch_and_add(value, 0);
+}
+
+void kwlAtomicStore(volatile int* value, int newValue)
+{
+    int oldValue = kwlAtomicLoad(value);
+    while (!__sync_bool_compare_and_swap(value, oldValue, newValue))
+    {
+        oldValue = kwlAtomicLoad(value);
+    }
+}
+
+int kwlAtomicCompareAndSwap(volatile int* value, int expectedValue, int newValue)
+{
+    return __sync_bool_compare_and_swap(value, expectedValue, newValue);
+}
+
 void kwlThreadCreate(kwlThread* thread, kwlThreadEntryPoint entryPoint, void* data)
 {
     int rc = pthread_create(thread, NULL, entryPoint, data);
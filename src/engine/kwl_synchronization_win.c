@@ -69,3 +69,18 @@ void kwlMutexLockRelease(kwlMutexLock* lock)
 {
     LeaveCriticalSection(&lock);
 }
+
+int kwlAtomicLoad(volatile int* value)
+{
+    return InterlockedCompareExchange((volatile LONG*)value, 0, 0);
+}
+
+void kwlAtomicStore(volatile int* value, int newValue)
+{
+    InterlockedExchange((volatile LONG*)value, newValue);
+}
+
+int kwlAtomicCompareAndSwap(volatile int* value, int expectedValue, int newValue)
+{
+    return InterlockedCompareExchange((volatile LONG*)value, newValue, expectedValue) == expectedValue;
+}
@@ -24,42 +24,145 @@
 #include <string.h>
 
 #include "kwl_audiodata.h"
+#include "kwl_decoder.h"
 #include "kwl_memory.h"
 #include "kwl_assert.h"
 #include "kwl_engine.h"
 #include "kwl_wavebank.h"
 
-kwlError kwlWaveBank_verifyWaveBankBinary(kwlEngine* engine, 
-                                          const char* const waveBankPath,
-                                          kwlWaveBank** waveBank)
+/** The number of bytes following the path of a wave bank entry, up to and including its number of data bytes.*/
+#define KWL_WAVE_BANK_ENTRY_HEADER_SIZE (10 * 4)
+
+/** Decodes a big endian 32 bit unsigned integer from a given byte buffer.*/
+static unsigned int kwlWaveBank_decodeUIntBE(const unsigned char* bytes)
 {
-    /*Open the file...*/
-    kwlInputStream stream;
-    kwlError result = kwlInputStream_initWithFile(&stream, waveBankPath);
-    if (result != KWL_NO_ERROR)
+    return ((unsigned int)bytes[0] << 24) | ((unsigned int)bytes[1] << 16) | 
+           ((unsigned int)bytes[2] << 8) | (unsigned int)bytes[3];
+}
+
+/** Decodes a big endian 32 bit integer from a given byte buffer.*/
+static int kwlWaveBank_decodeIntBE(const unsigned char* bytes)
+{
+    return (int)kwlWaveBank_decodeUIntBE(bytes);
+}
+
+/** Returns the 32 bit FNV-1a hash of a given number of characters of a path.*/
+static unsigned int kwlWaveBank_hashPath(const char* path, int length)
+{
+    unsigned int hash = 2166136261u;
+    for (int i = 0; i < length; i++)
     {
-        kwlInputStream_close(&stream);
-        return result;
+        hash ^= (unsigned char)path[i];
+        hash *= 16777619u;
     }
-    /*... and check the wave bank file identifier.*/
-    int i;
-    for (i = 0; i < KWL_WAVE_BANK_BINARY_FILE_IDENTIFIER_LENGTH; i++)
+    return hash;
+}
+
+/** 
+ * Creates an open addressing hash table mapping the file paths of the entries of a given wave bank
+ * to entry indices. Slots hold an entry index plus one, or zero if empty.
+ */
+static int* kwlWaveBank_createEntryIndex(kwlWaveBank* waveBank, kwlArena* arena, int* numSlots)
+{
+    int size = 16;
+    while (size < 2 * waveBank->numAudioDataEntries)
+    {
+        size *= 2;
+    }
+    
+    int* slots = (int*)kwlArena_alloc(arena, size * sizeof(int));
+    kwlMemset(slots, 0, size * sizeof(int));
+    
+    for (int i = 0; i < waveBank->numAudioDataEntries; i++)
+    {
+        const char* path = waveBank->audioDataItems[i].filePath;
+        unsigned int slot = kwlWaveBank_hashPath(path, strlen(path)) & (size - 1);
+        while (slots[slot] != 0)
+        {
+            slot = (slot + 1) & (size - 1);
+        }
+        slots[slot] = i + 1;
+    }
+    
+    *numSlots = size;
+    return slots;
+}
+
+/** Returns non-zero if the path of a given entry equals a given number of characters.*/
+static int kwlWaveBank_entryHasPath(kwlAudioData* entry, const char* path, int length)
+{
+    return strncmp(entry->filePath, path, length) == 0 && entry->filePath[length] == '\0';
+}
+
+/** 
+ * Returns the wave bank entry with a given path, or NULL if there is none. The entry at 
+ * \c expectedIndex is checked first, since wave bank files list entries in the same order
+ * as the engine data.
+ */
+static kwlAudioData* kwlWaveBank_findEntry(kwlWaveBank* waveBank, 
+                                           const int* slots, 
+                                           int numSlots, 
+                                           const char* path, 
+                                           int length,
+                                           int expectedIndex)
+{
+    if (expectedIndex < waveBank->numAudioDataEntries &&
+        kwlWaveBank_entryHasPath(&waveBank->audioDataItems[expectedIndex], path, length) != 0)
+    {
+        return &waveBank->audioDataItems[expectedIndex];
+    }
+    
+    unsigned int slot = kwlWaveBank_hashPath(path, length) & (numSlots - 1);
+    while (slots[slot] != 0)
     {
-        const char identifierChari = kwlInputStream_readChar(&stream);
-        if (identifierChari != KWL_WAVE_BANK_BINARY_FILE_IDENTIFIER[i])
+        kwlAudioData* entry = &waveBank->audioDataItems[slots[slot] - 1];
+        if (kwlWaveBank_entryHasPath(entry, path, length) != 0)
         {
-            /* Not the file identifier we expected. */
-            kwlInputStream_close(&stream);
-            return KWL_UNKNOWN_FILE_FORMAT;
+            return entry;
         }
+        slot = (slot + 1) & (numSlots - 1);
+    }
+    
+    return NULL;
+}
+
+/** Frees the audio data of all entries of a wave bank whose loading failed.*/
+static void kwlWaveBank_discardAudioData(kwlWaveBank* waveBank)
+{
+    for (int i = 0; i < waveBank->numAudioDataEntries; i++)
+    {
+        kwlAudioData_free(&waveBank->audioDataItems[i]);
+    }
+    kwlArena_free(&waveBank->arena);
+    waveBank->waveBankFilePath = NULL;
+}
+
+kwlError kwlWaveBank_readWaveBankBinaryHeader(kwlEngine* engine, 
+                                              kwlInputStream* stream,
+                                              kwlWaveBank** waveBank)
+{
+    /*Check the wave bank file identifier.*/
+    signed char identifier[KWL_WAVE_BANK_BINARY_FILE_IDENTIFIER_LENGTH];
+    int bytesRead = kwlInputStream_read(stream, identifier, KWL_WAVE_BANK_BINARY_FILE_IDENTIFIER_LENGTH);
+    if (bytesRead != KWL_WAVE_BANK_BINARY_FILE_IDENTIFIER_LENGTH ||
+        memcmp(identifier, KWL_WAVE_BANK_BINARY_FILE_IDENTIFIER, KWL_WAVE_BANK_BINARY_FILE_IDENTIFIER_LENGTH) != 0)
+    {
+        /* Not the file identifier we expected. */
+        return KWL_UNKNOWN_FILE_FORMAT;
+    }
+    
+    const int version = kwlInputStream_readIntBE(stream);
+    if (version != KWL_WAVE_BANK_BINARY_VERSION)
+    {
+        return KWL_UNKNOWN_FILE_FORMAT;
     }
     
     /*Read the ID from the wave bank binary file and find a matching wave bank struct.*/
-    const char* waveBankToLoadId = kwlInputStream_readASCIIString(&stream);
-    const int waveBankToLoadnumAudioDataEntries = kwlInputStream_readIntBE(&stream);
+    const char* waveBankToLoadId = kwlInputStream_readASCIIString(stream);
+    const int waveBankToLoadnumAudioDataEntries = kwlInputStream_readIntBE(stream);
     const int numWaveBanks = engine->engineData.numWaveBanks;
     kwlWaveBank* matchingWaveBank = NULL;
-    for (i = 0; i < numWaveBanks; i++)
+    for (int i = 0; i < numWaveBanks; i++)
     {
         if (strcmp(waveBankToLoadId, engine->engineData.waveBanks[i].id) == 0)
         {
@@ -70,87 +173,71 @@ kwlError kwlWaveBank_verifyWaveBankBinary(kwlEngine* engine,
     KWL_FREE((void*)waveBankToLoadId);
     if (matchingWaveBank == NULL)
     {
-        /*No matching bank was found. Close the file stream and return an error.*/
-        kwlInputStream_close(&stream);
+        /*No matching bank was found.*/
         return KWL_NO_MATCHING_WAVE_BANK;
     }
     else if (waveBankToLoadnumAudioDataEntries != matchingWaveBank->numAudioDataEntries)
     {
         /*A matching wave bank was found but the number of audio data entries
          does not match the binary wave bank data.*/
-        kwlInputStream_close(&stream);
         return KWL_WAVE_BANK_ENTRY_MISMATCH;
     }
-    else if (matchingWaveBank->isLoaded != 0)
-    {
-        /*The wave bank is already loaded, just set the handle and do nothing.*/
-        *waveBank = matchingWaveBank;
-        kwlInputStream_close(&stream);
-        return KWL_NO_ERROR;
-    }
+    
+    *waveBank = matchingWaveBank;
+    return KWL_NO_ERROR;
+}
+
+kwlError kwlWaveBank_loadAudioData(kwlWaveBank* waveBank, 
+                                   kwlAudioDataCache* audioDataCache,
+                                   const char* path, 
+                                   kwlInputStream* stream,
+                                   int threaded,
+                                   int loadOnDemand)
+{
+    KWL_ASSERT(waveBank->isLoaded == 0);
+    waveBank->loadOnDemand = loadOnDemand;
+    waveBank->audioDataCache = audioDataCache;
     
     /*Store the path the wave bank was loaded from (used when streaming from disk).*/
-    const int pathLen = strlen(waveBankPath);
-    matchingWaveBank->waveBankFilePath = (char*)KWL_MALLOC((pathLen + 1) * sizeof(char), "wave bank path string");
-    strcpy(matchingWaveBank->waveBankFilePath, waveBankPath);
+    const int pathLen = strlen(path);
+    kwlArena_init(&waveBank->arena, KWL_MEMORY_CATEGORY_WAVE_BANK, pathLen + 1);
+    waveBank->waveBankFilePath = (char*)kwlArena_alloc(&waveBank->arena, (pathLen + 1) * sizeof(char));
+    strcpy(waveBank->waveBankFilePath, path);
     
-    /*Make sure that the entries of the wave bank to load and the wave bank struct line up.*/
-    for (i = 0; i < waveBankToLoadnumAudioDataEntries; i++)
+    if (threaded == 0)
     {
-        const char* filePathi = kwlInputStream_readASCIIString(&stream);
+        /*perform blocking loading*/
+        kwlError result = kwlWaveBank_loadAudioDataItems(waveBank, stream);
         
-        int matchingEntryIndex = -1;
-        int j = 0;
-        for (j = 0; j < waveBankToLoadnumAudioDataEntries; j++)
+        /*Keep the file open for streaming entries, so that streams can 
+          read from it without opening the file every time an event starts.
+          Entries loaded on demand are read from it too.*/
+        int hasStreamingEntries = loadOnDemand;
+        for (int i = 0; i < waveBank->numAudioDataEntries; i++)
         {
-            if (strcmp(matchingWaveBank->audioDataItems[j].filePath, filePathi) == 0)
+            if (waveBank->audioDataItems[i].streamFromDisk != 0)
             {
-                matchingEntryIndex = j;
+                hasStreamingEntries = 1;
                 break;
             }
         }
         
-        KWL_FREE((void*)filePathi);
-        
-        if (matchingEntryIndex < 0)
+        if (result == KWL_NO_ERROR && hasStreamingEntries != 0)
         {
-            /* This wave bank entry has no corresponding waveform slot. Abort loading.*/
-            kwlInputStream_close(&stream);
-            return KWL_WAVE_BANK_ENTRY_MISMATCH;
+            /*take over the file from the stream before closing it.*/
+            waveBank->streamingFile = stream->file;
+            waveBank->fileSystem = stream->fileSystem;
+            stream->file = NULL;
         }
+        kwlInputStream_close(stream);
         
-        /*skip to the next wave data entry*/
-        /*const int encoding = */kwlInputStream_readIntBE(&stream);
-        /*const int streamFromDisk = */kwlInputStream_readIntBE(&stream);
-        const int numChannels = kwlInputStream_readIntBE(&stream);
-        KWL_ASSERT((numChannels == 0 || numChannels == 1 || numChannels == 2) && "invalid num channels");
-        const int numBytes = kwlInputStream_readIntBE(&stream);
-        KWL_ASSERT(numBytes > 0);
-        kwlInputStream_skip(&stream, numBytes);
-    }
-    
-    /* Reading went well. */
-    kwlInputStream_close(&stream);
-    *waveBank = matchingWaveBank;
-    return KWL_NO_ERROR;
-}
-
-kwlError kwlWaveBank_loadAudioData(kwlWaveBank* waveBank, 
-                                   const char* path, 
-                                   int threaded)
-{
-    if (threaded == 0)
-    {
-        /*perform blocking loading*/
-        kwlInputStream stream;
-        kwlInputStream_initWithFile(&stream, path);
-        return kwlWaveBank_loadAudioDataItems(waveBank, &stream);
+        return result;
     }
     else
     {
         KWL_ASSERT(0 && "TODO");
         /*do asynchronous loading*/
-        kwlInputStream_initWithFile(&waveBank->loadingThread.inputStream, path);
+        waveBank->loadingThread.inputStream = *stream;
         waveBank->loadingThread.waveBank = waveBank;
         
         kwlThreadCreate(&waveBank->loadingThread.thread, 
@@ -162,55 +249,109 @@ kwlError kwlWaveBank_loadAudioData(kwlWaveBank* waveBank,
 
 kwlError kwlWaveBank_loadAudioDataItems(kwlWaveBank* waveBank, kwlInputStream* stream)
 {
-    /*The input stream is assumed to be valid, so move the
-      read position to the first audio data entry.*/
-    kwlInputStream_reset(stream);
-    kwlInputStream_skip(stream, KWL_WAVE_BANK_BINARY_FILE_IDENTIFIER_LENGTH);
-    const int strLen = kwlInputStream_readIntBE(stream);
-    kwlInputStream_skip(stream, strLen); 
-    /*int numEntries = */kwlInputStream_readIntBE(stream);
+    const int numEntries = waveBank->numAudioDataEntries;
+    
+    /*The entry index and the header buffer are only needed while loading.*/
+    kwlArena scratch;
+    kwlArena_init(&scratch, KWL_MEMORY_CATEGORY_WAVE_BANK, 4096);
+    int numSlots = 0;
+    int* slots = kwlWaveBank_createEntryIndex(waveBank, &scratch, &numSlots);
     
-    const int waveBankToLoadnumAudioDataEntries = waveBank->numAudioDataEntries;
+    /*The path and the fixed size fields of each entry header are read into this buffer in one go.*/
+    int headerBufferSize = 256 + KWL_WAVE_BANK_ENTRY_HEADER_SIZE;
+    unsigned char* header = (unsigned char*)kwlArena_alloc(&scratch, headerBufferSize);
     
-    for (int i = 0; i < waveBankToLoadnumAudioDataEntries; i++)
+    kwlError result = KWL_NO_ERROR;
+    
+    for (int i = 0; i < numEntries && result == KWL_NO_ERROR; i++)
     {
-        char* const waveEntryIdi = kwlInputStream_readASCIIString(stream);
+        signed char pathLengthBytes[4];
+        if (kwlInputStream_read(stream, pathLengthBytes, 4) != 4)
+        {
+            KWL_ASSERT(0 && "error reading wave bank entry header");
+            result = KWL_CORRUPT_BINARY_DATA;
+            break;
+        }
         
-        kwlAudioData* matchingAudioData = NULL;
-
-        for (int j = 0; j < waveBankToLoadnumAudioDataEntries; j++)
+        const int pathLength = kwlWaveBank_decodeIntBE((unsigned char*)pathLengthBytes);
+        if (pathLength <= 0 || pathLength >= 10000)
         {
-            kwlAudioData* entryj = &waveBank->audioDataItems[j];
-            if (strcmp(entryj->filePath, waveEntryIdi) == 0)
-            {
-                matchingAudioData = entryj;
-                break;
-            }
+            KWL_ASSERT(0 && "invalid wave bank entry path length");
+            result = KWL_CORRUPT_BINARY_DATA;
+            break;
+        }
+        
+        const int headerSize = pathLength + KWL_WAVE_BANK_ENTRY_HEADER_SIZE;
+        if (headerSize > headerBufferSize)
+        {
+            headerBufferSize = headerSize;
+            header = (unsigned char*)kwlArena_alloc(&scratch, headerBufferSize);
         }
-        //printf("    loading %s\n", waveEntryIdi);
-        KWL_FREE(waveEntryIdi);
         
-        const kwlAudioEncoding encoding = (kwlAudioEncoding)kwlInputStream_readIntBE(stream);
-        const int streamFromDisk = kwlInputStream_readIntBE(stream);
-        const int numChannels = kwlInputStream_readIntBE(stream);
-        const int numBytes = kwlInputStream_readIntBE(stream);
+        if (kwlInputStream_read(stream, (signed char*)header, headerSize) != headerSize)
+        {
+            KWL_ASSERT(0 && "error reading wave bank entry header");
+            result = KWL_CORRUPT_BINARY_DATA;
+            break;
+        }
+        
+        kwlAudioData* matchingAudioData = kwlWaveBank_findEntry(waveBank, 
+                                                                slots, 
+                                                                numSlots, 
+                                                                (const char*)header, 
+                                                                pathLength, 
+                                                                i);
+        if (matchingAudioData == NULL || matchingAudioData->isLoaded != 0)
+        {
+            /* This wave bank entry has no corresponding waveform slot or appears twice.*/
+            result = KWL_WAVE_BANK_ENTRY_MISMATCH;
+            break;
+        }
+        
+        const unsigned char* fields = &header[pathLength];
+        const kwlAudioEncoding encoding = (kwlAudioEncoding)kwlWaveBank_decodeIntBE(&fields[0]);
+        const int streamFromDisk = kwlWaveBank_decodeIntBE(&fields[4]);
+        const int numChannels = kwlWaveBank_decodeIntBE(&fields[8]);
+        const int sampleRate = kwlWaveBank_decodeIntBE(&fields[12]);
+        const int loopStart = kwlWaveBank_decodeIntBE(&fields[16]);
+        const int loopEnd = kwlWaveBank_decodeIntBE(&fields[20]);
+        const int prefetchHeadLength = kwlWaveBank_decodeIntBE(&fields[24]);
+        const unsigned int contentHashHi = kwlWaveBank_decodeUIntBE(&fields[28]);
+        const unsigned int contentHashLo = kwlWaveBank_decodeUIntBE(&fields[32]);
+        const unsigned long long contentHash = ((unsigned long long)contentHashHi << 32) | contentHashLo;
+        const int numBytes = kwlWaveBank_decodeIntBE(&fields[36]);
         const int numFrames = numBytes / 2 * numChannels;
         
         /* Check that the audio meta data makes sense */
         if (numBytes <= 0)
         {
             KWL_ASSERT(0 && "the number of audio data bytes must be positive");
-            return KWL_CORRUPT_BINARY_DATA;
-        }
-        if (matchingAudioData == NULL)
-        {
-            KWL_ASSERT(0 && "no matching wave bank entry");
-            return KWL_CORRUPT_BINARY_DATA;
+            result = KWL_CORRUPT_BINARY_DATA;
+            break;
         }
         if (numChannels != 0 && numChannels != 1 && numChannels != 2)
         {
             KWL_ASSERT(0 && "invalid number of channels");
-            return KWL_CORRUPT_BINARY_DATA;
+            result = KWL_CORRUPT_BINARY_DATA;
+            break;
+        }
+        if (sampleRate < 0)
+        {
+            KWL_ASSERT(0 && "invalid sample rate");
+            result = KWL_CORRUPT_BINARY_DATA;
+            break;
+        }
+        if (loopStart < 0 || loopEnd < 0 || (loopEnd > 0 && loopEnd <= loopStart))
+        {
+            KWL_ASSERT(0 && "invalid loop region");
+            result = KWL_CORRUPT_BINARY_DATA;
+            break;
+        }
+        if (prefetchHeadLength < 0)
+        {
+            KWL_ASSERT(0 && "invalid prefetch head length");
+            result = KWL_CORRUPT_BINARY_DATA;
+            break;
         }
         
         /*free any old data*/
@@ -219,34 +360,75 @@ kwlError kwlWaveBank_loadAudioDataItems(kwlWaveBank* waveBank, kwlInputStream* s
         /*Store audio meta data.*/
         matchingAudioData->numFrames = numFrames;
         matchingAudioData->numChannels = numChannels;
+        matchingAudioData->sampleRate = sampleRate;
+        matchingAudioData->loopStart = loopStart;
+        matchingAudioData->loopEnd = loopEnd;
         matchingAudioData->numBytes = numBytes;
+        matchingAudioData->contentHash = contentHash;
         matchingAudioData->encoding = (kwlAudioEncoding)encoding;
         matchingAudioData->streamFromDisk = streamFromDisk;
         matchingAudioData->isLoaded = 1;
         matchingAudioData->bytes = NULL;
         
-        if (streamFromDisk == 0)
+        if (streamFromDisk == 0 && waveBank->loadOnDemand != 0)
         {
-            /*This entry should not be streamed, so allocate audio data up front.*/
-            matchingAudioData->bytes = KWL_MALLOC(numBytes, "kwlEngine_loadWaveBank");
-            
-            int bytesRead = kwlInputStream_read(stream, 
-                                                (signed char*)matchingAudioData->bytes, 
-                                                numBytes);
-            if (bytesRead != numBytes)
+            /*Store the offset of the entry. Its audio data is loaded when first used.*/
+            matchingAudioData->fileOffset = kwlInputStream_tell(stream);
+            kwlInputStream_skip(stream, numBytes);
+        }
+        else if (streamFromDisk == 0)
+        {
+            /*This entry should not be streamed, so load its audio data up front, 
+              unless another loaded wave bank already holds the same data.*/
+            kwlSharedAudioBuffer* sharedBuffer = 
+                kwlAudioDataCache_findBuffer(waveBank->audioDataCache, contentHash, numBytes);
+            if (sharedBuffer != NULL)
+            {
+                kwlInputStream_skip(stream, numBytes);
+            }
+            else
             {
-                KWL_ASSERT(0 && "error reading wave bank audio data bytes");
-                return KWL_CORRUPT_BINARY_DATA;
+                void* bytes = KWL_MALLOC(numBytes, KWL_MEMORY_CATEGORY_AUDIO_DATA, "kwlEngine_loadWaveBank");
+                int bytesRead = kwlInputStream_read(stream, (signed char*)bytes, numBytes);
+                if (bytesRead != numBytes)
+                {
+                    KWL_FREE(bytes);
+                    KWL_ASSERT(0 && "error reading wave bank audio data bytes");
+                    result = KWL_CORRUPT_BINARY_DATA;
+                    break;
+                }
+                sharedBuffer = kwlAudioDataCache_addBuffer(waveBank->audioDataCache, contentHash, numBytes, bytes);
             }
+            
+            matchingAudioData->sharedBuffer = sharedBuffer;
+            matchingAudioData->bytes = sharedBuffer->bytes;
         }
         else
         {
             /*Store the offset into the wave bank binary files for streaming entries.*/
             matchingAudioData->fileOffset = kwlInputStream_tell(stream);
             kwlInputStream_skip(stream, numBytes);
+            
+            if (prefetchHeadLength > 0)
+            {
+                /*Decode the start of the entry, so events can start playing it from memory.*/
+                result = kwlDecoder_createPrefetchHead(matchingAudioData, 
+                                                       waveBank->waveBankFilePath, 
+                                                       stream->fileSystem,
+                                                       prefetchHeadLength);
+            }
         }
     }
     
+    kwlArena_free(&scratch);
+    
+    if (result != KWL_NO_ERROR)
+    {
+        /*Leave the wave bank unloaded, as if loading had not been attempted.*/
+        kwlWaveBank_discardAudioData(waveBank);
+        return result;
+    }
+    
     waveBank->isLoaded = 1;
     return KWL_NO_ERROR;
 }
@@ -283,5 +465,24 @@ void kwlWaveBank_unload(kwlWaveBank* waveBank)
         kwlAudioData_free(wavei);
     }
     waveBank->isLoaded = 0;
-    KWL_FREE(waveBank->waveBankFilePath);
+    kwlArena_free(&waveBank->arena);
+    waveBank->waveBankFilePath = NULL;
+    
+    if (waveBank->streamingFile != NULL)
+    {
+        kwlFileSystem_close(waveBank->fileSystem, waveBank->streamingFile);
+        waveBank->streamingFile = NULL;
+        waveBank->fileSystem = NULL;
+    }
+}
+
+int kwlWaveBank_getPrefetchHeadMemory(kwlWaveBank* waveBank)
+{
+    int numBytes = 0;
+    for (int i = 0; i < waveBank->numAudioDataEntries; i++)
+    {
+        kwlAudioData* audioDatai = &waveBank->audioDataItems[i];
+        numBytes += sizeof(short) * audioDatai->numPrefetchHeadFrames * audioDatai->numPrefetchHeadChannels;
+    }
+    return numBytes;
 }
\ No newline at end of file
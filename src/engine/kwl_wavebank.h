@@ -28,6 +28,8 @@ freely, subject to the following restrictions:
 
 #include "kowalski.h"
 #include "kowalski.h"
+#include "kwl_arena.h"
+#include "kwl_audiodatacache.h"
 #include "kwl_inputstream.h"
 #include "kwl_messagequeue.h"
 #include "kwl_synchronization.h"
@@ -51,6 +53,12 @@ static const char KWL_WAVE_BANK_BINARY_FILE_IDENTIFIER[KWL_WAVE_BANK_BINARY_FILE
     0xAB, 'K', 'W', 'B', 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
 };
 
+/** 
+ * The version of the wave bank binary layout, stored right after the file identifier. 
+ * Wave bank binaries with any other version are rejected.
+ */
+#define KWL_WAVE_BANK_BINARY_VERSION 1
+
 /** 
  * A struct containing everything needed to load
  * a wave bank on a separate thread.
@@ -78,8 +86,27 @@ typedef struct kwlWaveBank
     const char* id;
     /** Non-zero if the wave bank is loaded, zero otherwise*/
     int isLoaded;
+    /** 
+     * Non-zero if only the table of contents of the wave bank was loaded and audio data that is
+     * not streamed from disk is loaded when first used, zero if all such audio data was loaded up front.
+     */
+    int loadOnDemand;
     /** The path to the wave bank file. Empty if the wave bank is not loaded.*/
     char *waveBankFilePath;
+    /** Holds the path and any other tables of the loaded wave bank. Freed in one go on unloading.*/
+    kwlArena arena;
+    /** 
+     * The wave bank file, kept open while the wave bank is loaded if any of its entries are streamed
+     * from disk or loaded on demand. Shared by all decoders streaming from the wave bank. NULL otherwise.
+     */
+    void* streamingFile;
+    /** The file system \c streamingFile was opened with.*/
+    const kwlFileSystem* fileSystem;
+    /** 
+     * The cache through which the audio data of entries is shared with other wave banks.
+     * Set when the wave bank is loaded.
+     */
+    kwlAudioDataCache* audioDataCache;
     /** An array of audio data entries for the wave bank. */
     struct kwlAudioData* audioDataItems;
     /** The number of audio data entries in the wave bank. */
@@ -89,27 +116,38 @@ typedef struct kwlWaveBank
 } kwlWaveBank;
 
 /** 
- * Checks that a wave bank binary at a given path is valid with respect to 
- * currently loaded engine data.
+ * Reads the header of a wave bank binary from the start of a given stream and finds the wave bank
+ * of the currently loaded engine data with the same ID and number of entries. On success, the 
+ * stream is left at the first entry.
  */    
-kwlError kwlWaveBank_verifyWaveBankBinary(struct kwlEngine* engine, 
-                                          const char* const waveBankPath,
-                                          kwlWaveBank** waveBank);
+kwlError kwlWaveBank_readWaveBankBinaryHeader(struct kwlEngine* engine, 
+                                              kwlInputStream* stream,
+                                              kwlWaveBank** waveBank);
     
 /**
- * Loads all audio data items from a given input stream. The stream is assumed
- * to be a valid wave bank data stream.
+ * Loads all audio data items from a given input stream, positioned at the first entry of 
+ * a wave bank binary, in a single pass. Entries are matched to the entries of the wave bank 
+ * by path. If an entry does not match or the data is corrupt, any audio data read so far is
+ * freed and the wave bank is left unloaded. If the wave bank is loaded on demand, only the
+ * meta data of entries that are not streamed is read.
  */
 kwlError kwlWaveBank_loadAudioDataItems(kwlWaveBank* waveBank, kwlInputStream* inputStream);
 
 /**
- * Load wave bank audio data from a file at a given path. If callback is not NULL, this method returns immediately and 
- * loading is performed in a separate thread and the callback gets invoked when loading finishes.
- * If callback is NULL, this function returns when all data has been loaded.
+ * Loads wave bank audio data from a given stream, read from the file at a given path and positioned
+ * at the first entry by \c kwlWaveBank_readWaveBankBinaryHeader. The wave bank takes ownership of
+ * the stream. If \c threaded is non-zero, this method returns immediately and loading is performed in
+ * a separate thread. Otherwise this function returns when all data has been loaded.
+ * If \c loadOnDemand is non-zero, only the table of contents is loaded. Audio data is then
+ * loaded through the residency manager of the engine. Entries with the same content as entries
+ * of other loaded wave banks share their audio data through \c audioDataCache.
  */
 kwlError kwlWaveBank_loadAudioData(kwlWaveBank* waveBank, 
+                                   kwlAudioDataCache* audioDataCache,
                                    const char* path, 
-                                   int threaded);
+                                   kwlInputStream* stream,
+                                   int threaded,
+                                   int loadOnDemand);
     
 /** The entry point for the loading thread.*/
 void* kwlWaveBank_loadingThreadEntryPoint(void* loadingThread);
@@ -117,6 +155,9 @@ void* kwlWaveBank_loadingThreadEntryPoint(void* loadingThread);
 /** */
 void kwlWaveBank_unload(kwlWaveBank* waveBank);
 
+/** Returns the number of bytes used by the prefetch heads of the entries of a given wave bank.*/
+int kwlWaveBank_getPrefetchHeadMemory(kwlWaveBank* waveBank);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */    
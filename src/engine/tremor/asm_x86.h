@@ -0,0 +1,96 @@
+/********************************************************************
+ *                                                                  *
+ * THIS FILE IS PART OF THE OggVorbis 'TREMOR' CODEC SOURCE CODE.   *
+ *                                                                  *
+ * USE, DISTRIBUTION AND REPRODUCTION OF THIS LIBRARY SOURCE IS     *
+ * GOVERNED BY A BSD-STYLE SOURCE LICENSE INCLUDED WITH THIS SOURCE *
+ * IN 'COPYING'. PLEASE READ THESE TERMS BEFORE DISTRIBUTING.       *
+ *                                                                  *
+ * THE OggVorbis 'TREMOR' SOURCE CODE IS (C) COPYRIGHT 1994-2002    *
+ * BY THE Xiph.Org FOUNDATION http://www.xiph.org/                  *
+ *                                                                  *
+ ********************************************************************
+
+ function: x86 SSE2/AVX2 vector wide math functions
+
+ The vector versions of MULT32/MULT31 below produce exactly the same
+ results as the scalar versions in misc.h, lane by lane, so decoder
+ output does not depend on which path is taken.
+ SSE2 is part of the x86-64 baseline and is selected at compile time.
+ AVX2 code is compiled into separate functions and only called after
+ checking the CPU at runtime.  Define _V_NO_SIMD to use the portable
+ C code only.
+
+ ********************************************************************/
+
+#ifndef _V_SIMD_X86_H_
+#define _V_SIMD_X86_H_
+
+#if (defined(__SSE2__) || defined(_M_X64)) && \
+    !defined(_ARM_ASSEM_) && !defined(_LOW_ACCURACY_) && !defined(_V_NO_SIMD)
+#define _V_SIMD_X86
+
+#include <emmintrin.h>
+#ifdef __SSE4_1__
+#include <smmintrin.h>
+#endif
+
+/* high 32 bits of the signed 32x32->64 bit product, four lanes */
+STIN __m128i MULT32_X4(__m128i x, __m128i y) {
+  __m128i hi_mask = _mm_set_epi32(-1, 0, -1, 0);
+#ifdef __SSE4_1__
+  __m128i even = _mm_mul_epi32(x, y);
+  __m128i odd  = _mm_mul_epi32(_mm_srli_epi64(x, 32), _mm_srli_epi64(y, 32));
+  return _mm_or_si128(_mm_srli_epi64(even, 32), _mm_and_si128(odd, hi_mask));
+#else
+  /* SSE2 only has an unsigned multiply; correct the high word for the
+     sign of each operand */
+  __m128i even = _mm_mul_epu32(x, y);
+  __m128i odd  = _mm_mul_epu32(_mm_srli_epi64(x, 32), _mm_srli_epi64(y, 32));
+  __m128i hi   = _mm_or_si128(_mm_srli_epi64(even, 32),
+                              _mm_and_si128(odd, hi_mask));
+  hi = _mm_sub_epi32(hi, _mm_and_si128(_mm_srai_epi32(x, 31), y));
+  return _mm_sub_epi32(hi, _mm_and_si128(_mm_srai_epi32(y, 31), x));
+#endif
+}
+
+STIN __m128i MULT31_X4(__m128i x, __m128i y) {
+  return _mm_slli_epi32(MULT32_X4(x, y), 1);
+}
+
+#define REVERSE_X4(_a)   _mm_shuffle_epi32(_a, _MM_SHUFFLE(0, 1, 2, 3))
+#define LOAD_X4(_p)      _mm_loadu_si128((const __m128i *)(_p))
+#define STORE_X4(_p, _a) _mm_storeu_si128((__m128i *)(_p), _a)
+
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define _V_SIMD_X86_AVX2
+
+#include <immintrin.h>
+
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+STIN int _vorbis_cpu_has_avx2(void) {
+  static int has_avx2 = -1;
+  if (has_avx2 < 0) {
+    __builtin_cpu_init();
+    has_avx2 = __builtin_cpu_supports("avx2") != 0;
+  }
+  return has_avx2;
+}
+
+AVX2_TARGET STIN __m256i MULT31_X8(__m256i x, __m256i y) {
+  __m256i hi_mask = _mm256_set_epi32(-1, 0, -1, 0, -1, 0, -1, 0);
+  __m256i even = _mm256_mul_epi32(x, y);
+  __m256i odd  = _mm256_mul_epi32(_mm256_srli_epi64(x, 32),
+                                  _mm256_srli_epi64(y, 32));
+  __m256i hi   = _mm256_or_si256(_mm256_srli_epi64(even, 32),
+                                 _mm256_and_si256(odd, hi_mask));
+  return _mm256_slli_epi32(hi, 1);
+}
+
+#endif
+
+#endif
+
+#endif
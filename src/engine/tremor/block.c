@@ -254,6 +254,19 @@ void vorbis_dsp_clear(vorbis_dsp_state *v){
    block.  The time domain envelope is not yet handled at the point of
    calling (as it relies on the previous block). */
 
+/* pcm[i]+=p[i] for the overlapping half of two blocks; n is a multiple
+   of 16 */
+STIN void _vorbis_overlap_add(ogg_int32_t *pcm,const ogg_int32_t *p,int n){
+  int i;
+#ifdef _V_SIMD_X86
+  for(i=0;i<n;i+=4)
+    STORE_X4(pcm+i,_mm_add_epi32(LOAD_X4(pcm+i),LOAD_X4(p+i)));
+#else
+  for(i=0;i<n;i++)
+    pcm[i]+=p[i];
+#endif
+}
+
 int vorbis_synthesis_blockin(vorbis_dsp_state *v,vorbis_block *vb){
   vorbis_info *vi=v->vi;
   codec_setup_info *ci=(codec_setup_info *)vi->codec_setup;
@@ -304,30 +317,26 @@ int vorbis_synthesis_blockin(vorbis_dsp_state *v,vorbis_block *vb){
 	  /* large/large */
 	  ogg_int32_t *pcm=v->pcm[j]+prevCenter;
 	  ogg_int32_t *p=vb->pcm[j];
-	  for(i=0;i<n1;i++)
-	    pcm[i]+=p[i];
+	  _vorbis_overlap_add(pcm,p,n1);
 	}else{
 	  /* large/small */
 	  ogg_int32_t *pcm=v->pcm[j]+prevCenter+n1/2-n0/2;
 	  ogg_int32_t *p=vb->pcm[j];
-	  for(i=0;i<n0;i++)
-	    pcm[i]+=p[i];
+	  _vorbis_overlap_add(pcm,p,n0);
 	}
       }else{
 	if(v->W){
 	  /* small/large */
 	  ogg_int32_t *pcm=v->pcm[j]+prevCenter;
 	  ogg_int32_t *p=vb->pcm[j]+n1/2-n0/2;
-	  for(i=0;i<n0;i++)
-	    pcm[i]+=p[i];
-	  for(;i<n1/2+n0/2;i++)
+	  _vorbis_overlap_add(pcm,p,n0);
+	  for(i=n0;i<n1/2+n0/2;i++)
 	    pcm[i]=p[i];
 	}else{
 	  /* small/small */
 	  ogg_int32_t *pcm=v->pcm[j]+prevCenter;
 	  ogg_int32_t *p=vb->pcm[j];
-	  for(i=0;i<n0;i++)
-	    pcm[i]+=p[i];
+	  _vorbis_overlap_add(pcm,p,n0);
 	}
       }
       
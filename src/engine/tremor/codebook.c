@@ -264,6 +264,21 @@ long vorbis_book_decodev_add(codebook *book,ogg_int32_t *a,
     ogg_int32_t *t;
     int shift=point-book->binarypoint;
     
+#ifdef _V_SIMD_X86
+    if((book->dim&3)==0){
+      __m128i count=_mm_cvtsi32_si128(shift>=0?shift:-shift);
+      for(i=0;i<n;){
+	entry = decode_packed_entry_number(book,b);
+	if(entry==-1)return(-1);
+	t     = book->valuelist+entry*book->dim;
+	for (j=0;j<book->dim;i+=4,j+=4){
+	  __m128i v=LOAD_X4(t+j);
+	  v=shift>=0?_mm_sra_epi32(v,count):_mm_sll_epi32(v,count);
+	  STORE_X4(a+i,_mm_add_epi32(LOAD_X4(a+i),v));
+	}
+      }
+    }else
+#endif
     if(shift>=0){
       for(i=0;i<n;){
 	entry = decode_packed_entry_number(book,b);
@@ -333,6 +348,35 @@ long vorbis_book_decodevv_add(codebook *book,ogg_int32_t **a,\
     int chptr=0;
     int shift=point-book->binarypoint;
     
+#ifdef _V_SIMD_X86
+    /* stereo with an even dimension never leaves an entry half way
+       through a sample frame, so each group of four values adds to two
+       frames */
+    if(ch==2 && (book->dim&3)==0){
+      __m128i count=_mm_cvtsi32_si128(shift>=0?shift:-shift);
+      ogg_int32_t *a0=a[0];
+      ogg_int32_t *a1=a[1];
+      for(i=offset;i<offset+n;){
+	entry = decode_packed_entry_number(book,b);
+	if(entry==-1)return(-1);
+	{
+	  const ogg_int32_t *t = book->valuelist+entry*book->dim;
+	  for (j=0;j<book->dim;j+=4,i+=2){
+	    __m128i v=LOAD_X4(t+j);
+	    v=shift>=0?_mm_sra_epi32(v,count):_mm_sll_epi32(v,count);
+	    v=_mm_shuffle_epi32(v,_MM_SHUFFLE(3,1,2,0));
+	    _mm_storel_epi64((__m128i *)(a0+i),
+			     _mm_add_epi32(_mm_loadl_epi64((__m128i *)(a0+i)),v));
+	    _mm_storel_epi64((__m128i *)(a1+i),
+			     _mm_add_epi32(_mm_loadl_epi64((__m128i *)(a1+i)),
+					   _mm_unpackhi_epi64(v,v)));
+	  }
+	}
+      }
+      return(0);
+    }
+#endif
+
     if(shift>=0){
       
       for(i=offset;i<offset+n;){
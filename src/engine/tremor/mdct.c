@@ -144,6 +144,88 @@ STIN void mdct_butterfly_32(DATA_TYPE *x){
 	   mdct_butterfly_16(x+16);
 }
 
+#ifdef _V_SIMD_X86_AVX2
+
+/* Eight (even,odd) pairs of the generic butterfly per step, which is two
+   steps of the scalar loops.  The in-lane shuffles leave the pairs of
+   the lower eight values in lanes 0,1,4,5 and those of the upper eight
+   in lanes 2,3,6,7; the unpacks undo this on the way out and GATHER_X8
+   loads T in the matching order. */
+
+#define GATHER_X8(_T, _s)						\
+  _mm256_set_epi32((_T)[0], (_T)[(_s)], (_T)[4*(_s)], (_T)[5*(_s)],	\
+		   (_T)[2*(_s)], (_T)[3*(_s)], (_T)[6*(_s)], (_T)[7*(_s)])
+#define EVENS_X8(_a, _b)						\
+  _mm256_castps_si256(_mm256_shuffle_ps(_mm256_castsi256_ps(_a),	\
+					_mm256_castsi256_ps(_b),	\
+					_MM_SHUFFLE(2, 0, 2, 0)))
+#define ODDS_X8(_a, _b)							\
+  _mm256_castps_si256(_mm256_shuffle_ps(_mm256_castsi256_ps(_a),	\
+					_mm256_castsi256_ps(_b),	\
+					_MM_SHUFFLE(3, 1, 3, 1)))
+#define XPROD31_X8(_a, _b, _t, _v, _x, _y)				\
+  { _x = _mm256_add_epi32(MULT31_X8(_a, _t), MULT31_X8(_b, _v));	\
+    _y = _mm256_sub_epi32(MULT31_X8(_b, _t), MULT31_X8(_a, _v)); }
+#define XNPROD31_X8(_a, _b, _t, _v, _x, _y)				\
+  { _x = _mm256_sub_epi32(MULT31_X8(_a, _t), MULT31_X8(_b, _v));	\
+    _y = _mm256_add_epi32(MULT31_X8(_b, _t), MULT31_X8(_a, _v)); }
+
+#define BUTTERFLY_LOAD_X8						\
+  a0 = _mm256_loadu_si256((const __m256i *)(x1-8));			\
+  a1 = _mm256_loadu_si256((const __m256i *)x1);				\
+  b0 = _mm256_loadu_si256((const __m256i *)(x2-8));			\
+  b1 = _mm256_loadu_si256((const __m256i *)x2);				\
+  _mm256_storeu_si256((__m256i *)(x1-8), _mm256_add_epi32(a0, b0));	\
+  _mm256_storeu_si256((__m256i *)x1, _mm256_add_epi32(a1, b1))
+
+#define BUTTERFLY_STORE_X8						\
+  _mm256_storeu_si256((__m256i *)(x2-8), _mm256_unpacklo_epi32(xo, yo)); \
+  _mm256_storeu_si256((__m256i *)x2, _mm256_unpackhi_epi32(xo, yo))
+
+AVX2_TARGET
+static void mdct_butterfly_generic_x8(DATA_TYPE *x,int points,int step){
+
+  LOOKUP_T *T   = sincos_lookup0;
+  DATA_TYPE *x1        = x + points      - 8;
+  DATA_TYPE *x2        = x + (points>>1) - 8;
+  __m256i    a0, a1, b0, b1, r0, r1, xo, yo;
+
+  do{
+    BUTTERFLY_LOAD_X8;
+    r0 = EVENS_X8(_mm256_sub_epi32(a0, b0), _mm256_sub_epi32(a1, b1));
+    r1 = ODDS_X8(_mm256_sub_epi32(b0, a0), _mm256_sub_epi32(b1, a1));
+    XPROD31_X8( r1, r0, GATHER_X8(T,step), GATHER_X8(T+1,step), xo, yo );
+    BUTTERFLY_STORE_X8;
+    T+=8*step; x1-=16; x2-=16;
+  }while(T<sincos_lookup0+1024);
+  do{
+    BUTTERFLY_LOAD_X8;
+    r0 = EVENS_X8(_mm256_sub_epi32(a0, b0), _mm256_sub_epi32(a1, b1));
+    r1 = ODDS_X8(_mm256_sub_epi32(a0, b0), _mm256_sub_epi32(a1, b1));
+    XNPROD31_X8( r0, r1, GATHER_X8(T,-step), GATHER_X8(T+1,-step), xo, yo );
+    BUTTERFLY_STORE_X8;
+    T-=8*step; x1-=16; x2-=16;
+  }while(T>sincos_lookup0);
+  do{
+    BUTTERFLY_LOAD_X8;
+    r0 = EVENS_X8(_mm256_sub_epi32(b0, a0), _mm256_sub_epi32(b1, a1));
+    r1 = ODDS_X8(_mm256_sub_epi32(b0, a0), _mm256_sub_epi32(b1, a1));
+    XPROD31_X8( r0, r1, GATHER_X8(T,step), GATHER_X8(T+1,step), xo, yo );
+    BUTTERFLY_STORE_X8;
+    T+=8*step; x1-=16; x2-=16;
+  }while(T<sincos_lookup0+1024);
+  do{
+    BUTTERFLY_LOAD_X8;
+    r0 = EVENS_X8(_mm256_sub_epi32(a0, b0), _mm256_sub_epi32(a1, b1));
+    r1 = ODDS_X8(_mm256_sub_epi32(b0, a0), _mm256_sub_epi32(b1, a1));
+    XNPROD31_X8( r1, r0, GATHER_X8(T,-step), GATHER_X8(T+1,-step), xo, yo );
+    BUTTERFLY_STORE_X8;
+    T-=8*step; x1-=16; x2-=16;
+  }while(T>sincos_lookup0);
+}
+
+#endif
+
 /* N/stage point generic N stage butterfly (in place, 2 register) */
 STIN void mdct_butterfly_generic(DATA_TYPE *x,int points,int step){
 
@@ -153,6 +235,15 @@ STIN void mdct_butterfly_generic(DATA_TYPE *x,int points,int step){
   REG_TYPE   r0;
   REG_TYPE   r1;
 
+#ifdef _V_SIMD_X86_AVX2
+  /* each loop below runs 256/step times, so this is even unless step
+     is 256 */
+  if(step<256 && _vorbis_cpu_has_avx2()){
+    mdct_butterfly_generic_x8(x,points,step);
+    return;
+  }
+#endif
+
   do{
     r0 = x1[6] - x2[6]; x1[6] += x2[6];
     r1 = x2[7] - x1[7]; x1[7] += x2[7];
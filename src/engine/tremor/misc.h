@@ -21,6 +21,7 @@
 #include "os.h"
 
 #include "asm_arm.h"
+#include "asm_x86.h"
 #include <stdlib.h> /* for abs() */
   
 #ifndef _V_WIDE_MATH
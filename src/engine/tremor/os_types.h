@@ -27,10 +27,12 @@
 
 /* make it easy on the folks that want to compile the libs with a
    different malloc than stdlib */
-#define _ogg_malloc  malloc
-#define _ogg_calloc  calloc
-#define _ogg_realloc realloc
-#define _ogg_free    free
+/* Kowalski: allocate through the engine allocator */
+#include "../kwl_memory.h"
+#define _ogg_malloc(size)        kwlMalloc(size, KWL_MEMORY_CATEGORY_DECODER)
+#define _ogg_calloc(num, size)   kwlMallocAndZero((num) * (size), KWL_MEMORY_CATEGORY_DECODER)
+#define _ogg_realloc(ptr, size)  kwlRealloc(ptr, size, KWL_MEMORY_CATEGORY_DECODER)
+#define _ogg_free(ptr)           kwlFree(ptr)
 
 #ifdef _WIN32 
 
@@ -1507,6 +1507,8 @@ int ov_pcm_seek_page(OggVorbis_File *vf,ogg_int64_t pos){
             if(ogg_page_serialno(&og)==vf->current_serialno &&
                (ogg_page_granulepos(&og)>-1 ||
                 !ogg_page_continued(&og))){
+	      ogg_page_release(&og);
+	      ogg_packet_release(&op);
 	      return ov_raw_seek(vf,result);
 	    }
 	    vf->offset=result;
@@ -1851,6 +1853,32 @@ long ov_read(OggVorbis_File *vf,char *buffer,int bytes_req,int *bitstream){
     if(samples>(bytes_req/(2*channels)))
       samples=bytes_req/(2*channels);      
     
+#ifdef _V_SIMD_X86
+    /* packs_epi32 saturates exactly like CLIP_TO_15 */
+    if(channels==2){
+      ogg_int32_t *l=pcm[0];
+      ogg_int32_t *r=pcm[1];
+      short *dest=(short *)buffer;
+      for(j=0;j+4<=samples;j+=4,dest+=8){
+	__m128i lv=_mm_srai_epi32(LOAD_X4(l+j),9);
+	__m128i rv=_mm_srai_epi32(LOAD_X4(r+j),9);
+	STORE_X4(dest,_mm_packs_epi32(_mm_unpacklo_epi32(lv,rv),
+				       _mm_unpackhi_epi32(lv,rv)));
+      }
+      for(;j<samples;j++){
+	*dest++=CLIP_TO_15(l[j]>>9);
+	*dest++=CLIP_TO_15(r[j]>>9);
+      }
+    }else if(channels==1){
+      ogg_int32_t *src=pcm[0];
+      short *dest=(short *)buffer;
+      for(j=0;j+8<=samples;j+=8)
+	STORE_X4(dest+j,_mm_packs_epi32(_mm_srai_epi32(LOAD_X4(src+j),9),
+					 _mm_srai_epi32(LOAD_X4(src+j+4),9)));
+      for(;j<samples;j++)
+	dest[j]=CLIP_TO_15(src[j]>>9);
+    }else
+#endif
     for(i=0;i<channels;i++) { /* It's faster in this order */
       ogg_int32_t *src=pcm[i];
       short *dest=((short *)buffer)+i;
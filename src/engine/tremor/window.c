@@ -52,6 +52,67 @@ const void *_vorbis_window(int type, int left){
   }
 }
 
+#ifdef _V_SIMD_X86_AVX2
+
+AVX2_TARGET
+static void _vorbis_apply_window_x8(ogg_int32_t *d,LOOKUP_T *window,
+				    long begin,long end,int reverse){
+  const __m256i order=_mm256_set_epi32(0,1,2,3,4,5,6,7);
+  long i=begin;
+  long p=reverse?end-begin-8:0;
+
+  for(;i+8<=end;i+=8){
+    __m256i w=_mm256_loadu_si256((const __m256i *)(window+p));
+    __m256i v=_mm256_loadu_si256((const __m256i *)(d+i));
+    if(reverse){
+      w=_mm256_permutevar8x32_epi32(w,order);
+      p-=8;
+    }else
+      p+=8;
+    _mm256_storeu_si256((__m256i *)(d+i),MULT31_X8(v,w));
+  }
+}
+
+#endif
+
+/* Multiplies d[begin..end) by the window, or by the window read back to
+   front when reverse is set.  The window halves are at least 32 long, so
+   only the vector loop is needed. */
+STIN void _vorbis_apply_window_part(ogg_int32_t *d,LOOKUP_T *window,
+				    long begin,long end,int reverse){
+#ifdef _V_SIMD_X86
+  long i=begin;
+  long p=reverse?end-begin-4:0;
+
+#ifdef _V_SIMD_X86_AVX2
+  if(_vorbis_cpu_has_avx2()){
+    _vorbis_apply_window_x8(d,window,begin,end,reverse);
+    return;
+  }
+#endif
+
+  for(;i+4<=end;i+=4){
+    __m128i w=LOAD_X4(window+p);
+    if(reverse){
+      w=REVERSE_X4(w);
+      p-=4;
+    }else
+      p+=4;
+    STORE_X4(d+i,MULT31_X4(LOAD_X4(d+i),w));
+  }
+#else
+  long i,p;
+
+  if(reverse){
+    for(i=begin,p=end-begin-1;i<end;i++,p--)
+      d[i]=MULT31(d[i],window[p]);
+  }else{
+    for(i=begin,p=0;i<end;i++,p++)
+      d[i]=MULT31(d[i],window[p]);
+  }
+#endif
+}
+
 void _vorbis_apply_window(ogg_int32_t *d,const void *window_p[2],
 			  long *blocksizes,
 			  int lW,int W,int nW){
@@ -66,17 +127,14 @@ void _vorbis_apply_window(ogg_int32_t *d,const void *window_p[2],
   long rightbegin=n/2+n/4-rn/4;
   long rightend=rightbegin+rn/2;
   
-  int i,p;
+  int i;
 
   for(i=0;i<leftbegin;i++)
     d[i]=0;
 
-  for(p=0;i<leftend;i++,p++)
-    d[i]=MULT31(d[i],window[lW][p]);
-
-  for(i=rightbegin,p=rn/2-1;i<rightend;i++,p--)
-    d[i]=MULT31(d[i],window[nW][p]);
+  _vorbis_apply_window_part(d,window[lW],leftbegin,leftend,0);
+  _vorbis_apply_window_part(d,window[nW],rightbegin,rightend,1);
 
-  for(;i<n;i++)
+  for(i=rightend;i<n;i++)
     d[i]=0;
 }
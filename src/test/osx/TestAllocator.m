@@ -0,0 +1,233 @@
+/*
+ Copyright (c) 2010-2012 Per Gantelius
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any damages
+ arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it
+ freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must not
+ claim that you wrote the original software. If you use this software
+ in a product, an acknowledgment in the product documentation would be
+ appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and must not be
+ misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#import "TestAllocator.h"
+
+#import "kowalski.h"
+#import "TestUtil.h"
+
+#import <libkern/OSAtomic.h>
+#import <unistd.h>
+
+/***************************************************************************
+ * COUNTING ALLOCATOR
+ ***************************************************************************/
+
+/** Written in front of every block handed out by the counting allocator.*/
+#define COUNTING_ALLOCATOR_MAGIC 0x6b776c41
+
+/** Per category allocation counts of the counting allocator.*/
+typedef struct
+{
+    volatile int32_t numAllocations[KWL_NUM_MEMORY_CATEGORIES];
+    volatile int32_t numLiveBlocks[KWL_NUM_MEMORY_CATEGORIES];
+    volatile int32_t numForeignFrees;
+} CountingAllocator;
+
+/** The header of blocks from the counting allocator, keeping the payload 16 byte aligned.*/
+typedef struct
+{
+    int32_t magic;
+    int32_t category;
+    int64_t padding;
+} CountingBlockHeader;
+
+static void* countingAlloc(void* userData, size_t size, kwlMemoryCategory category)
+{
+    CountingAllocator* allocator = (CountingAllocator*)userData;
+    CountingBlockHeader* header = (CountingBlockHeader*)malloc(sizeof(CountingBlockHeader) + size);
+    header->magic = COUNTING_ALLOCATOR_MAGIC;
+    header->category = category;
+    OSAtomicIncrement32Barrier(&allocator->numAllocations[category]);
+    OSAtomicIncrement32Barrier(&allocator->numLiveBlocks[category]);
+    return header + 1;
+}
+
+static void* countingRealloc(void* userData, void* pointer, size_t size, kwlMemoryCategory category)
+{
+    CountingBlockHeader* header = (CountingBlockHeader*)pointer - 1;
+    if (header->magic != COUNTING_ALLOCATOR_MAGIC)
+    {
+        OSAtomicIncrement32Barrier(&((CountingAllocator*)userData)->numForeignFrees);
+        return NULL;
+    }
+    header = (CountingBlockHeader*)realloc(header, sizeof(CountingBlockHeader) + size);
+    return header + 1;
+}
+
+static void* countingAlignedAlloc(void* userData, size_t size, size_t alignment, kwlMemoryCategory category)
+{
+    /*blocks are only 16 byte aligned, so this only works for the alignments the engine uses.*/
+    if (alignment > sizeof(CountingBlockHeader))
+    {
+        return NULL;
+    }
+    return countingAlloc(userData, size, category);
+}
+
+static void countingFree(void* userData, void* pointer, kwlMemoryCategory category)
+{
+    CountingAllocator* allocator = (CountingAllocator*)userData;
+    CountingBlockHeader* header = (CountingBlockHeader*)pointer - 1;
+    if (header->magic != COUNTING_ALLOCATOR_MAGIC)
+    {
+        OSAtomicIncrement32Barrier(&allocator->numForeignFrees);
+        return;
+    }
+    OSAtomicDecrement32Barrier(&allocator->numLiveBlocks[header->category]);
+    header->magic = 0;
+    free(header);
+}
+
+@implementation TestAllocator
+
+- (void)setUp
+{
+    [super setUp];
+    
+    // Set-up code here.
+}
+
+- (void)tearDown
+{
+    // Tear-down code here.
+    
+    [super tearDown];
+}
+
+/***************************************************************************
+ * LIFECYCLE TESTS
+ ***************************************************************************/
+
+-(void)testEngineLifecycleUsesAllocator
+{
+    /*build a project with one entry loaded into memory and one streamed from disk.*/
+    NSString* dir = [NSTemporaryDirectory() stringByAppendingPathComponent:@"kwl_test_allocator"];
+    [TestUtil createEmptyDirectory:dir];
+    [TestUtil writeWAV:[dir stringByAppendingPathComponent:@"memory.wav"] :4410];
+    [TestUtil writeWAV:[dir stringByAppendingPathComponent:@"streamed.wav"] :88200];
+    [TestUtil writeWAV:[dir stringByAppendingPathComponent:@"freeform.wav"] :4410];
+    NSString* audioDataXML = [[TestUtil audioDataXML:@"memory.wav" :NO] 
+                              stringByAppendingString:[TestUtil audioDataXML:@"streamed.wav" :YES]];
+    NSString* eventsXML = [[TestUtil eventXML:@"memory" :@"memory.wav"] 
+                           stringByAppendingString:[TestUtil eventXML:@"streamed" :@"streamed.wav"]];
+    STAssertEquals([TestUtil buildProject:dir :audioDataXML :eventsXML],
+                   KWL_SUCCESS,
+                   @"failed to build the project");
+    
+    NSString* engineDataPath = [dir stringByAppendingPathComponent:@"project.kwl"];
+    NSString* waveBankPath = [dir stringByAppendingPathComponent:@"bank.kwb"];
+    NSString* freeformPath = [dir stringByAppendingPathComponent:@"freeform.wav"];
+    
+    kwlMemoryStats statsBefore[KWL_NUM_MEMORY_CATEGORIES];
+    for (int i = 0; i < KWL_NUM_MEMORY_CATEGORIES; i++)
+    {
+        kwlGetMemoryStats((kwlMemoryCategory)i, &statsBefore[i]);
+    }
+    
+    CountingAllocator countingAllocator;
+    memset(&countingAllocator, 0, sizeof(CountingAllocator));
+    kwlAllocator allocator;
+    allocator.alloc = countingAlloc;
+    allocator.realloc = countingRealloc;
+    allocator.alignedAlloc = countingAlignedAlloc;
+    allocator.free = countingFree;
+    allocator.userData = &countingAllocator;
+    
+    kwlInitializeWithAllocator(44100, 2, 0, 512, NULL, &allocator);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to initialize the engine");
+    
+    kwlEngineDataLoad([engineDataPath UTF8String]);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to load engine data");
+    kwlWaveBankHandle waveBank = kwlWaveBankLoad([waveBankPath UTF8String]);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to load the wave bank");
+    
+    /*play data driven events, one of them streamed, and a freeform event to the end.*/
+    kwlEventHandle memoryEvent = kwlEventGetHandle("memory");
+    kwlEventHandle streamedEvent = kwlEventGetHandle("streamed");
+    kwlEventHandle freeformEvent = kwlEventCreateWithFile([freeformPath UTF8String], KWL_NONPOSITIONAL, 0);
+    kwlEventStart(memoryEvent);
+    kwlEventStart(streamedEvent);
+    kwlEventStart(freeformEvent);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to start events");
+    for (int i = 0; i < 500 && (kwlEventIsPlaying(memoryEvent) || 
+                                kwlEventIsPlaying(streamedEvent) ||
+                                kwlEventIsPlaying(freeformEvent)); i++)
+    {
+        kwlUpdate(0.01f);
+        usleep(10000);
+    }
+    STAssertFalse(kwlEventIsPlaying(streamedEvent), @"the streamed event should have finished playing");
+    
+    kwlEventRelease(memoryEvent);
+    kwlEventRelease(streamedEvent);
+    kwlEventRelease(freeformEvent);
+    kwlWaveBankUnload(waveBank);
+    kwlEngineDataUnload();
+    kwlDeinitialize();
+    
+    STAssertEquals(countingAllocator.numForeignFrees, 0, @"blocks not allocated by the allocator were freed through it");
+    const kwlMemoryCategory expectedCategories[] = 
+    {
+        KWL_MEMORY_CATEGORY_ENGINE_DATA,
+        KWL_MEMORY_CATEGORY_WAVE_BANK,
+        KWL_MEMORY_CATEGORY_AUDIO_DATA,
+        KWL_MEMORY_CATEGORY_EVENT,
+        KWL_MEMORY_CATEGORY_DECODER,
+        KWL_MEMORY_CATEGORY_MIXER,
+        KWL_MEMORY_CATEGORY_STREAMING
+    };
+    for (int i = 0; i < sizeof(expectedCategories) / sizeof(kwlMemoryCategory); i++)
+    {
+        STAssertTrue(countingAllocator.numAllocations[expectedCategories[i]] > 0, 
+                     @"no allocations were made in category %d", expectedCategories[i]);
+    }
+    
+    for (int i = 0; i < KWL_NUM_MEMORY_CATEGORIES; i++)
+    {
+        STAssertEquals(countingAllocator.numLiveBlocks[i], 0, @"blocks of category %d were leaked", i);
+        
+        /*every allocation the engine made while it was running went through the allocator.*/
+        kwlMemoryStats statsAfter;
+        kwlGetMemoryStats((kwlMemoryCategory)i, &statsAfter);
+        STAssertEquals(statsAfter.numAllocations - statsBefore[i].numAllocations, 
+                       countingAllocator.numAllocations[i], 
+                       @"allocations of category %d bypassed the allocator", i);
+        STAssertEquals(statsAfter.numLiveAllocations, statsBefore[i].numLiveAllocations, 
+                       @"the engine reports live blocks of category %d", i);
+    }
+    
+    [[NSFileManager defaultManager] removeItemAtPath:dir error:NULL];
+}
+
+-(void)testInvalidAllocator
+{
+    kwlAllocator allocator;
+    memset(&allocator, 0, sizeof(kwlAllocator));
+    kwlInitializeWithAllocator(44100, 2, 0, 512, NULL, &allocator);
+    STAssertEquals(kwlGetError(), KWL_INVALID_PARAMETER_VALUE, @"an allocator without callbacks should be rejected");
+    STAssertFalse(kwlIsEngineInitialized(), @"the engine should not be initialized");
+}
+
+@end
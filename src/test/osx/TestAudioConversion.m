@@ -0,0 +1,125 @@
+/*
+ Copyright (c) 2010-2012 Per Gantelius
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any damages
+ arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it
+ freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must not
+ claim that you wrote the original software. If you use this software
+ in a product, an acknowledgment in the product documentation would be
+ appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and must not be
+ misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#import "TestAudioConversion.h"
+
+#import "kwl_memory.h"
+
+#import <math.h>
+
+@implementation TestAudioConversion
+
+/***************************************************************************
+ * RESAMPLING
+ ***************************************************************************/
+
+-(void)testResamplingRoundTripPreservesSine
+{
+    const int numFrames = 44100;
+    const float frequency = 1000.0f;
+    const float amplitude = 8000.0f;
+    
+    short* samples = (short*)KWL_MALLOC(numFrames * sizeof(short), KWL_MEMORY_CATEGORY_GENERAL, "test sine");
+    for (int i = 0; i < numFrames; i++)
+    {
+        samples[i] = (short)lrintf(amplitude * sinf(2.0f * M_PI * frequency * i / 44100.0f));
+    }
+    
+    kwlAudioData source;
+    kwlMemset(&source, 0, sizeof(kwlAudioData));
+    source.bytes = samples;
+    source.numBytes = numFrames * sizeof(short);
+    source.numFrames = numFrames;
+    source.numChannels = 1;
+    source.sampleRate = 44100;
+    source.encoding = KWL_ENCODING_SIGNED_16BIT_PCM;
+    
+    kwlAudioConversionJob downJob;
+    kwlAudioData downsampled;
+    [self convert:&source :22050 :&downJob :&downsampled];
+    STAssertEquals(downsampled.numFrames, numFrames / 2, @"unexpected downsampled frame count");
+    
+    kwlAudioConversionJob upJob;
+    kwlAudioData result;
+    [self convert:&downsampled :44100 :&upJob :&result];
+    STAssertEquals(result.numFrames, numFrames, @"unexpected round trip frame count");
+    
+    /*skip the edges, where the filter kernel runs past the ends of the input*/
+    const short* output = (const short*)result.bytes;
+    const int margin = 1000;
+    int numZeroCrossings = 0;
+    double sumOfSquares = 0.0;
+    double sumOfSquaredErrors = 0.0;
+    for (int i = margin; i < numFrames - margin; i++)
+    {
+        if ((output[i - 1] < 0) != (output[i] < 0))
+        {
+            numZeroCrossings++;
+        }
+        sumOfSquares += (double)output[i] * output[i];
+        sumOfSquaredErrors += ((double)output[i] - samples[i]) * ((double)output[i] - samples[i]);
+    }
+    
+    const int numCheckedFrames = numFrames - 2 * margin;
+    const double expectedZeroCrossings = 2.0 * frequency * numCheckedFrames / 44100.0;
+    const double measuredAmplitude = sqrt(2.0 * sumOfSquares / numCheckedFrames);
+    const double rmsError = sqrt(sumOfSquaredErrors / numCheckedFrames);
+    
+    STAssertEqualsWithAccuracy((double)numZeroCrossings, expectedZeroCrossings, 0.01 * expectedZeroCrossings, 
+                               @"the round trip should preserve the frequency");
+    STAssertEqualsWithAccuracy(measuredAmplitude, (double)amplitude, 0.01 * amplitude, 
+                               @"the round trip should preserve the amplitude");
+    STAssertTrue(rmsError < 0.01 * amplitude, @"the round trip should reproduce the input, rms error %f", rmsError);
+    
+    KWL_FREE(upJob.output);
+    KWL_FREE(downJob.output);
+    KWL_FREE(samples);
+}
+
+/***************************************************************************
+ * HELPER METHODS
+ ***************************************************************************/
+
+-(void)convert:(kwlAudioData*)audioData 
+              :(int)sampleRate 
+              :(kwlAudioConversionJob*)job 
+              :(kwlAudioData*)result
+{
+    kwlAudioConversionSettings settings;
+    kwlMemset(&settings, 0, sizeof(kwlAudioConversionSettings));
+    settings.targetSampleRate = sampleRate;
+    
+    kwlAudioConversionJob_init(job, &settings, audioData, 0);
+    kwlAudioConversionJob_process(job);
+    
+    kwlMemset(result, 0, sizeof(kwlAudioData));
+    result->bytes = job->output;
+    result->numBytes = job->numOutputBytes;
+    result->numFrames = job->numOutputFrames;
+    result->numChannels = job->numOutputChannels;
+    result->sampleRate = job->outputSampleRate;
+    result->encoding = KWL_ENCODING_SIGNED_16BIT_PCM;
+}
+
+@end
@@ -0,0 +1,158 @@
+/*
+ Copyright (c) 2010-2012 Per Gantelius
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any damages
+ arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it
+ freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must not
+ claim that you wrote the original software. If you use this software
+ in a product, an acknowledgment in the product documentation would be
+ appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and must not be
+ misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#import "TestCommandBuffers.h"
+
+#import "kowalski.h"
+#import "TestUtil.h"
+
+#define NUM_PRODUCERS 8
+#define NUM_COMMANDS_PER_PRODUCER 1000
+
+@implementation TestCommandBuffers
+
+- (void)setUp
+{
+    [super setUp];
+    
+    /*build a project with one entry streamed from disk and one loaded into memory.*/
+    NSString* dir = [self testDirectory];
+    [TestUtil createEmptyDirectory:dir];
+    [TestUtil writeWAV:[dir stringByAppendingPathComponent:@"streamed.wav"] :441000];
+    [TestUtil writeWAV:[dir stringByAppendingPathComponent:@"short.wav"] :44100];
+    NSString* audioDataXML = [[TestUtil audioDataXML:@"streamed.wav" :YES] 
+                              stringByAppendingString:[TestUtil audioDataXML:@"short.wav" :NO]];
+    NSString* eventsXML = [[TestUtil eventXML:@"streamed" :@"streamed.wav"] 
+                           stringByAppendingString:[TestUtil eventXML:@"short" :@"short.wav"]];
+    STAssertEquals([TestUtil buildProject:dir :audioDataXML :eventsXML],
+                   KWL_SUCCESS,
+                   @"failed to build the project");
+    
+    kwlInitialize(44100, 2, 0, 512);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to initialize the engine");
+    kwlEngineDataLoad([self getTestFilePath:@"project.kwl"]);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to load engine data");
+    kwlWaveBankLoad([self getTestFilePath:@"bank.kwb"]);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to load the wave bank");
+}
+
+- (void)tearDown
+{
+    kwlDeinitialize();
+    [[NSFileManager defaultManager] removeItemAtPath:[self testDirectory] error:NULL];
+    
+    [super tearDown];
+}
+
+/***************************************************************************
+ * COMMAND BUFFERS
+ ***************************************************************************/
+
+-(void)testCommandsFromSeveralThreads
+{
+    kwlEventHandle event = kwlEventGetHandle("streamed");
+    kwlCommandBufferHandle buffers[NUM_PRODUCERS];
+    for (int i = 0; i < NUM_PRODUCERS; i++)
+    {
+        buffers[i] = kwlCommandBufferCreate(NUM_COMMANDS_PER_PRODUCER + 1);
+        STAssertTrue(buffers[i] != NULL, @"failed to create a command buffer");
+    }
+    
+    dispatch_apply(NUM_PRODUCERS, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+        for (int j = 0; j < NUM_COMMANDS_PER_PRODUCER; j++)
+        {
+            kwlCommandEventSetGain(buffers[i], event, j / (float)NUM_COMMANDS_PER_PRODUCER);
+        }
+        if (i == 0)
+        {
+            kwlCommandEventStart(buffers[i], event);
+        }
+        kwlCommandBufferSubmit(buffers[i]);
+    });
+    
+    kwlUpdate(0.01f);
+    STAssertTrue(kwlEventIsPlaying(event) != 0, @"the recorded start command should have been executed");
+    for (int i = 0; i < NUM_PRODUCERS; i++)
+    {
+        STAssertEquals(kwlCommandBufferGetError(buffers[i]), KWL_NO_ERROR, @"the commands should succeed");
+        kwlCommandBufferDestroy(buffers[i]);
+    }
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"destroying the buffers should not fail");
+    
+    kwlEventStop(event);
+    kwlEventRelease(event);
+}
+
+-(void)testErrorsArePerBuffer
+{
+    kwlEventHandle event = kwlEventGetHandle("short");
+    kwlCommandBufferHandle first = kwlCommandBufferCreate(2);
+    kwlCommandBufferHandle second = kwlCommandBufferCreate(2);
+    
+    kwlCommandEventSetGain(first, event, 0.5f);
+    kwlCommandEventSetGain(second, KWL_INVALID_HANDLE, 0.5f);
+    kwlCommandBufferSubmit(first);
+    kwlCommandBufferSubmit(second);
+    kwlUpdate(0.01f);
+    STAssertEquals(kwlCommandBufferGetError(first), KWL_NO_ERROR, @"valid commands should succeed");
+    STAssertEquals(kwlCommandBufferGetError(second), 
+                   KWL_INVALID_EVENT_INSTANCE_HANDLE, 
+                   @"the error should be reported for the buffer recording the command");
+    STAssertEquals(kwlCommandBufferGetError(second), KWL_NO_ERROR, @"getting the error should clear it");
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"command errors should not be reported by kwlGetError");
+    
+    /*a full buffer discards commands until the engine has executed the pending ones.*/
+    for (int i = 0; i < 3; i++)
+    {
+        kwlCommandEventSetGain(first, event, 0.5f);
+    }
+    STAssertEquals(kwlCommandBufferGetError(first), KWL_COMMAND_BUFFER_FULL, @"the third command should not fit");
+    kwlCommandBufferSubmit(first);
+    kwlUpdate(0.01f);
+    kwlCommandEventSetGain(first, event, 0.5f);
+    STAssertEquals(kwlCommandBufferGetError(first), KWL_NO_ERROR, @"executed commands should free up space");
+    
+    kwlCommandBufferDestroy(first);
+    kwlCommandBufferDestroy(second);
+    kwlEventRelease(event);
+    
+    kwlCommandBufferCreate(0);
+    STAssertEquals(kwlGetError(), KWL_INVALID_PARAMETER_VALUE, @"the capacity must be positive");
+}
+
+/***************************************************************************
+ * HELPER METHODS
+ ***************************************************************************/
+
+-(NSString*)testDirectory
+{
+    return [NSTemporaryDirectory() stringByAppendingPathComponent:@"kwl_test_commandbuffers"];
+}
+
+-(const char*)getTestFilePath:(NSString*)fileName
+{
+    return [[[self testDirectory] stringByAppendingPathComponent:fileName] UTF8String];
+}
+
+@end
@@ -0,0 +1,111 @@
+/*
+ Copyright (c) 2010-2012 Per Gantelius
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any damages
+ arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it
+ freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must not
+ claim that you wrote the original software. If you use this software
+ in a product, an acknowledgment in the product documentation would be
+ appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and must not be
+ misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+
+#import "TestEngineConfig.h"
+
+@implementation TestEngineConfig
+
+-(void)testDefaultConfig
+{
+    kwlEngineConfig defaultConfig;
+    kwlGetDefaultEngineConfig(&defaultConfig);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to get the default config");
+    
+    kwlEngineConfig config;
+    kwlGetEngineConfig(&config);
+    STAssertEquals(kwlGetError(), KWL_ENGINE_IS_NOT_INITIALIZED, @"got the config of an uninitialized engine");
+    
+    kwlInitialize(44100, 2, 0, 512);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to initialize the engine");
+    kwlGetEngineConfig(&config);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to get the engine config");
+    STAssertTrue(memcmp(&config, &defaultConfig, sizeof(kwlEngineConfig)) == 0, 
+                 @"an engine initialized without a config should use the default config");
+    kwlDeinitialize();
+}
+
+-(void)testCustomConfig
+{
+    kwlEngineConfig config;
+    kwlGetDefaultEngineConfig(&config);
+    config.numDecoders = 2;
+    config.numInlineDecoders = 8;
+    config.pcmDecoderBufferSize = 512;
+    config.messageQueueSize = 64;
+    config.mixBufferSizeInFrames = 256;
+    config.numPreallocatedFreeformEvents = 0;
+    config.freeformEventPoolChunkSize = 4;
+    
+    kwlInitializeWithConfig(44100, 2, 0, 512, NULL, NULL, &config);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to initialize the engine with a custom config");
+    
+    kwlEngineConfig usedConfig;
+    kwlGetEngineConfig(&usedConfig);
+    STAssertTrue(memcmp(&config, &usedConfig, sizeof(kwlEngineConfig)) == 0, 
+                 @"the engine should use the config it was initialized with");
+    kwlDeinitialize();
+    
+    kwlEngineInstance* engine = kwlEngineCreateWithConfig(44100, 2, 0, 512, NULL, NULL, &config);
+    STAssertTrue(engine != NULL, @"failed to create an engine instance with a custom config");
+    kwlInstanceGetEngineConfig(engine, &usedConfig);
+    STAssertEquals(kwlInstanceGetError(engine), KWL_NO_ERROR, @"failed to get the instance config");
+    STAssertTrue(memcmp(&config, &usedConfig, sizeof(kwlEngineConfig)) == 0, 
+                 @"the instance should use the config it was created with");
+    kwlEngineDestroy(engine);
+}
+
+-(void)testInvalidConfigs
+{
+    kwlEngineConfig defaultConfig;
+    kwlGetDefaultEngineConfig(&defaultConfig);
+    
+    kwlEngineConfig configs[9];
+    for (int i = 0; i < 9; i++)
+    {
+        configs[i] = defaultConfig;
+    }
+    configs[0].numDecoders = 0;
+    configs[1].pcmDecoderBufferSize = 2;
+    configs[2].oggVorbisDecoderBufferSize = 0;
+    configs[3].messageQueueSize = 0;
+    configs[4].mixBufferSizeInFrames = -1;
+    configs[5].numPreallocatedFreeformEvents = -1;
+    configs[6].freeformEventPoolChunkSize = 0;
+    configs[7].debugAllocationTableSize = 0;
+    configs[8].numInlineDecoders = 0;
+    
+    for (int i = 0; i < 9; i++)
+    {
+        kwlInitializeWithConfig(44100, 2, 0, 512, NULL, NULL, &configs[i]);
+        STAssertEquals(kwlGetError(), KWL_INVALID_PARAMETER_VALUE, @"an out of range config should be rejected");
+        STAssertTrue(kwlEngineGetDefault() == NULL, @"the engine should not be initialized with an out of range config");
+        
+        kwlEngineInstance* engine = kwlEngineCreateWithConfig(44100, 2, 0, 512, NULL, NULL, &configs[i]);
+        STAssertTrue(engine == NULL, @"an instance should not be created with an out of range config");
+        STAssertEquals(kwlGetError(), KWL_INVALID_PARAMETER_VALUE, @"an out of range config should be rejected");
+    }
+}
+
+@end
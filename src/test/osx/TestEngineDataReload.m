@@ -0,0 +1,220 @@
+/*
+ Copyright (c) 2010-2012 Per Gantelius
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any damages
+ arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it
+ freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must not
+ claim that you wrote the original software. If you use this software
+ in a product, an acknowledgment in the product documentation would be
+ appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and must not be
+ misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#import "TestEngineDataReload.h"
+
+#import "kowalski.h"
+#import "TestUtil.h"
+#import "kwl_logging.h"
+
+#import <unistd.h>
+
+static NSString* const audioDataXML = 
+@"      <AudioData relativePath=\"streamed.wav\" streamFromDisk=\"true\"/>\n"
+"      <AudioData relativePath=\"short.wav\"/>\n";
+
+static NSString* const eventsXML = 
+@"    <Event bus=\"master\" positional=\"false\" id=\"streamed\">\n"
+"      <AudioDataReference relativePath=\"streamed.wav\" waveBank=\"bank\"/>\n"
+"    </Event>\n"
+"    <Event bus=\"master\" positional=\"false\" id=\"short\">\n"
+"      <AudioDataReference relativePath=\"short.wav\" waveBank=\"bank\"/>\n"
+"    </Event>\n";
+
+/** Stores the result of a reload and counts the invocations of the callback.*/
+typedef struct
+{
+    kwlError result;
+    int numCallbacks;
+} ReloadResult;
+
+static void storeReloadResult(kwlError result, void* userData)
+{
+    ReloadResult* reloadResult = (ReloadResult*)userData;
+    reloadResult->result = result;
+    reloadResult->numCallbacks++;
+}
+
+@implementation TestEngineDataReload
+
+- (void)setUp
+{
+    [super setUp];
+    
+    /*build a project with an entry streamed from disk, long enough to play throughout the tests.*/
+    NSString* dir = [self testDirectory];
+    [TestUtil createEmptyDirectory:dir];
+    [TestUtil writeWAV:[dir stringByAppendingPathComponent:@"streamed.wav"] :441000];
+    [TestUtil writeWAV:[dir stringByAppendingPathComponent:@"short.wav"] :4410];
+    [self buildEngineData:@"project" :audioDataXML :eventsXML :1.0f];
+    STAssertEquals(kwlBuildWaveBanks([self getTestFilePath:@"project.xml"], 
+                                     [TestUtil getResourcePath:@"kowalski.xsd"], 
+                                     [dir UTF8String], 
+                                     1, 
+                                     kwlDefaultLogCallback),
+                   KWL_SUCCESS,
+                   @"failed to build wave banks");
+    
+    kwlInitialize(44100, 2, 0, 512);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to initialize the engine");
+    kwlEngineDataLoad([self getTestFilePath:@"project.kwl"]);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to load engine data");
+    kwlWaveBankLoad([self getTestFilePath:@"bank.kwb"]);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to load the wave bank");
+}
+
+- (void)tearDown
+{
+    kwlDeinitialize();
+    [[NSFileManager defaultManager] removeItemAtPath:[self testDirectory] error:NULL];
+    
+    [super tearDown];
+}
+
+/***************************************************************************
+ * RELOADING
+ ***************************************************************************/
+
+-(void)testReloadKeepsPlayingEvents
+{
+    kwlEventHandle streamed = kwlEventGetHandle("streamed");
+    kwlEventStart(streamed);
+    kwlUpdate(0.01f);
+    
+    /*same events, different mix preset gain.*/
+    [self buildEngineData:@"louder" :audioDataXML :eventsXML :0.5f];
+    STAssertEquals([self reloadAndWait:@"louder.kwl"], KWL_NO_ERROR, @"the reload should succeed");
+    STAssertTrue(kwlEngineDataIsLoaded() != 0, @"engine data should be loaded");
+    STAssertTrue(kwlEventIsPlaying(streamed) != 0, @"the streamed event should keep playing");
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"the event handle should stay valid");
+    
+    kwlEventStop(streamed);
+    kwlEventRelease(streamed);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"the event handle should stay valid");
+}
+
+-(void)testReloadRemovesEvents
+{
+    kwlEventHandle streamed = kwlEventGetHandle("streamed");
+    kwlEventStart(streamed);
+    kwlUpdate(0.01f);
+    
+    /*replace the streamed and short events with a new one.*/
+    NSString* changedEventsXML = 
+    @"    <Event bus=\"master\" positional=\"false\" id=\"added\">\n"
+    "      <AudioDataReference relativePath=\"short.wav\" waveBank=\"bank\"/>\n"
+    "    </Event>\n";
+    [self buildEngineData:@"changed" :audioDataXML :changedEventsXML :1.0f];
+    STAssertEquals([self reloadAndWait:@"changed.kwl"], KWL_NO_ERROR, @"the reload should succeed");
+    
+    kwlEventIsPlaying(streamed);
+    STAssertEquals(kwlGetError(), KWL_INVALID_EVENT_INSTANCE_HANDLE, @"handles of removed events should be invalid");
+    kwlEventGetHandle("streamed");
+    STAssertEquals(kwlGetError(), KWL_UNKNOWN_EVENT_DEFINITION_ID, @"the streamed event should be removed");
+    kwlEventHandle added = kwlEventGetHandle("added");
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"the added event should be available");
+    kwlEventRelease(added);
+}
+
+-(void)testReloadErrors
+{
+    kwlEngineDataReload([self getTestFilePath:@"missing.kwl"], NULL, NULL);
+    STAssertEquals(kwlGetError(), KWL_FILE_NOT_FOUND, @"a missing file should be rejected");
+    STAssertFalse(kwlEngineDataIsReloadPending() != 0, @"no reload should be pending");
+    
+    ReloadResult reloadResult = {KWL_NO_ERROR, 0};
+    kwlEngineDataReload([self getTestFilePath:@"project.kwl"], storeReloadResult, &reloadResult);
+    STAssertTrue(kwlEngineDataIsReloadPending() != 0, @"the reload should be pending");
+    kwlEngineDataReload([self getTestFilePath:@"project.kwl"], NULL, NULL);
+    STAssertEquals(kwlGetError(), KWL_ENGINE_DATA_RELOAD_PENDING, @"a second reload should be rejected");
+    [self updateUntilNonZero:&reloadResult.numCallbacks];
+    STAssertEquals(reloadResult.numCallbacks, 1, @"the callback should be invoked once");
+    
+    /*the loaded wave bank lists an entry that the new data lacks.*/
+    NSString* mismatchingAudioDataXML = 
+    @"      <AudioData relativePath=\"streamed.wav\" streamFromDisk=\"true\"/>\n";
+    NSString* mismatchingEventsXML = 
+    @"    <Event bus=\"master\" positional=\"false\" id=\"streamed\">\n"
+    "      <AudioDataReference relativePath=\"streamed.wav\" waveBank=\"bank\"/>\n"
+    "    </Event>\n";
+    [self buildEngineData:@"mismatch" :mismatchingAudioDataXML :mismatchingEventsXML :1.0f];
+    STAssertEquals([self reloadAndWait:@"mismatch.kwl"], 
+                   KWL_WAVE_BANK_ENTRY_MISMATCH, 
+                   @"a different wave bank layout should be rejected while the wave bank is loaded");
+    kwlEventHandle event = kwlEventGetHandle("short");
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"the previous engine data should be kept");
+    kwlEventRelease(event);
+    
+    kwlEngineDataUnload();
+    kwlEngineDataReload([self getTestFilePath:@"project.kwl"], NULL, NULL);
+    STAssertEquals(kwlGetError(), KWL_ENGINE_DATA_NOT_LOADED, @"reloading without engine data should fail");
+}
+
+/***************************************************************************
+ * HELPER METHODS
+ ***************************************************************************/
+
+-(NSString*)testDirectory
+{
+    return [NSTemporaryDirectory() stringByAppendingPathComponent:@"kwl_test_enginedatareload"];
+}
+
+-(void)buildEngineData:(NSString*)fileName
+                      :(NSString*)audioDataXML
+                      :(NSString*)eventsXML
+                      :(float)gain
+{
+    NSString* xmlPath = [[self testDirectory] stringByAppendingPathComponent:[fileName stringByAppendingPathExtension:@"xml"]];
+    NSString* engineDataPath = [[self testDirectory] stringByAppendingPathComponent:[fileName stringByAppendingPathExtension:@"kwl"]];
+    STAssertEquals([TestUtil buildEngineData:[TestUtil projectXML:audioDataXML :eventsXML :gain] :xmlPath :engineDataPath],
+                   KWL_SUCCESS,
+                   @"failed to build engine data");
+}
+
+-(const char*)getTestFilePath:(NSString*)fileName
+{
+    return [[[self testDirectory] stringByAppendingPathComponent:fileName] UTF8String];
+}
+
+-(kwlError)reloadAndWait:(NSString*)fileName
+{
+    ReloadResult reloadResult = {KWL_NO_ERROR, 0};
+    kwlEngineDataReload([self getTestFilePath:fileName], storeReloadResult, &reloadResult);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to request the reload");
+    [self updateUntilNonZero:&reloadResult.numCallbacks];
+    STAssertEquals(reloadResult.numCallbacks, 1, @"the callback should be invoked once");
+    STAssertFalse(kwlEngineDataIsReloadPending() != 0, @"the reload should not be pending");
+    return reloadResult.result;
+}
+
+-(void)updateUntilNonZero:(int*)value
+{
+    for (int i = 0; i < 500 && *value == 0; i++)
+    {
+        kwlUpdate(0.01f);
+        usleep(10000);
+    }
+}
+
+@end
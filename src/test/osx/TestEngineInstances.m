@@ -0,0 +1,172 @@
+/*
+ Copyright (c) 2010-2012 Per Gantelius
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any damages
+ arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it
+ freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must not
+ claim that you wrote the original software. If you use this software
+ in a product, an acknowledgment in the product documentation would be
+ appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and must not be
+ misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#import "TestEngineInstances.h"
+
+#import "kowalski.h"
+#import "TestUtil.h"
+
+#import <string.h>
+
+#define NUM_FRAMES_PER_BUFFER 512
+
+@implementation TestEngineInstances
+
+- (void)setUp
+{
+    [super setUp];
+    
+    /*build a project with one entry streamed from disk and one loaded into memory.*/
+    NSString* dir = [self testDirectory];
+    [TestUtil createEmptyDirectory:dir];
+    [TestUtil writeWAV:[dir stringByAppendingPathComponent:@"streamed.wav"] :441000];
+    [TestUtil writeWAV:[dir stringByAppendingPathComponent:@"short.wav"] :44100];
+    NSString* audioDataXML = [[TestUtil audioDataXML:@"streamed.wav" :YES] 
+                              stringByAppendingString:[TestUtil audioDataXML:@"short.wav" :NO]];
+    NSString* eventsXML = [[TestUtil eventXML:@"streamed" :@"streamed.wav"] 
+                           stringByAppendingString:[TestUtil eventXML:@"short" :@"short.wav"]];
+    STAssertEquals([TestUtil buildProject:dir :audioDataXML :eventsXML],
+                   KWL_SUCCESS,
+                   @"failed to build the project");
+}
+
+- (void)tearDown
+{
+    [[NSFileManager defaultManager] removeItemAtPath:[self testDirectory] error:NULL];
+    
+    [super tearDown];
+}
+
+/***************************************************************************
+ * OFFLINE INSTANCES
+ ***************************************************************************/
+
+-(void)testOfflineInstancesRenderIdentically
+{
+    kwlEngineInstance* first = [self createOfflineInstance:NULL];
+    kwlMemoryStats statsAfterFirst;
+    kwlGetMemoryStats(KWL_MEMORY_CATEGORY_AUDIO_DATA, &statsAfterFirst);
+    kwlEngineInstance* second = [self createOfflineInstance:first];
+    kwlMemoryStats statsAfterSecond;
+    kwlGetMemoryStats(KWL_MEMORY_CATEGORY_AUDIO_DATA, &statsAfterSecond);
+    STAssertEquals(statsAfterSecond.numLiveBytes, 
+                   statsAfterFirst.numLiveBytes, 
+                   @"the second instance should share the loaded audio data");
+    
+    kwlEngineInstance* instances[2] = {first, second};
+    float buffers[2][2 * NUM_FRAMES_PER_BUFFER];
+    for (int i = 0; i < 2; i++)
+    {
+        kwlInstanceEventStart(instances[i], kwlInstanceEventGetHandle(instances[i], "streamed"));
+        kwlInstanceEventStart(instances[i], kwlInstanceEventGetHandle(instances[i], "short"));
+        STAssertEquals(kwlInstanceGetError(instances[i]), KWL_NO_ERROR, @"failed to start events");
+        
+        const float peak = [self renderAndGetPeak:instances[i] :buffers[i] :100];
+        STAssertTrue(peak > 0.0f, @"the instance should render audio");
+    }
+    STAssertTrue(memcmp(buffers[0], buffers[1], sizeof(buffers[0])) == 0, 
+                 @"instances playing the same events should render the same output");
+    
+    /*the audio data stays loaded until the last instance sharing it is destroyed.*/
+    kwlEngineDestroy(first);
+    kwlInstanceEventStart(second, kwlInstanceEventGetHandle(second, "short"));
+    STAssertTrue([self renderAndGetPeak:second :buffers[1] :10] > 0.0f, 
+                 @"the remaining instance should still render audio");
+    kwlEngineDestroy(second);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"destroying the instances should not fail");
+}
+
+-(void)testInstanceErrors
+{
+    STAssertTrue(kwlEngineCreateOffline(44100, 3, NULL, NULL) == NULL, @"creating the instance should fail");
+    STAssertEquals(kwlInstanceGetError(NULL), 
+                   KWL_UNSUPPORTED_NUM_OUTPUT_CHANNELS, 
+                   @"failed creation should be reported without an instance");
+    
+    kwlEngineInstance* engine = [self createOfflineInstance:NULL];
+    kwlInstanceEventGetHandle(engine, "missing");
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"errors of other instances should not be reported for the default one");
+    STAssertEquals(kwlInstanceGetError(engine), KWL_UNKNOWN_EVENT_DEFINITION_ID, @"the error should be reported for the instance");
+    STAssertEquals(kwlInstanceGetError(engine), KWL_NO_ERROR, @"getting the error should clear it");
+    
+    kwlInstanceRender(engine, NULL, NUM_FRAMES_PER_BUFFER);
+    STAssertEquals(kwlInstanceGetError(engine), KWL_INVALID_PARAMETER_VALUE, @"rendering into NULL should fail");
+    kwlEngineDestroy(engine);
+    
+    kwlInitialize(44100, 2, 0, 512);
+    STAssertTrue(kwlEngineGetDefault() != NULL, @"the default instance should exist");
+    float buffer[2 * NUM_FRAMES_PER_BUFFER];
+    kwlInstanceRender(kwlEngineGetDefault(), buffer, NUM_FRAMES_PER_BUFFER);
+    STAssertEquals(kwlGetError(), KWL_INVALID_PARAMETER_VALUE, @"host driven instances should not render offline");
+    kwlDeinitialize();
+    STAssertTrue(kwlEngineGetDefault() == NULL, @"deinitializing should destroy the default instance");
+    
+    kwlEngineDestroy(NULL);
+    STAssertEquals(kwlGetError(), KWL_ENGINE_IS_NOT_INITIALIZED, @"destroying NULL should fail");
+}
+
+/***************************************************************************
+ * HELPER METHODS
+ ***************************************************************************/
+
+-(NSString*)testDirectory
+{
+    return [NSTemporaryDirectory() stringByAppendingPathComponent:@"kwl_test_engineinstances"];
+}
+
+-(kwlEngineInstance*)createOfflineInstance:(kwlEngineInstance*)audioDataSource
+{
+    kwlEngineInstance* engine = kwlEngineCreateOffline(44100, 2, NULL, audioDataSource);
+    STAssertTrue(engine != NULL, @"failed to create the instance");
+    kwlInstanceEngineDataLoad(engine, [self getTestFilePath:@"project.kwl"]);
+    STAssertEquals(kwlInstanceGetError(engine), KWL_NO_ERROR, @"failed to load engine data");
+    kwlInstanceWaveBankLoad(engine, [self getTestFilePath:@"bank.kwb"]);
+    STAssertEquals(kwlInstanceGetError(engine), KWL_NO_ERROR, @"failed to load the wave bank");
+    return engine;
+}
+
+-(float)renderAndGetPeak:(kwlEngineInstance*)engine
+                        :(float*)buffer
+                        :(int)numBuffers
+{
+    float peak = 0.0f;
+    for (int i = 0; i < numBuffers; i++)
+    {
+        kwlInstanceUpdate(engine, NUM_FRAMES_PER_BUFFER / 44100.0f);
+        kwlInstanceRender(engine, buffer, NUM_FRAMES_PER_BUFFER);
+        for (int j = 0; j < 2 * NUM_FRAMES_PER_BUFFER; j++)
+        {
+            peak = fabsf(buffer[j]) > peak ? fabsf(buffer[j]) : peak;
+        }
+    }
+    STAssertEquals(kwlInstanceGetError(engine), KWL_NO_ERROR, @"failed to render");
+    return peak;
+}
+
+-(const char*)getTestFilePath:(NSString*)fileName
+{
+    return [[[self testDirectory] stringByAppendingPathComponent:fileName] UTF8String];
+}
+
+@end
@@ -0,0 +1,222 @@
+/*
+ Copyright (c) 2010-2012 Per Gantelius
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any damages
+ arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it
+ freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must not
+ claim that you wrote the original software. If you use this software
+ in a product, an acknowledgment in the product documentation would be
+ appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and must not be
+ misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+
+#import "TestEventBatches.h"
+
+#import "kwl_engine.h"
+#import "kwl_eventinstance.h"
+
+/** The number of events updated by each batch.*/
+#define NUM_EVENTS 1000
+
+/** The kind of per entity component a game keeps its emitter state in.*/
+typedef struct
+{
+    float position[3];
+    int entityID;
+    float velocity[3];
+    float direction[3];
+    float gain;
+    float pitch;
+} Emitter;
+
+@implementation TestEventBatches
+
+- (void)setUp
+{
+    [super setUp];
+    
+    kwlInitialize(44100, 2, 0, 512);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to initialize the engine");
+}
+
+- (void)tearDown
+{
+    kwlDeinitialize();
+    
+    [super tearDown];
+}
+
+-(void)testStridedParameterArrays
+{
+    kwlEventHandle handles[NUM_EVENTS];
+    kwlEventHandle referenceHandles[NUM_EVENTS];
+    Emitter emitters[NUM_EVENTS];
+    kwlError errors[NUM_EVENTS];
+    for (int i = 0; i < NUM_EVENTS; i++)
+    {
+        /*every parameter differs between events, so a wrong stride reads another event's values.*/
+        handles[i] = [self createEvent:KWL_POSITIONAL];
+        emitters[i].position[0] = i;
+        emitters[i].position[1] = 0.5f * i;
+        emitters[i].position[2] = -i;
+        emitters[i].velocity[0] = 1.0f + i;
+        emitters[i].velocity[1] = 2.0f - i;
+        emitters[i].velocity[2] = 0.25f * i;
+        emitters[i].direction[0] = 1.0f;
+        emitters[i].direction[1] = 0.01f * i;
+        emitters[i].direction[2] = 1.0f + i;
+        emitters[i].gain = 0.001f * i;
+        emitters[i].pitch = 0.5f + 0.002f * i;
+        
+        /*a reference event given the same parameters through the per event setters.*/
+        referenceHandles[i] = [self createEvent:KWL_POSITIONAL];
+        kwlEventSetPosition(referenceHandles[i], emitters[i].position[0], emitters[i].position[1], emitters[i].position[2]);
+        kwlEventSetVelocity(referenceHandles[i], emitters[i].velocity[0], emitters[i].velocity[1], emitters[i].velocity[2]);
+        kwlEventSetOrientation(referenceHandles[i], emitters[i].direction[0], emitters[i].direction[1], emitters[i].direction[2]);
+        kwlEventSetGain(referenceHandles[i], emitters[i].gain);
+        kwlEventSetPitch(referenceHandles[i], emitters[i].pitch);
+        STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to set the parameters of a reference event");
+    }
+    
+    kwlEventParameterBatch batch;
+    memset(&batch, 0, sizeof(batch));
+    batch.positions = emitters[0].position;
+    batch.positionStride = sizeof(Emitter);
+    batch.velocities = emitters[0].velocity;
+    batch.velocityStride = sizeof(Emitter);
+    batch.orientations = emitters[0].direction;
+    batch.orientationStride = sizeof(Emitter);
+    batch.gains = &emitters[0].gain;
+    batch.gainStride = sizeof(Emitter);
+    batch.pitches = &emitters[0].pitch;
+    batch.pitchStride = sizeof(Emitter);
+    
+    kwlEventBatchSetParameters(handles, NUM_EVENTS, &batch, errors);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to set the parameters of a batch");
+    for (int i = 0; i < NUM_EVENTS; i++)
+    {
+        STAssertEquals(errors[i], KWL_NO_ERROR, @"an event of a valid batch reported an error");
+        [self checkEventParameters:handles[i] :referenceHandles[i]];
+    }
+    
+    /*tightly packed arrays and a subset of the parameters.*/
+    float gains[NUM_EVENTS];
+    for (int i = 0; i < NUM_EVENTS; i++)
+    {
+        gains[i] = 0.25f;
+    }
+    memset(&batch, 0, sizeof(batch));
+    batch.gains = gains;
+    batch.isLinearGain = 1;
+    kwlEventBatchSetParameters(handles, NUM_EVENTS, &batch, NULL);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to set packed gains");
+    for (int i = 0; i < NUM_EVENTS; i++)
+    {
+        kwlEventSetLinearGain(referenceHandles[i], gains[i]);
+        [self checkEventParameters:handles[i] :referenceHandles[i]];
+    }
+    
+    /*invalid arguments.*/
+    kwlEventBatchSetParameters(NULL, NUM_EVENTS, &batch, NULL);
+    STAssertEquals(kwlGetError(), KWL_INVALID_PARAMETER_VALUE, @"NULL handles should be rejected");
+    kwlEventBatchSetParameters(handles, NUM_EVENTS, NULL, NULL);
+    STAssertEquals(kwlGetError(), KWL_INVALID_PARAMETER_VALUE, @"NULL parameters should be rejected");
+    kwlEventBatchSetParameters(handles, -1, &batch, NULL);
+    STAssertEquals(kwlGetError(), KWL_INVALID_PARAMETER_VALUE, @"a negative event count should be rejected");
+    batch.gainStride = -1;
+    kwlEventBatchSetParameters(handles, NUM_EVENTS, &batch, NULL);
+    STAssertEquals(kwlGetError(), KWL_INVALID_PARAMETER_VALUE, @"a negative stride should be rejected");
+    
+    for (int i = 0; i < NUM_EVENTS; i++)
+    {
+        kwlEventRelease(handles[i]);
+        kwlEventRelease(referenceHandles[i]);
+    }
+}
+
+-(void)testErrorsArePerEvent
+{
+    const kwlEventHandle staleHandle = [self createEvent:KWL_POSITIONAL];
+    kwlEventRelease(staleHandle);
+    
+    const kwlEventHandle positional = [self createEvent:KWL_POSITIONAL];
+    const kwlEventHandle nonPositional = [self createEvent:KWL_NONPOSITIONAL];
+    kwlEventHandle handles[5] = {positional, KWL_INVALID_HANDLE, nonPositional, staleHandle, positional};
+    float positions[5 * 3];
+    memset(positions, 0, sizeof(positions));
+    float gains[5] = {1.0f, 1.0f, 1.0f, 1.0f, -1.0f};
+    kwlError errors[5];
+    
+    kwlEventParameterBatch batch;
+    memset(&batch, 0, sizeof(batch));
+    batch.positions = positions;
+    batch.gains = gains;
+    kwlEventBatchSetParameters(handles, 5, &batch, errors);
+    STAssertEquals(kwlGetError(), KWL_INVALID_EVENT_INSTANCE_HANDLE, @"the first error of the batch should be reported");
+    STAssertEquals(errors[0], KWL_NO_ERROR, @"a valid event reported an error");
+    STAssertEquals(errors[1], KWL_INVALID_EVENT_INSTANCE_HANDLE, @"the invalid handle should be rejected");
+    STAssertEquals(errors[2], KWL_EVENT_IS_NOT_POSITIONAL, @"positioning a non-positional event should fail");
+    STAssertEquals(errors[3], KWL_INVALID_EVENT_INSTANCE_HANDLE, @"the stale handle should be rejected");
+    STAssertEquals(errors[4], KWL_INVALID_PARAMETER_VALUE, @"a negative gain should be rejected");
+    
+    /*gains alone apply to non-positional events too.*/
+    batch.positions = NULL;
+    kwlEventBatchSetParameters(&nonPositional, 1, &batch, errors);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to set the gain of a non-positional event");
+    
+    kwlEventRelease(positional);
+    kwlEventRelease(nonPositional);
+}
+
+/***************************************************************************
+ * HELPER METHODS
+ ***************************************************************************/
+
+-(kwlEventHandle)createEvent:(kwlEventType)type
+{
+    static short samples[256];
+    kwlPCMBuffer buffer;
+    buffer.pcmData = samples;
+    buffer.numFrames = 256;
+    buffer.numChannels = 1;
+    
+    const kwlEventHandle handle = kwlEventCreateWithBuffer(&buffer, type);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to create an event");
+    return handle;
+}
+
+-(void)checkEventParameters:(kwlEventHandle)handle
+                           :(kwlEventHandle)referenceHandle
+{
+    kwlEngine* engine = kwlEngineGetDefault();
+    const kwlEventInstance* event = kwlEngine_getEventFromHandle(engine, handle);
+    const kwlEventInstance* reference = kwlEngine_getEventFromHandle(engine, referenceHandle);
+    STAssertTrue(event != NULL && reference != NULL, @"failed to look up the events");
+    
+    STAssertEquals(event->positionX, reference->positionX, @"batched position x differs from kwlEventSetPosition");
+    STAssertEquals(event->positionY, reference->positionY, @"batched position y differs from kwlEventSetPosition");
+    STAssertEquals(event->positionZ, reference->positionZ, @"batched position z differs from kwlEventSetPosition");
+    STAssertEquals(event->velocityX, reference->velocityX, @"batched velocity x differs from kwlEventSetVelocity");
+    STAssertEquals(event->velocityY, reference->velocityY, @"batched velocity y differs from kwlEventSetVelocity");
+    STAssertEquals(event->velocityZ, reference->velocityZ, @"batched velocity z differs from kwlEventSetVelocity");
+    STAssertEquals(event->directionX, reference->directionX, @"batched orientation x differs from kwlEventSetOrientation");
+    STAssertEquals(event->directionY, reference->directionY, @"batched orientation y differs from kwlEventSetOrientation");
+    STAssertEquals(event->directionZ, reference->directionZ, @"batched orientation z differs from kwlEventSetOrientation");
+    STAssertEquals(event->userGain, reference->userGain, @"batched gain differs from kwlEventSetGain");
+    STAssertEquals(event->userPitch, reference->userPitch, @"batched pitch differs from kwlEventSetPitch");
+}
+
+@end
@@ -0,0 +1,206 @@
+/*
+ Copyright (c) 2010-2012 Per Gantelius
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any damages
+ arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it
+ freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must not
+ claim that you wrote the original software. If you use this software
+ in a product, an acknowledgment in the product documentation would be
+ appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and must not be
+ misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#import "TestEventHandles.h"
+
+#import "TestUtil.h"
+
+#import <unistd.h>
+
+/** The number of freeform events kept alive while hammering handles.*/
+#define NUM_LIVE_EVENTS 16
+
+/** The number of release/create iterations.*/
+#define NUM_ITERATIONS 100000
+
+@implementation TestEventHandles
+
+- (void)setUp
+{
+    [super setUp];
+    
+    kwlInitialize(44100, 2, 0, 512);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to initialize the engine");
+}
+
+- (void)tearDown
+{
+    kwlDeinitialize();
+    
+    [super tearDown];
+}
+
+/***************************************************************************
+ * FREEFORM EVENT HANDLES
+ ***************************************************************************/
+
+-(void)testStaleFreeformHandlesAreRejected
+{
+    short samples[2 * 256];
+    memset(samples, 0, sizeof(samples));
+    kwlPCMBuffer buffer;
+    buffer.pcmData = samples;
+    buffer.numFrames = 256;
+    buffer.numChannels = 2;
+    
+    kwlEventHandle liveHandles[NUM_LIVE_EVENTS];
+    for (int i = 0; i < NUM_LIVE_EVENTS; i++)
+    {
+        liveHandles[i] = kwlEventCreateWithBuffer(&buffer, KWL_NONPOSITIONAL);
+        STAssertTrue([self isHandleValid:liveHandles[i]], @"a new handle should be valid");
+    }
+    
+    /*release random events and create new ones, which reuses the released slots. every slot is 
+      reused more times than there are handle generations, so all stale handles are kept.*/
+    kwlEventHandle* staleHandles = (kwlEventHandle*)malloc(NUM_ITERATIONS * sizeof(kwlEventHandle));
+    unsigned int seed = 1;
+    for (int i = 0; i < NUM_ITERATIONS; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        const int index = (seed >> 8) % NUM_LIVE_EVENTS;
+        const kwlEventHandle staleHandle = liveHandles[index];
+        
+        kwlEventRelease(staleHandle);
+        STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to release a live handle");
+        liveHandles[index] = kwlEventCreateWithBuffer(&buffer, KWL_NONPOSITIONAL);
+        STAssertTrue([self isHandleValid:liveHandles[index]], @"a new handle should be valid");
+        
+        STAssertFalse(liveHandles[index] == staleHandle, @"a released handle was handed out again");
+        STAssertFalse([self isHandleValid:staleHandle], @"a released handle should be rejected");
+        kwlEventRelease(staleHandle);
+        STAssertEquals(kwlGetError(), KWL_INVALID_EVENT_INSTANCE_HANDLE, @"releasing a stale handle should fail");
+        staleHandles[i] = staleHandle;
+    }
+    
+    /*handles from much older cycles must not have become valid again.*/
+    for (int i = 0; i < NUM_ITERATIONS; i++)
+    {
+        STAssertFalse([self isHandleValid:staleHandles[i]], @"a handle released many cycles ago should be rejected");
+    }
+    free(staleHandles);
+    
+    /*a freeform handle with the freeform bit cleared does not address the event.*/
+    kwlEventRelease([self flipFreeformBit:liveHandles[0]]);
+    STAssertEquals(kwlGetError(), KWL_INVALID_EVENT_INSTANCE_HANDLE, @"a handle of the wrong kind should be rejected");
+    STAssertTrue([self isHandleValid:liveHandles[0]], @"releasing a handle of the wrong kind released the event");
+    
+    /*a stale handle must not control the event now occupying its slot.*/
+    const kwlEventHandle staleHandle = kwlEventCreateWithBuffer(&buffer, KWL_NONPOSITIONAL);
+    kwlEventRelease(staleHandle);
+    const kwlEventHandle reusingHandle = kwlEventCreateWithBuffer(&buffer, KWL_NONPOSITIONAL);
+    kwlEventStart(staleHandle);
+    STAssertEquals(kwlGetError(), KWL_INVALID_EVENT_INSTANCE_HANDLE, @"starting a stale handle should fail");
+    STAssertFalse(kwlEventIsPlaying(reusingHandle), @"a stale handle started the event reusing its slot");
+    
+    kwlEventStart(KWL_INVALID_HANDLE);
+    STAssertEquals(kwlGetError(), KWL_INVALID_EVENT_INSTANCE_HANDLE, @"the invalid handle should be rejected");
+    
+    kwlEventRelease(reusingHandle);
+    for (int i = 0; i < NUM_LIVE_EVENTS; i++)
+    {
+        kwlEventRelease(liveHandles[i]);
+    }
+}
+
+/***************************************************************************
+ * DATA DRIVEN EVENT HANDLES
+ ***************************************************************************/
+
+-(void)testStaleDataHandlesAreRejected
+{
+    NSString* dir = [NSTemporaryDirectory() stringByAppendingPathComponent:@"kwl_test_event_handles"];
+    [TestUtil createEmptyDirectory:dir];
+    [TestUtil writeWAV:[dir stringByAppendingPathComponent:@"sound.wav"] :4410];
+    STAssertEquals([TestUtil buildProject:dir 
+                                         :[TestUtil audioDataXML:@"sound.wav" :NO] 
+                                         :[TestUtil eventXML:@"event" :@"sound.wav"]],
+                   KWL_SUCCESS,
+                   @"failed to build the project");
+    
+    NSString* engineDataPath = [dir stringByAppendingPathComponent:@"project.kwl"];
+    kwlEngineDataLoad([engineDataPath UTF8String]);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to load engine data");
+    
+    kwlEventHandle handle = kwlEventGetHandle("event");
+    STAssertTrue([self isHandleValid:handle], @"a new handle should be valid");
+    
+    /*a data handle with the freeform bit set does not address the event.*/
+    kwlEventRelease([self flipFreeformBit:handle]);
+    STAssertEquals(kwlGetError(), KWL_INVALID_EVENT_INSTANCE_HANDLE, @"a handle of the wrong kind should be rejected");
+    STAssertTrue([self isHandleValid:handle], @"releasing a handle of the wrong kind released the event");
+    
+    kwlEventHandle* staleHandles = (kwlEventHandle*)malloc(NUM_ITERATIONS * sizeof(kwlEventHandle));
+    for (int i = 0; i < NUM_ITERATIONS; i++)
+    {
+        /*the released instance is handed out again, with a new handle.*/
+        kwlEventRelease(handle);
+        staleHandles[i] = handle;
+        const kwlEventHandle newHandle = kwlEventGetHandle("event");
+        STAssertTrue([self isHandleValid:newHandle], @"a new handle should be valid");
+        STAssertFalse(newHandle == handle, @"a released handle was handed out again");
+        STAssertFalse([self isHandleValid:handle], @"a released handle should be rejected");
+        handle = newHandle;
+    }
+    
+    /*handles from much older cycles must not have become valid again.*/
+    for (int i = 0; i < NUM_ITERATIONS; i++)
+    {
+        STAssertFalse([self isHandleValid:staleHandles[i]], @"a handle released many cycles ago should be rejected");
+    }
+    free(staleHandles);
+    
+    /*handles to events of unloaded engine data are rejected after reloading it.*/
+    kwlEngineDataUnload();
+    kwlEngineDataLoad([engineDataPath UTF8String]);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to reload engine data");
+    STAssertFalse([self isHandleValid:handle], @"a handle from previously loaded engine data should be rejected");
+    
+    const kwlEventHandle reloadedHandle = kwlEventGetHandle("event");
+    STAssertTrue([self isHandleValid:reloadedHandle], @"a new handle should be valid");
+    kwlEventRelease(reloadedHandle);
+    kwlEngineDataUnload();
+    
+    [[NSFileManager defaultManager] removeItemAtPath:dir error:NULL];
+}
+
+/***************************************************************************
+ * HELPER METHODS
+ ***************************************************************************/
+
+-(BOOL)isHandleValid:(kwlEventHandle)handle
+{
+    /*clear any previous error*/
+    kwlGetError();
+    kwlEventIsPlaying(handle);
+    return kwlGetError() == KWL_NO_ERROR;
+}
+
+-(kwlEventHandle)flipFreeformBit:(kwlEventHandle)handle
+{
+    /*the freeform flag is the most significant bit of a handle.*/
+    const unsigned long long freeformBit = 1ULL << (8 * sizeof(kwlEventHandle) - 1);
+    return (kwlEventHandle)((unsigned long long)handle ^ freeformBit);
+}
+
+@end
@@ -0,0 +1,218 @@
+/*
+ Copyright (c) 2010-2012 Per Gantelius
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any damages
+ arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it
+ freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must not
+ claim that you wrote the original software. If you use this software
+ in a product, an acknowledgment in the product documentation would be
+ appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and must not be
+ misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+#import "TestFileSystem.h"
+
+#import "kowalski.h"
+#import "TestUtil.h"
+
+#import <libkern/OSAtomic.h>
+#import <unistd.h>
+
+/***************************************************************************
+ * IN-MEMORY FILE SYSTEM
+ ***************************************************************************/
+
+#define MAX_NUM_MEMORY_FILES 4
+
+/** A file served from memory.*/
+typedef struct
+{
+    char path[1024];
+    char* bytes;
+    int size;
+} MemoryFile;
+
+/** The files and the read statistics of the in-memory file system.*/
+typedef struct
+{
+    MemoryFile files[MAX_NUM_MEMORY_FILES];
+    int numFiles;
+    volatile int32_t numOpenFiles;
+    volatile int32_t numReads;
+    volatile int32_t numBytesRead;
+} MemoryFileSystem;
+
+static void* memoryFileSystemOpen(void* userData, const char* path)
+{
+    MemoryFileSystem* fileSystem = (MemoryFileSystem*)userData;
+    for (int i = 0; i < fileSystem->numFiles; i++)
+    {
+        if (strcmp(fileSystem->files[i].path, path) == 0)
+        {
+            OSAtomicIncrement32Barrier(&fileSystem->numOpenFiles);
+            return &fileSystem->files[i];
+        }
+    }
+    return NULL;
+}
+
+static int memoryFileSystemRead(void* userData, void* file, int position, void* data, int length)
+{
+    MemoryFileSystem* fileSystem = (MemoryFileSystem*)userData;
+    MemoryFile* memoryFile = (MemoryFile*)file;
+    if (position >= memoryFile->size)
+    {
+        return 0;
+    }
+    if (length > memoryFile->size - position)
+    {
+        length = memoryFile->size - position;
+    }
+    memcpy(data, memoryFile->bytes + position, length);
+    OSAtomicIncrement32Barrier(&fileSystem->numReads);
+    OSAtomicAdd32Barrier(length, &fileSystem->numBytesRead);
+    return length;
+}
+
+static int memoryFileSystemGetSize(void* userData, void* file)
+{
+    return ((MemoryFile*)file)->size;
+}
+
+static void memoryFileSystemClose(void* userData, void* file)
+{
+    MemoryFileSystem* fileSystem = (MemoryFileSystem*)userData;
+    OSAtomicDecrement32Barrier(&fileSystem->numOpenFiles);
+}
+
+/** Moves a file from disk into a given in-memory file system.*/
+static void memoryFileSystemAddFile(MemoryFileSystem* fileSystem, NSString* path)
+{
+    NSData* data = [NSData dataWithContentsOfFile:path];
+    MemoryFile* file = &fileSystem->files[fileSystem->numFiles++];
+    strcpy(file->path, [path UTF8String]);
+    file->size = (int)[data length];
+    file->bytes = (char*)malloc(file->size);
+    memcpy(file->bytes, [data bytes], file->size);
+    
+    /*make sure nothing can be read from disk.*/
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+}
+
+@implementation TestFileSystem
+
+- (void)setUp
+{
+    [super setUp];
+    
+    // Set-up code here.
+}
+
+- (void)tearDown
+{
+    // Tear-down code here.
+    
+    [super tearDown];
+}
+
+/***************************************************************************
+ * LOAD AND STREAM TESTS
+ ***************************************************************************/
+
+-(void)testLoadAndStreamFromMemory
+{
+    /*build a project with one entry loaded into memory and one streamed from disk.*/
+    NSString* dir = [NSTemporaryDirectory() stringByAppendingPathComponent:@"kwl_test_file_system"];
+    [TestUtil createEmptyDirectory:dir];
+    [TestUtil writeWAV:[dir stringByAppendingPathComponent:@"memory.wav"] :4410];
+    [TestUtil writeWAV:[dir stringByAppendingPathComponent:@"streamed.wav"] :88200];
+    NSString* audioDataXML = [[TestUtil audioDataXML:@"memory.wav" :NO] 
+                              stringByAppendingString:[TestUtil audioDataXML:@"streamed.wav" :YES]];
+    NSString* eventsXML = [[TestUtil eventXML:@"memory" :@"memory.wav"] 
+                           stringByAppendingString:[TestUtil eventXML:@"streamed" :@"streamed.wav"]];
+    STAssertEquals([TestUtil buildProject:dir :audioDataXML :eventsXML],
+                   KWL_SUCCESS,
+                   @"failed to build the project");
+    
+    NSString* engineDataPath = [dir stringByAppendingPathComponent:@"project.kwl"];
+    NSString* waveBankPath = [dir stringByAppendingPathComponent:@"bank.kwb"];
+    
+    /*serve the built files from memory only.*/
+    MemoryFileSystem memoryFileSystem;
+    memset(&memoryFileSystem, 0, sizeof(MemoryFileSystem));
+    memoryFileSystemAddFile(&memoryFileSystem, engineDataPath);
+    memoryFileSystemAddFile(&memoryFileSystem, waveBankPath);
+    const int streamedEntrySize = 2 * 88200;
+    
+    kwlFileSystem fileSystem;
+    memset(&fileSystem, 0, sizeof(kwlFileSystem));
+    fileSystem.open = memoryFileSystemOpen;
+    fileSystem.read = memoryFileSystemRead;
+    fileSystem.getSize = memoryFileSystemGetSize;
+    fileSystem.close = memoryFileSystemClose;
+    fileSystem.userData = &memoryFileSystem;
+    
+    kwlInitializeWithFileSystem(44100, 2, 0, 512, &fileSystem);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to initialize the engine");
+    
+    kwlEngineDataLoad([engineDataPath UTF8String]);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to load engine data from memory");
+    kwlWaveBankHandle waveBank = kwlWaveBankLoad([waveBankPath UTF8String]);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to load the wave bank from memory");
+    /*the wave bank file stays open for the streamed entry.*/
+    STAssertEquals(memoryFileSystem.numOpenFiles, 1, @"the wave bank file should be kept open");
+    const int numBytesReadAfterLoading = memoryFileSystem.numBytesRead;
+    STAssertTrue(numBytesReadAfterLoading < memoryFileSystem.files[0].size + memoryFileSystem.files[1].size - streamedEntrySize / 2,
+                 @"the streamed entry should not be read when loading");
+    
+    /*play both events to the end.*/
+    kwlEventHandle memoryEvent = kwlEventGetHandle("memory");
+    kwlEventHandle streamedEvent = kwlEventGetHandle("streamed");
+    kwlEventStart(memoryEvent);
+    kwlEventStart(streamedEvent);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to start events");
+    for (int i = 0; i < 500 && (kwlEventIsPlaying(memoryEvent) || kwlEventIsPlaying(streamedEvent)); i++)
+    {
+        kwlUpdate(0.01f);
+        usleep(10000);
+    }
+    STAssertFalse(kwlEventIsPlaying(streamedEvent), @"the streamed event should have finished playing");
+    STAssertTrue(memoryFileSystem.numBytesRead - numBytesReadAfterLoading >= streamedEntrySize,
+                 @"the streamed entry should have been read through the file system");
+    
+    kwlEventRelease(memoryEvent);
+    kwlEventRelease(streamedEvent);
+    kwlWaveBankUnload(waveBank);
+    kwlEngineDataUnload();
+    kwlDeinitialize();
+    
+    STAssertEquals(memoryFileSystem.numOpenFiles, 0, @"all files should be closed");
+    
+    for (int i = 0; i < memoryFileSystem.numFiles; i++)
+    {
+        free(memoryFileSystem.files[i].bytes);
+    }
+    [[NSFileManager defaultManager] removeItemAtPath:dir error:NULL];
+}
+
+-(void)testInvalidFileSystem
+{
+    kwlFileSystem fileSystem;
+    memset(&fileSystem, 0, sizeof(kwlFileSystem));
+    kwlInitializeWithFileSystem(44100, 2, 0, 512, &fileSystem);
+    STAssertEquals(kwlGetError(), KWL_INVALID_PARAMETER_VALUE, @"a file system without callbacks should be rejected");
+    STAssertFalse(kwlIsEngineInitialized(), @"the engine should not be initialized");
+}
+
+@end
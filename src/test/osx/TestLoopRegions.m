@@ -0,0 +1,227 @@
+/*
+ Copyright (c) 2010-2012 Per Gantelius
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any damages
+ arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it
+ freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must not
+ claim that you wrote the original software. If you use this software
+ in a product, an acknowledgment in the product documentation would be
+ appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and must not be
+ misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#import "TestLoopRegions.h"
+
+#import "kowalski.h"
+#import "kwl_decoder.h"
+#import "kwl_decoder_imaadpcm.h"
+#import "kwl_decoder_oggvorbis.h"
+#import "kwl_decoder_pcm.h"
+#import "kwl_memory.h"
+#import "TestUtil.h"
+
+#import <limits.h>
+#import <string.h>
+
+/** The number of times a loop region is played after the first pass.*/
+#define NUM_LOOP_ITERATIONS 2000
+
+/** The number of times a whole file loop is played after the first pass, kept low since each pass decodes the whole file.*/
+#define NUM_WHOLE_FILE_LOOP_ITERATIONS 20
+
+@implementation TestLoopRegions
+
+- (void)setUp
+{
+    [super setUp];
+    
+    [TestUtil createEmptyDirectory:[self testDirectory]];
+}
+
+- (void)tearDown
+{
+    [[NSFileManager defaultManager] removeItemAtPath:[self testDirectory] error:NULL];
+    
+    [super tearDown];
+}
+
+/***************************************************************************
+ * LOOP REGIONS
+ ***************************************************************************/
+
+-(void)testPCMLoopRegion
+{
+    NSString* path = [[self testDirectory] stringByAppendingPathComponent:@"loop.wav"];
+    [TestUtil writeWAV:path :30000];
+    NSData* fileData = [NSData dataWithContentsOfFile:path];
+    
+    [self checkLoopRegion:fileData :KWL_ENCODING_SIGNED_16BIT_PCM :1000 :1513];
+    [self checkLoopRegion:fileData :KWL_ENCODING_SIGNED_16BIT_PCM :0 :1];
+    [self checkLoopRegion:fileData :KWL_ENCODING_SIGNED_16BIT_PCM :0 :0];
+}
+
+-(void)testIMAADPCMLoopRegion
+{
+    NSData* fileData = [NSData dataWithContentsOfFile:
+                        [NSString stringWithUTF8String:[TestUtil getResourcePath:@"tonight_thats_allright_loop_ima4.wav"]]];
+    
+    [self checkLoopRegion:fileData :KWL_ENCODING_IMA_ADPCM :10000 :10513];
+    [self checkLoopRegion:fileData :KWL_ENCODING_IMA_ADPCM :0 :0];
+}
+
+-(void)testOggVorbisLoopRegion
+{
+    NSData* fileData = [NSData dataWithContentsOfFile:
+                        [NSString stringWithUTF8String:[TestUtil getResourcePath:@"tonight_thats_allright_loop.ogg"]]];
+    
+    [self checkLoopRegion:fileData :KWL_ENCODING_VORBIS :10000 :10513];
+    [self checkLoopRegion:fileData :KWL_ENCODING_VORBIS :0 :0];
+}
+
+/***************************************************************************
+ * HELPER METHODS
+ ***************************************************************************/
+
+-(NSString*)testDirectory
+{
+    return [NSTemporaryDirectory() stringByAppendingPathComponent:@"kwl_test_loop_regions"];
+}
+
+-(void)checkLoopRegion:(NSData*)fileData
+                      :(kwlAudioEncoding)encoding
+                      :(int)loopStart
+                      :(int)loopEnd
+{
+    STAssertTrue(fileData != nil, @"failed to read the audio file");
+    
+    int numReferenceFrames = 0;
+    int numChannels = 0;
+    short* reference = [self decode:fileData :encoding :0 :0 :0 :INT_MAX :&numReferenceFrames :&numChannels];
+    
+    const int end = loopEnd > 0 ? loopEnd : numReferenceFrames;
+    const int numIterations = loopEnd > 0 ? NUM_LOOP_ITERATIONS : NUM_WHOLE_FILE_LOOP_ITERATIONS;
+    const int numExpectedFrames = end + (end - loopStart) * numIterations;
+    int numFrames = 0;
+    short* looped = [self decode:fileData :encoding :1 :loopStart :loopEnd :numExpectedFrames :&numFrames :&numChannels];
+    STAssertTrue(numFrames >= numExpectedFrames, @"looped audio data should not end");
+    
+    /*the expected output is frames 0 to loopEnd, followed by loopStart to loopEnd repeated.*/
+    int referenceFrame = 0;
+    int firstMismatch = -1;
+    for (int i = 0; i < numExpectedFrames && firstMismatch < 0; i++)
+    {
+        if (memcmp(&looped[i * numChannels], 
+                   &reference[referenceFrame * numChannels], 
+                   numChannels * sizeof(short)) != 0)
+        {
+            firstMismatch = i;
+        }
+        
+        referenceFrame++;
+        if (referenceFrame == end)
+        {
+            referenceFrame = loopStart;
+        }
+    }
+    STAssertEquals(firstMismatch, -1, @"loop region %d-%d does not match the reference", loopStart, loopEnd);
+    
+    KWL_FREE(looped);
+    KWL_FREE(reference);
+}
+
+-(short*)decode:(NSData*)fileData
+               :(kwlAudioEncoding)encoding
+               :(int)loop
+               :(int)loopStart
+               :(int)loopEnd
+               :(int)maxNumFrames
+               :(int*)numFrames
+               :(int*)numChannels
+{
+    kwlAudioData audioData;
+    kwlMemset(&audioData, 0, sizeof(kwlAudioData));
+    audioData.encoding = encoding;
+    audioData.numBytes = (int)[fileData length];
+    audioData.bytes = KWL_MALLOC(audioData.numBytes, KWL_MEMORY_CATEGORY_AUDIO_DATA, "test loop audio data");
+    kwlMemcpy(audioData.bytes, [fileData bytes], audioData.numBytes);
+    audioData.loopStart = loopStart;
+    audioData.loopEnd = loopEnd;
+    
+    kwlEngineConfig config;
+    kwlGetDefaultEngineConfig(&config);
+    
+    kwlDecoder decoder;
+    kwlMemset(&decoder, 0, sizeof(kwlDecoder));
+    decoder.config = &config;
+    decoder.audioData = &audioData;
+    decoder.loop = loop;
+    decoder.loopStart = loopStart;
+    decoder.loopEnd = loopEnd;
+    kwlInputStream_initWithBuffer(&decoder.audioDataStream, audioData.bytes, 0, audioData.numBytes);
+    
+    kwlError result = KWL_UNSUPPORTED_ENCODING;
+    if (encoding == KWL_ENCODING_IMA_ADPCM)
+    {
+        result = kwlInitDecoderIMAADPCM(&decoder);
+    }
+    else if (encoding == KWL_ENCODING_VORBIS)
+    {
+        result = kwlInitDecoderOggVorbis(&decoder);
+    }
+    else
+    {
+        result = kwlInitDecoderPCM(&decoder);
+    }
+    STAssertEquals(result, KWL_NO_ERROR, @"failed to initialize the decoder");
+    
+    decoder.currentDecodedBuffer = (short*)KWL_MALLOC(decoder.maxDecodedBufferSize, KWL_MEMORY_CATEGORY_GENERAL, "test decoded buffer");
+    
+    /*decode whole buffers until the end of the data or until enough frames are decoded.*/
+    int capacity = 44100 * decoder.numChannels;
+    int numSamples = 0;
+    short* samples = (short*)KWL_MALLOC(capacity * sizeof(short), KWL_MEMORY_CATEGORY_GENERAL, "test decoded samples");
+    while (numSamples / decoder.numChannels < maxNumFrames)
+    {
+        const int endOfData = decoder.decodeBuffer(&decoder);
+        const int numBufferSamples = decoder.currentDecodedBufferSizeInBytes / sizeof(short);
+        if (numSamples + numBufferSamples > capacity)
+        {
+            capacity = 2 * (numSamples + numBufferSamples);
+            short* grown = (short*)KWL_MALLOC(capacity * sizeof(short), KWL_MEMORY_CATEGORY_GENERAL, "test decoded samples");
+            kwlMemcpy(grown, samples, numSamples * sizeof(short));
+            KWL_FREE(samples);
+            samples = grown;
+        }
+        kwlMemcpy(&samples[numSamples], decoder.currentDecodedBuffer, numBufferSamples * sizeof(short));
+        numSamples += numBufferSamples;
+        
+        /*like the decoding loop, rewind looping decoders at the end of the data.*/
+        if (endOfData && (!loop || !decoder.rewind(&decoder)))
+        {
+            break;
+        }
+    }
+    
+    *numChannels = decoder.numChannels;
+    *numFrames = numSamples / decoder.numChannels;
+    
+    decoder.deinit(&decoder);
+    KWL_FREE(decoder.currentDecodedBuffer);
+    kwlAudioData_free(&audioData);
+    
+    return samples;
+}
+
+@end
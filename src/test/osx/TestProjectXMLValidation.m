@@ -212,6 +212,12 @@
                                     :KWL_XML_VALIDATION_FAILED];
     [self requireXMLValidationResult:@"schema_error_wrong_root_name.xml"
                                     :KWL_XML_VALIDATION_FAILED];
+    [self requireXMLValidationResult:@"schema_error_invalid_bit_depth.xml"
+                                    :KWL_XML_VALIDATION_FAILED];
+    [self requireXMLValidationResult:@"schema_error_negative_loop_start.xml"
+                                    :KWL_XML_VALIDATION_FAILED];
+    [self requireXMLValidationResult:@"schema_error_negative_prefetch_head.xml"
+                                    :KWL_XML_VALIDATION_FAILED];
 }
 
 /***************************************************************************
@@ -0,0 +1,103 @@
+/*
+ Copyright (c) 2010-2012 Per Gantelius
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any damages
+ arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it
+ freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must not
+ claim that you wrote the original software. If you use this software
+ in a product, an acknowledgment in the product documentation would be
+ appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and must not be
+ misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#import "TestScheduledEvents.h"
+
+#define NUM_FRAMES_PER_BUFFER 512
+#define NUM_BUFFERS 16
+#define NUM_PCM_FRAMES 10000
+
+@implementation TestScheduledEvents
+
+/***************************************************************************
+ * SCHEDULED STARTS AND STOPS
+ ***************************************************************************/
+
+-(void)testScheduledStartAndStopAreFrameAccurate
+{
+    kwlEngineInstance* engine = kwlEngineCreateOffline(44100, 2, NULL, NULL);
+    STAssertTrue(engine != NULL, @"failed to create the instance");
+    
+    static short pcmData[2 * NUM_PCM_FRAMES];
+    for (int i = 0; i < 2 * NUM_PCM_FRAMES; i++)
+    {
+        pcmData[i] = 16000;
+    }
+    kwlPCMBuffer pcmBuffer;
+    pcmBuffer.numFrames = NUM_PCM_FRAMES;
+    pcmBuffer.numChannels = 2;
+    pcmBuffer.pcmData = pcmData;
+    kwlEventHandle handle = kwlInstanceEventCreateWithBuffer(engine, &pcmBuffer, KWL_NONPOSITIONAL);
+    STAssertEquals(kwlInstanceGetError(engine), KWL_NO_ERROR, @"failed to create the event");
+    
+    /*start a few buffers ahead, off a buffer boundary, and stop in a later buffer.*/
+    const long long renderStartFrame = kwlInstanceGetTotalNumFramesMixed(engine);
+    const long long startFrame = renderStartFrame + 3 * NUM_FRAMES_PER_BUFFER + 100;
+    const long long stopFrame = startFrame + 3000;
+    kwlInstanceEventStartAtFrame(engine, handle, startFrame);
+    kwlInstanceEventStopAtFrame(engine, handle, stopFrame);
+    STAssertEquals(kwlInstanceGetError(engine), KWL_NO_ERROR, @"failed to schedule the event");
+    
+    static float output[2 * NUM_FRAMES_PER_BUFFER * NUM_BUFFERS];
+    for (int i = 0; i < NUM_BUFFERS; i++)
+    {
+        kwlInstanceUpdate(engine, NUM_FRAMES_PER_BUFFER / 44100.0f);
+        kwlInstanceRender(engine, &output[2 * NUM_FRAMES_PER_BUFFER * i], NUM_FRAMES_PER_BUFFER);
+    }
+    STAssertEquals(kwlInstanceGetError(engine), KWL_NO_ERROR, @"failed to render");
+    
+    long long firstFrame = -1;
+    long long lastFrame = -1;
+    [self getFirstAndLastNonSilentFrame:output :NUM_FRAMES_PER_BUFFER * NUM_BUFFERS :&firstFrame :&lastFrame];
+    STAssertEquals(renderStartFrame + firstFrame, startFrame, @"the event should start at the scheduled frame");
+    STAssertEquals(renderStartFrame + lastFrame, stopFrame - 1, @"the event should end at the frame before the scheduled stop");
+    STAssertFalse(kwlInstanceEventIsPlaying(engine, handle), @"the event should have stopped");
+    
+    kwlInstanceEventRelease(engine, handle);
+    kwlEngineDestroy(engine);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"destroying the instance should not fail");
+}
+
+/***************************************************************************
+ * HELPER METHODS
+ ***************************************************************************/
+
+-(void)getFirstAndLastNonSilentFrame:(const float*)buffer 
+                                    :(int)numFrames 
+                                    :(long long*)firstFrame 
+                                    :(long long*)lastFrame
+{
+    *firstFrame = -1;
+    *lastFrame = -1;
+    for (int i = 0; i < numFrames; i++)
+    {
+        if (buffer[2 * i] != 0.0f || buffer[2 * i + 1] != 0.0f)
+        {
+            *firstFrame = *firstFrame < 0 ? i : *firstFrame;
+            *lastFrame = i;
+        }
+    }
+}
+
+@end
@@ -0,0 +1,204 @@
+/*
+ Copyright (c) 2010-2012 Per Gantelius
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any damages
+ arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it
+ freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must not
+ claim that you wrote the original software. If you use this software
+ in a product, an acknowledgment in the product documentation would be
+ appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and must not be
+ misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#import "TestUnloading.h"
+
+#import "kowalski.h"
+#import "TestUtil.h"
+
+#import <unistd.h>
+
+/** Counts the invocations of an unload completed callback.*/
+static void countUnloadCompleted(void* userData)
+{
+    (*(int*)userData)++;
+}
+
+@implementation TestUnloading
+
+- (void)setUp
+{
+    [super setUp];
+    
+    /*build a project with an entry streamed from disk and one loaded into memory, both 
+      long enough to play throughout the tests.*/
+    NSString* dir = [self testDirectory];
+    [TestUtil createEmptyDirectory:dir];
+    [TestUtil writeWAV:[dir stringByAppendingPathComponent:@"streamed.wav"] :441000];
+    [TestUtil writeWAV:[dir stringByAppendingPathComponent:@"memory.wav"] :441000];
+    NSString* audioDataXML = [[TestUtil audioDataXML:@"streamed.wav" :YES] 
+                              stringByAppendingString:[TestUtil audioDataXML:@"memory.wav" :NO]];
+    NSString* eventsXML = [[TestUtil eventXML:@"streamed" :@"streamed.wav"] 
+                           stringByAppendingString:[TestUtil eventXML:@"memory" :@"memory.wav"]];
+    STAssertEquals([TestUtil buildProject:dir :audioDataXML :eventsXML],
+                   KWL_SUCCESS,
+                   @"failed to build the project");
+    
+    kwlInitialize(44100, 2, 0, 512);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to initialize the engine");
+    kwlEngineDataLoad([[dir stringByAppendingPathComponent:@"project.kwl"] UTF8String]);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to load engine data");
+}
+
+- (void)tearDown
+{
+    kwlDeinitialize();
+    [[NSFileManager defaultManager] removeItemAtPath:[self testDirectory] error:NULL];
+    
+    [super tearDown];
+}
+
+/***************************************************************************
+ * NON-BLOCKING UNLOADS
+ ***************************************************************************/
+
+-(void)testWaveBankUnloadWithCallback
+{
+    kwlWaveBankHandle waveBank = [self loadWaveBankAndStartStreamedEvent];
+    
+    /*the event streams from the wave bank, so unloading waits for the mixer to stop it.*/
+    int numCallbacks = 0;
+    kwlWaveBankUnloadWithCallback(waveBank, countUnloadCompleted, &numCallbacks);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to request the wave bank unload");
+    STAssertTrue(kwlWaveBankIsUnloadPending(waveBank) != 0, @"the unload should be pending");
+    STAssertTrue(kwlWaveBankIsLoaded(waveBank) != 0, @"the wave bank should stay loaded until the mixer has stopped the event");
+    STAssertEquals(numCallbacks, 0, @"the callback should not be invoked before the unload completes");
+    
+    [self updateUntilNonZero:&numCallbacks];
+    STAssertEquals(numCallbacks, 1, @"the callback should be invoked once");
+    STAssertFalse(kwlWaveBankIsUnloadPending(waveBank) != 0, @"the unload should not be pending");
+    STAssertFalse(kwlWaveBankIsLoaded(waveBank) != 0, @"the wave bank should be unloaded");
+    
+    /*without playing events, the wave bank is unloaded right away and the callback is invoked from kwlUpdate.
+      Give the engine time to receive the stopped message of the event first.*/
+    for (int i = 0; i < 10; i++)
+    {
+        kwlUpdate(0.01f);
+        usleep(10000);
+    }
+    kwlWaveBankLoad([[[self testDirectory] stringByAppendingPathComponent:@"bank.kwb"] UTF8String]);
+    numCallbacks = 0;
+    kwlWaveBankUnloadWithCallback(waveBank, countUnloadCompleted, &numCallbacks);
+    STAssertFalse(kwlWaveBankIsLoaded(waveBank) != 0, @"the wave bank should be unloaded");
+    STAssertEquals(numCallbacks, 0, @"the callback should be invoked from kwlUpdate");
+    kwlUpdate(0.01f);
+    STAssertEquals(numCallbacks, 1, @"the callback should be invoked once");
+    
+    kwlWaveBankUnloadWithCallback(waveBank, NULL, NULL);
+    STAssertEquals(kwlGetError(), KWL_INVALID_PARAMETER_VALUE, @"a NULL callback should be rejected");
+}
+
+-(void)testEngineDataUnloadAsync
+{
+    kwlWaveBankHandle waveBank = [self loadWaveBankAndStartStreamedEvent];
+    
+    /*a pending wave bank unload completes along with the engine data unload.*/
+    int numWaveBankCallbacks = 0;
+    int numEngineDataCallbacks = 0;
+    kwlWaveBankUnloadWithCallback(waveBank, countUnloadCompleted, &numWaveBankCallbacks);
+    kwlEngineDataUnloadAsync(countUnloadCompleted, &numEngineDataCallbacks);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to request the engine data unload");
+    STAssertTrue(kwlEngineDataIsUnloadPending() != 0, @"the unload should be pending");
+    STAssertTrue(kwlEngineDataIsLoaded() != 0, @"engine data should stay loaded until the mixer has stopped all events");
+    
+    [self updateUntilNonZero:&numEngineDataCallbacks];
+    STAssertEquals(numEngineDataCallbacks, 1, @"the engine data callback should be invoked once");
+    STAssertEquals(numWaveBankCallbacks, 1, @"the wave bank callback should be invoked once");
+    STAssertFalse(kwlEngineDataIsUnloadPending() != 0, @"the unload should not be pending");
+    STAssertFalse(kwlEngineDataIsLoaded() != 0, @"engine data should be unloaded");
+}
+
+-(void)testInMemoryWaveBankUnloadWithCallback
+{
+    kwlWaveBankHandle waveBank = kwlWaveBankLoad([[[self testDirectory] stringByAppendingPathComponent:@"bank.kwb"] UTF8String]);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to load the wave bank");
+    kwlEventHandle event = kwlEventGetHandle("memory");
+    kwlEventStart(event);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to start the in-memory event");
+    kwlUpdate(0.01f);
+    
+    /*the mixer reads the audio data of the event, so unloading waits for the mixer to stop it.*/
+    int numCallbacks = 0;
+    kwlWaveBankUnloadWithCallback(waveBank, countUnloadCompleted, &numCallbacks);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to request the wave bank unload");
+    STAssertTrue(kwlWaveBankIsUnloadPending(waveBank) != 0, @"the unload should be pending");
+    STAssertTrue(kwlWaveBankIsLoaded(waveBank) != 0, @"the wave bank should stay loaded until the mixer has stopped the event");
+    
+    [self updateUntilNonZero:&numCallbacks];
+    STAssertEquals(numCallbacks, 1, @"the callback should be invoked once");
+    STAssertFalse(kwlEventIsPlaying(event) != 0, @"the event should be stopped before the wave bank is unloaded");
+    STAssertFalse(kwlWaveBankIsLoaded(waveBank) != 0, @"the wave bank should be unloaded");
+    
+    kwlEventRelease(event);
+}
+
+/***************************************************************************
+ * BLOCKING UNLOADS
+ ***************************************************************************/
+
+-(void)testBlockingUnloads
+{
+    kwlWaveBankHandle waveBank = [self loadWaveBankAndStartStreamedEvent];
+    kwlWaveBankUnloadBlocking(waveBank);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to unload the wave bank");
+    STAssertFalse(kwlWaveBankIsLoaded(waveBank) != 0, @"the wave bank should be unloaded");
+    
+    [self loadWaveBankAndStartStreamedEvent];
+    kwlEngineDataUnload();
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to unload engine data");
+    STAssertFalse(kwlEngineDataIsLoaded() != 0, @"engine data should be unloaded");
+}
+
+/***************************************************************************
+ * HELPER METHODS
+ ***************************************************************************/
+
+-(NSString*)testDirectory
+{
+    return [NSTemporaryDirectory() stringByAppendingPathComponent:@"kwl_test_unloading"];
+}
+
+-(kwlWaveBankHandle)loadWaveBankAndStartStreamedEvent
+{
+    kwlWaveBankHandle waveBank = kwlWaveBankLoad([[[self testDirectory] stringByAppendingPathComponent:@"bank.kwb"] UTF8String]);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to load the wave bank");
+    
+    kwlEventHandle event = kwlEventGetHandle("streamed");
+    kwlEventStart(event);
+    kwlEventRelease(event);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to start the streamed event");
+    kwlUpdate(0.01f);
+    return waveBank;
+}
+
+-(void)updateUntilNonZero:(int*)value
+{
+    for (int i = 0; i < 500 && *value == 0; i++)
+    {
+        kwlUpdate(0.01f);
+        usleep(10000);
+    }
+}
+
+@end
@@ -0,0 +1,71 @@
+/*
+ Copyright (c) 2010-2012 Per Gantelius
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any damages
+ arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it
+ freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must not
+ claim that you wrote the original software. If you use this software
+ in a product, an acknowledgment in the product documentation would be
+ appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and must not be
+ misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#import <Foundation/Foundation.h>
+
+#import "kwl_binarybuilding.h"
+
+/**
+ * Fixtures shared by the tests: test directories, generated audio files
+ * and projects with a single wave bank, \c bank, and a \c master bus.
+ */
+@interface TestUtil : NSObject
+
+/** Returns the path of a resource in the test bundle.*/
++(const char*)getResourcePath:(NSString*)fileName;
+
+/** Creates an empty directory, removing any previous directory at the same path.*/
++(void)createEmptyDirectory:(NSString*)path;
+
+/** Writes a mono 16 bit 44.1 kHz WAV file containing a 440 Hz sine.*/
++(void)writeWAV:(NSString*)path
+               :(int)numFrames;
+
+/** Returns an audio data element for the wave bank of a project.*/
++(NSString*)audioDataXML:(NSString*)fileName
+                        :(BOOL)streamFromDisk;
+
+/** Returns a non-positional event on the master bus playing an audio data entry.*/
++(NSString*)eventXML:(NSString*)eventID
+                    :(NSString*)fileName;
+
+/** Returns the XML of a project, with a given gain on the master bus.*/
++(NSString*)projectXML:(NSString*)audioDataXML
+                      :(NSString*)eventsXML
+                      :(float)gain;
+
+/** Writes project XML to a file and builds engine data from it.*/
++(kwlResultCode)buildEngineData:(NSString*)xml
+                               :(NSString*)xmlPath
+                               :(NSString*)engineDataPath;
+
+/** 
+ * Builds project.xml, project.kwl and bank.kwb in a directory containing
+ * the referenced audio files.
+ */
++(kwlResultCode)buildProject:(NSString*)directory
+                            :(NSString*)audioDataXML
+                            :(NSString*)eventsXML;
+
+@end
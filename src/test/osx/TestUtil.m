@@ -0,0 +1,145 @@
+/*
+ Copyright (c) 2010-2012 Per Gantelius
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any damages
+ arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it
+ freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must not
+ claim that you wrote the original software. If you use this software
+ in a product, an acknowledgment in the product documentation would be
+ appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and must not be
+ misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#import "TestUtil.h"
+
+#import "kwl_logging.h"
+
+@implementation TestUtil
+
++(const char*)getResourcePath:(NSString*)fileName
+{
+    NSBundle *bundle = [NSBundle bundleForClass:self];
+    NSString *path = [bundle pathForResource:fileName
+                                      ofType:nil];
+    
+    return [path UTF8String];
+}
+
++(void)createEmptyDirectory:(NSString*)path
+{
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+    [[NSFileManager defaultManager] createDirectoryAtPath:path
+                              withIntermediateDirectories:YES
+                                               attributes:nil
+                                                    error:NULL];
+}
+
++(void)writeWAV:(NSString*)path
+               :(int)numFrames
+{
+    const int numDataBytes = 2 * numFrames;
+    NSMutableData* data = [NSMutableData dataWithCapacity:44 + numDataBytes];
+    const int header[] = {0x46464952, 36 + numDataBytes, 0x45564157, 0x20746d66, 16,
+                          0x00010001, 44100, 2 * 44100, 0x00100002, 0x61746164, numDataBytes};
+    for (int i = 0; i < 11; i++)
+    {
+        /*little endian*/
+        unsigned char bytes[4] = {header[i] & 0xff, (header[i] >> 8) & 0xff, (header[i] >> 16) & 0xff, (header[i] >> 24) & 0xff};
+        [data appendBytes:bytes length:4];
+    }
+    for (int i = 0; i < numFrames; i++)
+    {
+        const short sample = (short)(8000 * sin(2 * M_PI * 440 * i / 44100.0));
+        unsigned char bytes[2] = {sample & 0xff, (sample >> 8) & 0xff};
+        [data appendBytes:bytes length:2];
+    }
+    [data writeToFile:path atomically:YES];
+}
+
++(NSString*)audioDataXML:(NSString*)fileName
+                        :(BOOL)streamFromDisk
+{
+    return [NSString stringWithFormat:@"      <AudioData relativePath=\"%@\"%@/>\n", 
+            fileName, 
+            streamFromDisk ? @" streamFromDisk=\"true\"" : @""];
+}
+
++(NSString*)eventXML:(NSString*)eventID
+                    :(NSString*)fileName
+{
+    return [NSString stringWithFormat:
+            @"    <Event bus=\"master\" positional=\"false\" id=\"%@\">\n"
+            "      <AudioDataReference relativePath=\"%@\" waveBank=\"bank\"/>\n"
+            "    </Event>\n", eventID, fileName];
+}
+
++(NSString*)projectXML:(NSString*)audioDataXML
+                      :(NSString*)eventsXML
+                      :(float)gain
+{
+    return [NSString stringWithFormat:
+    @"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<KowalskiProject version=\"1.0\">\n"
+    "  <WaveBankGroup id=\"root\">\n"
+    "    <WaveBank id=\"bank\">\n"
+    "%@"
+    "    </WaveBank>\n"
+    "  </WaveBankGroup>\n"
+    "  <SoundGroup id=\"root\"/>\n"
+    "  <EventGroup id=\"root\">\n"
+    "%@"
+    "  </EventGroup>\n"
+    "  <MixBus id=\"master\"/>\n"
+    "  <MixPresetGroup id=\"root\">\n"
+    "    <MixPreset id=\"default\" default=\"true\">\n"
+    "      <MixBusParameters mixBus=\"master\" leftGain=\"%f\" rightGain=\"%f\" pitch=\"1\"/>\n"
+    "    </MixPreset>\n"
+    "  </MixPresetGroup>\n"
+    "</KowalskiProject>\n", audioDataXML, eventsXML, gain, gain];
+}
+
++(kwlResultCode)buildEngineData:(NSString*)xml
+                               :(NSString*)xmlPath
+                               :(NSString*)engineDataPath
+{
+    [xml writeToFile:xmlPath atomically:YES encoding:NSUTF8StringEncoding error:NULL];
+    return kwlBuildEngineData([xmlPath UTF8String], 
+                              [self getResourcePath:@"kowalski.xsd"], 
+                              [engineDataPath UTF8String], 
+                              1, 
+                              kwlDefaultLogCallback);
+}
+
++(kwlResultCode)buildProject:(NSString*)directory
+                            :(NSString*)audioDataXML
+                            :(NSString*)eventsXML
+{
+    NSString* xmlPath = [directory stringByAppendingPathComponent:@"project.xml"];
+    const kwlResultCode result = [self buildEngineData:[self projectXML:audioDataXML :eventsXML :1.0f]
+                                                     :xmlPath
+                                                     :[directory stringByAppendingPathComponent:@"project.kwl"]];
+    if (result != KWL_SUCCESS)
+    {
+        return result;
+    }
+    
+    return kwlBuildWaveBanks([xmlPath UTF8String], 
+                             [self getResourcePath:@"kowalski.xsd"], 
+                             [directory UTF8String], 
+                             1, 
+                             kwlDefaultLogCallback);
+}
+
+@end
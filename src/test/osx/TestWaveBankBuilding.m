@@ -0,0 +1,76 @@
+/*
+ Copyright (c) 2010-2012 Per Gantelius
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any damages
+ arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it
+ freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must not
+ claim that you wrote the original software. If you use this software
+ in a product, an acknowledgment in the product documentation would be
+ appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and must not be
+ misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#import "TestWaveBankBuilding.h"
+
+#import "TestUtil.h"
+
+@implementation TestWaveBankBuilding
+
+- (void)setUp
+{
+    [super setUp];
+    
+    [TestUtil createEmptyDirectory:[self testDirectory]];
+}
+
+- (void)tearDown
+{
+    [[NSFileManager defaultManager] removeItemAtPath:[self testDirectory] error:NULL];
+    
+    [super tearDown];
+}
+
+/***************************************************************************
+ * LOADING ERRORS
+ ***************************************************************************/
+
+-(void)testUnreadableAudioFileFailsBuild
+{
+    NSString* dir = [self testDirectory];
+    [TestUtil writeWAV:[dir stringByAppendingPathComponent:@"sound.wav"] :4410];
+    [@"not audio data" writeToFile:[dir stringByAppendingPathComponent:@"corrupt.wav"] 
+                        atomically:YES 
+                          encoding:NSUTF8StringEncoding 
+                             error:NULL];
+    
+    NSString* audioDataXML = [[TestUtil audioDataXML:@"sound.wav" :NO] 
+                              stringByAppendingString:[TestUtil audioDataXML:@"corrupt.wav" :NO]];
+    STAssertEquals([TestUtil buildProject:dir :audioDataXML :@""],
+                   KWL_AUDIO_FILE_LOADING_ERROR,
+                   @"a wave bank with an unreadable audio file should not build");
+    STAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:[dir stringByAppendingPathComponent:@"bank.kwb"]],
+                  @"no wave bank should be written");
+}
+
+/***************************************************************************
+ * HELPER METHODS
+ ***************************************************************************/
+
+-(NSString*)testDirectory
+{
+    return [NSTemporaryDirectory() stringByAppendingPathComponent:@"kwl_test_wave_bank_building"];
+}
+
+@end
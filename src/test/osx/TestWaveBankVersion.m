@@ -0,0 +1,121 @@
+/*
+ Copyright (c) 2010-2012 Per Gantelius
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any damages
+ arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it
+ freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must not
+ claim that you wrote the original software. If you use this software
+ in a product, an acknowledgment in the product documentation would be
+ appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and must not be
+ misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#import "TestWaveBankVersion.h"
+
+#import "kowalski.h"
+#import "kwl_wavebank.h"
+#import "TestUtil.h"
+
+@implementation TestWaveBankVersion
+
+- (void)setUp
+{
+    [super setUp];
+    
+    NSString* dir = [self testDirectory];
+    [TestUtil createEmptyDirectory:dir];
+    [TestUtil writeWAV:[dir stringByAppendingPathComponent:@"sound.wav"] :4410];
+    STAssertEquals([TestUtil buildProject:dir 
+                                         :[TestUtil audioDataXML:@"sound.wav" :NO] 
+                                         :[TestUtil eventXML:@"event" :@"sound.wav"]],
+                   KWL_SUCCESS,
+                   @"failed to build the project");
+    
+    kwlInitialize(44100, 2, 0, 512);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to initialize the engine");
+    kwlEngineDataLoad([[dir stringByAppendingPathComponent:@"project.kwl"] UTF8String]);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"failed to load engine data");
+}
+
+- (void)tearDown
+{
+    kwlDeinitialize();
+    [[NSFileManager defaultManager] removeItemAtPath:[self testDirectory] error:NULL];
+    
+    [super tearDown];
+}
+
+/***************************************************************************
+ * VERSION TESTS
+ ***************************************************************************/
+
+-(void)testCurrentVersionIsAccepted
+{
+    NSString* path = [[self testDirectory] stringByAppendingPathComponent:@"bank.kwb"];
+    kwlWaveBankHandle handle = kwlWaveBankLoad([path UTF8String]);
+    STAssertEquals(kwlGetError(), KWL_NO_ERROR, @"a wave bank of the current version should load");
+    STAssertTrue(kwlWaveBankIsLoaded(handle) != 0, @"the wave bank should be loaded");
+}
+
+-(void)testOtherVersionsAreRejected
+{
+    const int versions[] = {0, KWL_WAVE_BANK_BINARY_VERSION - 1, KWL_WAVE_BANK_BINARY_VERSION + 1, -1};
+    for (int i = 0; i < 4; i++)
+    {
+        if (versions[i] == KWL_WAVE_BANK_BINARY_VERSION)
+        {
+            continue;
+        }
+        
+        NSString* path = [[self testDirectory] stringByAppendingPathComponent:@"other.kwb"];
+        [self writeWaveBankWithVersion:path :versions[i]];
+        kwlWaveBankLoad([path UTF8String]);
+        STAssertEquals(kwlGetError(), KWL_UNKNOWN_FILE_FORMAT, @"a wave bank of another version should be rejected");
+    }
+}
+
+-(void)testUnversionedWaveBankIsRejected
+{
+    /*wave banks written before versioning have the id right after the file identifier.*/
+    NSString* dir = [self testDirectory];
+    NSMutableData* data = [NSMutableData dataWithContentsOfFile:[dir stringByAppendingPathComponent:@"bank.kwb"]];
+    [data replaceBytesInRange:NSMakeRange(KWL_WAVE_BANK_BINARY_FILE_IDENTIFIER_LENGTH, 4) withBytes:NULL length:0];
+    NSString* path = [dir stringByAppendingPathComponent:@"unversioned.kwb"];
+    [data writeToFile:path atomically:YES];
+    
+    kwlWaveBankLoad([path UTF8String]);
+    STAssertEquals(kwlGetError(), KWL_UNKNOWN_FILE_FORMAT, @"an unversioned wave bank should be rejected");
+}
+
+/***************************************************************************
+ * HELPER METHODS
+ ***************************************************************************/
+
+-(NSString*)testDirectory
+{
+    return [NSTemporaryDirectory() stringByAppendingPathComponent:@"kwl_test_wave_bank_version"];
+}
+
+-(void)writeWaveBankWithVersion:(NSString*)path
+                               :(int)version
+{
+    /*the version is a big endian int following the file identifier.*/
+    NSMutableData* data = [NSMutableData dataWithContentsOfFile:[[self testDirectory] stringByAppendingPathComponent:@"bank.kwb"]];
+    unsigned char bytes[4] = {(version >> 24) & 0xff, (version >> 16) & 0xff, (version >> 8) & 0xff, version & 0xff};
+    [data replaceBytesInRange:NSMakeRange(KWL_WAVE_BANK_BINARY_FILE_IDENTIFIER_LENGTH, 4) withBytes:bytes];
+    [data writeToFile:path atomically:YES];
+}
+
+@end
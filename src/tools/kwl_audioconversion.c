@@ -0,0 +1,371 @@
+/*
+ Copyright (c) 2010-2012 Per Gantelius
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any damages
+ arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it
+ freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must not
+ claim that you wrote the original software. If you use this software
+ in a product, an acknowledgment in the product documentation would be
+ appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and must not be
+ misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#include <math.h>
+
+#include "kwl_assert.h"
+#include "kwl_audioconversion.h"
+#include "kwl_memory.h"
+#include "kwl_synchronization.h"
+
+/** The number of zero crossings on each side of the resampling filter kernel.*/
+#define KWL_RESAMPLER_NUM_ZERO_CROSSINGS 32
+/** The number of filter table entries per zero crossing.*/
+#define KWL_RESAMPLER_TABLE_RESOLUTION 512
+/** The Kaiser window shape parameter. Gives roughly 90 dB stop band attenuation.*/
+#define KWL_RESAMPLER_KAISER_BETA 9.0
+/** The fraction of the output Nyquist frequency to use as filter cutoff.*/
+#define KWL_RESAMPLER_CUTOFF_SCALE 0.95
+/** The size of a canonical WAV header in bytes.*/
+#define KWL_WAV_HEADER_SIZE 44
+
+/** 
+ * The right half of a Kaiser windowed sinc, sampled at KWL_RESAMPLER_TABLE_RESOLUTION
+ * points per zero crossing. Shared by all conversions regardless of ratio.
+ */
+static float kwlResamplerTable[KWL_RESAMPLER_NUM_ZERO_CROSSINGS * KWL_RESAMPLER_TABLE_RESOLUTION + 2];
+static int kwlResamplerTableInitialized = 0;
+
+/** Zeroth order modified Bessel function of the first kind.*/
+static double kwlBesselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 50; k++)
+    {
+        const double t = x / (2.0 * k);
+        term *= t * t;
+        sum += term;
+        if (term < sum * 1e-12)
+        {
+            break;
+        }
+    }
+    return sum;
+}
+
+static void kwlInitResamplerTable()
+{
+    if (kwlResamplerTableInitialized)
+    {
+        return;
+    }
+    
+    const int numPoints = KWL_RESAMPLER_NUM_ZERO_CROSSINGS * KWL_RESAMPLER_TABLE_RESOLUTION;
+    const double i0Beta = kwlBesselI0(KWL_RESAMPLER_KAISER_BETA);
+    for (int i = 0; i <= numPoints; i++)
+    {
+        const double u = i / (double)KWL_RESAMPLER_TABLE_RESOLUTION;
+        const double sinc = i == 0 ? 1.0 : sin(M_PI * u) / (M_PI * u);
+        const double r = u / KWL_RESAMPLER_NUM_ZERO_CROSSINGS;
+        const double window = kwlBesselI0(KWL_RESAMPLER_KAISER_BETA * sqrt(1.0 - r * r)) / i0Beta;
+        kwlResamplerTable[i] = (float)(sinc * window);
+    }
+    /*guard point for the interpolation at the very edge of the kernel*/
+    kwlResamplerTable[numPoints + 1] = 0.0f;
+    
+    kwlResamplerTableInitialized = 1;
+}
+
+/** Evaluates the filter kernel at u zero crossings from its center, u >= 0.*/
+static float kwlResamplerKernel(double u)
+{
+    const double pos = u * KWL_RESAMPLER_TABLE_RESOLUTION;
+    const int idx = (int)pos;
+    if (idx >= KWL_RESAMPLER_NUM_ZERO_CROSSINGS * KWL_RESAMPLER_TABLE_RESOLUTION)
+    {
+        return 0.0f;
+    }
+    const float frac = (float)(pos - idx);
+    return kwlResamplerTable[idx] + frac * (kwlResamplerTable[idx + 1] - kwlResamplerTable[idx]);
+}
+
+/** Returns the value of a given input frame and output channel, downmixing if required.*/
+static float kwlGetInputSample(const kwlAudioConversionJob* job, int frame, int channel)
+{
+    const short* f = &job->input[frame * job->numInputChannels];
+    if (job->numOutputChannels == job->numInputChannels)
+    {
+        return f[channel];
+    }
+    
+    float sum = 0.0f;
+    for (int c = 0; c < job->numInputChannels; c++)
+    {
+        sum += f[c];
+    }
+    return sum / job->numInputChannels;
+}
+
+static int kwlGetEncodingBitDepth(kwlAudioEncoding encoding)
+{
+    switch (encoding)
+    {
+        case KWL_ENCODING_SIGNED_8BIT_PCM:
+        case KWL_ENCODING_UNSIGNED_8BIT_PCM:
+            return 8;
+        case KWL_ENCODING_SIGNED_16BIT_PCM:
+            return 16;
+        case KWL_ENCODING_SIGNED_24BIT_PCM:
+            return 24;
+        case KWL_ENCODING_SIGNED_32BIT_PCM:
+            return 32;
+        default:
+            return 0;
+    }
+}
+
+static void kwlWriteIntLE(unsigned char* dst, int value, int numBytes)
+{
+    for (int i = 0; i < numBytes; i++)
+    {
+        dst[i] = (unsigned char)((value >> (8 * i)) & 0xff);
+    }
+}
+
+/** Writes a sample, given in 16 bit scale, at the job's output bit depth.*/
+static unsigned char* kwlWriteSample(const kwlAudioConversionJob* job, unsigned char* dst, float value)
+{
+    if (job->outputBitDepth == 8)
+    {
+        long s = lrintf(value / 256.0f);
+        s = s < -128 ? -128 : (s > 127 ? 127 : s);
+        *dst = (unsigned char)(s + 128);
+        return dst + 1;
+    }
+    
+    long s = lrintf(value);
+    s = s < -32768 ? -32768 : (s > 32767 ? 32767 : s);
+    if (job->writeWAVHeader)
+    {
+        kwlWriteIntLE(dst, (int)s, 2);
+    }
+    else
+    {
+        /*in-memory data is read by the mixer as native shorts*/
+        short ss = (short)s;
+        kwlMemcpy(dst, &ss, 2);
+    }
+    return dst + 2;
+}
+
+int kwlAudioConversionSettings_requiresConversion(const kwlAudioConversionSettings* settings,
+                                                  kwlAudioData* audioData,
+                                                  int isStreaming)
+{
+    if (!kwlAudioData_isLinearPCM(audioData))
+    {
+        return 0;
+    }
+    
+    if (settings->targetSampleRate > 0 &&
+        audioData->sampleRate > 0 &&
+        settings->targetSampleRate != audioData->sampleRate)
+    {
+        return 1;
+    }
+    
+    if (settings->downmixToMono && audioData->numChannels > 1)
+    {
+        return 1;
+    }
+    
+    if (isStreaming &&
+        settings->bitDepth > 0 &&
+        settings->bitDepth != kwlGetEncodingBitDepth(audioData->encoding))
+    {
+        return 1;
+    }
+    
+    return 0;
+}
+
+void kwlAudioConversionJob_init(kwlAudioConversionJob* job,
+                                const kwlAudioConversionSettings* settings,
+                                kwlAudioData* audioData,
+                                int isStreaming)
+{
+    KWL_ASSERT(audioData->encoding == KWL_ENCODING_SIGNED_16BIT_PCM);
+    
+    kwlInitResamplerTable();
+    
+    kwlMemset(job, 0, sizeof(kwlAudioConversionJob));
+    job->input = (const short*)audioData->bytes;
+    job->numInputFrames = audioData->numFrames;
+    job->numInputChannels = audioData->numChannels;
+    job->inputSampleRate = audioData->sampleRate;
+    
+    job->numOutputChannels = settings->downmixToMono ? 1 : audioData->numChannels;
+    job->outputSampleRate = settings->targetSampleRate > 0 && audioData->sampleRate > 0 ? 
+                                settings->targetSampleRate : audioData->sampleRate;
+    job->outputBitDepth = isStreaming && settings->bitDepth > 0 ? settings->bitDepth : 16;
+    KWL_ASSERT(job->outputBitDepth == 8 || job->outputBitDepth == 16);
+    job->writeWAVHeader = isStreaming;
+    
+    if (job->outputSampleRate == job->inputSampleRate)
+    {
+        job->numOutputFrames = job->numInputFrames;
+    }
+    else
+    {
+        job->numOutputFrames = (int)(((long long)job->numInputFrames * job->outputSampleRate +
+                                      job->inputSampleRate - 1) / job->inputSampleRate);
+    }
+    
+    const int numDataBytes = job->numOutputFrames * job->numOutputChannels * job->outputBitDepth / 8;
+    job->numOutputBytes = numDataBytes + (job->writeWAVHeader ? KWL_WAV_HEADER_SIZE : 0);
+    job->output = (unsigned char*)KWL_MALLOC(job->numOutputBytes, KWL_MEMORY_CATEGORY_GENERAL, "converted audio data");
+}
+
+void kwlAudioConversionJob_process(kwlAudioConversionJob* job)
+{
+    KWL_ASSERT(kwlResamplerTableInitialized);
+    
+    unsigned char* dst = job->output;
+    
+    if (job->writeWAVHeader)
+    {
+        const int numDataBytes = job->numOutputBytes - KWL_WAV_HEADER_SIZE;
+        const int blockAlign = job->numOutputChannels * job->outputBitDepth / 8;
+        kwlMemcpy(dst, "RIFF", 4);
+        kwlWriteIntLE(dst + 4, job->numOutputBytes - 8, 4);
+        kwlMemcpy(dst + 8, "WAVEfmt ", 8);
+        kwlWriteIntLE(dst + 16, 16, 4);
+        kwlWriteIntLE(dst + 20, 1, 2); /*linear PCM*/
+        kwlWriteIntLE(dst + 22, job->numOutputChannels, 2);
+        kwlWriteIntLE(dst + 24, job->outputSampleRate, 4);
+        kwlWriteIntLE(dst + 28, job->outputSampleRate * blockAlign, 4);
+        kwlWriteIntLE(dst + 32, blockAlign, 2);
+        kwlWriteIntLE(dst + 34, job->outputBitDepth, 2);
+        kwlMemcpy(dst + 36, "data", 4);
+        kwlWriteIntLE(dst + 40, numDataBytes, 4);
+        dst += KWL_WAV_HEADER_SIZE;
+    }
+    
+    if (job->outputSampleRate == job->inputSampleRate)
+    {
+        for (int i = 0; i < job->numOutputFrames; i++)
+        {
+            for (int c = 0; c < job->numOutputChannels; c++)
+            {
+                dst = kwlWriteSample(job, dst, kwlGetInputSample(job, i, c));
+            }
+        }
+        return;
+    }
+    
+    /*band limited interpolation using a Kaiser windowed sinc. when decimating,
+      the kernel is stretched so that its cutoff sits below the output Nyquist frequency.*/
+    const double step = job->inputSampleRate / (double)job->outputSampleRate;
+    const double cutoff = KWL_RESAMPLER_CUTOFF_SCALE * (step > 1.0 ? 1.0 / step : 1.0);
+    const double halfWidth = KWL_RESAMPLER_NUM_ZERO_CROSSINGS / cutoff;
+    
+    for (int i = 0; i < job->numOutputFrames; i++)
+    {
+        const double t = i * step;
+        int first = (int)ceil(t - halfWidth);
+        int last = (int)floor(t + halfWidth);
+        first = first < 0 ? 0 : first;
+        last = last >= job->numInputFrames ? job->numInputFrames - 1 : last;
+        
+        for (int c = 0; c < job->numOutputChannels; c++)
+        {
+            double sum = 0.0;
+            for (int k = first; k <= last; k++)
+            {
+                sum += kwlGetInputSample(job, k, c) * kwlResamplerKernel(fabs(t - k) * cutoff);
+            }
+            dst = kwlWriteSample(job, dst, (float)(sum * cutoff));
+        }
+    }
+}
+
+/** Shared state for the conversion worker threads.*/
+typedef struct kwlAudioConversionQueue
+{
+    kwlAudioConversionJob* jobs;
+    int numJobs;
+    int nextJob;
+    kwlMutexLock lock;
+} kwlAudioConversionQueue;
+
+static void* kwlAudioConversionWorker(void* param)
+{
+    kwlAudioConversionQueue* queue = (kwlAudioConversionQueue*)param;
+    
+    while (1)
+    {
+        kwlMutexLockAcquire(&queue->lock);
+        const int jobIndex = queue->nextJob++;
+        kwlMutexLockRelease(&queue->lock);
+        
+        if (jobIndex >= queue->numJobs)
+        {
+            break;
+        }
+        
+        kwlAudioConversionJob_process(&queue->jobs[jobIndex]);
+    }
+    
+    return NULL;
+}
+
+void kwlProcessAudioConversionJobs(kwlAudioConversionJob* jobs, int numJobs)
+{
+    if (numJobs <= 0)
+    {
+        return;
+    }
+    
+    kwlAudioConversionQueue queue;
+    queue.jobs = jobs;
+    queue.numJobs = numJobs;
+    queue.nextJob = 0;
+    kwlMutexLockInit(&queue.lock);
+    
+    int numThreads = KWL_AUDIO_CONVERSION_NUM_THREADS;
+    numThreads = numThreads > numJobs ? numJobs : numThreads;
+    
+    if (numThreads <= 1)
+    {
+        /*no worker threads needed, do the work on this thread*/
+        kwlAudioConversionWorker(&queue);
+        return;
+    }
+    
+    /*the thread handles are allocated up front, since the worker threads 
+      must not touch the (possibly non thread safe) allocator.*/
+    kwlThread* threads = (kwlThread*)KWL_MALLOC(numThreads * sizeof(kwlThread), KWL_MEMORY_CATEGORY_GENERAL, "conversion threads");
+    for (int i = 0; i < numThreads; i++)
+    {
+        kwlThreadCreate(&threads[i], kwlAudioConversionWorker, &queue);
+    }
+    
+    for (int i = 0; i < numThreads; i++)
+    {
+        kwlThreadJoin(&threads[i]);
+    }
+    
+    KWL_FREE(threads);
+}
@@ -0,0 +1,141 @@
+/*
+ Copyright (c) 2010-2012 Per Gantelius
+ 
+ This software is provided 'as-is', without any express or implied
+ warranty. In no event will the authors be held liable for any damages
+ arising from the use of this software.
+ 
+ Permission is granted to anyone to use this software for any purpose,
+ including commercial applications, and to alter it and redistribute it
+ freely, subject to the following restrictions:
+ 
+ 1. The origin of this software must not be misrepresented; you must not
+ claim that you wrote the original software. If you use this software
+ in a product, an acknowledgment in the product documentation would be
+ appreciated but is not required.
+ 
+ 2. Altered source versions must be plainly marked as such, and must not be
+ misrepresented as being the original software.
+ 
+ 3. This notice may not be removed or altered from any source
+ distribution.
+ */
+
+
+#ifndef KWL_AUDIO_CONVERSION_H
+#define KWL_AUDIO_CONVERSION_H
+
+#include "kwl_audiodata.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+    
+/** 
+ * The number of worker threads used to process conversion jobs. Can be overridden
+ * at build time. Platforms without kwlThread support process all jobs on the 
+ * calling thread.
+ */
+#ifndef KWL_AUDIO_CONVERSION_NUM_THREADS
+    #ifdef _WIN32
+        #define KWL_AUDIO_CONVERSION_NUM_THREADS 1
+    #else
+        #define KWL_AUDIO_CONVERSION_NUM_THREADS 4
+    #endif /* _WIN32 */
+#endif /* KWL_AUDIO_CONVERSION_NUM_THREADS */
+    
+    /**
+     * Build time conversion settings for a wave bank entry, resolved from the 
+     * attributes of the entry's AudioData node and its parent WaveBank node.
+     */
+    typedef struct kwlAudioConversionSettings
+    {
+        /** The sample rate to convert to in Hz. Zero means keep the source sample rate.*/
+        int targetSampleRate;
+        /** Non-zero if multichannel audio should be downmixed to mono.*/
+        int downmixToMono;
+        /** 
+         * The bit depth of streamed PCM entries, 8 or 16. Zero means keep the source bit depth,
+         * unless the entry is resampled or downmixed, which gives 16 bit output. Converted audio
+         * is decoded to 16 bit first, so higher bit depths would not add any precision.
+         * Ignored for entries loaded into memory, which are always 16 bit.
+         */
+        int bitDepth;
+    } kwlAudioConversionSettings;
+    
+    /**
+     * Describes the conversion of a single piece of 16 bit PCM audio data.
+     */
+    typedef struct kwlAudioConversionJob
+    {
+        /** The interleaved input samples.*/
+        const short* input;
+        /** The number of input frames.*/
+        int numInputFrames;
+        /** The number of input channels.*/
+        int numInputChannels;
+        /** The input sample rate in Hz.*/
+        int inputSampleRate;
+        /** The number of output frames.*/
+        int numOutputFrames;
+        /** The number of output channels.*/
+        int numOutputChannels;
+        /** The output sample rate in Hz.*/
+        int outputSampleRate;
+        /** The output bit depth, 8 or 16.*/
+        int outputBitDepth;
+        /** Non-zero if the output should be wrapped in a WAV container.*/
+        int writeWAVHeader;
+        /** The converted output.*/
+        unsigned char* output;
+        /** The size of the converted output in bytes.*/
+        int numOutputBytes;
+    } kwlAudioConversionJob;
+    
+    /**
+     * Checks if the given settings would alter a given piece of audio data.
+     * Only linear PCM audio data is ever converted.
+     * @param settings The conversion settings.
+     * @param audioData The audio data, loaded with KWL_SKIP_AUDIO_DATA or a more complete mode.
+     * @param isStreaming Non-zero if the audio data is streamed from disk.
+     * @return Non-zero if the audio data needs converting, zero otherwise.
+     */
+    int kwlAudioConversionSettings_requiresConversion(const kwlAudioConversionSettings* settings,
+                                                      kwlAudioData* audioData,
+                                                      int isStreaming);
+    
+    /**
+     * Initializes a conversion job and allocates its output buffer. Not thread safe.
+     * @param job The job to initialize.
+     * @param settings The conversion settings.
+     * @param audioData Audio data loaded with KWL_CONVERT_TO_INT16_OR_FAIL. 
+     * Must stay valid until the job has been processed.
+     * @param isStreaming Non-zero if the output should be a streamable WAV file
+     * rather than raw 16 bit samples.
+     */
+    void kwlAudioConversionJob_init(kwlAudioConversionJob* job,
+                                    const kwlAudioConversionSettings* settings,
+                                    kwlAudioData* audioData,
+                                    int isStreaming);
+    
+    /**
+     * Performs the conversion described by a job. Does not allocate memory and 
+     * may be called concurrently for different jobs.
+     * @param job The job to process.
+     */
+    void kwlAudioConversionJob_process(kwlAudioConversionJob* job);
+    
+    /**
+     * Processes a number of conversion jobs, distributing them over 
+     * at most KWL_AUDIO_CONVERSION_NUM_THREADS worker threads.
+     * @param jobs The jobs to process.
+     * @param numJobs The number of jobs.
+     */
+    void kwlProcessAudioConversionJobs(kwlAudioConversionJob* jobs, int numJobs);
+    
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+    
+#endif /*KWL_AUDIO_CONVERSION_H*/
@@ -144,7 +144,7 @@ kwlResultCode kwlBuildWaveBanks(const char* xmlPath,
             /*create the path of the output file*/
             char* wbFilePathNoExt = kwlAppendPathElement(targetDir, wbId);
             size_t fullPathLen = strlen(wbFilePathNoExt) + 5;
-            char* wbFilePath = KWL_MALLOCANDZERO(fullPathLen * sizeof(char), "wb path w ext");
+            char* wbFilePath = KWL_MALLOCANDZERO(fullPathLen * sizeof(char), KWL_MEMORY_CATEGORY_GENERAL, "wb path w ext");
             strcpy(wbFilePath, wbFilePathNoExt);
             
             wbFilePath[fullPathLen - 5] = '.';
@@ -51,7 +51,9 @@ extern "C"
         KWL_COULD_NOT_OPEN_WAVE_BANK_BINARY_FILE,
         KWL_COULD_NOT_OPEN_ENGINE_DATA_BINARY_FILE,
         KWL_AUDIO_FILE_REFERENCE_ERROR,
-        KWL_ENGINE_DATA_STRUCTURE_ERROR
+        KWL_ENGINE_DATA_STRUCTURE_ERROR,
+        KWL_INVALID_LOOP_REGION,
+        KWL_AUDIO_FILE_LOADING_ERROR
     } kwlResultCode;
     
     
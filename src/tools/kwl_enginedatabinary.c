@@ -45,7 +45,7 @@ const char* projectXmlPath = NULL;
 int kwlFileIsEngineDataBinary(const char* path)
 {
     kwlInputStream is;
-    kwlError result = kwlInputStream_initWithFile(&is, path);
+    kwlError result = kwlInputStream_initWithFile(&is, path, NULL);
     if (result != KWL_NO_ERROR)
     {
         return 0;
@@ -99,7 +99,7 @@ static const xmlChar* kwlGetNodePath(xmlNode* currentNode)
     }
     tempStr[numChars] = '\0';
     
-    xmlChar* pathStr = KWL_MALLOCANDZERO(numChars, "path string");
+    xmlChar* pathStr = KWL_MALLOCANDZERO(numChars, KWL_MEMORY_CATEGORY_GENERAL, "path string");
     kwlMemcpy(pathStr, &tempStr[1], numChars); //remove leading slash
     pathStr[numChars - 1] = '\0';
     return pathStr;
@@ -117,14 +117,14 @@ static void kwlGatherMixBusesCallback(xmlNode* currentNode,
     bin->mixBusesChunk.numMixBuses += 1;
     bin->mixBusesChunk.mixBuses = KWL_REALLOC(bin->mixBusesChunk.mixBuses,
                                               sizeof(kwlMixBusChunk) * bin->mixBusesChunk.numMixBuses,
-                                              "xml 2 bin mix bus realloc");
+                                              KWL_MEMORY_CATEGORY_GENERAL, "xml 2 bin mix bus realloc");
     kwlMixBusChunk* c = &bin->mixBusesChunk.mixBuses[bin->mixBusesChunk.numMixBuses - 1];
     c->id = kwlGetAttributeValueCopy(currentNode, "id");
     KWL_ASSERT(c->id != NULL);
     c->numSubBuses = kwlGetChildCount(currentNode, KWL_XML_MIX_BUS_NODE);
     if (c->numSubBuses > 0)
     {
-        c->subBusIndices = KWL_MALLOCANDZERO(c->numSubBuses * sizeof(int), "xml 2 bin sub buses");
+        c->subBusIndices = KWL_MALLOCANDZERO(c->numSubBuses * sizeof(int), KWL_MEMORY_CATEGORY_GENERAL, "xml 2 bin sub buses");
     }
 }
 
@@ -270,14 +270,14 @@ static void kwlGatherMixPresetsCallback(xmlNode* node,
     bin->mixPresetsChunk.numMixPresets += 1;
     bin->mixPresetsChunk.mixPresets = KWL_REALLOC(bin->mixPresetsChunk.mixPresets,
                                                   sizeof(kwlMixPresetChunk) * bin->mixPresetsChunk.numMixPresets,
-                                                  "xml 2 bin mix preset realloc");
+                                                  KWL_MEMORY_CATEGORY_GENERAL, "xml 2 bin mix preset realloc");
     kwlMixPresetChunk* c = &bin->mixPresetsChunk.mixPresets[bin->mixPresetsChunk.numMixPresets - 1];
     c->id = kwlGetNodePath(node);
     c->isDefault = kwlGetBoolAttributeValue(node, KWL_XML_MIX_PRESET_DEFAULT);
-    c->mixBusIndices = KWL_MALLOCANDZERO(numMixBuses * sizeof(int), "xml 2 bin mix preset bus indices");
-    c->gainLeft = KWL_MALLOCANDZERO(numMixBuses * sizeof(int), "xml 2 bin mix preset bus gain l");
-    c->gainRight = KWL_MALLOCANDZERO(numMixBuses * sizeof(int), "xml 2 bin mix preset bus gain r");
-    c->pitch = KWL_MALLOCANDZERO(numMixBuses * sizeof(int), "xml 2 bin mix preset bus pitch");
+    c->mixBusIndices = KWL_MALLOCANDZERO(numMixBuses * sizeof(int), KWL_MEMORY_CATEGORY_GENERAL, "xml 2 bin mix preset bus indices");
+    c->gainLeft = KWL_MALLOCANDZERO(numMixBuses * sizeof(int), KWL_MEMORY_CATEGORY_GENERAL, "xml 2 bin mix preset bus gain l");
+    c->gainRight = KWL_MALLOCANDZERO(numMixBuses * sizeof(int), KWL_MEMORY_CATEGORY_GENERAL, "xml 2 bin mix preset bus gain r");
+    c->pitch = KWL_MALLOCANDZERO(numMixBuses * sizeof(int), KWL_MEMORY_CATEGORY_GENERAL, "xml 2 bin mix preset bus pitch");
     
     int paramSetIdx = 0;
     for (xmlNode* curr = node->children; curr != NULL; curr = curr->next)
@@ -321,7 +321,7 @@ static void kwlGatherMixPresetsCallback(xmlNode* node,
     /*check one to one correspondence between mix bus ids and param set bus refs*/
     if (paramSetIdx == numMixBuses)
     {
-        const char** busRefIds = KWL_MALLOCANDZERO(numMixBuses * sizeof(char*), "preset bus ref validation");
+        const char** busRefIds = KWL_MALLOCANDZERO(numMixBuses * sizeof(char*), KWL_MEMORY_CATEGORY_GENERAL, "preset bus ref validation");
         
         for (int i = 0; i < numMixBuses; i++)
         {
@@ -412,13 +412,13 @@ static void kwlGatherWaveBanksCallback(xmlNode* node,
     bin->waveBanksChunk.numWaveBanks += 1;
     bin->waveBanksChunk.waveBanks = KWL_REALLOC(bin->waveBanksChunk.waveBanks,
                                                 sizeof(kwlWaveBankChunk) * bin->waveBanksChunk.numWaveBanks,
-                                                "xml 2 bin wave bank realloc");
+                                                KWL_MEMORY_CATEGORY_GENERAL, "xml 2 bin wave bank realloc");
     kwlWaveBankChunk* c = &bin->waveBanksChunk.waveBanks[bin->waveBanksChunk.numWaveBanks - 1];
     const xmlChar* path = kwlGetNodePath(node);
     c->id = path;
     c->numAudioDataEntries = kwlGetChildCount(node, KWL_XML_AUDIO_DATA_NODE);
     KWL_ASSERT(c->numAudioDataEntries > 0);
-    c->audioDataEntries = KWL_MALLOCANDZERO(c->numAudioDataEntries * sizeof(char*), "xml 2 bin wb entry names");
+    c->audioDataEntries = KWL_MALLOCANDZERO(c->numAudioDataEntries * sizeof(char*), KWL_MEMORY_CATEGORY_GENERAL, "xml 2 bin wb entry names");
     
     int idx = 0;
     //printf("reading wavebank %s\n", c->id);
@@ -556,12 +556,12 @@ static void kwlGatherSoundsCallback(xmlNode* node,
     bin->soundsChunk.numSoundDefinitions += 1;
     bin->soundsChunk.soundDefinitions = KWL_REALLOC(bin->soundsChunk.soundDefinitions,
                                                     sizeof(kwlSoundChunk) * bin->soundsChunk.numSoundDefinitions,
-                                                    "xml 2 bin sound realloc");
+                                                    KWL_MEMORY_CATEGORY_GENERAL, "xml 2 bin sound realloc");
     kwlSoundChunk* c = &bin->soundsChunk.soundDefinitions[bin->soundsChunk.numSoundDefinitions - 1];
     
     soundDefinitionNames = KWL_REALLOC(soundDefinitionNames,
                                        bin->soundsChunk.numSoundDefinitions * sizeof(char*),
-                                       "sound def id list realloc");
+                                       KWL_MEMORY_CATEGORY_GENERAL, "sound def id list realloc");
     soundDefinitionNames[bin->soundsChunk.numSoundDefinitions - 1] = kwlGetNodePath(node);
     
     c->gain = kwlGetFloatAttributeValue(node, KWL_XML_SOUND_GAIN);
@@ -575,8 +575,8 @@ static void kwlGatherSoundsCallback(xmlNode* node,
     
     if (c->numWaveReferences > 0)
     {
-        c->waveBankIndices = KWL_MALLOCANDZERO(c->numWaveReferences * sizeof(int), "xml 2 bin sound wb indices");
-        c->audioDataIndices = KWL_MALLOCANDZERO(c->numWaveReferences * sizeof(int), "xml 2 bin sound ad indices");
+        c->waveBankIndices = KWL_MALLOCANDZERO(c->numWaveReferences * sizeof(int), KWL_MEMORY_CATEGORY_GENERAL, "xml 2 bin sound wb indices");
+        c->audioDataIndices = KWL_MALLOCANDZERO(c->numWaveReferences * sizeof(int), KWL_MEMORY_CATEGORY_GENERAL, "xml 2 bin sound ad indices");
     }
     
     int refIdx = 0;
@@ -694,7 +694,7 @@ static void kwlGatherEventsCallback(xmlNode* node,
     bin->eventsChunk.numEventDefinitions += 1;
     bin->eventsChunk.eventDefinitions = KWL_REALLOC(bin->eventsChunk.eventDefinitions,
                                                     sizeof(kwlEventChunk) * bin->eventsChunk.numEventDefinitions,
-                                                    "xml 2 bin event realloc");
+                                                    KWL_MEMORY_CATEGORY_GENERAL, "xml 2 bin event realloc");
     kwlEventChunk* c = &bin->eventsChunk.eventDefinitions[bin->eventsChunk.numEventDefinitions - 1];
     kwlMemset(c, 0, sizeof(kwlEventChunk));
     
@@ -758,7 +758,7 @@ static void kwlGatherEventsCallback(xmlNode* node,
         }
         
         c->numReferencedWaveBanks = 1;
-        c->waveBankIndices = KWL_MALLOCANDZERO(c->numReferencedWaveBanks * sizeof(int), "bin streaming evt wb indices");
+        c->waveBankIndices = KWL_MALLOCANDZERO(c->numReferencedWaveBanks * sizeof(int), KWL_MEMORY_CATEGORY_GENERAL, "bin streaming evt wb indices");
         c->waveBankIndices[0] = c->waveBankIndex;
     }
     else
@@ -800,7 +800,7 @@ static void kwlGatherEventsCallback(xmlNode* node,
                     c->numReferencedWaveBanks++;
                     c->waveBankIndices = KWL_REALLOC(c->waveBankIndices,
                                                      c->numReferencedWaveBanks * sizeof(int),
-                                                     "bin event ref wb list");
+                                                     KWL_MEMORY_CATEGORY_GENERAL, "bin event ref wb list");
                     c->waveBankIndices[c->numReferencedWaveBanks - 1] = wbIdx;
                 }
             }
@@ -865,6 +865,7 @@ static void kwlCreateEventChunk(xmlNode* eventsRootGroup,
             kwlAudioData ad;
             //printf("loadint audio file %s\n", absFilePath);
             kwlError e = kwlLoadAudioFile(absFilePath,
+                                          NULL,
                                           &ad,
                                           KWL_SKIP_AUDIO_DATA);
             
@@ -878,7 +879,7 @@ static void kwlCreateEventChunk(xmlNode* eventsRootGroup,
                 const int newSndIdx = bin->soundsChunk.numSoundDefinitions - 1;
                 bin->soundsChunk.soundDefinitions = KWL_REALLOC(bin->soundsChunk.soundDefinitions,
                                                                 bin->soundsChunk.numSoundDefinitions * sizeof(kwlSoundChunk),
-                                                                "extra bin sounds realloc");
+                                                                KWL_MEMORY_CATEGORY_GENERAL, "extra bin sounds realloc");
                 kwlSoundChunk* s = &bin->soundsChunk.soundDefinitions[newSndIdx];
                 kwlMemset(s, 0, sizeof(kwlSoundChunk));
                 s->gain = 1.0f;
@@ -888,8 +889,8 @@ static void kwlCreateEventChunk(xmlNode* eventsRootGroup,
                 s->numWaveReferences = 1;
                 s->playbackMode = KWL_RANDOM;
                 s->playbackCount = 1;
-                s->audioDataIndices = KWL_MALLOCANDZERO(sizeof(int), "extra sound data idx");
-                s->waveBankIndices = KWL_MALLOCANDZERO(sizeof(int), "extra sound wb idx");
+                s->audioDataIndices = KWL_MALLOCANDZERO(sizeof(int), KWL_MEMORY_CATEGORY_GENERAL, "extra sound data idx");
+                s->waveBankIndices = KWL_MALLOCANDZERO(sizeof(int), KWL_MEMORY_CATEGORY_GENERAL, "extra sound wb idx");
                 s->waveBankIndices[0] = ei->waveBankIndex;
                 ei->waveBankIndex = -1;
                 s->audioDataIndices[0] = ei->audioDataIndex;
@@ -917,7 +918,7 @@ static void kwlCheckPathUniqueness(xmlNode* node,
     const int childCount = kwlGetChildCount(node, branchNodeName) + kwlGetChildCount(node, leafNodeName);
     
     /*gather child id list*/
-    const xmlChar** childNames = KWL_MALLOC(childCount * sizeof(char*), "path uniqueness check list");
+    const xmlChar** childNames = KWL_MALLOC(childCount * sizeof(char*), KWL_MEMORY_CATEGORY_GENERAL, "path uniqueness check list");
     int childIdx = 0;
     for (xmlNode* curr = node->children; curr != NULL; curr = curr->next)
     {
@@ -1167,6 +1168,57 @@ kwlResultCode kwlEngineDataBinary_validateFileReferences(kwlEngineDataBinary* bi
     return result;
 }
 
+/**
+ * Computes the element counts stored in the engine data binary header.
+ */
+static void kwlEngineDataBinary_getCounts(kwlEngineDataBinary* bin, kwlEngineDataCounts* counts)
+{
+    kwlMemset(counts, 0, sizeof(kwlEngineDataCounts));
+    
+    counts->numMixBuses = bin->mixBusesChunk.numMixBuses;
+    for (int i = 0; i < bin->mixBusesChunk.numMixBuses; i++)
+    {
+        counts->numSubBusReferences += bin->mixBusesChunk.mixBuses[i].numSubBuses;
+    }
+    
+    counts->numMixPresets = bin->mixPresetsChunk.numMixPresets;
+    counts->numWaveBanks = bin->waveBanksChunk.numWaveBanks;
+    counts->numAudioDataEntries = bin->waveBanksChunk.numAudioDataItemsTotal;
+    
+    counts->numSounds = bin->soundsChunk.numSoundDefinitions;
+    for (int i = 0; i < bin->soundsChunk.numSoundDefinitions; i++)
+    {
+        counts->numSoundAudioDataReferences += bin->soundsChunk.soundDefinitions[i].numWaveReferences;
+    }
+    
+    counts->numEventDefinitions = bin->eventsChunk.numEventDefinitions;
+    for (int i = 0; i < bin->eventsChunk.numEventDefinitions; i++)
+    {
+        kwlEventChunk* ei = &bin->eventsChunk.eventDefinitions[i];
+        counts->numEventInstances += ei->instanceCount < 1 ? 1 : ei->instanceCount;
+        counts->numEventWaveBankReferences += ei->numReferencedWaveBanks;
+    }
+}
+
+/**
+ * Writes the string table offset of a given string and advances 
+ * the string table size past the string and its null terminator.
+ * Strings must be written to the string table chunk in the same order.
+ */
+static void kwlWriteStringReference(kwlFileOutputStream* fos, const char* str, int* stringTableSize)
+{
+    kwlFileOutputStream_writeInt32BE(fos, *stringTableSize);
+    *stringTableSize += (int)strlen(str) + 1;
+}
+
+/**
+ * Writes a given string, including its null terminator, to the string table chunk.
+ */
+static void kwlWriteStringTableEntry(kwlFileOutputStream* fos, const char* str)
+{
+    kwlFileOutputStream_write(fos, str, (int)strlen(str) + 1);
+}
+
 kwlResultCode kwlEngineDataBinary_writeToFile(kwlEngineDataBinary* bin,
                                               const char* path)
 {
@@ -1180,14 +1232,49 @@ kwlResultCode kwlEngineDataBinary_writeToFile(kwlEngineDataBinary* bin,
     /*write file identifier*/
     kwlFileOutputStream_write(&fos, bin->fileIdentifier, KWL_ENGINE_DATA_BINARY_FILE_IDENTIFIER_LENGTH);
     
-    long chunkStartPositions[5] = {0, 0, 0, 0, 0};
-    long chunkEndPositions[5] = {0, 0, 0, 0, 0};
+    /*write the header. the element counts let the engine size all of 
+      its engine data structures before reading the rest of the file.*/
+    kwlEngineDataCounts counts;
+    kwlEngineDataBinary_getCounts(bin, &counts);
+    kwlFileOutputStream_writeInt32BE(&fos, KWL_ENGINE_DATA_BINARY_VERSION);
+    kwlFileOutputStream_writeInt32BE(&fos, 0); /*file size*/
+    kwlFileOutputStream_writeInt32BE(&fos, counts.numMixBuses);
+    kwlFileOutputStream_writeInt32BE(&fos, counts.numSubBusReferences);
+    kwlFileOutputStream_writeInt32BE(&fos, counts.numMixPresets);
+    kwlFileOutputStream_writeInt32BE(&fos, counts.numWaveBanks);
+    kwlFileOutputStream_writeInt32BE(&fos, counts.numAudioDataEntries);
+    kwlFileOutputStream_writeInt32BE(&fos, counts.numSounds);
+    kwlFileOutputStream_writeInt32BE(&fos, counts.numSoundAudioDataReferences);
+    kwlFileOutputStream_writeInt32BE(&fos, counts.numEventDefinitions);
+    kwlFileOutputStream_writeInt32BE(&fos, counts.numEventInstances);
+    kwlFileOutputStream_writeInt32BE(&fos, counts.numEventWaveBankReferences);
+    
+    /*write the chunk table. offsets and sizes are filled in at the end.*/
+    const int numChunks = 6;
+    const int chunkIds[6] =
+    {
+        KWL_WAVE_BANKS_CHUNK_ID,
+        KWL_MIX_BUSES_CHUNK_ID,
+        KWL_MIX_PRESETS_CHUNK_ID,
+        KWL_SOUNDS_CHUNK_ID,
+        KWL_EVENTS_CHUNK_ID,
+        KWL_STRINGS_CHUNK_ID
+    };
+    kwlFileOutputStream_writeInt32BE(&fos, numChunks);
+    for (int i = 0; i < numChunks; i++)
+    {
+        kwlFileOutputStream_writeInt32BE(&fos, chunkIds[i]);
+        kwlFileOutputStream_writeInt32BE(&fos, 0); /*offset*/
+        kwlFileOutputStream_writeInt32BE(&fos, 0); /*size*/
+    }
+    
+    long chunkStartPositions[6] = {0, 0, 0, 0, 0, 0};
+    long chunkEndPositions[6] = {0, 0, 0, 0, 0, 0};
+    int stringTableSize = 0;
     
     /*write wave banks chunk*/
     {
         kwlWaveBanksChunk* wbc = &bin->waveBanksChunk;
-        kwlFileOutputStream_writeInt32BE(&fos, KWL_WAVE_BANKS_CHUNK_ID);
-        kwlFileOutputStream_writeInt32BE(&fos, 0); /*size*/
         chunkStartPositions[0] = ftell(fos.file);
         kwlFileOutputStream_writeInt32BE(&fos, wbc->numAudioDataItemsTotal);
         kwlFileOutputStream_writeInt32BE(&fos, wbc->numWaveBanks);
@@ -1195,11 +1282,11 @@ kwlResultCode kwlEngineDataBinary_writeToFile(kwlEngineDataBinary* bin,
         for (int i = 0; i < wbc->numWaveBanks; i++)
         {
             kwlWaveBankChunk* wbi = &wbc->waveBanks[i];
-            kwlFileOutputStream_writeASCIIString(&fos, wbi->id);
+            kwlWriteStringReference(&fos, wbi->id, &stringTableSize);
             kwlFileOutputStream_writeInt32BE(&fos, wbi->numAudioDataEntries);
             for (int j = 0; j < wbi->numAudioDataEntries; j++)
             {
-                kwlFileOutputStream_writeASCIIString(&fos, wbi->audioDataEntries[j]);
+                kwlWriteStringReference(&fos, wbi->audioDataEntries[j], &stringTableSize);
             }
         }
         chunkEndPositions[0] = ftell(fos.file);
@@ -1208,15 +1295,13 @@ kwlResultCode kwlEngineDataBinary_writeToFile(kwlEngineDataBinary* bin,
     /*mix bus chunk*/
     {
         kwlMixBusesChunk* mbc = &bin->mixBusesChunk;
-        kwlFileOutputStream_writeInt32BE(&fos, KWL_MIX_BUSES_CHUNK_ID);
-        kwlFileOutputStream_writeInt32BE(&fos, 0); /*size*/
         chunkStartPositions[1] = ftell(fos.file);
         kwlFileOutputStream_writeInt32BE(&fos, mbc->numMixBuses);
         
         for (int i = 0; i < mbc->numMixBuses; i++)
         {
             kwlMixBusChunk* mbi = &mbc->mixBuses[i];
-            kwlFileOutputStream_writeASCIIString(&fos, mbi->id);
+            kwlWriteStringReference(&fos, mbi->id, &stringTableSize);
             kwlFileOutputStream_writeInt32BE(&fos, mbi->numSubBuses);
             for (int j = 0; j < mbi->numSubBuses; j++)
             {
@@ -1231,15 +1316,13 @@ kwlResultCode kwlEngineDataBinary_writeToFile(kwlEngineDataBinary* bin,
         const int numMixBuses = bin->mixBusesChunk.numMixBuses;
         KWL_ASSERT(numMixBuses > 0);
         kwlMixPresetsChunk * mpc = &bin->mixPresetsChunk;
-        kwlFileOutputStream_writeInt32BE(&fos, KWL_MIX_PRESETS_CHUNK_ID);
-        kwlFileOutputStream_writeInt32BE(&fos, 0); /*size*/
         chunkStartPositions[2] = ftell(fos.file);
         kwlFileOutputStream_writeInt32BE(&fos, mpc->numMixPresets);
         
         for (int i = 0; i < mpc->numMixPresets; i++)
         {
             kwlMixPresetChunk* mpi = &mpc->mixPresets[i];
-            kwlFileOutputStream_writeASCIIString(&fos, mpi->id);
+            kwlWriteStringReference(&fos, mpi->id, &stringTableSize);
             kwlFileOutputStream_writeInt32BE(&fos, mpi->isDefault);
             
             for (int j = 0; j < numMixBuses; j++)
@@ -1256,8 +1339,6 @@ kwlResultCode kwlEngineDataBinary_writeToFile(kwlEngineDataBinary* bin,
     /*sound chunk*/
     {
         kwlSoundsChunk * sdc = &bin->soundsChunk;
-        kwlFileOutputStream_writeInt32BE(&fos, KWL_SOUNDS_CHUNK_ID);
-        kwlFileOutputStream_writeInt32BE(&fos, 0); /*size*/
         chunkStartPositions[3] = ftell(fos.file);
         kwlFileOutputStream_writeInt32BE(&fos, sdc->numSoundDefinitions);
         
@@ -1285,15 +1366,13 @@ kwlResultCode kwlEngineDataBinary_writeToFile(kwlEngineDataBinary* bin,
     /*event chunk*/
     {
         kwlEventsChunk * edc = &bin->eventsChunk;
-        kwlFileOutputStream_writeInt32BE(&fos, KWL_EVENTS_CHUNK_ID);
-        kwlFileOutputStream_writeInt32BE(&fos, 0); /*size*/
         chunkStartPositions[4] = ftell(fos.file);
         kwlFileOutputStream_writeInt32BE(&fos, edc->numEventDefinitions);
         
         for (int i = 0; i < edc->numEventDefinitions; i++)
         {
             kwlEventChunk* ei = &edc->eventDefinitions[i];
-            kwlFileOutputStream_writeASCIIString(&fos, ei->id);
+            kwlWriteStringReference(&fos, ei->id, &stringTableSize);
             kwlFileOutputStream_writeInt32BE(&fos, ei->instanceCount);
             kwlFileOutputStream_writeFloat32BE(&fos, ei->gain);
             kwlFileOutputStream_writeFloat32BE(&fos, ei->pitch);
@@ -1317,13 +1396,45 @@ kwlResultCode kwlEngineDataBinary_writeToFile(kwlEngineDataBinary* bin,
         chunkEndPositions[4] = ftell(fos.file);
     }
     
-    /*finally write the chunk sizes*/
-    for (int i = 0; i < 5; i++)
+    /*string table chunk, in the order the string references were written above*/
+    {
+        chunkStartPositions[5] = ftell(fos.file);
+        for (int i = 0; i < bin->waveBanksChunk.numWaveBanks; i++)
+        {
+            kwlWaveBankChunk* wbi = &bin->waveBanksChunk.waveBanks[i];
+            kwlWriteStringTableEntry(&fos, wbi->id);
+            for (int j = 0; j < wbi->numAudioDataEntries; j++)
+            {
+                kwlWriteStringTableEntry(&fos, wbi->audioDataEntries[j]);
+            }
+        }
+        for (int i = 0; i < bin->mixBusesChunk.numMixBuses; i++)
+        {
+            kwlWriteStringTableEntry(&fos, bin->mixBusesChunk.mixBuses[i].id);
+        }
+        for (int i = 0; i < bin->mixPresetsChunk.numMixPresets; i++)
+        {
+            kwlWriteStringTableEntry(&fos, bin->mixPresetsChunk.mixPresets[i].id);
+        }
+        for (int i = 0; i < bin->eventsChunk.numEventDefinitions; i++)
+        {
+            kwlWriteStringTableEntry(&fos, bin->eventsChunk.eventDefinitions[i].id);
+        }
+        chunkEndPositions[5] = ftell(fos.file);
+        KWL_ASSERT(chunkEndPositions[5] - chunkStartPositions[5] == stringTableSize);
+    }
+    
+    /*finally write the file size and the chunk offsets and sizes*/
+    const long fileSize = ftell(fos.file);
+    fseek(fos.file, KWL_ENGINE_DATA_BINARY_FILE_IDENTIFIER_LENGTH + 4, SEEK_SET);
+    kwlFileOutputStream_writeInt32BE(&fos, (int)fileSize);
+    for (int i = 0; i < numChunks; i++)
     {
         fseek(fos.file,
-              chunkStartPositions[i] - 4,
+              KWL_ENGINE_DATA_BINARY_HEADER_SIZE + i * KWL_ENGINE_DATA_CHUNK_TABLE_ENTRY_SIZE + 4,
               SEEK_SET);
         const long size = chunkEndPositions[i] - chunkStartPositions[i];
+        kwlFileOutputStream_writeInt32BE(&fos, (int)chunkStartPositions[i]);
         kwlFileOutputStream_writeInt32BE(&fos, (int)size);
     }
     
@@ -1333,6 +1444,24 @@ kwlResultCode kwlEngineDataBinary_writeToFile(kwlEngineDataBinary* bin,
     return KWL_SUCCESS;
 }
 
+/**
+ * Reads a string table offset and returns a copy of the corresponding string,
+ * or NULL if the offset is out of bounds.
+ */
+static char* kwlReadStringReference(kwlInputStream* is, const char* stringTable, int stringTableSize)
+{
+    const int offset = kwlInputStream_readIntBE(is);
+    if (offset < 0 || offset >= stringTableSize)
+    {
+        return NULL;
+    }
+    
+    const int length = (int)strlen(&stringTable[offset]);
+    char* str = (char*)KWL_MALLOC(length + 1, KWL_MEMORY_CATEGORY_GENERAL, "bin string");
+    kwlMemcpy(str, &stringTable[offset], length + 1);
+    return str;
+}
+
 kwlResultCode kwlEngineDataBinary_loadFromBinaryFile(kwlEngineDataBinary* binaryRep,
                                                      const char* binaryPath,
                                                      kwlLogCallback errorLogCallbackIn)
@@ -1343,7 +1472,7 @@ kwlResultCode kwlEngineDataBinary_loadFromBinaryFile(kwlEngineDataBinary* binary
     kwlLogCallback errorLogCallback = errorLogCallbackIn == NULL ? kwlSilentLogCallback : errorLogCallbackIn;
     
     kwlInputStream is;
-    kwlError fileOpenResult = kwlInputStream_initWithFile(&is, binaryPath);
+    kwlError fileOpenResult = kwlInputStream_initWithFile(&is, binaryPath, NULL);
     if (fileOpenResult != KWL_NO_ERROR)
     {
         //error loading file
@@ -1365,8 +1494,22 @@ kwlResultCode kwlEngineDataBinary_loadFromBinaryFile(kwlEngineDataBinary* binary
         }
     }
     
+    const int version = kwlInputStream_readIntBE(&is);
+    if (version != KWL_ENGINE_DATA_BINARY_VERSION)
+    {
+        kwlInputStream_close(&is);
+        errorLogCallback("Unsupported engine data binary version %d in %s, expected %d\n",
+                         version, binaryPath, KWL_ENGINE_DATA_BINARY_VERSION);
+        return KWL_INVALID_FILE_IDENTIFIER;
+    }
+    
     kwlResultCode result = KWL_SUCCESS;
     
+    //string table
+    const int stringTableSize = kwlInputStream_seekToEngineDataChunk(&is, KWL_STRINGS_CHUNK_ID);
+    char* stringTable = (char*)KWL_MALLOCANDZERO(stringTableSize + 1, KWL_MEMORY_CATEGORY_GENERAL, "bin string table");
+    kwlInputStream_read(&is, (signed char*)stringTable, stringTableSize);
+    
     //mix buses
     {
         binaryRep->mixBusesChunk.chunkId = KWL_MIX_BUSES_CHUNK_ID;
@@ -1375,19 +1518,25 @@ kwlResultCode kwlEngineDataBinary_loadFromBinaryFile(kwlEngineDataBinary* binary
         //allocate memory for the mix bus data
         binaryRep->mixBusesChunk.numMixBuses = kwlInputStream_readIntBE(&is);
         binaryRep->mixBusesChunk.mixBuses = KWL_MALLOCANDZERO(binaryRep->mixBusesChunk.numMixBuses * sizeof(kwlMixBusChunk),
-                                                              "bin mix buses");
+                                                              KWL_MEMORY_CATEGORY_GENERAL, "bin mix buses");
         
         //read mix bus data
         for (int i = 0; i < binaryRep->mixBusesChunk.numMixBuses; i++)
         {
             kwlMixBusChunk* mi = &binaryRep->mixBusesChunk.mixBuses[i];
-            mi->id = kwlInputStream_readASCIIString(&is);
+            mi->id = kwlReadStringReference(&is, stringTable, stringTableSize);
+            if (mi->id == NULL)
+            {
+                errorLogCallback("Invalid id string reference in mix bus %d\n", i);
+                result = KWL_ENGINE_DATA_STRUCTURE_ERROR;
+                goto onDataError;
+            }
             mi->numSubBuses = kwlInputStream_readIntBE(&is);
             mi->subBusIndices = NULL;
             
             if (mi->numSubBuses > 0)
             {
-                mi->subBusIndices = KWL_MALLOCANDZERO(mi->numSubBuses * sizeof(int), "bin sub bus list");
+                mi->subBusIndices = KWL_MALLOCANDZERO(mi->numSubBuses * sizeof(int), KWL_MEMORY_CATEGORY_GENERAL, "bin sub bus list");
                 for (int j = 0; j < mi->numSubBuses; j++)
                 {
                     const int subBusIndexj = kwlInputStream_readIntBE(&is);
@@ -1412,7 +1561,7 @@ kwlResultCode kwlEngineDataBinary_loadFromBinaryFile(kwlEngineDataBinary* binary
         
         //allocate memory for the mix preset data
         binaryRep->mixPresetsChunk.numMixPresets = kwlInputStream_readIntBE(&is);
-        binaryRep->mixPresetsChunk.mixPresets = KWL_MALLOCANDZERO(binaryRep->mixPresetsChunk.numMixPresets * sizeof(kwlMixPresetChunk), "bin mix presets");
+        binaryRep->mixPresetsChunk.mixPresets = KWL_MALLOCANDZERO(binaryRep->mixPresetsChunk.numMixPresets * sizeof(kwlMixPresetChunk), KWL_MEMORY_CATEGORY_GENERAL, "bin mix presets");
         
         const int numParameterSets = binaryRep->mixBusesChunk.numMixBuses;
         int defaultPresetIndex = -1;
@@ -1422,7 +1571,13 @@ kwlResultCode kwlEngineDataBinary_loadFromBinaryFile(kwlEngineDataBinary* binary
         {
             kwlMixPresetChunk* mpi = &binaryRep->mixPresetsChunk.mixPresets[i];
             
-            mpi->id = kwlInputStream_readASCIIString(&is);
+            mpi->id = kwlReadStringReference(&is, stringTable, stringTableSize);
+            if (mpi->id == NULL)
+            {
+                errorLogCallback("Invalid id string reference in mix preset %d\n", i);
+                result = KWL_ENGINE_DATA_STRUCTURE_ERROR;
+                goto onDataError;
+            }
             mpi->isDefault = kwlInputStream_readIntBE(&is);
             
             if (mpi->isDefault != 0)
@@ -1436,10 +1591,10 @@ kwlResultCode kwlEngineDataBinary_loadFromBinaryFile(kwlEngineDataBinary* binary
                 defaultPresetIndex = i;
             }
             
-            mpi->gainLeft = (float*)KWL_MALLOCANDZERO(sizeof(float) * numParameterSets, "bin mp gains l");
-            mpi->gainRight = (float*)KWL_MALLOCANDZERO(sizeof(float) * numParameterSets, "bin mp gains r");
-            mpi->pitch = (float*)KWL_MALLOCANDZERO(sizeof(float) * numParameterSets, "bin mp pitches");
-            mpi->mixBusIndices = (int*)KWL_MALLOCANDZERO(sizeof(int) * numParameterSets, "bin mp indices");
+            mpi->gainLeft = (float*)KWL_MALLOCANDZERO(sizeof(float) * numParameterSets, KWL_MEMORY_CATEGORY_GENERAL, "bin mp gains l");
+            mpi->gainRight = (float*)KWL_MALLOCANDZERO(sizeof(float) * numParameterSets, KWL_MEMORY_CATEGORY_GENERAL, "bin mp gains r");
+            mpi->pitch = (float*)KWL_MALLOCANDZERO(sizeof(float) * numParameterSets, KWL_MEMORY_CATEGORY_GENERAL, "bin mp pitches");
+            mpi->mixBusIndices = (int*)KWL_MALLOCANDZERO(sizeof(int) * numParameterSets, KWL_MEMORY_CATEGORY_GENERAL, "bin mp indices");
             
             for (int j = 0; j < numParameterSets; j++)
             {
@@ -1491,13 +1646,19 @@ kwlResultCode kwlEngineDataBinary_loadFromBinaryFile(kwlEngineDataBinary* binary
         }
         
         binaryRep->waveBanksChunk.waveBanks = KWL_MALLOCANDZERO(binaryRep->waveBanksChunk.numWaveBanks * sizeof(kwlWaveBankChunk),
-                                                                "bin wbs");
+                                                                KWL_MEMORY_CATEGORY_GENERAL, "bin wbs");
         
         int audioDataItemIdx = 0;
         for (int i = 0; i < binaryRep->waveBanksChunk.numWaveBanks; i++)
         {
             kwlWaveBankChunk* wbi = &binaryRep->waveBanksChunk.waveBanks[i];
-            wbi->id = kwlInputStream_readASCIIString(&is);
+            wbi->id = kwlReadStringReference(&is, stringTable, stringTableSize);
+            if (wbi->id == NULL)
+            {
+                errorLogCallback("Invalid id string reference in wave bank %d\n", i);
+                result = KWL_ENGINE_DATA_STRUCTURE_ERROR;
+                goto onDataError;
+            }
             wbi->numAudioDataEntries = kwlInputStream_readIntBE(&is);
             if (wbi->numAudioDataEntries < 0)
             {
@@ -1509,11 +1670,17 @@ kwlResultCode kwlEngineDataBinary_loadFromBinaryFile(kwlEngineDataBinary* binary
             }
             
             wbi->audioDataEntries = KWL_MALLOCANDZERO(wbi->numAudioDataEntries * sizeof(char*),
-                                                      "bin wb audio data list");
+                                                      KWL_MEMORY_CATEGORY_GENERAL, "bin wb audio data list");
             
             for (int j = 0; j < wbi->numAudioDataEntries; j++)
             {
-                wbi->audioDataEntries[j] = kwlInputStream_readASCIIString(&is);
+                wbi->audioDataEntries[j] = kwlReadStringReference(&is, stringTable, stringTableSize);
+                if (wbi->audioDataEntries[j] == NULL)
+                {
+                    errorLogCallback("Invalid path string reference at entry %d in wave bank %s\n", j, wbi->id);
+                    result = KWL_ENGINE_DATA_STRUCTURE_ERROR;
+                    goto onDataError;
+                }
                 audioDataItemIdx++;
             }
         }
@@ -1527,7 +1694,7 @@ kwlResultCode kwlEngineDataBinary_loadFromBinaryFile(kwlEngineDataBinary* binary
         /*allocate memory for sound definitions*/
         binaryRep->soundsChunk.numSoundDefinitions = kwlInputStream_readIntBE(&is);
         binaryRep->soundsChunk.soundDefinitions = KWL_MALLOCANDZERO(binaryRep->soundsChunk.numSoundDefinitions * sizeof(kwlSoundChunk),
-                                                                    "bin sound defs");
+                                                                    KWL_MEMORY_CATEGORY_GENERAL, "bin sound defs");
         
         /*read sound definitions*/
         for (int i = 0; i < binaryRep->soundsChunk.numSoundDefinitions; i++)
@@ -1549,8 +1716,8 @@ kwlResultCode kwlEngineDataBinary_loadFromBinaryFile(kwlEngineDataBinary* binary
                 goto onDataError;
             }
             
-            si->waveBankIndices = KWL_MALLOCANDZERO(si->numWaveReferences * sizeof(int), "bin wb idcs");
-            si->audioDataIndices = KWL_MALLOCANDZERO(si->numWaveReferences * sizeof(int), "bin ad idcs");
+            si->waveBankIndices = KWL_MALLOCANDZERO(si->numWaveReferences * sizeof(int), KWL_MEMORY_CATEGORY_GENERAL, "bin wb idcs");
+            si->audioDataIndices = KWL_MALLOCANDZERO(si->numWaveReferences * sizeof(int), KWL_MEMORY_CATEGORY_GENERAL, "bin ad idcs");
             
             for (int j = 0; j < si->numWaveReferences; j++)
             {
@@ -1577,14 +1744,20 @@ kwlResultCode kwlEngineDataBinary_loadFromBinaryFile(kwlEngineDataBinary* binary
         
         binaryRep->eventsChunk.eventDefinitions =
         KWL_MALLOCANDZERO(binaryRep->eventsChunk.numEventDefinitions * sizeof(kwlEventChunk),
-                          "bin ev defs");
+                          KWL_MEMORY_CATEGORY_GENERAL, "bin ev defs");
         
         for (int i = 0; i < binaryRep->eventsChunk.numEventDefinitions; i++)
         {
             kwlEventChunk* ei = &binaryRep->eventsChunk.eventDefinitions[i];
             
             /*read the id of this event definition*/
-            ei->id = kwlInputStream_readASCIIString(&is);
+            ei->id = kwlReadStringReference(&is, stringTable, stringTableSize);
+            if (ei->id == NULL)
+            {
+                errorLogCallback("Invalid id string reference in event definition %d\n", i);
+                result = KWL_ENGINE_DATA_STRUCTURE_ERROR;
+                goto onDataError;
+            }
             
             ei->instanceCount = kwlInputStream_readIntBE(&is);
             KWL_ASSERT(ei->instanceCount >= -1);
@@ -1631,7 +1804,7 @@ kwlResultCode kwlEngineDataBinary_loadFromBinaryFile(kwlEngineDataBinary* binary
             ei->numReferencedWaveBanks = kwlInputStream_readIntBE(&is);
             KWL_ASSERT(ei->numReferencedWaveBanks >= 0 && ei->numReferencedWaveBanks <= binaryRep->waveBanksChunk.numWaveBanks);
             ei->waveBankIndices = (int*)KWL_MALLOCANDZERO(ei->numReferencedWaveBanks * sizeof(int),
-                                                          "bin evt wave bank refs");
+                                                          KWL_MEMORY_CATEGORY_GENERAL, "bin evt wave bank refs");
             
             for (int j = 0; j < ei->numReferencedWaveBanks; j++)
             {
@@ -1649,10 +1822,12 @@ kwlResultCode kwlEngineDataBinary_loadFromBinaryFile(kwlEngineDataBinary* binary
         }
     }
     
+    KWL_FREE(stringTable);
     kwlInputStream_close(&is);
     return KWL_SUCCESS;
     
 onDataError:
+    KWL_FREE(stringTable);
     kwlInputStream_close(&is);
     kwlEngineDataBinary_free(binaryRep);
     return result;
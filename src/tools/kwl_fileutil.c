@@ -96,7 +96,7 @@ char* kwlAppendPathElement(const char* path, const char* toAppend)
     }
     
     const size_t finalLen = plen - (pEndsWithSep ? 1 : 0) + appLen - (appStartsWithSep ? 1 : 0) + 1;
-    char* final = KWL_MALLOC(finalLen + 1, "path combine str");
+    char* final = KWL_MALLOC(finalLen + 1, KWL_MEMORY_CATEGORY_GENERAL, "path combine str");
     
     const size_t sepIdx = plen - (pEndsWithSep ? 1 : 0);
     kwlMemcpy(final, path, sepIdx + 1);
@@ -122,7 +122,7 @@ char* kwlGetFileDirectory(const char* path)
         }
     }
     
-    char* str = KWL_MALLOC(lastSepIdx + 1, "file path str");
+    char* str = KWL_MALLOC(lastSepIdx + 1, KWL_MEMORY_CATEGORY_GENERAL, "file path str");
     kwlMemcpy(str, path, lastSepIdx);
     str[lastSepIdx] = '\0';
     
@@ -24,6 +24,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "kwl_audioconversion.h"
 #include "kwl_audiofileutil.h"
 #include "kwl_fileoutputstream.h"
 #include "kwl_fileutil.h"
@@ -34,7 +35,7 @@
 int kwlFileIsWaveBankBinary(const char* path)
 {
     kwlInputStream is;
-    kwlError result = kwlInputStream_initWithFile(&is, path);
+    kwlError result = kwlInputStream_initWithFile(&is, path, NULL);
     if (result != KWL_NO_ERROR)
     {
         return 0;
@@ -70,6 +71,9 @@ void kwlWaveBankBinary_writeToFile(kwlWaveBankBinary* bin,
     /*write file identifier*/
     kwlFileOutputStream_write(&fos, bin->fileIdentifier, KWL_WAVE_BANK_BINARY_FILE_IDENTIFIER_LENGTH);
     
+    /*write layout version*/
+    kwlFileOutputStream_writeInt32BE(&fos, KWL_WAVE_BANK_BINARY_VERSION);
+    
     /*write id and entry count*/
     kwlFileOutputStream_writeASCIIString(&fos, bin->id);
     kwlFileOutputStream_writeInt32BE(&fos, bin->numEntries);
@@ -82,6 +86,13 @@ void kwlWaveBankBinary_writeToFile(kwlWaveBankBinary* bin,
         kwlFileOutputStream_writeInt32BE(&fos, ei->encoding);
         kwlFileOutputStream_writeInt32BE(&fos, ei->isStreaming);
         kwlFileOutputStream_writeInt32BE(&fos, ei->numChannels);
+        kwlFileOutputStream_writeInt32BE(&fos, ei->sampleRate);
+        kwlFileOutputStream_writeInt32BE(&fos, ei->loopStart);
+        kwlFileOutputStream_writeInt32BE(&fos, ei->loopEnd);
+        kwlFileOutputStream_writeInt32BE(&fos, ei->prefetchHeadLength);
+        /*the content hash is written as two 32 bit words, most significant word first.*/
+        kwlFileOutputStream_writeInt32BE(&fos, (int)(ei->contentHash >> 32));
+        kwlFileOutputStream_writeInt32BE(&fos, (int)(ei->contentHash & 0xffffffff));
         kwlFileOutputStream_writeInt32BE(&fos, ei->numBytes);
         kwlFileOutputStream_write(&fos, ei->data, ei->numBytes);
     }
@@ -99,7 +110,7 @@ kwlResultCode kwlWaveBankBinary_loadFromBinaryFile(kwlWaveBankBinary* binaryRep,
     kwlMemset(binaryRep, 0, sizeof(kwlWaveBankBinary));
     
     kwlInputStream stream;
-    kwlError result = kwlInputStream_initWithFile(&stream, path);
+    kwlError result = kwlInputStream_initWithFile(&stream, path, NULL);
     if (result != KWL_NO_ERROR)
     {
         //error loading file
@@ -123,10 +134,19 @@ kwlResultCode kwlWaveBankBinary_loadFromBinaryFile(kwlWaveBankBinary* binaryRep,
         }
     }
     
+    binaryRep->version = kwlInputStream_readIntBE(&stream);
+    if (binaryRep->version != KWL_WAVE_BANK_BINARY_VERSION)
+    {
+        errorCallback("Unsupported wave bank binary version %d in %s, expected %d\n",
+                      binaryRep->version, path, KWL_WAVE_BANK_BINARY_VERSION);
+        error = KWL_INVALID_FILE_IDENTIFIER;
+        goto onDataError;
+    }
+    
     binaryRep->id = kwlInputStream_readASCIIString(&stream);
     binaryRep->numEntries = kwlInputStream_readIntBE(&stream);
     binaryRep->entries = KWL_MALLOCANDZERO(binaryRep->numEntries * sizeof(kwlWaveBankEntryChunk),
-                                           "bin wb entries");
+                                           KWL_MEMORY_CATEGORY_GENERAL, "bin wb entries");
     
     for (int i = 0; i < binaryRep->numEntries; i++)
     {
@@ -135,9 +155,16 @@ kwlResultCode kwlWaveBankBinary_loadFromBinaryFile(kwlWaveBankBinary* binaryRep,
         ei->encoding = kwlInputStream_readIntBE(&stream);
         ei->isStreaming = kwlInputStream_readIntBE(&stream);
         ei->numChannels = kwlInputStream_readIntBE(&stream);
+        ei->sampleRate = kwlInputStream_readIntBE(&stream);
+        ei->loopStart = kwlInputStream_readIntBE(&stream);
+        ei->loopEnd = kwlInputStream_readIntBE(&stream);
+        ei->prefetchHeadLength = kwlInputStream_readIntBE(&stream);
+        const unsigned int contentHashHigh = (unsigned int)kwlInputStream_readIntBE(&stream);
+        const unsigned int contentHashLow = (unsigned int)kwlInputStream_readIntBE(&stream);
+        ei->contentHash = ((unsigned long long)contentHashHigh << 32) | contentHashLow;
         ei->numBytes = kwlInputStream_readIntBE(&stream);
         KWL_ASSERT(ei->numBytes >= 0);
-        ei->data = KWL_MALLOC(ei->numBytes, "bin wb audio data entry");
+        ei->data = KWL_MALLOC(ei->numBytes, KWL_MEMORY_CATEGORY_GENERAL, "bin wb audio data entry");
         kwlInputStream_read(&stream, ei->data, ei->numBytes);
     }
     
@@ -151,15 +178,145 @@ onDataError:
 }
 
 
+/**
+ * Computes the 64 bit FNV-1a hash of a given piece of audio data. Never returns 0,
+ * which the engine treats as "no hash".
+ */
+static unsigned long long kwlComputeContentHash(const void* data, int numBytes)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    unsigned long long hash = 14695981039346656037ULL;
+    for (int i = 0; i < numBytes; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    
+    return hash == 0 ? 1 : hash;
+}
+
 static char* kwlDuplicateString(const char* str)
 {
     size_t len = strlen(str);
-    char* copy = KWL_MALLOC(len + 1, "string copy");
+    char* copy = KWL_MALLOC(len + 1, KWL_MEMORY_CATEGORY_GENERAL, "string copy");
     kwlMemcpy(copy, str, len);
     copy[len] = '\0';
     return copy;
 }
 
+/**
+ * Resolves the build time conversion settings of an audio data node. Attributes
+ * set on the audio data node override the ones of its parent wave bank node.
+ */
+static void kwlResolveAudioConversionSettings(xmlNode* audioDataNode,
+                                              kwlAudioConversionSettings* settings)
+{
+    xmlNode* waveBankNode = audioDataNode->parent;
+    KWL_ASSERT(xmlStrEqual(waveBankNode->name, (xmlChar*)KWL_XML_WAVE_BANK_NODE));
+    
+    kwlMemset(settings, 0, sizeof(kwlAudioConversionSettings));
+    
+    if (kwlGetAttributeValue(audioDataNode, KWL_XML_AUDIO_DATA_TARGET_SAMPLE_RATE) != NULL)
+    {
+        settings->targetSampleRate = kwlGetIntAttributeValue(audioDataNode, KWL_XML_AUDIO_DATA_TARGET_SAMPLE_RATE);
+    }
+    else if (kwlGetAttributeValue(waveBankNode, KWL_XML_WAVE_BANK_TARGET_SAMPLE_RATE) != NULL)
+    {
+        settings->targetSampleRate = kwlGetIntAttributeValue(waveBankNode, KWL_XML_WAVE_BANK_TARGET_SAMPLE_RATE);
+    }
+    
+    if (kwlGetAttributeValue(audioDataNode, KWL_XML_AUDIO_DATA_DOWNMIX_TO_MONO) != NULL)
+    {
+        settings->downmixToMono = kwlGetBoolAttributeValue(audioDataNode, KWL_XML_AUDIO_DATA_DOWNMIX_TO_MONO);
+    }
+    else if (kwlGetAttributeValue(waveBankNode, KWL_XML_WAVE_BANK_DOWNMIX_TO_MONO) != NULL)
+    {
+        settings->downmixToMono = kwlGetBoolAttributeValue(waveBankNode, KWL_XML_WAVE_BANK_DOWNMIX_TO_MONO);
+    }
+    
+    if (kwlGetAttributeValue(audioDataNode, KWL_XML_AUDIO_DATA_BIT_DEPTH) != NULL)
+    {
+        settings->bitDepth = kwlGetIntAttributeValue(audioDataNode, KWL_XML_AUDIO_DATA_BIT_DEPTH);
+    }
+    else if (kwlGetAttributeValue(waveBankNode, KWL_XML_WAVE_BANK_BIT_DEPTH) != NULL)
+    {
+        settings->bitDepth = kwlGetIntAttributeValue(waveBankNode, KWL_XML_WAVE_BANK_BIT_DEPTH);
+    }
+}
+
+/**
+ * Reads the loop region of an audio data node and checks it against the
+ * number of frames of the audio data, if known.
+ * @return Non-zero if the loop region is valid, zero otherwise.
+ */
+static int kwlResolveLoopRegion(xmlNode* audioDataNode,
+                                kwlAudioData* audioData,
+                                int* loopStart,
+                                int* loopEnd)
+{
+    *loopStart = 0;
+    *loopEnd = 0;
+    
+    if (kwlGetAttributeValue(audioDataNode, KWL_XML_AUDIO_DATA_LOOP_START) != NULL)
+    {
+        *loopStart = kwlGetIntAttributeValue(audioDataNode, KWL_XML_AUDIO_DATA_LOOP_START);
+    }
+    if (kwlGetAttributeValue(audioDataNode, KWL_XML_AUDIO_DATA_LOOP_END) != NULL)
+    {
+        *loopEnd = kwlGetIntAttributeValue(audioDataNode, KWL_XML_AUDIO_DATA_LOOP_END);
+    }
+    
+    if (*loopStart < 0 || *loopEnd < 0)
+    {
+        return 0;
+    }
+    else if (*loopEnd > 0 && *loopEnd <= *loopStart)
+    {
+        return 0;
+    }
+    else if (audioData->numFrames > 0 &&
+             (*loopStart >= audioData->numFrames || *loopEnd > audioData->numFrames))
+    {
+        return 0;
+    }
+    
+    return 1;
+}
+
+/**
+ * Scales a frame index of audio data being resampled from one sample rate
+ * to another.
+ */
+static int kwlScaleFrameIndex(int frameIndex, int sourceSampleRate, int targetSampleRate)
+{
+    if (sourceSampleRate <= 0 || targetSampleRate <= 0 || sourceSampleRate == targetSampleRate)
+    {
+        return frameIndex;
+    }
+    
+    return (int)(((long long)frameIndex * targetSampleRate + sourceSampleRate / 2) / sourceSampleRate);
+}
+
+/**
+ * Loads the audio file of a wave bank entry, logging an error if it could not be loaded.
+ */
+static kwlResultCode kwlLoadEntryAudioFile(const char* audioFilePath,
+                                           kwlAudioData* audioData,
+                                           kwlAudioDataLoadingMode mode,
+                                           const char* waveBankId,
+                                           kwlLogCallback errorLogCallback)
+{
+    const kwlError result = kwlLoadAudioFile(audioFilePath, NULL, audioData, mode);
+    if (result != KWL_NO_ERROR)
+    {
+        errorLogCallback("Could not load audio file %s in wave bank '%s' (error %d)\n",
+                         audioFilePath, waveBankId, result);
+        return KWL_AUDIO_FILE_LOADING_ERROR;
+    }
+    
+    return KWL_SUCCESS;
+}
+
 kwlResultCode kwlWaveBankBinary_create(kwlWaveBankBinary* wbBin,
                                        kwlEngineDataBinary* edBin,
                                        xmlNode* projNode,
@@ -210,9 +367,21 @@ kwlResultCode kwlWaveBankBinary_create(kwlWaveBankBinary* wbBin,
     {
         wbBin->fileIdentifier[i] = KWL_WAVE_BANK_BINARY_FILE_IDENTIFIER[i];
     }
+    wbBin->version = KWL_WAVE_BANK_BINARY_VERSION;
     
     wbBin->id = kwlDuplicateString(waveBank->id);
-    wbBin->entries = KWL_MALLOCANDZERO(waveBank->numAudioDataEntries * sizeof(kwlWaveBankEntryChunk), "bin wb entries");
+    wbBin->entries = KWL_MALLOCANDZERO(waveBank->numAudioDataEntries * sizeof(kwlWaveBankEntryChunk), KWL_MEMORY_CATEGORY_GENERAL, "bin wb entries");
+    
+    /*entries requiring sample rate, channel or bit depth conversion are collected
+     and converted in parallel once all audio files have been loaded.*/
+    kwlAudioConversionJob* conversionJobs = 
+        KWL_MALLOCANDZERO(waveBank->numAudioDataEntries * sizeof(kwlAudioConversionJob), KWL_MEMORY_CATEGORY_GENERAL, "bin wb conversion jobs");
+    kwlAudioData* conversionSources = 
+        KWL_MALLOCANDZERO(waveBank->numAudioDataEntries * sizeof(kwlAudioData), KWL_MEMORY_CATEGORY_GENERAL, "bin wb conversion sources");
+    int* conversionEntryIndices = 
+        KWL_MALLOCANDZERO(waveBank->numAudioDataEntries * sizeof(int), KWL_MEMORY_CATEGORY_GENERAL, "bin wb conversion entry indices");
+    int numConversionJobs = 0;
+    
     for (int i = 0; i < waveBank->numAudioDataEntries; i++)
     {
         kwlWaveBankEntryChunk* ei = &wbBin->entries[i];
@@ -221,7 +390,13 @@ kwlResultCode kwlWaveBankBinary_create(kwlWaveBankBinary* wbBin,
         KWL_ASSERT(kwlDoesFileExist(audioFilePath) && "audio file does not exist. should have been caught in validation");
         
         kwlAudioData audioData;
-        kwlLoadAudioFile(audioFilePath, &audioData, KWL_SKIP_AUDIO_DATA);
+        kwlResultCode loadResult = kwlLoadEntryAudioFile(audioFilePath, &audioData, KWL_SKIP_AUDIO_DATA, 
+                                                         wbBin->id, errorLogCallback);
+        if (loadResult != KWL_SUCCESS)
+        {
+            rc = loadResult;
+            continue;
+        }
         
         xmlNode* audioDataNode = kwlResolveAudioDataReference(projNode,
                                                               wbBin->id,
@@ -229,23 +404,110 @@ kwlResultCode kwlWaveBankBinary_create(kwlWaveBankBinary* wbBin,
         KWL_ASSERT(audioDataNode != 0);
         const int isStreaming = kwlGetBoolAttributeValue(audioDataNode, KWL_XML_AUDIO_DATA_STREAM);
         
-        if (kwlAudioData_isLinearPCM(&audioData) && !isStreaming)
+        if (!kwlResolveLoopRegion(audioDataNode, &audioData, &ei->loopStart, &ei->loopEnd))
+        {
+            errorLogCallback("Invalid loop region %d - %d for audio data '%s' in wave bank '%s'\n",
+                             ei->loopStart, ei->loopEnd, ei->fileName, wbBin->id);
+            rc = KWL_INVALID_LOOP_REGION;
+        }
+        
+        /*prefetch heads are only used when streaming.*/
+        if (isStreaming && kwlGetAttributeValue(audioDataNode, KWL_XML_AUDIO_DATA_PREFETCH_HEAD) != NULL)
+        {
+            ei->prefetchHeadLength = kwlGetIntAttributeValue(audioDataNode, KWL_XML_AUDIO_DATA_PREFETCH_HEAD);
+        }
+        
+        kwlAudioConversionSettings conversionSettings;
+        kwlResolveAudioConversionSettings(audioDataNode, &conversionSettings);
+        
+        if (kwlAudioConversionSettings_requiresConversion(&conversionSettings, &audioData, isStreaming))
+        {
+            kwlAudioData* source = &conversionSources[numConversionJobs];
+            loadResult = kwlLoadEntryAudioFile(audioFilePath, source, KWL_CONVERT_TO_INT16_OR_FAIL, 
+                                               wbBin->id, errorLogCallback);
+            if (loadResult != KWL_SUCCESS)
+            {
+                rc = loadResult;
+                continue;
+            }
+            kwlAudioConversionJob_init(&conversionJobs[numConversionJobs],
+                                       &conversionSettings,
+                                       source,
+                                       isStreaming);
+            conversionEntryIndices[numConversionJobs] = i;
+            numConversionJobs++;
+            
+            ei->isStreaming = isStreaming;
+            continue;
+        }
+        else if (kwlAudioData_isLinearPCM(&audioData) && !isStreaming)
         {
-            kwlLoadAudioFile(audioFilePath, &audioData, KWL_CONVERT_TO_INT16_OR_FAIL);
+            loadResult = kwlLoadEntryAudioFile(audioFilePath, &audioData, KWL_CONVERT_TO_INT16_OR_FAIL, 
+                                               wbBin->id, errorLogCallback);
         }
         else
         {
             /**/
-            kwlLoadAudioFile(audioFilePath, &audioData, KWL_LOAD_ENTIRE_FILE);
+            loadResult = kwlLoadEntryAudioFile(audioFilePath, &audioData, KWL_LOAD_ENTIRE_FILE, 
+                                               wbBin->id, errorLogCallback);
+        }
+        
+        if (loadResult != KWL_SUCCESS)
+        {
+            rc = loadResult;
+            continue;
         }
         
         ei->encoding = audioData.encoding;
         ei->isStreaming = isStreaming;
         ei->numBytes = audioData.numBytes;
         ei->numChannels = audioData.numChannels;
+        ei->sampleRate = audioData.sampleRate;
         ei->data = audioData.bytes;
     }
     
+    if (rc != KWL_SUCCESS)
+    {
+        for (int i = 0; i < numConversionJobs; i++)
+        {
+            kwlAudioData_free(&conversionSources[i]);
+            KWL_FREE(conversionJobs[i].output);
+        }
+        KWL_FREE(conversionJobs);
+        KWL_FREE(conversionSources);
+        KWL_FREE(conversionEntryIndices);
+        kwlWaveBankBinary_free(wbBin);
+        return rc;
+    }
+    
+    kwlProcessAudioConversionJobs(conversionJobs, numConversionJobs);
+    
+    for (int i = 0; i < numConversionJobs; i++)
+    {
+        kwlAudioConversionJob* job = &conversionJobs[i];
+        kwlWaveBankEntryChunk* ei = &wbBin->entries[conversionEntryIndices[i]];
+        
+        ei->encoding = job->outputBitDepth == 8 ? KWL_ENCODING_UNSIGNED_8BIT_PCM : KWL_ENCODING_SIGNED_16BIT_PCM;
+        ei->numBytes = job->numOutputBytes;
+        ei->numChannels = job->numOutputChannels;
+        ei->sampleRate = job->outputSampleRate;
+        ei->loopStart = kwlScaleFrameIndex(ei->loopStart, job->inputSampleRate, job->outputSampleRate);
+        ei->loopEnd = kwlScaleFrameIndex(ei->loopEnd, job->inputSampleRate, job->outputSampleRate);
+        ei->data = job->output;
+        
+        kwlAudioData_free(&conversionSources[i]);
+    }
+    
+    KWL_FREE(conversionJobs);
+    KWL_FREE(conversionSources);
+    KWL_FREE(conversionEntryIndices);
+    
+    for (int i = 0; i < wbBin->numEntries; i++)
+    {
+        kwlWaveBankEntryChunk* ei = &wbBin->entries[i];
+        ei->contentHash = kwlComputeContentHash(ei->data, ei->numBytes);
+    }
+    
     return KWL_SUCCESS;
 }
 
@@ -260,7 +522,7 @@ void kwlWaveBankBinary_dump(kwlWaveBankBinary* bin,
     {
         logCallback("%d ", (int)bin->fileIdentifier[i]);
     }
-    logCallback(")\n");
+    logCallback(", version %d)\n", bin->version);
     
     logCallback("    id '%s' (%d entries):\n", bin->id, bin->numEntries);
     
@@ -268,8 +530,17 @@ void kwlWaveBankBinary_dump(kwlWaveBankBinary* bin,
     {
         kwlWaveBankEntryChunk* ei = &bin->entries[i];
         logCallback("        '%s'\n", ei->fileName);
-        logCallback("            encoding %d, streaming %d, %d channel(s), %d bytes\n",
-                    ei->encoding, ei->isStreaming, ei->numChannels, ei->numBytes);
+        logCallback("            encoding %d, streaming %d, %d channel(s), %d Hz, %d bytes\n",
+                    ei->encoding, ei->isStreaming, ei->numChannels, ei->sampleRate, ei->numBytes);
+        if (ei->loopStart > 0 || ei->loopEnd > 0)
+        {
+            logCallback("            loop region %d - %d\n", ei->loopStart, ei->loopEnd);
+        }
+        if (ei->prefetchHeadLength > 0)
+        {
+            logCallback("            prefetch head %d ms\n", ei->prefetchHeadLength);
+        }
+        logCallback("            content hash %016llx\n", ei->contentHash);
         
     }
 }
@@ -41,6 +41,18 @@ extern "C"
         int encoding;
         int isStreaming;
         int numChannels;
+        int sampleRate;
+        /** The first sample frame of the loop region.*/
+        int loopStart;
+        /** The sample frame following the loop region. 0 means the end of the data.*/
+        int loopEnd;
+        /** The length in milliseconds of the decoded head kept in memory for streaming entries. 0 for none.*/
+        int prefetchHeadLength;
+        /** 
+         * A 64 bit FNV-1a hash of the audio data bytes, used by the engine to load identical
+         * audio data appearing in more than one wave bank only once.
+         */
+        unsigned long long contentHash;
         int numBytes;
         void* data;
     } kwlWaveBankEntryChunk;
@@ -52,6 +64,8 @@ extern "C"
     {
         /** The wave bank binary file identifier.*/
         char fileIdentifier[KWL_WAVE_BANK_BINARY_FILE_IDENTIFIER_LENGTH];
+        /** The version of the wave bank binary layout.*/
+        int version;
         /** The id of the wave bank.*/
         char* id;
         /** The number of audio data entries*/
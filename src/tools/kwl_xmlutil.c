@@ -90,7 +90,7 @@ char* kwlGetAttributeValueCopy(xmlNode* node, const char* name)
     }
     
     int len = xmlStrlen(val) + 1;
-    char* ret = KWL_MALLOCANDZERO(len * sizeof(char), "attribute value copy");
+    char* ret = KWL_MALLOCANDZERO(len * sizeof(char), KWL_MEMORY_CATEGORY_GENERAL, "attribute value copy");
     kwlMemcpy(ret, val, len - 1);
     ret[len - 1] = '\0';
     return ret;
@@ -281,7 +281,7 @@ xmlNode* kwlResolveNodePath(xmlNode* root, const char* path)
             }
         }
         
-        char* currPathElement = KWL_MALLOC(currEnd - currStart + 1, "path element");
+        char* currPathElement = KWL_MALLOC(currEnd - currStart + 1, KWL_MEMORY_CATEGORY_GENERAL, "path element");
         kwlMemcpy(currPathElement, &path[currStart], currEnd - currStart);
         currPathElement[currEnd - currStart] = '\0';
         
@@ -34,6 +34,12 @@
 
 #define KWL_XML_AUDIO_DATA_NODE "AudioData"
 #define KWL_XML_AUDIO_DATA_STREAM "streamFromDisk"
+#define KWL_XML_AUDIO_DATA_TARGET_SAMPLE_RATE "targetSampleRate"
+#define KWL_XML_AUDIO_DATA_DOWNMIX_TO_MONO "downmixToMono"
+#define KWL_XML_AUDIO_DATA_BIT_DEPTH "bitDepth"
+#define KWL_XML_AUDIO_DATA_LOOP_START "loopStart"
+#define KWL_XML_AUDIO_DATA_LOOP_END "loopEnd"
+#define KWL_XML_AUDIO_DATA_PREFETCH_HEAD "prefetchHead"
 
 #define KWL_XML_AUDIO_DATA_REFERENCE_NODE "AudioDataReference"
 #define KWL_XML_AUDIO_DATA_REFERENCE_PATH "relativePath"
@@ -87,6 +93,9 @@
 
 #define KWL_XML_WAVE_BANK_GROUP_NODE "WaveBankGroup"
 #define KWL_XML_WAVE_BANK_NODE "WaveBank"
+#define KWL_XML_WAVE_BANK_TARGET_SAMPLE_RATE "targetSampleRate"
+#define KWL_XML_WAVE_BANK_DOWNMIX_TO_MONO "downmixToMono"
+#define KWL_XML_WAVE_BANK_BIT_DEPTH "bitDepth"
 
 #define KWL_XML_ATTR_ID "id"
 #define KWL_XML_ATTR_REL_PATH "relativePath"